@@ -0,0 +1,1786 @@
+/**
+ * XML Security Library benchmark suite.
+ *
+ * Runs macro (sign/verify/encrypt/decrypt) and micro (base64, c14n,
+ * nodes set, digest, cipher, keys store) benchmarks and reports
+ * ops/s, latency percentiles, throughput and allocations per
+ * operation (total and xmlsec objects only) in text or JSON format.
+ *
+ * See Copyright for the status of this software.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif /* !defined(_WIN32) && !defined(_POSIX_C_SOURCE) */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif /* defined(_WIN32) */
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf
+#endif /* defined(_MSC_VER) && _MSC_VER < 1900 */
+
+#include <libxml/tree.h>
+#include <libxml/xmlmemory.h>
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+
+#ifndef XMLSEC_NO_XSLT
+#include <libxslt/xslt.h>
+#endif /* XMLSEC_NO_XSLT */
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
+#include <xmlsec/xmltree.h>
+#include <xmlsec/base64.h>
+#include <xmlsec/keys.h>
+#include <xmlsec/keyinfo.h>
+#include <xmlsec/keysmngr.h>
+#include <xmlsec/nodeset.h>
+#include <xmlsec/transforms.h>
+#include <xmlsec/xmldsig.h>
+#include <xmlsec/xmlenc.h>
+#include <xmlsec/templates.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/version.h>
+
+#include "crypto.h"
+#include "cmdline.h"
+
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(param)   ((void)(param))
+#endif /* UNREFERENCED_PARAMETER */
+
+static const char copyright[] =
+    "Written by Aleksey Sanin <aleksey@aleksey.com>.\n\n"
+    "Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved..\n"
+    "This is free software: see the source for copying information.\n";
+
+static const char bugs[] =
+    "Report bugs to http://www.aleksey.com/xmlsec/bugs.html\n";
+
+static const char helpUsage[] =
+    "Usage: xmlsec-bench [<options>] [<pattern> ...]\n"
+    "Runs XML Security Library benchmarks. If one or more <pattern> are\n"
+    "specified then only benchmarks with names containing one of the\n"
+    "patterns are executed.\n";
+
+#define xmlSecBenchCmdLineTopicGeneral          0x0001
+#define xmlSecBenchCmdLineTopicAll              0xFFFF
+
+/****************************************************************
+ *
+ * Command line parameters
+ *
+ ***************************************************************/
+static xmlSecAppCmdLineParam helpParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--help",
+    "-h",
+    "--help"
+    "\n\tprint help information about the command",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam listParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--list",
+    "-l",
+    "--list"
+    "\n\tprint the list of available benchmarks and exit",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam cryptoParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--crypto",
+    NULL,
+    "--crypto <name>"
+    "\n\tthe name of the crypto engine to use from the following"
+    "\n\tlist: openssl, mscrypto, nss, gnutls, gcrypt (if no crypto engine is"
+    "\n\tspecified then the default one is used)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam cryptoConfigParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--crypto-config",
+    NULL,
+    "--crypto-config <path>"
+    "\n\tpath to crypto engine configuration",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam iterationsParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--iterations",
+    "-n",
+    "--iterations <number>"
+    "\n\trun each benchmark exactly <number> times (by default,"
+    "\n\tthe number of iterations is determined by \"--min-time\")",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam minTimeParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--min-time",
+    NULL,
+    "--min-time <ms>"
+    "\n\tminimum time in milliseconds to run each benchmark (default: 1000)",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam formatParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--format",
+    "-f",
+    "--format <text|json>"
+    "\n\tthe results output format (default: text)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam outputParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--output",
+    "-o",
+    "--output <filename>"
+    "\n\twrite the results to the file <filename> (default: stdout)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam arenaParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--arena",
+    NULL,
+    "--arena"
+    "\n\tallocate the transforms and the references contexts from the"
+    "\n\tper-operation arena in the signature and encryption benchmarks",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam batchDigestsParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--batch-digests",
+    NULL,
+    "--batch-digests"
+    "\n\tcalculate the references digests together in the signature"
+    "\n\tverification benchmarks",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam pipelineC14NParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--pipeline-c14n",
+    NULL,
+    "--pipeline-c14n"
+    "\n\tcanonicalize and digest the references data in two threads"
+    "\n\tin the signature benchmarks",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam verboseParam = {
+    xmlSecBenchCmdLineTopicGeneral,
+    "--verbose",
+    NULL,
+    "--verbose"
+    "\n\tprint xmlsec errors",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParamPtr parameters[] = {
+    &helpParam,
+    &listParam,
+    &cryptoParam,
+    &cryptoConfigParam,
+    &iterationsParam,
+    &minTimeParam,
+    &formatParam,
+    &outputParam,
+    &arenaParam,
+    &batchDigestsParam,
+    &pipelineC14NParam,
+    &verboseParam,
+
+    /* MUST be the last one */
+    NULL
+};
+
+/****************************************************************
+ *
+ * Allocations counting: all libxml2 and xmlsec allocations go
+ * through xmlMalloc() and friends (crypto library allocations
+ * are not counted).
+ *
+ ***************************************************************/
+static size_t g_xmlSecBenchAllocsNum = 0;
+static size_t g_xmlSecBenchAllocsSize = 0;
+
+static void*
+xmlSecBenchMalloc(size_t size) {
+    ++g_xmlSecBenchAllocsNum;
+    g_xmlSecBenchAllocsSize += size;
+    return(malloc(size));
+}
+
+static void*
+xmlSecBenchRealloc(void* ptr, size_t size) {
+    ++g_xmlSecBenchAllocsNum;
+    g_xmlSecBenchAllocsSize += size;
+    return(realloc(ptr, size));
+}
+
+static char*
+xmlSecBenchStrdup(const char* str) {
+    char* res;
+    size_t size;
+
+    size = strlen(str) + 1;
+    ++g_xmlSecBenchAllocsNum;
+    g_xmlSecBenchAllocsSize += size;
+
+    res = (char*)malloc(size);
+    if(res != NULL) {
+        memcpy(res, str, size);
+    }
+    return(res);
+}
+
+static void
+xmlSecBenchFree(void* ptr) {
+    free(ptr);
+}
+
+/****************************************************************
+ *
+ * Timer
+ *
+ ***************************************************************/
+static double
+xmlSecBenchGetTime(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER counter;
+
+    if(freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&counter);
+    return((double)counter.QuadPart / (double)freq.QuadPart);
+#else  /* defined(_WIN32) */
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0);
+#endif /* defined(_WIN32) */
+}
+
+/****************************************************************
+ *
+ * Benchmarks
+ *
+ ***************************************************************/
+#define XMLSEC_BENCH_NAME_SIZE                  128
+#define XMLSEC_BENCH_KEYS_STORE_SIZE            1000
+#define XMLSEC_BENCH_DEFAULT_MIN_TIME           1000
+#define XMLSEC_BENCH_MIN_ITERATIONS             10
+#define XMLSEC_BENCH_MAX_ITERATIONS             10000000
+
+typedef struct _xmlSecBenchCase                 xmlSecBenchCase,
+                                                *xmlSecBenchCasePtr;
+
+/* returns 0 on success, 1 if the benchmark is not supported or a negative value on error */
+typedef int     (*xmlSecBenchSetupMethod)       (xmlSecBenchCasePtr bench);
+typedef int     (*xmlSecBenchRunMethod)         (xmlSecBenchCasePtr bench);
+typedef void    (*xmlSecBenchCleanupMethod)     (xmlSecBenchCasePtr bench);
+
+typedef enum {
+    xmlSecBenchStatusNotRun = 0,
+    xmlSecBenchStatusOk,
+    xmlSecBenchStatusSkipped,
+    xmlSecBenchStatusFailed
+} xmlSecBenchStatus;
+
+struct _xmlSecBenchCase {
+    char                        name[XMLSEC_BENCH_NAME_SIZE];
+    const char*                 group;
+    const char*                 algorithm;
+    xmlSecTransformUsage        usage;
+    const char*                 keyName;
+    xmlSecSize                  dataSize;
+    xmlSecSize                  refsNum;
+
+    xmlSecBenchSetupMethod      setup;
+    xmlSecBenchRunMethod        run;
+    xmlSecBenchCleanupMethod    cleanup;
+
+    /* state */
+    xmlSecTransformId           transformId;
+    xmlSecByte*                 data;
+    xmlChar*                    str;
+    int                         strSize;
+    xmlDocPtr                   doc;
+    xmlSecNodeSetPtr            nodes;
+    xmlSecBufferPtr             buffer;
+    xmlSecKeyPtr                key;
+    xmlSecKeysMngrPtr           keysMngr;
+    xmlSecKeyInfoCtxPtr         keyInfoCtx;
+    xmlChar**                   keyNames;
+    xmlSecSize                  counter;
+    xmlSecSize                  bytesPerOp;
+
+    /* results */
+    xmlSecBenchStatus           status;
+    xmlSecSize                  iterations;
+    double                      totalTime;
+    double                      minLatency;
+    double                      p50Latency;
+    double                      p99Latency;
+    double                      maxLatency;
+    double                      allocsPerOp;
+    double                      allocsSizePerOp;
+    double                      xmlsecAllocsPerOp;
+    double                      xmlsecAllocsSizePerOp;
+    xmlSecSize                  xmlsecPeakBytes;
+    double                      xmlsecTypeAllocsPerOp[XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX];
+};
+
+typedef struct _xmlSecBenchKeyInfo {
+    const char*                 name;
+    const char*                 klassAndSize;
+    int                         status;     /* 0 - not generated, 1 - ok, -1 - failed */
+} xmlSecBenchKeyInfo;
+
+static xmlSecBenchKeyInfo g_xmlSecBenchKeys[] = {
+    { "bench-rsa",      "rsa-2048",     0 },
+    { "bench-hmac",     "hmac-256",     0 },
+    { "bench-aes128",   "aes-128",      0 },
+    { "bench-aes256",   "aes-256",      0 },
+    { NULL,             NULL,           0 }
+};
+
+static xmlSecKeysMngrPtr g_xmlSecBenchKeysMngr = NULL;
+static xmlChar* g_xmlSecBenchIds[] = { BAD_CAST "Id", NULL };
+static const xmlChar g_xmlSecBenchNs[] = "urn:xmlsec:bench";
+static const char g_xmlSecBenchText[] = "The quick brown fox jumps over the lazy dog. ";
+
+/****************************************************************
+ *
+ * Helpers
+ *
+ ***************************************************************/
+static int
+xmlSecBenchEnsureKey(const char* name) {
+    xmlSecSize ii;
+    int ret;
+
+    if(name == NULL) {
+        return(0);
+    }
+    if(g_xmlSecBenchKeysMngr == NULL) {
+        return(-1);
+    }
+    for(ii = 0; g_xmlSecBenchKeys[ii].name != NULL; ++ii) {
+        if(strcmp(g_xmlSecBenchKeys[ii].name, name) != 0) {
+            continue;
+        }
+        if(g_xmlSecBenchKeys[ii].status == 0) {
+            ret = xmlSecAppCryptoSimpleKeysMngrKeyGenerate(g_xmlSecBenchKeysMngr,
+                g_xmlSecBenchKeys[ii].klassAndSize, g_xmlSecBenchKeys[ii].name);
+            g_xmlSecBenchKeys[ii].status = (ret < 0) ? -1 : 1;
+        }
+        return((g_xmlSecBenchKeys[ii].status > 0) ? 0 : -1);
+    }
+    return(-1);
+}
+
+static const char*
+xmlSecBenchGetKeyKlassAndSize(const char* name) {
+    xmlSecSize ii;
+
+    for(ii = 0; g_xmlSecBenchKeys[ii].name != NULL; ++ii) {
+        if(strcmp(g_xmlSecBenchKeys[ii].name, name) == 0) {
+            return(g_xmlSecBenchKeys[ii].klassAndSize);
+        }
+    }
+    return(NULL);
+}
+
+/* resolves the transform and generates the key if needed: returns 1 if not supported */
+static int
+xmlSecBenchSetupAlgorithmAndKey(xmlSecBenchCasePtr bench) {
+    if(bench->usage != xmlSecTransformUsageUnknown) {
+        bench->transformId = xmlSecTransformIdListFindByName(xmlSecTransformIdsGet(),
+                    BAD_CAST bench->algorithm, bench->usage);
+        if(bench->transformId == xmlSecTransformIdUnknown) {
+            return(1);
+        }
+    }
+    if(xmlSecBenchEnsureKey(bench->keyName) < 0) {
+        return(1);
+    }
+    return(0);
+}
+
+static xmlSecByte*
+xmlSecBenchCreateData(xmlSecSize size) {
+    xmlSecByte* data;
+    xmlSecSize ii;
+
+    data = (xmlSecByte*)malloc(size + 1);
+    if(data == NULL) {
+        fprintf(stderr, "Error: failed to allocate " XMLSEC_SIZE_FMT " bytes\n", size);
+        return(NULL);
+    }
+    for(ii = 0; ii < size; ++ii) {
+        data[ii] = (xmlSecByte)g_xmlSecBenchText[ii % (sizeof(g_xmlSecBenchText) - 1)];
+    }
+    data[size] = '\0';
+    return(data);
+}
+
+/* creates <Envelope><Part Id="pN">text</Part>...</Envelope> document */
+static xmlDocPtr
+xmlSecBenchCreateDoc(xmlSecSize size, xmlSecSize partsNum) {
+    xmlDocPtr doc;
+    xmlNodePtr root;
+    xmlNodePtr cur;
+    xmlSecByte* text;
+    xmlSecSize partSize;
+    xmlSecSize ii;
+    char id[32];
+
+    if(partsNum == 0) {
+        partsNum = 1;
+    }
+    partSize = size / partsNum;
+
+    text = xmlSecBenchCreateData(partSize);
+    if(text == NULL) {
+        return(NULL);
+    }
+
+    doc = xmlNewDoc(BAD_CAST "1.0");
+    if(doc == NULL) {
+        fprintf(stderr, "Error: failed to create document\n");
+        free(text);
+        return(NULL);
+    }
+    root = xmlNewDocNode(doc, NULL, BAD_CAST "Envelope", NULL);
+    if(root == NULL) {
+        fprintf(stderr, "Error: failed to create root node\n");
+        xmlFreeDoc(doc);
+        free(text);
+        return(NULL);
+    }
+    xmlDocSetRootElement(doc, root);
+    if(xmlNewNs(root, g_xmlSecBenchNs, NULL) == NULL) {
+        fprintf(stderr, "Error: failed to create namespace\n");
+        xmlFreeDoc(doc);
+        free(text);
+        return(NULL);
+    }
+
+    for(ii = 0; ii < partsNum; ++ii) {
+        cur = xmlNewTextChild(root, NULL, BAD_CAST "Part", (const xmlChar*)text);
+        if(cur == NULL) {
+            fprintf(stderr, "Error: failed to create part node\n");
+            xmlFreeDoc(doc);
+            free(text);
+            return(NULL);
+        }
+        snprintf(id, sizeof(id), "p" XMLSEC_SIZE_FMT, ii);
+        if(xmlSetProp(cur, BAD_CAST "Id", BAD_CAST id) == NULL) {
+            fprintf(stderr, "Error: failed to set Id attribute\n");
+            xmlFreeDoc(doc);
+            free(text);
+            return(NULL);
+        }
+    }
+
+    free(text);
+    return(doc);
+}
+
+static int
+xmlSecBenchDumpDoc(xmlSecBenchCasePtr bench, xmlDocPtr doc) {
+    if(bench->str != NULL) {
+        xmlFree(bench->str);
+        bench->str = NULL;
+    }
+    xmlDocDumpMemory(doc, &(bench->str), &(bench->strSize));
+    if((bench->str == NULL) || (bench->strSize <= 0)) {
+        fprintf(stderr, "Error: failed to serialize document\n");
+        return(-1);
+    }
+    bench->bytesPerOp = (xmlSecSize)bench->strSize;
+    return(0);
+}
+
+static xmlDocPtr
+xmlSecBenchParseDoc(xmlSecBenchCasePtr bench) {
+    xmlDocPtr doc;
+
+    doc = xmlReadMemory((const char*)bench->str, bench->strSize, NULL, NULL, XML_PARSE_NONET);
+    if((doc == NULL) || (xmlDocGetRootElement(doc) == NULL)) {
+        fprintf(stderr, "Error: failed to parse document\n");
+        if(doc != NULL) {
+            xmlFreeDoc(doc);
+        }
+        return(NULL);
+    }
+    xmlSecAddIDs(doc, xmlDocGetRootElement(doc), (const xmlChar**)g_xmlSecBenchIds);
+    return(doc);
+}
+
+static void
+xmlSecBenchCleanup(xmlSecBenchCasePtr bench) {
+    if(bench->keyInfoCtx != NULL) {
+        xmlSecKeyInfoCtxDestroy(bench->keyInfoCtx);
+        bench->keyInfoCtx = NULL;
+    }
+    if(bench->keyNames != NULL) {
+        xmlSecSize ii;
+
+        for(ii = 0; ii < XMLSEC_BENCH_KEYS_STORE_SIZE; ++ii) {
+            if(bench->keyNames[ii] != NULL) {
+                xmlFree(bench->keyNames[ii]);
+            }
+        }
+        free(bench->keyNames);
+        bench->keyNames = NULL;
+    }
+    if(bench->keysMngr != NULL) {
+        xmlSecKeysMngrDestroy(bench->keysMngr);
+        bench->keysMngr = NULL;
+    }
+    if(bench->key != NULL) {
+        xmlSecKeyDestroy(bench->key);
+        bench->key = NULL;
+    }
+    if(bench->buffer != NULL) {
+        xmlSecBufferDestroy(bench->buffer);
+        bench->buffer = NULL;
+    }
+    if(bench->nodes != NULL) {
+        xmlSecNodeSetDestroy(bench->nodes);
+        bench->nodes = NULL;
+    }
+    if(bench->doc != NULL) {
+        xmlFreeDoc(bench->doc);
+        bench->doc = NULL;
+    }
+    if(bench->str != NULL) {
+        xmlFree(bench->str);
+        bench->str = NULL;
+    }
+    if(bench->data != NULL) {
+        free(bench->data);
+        bench->data = NULL;
+    }
+}
+
+#ifndef XMLSEC_NO_XMLDSIG
+/****************************************************************
+ *
+ * Macro: XML Digital Signature sign/verify
+ *
+ ***************************************************************/
+static int
+xmlSecBenchDSigSetup(xmlSecBenchCasePtr bench) {
+    xmlSecTransformId digestId;
+    xmlDocPtr doc;
+    xmlNodePtr signNode;
+    xmlNodePtr refNode;
+    xmlNodePtr keyInfoNode;
+    xmlSecSize ii;
+    char uri[32];
+    int ret;
+
+    ret = xmlSecBenchSetupAlgorithmAndKey(bench);
+    if(ret != 0) {
+        return(ret);
+    }
+    digestId = xmlSecTransformIdListFindByName(xmlSecTransformIdsGet(),
+                    BAD_CAST "sha256", xmlSecTransformUsageDigestMethod);
+    if(digestId == xmlSecTransformIdUnknown) {
+        return(1);
+    }
+
+    doc = xmlSecBenchCreateDoc(bench->dataSize, bench->refsNum);
+    if(doc == NULL) {
+        return(-1);
+    }
+
+    signNode = xmlSecTmplSignatureCreate(doc, xmlSecTransformExclC14NId, bench->transformId, NULL);
+    if(signNode == NULL) {
+        fprintf(stderr, "Error: failed to create signature template\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+    xmlAddChild(xmlDocGetRootElement(doc), signNode);
+
+    for(ii = 0; ii < bench->refsNum; ++ii) {
+        snprintf(uri, sizeof(uri), "#p" XMLSEC_SIZE_FMT, ii);
+        refNode = xmlSecTmplSignatureAddReference(signNode, digestId, NULL, BAD_CAST uri, NULL);
+        if(refNode == NULL) {
+            fprintf(stderr, "Error: failed to add reference to signature template\n");
+            xmlFreeDoc(doc);
+            return(-1);
+        }
+        if(xmlSecTmplReferenceAddTransform(refNode, xmlSecTransformExclC14NId) == NULL) {
+            fprintf(stderr, "Error: failed to add c14n transform to reference\n");
+            xmlFreeDoc(doc);
+            return(-1);
+        }
+    }
+
+    keyInfoNode = xmlSecTmplSignatureEnsureKeyInfo(signNode, NULL);
+    if((keyInfoNode == NULL) || (xmlSecTmplKeyInfoAddKeyName(keyInfoNode, BAD_CAST bench->keyName) == NULL)) {
+        fprintf(stderr, "Error: failed to add key info to signature template\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+
+    ret = xmlSecBenchDumpDoc(bench, doc);
+    xmlFreeDoc(doc);
+    return(ret);
+}
+
+static int
+xmlSecBenchDSigExecute(xmlSecBenchCasePtr bench, int sign) {
+    xmlDocPtr doc;
+    xmlNodePtr node;
+    xmlSecDSigCtxPtr dsigCtx;
+    int ret;
+
+    doc = xmlSecBenchParseDoc(bench);
+    if(doc == NULL) {
+        return(-1);
+    }
+
+    node = xmlSecFindNode(xmlDocGetRootElement(doc), xmlSecNodeSignature, xmlSecDSigNs);
+    if(node == NULL) {
+        fprintf(stderr, "Error: signature node is not found\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+
+    dsigCtx = xmlSecDSigCtxCreate(g_xmlSecBenchKeysMngr);
+    if(dsigCtx == NULL) {
+        fprintf(stderr, "Error: failed to create signature context\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+    if(xmlSecAppCmdLineParamIsSet(&arenaParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_USE_ARENA;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&batchDigestsParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_BATCH_DIGESTS;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&pipelineC14NParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_PIPELINE_C14N;
+    }
+
+    if(sign != 0) {
+        ret = xmlSecDSigCtxSign(dsigCtx, node);
+        if(ret == 0) {
+            /* keep the signed document for the verification setup */
+            if(bench->doc == NULL) {
+                bench->doc = doc;
+                doc = NULL;
+            }
+        }
+    } else {
+        ret = xmlSecDSigCtxVerify(dsigCtx, node);
+        if((ret == 0) && (dsigCtx->status != xmlSecDSigStatusSucceeded)) {
+            fprintf(stderr, "Error: signature verification failed\n");
+            ret = -1;
+        }
+    }
+    if(ret < 0) {
+        fprintf(stderr, "Error: signature %s failed\n", (sign != 0) ? "sign" : "verify");
+    }
+
+    xmlSecDSigCtxDestroy(dsigCtx);
+    if(doc != NULL) {
+        xmlFreeDoc(doc);
+    }
+    return(ret);
+}
+
+static int
+xmlSecBenchDSigSign(xmlSecBenchCasePtr bench) {
+    int ret;
+
+    ret = xmlSecBenchDSigExecute(bench, 1);
+    if(bench->doc != NULL) {
+        xmlFreeDoc(bench->doc);
+        bench->doc = NULL;
+    }
+    return(ret);
+}
+
+static int
+xmlSecBenchDSigVerifySetup(xmlSecBenchCasePtr bench) {
+    int ret;
+
+    ret = xmlSecBenchDSigSetup(bench);
+    if(ret != 0) {
+        return(ret);
+    }
+
+    /* sign once and use the signed document as the input */
+    ret = xmlSecBenchDSigExecute(bench, 1);
+    if((ret < 0) || (bench->doc == NULL)) {
+        return(-1);
+    }
+    ret = xmlSecBenchDumpDoc(bench, bench->doc);
+    xmlFreeDoc(bench->doc);
+    bench->doc = NULL;
+    return(ret);
+}
+
+static int
+xmlSecBenchDSigVerify(xmlSecBenchCasePtr bench) {
+    return(xmlSecBenchDSigExecute(bench, 0));
+}
+#endif /* XMLSEC_NO_XMLDSIG */
+
+#ifndef XMLSEC_NO_XMLENC
+/****************************************************************
+ *
+ * Macro: XML Encryption encrypt/decrypt of binary data
+ *
+ ***************************************************************/
+static int
+xmlSecBenchEncSetup(xmlSecBenchCasePtr bench) {
+    xmlDocPtr doc;
+    xmlNodePtr encNode;
+    xmlNodePtr keyInfoNode;
+    int ret;
+
+    ret = xmlSecBenchSetupAlgorithmAndKey(bench);
+    if(ret != 0) {
+        return(ret);
+    }
+
+    bench->data = xmlSecBenchCreateData(bench->dataSize);
+    if(bench->data == NULL) {
+        return(-1);
+    }
+
+    doc = xmlNewDoc(BAD_CAST "1.0");
+    if(doc == NULL) {
+        fprintf(stderr, "Error: failed to create document\n");
+        return(-1);
+    }
+    encNode = xmlSecTmplEncDataCreate(doc, bench->transformId, NULL, NULL, NULL, NULL);
+    if(encNode == NULL) {
+        fprintf(stderr, "Error: failed to create encryption template\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+    xmlDocSetRootElement(doc, encNode);
+
+    if(xmlSecTmplEncDataEnsureCipherValue(encNode) == NULL) {
+        fprintf(stderr, "Error: failed to add CipherValue node\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+    keyInfoNode = xmlSecTmplEncDataEnsureKeyInfo(encNode, NULL);
+    if((keyInfoNode == NULL) || (xmlSecTmplKeyInfoAddKeyName(keyInfoNode, BAD_CAST bench->keyName) == NULL)) {
+        fprintf(stderr, "Error: failed to add key info to encryption template\n");
+        xmlFreeDoc(doc);
+        return(-1);
+    }
+
+    ret = xmlSecBenchDumpDoc(bench, doc);
+    xmlFreeDoc(doc);
+    bench->bytesPerOp = bench->dataSize;
+    return(ret);
+}
+
+static int
+xmlSecBenchEncEncryptDoc(xmlSecBenchCasePtr bench, xmlDocPtr doc) {
+    xmlSecEncCtxPtr encCtx;
+    int ret;
+
+    encCtx = xmlSecEncCtxCreate(g_xmlSecBenchKeysMngr);
+    if(encCtx == NULL) {
+        fprintf(stderr, "Error: failed to create encryption context\n");
+        return(-1);
+    }
+    if(xmlSecAppCmdLineParamIsSet(&arenaParam)) {
+        encCtx->flags |= XMLSEC_ENC_USE_ARENA;
+    }
+    ret = xmlSecEncCtxBinaryEncrypt(encCtx, xmlDocGetRootElement(doc), bench->data, bench->dataSize);
+    if(ret < 0) {
+        fprintf(stderr, "Error: encryption failed\n");
+    }
+    xmlSecEncCtxDestroy(encCtx);
+    return(ret);
+}
+
+static int
+xmlSecBenchEncEncrypt(xmlSecBenchCasePtr bench) {
+    xmlDocPtr doc;
+    int ret;
+
+    doc = xmlSecBenchParseDoc(bench);
+    if(doc == NULL) {
+        return(-1);
+    }
+    ret = xmlSecBenchEncEncryptDoc(bench, doc);
+    xmlFreeDoc(doc);
+    return(ret);
+}
+
+static int
+xmlSecBenchEncDecryptSetup(xmlSecBenchCasePtr bench) {
+    int ret;
+
+    ret = xmlSecBenchEncSetup(bench);
+    if(ret != 0) {
+        return(ret);
+    }
+
+    /* encrypt once and decrypt the same document over and over */
+    bench->doc = xmlSecBenchParseDoc(bench);
+    if(bench->doc == NULL) {
+        return(-1);
+    }
+    return(xmlSecBenchEncEncryptDoc(bench, bench->doc));
+}
+
+static int
+xmlSecBenchEncDecrypt(xmlSecBenchCasePtr bench) {
+    xmlSecEncCtxPtr encCtx;
+    xmlSecBufferPtr buffer;
+    int ret = 0;
+
+    encCtx = xmlSecEncCtxCreate(g_xmlSecBenchKeysMngr);
+    if(encCtx == NULL) {
+        fprintf(stderr, "Error: failed to create encryption context\n");
+        return(-1);
+    }
+    if(xmlSecAppCmdLineParamIsSet(&arenaParam)) {
+        encCtx->flags |= XMLSEC_ENC_USE_ARENA;
+    }
+    buffer = xmlSecEncCtxDecryptToBuffer(encCtx, xmlDocGetRootElement(bench->doc));
+    if((buffer == NULL) || (xmlSecBufferGetSize(buffer) != bench->dataSize)) {
+        fprintf(stderr, "Error: decryption failed\n");
+        ret = -1;
+    }
+    xmlSecEncCtxDestroy(encCtx);
+    return(ret);
+}
+#endif /* XMLSEC_NO_XMLENC */
+
+/****************************************************************
+ *
+ * Micro: base64
+ *
+ ***************************************************************/
+static int
+xmlSecBenchBase64Setup(xmlSecBenchCasePtr bench) {
+    bench->data = xmlSecBenchCreateData(bench->dataSize);
+    if(bench->data == NULL) {
+        return(-1);
+    }
+    bench->str = xmlSecBase64Encode(bench->data, bench->dataSize, xmlSecBase64GetDefaultLineSize());
+    if(bench->str == NULL) {
+        fprintf(stderr, "Error: base64 encode failed\n");
+        return(-1);
+    }
+    bench->buffer = xmlSecBufferCreate((xmlSecSize)xmlStrlen(bench->str));
+    if(bench->buffer == NULL) {
+        fprintf(stderr, "Error: failed to create buffer\n");
+        return(-1);
+    }
+    bench->bytesPerOp = bench->dataSize;
+    return(0);
+}
+
+static int
+xmlSecBenchBase64Encode(xmlSecBenchCasePtr bench) {
+    xmlChar* str;
+
+    str = xmlSecBase64Encode(bench->data, bench->dataSize, xmlSecBase64GetDefaultLineSize());
+    if(str == NULL) {
+        fprintf(stderr, "Error: base64 encode failed\n");
+        return(-1);
+    }
+    xmlFree(str);
+    return(0);
+}
+
+static int
+xmlSecBenchBase64Decode(xmlSecBenchCasePtr bench) {
+    xmlSecSize written = 0;
+    int ret;
+
+    ret = xmlSecBase64Decode_ex(bench->str, xmlSecBufferGetData(bench->buffer),
+                xmlSecBufferGetMaxSize(bench->buffer), &written);
+    if((ret < 0) || (written != bench->dataSize)) {
+        fprintf(stderr, "Error: base64 decode failed\n");
+        return(-1);
+    }
+    return(0);
+}
+
+/****************************************************************
+ *
+ * Micro: c14n and nodes set
+ *
+ ***************************************************************/
+static int
+xmlSecBenchC14NSetup(xmlSecBenchCasePtr bench) {
+    int ret;
+
+    ret = xmlSecBenchSetupAlgorithmAndKey(bench);
+    if(ret != 0) {
+        return(ret);
+    }
+
+    bench->doc = xmlSecBenchCreateDoc(bench->dataSize, bench->refsNum);
+    if(bench->doc == NULL) {
+        return(-1);
+    }
+    bench->nodes = xmlSecNodeSetGetChildren(bench->doc, NULL, 0, 0);
+    if(bench->nodes == NULL) {
+        fprintf(stderr, "Error: failed to create nodes set\n");
+        return(-1);
+    }
+    bench->bytesPerOp = bench->dataSize;
+    return(0);
+}
+
+static int
+xmlSecBenchC14N(xmlSecBenchCasePtr bench) {
+    xmlSecTransformCtxPtr transformCtx;
+    int ret = 0;
+
+    transformCtx = xmlSecTransformCtxCreate();
+    if(transformCtx == NULL) {
+        fprintf(stderr, "Error: failed to create transforms context\n");
+        return(-1);
+    }
+    if(xmlSecTransformCtxCreateAndAppend(transformCtx, bench->transformId) == NULL) {
+        fprintf(stderr, "Error: failed to create c14n transform\n");
+        ret = -1;
+    } else if(xmlSecTransformCtxXmlExecute(transformCtx, bench->nodes) < 0) {
+        fprintf(stderr, "Error: c14n failed\n");
+        ret = -1;
+    }
+    xmlSecTransformCtxDestroy(transformCtx);
+    return(ret);
+}
+
+static int
+xmlSecBenchNodeSetWalkCallback(xmlSecNodeSetPtr nset, xmlNodePtr cur,
+                               xmlNodePtr parent, void* data) {
+    UNREFERENCED_PARAMETER(nset);
+    UNREFERENCED_PARAMETER(cur);
+    UNREFERENCED_PARAMETER(parent);
+
+    ++(*(xmlSecSize*)data);
+    return(0);
+}
+
+static int
+xmlSecBenchNodeSetXPath(xmlSecBenchCasePtr bench) {
+    xmlXPathContextPtr xpathCtx;
+    xmlXPathObjectPtr xpathObj;
+    xmlSecNodeSetPtr nset;
+    xmlSecSize count = 0;
+    int ret;
+
+    xpathCtx = xmlXPathNewContext(bench->doc);
+    if(xpathCtx == NULL) {
+        fprintf(stderr, "Error: failed to create xpath context\n");
+        return(-1);
+    }
+    xpathObj = xmlXPathEvalExpression(BAD_CAST "//*[@Id]", xpathCtx);
+    if((xpathObj == NULL) || (xpathObj->nodesetval == NULL)) {
+        fprintf(stderr, "Error: xpath evaluation failed\n");
+        if(xpathObj != NULL) {
+            xmlXPathFreeObject(xpathObj);
+        }
+        xmlXPathFreeContext(xpathCtx);
+        return(-1);
+    }
+
+    nset = xmlSecNodeSetCreate(bench->doc, xpathObj->nodesetval, xmlSecNodeSetTree);
+    if(nset == NULL) {
+        fprintf(stderr, "Error: failed to create nodes set\n");
+        xmlXPathFreeObject(xpathObj);
+        xmlXPathFreeContext(xpathCtx);
+        return(-1);
+    }
+    xpathObj->nodesetval = NULL;
+
+    ret = xmlSecNodeSetWalk(nset, xmlSecBenchNodeSetWalkCallback, &count);
+    if((ret < 0) || (count == 0)) {
+        fprintf(stderr, "Error: nodes set walk failed\n");
+        ret = -1;
+    }
+
+    xmlSecNodeSetDestroy(nset);
+    xmlXPathFreeObject(xpathObj);
+    xmlXPathFreeContext(xpathCtx);
+    return(ret);
+}
+
+/****************************************************************
+ *
+ * Micro: digest and cipher transforms
+ *
+ ***************************************************************/
+static int
+xmlSecBenchTransformSetup(xmlSecBenchCasePtr bench) {
+    int ret;
+
+    ret = xmlSecBenchSetupAlgorithmAndKey(bench);
+    if(ret != 0) {
+        return(ret);
+    }
+    if(bench->keyName != NULL) {
+        bench->key = xmlSecAppCryptoKeyGenerate(xmlSecBenchGetKeyKlassAndSize(bench->keyName),
+                            bench->keyName, xmlSecKeyDataTypeSession);
+        if(bench->key == NULL) {
+            return(1);
+        }
+    }
+    bench->data = xmlSecBenchCreateData(bench->dataSize);
+    if(bench->data == NULL) {
+        return(-1);
+    }
+    bench->bytesPerOp = bench->dataSize;
+    return(0);
+}
+
+static int
+xmlSecBenchTransform(xmlSecBenchCasePtr bench) {
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecTransformPtr transform;
+    int ret = 0;
+
+    transformCtx = xmlSecTransformCtxCreate();
+    if(transformCtx == NULL) {
+        fprintf(stderr, "Error: failed to create transforms context\n");
+        return(-1);
+    }
+    transform = xmlSecTransformCtxCreateAndAppend(transformCtx, bench->transformId);
+    if(transform == NULL) {
+        fprintf(stderr, "Error: failed to create transform\n");
+        xmlSecTransformCtxDestroy(transformCtx);
+        return(-1);
+    }
+
+    if(bench->key != NULL) {
+        transform->operation = xmlSecTransformOperationEncrypt;
+        ret = xmlSecTransformSetKey(transform, bench->key);
+        if(ret < 0) {
+            fprintf(stderr, "Error: failed to set transform key\n");
+            xmlSecTransformCtxDestroy(transformCtx);
+            return(-1);
+        }
+    } else {
+        transform->operation = xmlSecTransformOperationSign;
+    }
+
+    ret = xmlSecTransformCtxBinaryExecute(transformCtx, bench->data, bench->dataSize);
+    if((ret < 0) || (transformCtx->result == NULL)) {
+        fprintf(stderr, "Error: transform failed\n");
+        ret = -1;
+    }
+    xmlSecTransformCtxDestroy(transformCtx);
+    return(ret);
+}
+
+/* digests bench->refsNum messages of bench->dataSize / bench->refsNum bytes at once */
+static int
+xmlSecBenchDigestBatch(xmlSecBenchCasePtr bench) {
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecTransformPtr transforms[64];
+    xmlSecSize msgSize, ii;
+    int ret = 0;
+
+    if((bench->refsNum == 0) || (bench->refsNum > sizeof(transforms) / sizeof(transforms[0]))) {
+        fprintf(stderr, "Error: invalid messages number\n");
+        return(-1);
+    }
+    transformCtx = xmlSecTransformCtxCreate();
+    if(transformCtx == NULL) {
+        fprintf(stderr, "Error: failed to create transforms context\n");
+        return(-1);
+    }
+
+    msgSize = bench->dataSize / bench->refsNum;
+    memset(transforms, 0, sizeof(transforms));
+    for(ii = 0; (ii < bench->refsNum) && (ret == 0); ++ii) {
+        transforms[ii] = xmlSecTransformCreate(bench->transformId);
+        if(transforms[ii] == NULL) {
+            fprintf(stderr, "Error: failed to create transform\n");
+            ret = -1;
+            break;
+        }
+        transforms[ii]->operation = xmlSecTransformOperationSign;
+        if(xmlSecBufferAppend(&(transforms[ii]->inBuf), bench->data + ii * msgSize, msgSize) < 0) {
+            fprintf(stderr, "Error: failed to set transform input\n");
+            ret = -1;
+        }
+    }
+    if(ret == 0) {
+        ret = xmlSecTransformExecuteBatch(transforms, bench->refsNum, transformCtx);
+        if(ret < 0) {
+            fprintf(stderr, "Error: transforms batch failed\n");
+        }
+    }
+
+    for(ii = 0; ii < bench->refsNum; ++ii) {
+        if(transforms[ii] != NULL) {
+            xmlSecTransformDestroy(transforms[ii]);
+        }
+    }
+    xmlSecTransformCtxDestroy(transformCtx);
+    return(ret);
+}
+
+/****************************************************************
+ *
+ * Micro: keys store lookup
+ *
+ ***************************************************************/
+static int
+xmlSecBenchKeysStoreSetup(xmlSecBenchCasePtr bench) {
+    xmlSecSize ii;
+    char name[64];
+    int ret;
+
+    bench->keysMngr = xmlSecKeysMngrCreate();
+    if(bench->keysMngr == NULL) {
+        fprintf(stderr, "Error: failed to create keys manager\n");
+        return(-1);
+    }
+    ret = xmlSecAppCryptoSimpleKeysMngrInit(bench->keysMngr);
+    if(ret < 0) {
+        return(-1);
+    }
+
+    bench->keyNames = (xmlChar**)malloc(sizeof(xmlChar*) * XMLSEC_BENCH_KEYS_STORE_SIZE);
+    if(bench->keyNames == NULL) {
+        fprintf(stderr, "Error: failed to allocate keys names\n");
+        return(-1);
+    }
+    memset(bench->keyNames, 0, sizeof(xmlChar*) * XMLSEC_BENCH_KEYS_STORE_SIZE);
+
+    for(ii = 0; ii < XMLSEC_BENCH_KEYS_STORE_SIZE; ++ii) {
+        snprintf(name, sizeof(name), "bench-key-" XMLSEC_SIZE_FMT, ii);
+        bench->keyNames[ii] = xmlStrdup(BAD_CAST name);
+        if(bench->keyNames[ii] == NULL) {
+            fprintf(stderr, "Error: failed to allocate key name\n");
+            return(-1);
+        }
+        ret = xmlSecAppCryptoSimpleKeysMngrKeyGenerate(bench->keysMngr, "hmac-128", name);
+        if(ret < 0) {
+            return(1);
+        }
+    }
+
+    bench->keyInfoCtx = xmlSecKeyInfoCtxCreate(bench->keysMngr);
+    if(bench->keyInfoCtx == NULL) {
+        fprintf(stderr, "Error: failed to create key info context\n");
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecBenchKeysStoreFind(xmlSecBenchCasePtr bench) {
+    xmlSecKeyPtr key;
+
+    key = xmlSecKeysMngrFindKey(bench->keysMngr,
+                bench->keyNames[(bench->counter++) % XMLSEC_BENCH_KEYS_STORE_SIZE],
+                bench->keyInfoCtx);
+    if(key == NULL) {
+        fprintf(stderr, "Error: key is not found\n");
+        return(-1);
+    }
+    xmlSecKeyDestroy(key);
+    return(0);
+}
+
+/****************************************************************
+ *
+ * Benchmarks list
+ *
+ ***************************************************************/
+#define XMLSEC_BENCH_MAX_CASES                  128
+
+static xmlSecBenchCase g_xmlSecBenchCases[XMLSEC_BENCH_MAX_CASES];
+static xmlSecSize g_xmlSecBenchCasesNum = 0;
+
+static const xmlSecSize g_xmlSecBenchDocSizes[] = { 1024, 64 * 1024, 1024 * 1024 };
+static const xmlSecSize g_xmlSecBenchRefsNums[] = { 1, 16 };
+
+static xmlSecBenchCasePtr
+xmlSecBenchAddCase(const char* group, const char* kind, const char* algorithm,
+                   xmlSecTransformUsage usage, const char* keyName,
+                   xmlSecSize dataSize, xmlSecSize refsNum, const char* refsLabel,
+                   xmlSecBenchSetupMethod setup, xmlSecBenchRunMethod run) {
+    xmlSecBenchCasePtr bench;
+    char size[32];
+    char refs[32];
+
+    if(g_xmlSecBenchCasesNum >= XMLSEC_BENCH_MAX_CASES) {
+        return(NULL);
+    }
+    bench = &(g_xmlSecBenchCases[g_xmlSecBenchCasesNum++]);
+    memset(bench, 0, sizeof(xmlSecBenchCase));
+
+    size[0] = refs[0] = '\0';
+    if(dataSize >= 1024 * 1024) {
+        snprintf(size, sizeof(size), "/" XMLSEC_SIZE_FMT "m", dataSize / (1024 * 1024));
+    } else if(dataSize > 0) {
+        snprintf(size, sizeof(size), "/" XMLSEC_SIZE_FMT "k", dataSize / 1024);
+    }
+    if((refsNum > 0) && (refsLabel != NULL)) {
+        snprintf(refs, sizeof(refs), "/" XMLSEC_SIZE_FMT "%s", refsNum, refsLabel);
+    }
+    snprintf(bench->name, sizeof(bench->name), "%s/%s/%s%s%s",
+        group, kind, algorithm, size, refs);
+    bench->group     = group;
+    bench->algorithm = algorithm;
+    bench->usage     = usage;
+    bench->keyName   = keyName;
+    bench->dataSize  = dataSize;
+    bench->refsNum   = refsNum;
+    bench->setup     = setup;
+    bench->run       = run;
+    bench->cleanup   = xmlSecBenchCleanup;
+    return(bench);
+}
+
+static void
+xmlSecBenchInitCases(void) {
+    xmlSecSize ii, jj;
+
+#ifndef XMLSEC_NO_XMLDSIG
+    static const char* dsigAlgs[][2] = {
+        { "rsa-sha256",     "bench-rsa" },
+        { "hmac-sha256",    "bench-hmac" }
+    };
+    xmlSecSize kk;
+
+    for(kk = 0; kk < sizeof(dsigAlgs) / sizeof(dsigAlgs[0]); ++kk) {
+        for(ii = 0; ii < sizeof(g_xmlSecBenchDocSizes) / sizeof(g_xmlSecBenchDocSizes[0]); ++ii) {
+            for(jj = 0; jj < sizeof(g_xmlSecBenchRefsNums) / sizeof(g_xmlSecBenchRefsNums[0]); ++jj) {
+                xmlSecBenchAddCase("macro", "sign", dsigAlgs[kk][0],
+                    xmlSecTransformUsageSignatureMethod, dsigAlgs[kk][1],
+                    g_xmlSecBenchDocSizes[ii], g_xmlSecBenchRefsNums[jj], "refs",
+                    xmlSecBenchDSigSetup, xmlSecBenchDSigSign);
+                xmlSecBenchAddCase("macro", "verify", dsigAlgs[kk][0],
+                    xmlSecTransformUsageSignatureMethod, dsigAlgs[kk][1],
+                    g_xmlSecBenchDocSizes[ii], g_xmlSecBenchRefsNums[jj], "refs",
+                    xmlSecBenchDSigVerifySetup, xmlSecBenchDSigVerify);
+            }
+        }
+    }
+#endif /* XMLSEC_NO_XMLDSIG */
+
+#ifndef XMLSEC_NO_XMLENC
+    {
+        static const char* encAlgs[][2] = {
+            { "aes128-cbc",     "bench-aes128" },
+            { "aes256-gcm",     "bench-aes256" }
+        };
+
+        for(jj = 0; jj < sizeof(encAlgs) / sizeof(encAlgs[0]); ++jj) {
+            for(ii = 0; ii < sizeof(g_xmlSecBenchDocSizes) / sizeof(g_xmlSecBenchDocSizes[0]); ++ii) {
+                xmlSecBenchAddCase("macro", "encrypt", encAlgs[jj][0],
+                    xmlSecTransformUsageEncryptionMethod, encAlgs[jj][1],
+                    g_xmlSecBenchDocSizes[ii], 0, NULL,
+                    xmlSecBenchEncSetup, xmlSecBenchEncEncrypt);
+                xmlSecBenchAddCase("macro", "decrypt", encAlgs[jj][0],
+                    xmlSecTransformUsageEncryptionMethod, encAlgs[jj][1],
+                    g_xmlSecBenchDocSizes[ii], 0, NULL,
+                    xmlSecBenchEncDecryptSetup, xmlSecBenchEncDecrypt);
+            }
+        }
+    }
+#endif /* XMLSEC_NO_XMLENC */
+
+    xmlSecBenchAddCase("micro", "base64", "encode", xmlSecTransformUsageUnknown, NULL,
+        64 * 1024, 0, NULL, xmlSecBenchBase64Setup, xmlSecBenchBase64Encode);
+    xmlSecBenchAddCase("micro", "base64", "decode", xmlSecTransformUsageUnknown, NULL,
+        64 * 1024, 0, NULL, xmlSecBenchBase64Setup, xmlSecBenchBase64Decode);
+
+    xmlSecBenchAddCase("micro", "c14n", "c14n", xmlSecTransformUsageC14NMethod, NULL,
+        64 * 1024, 64, "parts", xmlSecBenchC14NSetup, xmlSecBenchC14N);
+    xmlSecBenchAddCase("micro", "c14n", "exc-c14n", xmlSecTransformUsageC14NMethod, NULL,
+        64 * 1024, 64, "parts", xmlSecBenchC14NSetup, xmlSecBenchC14N);
+
+    xmlSecBenchAddCase("micro", "nodeset", "xpath", xmlSecTransformUsageUnknown, NULL,
+        64 * 1024, 256, "parts", xmlSecBenchC14NSetup, xmlSecBenchNodeSetXPath);
+
+    xmlSecBenchAddCase("micro", "digest", "sha1", xmlSecTransformUsageDigestMethod, NULL,
+        64 * 1024, 0, NULL, xmlSecBenchTransformSetup, xmlSecBenchTransform);
+    xmlSecBenchAddCase("micro", "digest", "sha256", xmlSecTransformUsageDigestMethod, NULL,
+        64 * 1024, 0, NULL, xmlSecBenchTransformSetup, xmlSecBenchTransform);
+    xmlSecBenchAddCase("micro", "digest", "sha512", xmlSecTransformUsageDigestMethod, NULL,
+        64 * 1024, 0, NULL, xmlSecBenchTransformSetup, xmlSecBenchTransform);
+
+    xmlSecBenchAddCase("micro", "digest-batch", "sha256", xmlSecTransformUsageDigestMethod, NULL,
+        16 * 1024, 64, "msgs", xmlSecBenchTransformSetup, xmlSecBenchDigestBatch);
+    xmlSecBenchAddCase("micro", "digest-batch", "sha512", xmlSecTransformUsageDigestMethod, NULL,
+        16 * 1024, 64, "msgs", xmlSecBenchTransformSetup, xmlSecBenchDigestBatch);
+
+    xmlSecBenchAddCase("micro", "cipher", "aes128-cbc", xmlSecTransformUsageEncryptionMethod, "bench-aes128",
+        64 * 1024, 0, NULL, xmlSecBenchTransformSetup, xmlSecBenchTransform);
+    xmlSecBenchAddCase("micro", "cipher", "aes256-gcm", xmlSecTransformUsageEncryptionMethod, "bench-aes256",
+        64 * 1024, 0, NULL, xmlSecBenchTransformSetup, xmlSecBenchTransform);
+
+    xmlSecBenchAddCase("micro", "keys", "find", xmlSecTransformUsageUnknown, NULL,
+        0, XMLSEC_BENCH_KEYS_STORE_SIZE, "keys", xmlSecBenchKeysStoreSetup, xmlSecBenchKeysStoreFind);
+}
+
+/****************************************************************
+ *
+ * Runner
+ *
+ ***************************************************************/
+static int
+xmlSecBenchCompareDouble(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return((da < db) ? -1 : ((da > db) ? 1 : 0));
+}
+
+static double
+xmlSecBenchPercentile(const double* sorted, xmlSecSize size, xmlSecSize percent) {
+    xmlSecSize pos;
+
+    if(size == 0) {
+        return(0);
+    }
+    /* nearest rank */
+    pos = (size * percent + 99) / 100;
+    return(sorted[(pos > 0) ? (pos - 1) : 0]);
+}
+
+static int
+xmlSecBenchRunCase(xmlSecBenchCasePtr bench, xmlSecSize iterations, double minTime) {
+    double* latencies = NULL;
+    xmlSecSize latenciesSize = 0;
+    size_t allocsNum, allocsSize;
+    xmlSecAllocatorStats xmlsecStats;
+    double start, cur, opStart;
+    xmlSecSize ii;
+    int ret;
+
+    ret = bench->setup(bench);
+    if(ret != 0) {
+        bench->status = (ret > 0) ? xmlSecBenchStatusSkipped : xmlSecBenchStatusFailed;
+        bench->cleanup(bench);
+        return((ret > 0) ? 0 : -1);
+    }
+
+    /* warm up and sanity check */
+    ret = bench->run(bench);
+    if(ret < 0) {
+        bench->status = xmlSecBenchStatusFailed;
+        bench->cleanup(bench);
+        return(-1);
+    }
+
+    allocsNum  = g_xmlSecBenchAllocsNum;
+    allocsSize = g_xmlSecBenchAllocsSize;
+    xmlSecAllocatorStatsReset();
+    start = cur = xmlSecBenchGetTime();
+    while(1) {
+        if(iterations > 0) {
+            if(bench->iterations >= iterations) {
+                break;
+            }
+        } else if((bench->iterations >= XMLSEC_BENCH_MIN_ITERATIONS) && ((cur - start) >= minTime)) {
+            break;
+        }
+        if(bench->iterations >= XMLSEC_BENCH_MAX_ITERATIONS) {
+            break;
+        }
+
+        if(bench->iterations >= latenciesSize) {
+            xmlSecSize newSize = (latenciesSize > 0) ? 2 * latenciesSize : 1024;
+            double* newLatencies;
+
+            newLatencies = (double*)realloc(latencies, sizeof(double) * newSize);
+            if(newLatencies == NULL) {
+                fprintf(stderr, "Error: failed to allocate latencies\n");
+                bench->status = xmlSecBenchStatusFailed;
+                break;
+            }
+            latencies = newLatencies;
+            latenciesSize = newSize;
+        }
+
+        opStart = cur;
+        ret = bench->run(bench);
+        cur = xmlSecBenchGetTime();
+        if(ret < 0) {
+            bench->status = xmlSecBenchStatusFailed;
+            break;
+        }
+        latencies[bench->iterations++] = cur - opStart;
+    }
+    bench->totalTime = cur - start;
+    xmlSecAllocatorStatsGet(&xmlsecStats);
+
+    if((bench->status != xmlSecBenchStatusFailed) && (bench->iterations > 0)) {
+        bench->status = xmlSecBenchStatusOk;
+        bench->allocsPerOp = (double)(g_xmlSecBenchAllocsNum - allocsNum) / (double)bench->iterations;
+        bench->allocsSizePerOp = (double)(g_xmlSecBenchAllocsSize - allocsSize) / (double)bench->iterations;
+        bench->xmlsecAllocsPerOp = (double)xmlsecStats.totalAllocs / (double)bench->iterations;
+        bench->xmlsecAllocsSizePerOp = (double)xmlsecStats.totalBytes / (double)bench->iterations;
+        bench->xmlsecPeakBytes = xmlsecStats.peakBytes;
+        for(ii = 0; ii < XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX; ++ii) {
+            bench->xmlsecTypeAllocsPerOp[ii] = (double)xmlsecStats.typeAllocs[ii] / (double)bench->iterations;
+        }
+
+        qsort(latencies, bench->iterations, sizeof(double), xmlSecBenchCompareDouble);
+        bench->minLatency = latencies[0];
+        bench->p50Latency = xmlSecBenchPercentile(latencies, bench->iterations, 50);
+        bench->p99Latency = xmlSecBenchPercentile(latencies, bench->iterations, 99);
+        bench->maxLatency = latencies[bench->iterations - 1];
+    }
+
+    if(latencies != NULL) {
+        free(latencies);
+    }
+    bench->cleanup(bench);
+    return((bench->status == xmlSecBenchStatusOk) ? 0 : -1);
+}
+
+static const char*
+xmlSecBenchStatusToString(xmlSecBenchStatus status) {
+    switch(status) {
+    case xmlSecBenchStatusOk:
+        return("ok");
+    case xmlSecBenchStatusSkipped:
+        return("skipped");
+    case xmlSecBenchStatusFailed:
+        return("failed");
+    case xmlSecBenchStatusNotRun:
+    default:
+        return("not-run");
+    }
+}
+
+static double
+xmlSecBenchOpsPerSec(xmlSecBenchCasePtr bench) {
+    return((bench->totalTime > 0) ? ((double)bench->iterations / bench->totalTime) : 0);
+}
+
+static void
+xmlSecBenchPrintText(FILE* output) {
+    xmlSecBenchCasePtr bench;
+    xmlSecSize ii;
+
+    fprintf(output, "%-48s %10s %12s %12s %12s %12s %10s %10s\n",
+        "benchmark", "iterations", "ops/s", "p50 (us)", "p99 (us)", "MB/s", "allocs/op", "xmlsec/op");
+    for(ii = 0; ii < g_xmlSecBenchCasesNum; ++ii) {
+        bench = &(g_xmlSecBenchCases[ii]);
+        if(bench->status == xmlSecBenchStatusNotRun) {
+            continue;
+        }
+        if(bench->status != xmlSecBenchStatusOk) {
+            fprintf(output, "%-48s %s\n", bench->name, xmlSecBenchStatusToString(bench->status));
+            continue;
+        }
+        fprintf(output, "%-48s %10lu %12.1f %12.1f %12.1f %12.2f %10.1f %10.1f\n",
+            bench->name,
+            (unsigned long)bench->iterations,
+            xmlSecBenchOpsPerSec(bench),
+            bench->p50Latency * 1000000.0,
+            bench->p99Latency * 1000000.0,
+            xmlSecBenchOpsPerSec(bench) * (double)bench->bytesPerOp / (1024.0 * 1024.0),
+            bench->allocsPerOp,
+            bench->xmlsecAllocsPerOp);
+    }
+}
+
+static void
+xmlSecBenchPrintJson(FILE* output, const char* crypto) {
+    xmlSecBenchCasePtr bench;
+    xmlSecSize ii, jj;
+    int first = 1;
+
+    fprintf(output, "{\n");
+    fprintf(output, "  \"xmlsec\": \"%s\",\n", XMLSEC_VERSION);
+    fprintf(output, "  \"crypto\": \"%s\",\n", crypto);
+    fprintf(output, "  \"results\": [");
+    for(ii = 0; ii < g_xmlSecBenchCasesNum; ++ii) {
+        bench = &(g_xmlSecBenchCases[ii]);
+        if(bench->status == xmlSecBenchStatusNotRun) {
+            continue;
+        }
+        fprintf(output, "%s\n    {\n", (first != 0) ? "" : ",");
+        first = 0;
+
+        fprintf(output, "      \"name\": \"%s\",\n", bench->name);
+        fprintf(output, "      \"group\": \"%s\",\n", bench->group);
+        fprintf(output, "      \"status\": \"%s\"", xmlSecBenchStatusToString(bench->status));
+        if(bench->status == xmlSecBenchStatusOk) {
+            fprintf(output, ",\n");
+            fprintf(output, "      \"iterations\": %lu,\n", (unsigned long)bench->iterations);
+            fprintf(output, "      \"total_sec\": %.6f,\n", bench->totalTime);
+            fprintf(output, "      \"ops_per_sec\": %.3f,\n", xmlSecBenchOpsPerSec(bench));
+            fprintf(output, "      \"latency_min_us\": %.3f,\n", bench->minLatency * 1000000.0);
+            fprintf(output, "      \"latency_p50_us\": %.3f,\n", bench->p50Latency * 1000000.0);
+            fprintf(output, "      \"latency_p99_us\": %.3f,\n", bench->p99Latency * 1000000.0);
+            fprintf(output, "      \"latency_max_us\": %.3f,\n", bench->maxLatency * 1000000.0);
+            fprintf(output, "      \"bytes_per_op\": %lu,\n", (unsigned long)bench->bytesPerOp);
+            fprintf(output, "      \"bytes_per_sec\": %.1f,\n", xmlSecBenchOpsPerSec(bench) * (double)bench->bytesPerOp);
+            fprintf(output, "      \"allocs_per_op\": %.2f,\n", bench->allocsPerOp);
+            fprintf(output, "      \"alloc_bytes_per_op\": %.1f,\n", bench->allocsSizePerOp);
+            fprintf(output, "      \"xmlsec_allocs_per_op\": %.2f,\n", bench->xmlsecAllocsPerOp);
+            fprintf(output, "      \"xmlsec_alloc_bytes_per_op\": %.1f,\n", bench->xmlsecAllocsSizePerOp);
+            fprintf(output, "      \"xmlsec_peak_bytes\": %lu,\n", (unsigned long)bench->xmlsecPeakBytes);
+            fprintf(output, "      \"xmlsec_allocs_per_op_by_type\": {");
+            for(jj = 0; jj < XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX; ++jj) {
+                fprintf(output, "%s\"%s\": %.2f", (jj > 0) ? ", " : " ",
+                    xmlSecAllocatorObjectTypeGetName((xmlSecAllocatorObjectType)jj),
+                    bench->xmlsecTypeAllocsPerOp[jj]);
+            }
+            fprintf(output, " }\n");
+        } else {
+            fprintf(output, "\n");
+        }
+        fprintf(output, "    }");
+    }
+    fprintf(output, "\n  ]\n}\n");
+}
+
+static int
+xmlSecBenchMatch(const char* name, const char** argv, int argc, int pos) {
+    int ii;
+
+    if(pos >= argc) {
+        return(1);
+    }
+    for(ii = pos; ii < argc; ++ii) {
+        if(strstr(name, argv[ii]) != NULL) {
+            return(1);
+        }
+    }
+    return(0);
+}
+
+static void
+xmlSecBenchPrintHelp(void) {
+    fprintf(stdout, "%s\n", helpUsage);
+    fprintf(stdout, "Options:\n");
+    xmlSecAppCmdLineParamsListPrint(parameters, xmlSecBenchCmdLineTopicAll, stdout);
+    fprintf(stdout, "\n%s\n", bugs);
+    fprintf(stdout, "%s\n", copyright);
+}
+
+int
+main(int argc, const char **argv) {
+    const char* crypto = NULL;
+    const char* format;
+    const char* outputFileName;
+    FILE* output = stdout;
+    xmlSecSize iterations = 0;
+    double minTime;
+    xmlSecSize ii;
+    int initialized = 0;
+    int failed = 0;
+    int pos;
+    int res = 1;
+
+    /* count all allocations: this MUST be done before libxml2 initialization */
+    xmlMemSetup(xmlSecBenchFree, xmlSecBenchMalloc, xmlSecBenchRealloc, xmlSecBenchStrdup);
+    xmlGcMemSetup(xmlSecBenchFree, xmlSecBenchMalloc, xmlSecBenchMalloc, xmlSecBenchRealloc, xmlSecBenchStrdup);
+
+    pos = xmlSecAppCmdLineParamsListParse(parameters, xmlSecBenchCmdLineTopicAll, argv, argc, 1);
+    if(pos < 0) {
+        fprintf(stderr, "Error: invalid parameters\n");
+        fprintf(stderr, "%s\n", helpUsage);
+        goto done;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&helpParam)) {
+        xmlSecBenchPrintHelp();
+        res = 0;
+        goto done;
+    }
+
+    xmlSecBenchInitCases();
+    if(xmlSecAppCmdLineParamIsSet(&listParam)) {
+        for(ii = 0; ii < g_xmlSecBenchCasesNum; ++ii) {
+            if(xmlSecBenchMatch(g_xmlSecBenchCases[ii].name, argv, argc, pos) != 0) {
+                fprintf(stdout, "%s\n", g_xmlSecBenchCases[ii].name);
+            }
+        }
+        res = 0;
+        goto done;
+    }
+
+    if(xmlSecAppCmdLineParamIsSet(&iterationsParam)) {
+        int value = xmlSecAppCmdLineParamGetInt(&iterationsParam, 0);
+        if(value <= 0) {
+            fprintf(stderr, "Error: iterations number should be greater than zero\n");
+            goto done;
+        }
+        iterations = (xmlSecSize)value;
+    }
+    minTime = (double)xmlSecAppCmdLineParamGetInt(&minTimeParam, XMLSEC_BENCH_DEFAULT_MIN_TIME) / 1000.0;
+    if(minTime < 0) {
+        fprintf(stderr, "Error: min time should be greater or equal to zero\n");
+        goto done;
+    }
+
+    format = xmlSecAppCmdLineParamGetString(&formatParam);
+    if((format != NULL) && (strcmp(format, "text") != 0) && (strcmp(format, "json") != 0)) {
+        fprintf(stderr, "Error: unknown output format \"%s\"\n", format);
+        goto done;
+    }
+
+    /* init libxml, libxslt and xmlsec */
+    xmlInitParser();
+    LIBXML_TEST_VERSION
+    initialized = 1;
+
+    /* count xmlsec objects allocations: this MUST be done before xmlsec initialization */
+    if(xmlSecAllocatorStatsEnable(1) < 0) {
+        fprintf(stderr, "Error: failed to enable xmlsec allocator stats.\n");
+        goto done;
+    }
+
+    if(xmlSecInit() < 0) {
+        fprintf(stderr, "Error: xmlsec intialization failed.\n");
+        goto done;
+    }
+    if(xmlSecCheckVersion() != 1) {
+        fprintf(stderr, "Error: loaded xmlsec library version is not compatible.\n");
+        goto done;
+    }
+    xmlSecErrorsDefaultCallbackEnableOutput(xmlSecAppCmdLineParamIsSet(&verboseParam) ? 1 : 0);
+
+    crypto = xmlSecAppCmdLineParamGetString(&cryptoParam);
+#if !defined(XMLSEC_NO_CRYPTO_DYNAMIC_LOADING) && defined(XMLSEC_CRYPTO_DYNAMIC_LOADING)
+    if(xmlSecCryptoDLLoadLibrary(BAD_CAST crypto) < 0) {
+        fprintf(stderr, "Error: unable to load xmlsec-%s library. Make sure that you have\n"
+                        "this it installed, check shared libraries path (LD_LIBRARY_PATH)\n"
+                        "environment variable or use \"--crypto\" option to specify different\n"
+                        "crypto engine.\n",
+                        ((crypto != NULL) ? crypto : (const char*)xmlSecGetDefaultCrypto())
+        );
+        goto done;
+    }
+#else  /* !defined(XMLSEC_NO_CRYPTO_DYNAMIC_LOADING) && defined(XMLSEC_CRYPTO_DYNAMIC_LOADING) */
+    if((crypto != NULL) && (xmlStrcmp(BAD_CAST crypto, xmlSecGetDefaultCrypto()) != 0)) {
+        fprintf(stderr, "Error: crypto engine \"%s\" is not supported, this build uses \"%s\".\n",
+                        crypto, (const char*)xmlSecGetDefaultCrypto());
+        goto done;
+    }
+#endif /* !defined(XMLSEC_NO_CRYPTO_DYNAMIC_LOADING) && defined(XMLSEC_CRYPTO_DYNAMIC_LOADING) */
+    if(crypto == NULL) {
+        crypto = (const char*)xmlSecGetDefaultCrypto();
+    }
+
+    if(xmlSecAppCryptoInit(xmlSecAppCmdLineParamGetString(&cryptoConfigParam)) < 0) {
+        fprintf(stderr, "Error: xmlsec crypto intialization failed.\n");
+        goto done;
+    }
+
+    g_xmlSecBenchKeysMngr = xmlSecKeysMngrCreate();
+    if(g_xmlSecBenchKeysMngr == NULL) {
+        fprintf(stderr, "Error: failed to create keys manager\n");
+        goto done;
+    }
+    if(xmlSecAppCryptoSimpleKeysMngrInit(g_xmlSecBenchKeysMngr) < 0) {
+        fprintf(stderr, "Error: failed to initialize keys manager\n");
+        goto done;
+    }
+
+    /* run */
+    for(ii = 0; ii < g_xmlSecBenchCasesNum; ++ii) {
+        if(xmlSecBenchMatch(g_xmlSecBenchCases[ii].name, argv, argc, pos) == 0) {
+            continue;
+        }
+        if(xmlSecBenchRunCase(&(g_xmlSecBenchCases[ii]), iterations, minTime) < 0) {
+            fprintf(stderr, "Error: benchmark \"%s\" failed\n", g_xmlSecBenchCases[ii].name);
+            failed = 1;
+        }
+    }
+
+    /* report */
+    outputFileName = xmlSecAppCmdLineParamGetString(&outputParam);
+    if((outputFileName != NULL) && (strcmp(outputFileName, XMLSEC_STDOUT_FILENAME) != 0)) {
+        output = fopen(outputFileName, "w");
+        if(output == NULL) {
+            fprintf(stderr, "Error: failed to open output file \"%s\"\n", outputFileName);
+            goto done;
+        }
+    }
+    if((format != NULL) && (strcmp(format, "json") == 0)) {
+        xmlSecBenchPrintJson(output, crypto);
+    } else {
+        xmlSecBenchPrintText(output);
+    }
+    if(output != stdout) {
+        fclose(output);
+    }
+
+    res = (failed != 0) ? 1 : 0;
+
+done:
+    if(g_xmlSecBenchKeysMngr != NULL) {
+        xmlSecKeysMngrDestroy(g_xmlSecBenchKeysMngr);
+        g_xmlSecBenchKeysMngr = NULL;
+    }
+    if(initialized != 0) {
+        xmlSecAppCryptoShutdown();
+        xmlSecShutdown();
+#ifndef XMLSEC_NO_XSLT
+        xsltCleanupGlobals();
+#endif /* XMLSEC_NO_XSLT */
+        xmlCleanupParser();
+    }
+    xmlSecAppCmdLineParamsListClean(parameters);
+    return(res);
+}
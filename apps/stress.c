@@ -0,0 +1,642 @@
+/*
+ * XML Security Library
+ *
+ * Multi-threaded stress test: several worker threads sign and verify
+ * documents while the main thread changes the global configuration
+ * (registers transforms and key data klasses, resets IO callbacks,
+ * changes the default binary chunk size). Before that it checks that the keys
+ * list returned by xmlSecSimpleKeysStoreGetKeys() survives adding keys. Build
+ * xmlsec with "--enable-tsan" to run it under ThreadSanitizer.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else  /* defined(_WIN32) */
+#include <pthread.h>
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+#include <libxml/tree.h>
+#include <libxml/xmlmemory.h>
+#include <libxml/parser.h>
+
+#ifndef XMLSEC_NO_XSLT
+#include <libxslt/xslt.h>
+#endif /* XMLSEC_NO_XSLT */
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/xmltree.h>
+#include <xmlsec/keys.h>
+#include <xmlsec/keysdata.h>
+#include <xmlsec/keysmngr.h>
+#include <xmlsec/transforms.h>
+#include <xmlsec/io.h>
+#include <xmlsec/xmldsig.h>
+#include <xmlsec/templates.h>
+#include <xmlsec/errors.h>
+
+#include "crypto.h"
+#include "cmdline.h"
+
+static const char copyright[] =
+    "Written by Aleksey Sanin <aleksey@aleksey.com>.\n\n"
+    "Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved..\n"
+    "This is free software: see the source for copying information.\n";
+
+static const char bugs[] =
+    "Report bugs to http://www.aleksey.com/xmlsec/bugs.html\n";
+
+static const char helpUsage[] =
+    "Usage: xmlsec-stress [<options>]\n"
+    "Runs XML Security Library multi-threaded stress test: the worker threads\n"
+    "sign and verify documents with one shared keys manager while the main\n"
+    "thread changes the global configuration and adds keys to the keys manager.\n";
+
+#define xmlSecStressCmdLineTopicGeneral         0x0001
+#define xmlSecStressCmdLineTopicAll             0xFFFF
+
+#define XMLSEC_STRESS_DEFAULT_THREADS           8
+#define XMLSEC_STRESS_DEFAULT_ITERATIONS        100
+#define XMLSEC_STRESS_DEFAULT_RELOADS           100
+#define XMLSEC_STRESS_MAX_THREADS               256
+
+/****************************************************************
+ *
+ * Command line parameters
+ *
+ ***************************************************************/
+static xmlSecAppCmdLineParam helpParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--help",
+    "-h",
+    "--help"
+    "\n\tprint help information about the command",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam cryptoParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--crypto",
+    NULL,
+    "--crypto <name>"
+    "\n\tthe name of the crypto engine to use from the following"
+    "\n\tlist: openssl, mscrypto, nss, gnutls, gcrypt (if no crypto engine is"
+    "\n\tspecified then the default one is used)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam cryptoConfigParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--crypto-config",
+    NULL,
+    "--crypto-config <path>"
+    "\n\tpath to crypto engine configuration",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam threadsParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--threads",
+    "-t",
+    "--threads <number>"
+    "\n\tthe number of worker threads (default: 8)",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam iterationsParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--iterations",
+    "-n",
+    "--iterations <number>"
+    "\n\tthe number of sign/verify operations per worker thread (default: 100)",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam reloadsParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--reloads",
+    NULL,
+    "--reloads <number>"
+    "\n\tthe number of the global configuration changes done by the main"
+    "\n\tthread while the workers are running (default: 100)",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam verboseParam = {
+    xmlSecStressCmdLineTopicGeneral,
+    "--verbose",
+    "-v",
+    "--verbose"
+    "\n\tprint the xmlsec errors",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParamPtr parameters[] = {
+    &helpParam,
+    &cryptoParam,
+    &cryptoConfigParam,
+    &threadsParam,
+    &iterationsParam,
+    &reloadsParam,
+    &verboseParam,
+    NULL
+};
+
+/****************************************************************
+ *
+ * Worker
+ *
+ ***************************************************************/
+typedef struct _xmlSecStressWorker {
+    int                         id;
+    int                         iterations;
+    int                         failed;
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    HANDLE                      handle;
+#else  /* defined(_WIN32) */
+    pthread_t                   handle;
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+} xmlSecStressWorker, *xmlSecStressWorkerPtr;
+
+static xmlSecKeysMngrPtr g_xmlSecStressKeysMngr = NULL;
+static xmlSecTransformId g_xmlSecStressSignId = xmlSecTransformIdUnknown;
+static xmlSecTransformId g_xmlSecStressDigestId = xmlSecTransformIdUnknown;
+static xmlChar* g_xmlSecStressIds[] = { BAD_CAST "Id", NULL };
+static const char g_xmlSecStressKeyName[] = "stress-hmac";
+static const char g_xmlSecStressReloadKeyName[] = "stress-reload";
+static const char g_xmlSecStressDoc[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<Envelope xmlns=\"urn:xmlsec:stress\">"
+    "<Data Id=\"data\">The quick brown fox jumps over the lazy dog.</Data>"
+    "</Envelope>";
+
+static xmlDocPtr
+xmlSecStressCreateDoc(void) {
+    xmlDocPtr doc;
+    xmlNodePtr signNode;
+    xmlNodePtr refNode;
+    xmlNodePtr keyInfoNode;
+
+    doc = xmlReadMemory(g_xmlSecStressDoc, (int)(sizeof(g_xmlSecStressDoc) - 1), NULL, NULL, 0);
+    if(doc == NULL) {
+        fprintf(stderr, "Error: failed to parse document\n");
+        return(NULL);
+    }
+    xmlSecAddIDs(doc, xmlDocGetRootElement(doc), (const xmlChar**)g_xmlSecStressIds);
+
+    signNode = xmlSecTmplSignatureCreate(doc, xmlSecTransformExclC14NId, g_xmlSecStressSignId, NULL);
+    if(signNode == NULL) {
+        fprintf(stderr, "Error: failed to create signature template\n");
+        xmlFreeDoc(doc);
+        return(NULL);
+    }
+    xmlAddChild(xmlDocGetRootElement(doc), signNode);
+
+    refNode = xmlSecTmplSignatureAddReference(signNode, g_xmlSecStressDigestId, NULL, BAD_CAST "#data", NULL);
+    if((refNode == NULL) || (xmlSecTmplReferenceAddTransform(refNode, xmlSecTransformExclC14NId) == NULL)) {
+        fprintf(stderr, "Error: failed to add reference to signature template\n");
+        xmlFreeDoc(doc);
+        return(NULL);
+    }
+
+    keyInfoNode = xmlSecTmplSignatureEnsureKeyInfo(signNode, NULL);
+    if((keyInfoNode == NULL) || (xmlSecTmplKeyInfoAddKeyName(keyInfoNode, BAD_CAST g_xmlSecStressKeyName) == NULL)) {
+        fprintf(stderr, "Error: failed to add key info to signature template\n");
+        xmlFreeDoc(doc);
+        return(NULL);
+    }
+    return(doc);
+}
+
+static int
+xmlSecStressSignVerify(void) {
+    xmlDocPtr doc;
+    xmlNodePtr node;
+    xmlSecDSigCtxPtr dsigCtx = NULL;
+    int res = -1;
+
+    /* registries lookups */
+    if(xmlSecTransformIdListFindByName(xmlSecTransformIdsGet(), BAD_CAST "base64", xmlSecTransformUsageAny) == xmlSecTransformIdUnknown) {
+        fprintf(stderr, "Error: base64 transform is not found\n");
+        return(-1);
+    }
+    if(xmlSecKeyDataIdListFindByName(xmlSecKeyDataIdsGet(), BAD_CAST "key-name", xmlSecKeyDataUsageAny) == xmlSecKeyDataIdUnknown) {
+        fprintf(stderr, "Error: key name key data is not found\n");
+        return(-1);
+    }
+
+    doc = xmlSecStressCreateDoc();
+    if(doc == NULL) {
+        return(-1);
+    }
+    node = xmlSecFindNode(xmlDocGetRootElement(doc), xmlSecNodeSignature, xmlSecDSigNs);
+    if(node == NULL) {
+        fprintf(stderr, "Error: signature node is not found\n");
+        goto done;
+    }
+
+    /* sign */
+    dsigCtx = xmlSecDSigCtxCreate(g_xmlSecStressKeysMngr);
+    if(dsigCtx == NULL) {
+        fprintf(stderr, "Error: failed to create signature context\n");
+        goto done;
+    }
+    if(xmlSecDSigCtxSign(dsigCtx, node) < 0) {
+        fprintf(stderr, "Error: signature failed\n");
+        goto done;
+    }
+    xmlSecDSigCtxDestroy(dsigCtx);
+
+    /* verify */
+    dsigCtx = xmlSecDSigCtxCreate(g_xmlSecStressKeysMngr);
+    if(dsigCtx == NULL) {
+        fprintf(stderr, "Error: failed to create signature context\n");
+        goto done;
+    }
+    if(xmlSecDSigCtxVerify(dsigCtx, node) < 0) {
+        fprintf(stderr, "Error: signature verification failed\n");
+        goto done;
+    }
+    if(dsigCtx->status != xmlSecDSigStatusSucceeded) {
+        fprintf(stderr, "Error: signature is invalid\n");
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(dsigCtx != NULL) {
+        xmlSecDSigCtxDestroy(dsigCtx);
+    }
+    xmlFreeDoc(doc);
+    return(res);
+}
+
+static void
+xmlSecStressWorkerRun(xmlSecStressWorkerPtr worker) {
+    int ii;
+
+    for(ii = 0; ii < worker->iterations; ++ii) {
+        if(xmlSecStressSignVerify() < 0) {
+            fprintf(stderr, "Error: worker %d failed at iteration %d\n", worker->id, ii);
+            worker->failed = 1;
+            return;
+        }
+    }
+}
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+static unsigned __stdcall
+xmlSecStressWorkerMain(void* arg) {
+    xmlSecStressWorkerRun((xmlSecStressWorkerPtr)arg);
+    return(0);
+}
+
+static int
+xmlSecStressWorkerStart(xmlSecStressWorkerPtr worker) {
+    worker->handle = (HANDLE)_beginthreadex(NULL, 0, xmlSecStressWorkerMain, worker, 0, NULL);
+    return((worker->handle != 0) ? 0 : -1);
+}
+
+static void
+xmlSecStressWorkerJoin(xmlSecStressWorkerPtr worker) {
+    WaitForSingleObject(worker->handle, INFINITE);
+    CloseHandle(worker->handle);
+}
+#else  /* defined(_WIN32) */
+static void*
+xmlSecStressWorkerMain(void* arg) {
+    xmlSecStressWorkerRun((xmlSecStressWorkerPtr)arg);
+    return(NULL);
+}
+
+static int
+xmlSecStressWorkerStart(xmlSecStressWorkerPtr worker) {
+    return((pthread_create(&(worker->handle), NULL, xmlSecStressWorkerMain, worker) == 0) ? 0 : -1);
+}
+
+static void
+xmlSecStressWorkerJoin(xmlSecStressWorkerPtr worker) {
+    pthread_join(worker->handle, NULL);
+}
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+/****************************************************************
+ *
+ * Keys store
+ *
+ ***************************************************************/
+static int
+xmlSecStressAdoptKey(xmlSecKeyStorePtr store, const char* name) {
+    xmlSecKeyPtr key;
+
+    key = xmlSecAppCryptoKeyGenerate("hmac-256", name, xmlSecKeyDataTypePermanent);
+    if(key == NULL) {
+        fprintf(stderr, "Error: failed to generate key \"%s\"\n", name);
+        return(-1);
+    }
+    if(xmlSecSimpleKeysStoreAdoptKey(store, key) < 0) {
+        fprintf(stderr, "Error: failed to adopt key \"%s\"\n", name);
+        xmlSecKeyDestroy(key);
+        return(-1);
+    }
+    return(0);
+}
+
+/* the keys list returned by xmlSecSimpleKeysStoreGetKeys() must stay valid
+ * after the keys store adopts more keys and looks them up */
+static int
+xmlSecStressCheckKeysList(void) {
+    xmlSecKeyStorePtr store;
+    xmlSecKeyInfoCtxPtr keyInfoCtx = NULL;
+    xmlSecPtrListPtr keys;
+    xmlSecKeyPtr key;
+    int res = -1;
+
+    store = xmlSecKeyStoreCreate(xmlSecSimpleKeysStoreId);
+    if(store == NULL) {
+        fprintf(stderr, "Error: failed to create keys store\n");
+        return(-1);
+    }
+    if(xmlSecStressAdoptKey(store, g_xmlSecStressKeyName) < 0) {
+        goto done;
+    }
+    keys = xmlSecSimpleKeysStoreGetKeys(store);
+    if((keys == NULL) || (xmlSecPtrListGetSize(keys) != 1)) {
+        fprintf(stderr, "Error: failed to get keys list\n");
+        goto done;
+    }
+
+    if(xmlSecStressAdoptKey(store, g_xmlSecStressReloadKeyName) < 0) {
+        goto done;
+    }
+    keyInfoCtx = xmlSecKeyInfoCtxCreate(NULL);
+    if(keyInfoCtx == NULL) {
+        fprintf(stderr, "Error: failed to create key info context\n");
+        goto done;
+    }
+    key = xmlSecKeyStoreFindKey(store, BAD_CAST g_xmlSecStressReloadKeyName, keyInfoCtx);
+    if(key == NULL) {
+        fprintf(stderr, "Error: key \"%s\" is not found\n", g_xmlSecStressReloadKeyName);
+        goto done;
+    }
+    xmlSecKeyDestroy(key);
+
+    /* the old keys list still has the first key only */
+    key = (xmlSecPtrListGetSize(keys) == 1) ? (xmlSecKeyPtr)xmlSecPtrListGetItem(keys, 0) : NULL;
+    if((!xmlSecKeyIsValid(key)) || (xmlStrcmp(xmlSecKeyGetName(key), BAD_CAST g_xmlSecStressKeyName) != 0)) {
+        fprintf(stderr, "Error: keys list is changed after adding a key\n");
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(keyInfoCtx != NULL) {
+        xmlSecKeyInfoCtxDestroy(keyInfoCtx);
+    }
+    xmlSecKeyStoreDestroy(store);
+    return(res);
+}
+
+/****************************************************************
+ *
+ * Global configuration changes
+ *
+ ***************************************************************/
+static int
+xmlSecStressReload(int round) {
+    xmlSecTransformCtxSetDefaultBinaryChunkSize(((round % 2) == 0) ? 4096 : (64 * 1024));
+
+    if(xmlSecTransformIdsRegister(xmlSecTransformBase64Id) < 0) {
+        fprintf(stderr, "Error: failed to register transform\n");
+        return(-1);
+    }
+    if(xmlSecKeyDataIdsRegisterDisabled(xmlSecKeyDataNameId) < 0) {
+        fprintf(stderr, "Error: failed to register key data\n");
+        return(-1);
+    }
+
+    xmlSecIOCleanupCallbacks();
+    if(xmlSecIORegisterDefaultCallbacks() < 0) {
+        fprintf(stderr, "Error: failed to register IO callbacks\n");
+        return(-1);
+    }
+
+    /* the workers lookup keys in the same keys manager */
+    if(xmlSecAppCryptoSimpleKeysMngrKeyGenerate(g_xmlSecStressKeysMngr, "hmac-256", g_xmlSecStressReloadKeyName) < 0) {
+        fprintf(stderr, "Error: failed to add key\n");
+        return(-1);
+    }
+    return(0);
+}
+
+#if !defined(XMLSEC_NO_THREADS)
+static int
+xmlSecStressRun(int threadsNum, int iterations, int reloads) {
+    xmlSecStressWorkerPtr workers;
+    int started;
+    int failed = 0;
+    int ii;
+
+    workers = (xmlSecStressWorkerPtr)malloc(sizeof(xmlSecStressWorker) * (size_t)threadsNum);
+    if(workers == NULL) {
+        fprintf(stderr, "Error: failed to allocate workers\n");
+        return(-1);
+    }
+    memset(workers, 0, sizeof(xmlSecStressWorker) * (size_t)threadsNum);
+
+    fprintf(stdout, "Running %d threads x %d iterations with %d reloads\n", threadsNum, iterations, reloads);
+    for(started = 0; started < threadsNum; ++started) {
+        workers[started].id = started;
+        workers[started].iterations = iterations;
+        if(xmlSecStressWorkerStart(&(workers[started])) < 0) {
+            fprintf(stderr, "Error: failed to start worker %d\n", started);
+            failed = 1;
+            break;
+        }
+    }
+
+    /* change the global configuration while the workers are running */
+    for(ii = 0; (ii < reloads) && (failed == 0); ++ii) {
+        if(xmlSecStressReload(ii) < 0) {
+            failed = 1;
+        }
+    }
+
+    for(ii = 0; ii < started; ++ii) {
+        xmlSecStressWorkerJoin(&(workers[ii]));
+        if(workers[ii].failed != 0) {
+            failed = 1;
+        }
+    }
+    free(workers);
+
+    if(failed != 0) {
+        return(-1);
+    }
+    fprintf(stdout, "OK\n");
+    return(0);
+}
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+static void
+xmlSecStressPrintHelp(void) {
+    fprintf(stdout, "%s\n", helpUsage);
+    fprintf(stdout, "Options:\n");
+    xmlSecAppCmdLineParamsListPrint(parameters, xmlSecStressCmdLineTopicAll, stdout);
+    fprintf(stdout, "\n%s\n", bugs);
+    fprintf(stdout, "%s\n", copyright);
+}
+
+int
+main(int argc, const char **argv) {
+    const char* crypto = NULL;
+    int threadsNum, iterations, reloads;
+    int initialized = 0;
+    int pos;
+    int res = 1;
+
+    pos = xmlSecAppCmdLineParamsListParse(parameters, xmlSecStressCmdLineTopicAll, argv, argc, 1);
+    if((pos < 0) || (pos != argc)) {
+        fprintf(stderr, "Error: invalid parameters\n");
+        fprintf(stderr, "%s\n", helpUsage);
+        goto done;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&helpParam)) {
+        xmlSecStressPrintHelp();
+        res = 0;
+        goto done;
+    }
+
+    threadsNum = xmlSecAppCmdLineParamGetInt(&threadsParam, XMLSEC_STRESS_DEFAULT_THREADS);
+    iterations = xmlSecAppCmdLineParamGetInt(&iterationsParam, XMLSEC_STRESS_DEFAULT_ITERATIONS);
+    reloads = xmlSecAppCmdLineParamGetInt(&reloadsParam, XMLSEC_STRESS_DEFAULT_RELOADS);
+    if((threadsNum <= 0) || (threadsNum > XMLSEC_STRESS_MAX_THREADS) || (iterations <= 0) || (reloads < 0)) {
+        fprintf(stderr, "Error: invalid threads, iterations or reloads number\n");
+        goto done;
+    }
+
+    /* init libxml, libxslt and xmlsec */
+    xmlInitParser();
+    LIBXML_TEST_VERSION
+    initialized = 1;
+
+    if(xmlSecInit() < 0) {
+        fprintf(stderr, "Error: xmlsec intialization failed.\n");
+        goto done;
+    }
+    if(xmlSecCheckVersion() != 1) {
+        fprintf(stderr, "Error: loaded xmlsec library version is not compatible.\n");
+        goto done;
+    }
+    xmlSecErrorsDefaultCallbackEnableOutput(xmlSecAppCmdLineParamIsSet(&verboseParam) ? 1 : 0);
+
+    crypto = xmlSecAppCmdLineParamGetString(&cryptoParam);
+#if !defined(XMLSEC_NO_CRYPTO_DYNAMIC_LOADING) && defined(XMLSEC_CRYPTO_DYNAMIC_LOADING)
+    if(xmlSecCryptoDLLoadLibrary(BAD_CAST crypto) < 0) {
+        fprintf(stderr, "Error: unable to load xmlsec-%s library. Make sure that you have\n"
+                        "this it installed, check shared libraries path (LD_LIBRARY_PATH)\n"
+                        "environment variable or use \"--crypto\" option to specify different\n"
+                        "crypto engine.\n",
+                        ((crypto != NULL) ? crypto : (const char*)xmlSecGetDefaultCrypto())
+        );
+        goto done;
+    }
+#else  /* !defined(XMLSEC_NO_CRYPTO_DYNAMIC_LOADING) && defined(XMLSEC_CRYPTO_DYNAMIC_LOADING) */
+    if((crypto != NULL) && (xmlStrcmp(BAD_CAST crypto, xmlSecGetDefaultCrypto()) != 0)) {
+        fprintf(stderr, "Error: crypto engine \"%s\" is not supported, this build uses \"%s\".\n",
+                        crypto, (const char*)xmlSecGetDefaultCrypto());
+        goto done;
+    }
+#endif /* !defined(XMLSEC_NO_CRYPTO_DYNAMIC_LOADING) && defined(XMLSEC_CRYPTO_DYNAMIC_LOADING) */
+
+    if(xmlSecAppCryptoInit(xmlSecAppCmdLineParamGetString(&cryptoConfigParam)) < 0) {
+        fprintf(stderr, "Error: xmlsec crypto intialization failed.\n");
+        goto done;
+    }
+
+    g_xmlSecStressSignId = xmlSecTransformIdListFindByName(xmlSecTransformIdsGet(),
+        BAD_CAST "hmac-sha256", xmlSecTransformUsageSignatureMethod);
+    g_xmlSecStressDigestId = xmlSecTransformIdListFindByName(xmlSecTransformIdsGet(),
+        BAD_CAST "sha256", xmlSecTransformUsageDigestMethod);
+    if((g_xmlSecStressSignId == xmlSecTransformIdUnknown) || (g_xmlSecStressDigestId == xmlSecTransformIdUnknown)) {
+        fprintf(stdout, "Skipped: hmac-sha256 or sha256 is not supported by the crypto engine\n");
+        res = 0;
+        goto done;
+    }
+
+    g_xmlSecStressKeysMngr = xmlSecKeysMngrCreate();
+    if(g_xmlSecStressKeysMngr == NULL) {
+        fprintf(stderr, "Error: failed to create keys manager\n");
+        goto done;
+    }
+    if(xmlSecAppCryptoSimpleKeysMngrInit(g_xmlSecStressKeysMngr) < 0) {
+        fprintf(stderr, "Error: failed to initialize keys manager\n");
+        goto done;
+    }
+    if(xmlSecAppCryptoSimpleKeysMngrKeyGenerate(g_xmlSecStressKeysMngr, "hmac-256", g_xmlSecStressKeyName) < 0) {
+        fprintf(stderr, "Error: failed to generate key\n");
+        goto done;
+    }
+    if(xmlSecStressCheckKeysList() < 0) {
+        goto done;
+    }
+
+#if !defined(XMLSEC_NO_THREADS)
+    if(xmlSecStressRun(threadsNum, iterations, reloads) < 0) {
+        goto done;
+    }
+#else  /* !defined(XMLSEC_NO_THREADS) */
+    fprintf(stdout, "Skipped: xmlsec is compiled without threads support\n");
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+    /* success */
+    res = 0;
+
+done:
+    if(g_xmlSecStressKeysMngr != NULL) {
+        xmlSecKeysMngrDestroy(g_xmlSecStressKeysMngr);
+        g_xmlSecStressKeysMngr = NULL;
+    }
+    if(initialized != 0) {
+        xmlSecAppCryptoShutdown();
+        xmlSecShutdown();
+#ifndef XMLSEC_NO_XSLT
+        xsltCleanupGlobals();
+#endif /* XMLSEC_NO_XSLT */
+        xmlCleanupParser();
+    }
+    xmlSecAppCmdLineParamsListClean(parameters);
+    return(res);
+}
@@ -5,14 +5,28 @@
  *
  * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
  */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif /* !defined(_WIN32) && !defined(_POSIX_C_SOURCE) */
+
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 
 #if !defined(_MSC_VER)
 #include <libgen.h>
 #endif /* defined(_MSC_VER) */
 
+#if defined(_WIN32)
+#include <windows.h>
+#if !defined(XMLSEC_NO_THREADS)
+#include <process.h>
+#endif /* !defined(XMLSEC_NO_THREADS) */
+#elif !defined(XMLSEC_NO_THREADS)
+#include <pthread.h>
+#endif /* defined(_WIN32) */
+
 #if defined(_MSC_VER) && _MSC_VER < 1900
 #define snprintf _snprintf
 #endif /* defined(_MSC_VER) && _MSC_VER < 1900 */
@@ -24,6 +38,10 @@
 #include <libxml/xpath.h>
 #include <libxml/xmlsave.h>
 #include <libxml/xpathInternals.h>
+#include <libxml/threads.h>
+#ifdef LIBXML_READER_ENABLED
+#include <libxml/xmlreader.h>
+#endif /* LIBXML_READER_ENABLED */
 
 #ifndef XMLSEC_NO_XSLT
 #include <libxslt/xslt.h>
@@ -47,6 +65,7 @@
 #include <xmlsec/parser.h>
 #include <xmlsec/templates.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/trace.h>
 
 #include "crypto.h"
 #include "cmdline.h"
@@ -203,6 +222,43 @@ static xmlSecAppCmdLineParam repeatParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam repeatWarmupParam = {
+    xmlSecAppCmdLineTopicCryptoConfig,
+    "--repeat-warmup",
+    NULL,
+    "--repeat-warmup <number>"
+    "\n\trun <number> warm-up iterations before the \"--repeat\""
+    "\n\titerations, the warm-up iterations are not included"
+    "\n\tin the statistics",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam repeatFormatParam = {
+    xmlSecAppCmdLineTopicCryptoConfig,
+    "--repeat-format",
+    NULL,
+    "--repeat-format <text|csv|json>"
+    "\n\tthe \"--repeat\" statistics format (default: text)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam repeatStatsFileParam = {
+    xmlSecAppCmdLineTopicCryptoConfig,
+    "--repeat-stats-file",
+    NULL,
+    "--repeat-stats-file <filename>"
+    "\n\twrite the \"--repeat\" statistics to <filename> instead"
+    "\n\tof stderr, the result document still goes to \"--output\""
+    "\n\tor stdout",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam base64LineSizeParam = {
     xmlSecAppCmdLineTopicCryptoConfig,
     "--base64-line-size",
@@ -213,6 +269,18 @@ static xmlSecAppCmdLineParam base64LineSizeParam = {
     xmlSecAppCmdLineParamFlagNone,
     NULL
 };
+static xmlSecAppCmdLineParam mmapThresholdParam = {
+    xmlSecAppCmdLineTopicCryptoConfig,
+    "--mmap-threshold",
+    NULL,
+    "--mmap-threshold <size>"
+    "\n\tmemory map the local files with size greater or equal"
+    "\n\tto <size> instead of reading them (0 to disable, default)",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam transformBinChunkSizeParam = {
     xmlSecAppCmdLineTopicCryptoConfig,
     "--transform-binary-chunk-size",
@@ -574,6 +642,37 @@ static xmlSecAppCmdLineParam outputParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam batchParam = {
+    xmlSecAppCmdLineTopicDSigCommon |
+    xmlSecAppCmdLineTopicEncCommon,
+    "--batch",
+    NULL,
+    "--batch <filename>"
+    "\n\tread the jobs from <filename> (\"-\" for stdin), one job per line:"
+    "\n\t\"<input-file> [<output-file>]\"; the keys are loaded once and"
+    "\n\tshared by all the jobs, the jobs without <output-file> use"
+    "\n\t\"--output\" (it should include '{inputfile}' if there is more"
+    "\n\tthan one batch thread); the empty lines and lines starting"
+    "\n\twith '#' are ignored",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam batchThreadsParam = {
+    xmlSecAppCmdLineTopicDSigCommon |
+    xmlSecAppCmdLineTopicEncCommon,
+    "--batch-threads",
+    NULL,
+    "--batch-threads <number>"
+    "\n\tprocess the command line files and the \"--batch\" jobs in"
+    "\n\t<number> worker threads (default 1) and print each job status"
+    "\n\tand the total throughput to stderr",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam nodeIdParam = {
     xmlSecAppCmdLineTopicDSigCommon |
     xmlSecAppCmdLineTopicEncCommon,
@@ -648,6 +747,32 @@ static xmlSecAppCmdLineParam printXmlDebugParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam arenaParam = {
+    xmlSecAppCmdLineTopicDSigCommon |
+    xmlSecAppCmdLineTopicEncCommon,
+    "--arena",
+    NULL,
+    "--arena"
+    "\n\tallocate the transforms and the references contexts"
+    "\n\tfrom the per-operation arena",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam traceParam = {
+    xmlSecAppCmdLineTopicDSigCommon |
+    xmlSecAppCmdLineTopicEncCommon,
+    "--trace",
+    NULL,
+    "--trace"
+    "\n\tprint the operations trace (signature, reference, encryption,"
+    "\n\tkey lookup and X509 verification spans) to stderr",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam idAttrParam = {
     xmlSecAppCmdLineTopicDSigCommon |
     xmlSecAppCmdLineTopicEncCommon,
@@ -709,6 +834,30 @@ static xmlSecAppCmdLineParam ignoreManifestsParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam prefetchUrisParam = {
+    xmlSecAppCmdLineTopicDSigCommon,
+    "--prefetch-uris",
+    NULL,
+    "--prefetch-uris"
+    "\n\tread all the external <dsig:Reference/> URIs in parallel"
+    "\n\tbefore processing the references",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam transformStatsParam = {
+    xmlSecAppCmdLineTopicDSigCommon,
+    "--transform-stats",
+    NULL,
+    "--transform-stats"
+    "\n\tcollect and print the transforms execution statistics"
+    "\n\t(time, bytes and chunks processed, buffers high-water marks)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam storeReferencesParam = {
     xmlSecAppCmdLineTopicDSigCommon,
     "--store-references",
@@ -733,6 +882,30 @@ static xmlSecAppCmdLineParam storeSignaturesParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam batchDigestsParam = {
+    xmlSecAppCmdLineTopicDSigVerify,
+    "--batch-digests",
+    NULL,
+    "--batch-digests"
+    "\n\tcalculate the digests of the small <dsig:Reference> elements"
+    "\n\ttogether after all the references are processed",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam pipelineC14NParam = {
+    xmlSecAppCmdLineTopicDSigCommon,
+    "--pipeline-c14n",
+    NULL,
+    "--pipeline-c14n"
+    "\n\tcanonicalize the <dsig:Reference> data in one thread and"
+    "\n\tdigest it in another thread",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam enabledRefUrisParam = {
     xmlSecAppCmdLineTopicDSigCommon,
     "--enabled-reference-uris",
@@ -760,6 +933,35 @@ static xmlSecAppCmdLineParam enableVisa3DHackParam = {
     NULL
 };
 
+#ifdef LIBXML_READER_ENABLED
+static xmlSecAppCmdLineParam streamDataParam = {
+    xmlSecAppCmdLineTopicDSigSign,
+    "--stream-data",
+    NULL,
+    "--stream-data <file>"
+    "\n\tsign the XML document <file> in one pass without loading it in memory;"
+    "\n\tthe template is a standalone <dsig:Signature/> element with enveloped"
+    "\n\treference inserted at the end of the document element and the output"
+    "\n\tis the canonical form of the document",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam streamVerifyParam = {
+    xmlSecAppCmdLineTopicDSigVerify,
+    "--stream-verify",
+    NULL,
+    "--stream-verify"
+    "\n\tverify the first <dsig:Signature/> element in one pass without loading"
+    "\n\tthe document in memory; the same-document references should select"
+    "\n\tthe whole document or an element by id and use only c14n transforms",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+#endif /* LIBXML_READER_ENABLED */
+
 #endif /* XMLSEC_NO_XMLDSIG */
 
 /****************************************************************
@@ -802,6 +1004,43 @@ static xmlSecAppCmdLineParam xmlDataParam = {
     xmlSecAppCmdLineParamFlagNone,
     NULL
 };
+
+static xmlSecAppCmdLineParam encRecipientParam = {
+    xmlSecAppCmdLineTopicEncEncrypt,
+    "--enc-recipient",
+    NULL,
+    "--enc-recipient <name>"
+    "\n\tencrypt the session key for the recipient key <name> using the first"
+    "\n\t<enc:EncryptedKey/> node in the template; the option can be repeated"
+    "\n\tto encrypt the data once for several recipients (requires \"--xml-data\")",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagMultipleValues,
+    NULL
+};
+
+static xmlSecAppCmdLineParam streamOutputParam = {
+    xmlSecAppCmdLineTopicEncEncrypt,
+    "--stream-output",
+    NULL,
+    "--stream-output"
+    "\n\twrite the result document to the output while the \"--binary-data\""
+    "\n\tfile is encrypted without keeping the cipher value in memory",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam decryptAllParam = {
+    xmlSecAppCmdLineTopicEncDecrypt,
+    "--decrypt-all",
+    NULL,
+    "--decrypt-all"
+    "\n\tdecrypt all the <enc:EncryptedData> elements in the document"
+    "\n\tin parallel, each shared <enc:EncryptedKey> is decrypted once",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
 #endif /* XMLSEC_NO_XMLENC */
 
 
@@ -983,10 +1222,18 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     /* common dsig params */
 #ifndef XMLSEC_NO_XMLDSIG
     &ignoreManifestsParam,
+    &prefetchUrisParam,
+    &transformStatsParam,
     &storeReferencesParam,
     &storeSignaturesParam,
+    &batchDigestsParam,
+    &pipelineC14NParam,
     &enabledRefUrisParam,
     &enableVisa3DHackParam,
+#ifdef LIBXML_READER_ENABLED
+    &streamDataParam,
+    &streamVerifyParam,
+#endif /* LIBXML_READER_ENABLED */
 
 #ifndef XMLSEC_NO_HMAC
     &hmacMinOutputLenParam,
@@ -998,14 +1245,21 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
 #ifndef XMLSEC_NO_XMLENC
     &binaryDataParam,
     &xmlDataParam,
+    &encRecipientParam,
+    &streamOutputParam,
     &enabledCipherRefUrisParam,
+    &decryptAllParam,
 #endif /* XMLSEC_NO_XMLENC */
 
     /* common dsig and enc parameters */
     &sessionKeyParam,
     &outputParam,
+    &batchParam,
+    &batchThreadsParam,
     &printDebugParam,
     &printXmlDebugParam,
+    &traceParam,
+    &arenaParam,
     &dtdFileParam,
     &nodeIdParam,
     &nodeNameParam,
@@ -1076,8 +1330,12 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &cryptoConfigParam,
     &verboseParam,
     &repeatParam,
+    &repeatWarmupParam,
+    &repeatFormatParam,
+    &repeatStatsFileParam,
     &base64LineSizeParam,
     &transformBinChunkSizeParam,
+    &mmapThresholdParam,
     &xxeParam,
     &urlMapParam,
     &helpParam,
@@ -1158,6 +1416,11 @@ static int                      xmlSecAppCheckTransform     (const char * name);
 
 static xmlSecTransformUriType   xmlSecAppGetUriType             (const char* string);
 static xmlOutputBufferPtr       xmlSecAppOpenFile               (const char* filename, const char* encoding);
+static xmlOutputBufferPtr       xmlSecAppOpenResultFile         (const char* inputFileName,
+                                                                 const char* outputFileNameTmpl,
+                                                                 const xmlChar* encoding);
+static xmlOutputBufferPtr       xmlSecAppOpenStreamedResultFile (const char* inputFileName,
+                                                                 const char* outputFileNameTmpl);
 static int                      xmlSecAppWriteResult            (const char* inputFileName,
                                                                  const char* outputFileNameTmpl,
                                                                  xmlDocPtr doc,
@@ -1175,10 +1438,23 @@ static int                      xmlSecAppInputReadCallback      (void * context,
                                                                  char * buffer,
                                                                  int len);
 static int                      xmlSecAppInputCloseCallback     (void * context);
+static void                     xmlSecAppTraceCallback          (xmlSecTraceEvent event,
+                                                                 xmlSecTraceSpanPtr span,
+                                                                 void* context);
 
 static int                      xmlSecAppExecute                (xmlSecAppCommand command,
                                                                 const char** utf8_argv,
                                                                 int argc);
+static int                      xmlSecAppBatchRun               (xmlSecAppCommand command,
+                                                                const char** utf8_argv,
+                                                                int argc);
+static double                   xmlSecAppGetTime                (void);
+static void                     xmlSecAppAddTime                (double start_time);
+static int                      xmlSecAppPrintRepeatStats       (FILE* out,
+                                                                 double* latencies,
+                                                                int iterations,
+                                                                int warmup,
+                                                                const char* format);
 
 
 #if defined(XMLSEC_WINDOWS) && defined(UNICODE) && defined(__MINGW32__)
@@ -1190,7 +1466,8 @@ int g_repeats = 1;
 int g_printDebug = 0;
 int g_printVerboseDebug = 0;
 int g_blockNetworkIO = 0;
-clock_t g_totalTime = 0;
+double g_iterationTime = 0;
+xmlMutexPtr g_iterationTimeMutex = NULL;
 const char* g_xmlSecCryptoLibrary = NULL;
 const char* gOutputFilename = NULL;
 
@@ -1277,7 +1554,7 @@ int main(int argc, const char **argv) {
         case xmlSecAppCommandVerify:
         case xmlSecAppCommandEncrypt:
         case xmlSecAppCommandDecrypt:
-            if(pos >= argc) {
+            if((pos >= argc) && !xmlSecAppCmdLineParamIsSet(&batchParam)) {
                 fprintf(stderr, "Error: <file> parameter is required for this command\n");
                 xmlSecAppPrintUsage();
                 goto done;
@@ -1330,6 +1607,11 @@ done:
 static int
 xmlSecAppExecute(xmlSecAppCommand command, const char** utf8_argv, int argc) {
     const char* tmp = NULL;
+    const char* repeatFormat = NULL;
+    double* latencies = NULL;
+    int repeats = 0;
+    int warmup = 0;
+    int iteration;
     int res = - 1;
     int ii;
 
@@ -1366,6 +1648,11 @@ xmlSecAppExecute(xmlSecAppCommand command, const char** utf8_argv, int argc) {
        xmlSecErrorsDefaultCallbackEnableOutput(0);
     }
 
+    /* enable tracing? */
+    if(xmlSecAppCmdLineParamIsSet(&traceParam)) {
+        xmlSecTraceSetCallback(xmlSecAppTraceCallback, stderr);
+    }
+
 
     /* base64 line size */
     if(xmlSecAppCmdLineParamIsSet(&base64LineSizeParam)) {
@@ -1389,6 +1676,17 @@ xmlSecAppExecute(xmlSecAppCommand command, const char** utf8_argv, int argc) {
         xmlSecTransformCtxSetDefaultBinaryChunkSize((xmlSecSize)chunkSize);
     }
 
+    /* mmap threshold */
+    if(xmlSecAppCmdLineParamIsSet(&mmapThresholdParam)) {
+        int mmapThreshold = xmlSecAppCmdLineParamGetInt(&mmapThresholdParam, 0);
+        if(mmapThreshold < 0) {
+            fprintf(stderr, "Error: mmap threshold should be greater or equal to zero\n");
+            xmlSecAppPrintUsage();
+            goto done;
+        }
+        xmlSecBufferSetMmapThreshold((xmlSecSize)mmapThreshold);
+    }
+
     /* load keys */
     if(xmlSecAppLoadKeys() < 0) {
         fprintf(stderr, "Error: keys manager creation failed\n");
@@ -1396,18 +1694,62 @@ xmlSecAppExecute(xmlSecAppCommand command, const char** utf8_argv, int argc) {
         goto done;
     }
 
-    /* get the "g_repeats" number */
+    /* get the "g_repeats" number: the warm-up iterations go first */
     if(xmlSecAppCmdLineParamIsSet(&repeatParam) &&
        (xmlSecAppCmdLineParamGetInt(&repeatParam, 1) > 0)) {
 
-        g_repeats = xmlSecAppCmdLineParamGetInt(&repeatParam, 1);
+        repeats = xmlSecAppCmdLineParamGetInt(&repeatParam, 1);
+        warmup = xmlSecAppCmdLineParamGetInt(&repeatWarmupParam, 0);
+        if((warmup < 0) || (warmup > INT_MAX - repeats)) {
+            fprintf(stderr, "Error: invalid number of warm-up iterations\n");
+            xmlSecAppPrintUsage();
+            goto done;
+        }
+        repeatFormat = xmlSecAppCmdLineParamGetString(&repeatFormatParam);
+        if((repeatFormat != NULL) && (strcmp(repeatFormat, "text") != 0) &&
+           (strcmp(repeatFormat, "csv") != 0) && (strcmp(repeatFormat, "json") != 0)) {
+            fprintf(stderr, "Error: unknown statistics format \"%s\"\n", repeatFormat);
+            xmlSecAppPrintUsage();
+            goto done;
+        }
+        latencies = (double*)xmlMalloc(sizeof(double) * (size_t)repeats);
+        if(latencies == NULL) {
+            fprintf(stderr, "Error: failed to allocate %d latencies\n", repeats);
+            goto done;
+        }
+        memset(latencies, 0, sizeof(double) * (size_t)repeats);
+        g_repeats = warmup + repeats;
     }
 
     /* get the output file */
     gOutputFilename = xmlSecAppCmdLineParamGetString(&outputParam);
 
+#ifndef XMLSEC_NO_XMLDSIG
+    /* the collected dsig stats are printed with the debug info */
+    if(xmlSecAppCmdLineParamIsSet(&transformStatsParam) ||
+       xmlSecAppCmdLineParamIsSet(&storeReferencesParam) ||
+       xmlSecAppCmdLineParamIsSet(&storeSignaturesParam)) {
+        g_printDebug = 1;
+    }
+#endif /* XMLSEC_NO_XMLDSIG */
+
+    /* batch mode: all the jobs share the keys manager */
+    if(xmlSecAppCmdLineParamIsSet(&batchParam) || xmlSecAppCmdLineParamIsSet(&batchThreadsParam)) {
+        if(xmlSecAppCmdLineParamIsSet(&repeatParam)) {
+            fprintf(stderr, "Error: \"--repeat\" option can not be used in batch mode\n");
+            xmlSecAppPrintUsage();
+            goto done;
+        }
+        if(xmlSecAppBatchRun(command, utf8_argv, argc) < 0) {
+            goto done;
+        }
+        res = 0;
+        goto done;
+    }
+
     /* execute requested number of times */
-    for(; g_repeats > 0; --g_repeats) {
+    for(iteration = 0; g_repeats > 0; --g_repeats, ++iteration) {
+        g_iterationTime = 0;
         switch(command) {
         case xmlSecAppCommandListKeyData:
             xmlSecAppListKeyData();
@@ -1502,22 +1844,49 @@ xmlSecAppExecute(xmlSecAppCommand command, const char** utf8_argv, int argc) {
             xmlSecAppPrintUsage();
             goto done;
         }
+
+        if((latencies != NULL) && (iteration >= warmup)) {
+            latencies[iteration - warmup] = g_iterationTime;
+        }
     }
 
-    /* print perf stats results */
-    if(xmlSecAppCmdLineParamIsSet(&repeatParam) &&
-       (xmlSecAppCmdLineParamGetInt(&repeatParam, 1) > 0)) {
-        long double msecs;
+    /* print perf stats results, stdout is for the result document */
+    if(latencies != NULL) {
+        const char* statsFileName = xmlSecAppCmdLineParamGetString(&repeatStatsFileParam);
+        FILE* statsFile = stderr;
+        int ret;
 
-        g_repeats = xmlSecAppCmdLineParamGetInt(&repeatParam, 1);
-        msecs = (1000 * g_totalTime) / (long double)CLOCKS_PER_SEC;
-        fprintf(stderr, "Executed %d tests in %.2Lf msec\n", g_repeats, msecs);
+        if(statsFileName != NULL) {
+#if defined(_MSC_VER)
+            statsFile = NULL;
+            fopen_s(&statsFile, statsFileName, "w");
+#else /* defined(_MSC_VER) */
+            statsFile = fopen(statsFileName, "w");
+#endif /* defined(_MSC_VER) */
+            if(statsFile == NULL) {
+                fprintf(stderr, "Error: failed to open statistics file \"%s\"\n", statsFileName);
+                goto done;
+            }
+        }
+        ret = xmlSecAppPrintRepeatStats(statsFile, latencies, repeats, warmup, repeatFormat);
+        if(statsFile != stderr) {
+            if(fclose(statsFile) != 0) {
+                fprintf(stderr, "Error: failed to write statistics file \"%s\"\n", statsFileName);
+                ret = -1;
+            }
+        }
+        if(ret < 0) {
+            goto done;
+        }
     }
 
     /* success! */
     res = 0;
 
 done:
+    if(latencies != NULL) {
+        xmlFree(latencies);
+    }
     if(g_keysManager != NULL) {
         xmlSecKeysMngrDestroy(g_keysManager);
         g_keysManager = NULL;
@@ -1526,12 +1895,533 @@ done:
     return(res);
 }
 
+/****************************************************************
+ *
+ * Performance statistics: the operations time is measured with
+ * the monotonic clock and added to the current iteration time
+ *
+ ***************************************************************/
+static double
+xmlSecAppGetTime(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER counter;
+
+    if(freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&counter);
+    return((double)counter.QuadPart / (double)freq.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0);
+#else  /* defined(_WIN32) */
+    return((double)time(NULL));
+#endif /* defined(_WIN32) */
+}
+
+static void
+xmlSecAppAddTime(double start_time) {
+    double delta = xmlSecAppGetTime() - start_time;
+
+    if(g_iterationTimeMutex != NULL) {
+        xmlMutexLock(g_iterationTimeMutex);
+        g_iterationTime += delta;
+        xmlMutexUnlock(g_iterationTimeMutex);
+    } else {
+        g_iterationTime += delta;
+    }
+}
+
+static int
+xmlSecAppCompareDouble(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+
+    return((da < db) ? -1 : ((da > db) ? 1 : 0));
+}
+
+static double
+xmlSecAppPercentile(const double* sorted, int size, int percent) {
+    int pos;
+
+    if(size <= 0) {
+        return(0);
+    }
+    /* nearest rank */
+    pos = (int)(((long)size * percent + 99) / 100);
+    return(sorted[(pos > 0) ? (pos - 1) : 0]);
+}
+
+static int
+xmlSecAppPrintRepeatStats(FILE* out, double* latencies, int iterations, int warmup, const char* format) {
+    double total = 0;
+    double mean, p50, p99, opsPerSec;
+    int ii;
+
+    if((out == NULL) || (latencies == NULL) || (iterations <= 0)) {
+        fprintf(stderr, "Error: no iterations to report\n");
+        return(-1);
+    }
+
+    for(ii = 0; ii < iterations; ++ii) {
+        total += latencies[ii];
+    }
+    qsort(latencies, (size_t)iterations, sizeof(double), xmlSecAppCompareDouble);
+    mean = total / (double)iterations;
+    p50 = xmlSecAppPercentile(latencies, iterations, 50);
+    p99 = xmlSecAppPercentile(latencies, iterations, 99);
+    opsPerSec = (total > 0) ? ((double)iterations / total) : 0.0;
+
+    if((format != NULL) && (strcmp(format, "csv") == 0)) {
+        fprintf(out, "iterations,warmup,total_msec,min_msec,mean_msec,p50_msec,p99_msec,max_msec,ops_per_sec\n");
+        fprintf(out, "%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f\n",
+            iterations, warmup, 1000 * total, 1000 * latencies[0], 1000 * mean,
+            1000 * p50, 1000 * p99, 1000 * latencies[iterations - 1], opsPerSec);
+    } else if((format != NULL) && (strcmp(format, "json") == 0)) {
+        fprintf(out, "{\n");
+        fprintf(out, "  \"iterations\": %d,\n", iterations);
+        fprintf(out, "  \"warmup\": %d,\n", warmup);
+        fprintf(out, "  \"total_msec\": %.3f,\n", 1000 * total);
+        fprintf(out, "  \"latency_min_msec\": %.3f,\n", 1000 * latencies[0]);
+        fprintf(out, "  \"latency_mean_msec\": %.3f,\n", 1000 * mean);
+        fprintf(out, "  \"latency_p50_msec\": %.3f,\n", 1000 * p50);
+        fprintf(out, "  \"latency_p99_msec\": %.3f,\n", 1000 * p99);
+        fprintf(out, "  \"latency_max_msec\": %.3f,\n", 1000 * latencies[iterations - 1]);
+        fprintf(out, "  \"ops_per_sec\": %.2f\n", opsPerSec);
+        fprintf(out, "}\n");
+    } else {
+        fprintf(out, "Executed %d tests in %.2f msec", iterations, 1000 * total);
+        if(warmup > 0) {
+            fprintf(out, " (after %d warm-up tests)", warmup);
+        }
+        fprintf(out, "\n");
+        fprintf(out, "Latency (msec): min=%.3f mean=%.3f p50=%.3f p99=%.3f max=%.3f\n",
+            1000 * latencies[0], 1000 * mean, 1000 * p50, 1000 * p99, 1000 * latencies[iterations - 1]);
+        fprintf(out, "Throughput: %.2f ops/sec\n", opsPerSec);
+    }
+    return(0);
+}
+
+#define XMLSEC_OUTPUT_TMPL_PARAM  "{inputfile}"
+
+/****************************************************************
+ *
+ * Batch mode: the jobs are processed by the worker threads that
+ * share the keys manager loaded once in xmlSecAppExecute()
+ *
+ ***************************************************************/
+#define XMLSEC_APP_BATCH_MAX_THREADS            256
+#define XMLSEC_APP_BATCH_MAX_LINE_SIZE          4096
+
+typedef struct _xmlSecAppBatchJob {
+    char*                       inputFileName;
+    char*                       outputFileName;     /* NULL to use "--output" */
+} xmlSecAppBatchJob, *xmlSecAppBatchJobPtr;
+
+typedef struct _xmlSecAppBatch {
+    xmlSecAppCommand            command;
+    xmlSecAppBatchJobPtr        jobs;
+    int                         jobsNum;
+    int                         jobsMax;
+    int                         next;               /* protected by the mutex */
+    int                         failed;             /* protected by the mutex */
+    xmlMutexPtr                 mutex;
+} xmlSecAppBatch, *xmlSecAppBatchPtr;
+
+typedef struct _xmlSecAppBatchWorker {
+    xmlSecAppBatchPtr           batch;
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    HANDLE                      handle;
+#else  /* defined(_WIN32) */
+    pthread_t                   handle;
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+} xmlSecAppBatchWorker, *xmlSecAppBatchWorkerPtr;
+
+static int
+xmlSecAppBatchAddJob(xmlSecAppBatchPtr batch, const char* inputFileName, const char* outputFileName) {
+    xmlSecAppBatchJobPtr job;
+
+    if((batch == NULL) || (inputFileName == NULL)) {
+        return(-1);
+    }
+
+    if(batch->jobsNum >= batch->jobsMax) {
+        xmlSecAppBatchJobPtr newJobs;
+        int newMax = (batch->jobsMax > 0) ? 2 * batch->jobsMax : 64;
+
+        newJobs = (xmlSecAppBatchJobPtr)xmlRealloc(batch->jobs, sizeof(xmlSecAppBatchJob) * (size_t)newMax);
+        if(newJobs == NULL) {
+            fprintf(stderr, "Error: failed to allocate %d batch jobs\n", newMax);
+            return(-1);
+        }
+        batch->jobs = newJobs;
+        batch->jobsMax = newMax;
+    }
+
+    job = &(batch->jobs[batch->jobsNum]);
+    memset(job, 0, sizeof(xmlSecAppBatchJob));
+    job->inputFileName = (char*)xmlStrdup(BAD_CAST inputFileName);
+    if(job->inputFileName == NULL) {
+        fprintf(stderr, "Error: failed to duplicate filename \"%s\"\n", inputFileName);
+        return(-1);
+    }
+    if(outputFileName != NULL) {
+        job->outputFileName = (char*)xmlStrdup(BAD_CAST outputFileName);
+        if(job->outputFileName == NULL) {
+            fprintf(stderr, "Error: failed to duplicate filename \"%s\"\n", outputFileName);
+            xmlFree(job->inputFileName);
+            return(-1);
+        }
+    }
+    ++batch->jobsNum;
+    return(0);
+}
+
+static char*
+xmlSecAppBatchNextToken(char** str) {
+    char* res;
+    char* cur;
+
+    cur = (*str);
+    while(((*cur) == ' ') || ((*cur) == '\t')) {
+        ++cur;
+    }
+    if((*cur) == '\0') {
+        (*str) = cur;
+        return(NULL);
+    }
+    res = cur;
+    while(((*cur) != '\0') && ((*cur) != ' ') && ((*cur) != '\t')) {
+        ++cur;
+    }
+    if((*cur) != '\0') {
+        (*cur) = '\0';
+        ++cur;
+    }
+    (*str) = cur;
+    return(res);
+}
+
+static int
+xmlSecAppBatchReadJobs(xmlSecAppBatchPtr batch, const char* filename) {
+    char line[XMLSEC_APP_BATCH_MAX_LINE_SIZE];
+    char* cur;
+    char* inputFileName;
+    char* outputFileName;
+    size_t len;
+    FILE* f;
+    int lineNo = 0;
+    int res = -1;
+
+    if((batch == NULL) || (filename == NULL)) {
+        return(-1);
+    }
+
+    if(strcmp(filename, "-") == 0) {
+        f = stdin;
+    } else {
+#if defined(_MSC_VER)
+        f = NULL;
+        fopen_s(&f, filename, "r");
+#else /* defined(_MSC_VER) */
+        f = fopen(filename, "r");
+#endif /* defined(_MSC_VER) */
+        if(f == NULL) {
+            fprintf(stderr, "Error: failed to open batch file \"%s\"\n", filename);
+            return(-1);
+        }
+    }
+
+    while(fgets(line, sizeof(line), f) != NULL) {
+        ++lineNo;
+
+        len = strlen(line);
+        if((len > 0) && (line[len - 1] != '\n') && !feof(f)) {
+            fprintf(stderr, "Error: line %d in the batch file \"%s\" is too long\n", lineNo, filename);
+            goto done;
+        }
+        while((len > 0) && ((line[len - 1] == '\n') || (line[len - 1] == '\r'))) {
+            line[--len] = '\0';
+        }
+
+        cur = line;
+        inputFileName = xmlSecAppBatchNextToken(&cur);
+        if((inputFileName == NULL) || (inputFileName[0] == '#')) {
+            continue;
+        }
+        outputFileName = xmlSecAppBatchNextToken(&cur);
+        if(xmlSecAppBatchNextToken(&cur) != NULL) {
+            fprintf(stderr, "Error: line %d in the batch file \"%s\" has more than two filenames\n", lineNo, filename);
+            goto done;
+        }
+        if(xmlSecAppBatchAddJob(batch, inputFileName, outputFileName) < 0) {
+            goto done;
+        }
+    }
+    if(ferror(f)) {
+        fprintf(stderr, "Error: failed to read batch file \"%s\"\n", filename);
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(f != stdin) {
+        fclose(f);
+    }
+    return(res);
+}
+
+static int
+xmlSecAppBatchRunJob(xmlSecAppCommand command, xmlSecAppBatchJobPtr job) {
+    const char* outputFileName;
+
+    if(job == NULL) {
+        return(-1);
+    }
+    outputFileName = (job->outputFileName != NULL) ? job->outputFileName : gOutputFilename;
+
+    switch(command) {
+#ifndef XMLSEC_NO_XMLDSIG
+    case xmlSecAppCommandSign:
+        return(xmlSecAppSignFile(job->inputFileName, outputFileName));
+    case xmlSecAppCommandVerify:
+        return(xmlSecAppVerifyFile(job->inputFileName));
+#endif /* XMLSEC_NO_XMLDSIG */
+#ifndef XMLSEC_NO_XMLENC
+    case xmlSecAppCommandEncrypt:
+        return(xmlSecAppEncryptFile(job->inputFileName, outputFileName));
+    case xmlSecAppCommandDecrypt:
+        return(xmlSecAppDecryptFile(job->inputFileName, outputFileName));
+#endif /* XMLSEC_NO_XMLENC */
+    default:
+        fprintf(stderr, "Error: command %d is not supported in batch mode\n", (int)command);
+        return(-1);
+    }
+}
+
+static void
+xmlSecAppBatchWorkerRun(xmlSecAppBatchWorkerPtr worker) {
+    xmlSecAppBatchPtr batch = worker->batch;
+    int ii;
+    int ret;
+
+    while(1) {
+        xmlMutexLock(batch->mutex);
+        ii = (batch->next)++;
+        xmlMutexUnlock(batch->mutex);
+        if(ii >= batch->jobsNum) {
+            break;
+        }
+
+        ret = xmlSecAppBatchRunJob(batch->command, &(batch->jobs[ii]));
+
+        xmlMutexLock(batch->mutex);
+        if(ret < 0) {
+            ++(batch->failed);
+        }
+        fprintf(stderr, "Job %d: %s \"%s\"\n", ii + 1,
+            (ret < 0) ? "FAILED" : "OK", batch->jobs[ii].inputFileName);
+        fflush(stderr);
+        xmlMutexUnlock(batch->mutex);
+    }
+}
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+static unsigned __stdcall
+xmlSecAppBatchWorkerMain(void* arg) {
+    xmlSecAppBatchWorkerRun((xmlSecAppBatchWorkerPtr)arg);
+    return(0);
+}
+
+static int
+xmlSecAppBatchWorkerStart(xmlSecAppBatchWorkerPtr worker) {
+    worker->handle = (HANDLE)_beginthreadex(NULL, 0, xmlSecAppBatchWorkerMain, worker, 0, NULL);
+    return((worker->handle != 0) ? 0 : -1);
+}
+
+static void
+xmlSecAppBatchWorkerJoin(xmlSecAppBatchWorkerPtr worker) {
+    WaitForSingleObject(worker->handle, INFINITE);
+    CloseHandle(worker->handle);
+}
+#else  /* defined(_WIN32) */
+static void*
+xmlSecAppBatchWorkerMain(void* arg) {
+    xmlSecAppBatchWorkerRun((xmlSecAppBatchWorkerPtr)arg);
+    return(NULL);
+}
+
+static int
+xmlSecAppBatchWorkerStart(xmlSecAppBatchWorkerPtr worker) {
+    return((pthread_create(&(worker->handle), NULL, xmlSecAppBatchWorkerMain, worker) == 0) ? 0 : -1);
+}
+
+static void
+xmlSecAppBatchWorkerJoin(xmlSecAppBatchWorkerPtr worker) {
+    pthread_join(worker->handle, NULL);
+}
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+static int
+xmlSecAppBatchRun(xmlSecAppCommand command, const char** utf8_argv, int argc) {
+    xmlSecAppBatch batch;
+    xmlSecAppBatchWorkerPtr workers = NULL;
+    const char* batchFileName;
+    int threadsNum = 1;
+    int started = 0;
+    double start_time, secs;
+    int ii;
+    int res = -1;
+
+    memset(&batch, 0, sizeof(batch));
+    batch.command = command;
+
+    switch(command) {
+    case xmlSecAppCommandSign:
+    case xmlSecAppCommandVerify:
+    case xmlSecAppCommandEncrypt:
+    case xmlSecAppCommandDecrypt:
+        break;
+    default:
+        fprintf(stderr, "Error: batch mode is not supported for this command\n");
+        xmlSecAppPrintUsage();
+        return(-1);
+    }
+
+    if(xmlSecAppCmdLineParamIsSet(&batchThreadsParam)) {
+        threadsNum = xmlSecAppCmdLineParamGetInt(&batchThreadsParam, 1);
+        if((threadsNum <= 0) || (threadsNum > XMLSEC_APP_BATCH_MAX_THREADS)) {
+            fprintf(stderr, "Error: batch threads number should be between 1 and %d\n", XMLSEC_APP_BATCH_MAX_THREADS);
+            xmlSecAppPrintUsage();
+            return(-1);
+        }
+#if defined(XMLSEC_NO_THREADS)
+        if(threadsNum > 1) {
+            fprintf(stderr, "Warning: threads support is disabled, the batch jobs are processed sequentially\n");
+            threadsNum = 1;
+        }
+#endif /* defined(XMLSEC_NO_THREADS) */
+    }
+    if((threadsNum > 1) && xmlSecAppCmdLineParamIsSet(&traceParam)) {
+        fprintf(stderr, "Error: \"--trace\" option can not be used with more than one batch thread\n");
+        xmlSecAppPrintUsage();
+        return(-1);
+    }
+
+    /* the command line files go first */
+    for(ii = 0; ii < argc; ++ii) {
+        if(xmlSecAppBatchAddJob(&batch, utf8_argv[ii], NULL) < 0) {
+            goto done;
+        }
+    }
+    batchFileName = xmlSecAppCmdLineParamGetString(&batchParam);
+    if((batchFileName != NULL) && (xmlSecAppBatchReadJobs(&batch, batchFileName) < 0)) {
+        goto done;
+    }
+    if(threadsNum > batch.jobsNum) {
+        threadsNum = (batch.jobsNum > 0) ? batch.jobsNum : 1;
+    }
+
+    /* the parallel jobs can't share the output: the documents would be interleaved */
+    if((threadsNum > 1) && (command != xmlSecAppCommandVerify)) {
+        for(ii = 0; ii < batch.jobsNum; ++ii) {
+            if((batch.jobs[ii].outputFileName == NULL) &&
+               ((gOutputFilename == NULL) || (strstr(gOutputFilename, XMLSEC_OUTPUT_TMPL_PARAM) == NULL))) {
+                fprintf(stderr, "Error: job %d \"%s\" has no output file, with more than one batch thread"
+                    " each job needs <output-file> or \"--output\" with '" XMLSEC_OUTPUT_TMPL_PARAM "'\n",
+                    ii + 1, batch.jobs[ii].inputFileName);
+                xmlSecAppPrintUsage();
+                goto done;
+            }
+        }
+    }
+
+    batch.mutex = xmlNewMutex();
+    g_iterationTimeMutex = xmlNewMutex();
+    if((batch.mutex == NULL) || (g_iterationTimeMutex == NULL)) {
+        fprintf(stderr, "Error: failed to create mutex\n");
+        goto done;
+    }
+    workers = (xmlSecAppBatchWorkerPtr)xmlMalloc(sizeof(xmlSecAppBatchWorker) * (size_t)threadsNum);
+    if(workers == NULL) {
+        fprintf(stderr, "Error: failed to allocate %d batch workers\n", threadsNum);
+        goto done;
+    }
+    memset(workers, 0, sizeof(xmlSecAppBatchWorker) * (size_t)threadsNum);
+
+    start_time = xmlSecAppGetTime();
+#if !defined(XMLSEC_NO_THREADS)
+    if(threadsNum > 1) {
+        for(started = 0; started < threadsNum; ++started) {
+            workers[started].batch = &batch;
+            if(xmlSecAppBatchWorkerStart(&(workers[started])) < 0) {
+                fprintf(stderr, "Error: failed to start batch worker %d\n", started);
+                break;
+            }
+        }
+        for(ii = 0; ii < started; ++ii) {
+            xmlSecAppBatchWorkerJoin(&(workers[ii]));
+        }
+    } else
+#endif /* !defined(XMLSEC_NO_THREADS) */
+    {
+        workers[0].batch = &batch;
+        xmlSecAppBatchWorkerRun(&(workers[0]));
+        started = 1;
+    }
+    secs = xmlSecAppGetTime() - start_time;
+
+    fprintf(stderr, "Batch: %d jobs (%d failed) in %d threads, %.3f sec, %.2f jobs/sec\n",
+        batch.jobsNum, batch.failed, started, secs,
+        (secs > 0) ? ((double)batch.jobsNum / secs) : 0.0);
+
+    /* the jobs that were not picked up by any worker failed too */
+    if((batch.failed > 0) || (batch.next < batch.jobsNum)) {
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(workers != NULL) {
+        xmlFree(workers);
+    }
+    if(g_iterationTimeMutex != NULL) {
+        xmlFreeMutex(g_iterationTimeMutex);
+        g_iterationTimeMutex = NULL;
+    }
+    if(batch.mutex != NULL) {
+        xmlFreeMutex(batch.mutex);
+    }
+    for(ii = 0; ii < batch.jobsNum; ++ii) {
+        xmlFree(batch.jobs[ii].inputFileName);
+        if(batch.jobs[ii].outputFileName != NULL) {
+            xmlFree(batch.jobs[ii].outputFileName);
+        }
+    }
+    if(batch.jobs != NULL) {
+        xmlFree(batch.jobs);
+    }
+    return(res);
+}
+
 #ifndef XMLSEC_NO_XMLDSIG
 static int
 xmlSecAppSignFile(const char* inputFileName, const char* outputFileNameTmpl) {
     xmlSecAppXmlDataPtr data = NULL;
     xmlSecDSigCtx dsigCtx;
-    clock_t start_time;
+    double start_time;
+    int streamed = 0;
     int res = -1;
 
     if(inputFileName == NULL) {
@@ -1558,19 +2448,57 @@ xmlSecAppSignFile(const char* inputFileName, const char* outputFileNameTmpl) {
 
 
     /* sign */
-    start_time = clock();
-    if(xmlSecDSigCtxSign(&dsigCtx, data->startNode) < 0) {
-        /* caller will print the error */
-        goto done;
+#ifdef LIBXML_READER_ENABLED
+    if(xmlSecAppCmdLineParamGetString(&streamDataParam) != NULL) {
+        const char* streamFileName = xmlSecAppCmdLineParamGetString(&streamDataParam);
+        xmlTextReaderPtr reader;
+        xmlOutputBufferPtr outBuffer;
+        int ret;
+
+        /* the same options as for the tree parser */
+        reader = xmlReaderForFile(streamFileName, NULL,
+            xmlSecParserGetDefaultOptions() | XML_PARSE_NOENT | XML_PARSE_DTDLOAD | XML_PARSE_DTDATTR);
+        if(reader == NULL) {
+            fprintf(stderr, "Error: failed to open xml file \"%s\"\n", streamFileName);
+            goto done;
+        }
+
+        /* the canonical document is UTF-8, no encoder */
+        outBuffer = xmlSecAppOpenStreamedResultFile(inputFileName, outputFileNameTmpl);
+        if(outBuffer == NULL) {
+            xmlFreeTextReader(reader);
+            goto done;
+        }
+        start_time = xmlSecAppGetTime();
+        ret = xmlSecDSigCtxSignReader(&dsigCtx, data->startNode, reader, outBuffer);
+        xmlSecAppAddTime(start_time);
+        if(xmlOutputBufferClose(outBuffer) < 0) {
+            ret = -1;
+        }
+        xmlFreeTextReader(reader);
+        if(ret < 0) {
+            fprintf(stderr, "Error: failed to sign xml file \"%s\"\n", streamFileName);
+            goto done;
+        }
+        streamed = 1;
+    } else
+#endif /* LIBXML_READER_ENABLED */
+    {
+        start_time = xmlSecAppGetTime();
+        if(xmlSecDSigCtxSign(&dsigCtx, data->startNode) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+        xmlSecAppAddTime(start_time);
     }
-    g_totalTime += clock() - start_time;
 
     /* return an error if siganture failed */
     if(dsigCtx.status != xmlSecDSigStatusSucceeded) {
         goto done;
     }
 
-    if(g_repeats <= 1) {
+    /* print out result only once per execution (unless it was already streamed) */
+    if((g_repeats <= 1) && (streamed == 0)) {
         int ret;
 
         ret = xmlSecAppWriteResult(inputFileName, outputFileNameTmpl, data->doc, NULL, data->doc->encoding);
@@ -1603,7 +2531,7 @@ static int
 xmlSecAppVerifyFile(const char* inputFileName) {
     xmlSecAppXmlDataPtr data = NULL;
     xmlSecDSigCtx dsigCtx;
-    clock_t start_time;
+    double start_time;
     int res = -1;
 
     if(inputFileName == NULL) {
@@ -1620,20 +2548,45 @@ xmlSecAppVerifyFile(const char* inputFileName) {
         goto done;
     }
 
-    /* parse template and select start node */
-    data = xmlSecAppXmlDataCreate(inputFileName, xmlSecNodeSignature, xmlSecDSigNs);
-    if(data == NULL) {
-        fprintf(stderr, "Error: failed to load document \"%s\"\n", inputFileName);
-        goto done;
-    }
+#ifdef LIBXML_READER_ENABLED
+    if(xmlSecAppCmdLineParamIsSet(&streamVerifyParam)) {
+        xmlTextReaderPtr reader;
+        int ret;
 
-    /* sign */
-    start_time = clock();
-    if(xmlSecDSigCtxVerify(&dsigCtx, data->startNode) < 0) {
-        /* caller will print the error */
-        goto done;
+        /* the same options as for the tree parser */
+        reader = xmlReaderForFile(inputFileName, NULL,
+            xmlSecParserGetDefaultOptions() | XML_PARSE_NOENT | XML_PARSE_DTDLOAD | XML_PARSE_DTDATTR);
+        if(reader == NULL) {
+            fprintf(stderr, "Error: failed to open xml file \"%s\"\n", inputFileName);
+            goto done;
+        }
+
+        start_time = xmlSecAppGetTime();
+        ret = xmlSecDSigCtxVerifyReader(&dsigCtx, reader);
+        xmlSecAppAddTime(start_time);
+        xmlFreeTextReader(reader);
+        if(ret < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+    } else
+#endif /* LIBXML_READER_ENABLED */
+    {
+        /* parse template and select start node */
+        data = xmlSecAppXmlDataCreate(inputFileName, xmlSecNodeSignature, xmlSecDSigNs);
+        if(data == NULL) {
+            fprintf(stderr, "Error: failed to load document \"%s\"\n", inputFileName);
+            goto done;
+        }
+
+        /* verify */
+        start_time = xmlSecAppGetTime();
+        if(xmlSecDSigCtxVerify(&dsigCtx, data->startNode) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+        xmlSecAppAddTime(start_time);
     }
-    g_totalTime += clock() - start_time;
 
     /* return an error if verification failed */
     if(dsigCtx.status != xmlSecDSigStatusSucceeded) {
@@ -1698,7 +2651,7 @@ xmlSecAppSignTmpl(const char* outputFileNameTmpl) {
     xmlDocPtr doc = NULL;
     xmlNodePtr cur;
     xmlSecDSigCtx dsigCtx;
-    clock_t start_time;
+    double start_time;
     int res = -1;
 
     if(xmlSecDSigCtxInitialize(&dsigCtx, g_keysManager) < 0) {
@@ -1776,12 +2729,12 @@ xmlSecAppSignTmpl(const char* outputFileNameTmpl) {
     }
 
     /* sign */
-    start_time = clock();
+    start_time = xmlSecAppGetTime();
     if(xmlSecDSigCtxSign(&dsigCtx, xmlDocGetRootElement(doc)) < 0) {
         /* caller will print the error */
         goto done;
     }
-    g_totalTime += clock() - start_time;
+    xmlSecAppAddTime(start_time);
 
     /* return an error if siganture failed */
     if(dsigCtx.status != xmlSecDSigStatusSucceeded) {
@@ -1849,18 +2802,31 @@ xmlSecAppPrepareDSigCtx(xmlSecDSigCtxPtr dsigCtx) {
     if(xmlSecAppCmdLineParamIsSet(&ignoreManifestsParam)) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_IGNORE_MANIFESTS;
     }
+    if(xmlSecAppCmdLineParamIsSet(&prefetchUrisParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_PREFETCH_URIS;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&transformStatsParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_COLLECT_TRANSFORM_STATS;
+    }
     if(xmlSecAppCmdLineParamIsSet(&storeReferencesParam)) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_STORE_SIGNEDINFO_REFERENCES |
                           XMLSEC_DSIG_FLAGS_STORE_MANIFEST_REFERENCES;
-        g_printDebug = 1;
     }
     if(xmlSecAppCmdLineParamIsSet(&storeSignaturesParam)) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_STORE_SIGNATURE;
-        g_printDebug = 1;
     }
     if(xmlSecAppCmdLineParamIsSet(&enableVisa3DHackParam)) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK;
     }
+    if(xmlSecAppCmdLineParamIsSet(&arenaParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_USE_ARENA;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&batchDigestsParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_BATCH_DIGESTS;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&pipelineC14NParam)) {
+        dsigCtx->flags |= XMLSEC_DSIG_FLAGS_PIPELINE_C14N;
+    }
 
 #ifndef XMLSEC_NO_HMAC
     if(xmlSecAppCmdLineParamIsSet(&hmacMinOutputLenParam)) {
@@ -1909,7 +2875,12 @@ xmlSecAppEncryptFile(const char* inputFileName, const char* outputFileNameTmpl)
     xmlSecEncCtx encCtx;
     xmlDocPtr doc = NULL;
     xmlNodePtr startTmplNode;
-    clock_t start_time;
+    const xmlChar** recipients = NULL;
+    xmlSecSize recipientsSize = 0;
+    xmlSecAppCmdLineValuePtr value;
+    double start_time;
+    int streamed = 0;
+    int ret;
     int res = -1;
 
     if(inputFileName == NULL) {
@@ -1940,15 +2911,62 @@ xmlSecAppEncryptFile(const char* inputFileName, const char* outputFileNameTmpl)
         goto done;
     }
 
+    /* collect recipients */
+    for(value = encRecipientParam.value; value != NULL; value = value->next) {
+        ++recipientsSize;
+    }
+    if(recipientsSize > 0) {
+        xmlSecSize ii = 0;
+
+        recipients = (const xmlChar**)xmlMalloc(recipientsSize * sizeof(const xmlChar*));
+        if(recipients == NULL) {
+            fprintf(stderr, "Error: failed to allocate recipients list\n");
+            goto done;
+        }
+        for(value = encRecipientParam.value; value != NULL; value = value->next) {
+            recipients[ii++] = BAD_CAST value->strValue;
+        }
+    }
+
     if(xmlSecAppCmdLineParamGetString(&binaryDataParam) != NULL) {
-        /* encrypt */
-        start_time = clock();
-        if(xmlSecEncCtxUriEncrypt(&encCtx, startTmplNode, BAD_CAST xmlSecAppCmdLineParamGetString(&binaryDataParam)) < 0) {
-            fprintf(stderr, "Error: failed to encrypt file \"%s\"\n",
-                    xmlSecAppCmdLineParamGetString(&binaryDataParam));
+        if(recipients != NULL) {
+            fprintf(stderr, "Error: \"--enc-recipient\" option requires \"--xml-data\" option\n");
             goto done;
         }
-        g_totalTime += clock() - start_time;
+
+        /* encrypt */
+        if(xmlSecAppCmdLineParamIsSet(&streamOutputParam)) {
+            xmlOutputBufferPtr outBuffer;
+
+            /* the document is written in its own encoding, no encoder */
+            outBuffer = xmlSecAppOpenStreamedResultFile(inputFileName, outputFileNameTmpl);
+            if(outBuffer == NULL) {
+                goto done;
+            }
+            start_time = xmlSecAppGetTime();
+            ret = xmlSecEncCtxUriEncryptToOutput(&encCtx, startTmplNode, BAD_CAST xmlSecAppCmdLineParamGetString(&binaryDataParam), outBuffer);
+            xmlSecAppAddTime(start_time);
+            if(xmlOutputBufferClose(outBuffer) < 0) {
+                ret = -1;
+            }
+            if(ret < 0) {
+                fprintf(stderr, "Error: failed to encrypt file \"%s\"\n",
+                        xmlSecAppCmdLineParamGetString(&binaryDataParam));
+                goto done;
+            }
+            streamed = 1;
+        } else {
+            start_time = xmlSecAppGetTime();
+            if(xmlSecEncCtxUriEncrypt(&encCtx, startTmplNode, BAD_CAST xmlSecAppCmdLineParamGetString(&binaryDataParam)) < 0) {
+                fprintf(stderr, "Error: failed to encrypt file \"%s\"\n",
+                        xmlSecAppCmdLineParamGetString(&binaryDataParam));
+                goto done;
+            }
+            xmlSecAppAddTime(start_time);
+        }
+    } else if(xmlSecAppCmdLineParamIsSet(&streamOutputParam)) {
+        fprintf(stderr, "Error: \"--stream-output\" option requires \"--binary-data\" option\n");
+        goto done;
     } else if(xmlSecAppCmdLineParamGetString(&xmlDataParam) != NULL) {
         /* parse file and select node for encryption */
         data = xmlSecAppXmlDataCreate(xmlSecAppCmdLineParamGetString(&xmlDataParam), NULL, NULL);
@@ -1959,20 +2977,26 @@ xmlSecAppEncryptFile(const char* inputFileName, const char* outputFileNameTmpl)
         }
 
         /* encrypt */
-        start_time = clock();
-        if(xmlSecEncCtxXmlEncrypt(&encCtx, startTmplNode, data->startNode) < 0) {
+        start_time = xmlSecAppGetTime();
+        if(recipients != NULL) {
+            ret = xmlSecEncCtxXmlEncryptRecipients(&encCtx, startTmplNode,
+                recipients, recipientsSize, data->startNode);
+        } else {
+            ret = xmlSecEncCtxXmlEncrypt(&encCtx, startTmplNode, data->startNode);
+        }
+        if(ret < 0) {
             fprintf(stderr, "Error: failed to encrypt xml file \"%s\"\n",
                     xmlSecAppCmdLineParamGetString(&xmlDataParam));
             goto done;
         }
-        g_totalTime += clock() - start_time;
+        xmlSecAppAddTime(start_time);
     } else {
         fprintf(stderr, "Error: encryption data not specified (use \"--xml-data\" or \"--binary-data\" options)\n");
         goto done;
     }
 
-    /* print out result only once per execution */
-    if(g_repeats <= 1) {
+    /* print out result only once per execution (unless it was already streamed) */
+    if((g_repeats <= 1) && (streamed == 0)) {
         if(encCtx.resultReplaced) {
             if(xmlSecAppWriteResult(inputFileName, outputFileNameTmpl, (data != NULL) ? data->doc : doc, NULL, (data != NULL) ? data->doc->encoding : doc->encoding) < 0) {
                 goto done;
@@ -1999,6 +3023,9 @@ done:
     if(data != NULL) {
         xmlSecAppXmlDataDestroy(data);
     }
+    if(recipients != NULL) {
+        xmlFree(recipients);
+    }
     if(doc != NULL) {
         xmlFreeDoc(doc);
     }
@@ -2009,7 +3036,7 @@ static int
 xmlSecAppDecryptFile(const char* inputFileName, const char* outputFileNameTmpl) {
     xmlSecAppXmlDataPtr data = NULL;
     xmlSecEncCtx encCtx;
-    clock_t start_time;
+    double start_time;
     int res = -1;
 
     if(inputFileName == NULL) {
@@ -2033,16 +3060,21 @@ xmlSecAppDecryptFile(const char* inputFileName, const char* outputFileNameTmpl)
         goto done;
     }
 
-    start_time = clock();
-    if(xmlSecEncCtxDecrypt(&encCtx, data->startNode) < 0) {
+    start_time = xmlSecAppGetTime();
+    if(xmlSecAppCmdLineParamIsSet(&decryptAllParam)) {
+        if(xmlSecEncCtxDecryptAll(&encCtx, xmlDocGetRootElement(data->doc), 0) < 0) {
+            fprintf(stderr, "Error: failed to decrypt file\n");
+            goto done;
+        }
+    } else if(xmlSecEncCtxDecrypt(&encCtx, data->startNode) < 0) {
         fprintf(stderr, "Error: failed to decrypt file\n");
         goto done;
     }
-    g_totalTime += clock() - start_time;
+    xmlSecAppAddTime(start_time);
 
     /* print out result only once per execution */
     if(g_repeats <= 1) {
-        if(encCtx.resultReplaced) {
+        if(encCtx.resultReplaced || xmlSecAppCmdLineParamIsSet(&decryptAllParam)) {
             if(xmlSecAppWriteResult(inputFileName, outputFileNameTmpl, data->doc, NULL, data->doc->encoding) < 0) {
                 goto done;
             }
@@ -2078,7 +3110,7 @@ xmlSecAppEncryptTmpl(const char* outputFileNameTmpl) {
     xmlSecEncCtx encCtx;
     xmlDocPtr doc = NULL;
     xmlNodePtr cur;
-    clock_t start_time;
+    double start_time;
     int res = -1;
 
     if(xmlSecEncCtxInitialize(&encCtx, g_keysManager) < 0) {
@@ -2122,13 +3154,13 @@ xmlSecAppEncryptTmpl(const char* outputFileNameTmpl) {
     }
 
     /* encrypt */
-    start_time = clock();
+    start_time = xmlSecAppGetTime();
     if(xmlSecEncCtxBinaryEncrypt(&encCtx, xmlDocGetRootElement(doc),
                                 (const xmlSecByte*)data, xmlSecStrlen(data)) < 0) {
         fprintf(stderr, "Error: failed to encrypt data\n");
         goto done;
     }
-    g_totalTime += clock() - start_time;
+    xmlSecAppAddTime(start_time);
 
     /* print out result only once per execution */
     if(g_repeats <= 1) {
@@ -2178,6 +3210,10 @@ xmlSecAppPrepareEncCtx(xmlSecEncCtxPtr encCtx) {
         return(-1);
     }
 
+    if(xmlSecAppCmdLineParamIsSet(&arenaParam)) {
+        encCtx->flags |= XMLSEC_ENC_USE_ARENA;
+    }
+
     if(xmlSecAppCmdLineParamGetString(&sessionKeyParam) != NULL) {
         encCtx->encKey = xmlSecAppCryptoKeyGenerate(xmlSecAppCmdLineParamGetString(&sessionKeyParam),
                                 NULL, xmlSecKeyDataTypeSession);
@@ -3012,6 +4048,32 @@ static int xmlSecAppInputCloseCallback(void* context) {
     return(0);
 }
 
+static int g_traceDepth = 0;
+
+static void
+xmlSecAppTraceCallback(xmlSecTraceEvent event, xmlSecTraceSpanPtr span, void* context) {
+    FILE* output = (FILE*)context;
+
+    if((span == NULL) || (output == NULL)) {
+        return;
+    }
+    if(event == xmlSecTraceEventStart) {
+        ++g_traceDepth;
+        return;
+    }
+
+    /* print spans when they end, nested spans are indented */
+    --g_traceDepth;
+    fprintf(output, "Trace: %*s%s", 2 * g_traceDepth, "", xmlSecTraceSpanTypeGetName(span->type));
+    if(span->name != NULL) {
+        fprintf(output, " name=\"%s\"", (const char*)span->name);
+    }
+    if(span->href != NULL) {
+        fprintf(output, " href=\"%s\"", (const char*)span->href);
+    }
+    fprintf(output, " size=" XMLSEC_SIZE_FMT " time=%.6f sec status=%d\n",
+        span->size, span->duration, span->status);
+}
 
 static int intialized = 0;
 
@@ -3587,7 +4649,6 @@ xmlSecAppOpenFile(const char* filename, const char* encoding) {
     return(outBuffer);
 }
 
-#define XMLSEC_OUTPUT_TMPL_PARAM  "{inputfile}"
 static char*
 xmlSecAppGetOutputFilename(const char* inputFileName, const char* outputFileNameTmpl) {
     char* inputFileNameCopy = NULL;
@@ -3692,18 +4753,17 @@ done:
     return(res);
 }
 
-static int
-xmlSecAppWriteResult(const char* inputFileName, const char* outputFileNameTmpl, xmlDocPtr doc, xmlSecBufferPtr buffer, const xmlChar* encoding) {
+static xmlOutputBufferPtr
+xmlSecAppOpenResultFile(const char* inputFileName, const char* outputFileNameTmpl, const xmlChar* encoding) {
     char* outputFileName = NULL;
     xmlOutputBufferPtr outBuffer;
-    int ret;
 
     /* get output filename by replacing '{inputfile}' with input file name */
     if((inputFileName != NULL) && (outputFileNameTmpl != NULL)) {
         outputFileName = xmlSecAppGetOutputFilename(inputFileName, outputFileNameTmpl);
         if(outputFileName == NULL) {
             fprintf(stderr, "Error: can't create output filename\n");
-            return(-1);
+            return(NULL);
         }
     }
 
@@ -3712,6 +4772,36 @@ xmlSecAppWriteResult(const char* inputFileName, const char* outputFileNameTmpl,
     if ((outputFileName != NULL) && (outputFileName != outputFileNameTmpl)) {
         xmlFree(outputFileName);
     }
+    return(outBuffer);
+}
+
+static int
+xmlSecAppDiscardWrite(void* context ATTRIBUTE_UNUSED, const char* buffer ATTRIBUTE_UNUSED, int len) {
+    return(len);
+}
+
+/* the streamed result is written while the operation runs: print it out
+ * only once per execution, just like xmlSecAppWriteResult() callers do */
+static xmlOutputBufferPtr
+xmlSecAppOpenStreamedResultFile(const char* inputFileName, const char* outputFileNameTmpl) {
+    xmlOutputBufferPtr outBuffer;
+
+    if(g_repeats > 1) {
+        outBuffer = xmlOutputBufferCreateIO(xmlSecAppDiscardWrite, NULL, NULL, NULL);
+        if(outBuffer == NULL) {
+            fprintf(stderr, "Error: failed to create output buffer\n");
+        }
+        return(outBuffer);
+    }
+    return(xmlSecAppOpenResultFile(inputFileName, outputFileNameTmpl, NULL));
+}
+
+static int
+xmlSecAppWriteResult(const char* inputFileName, const char* outputFileNameTmpl, xmlDocPtr doc, xmlSecBufferPtr buffer, const xmlChar* encoding) {
+    xmlOutputBufferPtr outBuffer;
+    int ret;
+
+    outBuffer = xmlSecAppOpenResultFile(inputFileName, outputFileNameTmpl, encoding);
     if(outBuffer == NULL) {
         return(-1);
     }
@@ -0,0 +1,201 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Pluggable allocator for the xmlsec objects
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_ALLOCATOR_H__
+#define __XMLSEC_ALLOCATOR_H__
+
+#include <stddef.h>
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * xmlSecAllocatorObjectType:
+ * @xmlSecAllocatorObjectTypeOther:     the other objects.
+ * @xmlSecAllocatorObjectTypeBuffer:    the #xmlSecBuffer objects and data.
+ * @xmlSecAllocatorObjectTypeList:      the #xmlSecPtrList objects and data.
+ * @xmlSecAllocatorObjectTypeTransform: the #xmlSecTransform and #xmlSecTransformCtx objects.
+ * @xmlSecAllocatorObjectTypeKey:       the #xmlSecKey objects.
+ * @xmlSecAllocatorObjectTypeKeyData:   the #xmlSecKeyData objects.
+ * @xmlSecAllocatorObjectTypeStore:     the #xmlSecKeysMngr, #xmlSecKeyStore and #xmlSecKeyDataStore objects.
+ * @xmlSecAllocatorObjectTypeCtx:       the signature, encryption and &lt;dsig:KeyInfo/&gt; processing contexts.
+ * @xmlSecAllocatorObjectTypeArena:     the #xmlSecArena objects and memory chunks.
+ *
+ * The type of the object allocated thru the xmlsec allocator.
+ */
+typedef enum {
+    xmlSecAllocatorObjectTypeOther = 0,
+    xmlSecAllocatorObjectTypeBuffer,
+    xmlSecAllocatorObjectTypeList,
+    xmlSecAllocatorObjectTypeTransform,
+    xmlSecAllocatorObjectTypeKey,
+    xmlSecAllocatorObjectTypeKeyData,
+    xmlSecAllocatorObjectTypeStore,
+    xmlSecAllocatorObjectTypeCtx,
+    xmlSecAllocatorObjectTypeArena
+} xmlSecAllocatorObjectType;
+
+/**
+ * XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX:
+ *
+ * The number of the allocated object types.
+ */
+#define XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX        9
+
+/********************************************************************
+ *
+ * Allocator
+ *
+ *******************************************************************/
+/**
+ * xmlSecAllocatorMallocMethod:
+ * @size:               the number of bytes to allocate.
+ * @type:               the allocated object type.
+ * @context:            the allocator context.
+ *
+ * Allocates @size bytes of memory.
+ *
+ * Returns: the pointer to the allocated memory or NULL if an error occurs.
+ */
+typedef void*           (*xmlSecAllocatorMallocMethod)          (size_t size,
+                                                                 xmlSecAllocatorObjectType type,
+                                                                 void* context);
+/**
+ * xmlSecAllocatorReallocMethod:
+ * @ptr:                the pointer to the memory allocated by the allocator.
+ * @oldSize:            the size of the memory pointed by @ptr.
+ * @newSize:            the new size.
+ * @type:               the allocated object type.
+ * @context:            the allocator context.
+ *
+ * Changes the size of the memory pointed by @ptr to @newSize bytes.
+ *
+ * Returns: the pointer to the reallocated memory or NULL if an error occurs.
+ */
+typedef void*           (*xmlSecAllocatorReallocMethod)         (void* ptr,
+                                                                 size_t oldSize,
+                                                                 size_t newSize,
+                                                                 xmlSecAllocatorObjectType type,
+                                                                 void* context);
+/**
+ * xmlSecAllocatorFreeMethod:
+ * @ptr:                the pointer to the memory allocated by the allocator.
+ * @size:               the size of the memory pointed by @ptr.
+ * @type:               the allocated object type.
+ * @context:            the allocator context.
+ *
+ * Frees the memory pointed by @ptr.
+ */
+typedef void            (*xmlSecAllocatorFreeMethod)            (void* ptr,
+                                                                 size_t size,
+                                                                 xmlSecAllocatorObjectType type,
+                                                                 void* context);
+
+typedef struct _xmlSecAllocator                 xmlSecAllocator,
+                                                *xmlSecAllocatorPtr;
+
+/**
+ * xmlSecAllocator:
+ * @mallocMethod:       the malloc method.
+ * @reallocMethod:      the realloc method.
+ * @freeMethod:         the free method.
+ * @context:            the context passed to the allocator methods.
+ *
+ * The xmlsec allocator. The xmlsec objects always pass the allocated
+ * size back to the realloc and free methods (sized deallocation), thus
+ * the allocator doesn't need to track it.
+ */
+struct _xmlSecAllocator {
+    xmlSecAllocatorMallocMethod         mallocMethod;
+    xmlSecAllocatorReallocMethod        reallocMethod;
+    xmlSecAllocatorFreeMethod           freeMethod;
+    void*                               context;
+};
+
+XMLSEC_EXPORT int               xmlSecAllocatorSet              (const xmlSecAllocator* allocator);
+XMLSEC_EXPORT void              xmlSecAllocatorShutdown         (void);
+XMLSEC_EXPORT const char*       xmlSecAllocatorObjectTypeGetName(xmlSecAllocatorObjectType type);
+
+XMLSEC_EXPORT void*             xmlSecMalloc                    (size_t size,
+                                                                 xmlSecAllocatorObjectType type);
+XMLSEC_EXPORT void*             xmlSecRealloc                   (void* ptr,
+                                                                 size_t oldSize,
+                                                                 size_t newSize,
+                                                                 xmlSecAllocatorObjectType type);
+XMLSEC_EXPORT void              xmlSecFree                      (void* ptr,
+                                                                 size_t size,
+                                                                 xmlSecAllocatorObjectType type);
+
+/********************************************************************
+ *
+ * Allocator stats
+ *
+ *******************************************************************/
+typedef struct _xmlSecAllocatorStats            xmlSecAllocatorStats,
+                                                *xmlSecAllocatorStatsPtr;
+
+/**
+ * xmlSecAllocatorStats:
+ * @liveBytes:          the number of currently allocated bytes.
+ * @peakBytes:          the max number of allocated bytes.
+ * @liveAllocs:         the number of currently allocated memory blocks.
+ * @totalAllocs:        the total number of allocations.
+ * @totalReallocs:      the total number of reallocations.
+ * @totalBytes:         the total number of allocated bytes.
+ * @typeAllocs:         the total number of allocations per object type.
+ * @typeLiveBytes:      the number of currently allocated bytes per object type.
+ *
+ * The xmlsec allocator statistics. The stats collection should be
+ * enabled before any xmlsec object is created, otherwise the live
+ * counters only reflect the objects created after that.
+ */
+struct _xmlSecAllocatorStats {
+    xmlSecSize                          liveBytes;
+    xmlSecSize                          peakBytes;
+    xmlSecSize                          liveAllocs;
+    xmlSecSize                          totalAllocs;
+    xmlSecSize                          totalReallocs;
+    xmlSecSize                          totalBytes;
+    xmlSecSize                          typeAllocs[XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX];
+    xmlSecSize                          typeLiveBytes[XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX];
+};
+
+XMLSEC_EXPORT int               xmlSecAllocatorStatsEnable      (int enabled);
+XMLSEC_EXPORT void              xmlSecAllocatorStatsGet         (xmlSecAllocatorStatsPtr stats);
+XMLSEC_EXPORT void              xmlSecAllocatorStatsReset       (void);
+
+/********************************************************************
+ *
+ * Arena
+ *
+ *******************************************************************/
+/**
+ * XMLSEC_ARENA_DEFAULT_CHUNK_SIZE:
+ *
+ * The default arena chunk size.
+ */
+#define XMLSEC_ARENA_DEFAULT_CHUNK_SIZE         16384
+
+XMLSEC_EXPORT xmlSecArenaPtr    xmlSecArenaCreate               (xmlSecSize chunkSize);
+XMLSEC_EXPORT void              xmlSecArenaDestroy              (xmlSecArenaPtr arena);
+XMLSEC_EXPORT void              xmlSecArenaReset                (xmlSecArenaPtr arena);
+XMLSEC_EXPORT void*             xmlSecArenaMalloc               (xmlSecArenaPtr arena,
+                                                                 xmlSecSize size);
+XMLSEC_EXPORT xmlSecSize        xmlSecArenaGetUsedSize          (xmlSecArenaPtr arena);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_ALLOCATOR_H__ */
@@ -30,12 +30,17 @@ typedef struct _xmlSecBuffer                                    xmlSecBuffer,
  *                              allocated memory size.
  * @xmlSecAllocModeDouble:      the memory allocation mode that tries to minimize
  *                              the number of malloc calls.
+ * @xmlSecAllocModeMmap:        the buffer data is a read-only memory mapped file
+ *                              (see #xmlSecBufferReadFile); the data is copied to
+ *                              the memory allocated using the default mode before
+ *                              the buffer is changed (used only by @xmlSecBuffer).
  *
  * The memory allocation mode (used by @xmlSecBuffer and @xmlSecList).
  */
 typedef enum {
     xmlSecAllocModeExact = 0,
-    xmlSecAllocModeDouble
+    xmlSecAllocModeDouble,
+    xmlSecAllocModeMmap
 } xmlSecAllocMode;
 
 /*****************************************************************************
@@ -62,6 +67,8 @@ struct _xmlSecBuffer {
 
 XMLSEC_EXPORT void              xmlSecBufferSetDefaultAllocMode (xmlSecAllocMode defAllocMode,
                                                                  xmlSecSize defInitialSize);
+XMLSEC_EXPORT void              xmlSecBufferSetMmapThreshold    (xmlSecSize minSize);
+XMLSEC_EXPORT xmlSecSize        xmlSecBufferGetMmapThreshold    (void);
 
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecBufferCreate              (xmlSecSize size);
 XMLSEC_EXPORT void              xmlSecBufferDestroy             (xmlSecBufferPtr buf);
@@ -95,6 +102,8 @@ XMLSEC_EXPORT int               xmlSecBufferRemoveTail          (xmlSecBufferPtr
 XMLSEC_EXPORT int               xmlSecBufferReverse             (xmlSecBufferPtr buf);
 XMLSEC_EXPORT int               xmlSecBufferReadFile            (xmlSecBufferPtr buf,
                                                                  const char* filename);
+XMLSEC_EXPORT int               xmlSecBufferMapFile             (xmlSecBufferPtr buf,
+                                                                 const char* filename);
 XMLSEC_EXPORT int               xmlSecBufferBase64NodeContentRead(xmlSecBufferPtr buf,
                                                                  xmlNodePtr node);
 XMLSEC_EXPORT int               xmlSecBufferBase64NodeContentWrite(xmlSecBufferPtr buf,
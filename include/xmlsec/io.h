@@ -16,6 +16,7 @@
 
 #include <xmlsec/exports.h>
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/buffer.h>
 #include <xmlsec/transforms.h>
 
 #ifdef __cplusplus
@@ -31,6 +32,26 @@ XMLSEC_EXPORT int       xmlSecIORegisterCallbacks               (xmlInputMatchCa
                                                                  xmlInputReadCallback readFunc,
                                                                  xmlInputCloseCallback closeFunc);
 
+/********************************************************************
+ *
+ * External URIs prefetch
+ *
+ *******************************************************************/
+/**
+ * XMLSEC_IO_PREFETCH_DEFAULT_THREADS:
+ *
+ * The default max number of threads used to prefetch the external URIs.
+ */
+#define XMLSEC_IO_PREFETCH_DEFAULT_THREADS                      4
+
+XMLSEC_EXPORT xmlSecIOPrefetchPtr xmlSecIOPrefetchCreate        (xmlSecSize maxThreads);
+XMLSEC_EXPORT void      xmlSecIOPrefetchDestroy                 (xmlSecIOPrefetchPtr prefetch);
+XMLSEC_EXPORT int       xmlSecIOPrefetchAdd                     (xmlSecIOPrefetchPtr prefetch,
+                                                                 const xmlChar* uri);
+XMLSEC_EXPORT int       xmlSecIOPrefetchRun                     (xmlSecIOPrefetchPtr prefetch);
+XMLSEC_EXPORT xmlSecBufferPtr xmlSecIOPrefetchGetBuffer         (xmlSecIOPrefetchPtr prefetch,
+                                                                 const xmlChar* uri);
+
 /********************************************************************
  *
  * Input URI transform
@@ -46,8 +67,26 @@ XMLSEC_EXPORT int       xmlSecIORegisterCallbacks               (xmlInputMatchCa
 XMLSEC_EXPORT xmlSecTransformId xmlSecTransformInputURIGetKlass (void);
 XMLSEC_EXPORT int       xmlSecTransformInputURIOpen             (xmlSecTransformPtr transform,
                                                                  const xmlChar* uri);
+XMLSEC_EXPORT int       xmlSecTransformInputURIOpenBuffer       (xmlSecTransformPtr transform,
+                                                                 xmlSecBufferPtr buffer);
 XMLSEC_EXPORT int       xmlSecTransformInputURIClose            (xmlSecTransformPtr transform);
 
+/********************************************************************
+ *
+ * Output buffer transform
+ *
+ *******************************************************************/
+/**
+ * xmlSecTransformOutputBufferId:
+ *
+ * The output buffer transform id.
+ */
+#define xmlSecTransformOutputBufferId \
+        xmlSecTransformOutputBufferGetKlass()
+XMLSEC_EXPORT xmlSecTransformId xmlSecTransformOutputBufferGetKlass (void);
+XMLSEC_EXPORT int       xmlSecTransformOutputBufferSet          (xmlSecTransformPtr transform,
+                                                                 xmlOutputBufferPtr output);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
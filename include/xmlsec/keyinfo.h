@@ -206,7 +206,9 @@ typedef enum {
  *                      processing level (see @maxEncryptedKeyLevel).
  * @operation:          the transform operation for this key info.
  * @keyReq:             the current key requirements.
- * @reserved0:          reserved for the future.
+ * @encryptedKeys:      the decrypted &lt;enc:EncryptedKey/&gt; elements shared
+ *                      between several contexts (not owned by the context,
+ *                      see #xmlSecEncCtxDecryptAll); not thread safe.
  * @reserved1:          reserved for the future.
  *
  * The <dsig:KeyInfo /> reading or writing context.
@@ -250,8 +252,10 @@ struct _xmlSecKeyInfoCtx {
     xmlSecTransformOperation            operation;
     xmlSecKeyReq                        keyReq;
 
+    /* shared EncryptedKey cache */
+    xmlSecPtrListPtr                    encryptedKeys;
+
     /* for the future */
-    void*                               reserved0;
     void*                               reserved1;
 };
 
@@ -268,6 +272,16 @@ XMLSEC_EXPORT void                      xmlSecKeyInfoCtxDebugDump       (xmlSecK
                                                                          FILE* output);
 XMLSEC_EXPORT void                      xmlSecKeyInfoCtxDebugXmlDump    (xmlSecKeyInfoCtxPtr keyInfoCtx,
                                                                          FILE* output);
+
+/**
+ * xmlSecKeyInfoEncryptedKeyCacheId:
+ *
+ * The decrypted &lt;enc:EncryptedKey/&gt; elements cache klass
+ * (see @encryptedKeys member of #xmlSecKeyInfoCtx).
+ */
+#define xmlSecKeyInfoEncryptedKeyCacheId        xmlSecKeyInfoEncryptedKeyCacheGetKlass()
+XMLSEC_EXPORT xmlSecPtrListId           xmlSecKeyInfoEncryptedKeyCacheGetKlass(void);
+
 /**
  * xmlSecKeyDataNameId
  *
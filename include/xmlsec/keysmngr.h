@@ -293,6 +293,9 @@ XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreAdoptKey   (xmlSecK
 XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreLoad       (xmlSecKeyStorePtr store,
                                                                          const char *uri,
                                                                          xmlSecKeysMngrPtr keysMngr);
+XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreReload     (xmlSecKeyStorePtr store,
+                                                                         const char *uri,
+                                                                         xmlSecKeysMngrPtr keysMngr);
 XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreLoad_ex    (xmlSecKeyStorePtr store,
                                                                          const char *uri,
                                                                          xmlSecKeysMngrPtr keysMngr,
@@ -301,6 +304,9 @@ XMLSEC_EXPORT int                       xmlSecSimpleKeysStoreSave       (xmlSecK
                                                                          const char *filename,
                                                                          xmlSecKeyDataType type);
 XMLSEC_EXPORT xmlSecPtrListPtr          xmlSecSimpleKeysStoreGetKeys    (xmlSecKeyStorePtr store);
+XMLSEC_EXPORT xmlSecPtrListPtr          xmlSecSimpleKeysStoreGetKeysSnapshot(xmlSecKeyStorePtr store);
+XMLSEC_EXPORT void                      xmlSecSimpleKeysStoreReleaseKeysSnapshot(xmlSecKeyStorePtr store,
+                                                                         xmlSecPtrListPtr list);
 
 
 #ifdef __cplusplus
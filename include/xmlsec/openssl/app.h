@@ -44,6 +44,8 @@ XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLAppDefaultKeysMngrVerifyKey
                                                                          xmlSecKeyInfoCtxPtr keyInfoCtx);
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLAppDefaultKeysMngrLoad(xmlSecKeysMngrPtr mngr,
                                                                          const char* uri);
+XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLAppDefaultKeysMngrReload(xmlSecKeysMngrPtr mngr,
+                                                                         const char* uri);
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLAppDefaultKeysMngrSave(xmlSecKeysMngrPtr mngr,
                                                                          const char* filename,
                                                                          xmlSecKeyDataType type);
@@ -36,6 +36,9 @@ XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLKeysStoreAdoptKey(xmlSecKey
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLKeysStoreLoad    (xmlSecKeyStorePtr store,
                                                                        const char *uri,
                                                                        xmlSecKeysMngrPtr keysMngr);
+XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLKeysStoreReload  (xmlSecKeyStorePtr store,
+                                                                       const char *uri,
+                                                                       xmlSecKeysMngrPtr keysMngr);
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLKeysStoreSave    (xmlSecKeyStorePtr store,
                                                                        const char *filename,
                                                                        xmlSecKeyDataType type);
@@ -106,6 +106,9 @@ XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLX509StoreAdoptCert (xmlSecK
                                                                          xmlSecKeyDataType type);
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLX509StoreAdoptCrl  (xmlSecKeyDataStorePtr store,
                                                                          X509_CRL* crl);
+XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLX509StoreUpdateCerts(xmlSecKeyDataStorePtr store,
+                                                                         XMLSEC_STACK_OF_X509* addCerts,
+                                                                         XMLSEC_STACK_OF_X509* removeCerts);
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLX509StoreAddCertsPath(xmlSecKeyDataStorePtr store,
                                                                          const char* path);
 XMLSEC_CRYPTO_EXPORT int                xmlSecOpenSSLX509StoreAddCertsFile(xmlSecKeyDataStorePtr store,
@@ -0,0 +1,131 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Tracing hooks
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_TRACE_H__
+#define __XMLSEC_TRACE_H__
+
+#include <libxml/tree.h>
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/********************************************************************
+ *
+ * Tracing spans
+ *
+ *******************************************************************/
+/**
+ * xmlSecTraceSpanType:
+ * @xmlSecTraceSpanTypeUnknown:         the unknown span (never reported).
+ * @xmlSecTraceSpanTypeDSigSign:        the #xmlSecDSigCtxSign operation.
+ * @xmlSecTraceSpanTypeDSigVerify:      the #xmlSecDSigCtxVerify operation.
+ * @xmlSecTraceSpanTypeDSigReference:   the &lt;dsig:Reference/&gt; processing.
+ * @xmlSecTraceSpanTypeEncEncrypt:      the #xmlSecEncCtxBinaryEncrypt, #xmlSecEncCtxXmlEncrypt
+ *                                      or #xmlSecEncCtxUriEncrypt operation.
+ * @xmlSecTraceSpanTypeEncDecrypt:      the #xmlSecEncCtxDecrypt, #xmlSecEncCtxDecryptToBuffer
+ *                                      or #xmlSecEncCtxDecryptAll operation.
+ * @xmlSecTraceSpanTypeKeyLookup:       the key lookup thru the keys manager.
+ * @xmlSecTraceSpanTypeX509Verify:      the X509 certificates chain verification.
+ *
+ * The tracing span type.
+ */
+typedef enum {
+    xmlSecTraceSpanTypeUnknown = 0,
+    xmlSecTraceSpanTypeDSigSign,
+    xmlSecTraceSpanTypeDSigVerify,
+    xmlSecTraceSpanTypeDSigReference,
+    xmlSecTraceSpanTypeEncEncrypt,
+    xmlSecTraceSpanTypeEncDecrypt,
+    xmlSecTraceSpanTypeKeyLookup,
+    xmlSecTraceSpanTypeX509Verify
+} xmlSecTraceSpanType;
+
+/**
+ * xmlSecTraceEvent:
+ * @xmlSecTraceEventStart:      the span started.
+ * @xmlSecTraceEventEnd:        the span ended.
+ *
+ * The tracing event.
+ */
+typedef enum {
+    xmlSecTraceEventStart = 0,
+    xmlSecTraceEventEnd
+} xmlSecTraceEvent;
+
+typedef struct _xmlSecTraceSpan                 xmlSecTraceSpan,
+                                                *xmlSecTraceSpanPtr;
+
+/**
+ * xmlSecTraceSpan:
+ * @type:               the span type.
+ * @ctx:                the operation context: #xmlSecDSigCtx for sign/verify,
+ *                      #xmlSecDSigReferenceCtx for references, #xmlSecEncCtx
+ *                      for encrypt/decrypt and #xmlSecKeyInfoCtx for
+ *                      key lookups and X509 verification.
+ * @name:               the optional span name: the reference URI or the found
+ *                      key name (for key lookups, end event only).
+ * @href:               the optional algorithm href: the signature, digest or
+ *                      encryption method (end event only).
+ * @startTime:          the span start time in seconds (monotonic clock).
+ * @duration:           the span duration in seconds (end event only).
+ * @size:               the number of bytes processed: canonicalized and
+ *                      digested bytes for signatures and references, bytes
+ *                      fed to the cipher for encryption, the key size in bits
+ *                      for key lookups and 0 for X509 verification (end event only).
+ * @status:             0 if the operation succeeded or a negative value
+ *                      otherwise, e.g. if the key was not found or the certificate
+ *                      was not verified (end event only). The signature verification
+ *                      result is in the #status member of the @ctx.
+ * @userData:           the pointer reserved for the tracing callback: the value
+ *                      set during the start event is preserved for the end event.
+ *
+ * The tracing span. The span is owned by the library and is valid only
+ * during the callback invocation.
+ */
+struct _xmlSecTraceSpan {
+    xmlSecTraceSpanType         type;
+    void*                       ctx;
+    const xmlChar*              name;
+    const xmlChar*              href;
+    double                      startTime;
+    double                      duration;
+    xmlSecSize                  size;
+    int                         status;
+    void*                       userData;
+};
+
+/**
+ * xmlSecTraceCallback:
+ * @event:              the tracing event.
+ * @span:               the span.
+ * @context:            the context passed to #xmlSecTraceSetCallback.
+ *
+ * The tracing callback function. Spans are strictly nested within
+ * a single thread: the end event for a span is always reported before
+ * the end event of the enclosing span.
+ */
+typedef void (*xmlSecTraceCallback)                             (xmlSecTraceEvent event,
+                                                                 xmlSecTraceSpanPtr span,
+                                                                 void* context);
+
+XMLSEC_EXPORT void              xmlSecTraceSetCallback          (xmlSecTraceCallback callback,
+                                                                 void* context);
+XMLSEC_EXPORT xmlSecTraceCallback xmlSecTraceGetCallback        (void);
+XMLSEC_EXPORT const char*       xmlSecTraceSpanTypeGetName      (xmlSecTraceSpanType type);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_TRACE_H__ */
@@ -291,6 +291,37 @@ typedef int             (*xmlSecTransformCtxPreExecuteCallback)         (xmlSecT
  */
 #define XMLSEC_TRANSFORMCTX_FLAGS_USE_VISA3D_HACK               0x00000001
 
+/**
+ * XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS:
+ *
+ * If this flag is set then the time spent in each transform, the number
+ * of processed bytes and chunks and the buffers high-water marks are
+ * collected for each transform (see #xmlSecTransformCtxGetStats).
+ */
+#define XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS                 0x00000002
+
+/**
+ * XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE:
+ *
+ * If this flag is set then the transforms that can be executed in batches
+ * (e.g. the OpenSSL SHA-2 digests) only collect their (small) input and stay in #xmlSecTransformStatusNone
+ * status. The caller is responsible for finishing them with
+ * #xmlSecTransformExecuteBatch (e.g. together with the same transforms
+ * from the other transforms contexts).
+ */
+#define XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE                 0x00000004
+
+/**
+ * XMLSEC_TRANSFORMCTX_FLAGS_PIPELINE_C14N:
+ *
+ * If this flag is set then the c14n transforms write the canonicalized
+ * data in blocks to a bounded queue and the next transforms (e.g. digest)
+ * process the blocks in a separate thread. Ignored if threads support
+ * is disabled or #XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS flag is set.
+ * The crypto library must be thread safe.
+ */
+#define XMLSEC_TRANSFORMCTX_FLAGS_PIPELINE_C14N                 0x00000008
+
 /**
  * xmlSecTransformCtx:
  * @userData:           the pointer to user data (xmlsec and xmlsec-crypto never
@@ -316,7 +347,7 @@ typedef int             (*xmlSecTransformCtxPreExecuteCallback)         (xmlSecT
  * @xptrExpr:           the xpointer expression from data source URI (if any).
  * @first:              the first transform in the chain.
  * @last:               the last transform in the chain.
- * @reserved0:          reserved for the future.
+ * @reserved0:          the private data (used internally by xmlsec).
  * @reserved1:          reserved for the future.
  *
  * The transform execution context.
@@ -392,6 +423,47 @@ XMLSEC_EXPORT xmlSecSize                xmlSecTransformCtxGetDefaultBinaryChunkS
 XMLSEC_EXPORT void                      xmlSecTransformCtxSetDefaultBinaryChunkSize(xmlSecSize binaryChunkSize);
 
 
+/**************************************************************************
+ *
+ * xmlSecTransformStats
+ *
+ *************************************************************************/
+/**
+ * xmlSecTransformStats:
+ * @time:               the wall time (in seconds) spent in the transform itself
+ *                      (the time spent in other transforms in the chain is excluded).
+ * @bytesIn:            the number of bytes received by the transform.
+ * @bytesOut:           the number of bytes produced by the transform.
+ * @chunksIn:           the number of binary data chunks received by the transform.
+ * @chunksOut:          the number of binary data chunks produced by the transform.
+ * @xmlCalls:           the number of XML nodes sets processed by the transform.
+ * @inBufMaxSize:       the input buffer high-water mark (allocated size).
+ * @outBufMaxSize:      the output buffer high-water mark (allocated size).
+ *
+ * The transform execution statistics collected when the
+ * #XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS flag is set.
+ */
+typedef struct _xmlSecTransformStats            xmlSecTransformStats,
+                                                *xmlSecTransformStatsPtr;
+struct _xmlSecTransformStats {
+    double                              time;
+    xmlSecSize                          bytesIn;
+    xmlSecSize                          bytesOut;
+    xmlSecSize                          chunksIn;
+    xmlSecSize                          chunksOut;
+    xmlSecSize                          xmlCalls;
+    xmlSecSize                          inBufMaxSize;
+    xmlSecSize                          outBufMaxSize;
+};
+
+XMLSEC_EXPORT int                       xmlSecTransformCtxGetStats      (xmlSecTransformCtxPtr ctx,
+                                                                         xmlSecTransformStatsPtr stats);
+XMLSEC_EXPORT void                      xmlSecTransformStatsDebugDump   (xmlSecTransformStatsPtr stats,
+                                                                         FILE* output);
+XMLSEC_EXPORT void                      xmlSecTransformStatsDebugXmlDump(xmlSecTransformStatsPtr stats,
+                                                                         FILE* output);
+
+
 /**************************************************************************
  *
  * xmlSecTransform
@@ -410,7 +482,7 @@ XMLSEC_EXPORT void                      xmlSecTransformCtxSetDefaultBinaryChunkS
  * @inNodes:            the input XML nodes.
  * @outNodes:           the output XML nodes.
  * @expectedOutputSize: the expected transform output size (used for key wraps).
- * @reserved0:          reserved for the future.
+ * @reserved0:          the private data (used internally by xmlsec).
  * @reserved1:          reserved for the future.
  *
  * The transform structure.
@@ -442,6 +514,8 @@ struct _xmlSecTransform {
 };
 
 XMLSEC_EXPORT xmlSecTransformPtr        xmlSecTransformCreate   (xmlSecTransformId id);
+XMLSEC_EXPORT xmlSecTransformPtr        xmlSecTransformCreateInArena(xmlSecTransformId id,
+                                                                 xmlSecArenaPtr arena);
 XMLSEC_EXPORT void                      xmlSecTransformDestroy  (xmlSecTransformPtr transform);
 XMLSEC_EXPORT xmlSecTransformPtr        xmlSecTransformNodeRead (xmlNodePtr node,
                                                                  xmlSecTransformUsage usage,
@@ -479,6 +553,9 @@ XMLSEC_EXPORT int                       xmlSecTransformPushXml  (xmlSecTransform
 XMLSEC_EXPORT int                       xmlSecTransformPopXml   (xmlSecTransformPtr transform,
                                                                  xmlSecNodeSetPtr* nodes,
                                                                  xmlSecTransformCtxPtr transformCtx);
+XMLSEC_EXPORT int                       xmlSecTransformExecuteBatch(xmlSecTransformPtr* transforms,
+                                                                 xmlSecSize transformsSize,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 XMLSEC_EXPORT int                       xmlSecTransformExecute  (xmlSecTransformPtr transform,
                                                                  int last,
                                                                  xmlSecTransformCtxPtr transformCtx);
@@ -767,6 +844,25 @@ typedef int             (*xmlSecTransformPopXmlMethod)          (xmlSecTransform
 typedef int             (*xmlSecTransformExecuteMethod)         (xmlSecTransformPtr transform,
                                                                  int last,
                                                                  xmlSecTransformCtxPtr transformCtx);
+/**
+ * xmlSecTransformExecuteOnceMethod:
+ * @transform:                  the pointer to transform object.
+ * @data:                       the input data.
+ * @dataSize:                   the input data size.
+ * @transformCtx:               the pointer to transform context object.
+ *
+ * Transform specific method to process the whole input at once (optional).
+ * The method is called instead of #xmlSecTransformExecuteMethod when the
+ * input is small and already available in memory. It puts the result
+ * in the transform's output buffer and sets the transform status to
+ * #xmlSecTransformStatusFinished.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+typedef int             (*xmlSecTransformExecuteOnceMethod)     (xmlSecTransformPtr transform,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 
 /**
  * xmlSecTransformKlass:
@@ -789,7 +885,8 @@ typedef int             (*xmlSecTransformExecuteMethod)         (xmlSecTransform
  * @popXml:                     the XML data "pop from chain" procesing method.
  * @execute:                    the low level data processing method used  by default
  *                              implementations of @pushBin, @popBin, @pushXml and @popXml.
- * @reserved0:                  reserved for the future.
+ * @executeOnce:                the optional one-shot data processing method used by
+ *                              the default implementation of @pushBin for small inputs.
  * @reserved1:                  reserved for the future.
  *
  * The transform klass description structure.
@@ -821,9 +918,9 @@ struct _xmlSecTransformKlass {
 
     /* low level method */
     xmlSecTransformExecuteMethod        execute;
+    xmlSecTransformExecuteOnceMethod    executeOnce;
 
     /* reserved for future */
-    void*                               reserved0;
     void*                               reserved1;
 };
 
@@ -997,6 +1094,7 @@ XMLSEC_EXPORT xmlSecTransformId xmlSecTransformRelationshipGetKlass     (void);
         xmlSecTransformXsltGetKlass()
 XMLSEC_EXPORT xmlSecTransformId xmlSecTransformXsltGetKlass             (void);
 XMLSEC_EXPORT void              xmlSecTransformXsltSetDefaultSecurityPrefs(xsltSecurityPrefsPtr sec);
+XMLSEC_EXPORT void              xmlSecTransformXsltSetCacheSize         (xmlSecSize size);
 #endif /* XMLSEC_NO_XSLT */
 
 /**
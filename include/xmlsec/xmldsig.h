@@ -17,6 +17,10 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xmlIO.h>
+#ifdef LIBXML_READER_ENABLED
+#include <libxml/xmlreader.h>
+#endif /* LIBXML_READER_ENABLED */
 
 #include <xmlsec/exports.h>
 #include <xmlsec/xmlsec.h>
@@ -112,6 +116,56 @@ typedef enum {
  */
 #define XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK                       0x00000010
 
+/**
+ * XMLSEC_DSIG_FLAGS_PREFETCH_URIS:
+ *
+ * If this flag is set then the external URIs from &lt;dsig:Reference/&gt;
+ * elements (including the ones in &lt;dsig:Manifest/&gt; elements) are read
+ * in parallel before processing the references. The registered I/O
+ * callbacks must be thread safe. The referencePreExecuteCallback is
+ * called for each of these URIs before any of them is read (with the
+ * transforms chain created from the URI only) and can abort the processing.
+ */
+#define XMLSEC_DSIG_FLAGS_PREFETCH_URIS                         0x00000020
+
+/**
+ * XMLSEC_DSIG_FLAGS_COLLECT_TRANSFORM_STATS:
+ *
+ * If this flag is set then the transforms execution statistics are
+ * collected for &lt;dsig:SignedInfo/&gt; and each &lt;dsig:Reference/&gt;
+ * (see #xmlSecDSigReferenceCtxGetStats and #xmlSecTransformCtxGetStats).
+ */
+#define XMLSEC_DSIG_FLAGS_COLLECT_TRANSFORM_STATS               0x00000040
+
+/**
+ * XMLSEC_DSIG_FLAGS_USE_ARENA:
+ *
+ * If this flag is set then the transforms and the &lt;dsig:Reference/&gt;
+ * processing contexts are allocated from the per-operation arena and
+ * released all at once when the context is reset or finalized.
+ */
+#define XMLSEC_DSIG_FLAGS_USE_ARENA                             0x00000080
+
+/**
+ * XMLSEC_DSIG_FLAGS_BATCH_DIGESTS:
+ *
+ * If this flag is set then the digests of the small &lt;dsig:SignedInfo/&gt;
+ * references are calculated together after all the references are
+ * processed (e.g. using the multi-buffer digests if the crypto library
+ * supports them). Only used for the signature verification.
+ */
+#define XMLSEC_DSIG_FLAGS_BATCH_DIGESTS                         0x00000100
+
+/**
+ * XMLSEC_DSIG_FLAGS_PIPELINE_C14N:
+ *
+ * If this flag is set then the &lt;dsig:Reference/&gt; data are
+ * canonicalized and digested in two threads (see
+ * #XMLSEC_TRANSFORMCTX_FLAGS_PIPELINE_C14N). Useful for the large
+ * same-document references.
+ */
+#define XMLSEC_DSIG_FLAGS_PIPELINE_C14N                         0x00000200
+
 /**
  * xmlSecDSigCtx:
  * @userData:                   the pointer to user data (xmlsec and xmlsec-crypto libraries
@@ -142,7 +196,7 @@ typedef enum {
  * @id:                         the pointer to Id attribute of &lt;dsig:Signature/&gt; node.
  * @signedInfoReferences:       the list of references in &lt;dsig:SignedInfo/&gt; node.
  * @manifestReferences:         the list of references in &lt;dsig:Manifest/&gt; nodes.
- * @reserved0:                  reserved for the future.
+ * @reserved0:                  the private data (used internally by xmlsec).
  * @reserved1:                  reserved for the future.
  *
  * XML DSig processing context.
@@ -187,10 +241,19 @@ XMLSEC_EXPORT void              xmlSecDSigCtxDestroy            (xmlSecDSigCtxPt
 XMLSEC_EXPORT int               xmlSecDSigCtxInitialize         (xmlSecDSigCtxPtr dsigCtx,
                                                                  xmlSecKeysMngrPtr keysMngr);
 XMLSEC_EXPORT void              xmlSecDSigCtxFinalize           (xmlSecDSigCtxPtr dsigCtx);
+XMLSEC_EXPORT void              xmlSecDSigCtxReset              (xmlSecDSigCtxPtr dsigCtx);
 XMLSEC_EXPORT int               xmlSecDSigCtxSign               (xmlSecDSigCtxPtr dsigCtx,
                                                                  xmlNodePtr tmpl);
 XMLSEC_EXPORT int               xmlSecDSigCtxVerify             (xmlSecDSigCtxPtr dsigCtx,
                                                                  xmlNodePtr node);
+#ifdef LIBXML_READER_ENABLED
+XMLSEC_EXPORT int               xmlSecDSigCtxSignReader         (xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 xmlTextReaderPtr reader,
+                                                                 xmlOutputBufferPtr output);
+XMLSEC_EXPORT int               xmlSecDSigCtxVerifyReader       (xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlTextReaderPtr reader);
+#endif /* LIBXML_READER_ENABLED */
 XMLSEC_EXPORT int               xmlSecDSigCtxEnableReferenceTransform(xmlSecDSigCtxPtr dsigCtx,
                                                                 xmlSecTransformId transformId);
 XMLSEC_EXPORT int               xmlSecDSigCtxEnableSignatureTransform(xmlSecDSigCtxPtr dsigCtx,
@@ -241,7 +304,7 @@ typedef enum  {
  * @id:                         the &lt;dsig:Reference/&gt; node ID attribute.
  * @uri:                        the &lt;dsig:Reference/&gt; node URI attribute.
  * @type:                       the &lt;dsig:Reference/&gt; node Type attribute.
- * @reserved0:                  reserved for the future.
+ * @reserved0:                  the private data (used internally by xmlsec).
  * @reserved1:                  reserved for the future.
  *
  * The &lt;dsig:Reference/&gt; processing context.
@@ -276,6 +339,8 @@ XMLSEC_EXPORT int               xmlSecDSigReferenceCtxProcessNode(xmlSecDSigRefe
                                                                   xmlNodePtr node);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecDSigReferenceCtxGetPreDigestBuffer
                                                                 (xmlSecDSigReferenceCtxPtr dsigRefCtx);
+XMLSEC_EXPORT int               xmlSecDSigReferenceCtxGetStats  (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                                xmlSecTransformStatsPtr stats);
 XMLSEC_EXPORT void              xmlSecDSigReferenceCtxDebugDump (xmlSecDSigReferenceCtxPtr dsigRefCtx,
                                                                  FILE* output);
 XMLSEC_EXPORT void              xmlSecDSigReferenceCtxDebugXmlDump(xmlSecDSigReferenceCtxPtr dsigRefCtx,
@@ -18,6 +18,7 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xmlIO.h>
 
 #include <xmlsec/exports.h>
 #include <xmlsec/xmlsec.h>
@@ -64,6 +65,21 @@ typedef enum {
  */
 #define XMLSEC_ENC_RETURN_REPLACED_NODE                 0x00000001
 
+/**
+ * XMLSEC_ENC_USE_ARENA:
+ *
+ * If this flag is set, then the transforms are allocated from the per-operation
+ * arena and released all at once when the context is reset or finalized.
+ */
+#define XMLSEC_ENC_USE_ARENA                            0x00000002
+
+/**
+ * XMLSEC_ENC_DECRYPT_DEFAULT_THREADS:
+ *
+ * The default max number of threads used by #xmlSecEncCtxDecryptAll.
+ */
+#define XMLSEC_ENC_DECRYPT_DEFAULT_THREADS              4
+
 /**
  * xmlSecEncCtx:
  * @userData:                   the pointer to user data (xmlsec and xmlsec-crypto libraries
@@ -101,7 +117,7 @@ typedef enum {
  * @failureReason:              the detailed failure reason.
  * @keyInfoNode:                the pointer to &lt;enc:KeyInfo/&gt; node.
  * @cipherValueNode:            the pointer to &lt;enc:CipherValue/&gt; node.
- * @reserved1:                  reserved for the future.
+ * @reserved1:                  the private data (used internally by xmlsec).
  *
  * XML Encryption context.
  */
@@ -140,7 +156,7 @@ struct _xmlSecEncCtx {
     xmlNodePtr                  cipherValueNode;
 
     xmlNodePtr                  replacedNodeList; /* the pointer to the replaced node */
-    void*                       reserved1;        /* reserved for future */
+    void*                       reserved1;        /* the private data */
 };
 
 XMLSEC_EXPORT xmlSecEncCtxPtr   xmlSecEncCtxCreate              (xmlSecKeysMngrPtr keysMngr);
@@ -161,10 +177,33 @@ XMLSEC_EXPORT int               xmlSecEncCtxXmlEncrypt          (xmlSecEncCtxPtr
 XMLSEC_EXPORT int               xmlSecEncCtxUriEncrypt          (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr tmpl,
                                                                  const xmlChar *uri);
+XMLSEC_EXPORT int               xmlSecEncCtxBinaryEncryptToOutput(xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize,
+                                                                 xmlOutputBufferPtr output);
+XMLSEC_EXPORT int               xmlSecEncCtxUriEncryptToOutput  (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 const xmlChar *uri,
+                                                                 xmlOutputBufferPtr output);
+XMLSEC_EXPORT int               xmlSecEncCtxBinaryEncryptRecipients(xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 const xmlChar** recipients,
+                                                                 xmlSecSize recipientsSize,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
+XMLSEC_EXPORT int               xmlSecEncCtxXmlEncryptRecipients(xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 const xmlChar** recipients,
+                                                                 xmlSecSize recipientsSize,
+                                                                 xmlNodePtr node);
 XMLSEC_EXPORT int               xmlSecEncCtxDecrypt             (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr node);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecEncCtxDecryptToBuffer     (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr node);
+XMLSEC_EXPORT int               xmlSecEncCtxDecryptAll          (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr node,
+                                                                 xmlSecSize maxThreads);
 XMLSEC_EXPORT void              xmlSecEncCtxDebugDump           (xmlSecEncCtxPtr encCtx,
                                                                  FILE* output);
 XMLSEC_EXPORT void              xmlSecEncCtxDebugXmlDump        (xmlSecEncCtxPtr encCtx,
@@ -81,6 +81,8 @@ typedef struct _xmlSecKeyStore                  xmlSecKeyStore, *xmlSecKeyStoreP
 typedef struct _xmlSecKeysMngr                  xmlSecKeysMngr, *xmlSecKeysMngrPtr;
 typedef struct _xmlSecTransform                 xmlSecTransform, *xmlSecTransformPtr;
 typedef struct _xmlSecTransformCtx              xmlSecTransformCtx, *xmlSecTransformCtxPtr;
+typedef struct _xmlSecIOPrefetch                xmlSecIOPrefetch, *xmlSecIOPrefetchPtr;
+typedef struct _xmlSecArena                     xmlSecArena, *xmlSecArenaPtr;
 
 #ifndef XMLSEC_NO_XMLDSIG
 typedef struct _xmlSecDSigCtx                   xmlSecDSigCtx, *xmlSecDSigCtxPtr;
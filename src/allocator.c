@@ -0,0 +1,545 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Pluggable allocator for the xmlsec objects.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+/**
+ * SECTION:allocator
+ * @Short_description: Pluggable allocator and allocation stats functions.
+ * @Stability: Stable
+ *
+ * The xmlsec objects (buffers, lists, transforms, keys, key data, stores
+ * and the processing contexts) are allocated thru the xmlsec allocator.
+ * By default, the allocator uses the LibXML2 memory functions but the
+ * application can plug in its own allocator (e.g. a dedicated jemalloc
+ * arena) and collect the allocation stats per object type.
+ */
+#include "globals.h"
+
+#include <string.h>
+
+#include <libxml/xmlmemory.h>
+#include <libxml/threads.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private.h>
+
+static void*    xmlSecAllocatorDefaultMalloc    (size_t size,
+                                                 xmlSecAllocatorObjectType type,
+                                                 void* context);
+static void*    xmlSecAllocatorDefaultRealloc   (void* ptr,
+                                                 size_t oldSize,
+                                                 size_t newSize,
+                                                 xmlSecAllocatorObjectType type,
+                                                 void* context);
+static void     xmlSecAllocatorDefaultFree      (void* ptr,
+                                                 size_t size,
+                                                 xmlSecAllocatorObjectType type,
+                                                 void* context);
+
+static const xmlSecAllocator xmlSecAllocatorDefault = {
+    xmlSecAllocatorDefaultMalloc,       /* xmlSecAllocatorMallocMethod mallocMethod; */
+    xmlSecAllocatorDefaultRealloc,      /* xmlSecAllocatorReallocMethod reallocMethod; */
+    xmlSecAllocatorDefaultFree,         /* xmlSecAllocatorFreeMethod freeMethod; */
+    NULL,                               /* void* context; */
+};
+
+static xmlSecAllocator          gAllocator = {
+    xmlSecAllocatorDefaultMalloc,
+    xmlSecAllocatorDefaultRealloc,
+    xmlSecAllocatorDefaultFree,
+    NULL,
+};
+
+static int                      gStatsEnabled = 0;
+static xmlMutexPtr              gStatsMutex = NULL;
+static xmlSecAllocatorStats     gStats;
+
+static void*
+xmlSecAllocatorDefaultMalloc(size_t size, xmlSecAllocatorObjectType type ATTRIBUTE_UNUSED,
+                             void* context ATTRIBUTE_UNUSED) {
+    UNREFERENCED_PARAMETER(type);
+    UNREFERENCED_PARAMETER(context);
+    return(xmlMalloc(size));
+}
+
+static void*
+xmlSecAllocatorDefaultRealloc(void* ptr, size_t oldSize ATTRIBUTE_UNUSED, size_t newSize,
+                              xmlSecAllocatorObjectType type ATTRIBUTE_UNUSED,
+                              void* context ATTRIBUTE_UNUSED) {
+    UNREFERENCED_PARAMETER(oldSize);
+    UNREFERENCED_PARAMETER(type);
+    UNREFERENCED_PARAMETER(context);
+    return(xmlRealloc(ptr, newSize));
+}
+
+static void
+xmlSecAllocatorDefaultFree(void* ptr, size_t size ATTRIBUTE_UNUSED,
+                           xmlSecAllocatorObjectType type ATTRIBUTE_UNUSED,
+                           void* context ATTRIBUTE_UNUSED) {
+    UNREFERENCED_PARAMETER(size);
+    UNREFERENCED_PARAMETER(type);
+    UNREFERENCED_PARAMETER(context);
+    xmlFree(ptr);
+}
+
+/**
+ * xmlSecAllocatorSet:
+ * @allocator:          the new allocator or NULL to restore the default one.
+ *
+ * Sets the allocator for the xmlsec objects. The @allocator methods are
+ * copied. The allocator must be set before any xmlsec object is created
+ * (usually before calling #xmlSecInit) and can't be changed while any
+ * xmlsec object is alive.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecAllocatorSet(const xmlSecAllocator* allocator) {
+    if(allocator == NULL) {
+        allocator = &xmlSecAllocatorDefault;
+    }
+    xmlSecAssert2(allocator->mallocMethod != NULL, -1);
+    xmlSecAssert2(allocator->reallocMethod != NULL, -1);
+    xmlSecAssert2(allocator->freeMethod != NULL, -1);
+
+    gAllocator = (*allocator);
+    return(0);
+}
+
+/**
+ * xmlSecAllocatorObjectTypeGetName:
+ * @type:               the object type.
+ *
+ * Gets the object type name (e.g. for reporting the stats).
+ *
+ * Returns: the object type name.
+ */
+const char*
+xmlSecAllocatorObjectTypeGetName(xmlSecAllocatorObjectType type) {
+    switch(type) {
+    case xmlSecAllocatorObjectTypeBuffer:
+        return("buffer");
+    case xmlSecAllocatorObjectTypeList:
+        return("list");
+    case xmlSecAllocatorObjectTypeTransform:
+        return("transform");
+    case xmlSecAllocatorObjectTypeKey:
+        return("key");
+    case xmlSecAllocatorObjectTypeKeyData:
+        return("key-data");
+    case xmlSecAllocatorObjectTypeStore:
+        return("store");
+    case xmlSecAllocatorObjectTypeCtx:
+        return("ctx");
+    case xmlSecAllocatorObjectTypeArena:
+        return("arena");
+    case xmlSecAllocatorObjectTypeOther:
+    default:
+        return("other");
+    }
+}
+
+static void
+xmlSecAllocatorStatsUpdate(size_t oldSize, size_t newSize, xmlSecAllocatorObjectType type) {
+    xmlSecSize typeIdx;
+
+    if(gStatsMutex == NULL) {
+        return;
+    }
+    typeIdx = ((unsigned int)type < XMLSEC_ALLOCATOR_OBJECT_TYPE_MAX) ?
+            (xmlSecSize)type : (xmlSecSize)xmlSecAllocatorObjectTypeOther;
+
+    xmlMutexLock(gStatsMutex);
+    if(oldSize == 0) {
+        /* malloc */
+        ++gStats.totalAllocs;
+        ++gStats.liveAllocs;
+        ++gStats.typeAllocs[typeIdx];
+    } else if(newSize == 0) {
+        /* free: the objects created before the stats were enabled are not counted */
+        if(gStats.liveAllocs > 0) {
+            --gStats.liveAllocs;
+        }
+    } else {
+        /* realloc */
+        ++gStats.totalReallocs;
+    }
+
+    if(newSize > oldSize) {
+        gStats.totalBytes              += (newSize - oldSize);
+        gStats.liveBytes               += (newSize - oldSize);
+        gStats.typeLiveBytes[typeIdx]  += (newSize - oldSize);
+        if(gStats.peakBytes < gStats.liveBytes) {
+            gStats.peakBytes = gStats.liveBytes;
+        }
+    } else {
+        gStats.liveBytes = (gStats.liveBytes > (oldSize - newSize)) ?
+            (gStats.liveBytes - (oldSize - newSize)) : 0;
+        gStats.typeLiveBytes[typeIdx] = (gStats.typeLiveBytes[typeIdx] > (oldSize - newSize)) ?
+            (gStats.typeLiveBytes[typeIdx] - (oldSize - newSize)) : 0;
+    }
+    xmlMutexUnlock(gStatsMutex);
+}
+
+/**
+ * xmlSecMalloc:
+ * @size:               the number of bytes to allocate.
+ * @type:               the allocated object type.
+ *
+ * Allocates @size bytes thru the xmlsec allocator. The memory must be
+ * freed with #xmlSecFree function.
+ *
+ * Returns: the pointer to the allocated memory or NULL if an error occurs.
+ */
+void*
+xmlSecMalloc(size_t size, xmlSecAllocatorObjectType type) {
+    void* res;
+
+    xmlSecAssert2(size > 0, NULL);
+
+    res = gAllocator.mallocMethod(size, type, gAllocator.context);
+    if((res != NULL) && (gStatsEnabled != 0)) {
+        xmlSecAllocatorStatsUpdate(0, size, type);
+    }
+    return(res);
+}
+
+/**
+ * xmlSecRealloc:
+ * @ptr:                the pointer to the memory allocated with #xmlSecMalloc.
+ * @oldSize:            the size of the memory pointed by @ptr.
+ * @newSize:            the new size.
+ * @type:               the allocated object type.
+ *
+ * Changes the size of the memory allocated thru the xmlsec allocator.
+ *
+ * Returns: the pointer to the reallocated memory or NULL if an error
+ * occurs (@ptr is not freed in this case).
+ */
+void*
+xmlSecRealloc(void* ptr, size_t oldSize, size_t newSize, xmlSecAllocatorObjectType type) {
+    void* res;
+
+    xmlSecAssert2(newSize > 0, NULL);
+
+    if(ptr == NULL) {
+        return(xmlSecMalloc(newSize, type));
+    }
+    xmlSecAssert2(oldSize > 0, NULL);
+
+    res = gAllocator.reallocMethod(ptr, oldSize, newSize, type, gAllocator.context);
+    if((res != NULL) && (gStatsEnabled != 0)) {
+        xmlSecAllocatorStatsUpdate(oldSize, newSize, type);
+    }
+    return(res);
+}
+
+/**
+ * xmlSecFree:
+ * @ptr:                the pointer to the memory allocated with #xmlSecMalloc.
+ * @size:               the size of the memory pointed by @ptr.
+ * @type:               the allocated object type.
+ *
+ * Frees the memory allocated thru the xmlsec allocator.
+ */
+void
+xmlSecFree(void* ptr, size_t size, xmlSecAllocatorObjectType type) {
+    if(ptr == NULL) {
+        return;
+    }
+    xmlSecAssert(size > 0);
+
+    gAllocator.freeMethod(ptr, size, type, gAllocator.context);
+    if(gStatsEnabled != 0) {
+        xmlSecAllocatorStatsUpdate(size, 0, type);
+    }
+}
+
+/**
+ * xmlSecAllocatorStatsEnable:
+ * @enabled:            1 to enable the stats collection or 0 to disable it.
+ *
+ * Enables or disables the allocation stats collection. The stats
+ * collection adds a lock per allocation and should be enabled before
+ * any xmlsec object is created and before the library is used from
+ * multiple threads.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecAllocatorStatsEnable(int enabled) {
+    if((enabled != 0) && (gStatsMutex == NULL)) {
+        gStatsMutex = xmlNewMutex();
+        if(gStatsMutex == NULL) {
+            xmlSecXmlError("xmlNewMutex", NULL);
+            return(-1);
+        }
+    }
+    gStatsEnabled = enabled;
+    return(0);
+}
+
+/**
+ * xmlSecAllocatorStatsGet:
+ * @stats:              the pointer to the stats object.
+ *
+ * Gets the snapshot of the current allocation stats.
+ */
+void
+xmlSecAllocatorStatsGet(xmlSecAllocatorStatsPtr stats) {
+    xmlSecAssert(stats != NULL);
+
+    if(gStatsMutex == NULL) {
+        memset(stats, 0, sizeof(xmlSecAllocatorStats));
+        return;
+    }
+    xmlMutexLock(gStatsMutex);
+    memcpy(stats, &gStats, sizeof(xmlSecAllocatorStats));
+    xmlMutexUnlock(gStatsMutex);
+}
+
+/**
+ * xmlSecAllocatorStatsReset:
+ *
+ * Resets the total allocation counters (e.g. before measuring
+ * a single operation). The live counters are preserved and the
+ * peak is set to the current number of live bytes.
+ */
+void
+xmlSecAllocatorStatsReset(void) {
+    if(gStatsMutex == NULL) {
+        return;
+    }
+    xmlMutexLock(gStatsMutex);
+    gStats.peakBytes     = gStats.liveBytes;
+    gStats.totalAllocs   = 0;
+    gStats.totalReallocs = 0;
+    gStats.totalBytes    = 0;
+    memset(gStats.typeAllocs, 0, sizeof(gStats.typeAllocs));
+    xmlMutexUnlock(gStatsMutex);
+}
+
+/**
+ * xmlSecAllocatorShutdown:
+ *
+ * Disables the allocation stats collection and frees the allocated
+ * resources. The function is called from #xmlSecShutdown.
+ */
+void
+xmlSecAllocatorShutdown(void) {
+    gStatsEnabled = 0;
+    if(gStatsMutex != NULL) {
+        xmlFreeMutex(gStatsMutex);
+        gStatsMutex = NULL;
+    }
+    memset(&gStats, 0, sizeof(gStats));
+}
+
+/**************************************************************************
+ *
+ * Arena: the short-lived objects are bump allocated from the memory
+ * chunks and released all at once by #xmlSecArenaReset.
+ *
+ *************************************************************************/
+#define XMLSEC_ARENA_ALIGNMENT                  16
+#define XMLSEC_ARENA_ALIGN(size) \
+    (((size) + XMLSEC_ARENA_ALIGNMENT - 1) & ~((xmlSecSize)(XMLSEC_ARENA_ALIGNMENT - 1)))
+
+typedef struct _xmlSecArenaChunk                xmlSecArenaChunk,
+                                                *xmlSecArenaChunkPtr;
+struct _xmlSecArenaChunk {
+    xmlSecArenaChunkPtr         next;
+    xmlSecSize                  size;
+    xmlSecSize                  used;
+};
+
+#define XMLSEC_ARENA_CHUNK_HEADER_SIZE \
+    XMLSEC_ARENA_ALIGN(sizeof(xmlSecArenaChunk))
+#define XMLSEC_ARENA_CHUNK_DATA(chunk) \
+    (((xmlSecByte*)(chunk)) + XMLSEC_ARENA_CHUNK_HEADER_SIZE)
+
+struct _xmlSecArena {
+    xmlSecArenaChunkPtr         chunks;         /* the current chunk is the first one */
+    xmlSecSize                  chunkSize;
+    xmlSecSize                  usedSize;
+};
+
+static xmlSecArenaChunkPtr
+xmlSecArenaChunkCreate(xmlSecSize size) {
+    xmlSecArenaChunkPtr chunk;
+
+    xmlSecAssert2(size > 0, NULL);
+
+    if(size > XMLSEC_SIZE_MAX - XMLSEC_ARENA_CHUNK_HEADER_SIZE) {
+        xmlSecInvalidSizeMoreThanError("Arena chunk size", size,
+            XMLSEC_SIZE_MAX - XMLSEC_ARENA_CHUNK_HEADER_SIZE, NULL);
+        return(NULL);
+    }
+    chunk = (xmlSecArenaChunkPtr)xmlSecMalloc(XMLSEC_ARENA_CHUNK_HEADER_SIZE + size,
+        xmlSecAllocatorObjectTypeArena);
+    if(chunk == NULL) {
+        xmlSecMallocError(XMLSEC_ARENA_CHUNK_HEADER_SIZE + size, NULL);
+        return(NULL);
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return(chunk);
+}
+
+static void
+xmlSecArenaChunkDestroy(xmlSecArenaChunkPtr chunk) {
+    xmlSecAssert(chunk != NULL);
+
+    xmlSecFree(chunk, XMLSEC_ARENA_CHUNK_HEADER_SIZE + chunk->size,
+        xmlSecAllocatorObjectTypeArena);
+}
+
+static void
+xmlSecArenaFreeChunks(xmlSecArenaPtr arena) {
+    xmlSecArenaChunkPtr chunk;
+
+    xmlSecAssert(arena != NULL);
+
+    while(arena->chunks != NULL) {
+        chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        xmlSecArenaChunkDestroy(chunk);
+    }
+    arena->usedSize = 0;
+}
+
+/**
+ * xmlSecArenaCreate:
+ * @chunkSize:          the arena memory chunk size or 0 to use
+ *                      #XMLSEC_ARENA_DEFAULT_CHUNK_SIZE.
+ *
+ * Creates new arena: the memory is allocated from the arena with
+ * #xmlSecArenaMalloc function and released all at once with
+ * #xmlSecArenaReset or #xmlSecArenaDestroy functions. The arena
+ * is not thread safe. The caller is responsible for destroying
+ * returned object by calling #xmlSecArenaDestroy function.
+ *
+ * Returns: pointer to newly allocated arena or NULL if an error occurs.
+ */
+xmlSecArenaPtr
+xmlSecArenaCreate(xmlSecSize chunkSize) {
+    xmlSecArenaPtr arena;
+
+    arena = (xmlSecArenaPtr)xmlSecMalloc(sizeof(xmlSecArena), xmlSecAllocatorObjectTypeArena);
+    if(arena == NULL) {
+        xmlSecMallocError(sizeof(xmlSecArena), NULL);
+        return(NULL);
+    }
+    memset(arena, 0, sizeof(xmlSecArena));
+    arena->chunkSize = (chunkSize > 0) ? XMLSEC_ARENA_ALIGN(chunkSize) : XMLSEC_ARENA_DEFAULT_CHUNK_SIZE;
+    return(arena);
+}
+
+/**
+ * xmlSecArenaDestroy:
+ * @arena:              the pointer to arena.
+ *
+ * Destroys @arena and releases all the memory allocated from it.
+ */
+void
+xmlSecArenaDestroy(xmlSecArenaPtr arena) {
+    xmlSecAssert(arena != NULL);
+
+    xmlSecArenaFreeChunks(arena);
+    xmlSecFree(arena, sizeof(xmlSecArena), xmlSecAllocatorObjectTypeArena);
+}
+
+/**
+ * xmlSecArenaReset:
+ * @arena:              the pointer to arena.
+ *
+ * Releases all the memory allocated from @arena. The memory chunks
+ * are merged into a single one and kept for reuse, thus the next
+ * operation of the same size doesn't need to allocate any memory.
+ */
+void
+xmlSecArenaReset(xmlSecArenaPtr arena) {
+    xmlSecArenaChunkPtr chunk;
+    xmlSecSize size = 0;
+
+    xmlSecAssert(arena != NULL);
+
+    if(arena->chunks == NULL) {
+        return;
+    }
+    if(arena->chunks->next == NULL) {
+        arena->chunks->used = 0;
+        arena->usedSize = 0;
+        return;
+    }
+
+    for(chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+        size += chunk->size;
+    }
+    xmlSecArenaFreeChunks(arena);
+
+    /* if this fails then the chunk is allocated on the next xmlSecArenaMalloc() */
+    arena->chunks = xmlSecArenaChunkCreate(size);
+}
+
+/**
+ * xmlSecArenaMalloc:
+ * @arena:              the pointer to arena.
+ * @size:               the number of bytes to allocate.
+ *
+ * Allocates @size bytes from @arena. The memory is not initialized
+ * and must not be freed: it is released by #xmlSecArenaReset or
+ * #xmlSecArenaDestroy functions.
+ *
+ * Returns: the pointer to the allocated memory or NULL if an error occurs.
+ */
+void*
+xmlSecArenaMalloc(xmlSecArenaPtr arena, xmlSecSize size) {
+    xmlSecArenaChunkPtr chunk;
+    xmlSecByte* res;
+
+    xmlSecAssert2(arena != NULL, NULL);
+    xmlSecAssert2(size > 0, NULL);
+    xmlSecAssert2(size <= XMLSEC_SIZE_MAX - XMLSEC_ARENA_ALIGNMENT, NULL);
+
+    size = XMLSEC_ARENA_ALIGN(size);
+    chunk = arena->chunks;
+    if((chunk == NULL) || ((chunk->size - chunk->used) < size)) {
+        chunk = xmlSecArenaChunkCreate((size > arena->chunkSize) ? size : arena->chunkSize);
+        if(chunk == NULL) {
+            xmlSecInternalError("xmlSecArenaChunkCreate", NULL);
+            return(NULL);
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    res = XMLSEC_ARENA_CHUNK_DATA(chunk) + chunk->used;
+    chunk->used += size;
+    arena->usedSize += size;
+    return(res);
+}
+
+/**
+ * xmlSecArenaGetUsedSize:
+ * @arena:              the pointer to arena.
+ *
+ * Gets the number of bytes allocated from @arena since it was
+ * created or reset.
+ *
+ * Returns: the number of bytes allocated from @arena.
+ */
+xmlSecSize
+xmlSecArenaGetUsedSize(xmlSecArenaPtr arena) {
+    xmlSecAssert2(arena != NULL, 0);
+    return(arena->usedSize);
+}
@@ -779,7 +779,7 @@ static xmlSecTransformKlass xmlSecBase64Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecBase64Execute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
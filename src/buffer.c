@@ -20,9 +20,18 @@
 #include <string.h>
 #include <ctype.h>
 
+#ifndef XMLSEC_NO_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* XMLSEC_NO_MMAP */
+
 #include <libxml/tree.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/base64.h>
 #include <xmlsec/buffer.h>
@@ -37,6 +46,12 @@
  ****************************************************************************/
 static xmlSecAllocMode gAllocMode = xmlSecAllocModeDouble;
 static xmlSecSize gInitialSize = 1024;
+static xmlSecSize gMmapThreshold = 0;
+
+#ifndef XMLSEC_NO_MMAP
+static int      xmlSecBufferUnmap               (xmlSecBufferPtr buf,
+                                                 xmlSecSize size);
+#endif /* XMLSEC_NO_MMAP */
 
 /**
  * xmlSecBufferSetDefaultAllocMode:
@@ -47,12 +62,46 @@ static xmlSecSize gInitialSize = 1024;
  */
 void
 xmlSecBufferSetDefaultAllocMode(xmlSecAllocMode defAllocMode, xmlSecSize defInitialSize) {
+    xmlSecAssert(defAllocMode != xmlSecAllocModeMmap);
     xmlSecAssert(defInitialSize > 0);
 
     gAllocMode = defAllocMode;
     gInitialSize = defInitialSize;
 }
 
+/**
+ * xmlSecBufferSetMmapThreshold:
+ * @minSize:            the min file size to memory map or 0 to disable.
+ *
+ * Sets the min size of the files that are memory mapped instead of
+ * being read by #xmlSecBufferReadFile function (and by the Input URI
+ * transform for the local files). Memory mapping large files avoids
+ * copying the data but the file must not be truncated while the
+ * mapping is in use. By default, memory mapping is disabled.
+ */
+void
+xmlSecBufferSetMmapThreshold(xmlSecSize minSize) {
+    gMmapThreshold = minSize;
+}
+
+/**
+ * xmlSecBufferGetMmapThreshold:
+ *
+ * Gets the min size of the files that are memory mapped (see
+ * #xmlSecBufferSetMmapThreshold).
+ *
+ * Returns: the min file size to memory map or 0 if memory mapping
+ * is disabled or not supported.
+ */
+xmlSecSize
+xmlSecBufferGetMmapThreshold(void) {
+#ifndef XMLSEC_NO_MMAP
+    return(gMmapThreshold);
+#else  /* XMLSEC_NO_MMAP */
+    return(0);
+#endif /* XMLSEC_NO_MMAP */
+}
+
 /**
  * xmlSecBufferCreate:
  * @size:               the intial size.
@@ -68,7 +117,7 @@ xmlSecBufferCreate(xmlSecSize size) {
     xmlSecBufferPtr buf;
     int ret;
 
-    buf = (xmlSecBufferPtr)xmlMalloc(sizeof(xmlSecBuffer));
+    buf = (xmlSecBufferPtr)xmlSecMalloc(sizeof(xmlSecBuffer), xmlSecAllocatorObjectTypeBuffer);
     if(buf == NULL) {
         xmlSecMallocError(sizeof(xmlSecBuffer), NULL);
         return(NULL);
@@ -94,7 +143,7 @@ xmlSecBufferDestroy(xmlSecBufferPtr buf) {
     xmlSecAssert(buf != NULL);
 
     xmlSecBufferFinalize(buf);
-    xmlFree(buf);
+    xmlSecFree(buf, sizeof(xmlSecBuffer), xmlSecAllocatorObjectTypeBuffer);
 }
 
 /**
@@ -131,8 +180,16 @@ xmlSecBufferFinalize(xmlSecBufferPtr buf) {
 
     xmlSecBufferEmpty(buf);
 
+#ifndef XMLSEC_NO_MMAP
+    if((buf->data != 0) && (buf->allocMode == xmlSecAllocModeMmap)) {
+        munmap(buf->data, buf->maxSize);
+        buf->data = NULL;
+        buf->allocMode = gAllocMode;
+    }
+#endif /* XMLSEC_NO_MMAP */
+
     if(buf->data != 0) {
-        xmlFree(buf->data);
+        xmlSecFree(buf->data, buf->maxSize, xmlSecAllocatorObjectTypeBuffer);
     }
     buf->data = NULL;
     buf->size = buf->maxSize = 0;
@@ -148,7 +205,8 @@ void
 xmlSecBufferEmpty(xmlSecBufferPtr buf) {
     xmlSecAssert(buf != NULL);
 
-    if(buf->data != 0) {
+    /* don't touch (and copy) all the pages of the memory mapped file */
+    if((buf->data != 0) && (buf->allocMode != xmlSecAllocModeMmap)) {
         xmlSecAssert(buf->maxSize > 0);
         memset(buf->data, 0, buf->maxSize);
     }
@@ -289,6 +347,16 @@ xmlSecBufferSetMaxSize(xmlSecBufferPtr buf, xmlSecSize size) {
     xmlSecSize newSize = 0;
 
     xmlSecAssert2(buf != NULL, -1);
+    if(buf->allocMode == xmlSecAllocModeMmap) {
+#ifndef XMLSEC_NO_MMAP
+        /* the memory mapped file is read-only and can't grow: the caller
+         * is going to write in the buffer */
+        return(xmlSecBufferUnmap(buf, size));
+#else  /* XMLSEC_NO_MMAP */
+        xmlSecNotImplementedError("memory mapped files");
+        return(-1);
+#endif /* XMLSEC_NO_MMAP */
+    }
     if(size <= buf->maxSize) {
         return(0);
     }
@@ -300,6 +368,9 @@ xmlSecBufferSetMaxSize(xmlSecBufferPtr buf, xmlSecSize size) {
         case xmlSecAllocModeDouble:
             newSize = 2 * size + 32;
             break;
+        case xmlSecAllocModeMmap:
+            /* handled above */
+            return(-1);
     }
 
     if(newSize < gInitialSize) {
@@ -308,9 +379,9 @@ xmlSecBufferSetMaxSize(xmlSecBufferPtr buf, xmlSecSize size) {
 
 
     if(buf->data != NULL) {
-        newData = (xmlSecByte*)xmlRealloc(buf->data, newSize);
+        newData = (xmlSecByte*)xmlSecRealloc(buf->data, buf->maxSize, newSize, xmlSecAllocatorObjectTypeBuffer);
     } else {
-        newData = (xmlSecByte*)xmlMalloc(newSize);
+        newData = (xmlSecByte*)xmlSecMalloc(newSize, xmlSecAllocatorObjectTypeBuffer);
     }
     if(newData == NULL) {
         xmlSecMallocError(newSize, NULL);
@@ -426,8 +497,16 @@ xmlSecBufferPrepend(xmlSecBufferPtr buf, const xmlSecByte* data, xmlSecSize size
  */
 int
 xmlSecBufferRemoveHead(xmlSecBufferPtr buf, xmlSecSize size) {
+    int ret;
+
     xmlSecAssert2(buf != NULL, -1);
 
+    ret = xmlSecBufferSetMaxSize(buf, buf->size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL, "size=" XMLSEC_SIZE_FMT, buf->size);
+        return(-1);
+    }
+
     if(size < buf->size) {
         xmlSecAssert2(buf->data != NULL, -1);
 
@@ -454,8 +533,16 @@ xmlSecBufferRemoveHead(xmlSecBufferPtr buf, xmlSecSize size) {
  */
 int
 xmlSecBufferRemoveTail(xmlSecBufferPtr buf, xmlSecSize size) {
+    int ret;
+
     xmlSecAssert2(buf != NULL, -1);
 
+    ret = xmlSecBufferSetMaxSize(buf, buf->size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL, "size=" XMLSEC_SIZE_FMT, buf->size);
+        return(-1);
+    }
+
     if(size < buf->size) {
         buf->size -= size;
     } else {
@@ -482,6 +569,7 @@ xmlSecBufferReverse(xmlSecBufferPtr buf) {
     xmlSecByte* qq;
     xmlSecSize  size;
     xmlSecByte ch;
+    int ret;
 
     xmlSecAssert2(buf != NULL, -1);
 
@@ -490,6 +578,11 @@ xmlSecBufferReverse(xmlSecBufferPtr buf) {
     if (size <= 1) {
         return(0);
     }
+    ret = xmlSecBufferSetMaxSize(buf, size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL, "size=" XMLSEC_SIZE_FMT, size);
+        return(-1);
+    }
 
     pp = xmlSecBufferGetData(buf);
     xmlSecAssert2(pp != NULL, -1);
@@ -504,12 +597,128 @@ xmlSecBufferReverse(xmlSecBufferPtr buf) {
 }
 
 
+/**
+ * xmlSecBufferMapFile:
+ * @buf:                the pointer to empty buffer object.
+ * @filename:           the filename.
+ *
+ * Memory maps the file @filename in the buffer if the file size is at least
+ * the mmap threshold (see #xmlSecBufferSetMmapThreshold). The mapping is
+ * read-only: the data is copied to the heap before the buffer is changed
+ * thus the mapping doesn't need the swap space for the whole file.
+ *
+ * Returns: 1 if the file was mapped, 0 if the file should be read instead
+ * (e.g. it is too small, not a regular file or memory mapping is not
+ * supported) or a negative value if an error occurs.
+ */
+int
+xmlSecBufferMapFile(xmlSecBufferPtr buf, const char* filename) {
+#ifndef XMLSEC_NO_MMAP
+    struct stat st;
+    void* data;
+    xmlSecSize size;
+    int fd;
+    int ret;
+
+    xmlSecAssert2(buf != NULL, -1);
+    xmlSecAssert2(buf->size == 0, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    if(gMmapThreshold == 0) {
+        return(0);
+    }
+
+    fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        /* let fopen() report the error */
+        return(0);
+    }
+    ret = fstat(fd, &st);
+    if((ret != 0) || (!S_ISREG(st.st_mode)) || (st.st_size <= 0)) {
+        close(fd);
+        return(0);
+    }
+    if((unsigned long long)st.st_size > (unsigned long long)XMLSEC_SIZE_MAX) {
+        close(fd);
+        return(0);
+    }
+    size = (xmlSecSize)st.st_size;
+    if(size < gMmapThreshold) {
+        close(fd);
+        return(0);
+    }
+
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        /* e.g. out of address space: let fread() try */
+        return(0);
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(data, size, MADV_SEQUENTIAL);
+#endif /* MADV_SEQUENTIAL */
+
+    /* drop the previous data */
+    xmlSecBufferFinalize(buf);
+
+    buf->data = (xmlSecByte*)data;
+    buf->size = buf->maxSize = size;
+    buf->allocMode = xmlSecAllocModeMmap;
+    return(1);
+#else  /* XMLSEC_NO_MMAP */
+    xmlSecAssert2(buf != NULL, -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    return(0);
+#endif /* XMLSEC_NO_MMAP */
+}
+
+#ifndef XMLSEC_NO_MMAP
+/* copies the memory mapped data to the heap and unmaps the file */
+static int
+xmlSecBufferUnmap(xmlSecBufferPtr buf, xmlSecSize size) {
+    xmlSecByte* data;
+    xmlSecSize dataSize, dataMaxSize;
+    int ret;
+
+    xmlSecAssert2(buf != NULL, -1);
+    xmlSecAssert2(buf->allocMode == xmlSecAllocModeMmap, -1);
+    xmlSecAssert2(buf->data != NULL, -1);
+
+    data = buf->data;
+    dataSize = buf->size;
+    dataMaxSize = buf->maxSize;
+
+    buf->data = NULL;
+    buf->size = buf->maxSize = 0;
+    buf->allocMode = gAllocMode;
+
+    ret = xmlSecBufferSetMaxSize(buf, (size > dataSize) ? size : dataSize);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL, "size=" XMLSEC_SIZE_FMT, size);
+        buf->data = data;
+        buf->size = dataSize;
+        buf->maxSize = dataMaxSize;
+        buf->allocMode = xmlSecAllocModeMmap;
+        return(-1);
+    }
+    memcpy(buf->data, data, dataSize);
+    buf->size = dataSize;
+
+    munmap(data, dataMaxSize);
+    return(0);
+}
+#endif /* XMLSEC_NO_MMAP */
+
 /**
  * xmlSecBufferReadFile:
  * @buf:                the pointer to buffer object.
  * @filename:           the filename.
  *
- * Reads the content of the file @filename in the buffer.
+ * Reads the content of the file @filename in the buffer. If the buffer is
+ * empty and the file size is at least the mmap threshold (see
+ * #xmlSecBufferSetMmapThreshold) then the file is memory mapped
+ * instead.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
@@ -525,6 +734,17 @@ xmlSecBufferReadFile(xmlSecBufferPtr buf, const char* filename) {
     xmlSecAssert2(buf != NULL, -1);
     xmlSecAssert2(filename != NULL, -1);
 
+    if(buf->size == 0) {
+        ret = xmlSecBufferMapFile(buf, filename);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferMapFile", NULL,
+                "filename=%s", xmlSecErrorsSafeString(filename));
+            return(-1);
+        } else if(ret > 0) {
+            return(0);
+        }
+    }
+
 #ifndef _MSC_VER
     f = fopen(filename, "rb");
 #else
@@ -19,6 +19,10 @@
 
 #include <libxml/tree.h>
 #include <libxml/c14n.h>
+#include <libxml/uri.h>
+#ifdef LIBXML_READER_ENABLED
+#include <libxml/xmlreader.h>
+#endif /* LIBXML_READER_ENABLED */
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/keys.h>
@@ -28,6 +32,7 @@
 #include <xmlsec/errors.h>
 
 #include "cast_helpers.h"
+#include "transform_helpers.h"
 
 /******************************************************************************
  *
@@ -210,8 +215,15 @@ xmlSecTransformC14NPushXml(xmlSecTransformPtr transform, xmlSecNodeSetPtr nodes,
     }
     xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
 
-    /* prepare output buffer: next transform or ourselves */
-    if(transform->next != NULL) {
+    /* prepare output buffer: next transform (in a separate thread if requested) or ourselves */
+    if((transform->next != NULL) && ((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_PIPELINE_C14N) != 0)) {
+        buf = xmlSecTransformCreatePipelineOutputBuffer(transform->next, transformCtx);
+        if(buf == NULL) {
+            xmlSecInternalError("xmlSecTransformCreatePipelineOutputBuffer",
+                                xmlSecTransformGetName(transform));
+            return(-1);
+        }
+    } else if(transform->next != NULL) {
         buf = xmlSecTransformCreateOutputBuffer(transform->next, transformCtx);
         if(buf == NULL) {
             xmlSecInternalError("xmlSecTransformCreateOutputBuffer",
@@ -399,6 +411,848 @@ xmlSecTransformC14NExecute(xmlSecTransformId id, xmlSecNodeSetPtr nodes, xmlSecP
     return(0);
 }
 
+/***************************************************************************
+ *
+ * Subtree C14N: canonicalizes an element with all its descendants straight
+ * from the tree. libxml2 C14N walks the whole document and calls the
+ * visibility callback for every node even if only a small subtree
+ * (e.g. SignedInfo) is in the nodes set. Only the common cases are
+ * handled here, everything else is left to xmlSecTransformC14NExecute().
+ *
+ ***************************************************************************/
+#define XMLSEC_C14N_SUBTREE_MAX_ITEMS       64
+
+typedef struct _xmlSecC14NSubtreeCtx {
+    xmlSecBufferPtr     out;
+    int                 exclusive;
+    int                 withComments;
+    int                 inheritXmlAttrs;
+    xmlNsPtr            rendered[XMLSEC_C14N_SUBTREE_MAX_ITEMS];    /* exclusive: rendered namespaces stack */
+    xmlSecSize          renderedUse;
+} xmlSecC14NSubtreeCtx, *xmlSecC14NSubtreeCtxPtr;
+
+/* returns 1 on success, 0 if the subtree is not supported or -1 on error */
+static int              xmlSecC14NSubtreeElement        (xmlSecC14NSubtreeCtxPtr ctx,
+                                                         xmlNodePtr cur,
+                                                         int isApex);
+
+static int
+xmlSecC14NSubtreeWrite(xmlSecC14NSubtreeCtxPtr ctx, const xmlChar* str, xmlSecSize size) {
+    int ret;
+
+    if(size == 0) {
+        return(1);
+    }
+    ret = xmlSecBufferAppend(ctx->out, str, size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferAppend", NULL, "size=" XMLSEC_SIZE_FMT, size);
+        return(-1);
+    }
+    return(1);
+}
+
+static int
+xmlSecC14NSubtreeWriteStr(xmlSecC14NSubtreeCtxPtr ctx, const xmlChar* str) {
+    xmlSecSize size;
+
+    if(str == NULL) {
+        return(1);
+    }
+    XMLSEC_SAFE_CAST_SIZE_T_TO_SIZE(strlen((const char*)str), size, return(-1), NULL);
+    return(xmlSecC14NSubtreeWrite(ctx, str, size));
+}
+
+/* the same escaping as xmlC11NNormalizeText/Attr/PI/Comment in libxml2 */
+#define XMLSEC_C14N_SUBTREE_TEXT            0
+#define XMLSEC_C14N_SUBTREE_ATTR            1
+#define XMLSEC_C14N_SUBTREE_PI              2
+#define XMLSEC_C14N_SUBTREE_COMMENT         XMLSEC_C14N_SUBTREE_PI  /* only '\r' is escaped */
+
+static int
+xmlSecC14NSubtreeWriteEscaped(xmlSecC14NSubtreeCtxPtr ctx, const xmlChar* str, int mode) {
+    xmlSecSize ii, start;
+    const char* esc;
+    int ret;
+
+    if(str == NULL) {
+        return(1);
+    }
+    for(ii = start = 0; str[ii] != '\0'; ++ii) {
+        switch(str[ii]) {
+        case '&':
+            esc = (mode != XMLSEC_C14N_SUBTREE_PI) ? "&amp;" : NULL;
+            break;
+        case '<':
+            esc = (mode != XMLSEC_C14N_SUBTREE_PI) ? "&lt;" : NULL;
+            break;
+        case '>':
+            esc = (mode == XMLSEC_C14N_SUBTREE_TEXT) ? "&gt;" : NULL;
+            break;
+        case '"':
+            esc = (mode == XMLSEC_C14N_SUBTREE_ATTR) ? "&quot;" : NULL;
+            break;
+        case '\t':
+            esc = (mode == XMLSEC_C14N_SUBTREE_ATTR) ? "&#x9;" : NULL;
+            break;
+        case '\n':
+            esc = (mode == XMLSEC_C14N_SUBTREE_ATTR) ? "&#xA;" : NULL;
+            break;
+        case '\r':
+            esc = "&#xD;";
+            break;
+        default:
+            esc = NULL;
+            break;
+        }
+        if(esc == NULL) {
+            continue;
+        }
+        ret = xmlSecC14NSubtreeWrite(ctx, str + start, ii - start);
+        if(ret < 0) {
+            return(-1);
+        }
+        ret = xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST esc);
+        if(ret < 0) {
+            return(-1);
+        }
+        start = ii + 1;
+    }
+    return(xmlSecC14NSubtreeWrite(ctx, str + start, ii - start));
+}
+
+static int
+xmlSecC14NSubtreeIsXmlNs(xmlNsPtr ns) {
+    return((ns != NULL) && xmlStrEqual(ns->prefix, BAD_CAST "xml") &&
+           xmlStrEqual(ns->href, XML_XML_NAMESPACE));
+}
+
+static int
+xmlSecC14NSubtreeIsEmptyNs(xmlNsPtr ns) {
+    return((xmlStrlen(ns->prefix) == 0) && (xmlStrlen(ns->href) == 0));
+}
+
+/* the same order as xmlC14NNsCompare() */
+static int
+xmlSecC14NSubtreeNsCompare(xmlNsPtr ns1, xmlNsPtr ns2) {
+    return(xmlStrcmp(ns1->prefix, ns2->prefix));
+}
+
+/* the same order as xmlC14NAttrsCompare() */
+static int
+xmlSecC14NSubtreeAttrCompare(xmlAttrPtr attr1, xmlAttrPtr attr2) {
+    int ret;
+
+    if(attr1->ns == attr2->ns) {
+        return(xmlStrcmp(attr1->name, attr2->name));
+    }
+    if(attr1->ns == NULL) {
+        return(-1);
+    }
+    if(attr2->ns == NULL) {
+        return(1);
+    }
+    if(attr1->ns->prefix == NULL) {
+        return(-1);
+    }
+    if(attr2->ns->prefix == NULL) {
+        return(1);
+    }
+    ret = xmlStrcmp(attr1->ns->href, attr2->ns->href);
+    if(ret == 0) {
+        ret = xmlStrcmp(attr1->name, attr2->name);
+    }
+    return(ret);
+}
+
+/* sorted insert, returns 1 if inserted, 0 if there is an equal item or the list is full */
+static int
+xmlSecC14NSubtreeNsInsert(xmlNsPtr* list, xmlSecSize* listSize, xmlNsPtr ns) {
+    xmlSecSize ii;
+    int ret;
+
+    for(ii = (*listSize); ii > 0; --ii) {
+        ret = xmlSecC14NSubtreeNsCompare(list[ii - 1], ns);
+        if(ret == 0) {
+            return(0);
+        } else if(ret < 0) {
+            break;
+        }
+    }
+    if((*listSize) >= XMLSEC_C14N_SUBTREE_MAX_ITEMS) {
+        return(0);
+    }
+    memmove(list + ii + 1, list + ii, ((*listSize) - ii) * sizeof(xmlNsPtr));
+    list[ii] = ns;
+    ++(*listSize);
+    return(1);
+}
+
+static int
+xmlSecC14NSubtreeAttrInsert(xmlAttrPtr* list, xmlSecSize* listSize, xmlAttrPtr attr) {
+    xmlSecSize ii;
+    int ret;
+
+    for(ii = (*listSize); ii > 0; --ii) {
+        ret = xmlSecC14NSubtreeAttrCompare(list[ii - 1], attr);
+        if(ret == 0) {
+            return(0);
+        } else if(ret < 0) {
+            break;
+        }
+    }
+    if((*listSize) >= XMLSEC_C14N_SUBTREE_MAX_ITEMS) {
+        return(0);
+    }
+    memmove(list + ii + 1, list + ii, ((*listSize) - ii) * sizeof(xmlAttrPtr));
+    list[ii] = attr;
+    ++(*listSize);
+    return(1);
+}
+
+/* exclusive c14n: is the same namespace already rendered by an output ancestor? */
+static int
+xmlSecC14NSubtreeExclNsRendered(xmlSecC14NSubtreeCtxPtr ctx, xmlNsPtr ns) {
+    const xmlChar* prefix = (ns->prefix != NULL) ? ns->prefix : BAD_CAST "";
+    const xmlChar* href = (ns->href != NULL) ? ns->href : BAD_CAST "";
+    xmlSecSize ii;
+
+    for(ii = ctx->renderedUse; ii > 0; --ii) {
+        xmlNsPtr ns1 = ctx->rendered[ii - 1];
+        if(xmlStrEqual(prefix, (ns1->prefix != NULL) ? ns1->prefix : BAD_CAST "")) {
+            return(xmlStrEqual(href, (ns1->href != NULL) ? ns1->href : BAD_CAST ""));
+        }
+    }
+    return(xmlSecC14NSubtreeIsEmptyNs(ns));
+}
+
+/* returns 1 if added, 0 if the stack is full */
+static int
+xmlSecC14NSubtreeExclNsAdd(xmlSecC14NSubtreeCtxPtr ctx, xmlNsPtr ns, xmlNsPtr* list,
+                           xmlSecSize* listSize, int* hasEmptyNs) {
+    if(xmlSecC14NSubtreeIsXmlNs(ns)) {
+        return(1);
+    }
+    if(!xmlSecC14NSubtreeExclNsRendered(ctx, ns)) {
+        if(xmlSecC14NSubtreeNsInsert(list, listSize, ns) != 1) {
+            return(0);
+        }
+        if(ctx->renderedUse >= XMLSEC_C14N_SUBTREE_MAX_ITEMS) {
+            return(0);
+        }
+        ctx->rendered[(ctx->renderedUse)++] = ns;
+    }
+    if(xmlStrlen(ns->prefix) == 0) {
+        (*hasEmptyNs) = 1;
+    }
+    return(1);
+}
+
+/* collects the namespaces to render on @cur, returns 1 on success or 0 if not supported */
+static int
+xmlSecC14NSubtreeCollectNs(xmlSecC14NSubtreeCtxPtr ctx, xmlNodePtr cur, int isApex,
+                           xmlNsPtr* list, xmlSecSize* listSize, int* renderEmptyNs) {
+    xmlNsPtr ns;
+    xmlNodePtr node;
+    xmlSecSize ii;
+
+    (*renderEmptyNs) = 0;
+    if(ctx->exclusive != 0) {
+        xmlAttrPtr attr;
+        int hasEmptyNs = 0;
+        int utilizesEmptyNs = 0;
+
+        if(cur->ns != NULL) {
+            ns = cur->ns;
+        } else {
+            ns = xmlSearchNs(cur->doc, cur, NULL);
+            utilizesEmptyNs = 1;
+        }
+        if((ns != NULL) && (xmlSecC14NSubtreeExclNsAdd(ctx, ns, list, listSize, &hasEmptyNs) != 1)) {
+            return(0);
+        }
+        for(attr = cur->properties; attr != NULL; attr = attr->next) {
+            if((attr->ns != NULL) && (xmlSecC14NSubtreeExclNsAdd(ctx, attr->ns, list, listSize, &hasEmptyNs) != 1)) {
+                return(0);
+            }
+        }
+        if((utilizesEmptyNs != 0) && (hasEmptyNs == 0)) {
+            xmlNs emptyNs;
+
+            memset(&emptyNs, 0, sizeof(emptyNs));
+            (*renderEmptyNs) = !xmlSecC14NSubtreeExclNsRendered(ctx, &emptyNs);
+        }
+        return(1);
+    }
+
+    if(isApex != 0) {
+        /* all the namespaces in scope, the nearest declaration wins */
+        for(node = cur; (node != NULL) && (node->type == XML_ELEMENT_NODE); node = node->parent) {
+            for(ns = node->nsDef; ns != NULL; ns = ns->next) {
+                for(ii = 0; ii < (*listSize); ++ii) {
+                    if(xmlStrEqual(list[ii]->prefix, ns->prefix)) {
+                        break;
+                    }
+                }
+                if((ii < (*listSize)) || xmlSecC14NSubtreeIsXmlNs(ns)) {
+                    continue;
+                }
+                if(xmlSecC14NSubtreeNsInsert(list, listSize, ns) != 1) {
+                    return(0);
+                }
+            }
+        }
+        /* xmlns="" is never rendered on the apex */
+        if(((*listSize) > 0) && xmlSecC14NSubtreeIsEmptyNs(list[0])) {
+            memmove(list, list + 1, ((*listSize) - 1) * sizeof(xmlNsPtr));
+            --(*listSize);
+        }
+        return(1);
+    }
+
+    /* only the declarations that change the parent's in scope namespaces */
+    for(ns = cur->nsDef; ns != NULL; ns = ns->next) {
+        xmlNsPtr parentNs;
+
+        if(xmlSecC14NSubtreeIsXmlNs(ns)) {
+            continue;
+        }
+        parentNs = xmlSearchNs(cur->doc, cur->parent, ns->prefix);
+        if(xmlSecC14NSubtreeIsEmptyNs(ns)) {
+            if((parentNs == NULL) || (xmlStrlen(parentNs->href) == 0)) {
+                continue;
+            }
+        } else if((parentNs != NULL) && xmlStrEqual(parentNs->href, ns->href)) {
+            continue;
+        }
+        if(xmlSecC14NSubtreeNsInsert(list, listSize, ns) != 1) {
+            return(0);
+        }
+    }
+    return(1);
+}
+
+/* collects the attributes to render on @cur, returns 1 on success or 0 if not supported */
+static int
+xmlSecC14NSubtreeCollectAttrs(xmlSecC14NSubtreeCtxPtr ctx, xmlNodePtr cur, int isApex,
+                              xmlAttrPtr* list, xmlSecSize* listSize) {
+    xmlAttrPtr attr;
+    xmlNodePtr node;
+
+    for(attr = cur->properties; attr != NULL; attr = attr->next) {
+        if(xmlSecC14NSubtreeAttrInsert(list, listSize, attr) != 1) {
+            return(0);
+        }
+    }
+    if((isApex == 0) || (ctx->exclusive != 0)) {
+        return(1);
+    }
+
+    /* inclusive c14n: xml:* attributes are inherited from the ancestors
+     * (c14n 1.1 has special rules for them, leave it to libxml2) */
+    for(node = cur->parent; (node != NULL) && (node->type == XML_ELEMENT_NODE); node = node->parent) {
+        for(attr = node->properties; attr != NULL; attr = attr->next) {
+            if(!xmlSecC14NSubtreeIsXmlNs(attr->ns)) {
+                continue;
+            }
+            if(ctx->inheritXmlAttrs == 0) {
+                return(0);
+            }
+            if(((*listSize) >= XMLSEC_C14N_SUBTREE_MAX_ITEMS)) {
+                return(0);
+            }
+            xmlSecC14NSubtreeAttrInsert(list, listSize, attr);
+        }
+    }
+    return(1);
+}
+
+static int
+xmlSecC14NSubtreeWriteName(xmlSecC14NSubtreeCtxPtr ctx, xmlNsPtr ns, const xmlChar* name) {
+    if((ns != NULL) && (xmlStrlen(ns->prefix) > 0)) {
+        if((xmlSecC14NSubtreeWriteStr(ctx, ns->prefix) < 0) ||
+           (xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST ":") < 0)) {
+            return(-1);
+        }
+    }
+    return(xmlSecC14NSubtreeWriteStr(ctx, name));
+}
+
+static int
+xmlSecC14NSubtreeNode(xmlSecC14NSubtreeCtxPtr ctx, xmlNodePtr cur) {
+    switch(cur->type) {
+    case XML_ELEMENT_NODE:
+        return(xmlSecC14NSubtreeElement(ctx, cur, 0));
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+        return(xmlSecC14NSubtreeWriteEscaped(ctx, cur->content, XMLSEC_C14N_SUBTREE_TEXT));
+    case XML_COMMENT_NODE:
+        if(ctx->withComments == 0) {
+            return(1);
+        }
+        if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "<!--") < 0) ||
+           (xmlSecC14NSubtreeWriteEscaped(ctx, cur->content, XMLSEC_C14N_SUBTREE_COMMENT) < 0) ||
+           (xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "-->") < 0)) {
+            return(-1);
+        }
+        return(1);
+    case XML_PI_NODE:
+        if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "<?") < 0) ||
+           (xmlSecC14NSubtreeWriteStr(ctx, cur->name) < 0)) {
+            return(-1);
+        }
+        if((cur->content != NULL) && ((*cur->content) != '\0')) {
+            if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST " ") < 0) ||
+               (xmlSecC14NSubtreeWriteEscaped(ctx, cur->content, XMLSEC_C14N_SUBTREE_PI) < 0)) {
+                return(-1);
+            }
+        }
+        return(xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "?>"));
+    default:
+        /* entity references, xinclude nodes, ... */
+        return(0);
+    }
+}
+
+/* libxml2 fails on the relative namespace URIs declared on any element it walks
+ * through, returns 1 if the declarations on @cur are ok or 0 if not supported */
+static int
+xmlSecC14NSubtreeCheckNsDefs(xmlNodePtr cur) {
+    xmlNsPtr ns;
+
+    for(ns = cur->nsDef; ns != NULL; ns = ns->next) {
+        xmlURIPtr uri;
+        int relative;
+
+        if(xmlStrlen(ns->href) == 0) {
+            continue;
+        }
+        if(xmlStrchr(ns->href, '"') != NULL) {
+            return(0);
+        }
+        uri = xmlParseURI((const char*)ns->href);
+        if(uri == NULL) {
+            return(0);
+        }
+        relative = (xmlStrlen(BAD_CAST uri->scheme) == 0);
+        xmlFreeURI(uri);
+        if(relative) {
+            return(0);
+        }
+    }
+    return(1);
+}
+
+static int
+xmlSecC14NSubtreeStartTag(xmlSecC14NSubtreeCtxPtr ctx, xmlNodePtr cur, int isApex) {
+    xmlNsPtr nsList[XMLSEC_C14N_SUBTREE_MAX_ITEMS];
+    xmlAttrPtr attrList[XMLSEC_C14N_SUBTREE_MAX_ITEMS];
+    xmlSecSize nsListSize = 0;
+    xmlSecSize attrListSize = 0;
+    xmlNodePtr node;
+    xmlSecSize ii;
+    int renderEmptyNs;
+    int ret;
+
+    /* the apex ancestors are walked by libxml2 too */
+    for(node = cur; (node != NULL) && (node->type == XML_ELEMENT_NODE); node = node->parent) {
+        if(xmlSecC14NSubtreeCheckNsDefs(node) != 1) {
+            return(0);
+        }
+        if(isApex == 0) {
+            break;
+        }
+    }
+
+    ret = xmlSecC14NSubtreeCollectNs(ctx, cur, isApex, nsList, &nsListSize, &renderEmptyNs);
+    if(ret != 1) {
+        return(ret);
+    }
+    ret = xmlSecC14NSubtreeCollectAttrs(ctx, cur, isApex, attrList, &attrListSize);
+    if(ret != 1) {
+        return(ret);
+    }
+
+    /* start tag */
+    if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "<") < 0) ||
+       (xmlSecC14NSubtreeWriteName(ctx, cur->ns, cur->name) < 0)) {
+        return(-1);
+    }
+    if((renderEmptyNs != 0) && (xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST " xmlns=\"\"") < 0)) {
+        return(-1);
+    }
+    for(ii = 0; ii < nsListSize; ++ii) {
+        if(xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST " xmlns") < 0) {
+            return(-1);
+        }
+        if(nsList[ii]->prefix != NULL) {
+            if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST ":") < 0) ||
+               (xmlSecC14NSubtreeWriteStr(ctx, nsList[ii]->prefix) < 0)) {
+                return(-1);
+            }
+        }
+        if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "=\"") < 0) ||
+           (xmlSecC14NSubtreeWriteStr(ctx, nsList[ii]->href) < 0) ||
+           (xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "\"") < 0)) {
+            return(-1);
+        }
+    }
+    for(ii = 0; ii < attrListSize; ++ii) {
+        xmlAttrPtr attr = attrList[ii];
+
+        /* text only values, libxml2 handles entities */
+        if((attr->children != NULL) &&
+           ((attr->children->type != XML_TEXT_NODE) || (attr->children->next != NULL))) {
+            return(0);
+        }
+        if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST " ") < 0) ||
+           (xmlSecC14NSubtreeWriteName(ctx, attr->ns, attr->name) < 0) ||
+           (xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "=\"") < 0)) {
+            return(-1);
+        }
+        if((attr->children != NULL) &&
+           (xmlSecC14NSubtreeWriteEscaped(ctx, attr->children->content, XMLSEC_C14N_SUBTREE_ATTR) < 0)) {
+            return(-1);
+        }
+        if(xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "\"") < 0) {
+            return(-1);
+        }
+    }
+    if(xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST ">") < 0) {
+        return(-1);
+    }
+    return(1);
+}
+
+static int
+xmlSecC14NSubtreeEndTag(xmlSecC14NSubtreeCtxPtr ctx, xmlNodePtr cur) {
+    if((xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST "</") < 0) ||
+       (xmlSecC14NSubtreeWriteName(ctx, cur->ns, cur->name) < 0) ||
+       (xmlSecC14NSubtreeWriteStr(ctx, BAD_CAST ">") < 0)) {
+        return(-1);
+    }
+    return(1);
+}
+
+static int
+xmlSecC14NSubtreeElement(xmlSecC14NSubtreeCtxPtr ctx, xmlNodePtr cur, int isApex) {
+    xmlSecSize renderedUse = ctx->renderedUse;
+    xmlNodePtr child;
+    int ret;
+
+    ret = xmlSecC14NSubtreeStartTag(ctx, cur, isApex);
+    if(ret != 1) {
+        return(ret);
+    }
+    for(child = cur->children; child != NULL; child = child->next) {
+        ret = xmlSecC14NSubtreeNode(ctx, child);
+        if(ret != 1) {
+            return(ret);
+        }
+    }
+    ret = xmlSecC14NSubtreeEndTag(ctx, cur);
+    if(ret != 1) {
+        return(ret);
+    }
+    ctx->renderedUse = renderedUse;
+    return(1);
+}
+
+/* returns 1 on success or 0 if the transform is not supported */
+static int
+xmlSecC14NSubtreeCtxInitialize(xmlSecC14NSubtreeCtxPtr ctx, xmlSecTransformPtr transform) {
+    xmlSecPtrListPtr nsList;
+
+    memset(ctx, 0, sizeof(xmlSecC14NSubtreeCtx));
+    if(xmlSecTransformCheckId(transform, xmlSecTransformInclC14NId) ||
+       xmlSecTransformCheckId(transform, xmlSecTransformInclC14NWithCommentsId)) {
+        ctx->inheritXmlAttrs = 1;
+    } else if(xmlSecTransformInclC14N11CheckId(transform)) {
+        ctx->inheritXmlAttrs = 0;
+    } else if(xmlSecTransformExclC14NCheckId(transform)) {
+        /* the inclusive namespaces prefix list is left to libxml2 */
+        nsList = xmlSecC14NGetCtx(transform);
+        xmlSecAssert2(nsList != NULL, 0);
+        if(xmlSecPtrListGetSize(nsList) > 0) {
+            return(0);
+        }
+        ctx->exclusive = 1;
+    } else {
+        return(0);
+    }
+    ctx->withComments =
+        xmlSecTransformCheckId(transform, xmlSecTransformInclC14NWithCommentsId) ||
+        xmlSecTransformCheckId(transform, xmlSecTransformInclC14N11WithCommentsId) ||
+        xmlSecTransformCheckId(transform, xmlSecTransformExclC14NWithCommentsId);
+    return(1);
+}
+
+/**
+ * xmlSecTransformC14NExecuteSubtree:
+ * @transform:          the pointer to C14N transform.
+ * @node:               the subtree root element.
+ * @out:                the output buffer.
+ *
+ * Canonicalizes @node and all its descendants (including comments for
+ * the "with comments" transforms) into @out without walking the rest
+ * of the document. Only the simple cases are supported: the caller
+ * should fall back to xmlSecTransformPushXml() if this function returns 0.
+ * The content of @out is undefined in this case.
+ *
+ * Returns: 1 on success, 0 if the transform or the subtree are not
+ * supported or a negative value if an error occurs.
+ */
+int
+xmlSecTransformC14NExecuteSubtree(xmlSecTransformPtr transform, xmlNodePtr node, xmlSecBufferPtr out) {
+    xmlSecC14NSubtreeCtx ctx;
+    int ret;
+
+    xmlSecAssert2(transform != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(node->doc != NULL, -1);
+    xmlSecAssert2(out != NULL, -1);
+
+    if(xmlSecC14NSubtreeCtxInitialize(&ctx, transform) != 1) {
+        return(0);
+    }
+    ctx.out = out;
+
+    if(node->type != XML_ELEMENT_NODE) {
+        return(0);
+    }
+    ret = xmlSecC14NSubtreeElement(&ctx, node, 1);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NSubtreeElement", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    return(ret);
+}
+
+#ifdef LIBXML_READER_ENABLED
+/***************************************************************************
+ *
+ * C14N of the document read by xmlTextReader: the nodes are canonicalized
+ * one by one as the reader returns them, the rendered namespaces stack
+ * for the open elements is kept in the stream.
+ *
+ ***************************************************************************/
+struct _xmlSecTransformC14NStream {
+    xmlSecC14NSubtreeCtx        ctx;
+    xmlSecBuffer                openElements;   /* the saved renderedUse for each open element */
+    int                         afterRoot;
+};
+
+/**
+ * xmlSecTransformC14NStreamCreate:
+ * @transform:          the pointer to C14N transform.
+ *
+ * Creates the streaming canonicalization context for @transform. Only
+ * the inclusive C14N, C14N 1.1 and exclusive C14N (without the inclusive
+ * namespaces prefix list) transforms are supported.
+ *
+ * Returns: the pointer to newly created stream or NULL if an error occurs
+ * or the transform is not supported.
+ */
+xmlSecTransformC14NStreamPtr
+xmlSecTransformC14NStreamCreate(xmlSecTransformPtr transform) {
+    xmlSecTransformC14NStreamPtr stream;
+    int ret;
+
+    xmlSecAssert2(transform != NULL, NULL);
+
+    stream = (xmlSecTransformC14NStreamPtr)xmlMalloc(sizeof(xmlSecTransformC14NStream));
+    if(stream == NULL) {
+        xmlSecMallocError(sizeof(xmlSecTransformC14NStream), xmlSecTransformGetName(transform));
+        return(NULL);
+    }
+    memset(stream, 0, sizeof(xmlSecTransformC14NStream));
+
+    if(xmlSecC14NSubtreeCtxInitialize(&(stream->ctx), transform) != 1) {
+        xmlSecOtherError(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, xmlSecTransformGetName(transform),
+            "streaming canonicalization is not supported for the transform");
+        xmlFree(stream);
+        return(NULL);
+    }
+    ret = xmlSecBufferInitialize(&(stream->openElements), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", xmlSecTransformGetName(transform));
+        xmlFree(stream);
+        return(NULL);
+    }
+    return(stream);
+}
+
+/**
+ * xmlSecTransformC14NStreamDestroy:
+ * @stream:             the pointer to streaming canonicalization context.
+ *
+ * Destroys @stream created with #xmlSecTransformC14NStreamCreate.
+ */
+void
+xmlSecTransformC14NStreamDestroy(xmlSecTransformC14NStreamPtr stream) {
+    xmlSecAssert(stream != NULL);
+
+    xmlSecBufferFinalize(&(stream->openElements));
+    memset(stream, 0, sizeof(xmlSecTransformC14NStream));
+    xmlFree(stream);
+}
+
+/**
+ * xmlSecTransformC14NStreamRead:
+ * @stream:             the pointer to streaming canonicalization context.
+ * @reader:             the reader positioned on the current node.
+ * @out:                the output buffer.
+ *
+ * Appends the canonical form of the reader current node to @out: the
+ * start tag for an element, the end tag for the element end and the
+ * content for the other nodes. The end tag of an empty element
+ * (xmlTextReaderIsEmptyElement()) is not written, the caller should
+ * call #xmlSecTransformC14NStreamEndElement before moving the reader.
+ *
+ * Returns: 0 on success or a negative value if an error occurs or the
+ * node is not supported.
+ */
+int
+xmlSecTransformC14NStreamRead(xmlSecTransformC14NStreamPtr stream, xmlTextReaderPtr reader, xmlSecBufferPtr out) {
+    xmlSecSize renderedUse;
+    xmlNodePtr cur;
+    int isApex;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(reader != NULL, -1);
+    xmlSecAssert2(out != NULL, -1);
+
+    stream->ctx.out = out;
+    switch(xmlTextReaderNodeType(reader)) {
+    case XML_READER_TYPE_ELEMENT:
+        cur = xmlTextReaderCurrentNode(reader);
+        xmlSecAssert2(cur != NULL, -1);
+
+        isApex = (xmlSecBufferGetSize(&(stream->openElements)) == 0) ? 1 : 0;
+        if((isApex != 0) && (stream->afterRoot != 0)) {
+            xmlSecInvalidDataError("second document element", NULL);
+            return(-1);
+        }
+        renderedUse = stream->ctx.renderedUse;
+        ret = xmlSecC14NSubtreeStartTag(&(stream->ctx), cur, isApex);
+        break;
+    case XML_READER_TYPE_END_ELEMENT:
+        return(xmlSecTransformC14NStreamEndElement(stream, reader, out));
+    case XML_READER_TYPE_TEXT:
+    case XML_READER_TYPE_CDATA:
+    case XML_READER_TYPE_WHITESPACE:
+    case XML_READER_TYPE_SIGNIFICANT_WHITESPACE:
+        /* the text outside of the document element is not a part of the document */
+        if(xmlSecBufferGetSize(&(stream->openElements)) == 0) {
+            return(0);
+        }
+        cur = xmlTextReaderCurrentNode(reader);
+        xmlSecAssert2(cur != NULL, -1);
+        ret = xmlSecC14NSubtreeNode(&(stream->ctx), cur);
+        break;
+    case XML_READER_TYPE_COMMENT:
+    case XML_READER_TYPE_PROCESSING_INSTRUCTION:
+        cur = xmlTextReaderCurrentNode(reader);
+        xmlSecAssert2(cur != NULL, -1);
+        if(xmlSecBufferGetSize(&(stream->openElements)) > 0) {
+            ret = xmlSecC14NSubtreeNode(&(stream->ctx), cur);
+            break;
+        }
+
+        /* the document level nodes are separated from the document element by the line breaks */
+        if((cur->type == XML_COMMENT_NODE) && (stream->ctx.withComments == 0)) {
+            return(0);
+        }
+        if((stream->afterRoot != 0) && (xmlSecC14NSubtreeWriteStr(&(stream->ctx), BAD_CAST "\n") < 0)) {
+            return(-1);
+        }
+        ret = xmlSecC14NSubtreeNode(&(stream->ctx), cur);
+        if((ret == 1) && (stream->afterRoot == 0) && (xmlSecC14NSubtreeWriteStr(&(stream->ctx), BAD_CAST "\n") < 0)) {
+            return(-1);
+        }
+        break;
+    case XML_READER_TYPE_DOCUMENT_TYPE:
+    case XML_READER_TYPE_XML_DECLARATION:
+    case XML_READER_TYPE_END_ENTITY:
+        return(0);
+    default:
+        xmlSecOtherError2(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+            "streaming canonicalization is not supported for node type=%d",
+            xmlTextReaderNodeType(reader));
+        return(-1);
+    }
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NSubtreeNode", NULL);
+        return(-1);
+    } else if(ret == 0) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+            "streaming canonicalization is not supported for node=%s",
+            xmlSecErrorsSafeString(xmlTextReaderConstName(reader)));
+        return(-1);
+    }
+
+    /* remember the namespaces rendered before this element */
+    if(xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+        ret = xmlSecBufferAppend(&(stream->openElements), (const xmlSecByte*)&renderedUse, sizeof(renderedUse));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferAppend", NULL);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+/**
+ * xmlSecTransformC14NStreamEndElement:
+ * @stream:             the pointer to streaming canonicalization context.
+ * @reader:             the reader positioned on the element or the element end.
+ * @out:                the output buffer.
+ *
+ * Appends the end tag of the reader current element to @out.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformC14NStreamEndElement(xmlSecTransformC14NStreamPtr stream, xmlTextReaderPtr reader, xmlSecBufferPtr out) {
+    xmlSecSize renderedUse;
+    xmlSecSize size;
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(reader != NULL, -1);
+    xmlSecAssert2(out != NULL, -1);
+
+    size = xmlSecBufferGetSize(&(stream->openElements));
+    if(size < sizeof(renderedUse)) {
+        xmlSecInvalidDataError("unexpected element end", NULL);
+        return(-1);
+    }
+    cur = xmlTextReaderCurrentNode(reader);
+    xmlSecAssert2(cur != NULL, -1);
+
+    stream->ctx.out = out;
+    ret = xmlSecC14NSubtreeEndTag(&(stream->ctx), cur);
+    if(ret != 1) {
+        xmlSecInternalError("xmlSecC14NSubtreeEndTag", NULL);
+        return(-1);
+    }
+
+    size -= sizeof(renderedUse);
+    memcpy(&renderedUse, xmlSecBufferGetData(&(stream->openElements)) + size, sizeof(renderedUse));
+    stream->ctx.renderedUse = renderedUse;
+    ret = xmlSecBufferSetSize(&(stream->openElements), size);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferSetSize", NULL);
+        return(-1);
+    }
+    if(size == 0) {
+        stream->afterRoot = 1;
+    }
+    return(0);
+}
+#endif /* LIBXML_READER_ENABLED */
+
 /***************************************************************************
  *
  * C14N
@@ -428,7 +1282,7 @@ static xmlSecTransformKlass xmlSecTransformInclC14NKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -476,7 +1330,7 @@ static xmlSecTransformKlass xmlSecTransformInclC14NWithCommentsKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -523,7 +1377,7 @@ static xmlSecTransformKlass xmlSecTransformInclC14N11Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -569,7 +1423,7 @@ static xmlSecTransformKlass xmlSecTransformInclC14N11WithCommentsKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -615,7 +1469,7 @@ static xmlSecTransformKlass xmlSecTransformExclC14NKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -661,7 +1515,7 @@ static xmlSecTransformKlass xmlSecTransformExclC14NWithCommentsKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -707,7 +1561,7 @@ static xmlSecTransformKlass xmlSecTransformRemoveXmlTagsC14NKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
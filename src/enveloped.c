@@ -61,7 +61,7 @@ static xmlSecTransformKlass xmlSecTransformEnvelopedKlass = {
     xmlSecTransformDefaultPopXml,               /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecTransformEnvelopedExecute,            /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -625,7 +625,7 @@ static xmlSecTransformKlass xmlSecGCryptAes128CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptBlockCipherExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -664,7 +664,7 @@ static xmlSecTransformKlass xmlSecGCryptAes192CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptBlockCipherExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -703,7 +703,7 @@ static xmlSecTransformKlass xmlSecGCryptAes256CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptBlockCipherExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -745,7 +745,7 @@ static xmlSecTransformKlass xmlSecGCryptDes3CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptBlockCipherExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
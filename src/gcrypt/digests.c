@@ -362,7 +362,7 @@ static xmlSecTransformKlass xmlSecGCryptMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -410,7 +410,7 @@ static xmlSecTransformKlass xmlSecGCryptRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -459,7 +459,7 @@ static xmlSecTransformKlass xmlSecGCryptSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -508,7 +508,7 @@ static xmlSecTransformKlass xmlSecGCryptSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -556,7 +556,7 @@ static xmlSecTransformKlass xmlSecGCryptSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -604,7 +604,7 @@ static xmlSecTransformKlass xmlSecGCryptSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -653,7 +653,7 @@ static xmlSecTransformKlass xmlSecGCryptSha3_256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -699,7 +699,7 @@ static xmlSecTransformKlass xmlSecGCryptSha3_384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -745,7 +745,7 @@ static xmlSecTransformKlass xmlSecGCryptSha3_512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
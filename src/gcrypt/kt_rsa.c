@@ -220,7 +220,7 @@ static xmlSecTransformKlass xmlSecGCryptRsaPkcs1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptRsaPkcs1Execute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -553,7 +553,7 @@ static xmlSecTransformKlass xmlSecGCryptRsaOaepKlass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptRsaOaepExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -592,7 +592,7 @@ static xmlSecTransformKlass xmlSecGCryptRsaOaepEnc11Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptRsaOaepExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
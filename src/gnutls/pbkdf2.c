@@ -385,7 +385,7 @@ static xmlSecTransformKlass xmlSecGnuTLSPbkdf2Klass = {
     NULL,                                           /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSPbkdf2Execute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                           /* void* reserved0; */
+    NULL,                                           /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                           /* void* reserved1; */
 };
 
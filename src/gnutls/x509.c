@@ -48,6 +48,7 @@
 #include "private.h"
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
+#include "../trace_helpers.h"
 
 /*************************************************************************
  *
@@ -1001,6 +1002,7 @@ xmlSecGnuTLSKVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data,
     gnutls_x509_crt_t cert;
     gnutls_x509_crt_t keyCert;
     xmlSecKeyDataPtr keyValue;
+    xmlSecTraceSpan span;
     int ret;
 
     xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecGnuTLSKeyDataX509Id), -1);
@@ -1023,7 +1025,9 @@ xmlSecGnuTLSKVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data,
         xmlSecInternalError("xmlSecKeysMngrGetDataStore", xmlSecKeyDataGetName(data));
         return(-1);
     }
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeX509Verify, keyInfoCtx, NULL, NULL);
     cert = xmlSecGnuTLSX509StoreVerify(x509Store, &(ctx->certsList), &(ctx->crlsList), keyInfoCtx);
+    XMLSEC_TRACE_SPAN_END(&span, 0, (cert != NULL) ? 0 : -1);
     if(cert == NULL) {
         /* check if we want to fail if cert is not found */
         if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_X509DATA_STOP_ON_INVALID_CERT) != 0) {
@@ -1,7 +1,7 @@
 /*
  * XML Security Library (http://www.aleksey.com/xmlsec).
  *
- * Input uri transform and utility functions.
+ * Input uri, output buffer transforms and utility functions.
  *
  * This is free software; see Copyright file in the source
  * distribution for preciese wording.
@@ -23,6 +23,7 @@
 #include <libxml/uri.h>
 #include <libxml/tree.h>
 #include <libxml/xmlIO.h>
+#include <libxml/threads.h>
 
 /* check if we want HTTP and FTP support */
 #ifndef LIBXML_HTTP_ENABLED
@@ -42,6 +43,7 @@
 #endif /* XMLSEC_NO_FTP */
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/buffer.h>
 #include <xmlsec/keys.h>
 #include <xmlsec/transforms.h>
 #include <xmlsec/keys.h>
@@ -49,6 +51,9 @@
 #include <xmlsec/errors.h>
 
 #include "cast_helpers.h"
+#include "registry.h"
+#include "threads.h"
+#include "transform_helpers.h"
 
 /*******************************************************************
  *
@@ -151,7 +156,55 @@ xmlSecIOCallbackPtrListFind(xmlSecPtrListPtr list, const char* uri) {
     return(NULL);
 }
 
-static xmlSecPtrList xmlSecAllIOCallbacks;
+static xmlSecPtrRegistry xmlSecAllIOCallbacks;
+
+static xmlSecIOCallbackPtr
+xmlSecIOCallbackOpen(const xmlChar* uri, void** clbksCtx) {
+    xmlSecPtrListPtr allClbks;
+    xmlSecIOCallbackPtr clbks = NULL;
+
+    xmlSecAssert2(uri != NULL, NULL);
+    xmlSecAssert2(clbksCtx != NULL, NULL);
+
+    (*clbksCtx) = NULL;
+
+    /* use the same snapshot for both lookups */
+    allClbks = xmlSecPtrRegistryGet(&xmlSecAllIOCallbacks);
+    if(allClbks == NULL) {
+        return(NULL);
+    }
+
+    /*
+     * Try to find one of the input accept method accepting that scheme
+     * Go in reverse to give precedence to user defined handlers.
+     * try with an unescaped version of the uri
+     */
+    {
+        char *unescaped;
+
+        unescaped = xmlURIUnescapeString((const char*)uri, 0, NULL);
+        if (unescaped != NULL) {
+            clbks = xmlSecIOCallbackPtrListFind(allClbks, unescaped);
+            if(clbks != NULL) {
+                (*clbksCtx) = clbks->opencallback(unescaped);
+            }
+            xmlFree(unescaped);
+        }
+    }
+
+    /*
+     * If this failed try with a non-escaped uri this may be a strange
+     * filename
+     */
+    if (clbks == NULL) {
+        clbks = xmlSecIOCallbackPtrListFind(allClbks, (const char*)uri);
+        if(clbks != NULL) {
+            (*clbksCtx) = clbks->opencallback((const char*)uri);
+        }
+    }
+
+    return(clbks);
+}
 
 /**
  * xmlSecIOInit:
@@ -165,9 +218,9 @@ int
 xmlSecIOInit(void) {
     int ret;
 
-    ret = xmlSecPtrListInitialize(&xmlSecAllIOCallbacks, xmlSecIOCallbackPtrListId);
+    ret = xmlSecPtrRegistryInitialize(&xmlSecAllIOCallbacks, xmlSecIOCallbackPtrListId);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        xmlSecInternalError("xmlSecPtrRegistryInitialize", NULL);
         return(-1);
     }
 
@@ -206,18 +259,21 @@ xmlSecIOShutdown(void) {
     xmlNanoFTPCleanup();
 #endif /* XMLSEC_NO_FTP */
 
-    xmlSecPtrListFinalize(&xmlSecAllIOCallbacks);
+    xmlSecPtrRegistryFinalize(&xmlSecAllIOCallbacks);
 }
 
 /**
  * xmlSecIOCleanupCallbacks:
  *
  * Clears the entire input callback table. this includes the
- * compiled-in I/O.
+ * compiled-in I/O. The callbacks are released in #xmlSecIOShutdown
+ * since other threads might still use them.
  */
 void
 xmlSecIOCleanupCallbacks(void) {
-    xmlSecPtrListEmpty(&xmlSecAllIOCallbacks);
+    if(xmlSecPtrRegistryEmpty(&xmlSecAllIOCallbacks) < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryEmpty", NULL);
+    }
 }
 
 /**
@@ -246,9 +302,9 @@ xmlSecIORegisterCallbacks(xmlInputMatchCallback matchFunc,
         return(-1);
     }
 
-    ret = xmlSecPtrListAdd(&xmlSecAllIOCallbacks, callbacks);
+    ret = xmlSecPtrRegistryAdd(&xmlSecAllIOCallbacks, callbacks);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        xmlSecInternalError("xmlSecPtrRegistryAdd", NULL);
         xmlSecIOCallbackDestroy(callbacks);
         return(-1);
     }
@@ -299,6 +355,369 @@ xmlSecIORegisterDefaultCallbacks(void) {
     return(0);
 }
 
+/**************************************************************
+ *
+ * External URIs prefetch: the external URIs are read in parallel
+ * (using the registered I/O callbacks) before the actual processing
+ * starts. The I/O callbacks must be thread safe.
+ *
+ **************************************************************/
+typedef enum {
+    xmlSecIOPrefetchStatusPending = 0,
+    xmlSecIOPrefetchStatusRunning,
+    xmlSecIOPrefetchStatusDone,
+    xmlSecIOPrefetchStatusFailed
+} xmlSecIOPrefetchStatus;
+
+#define XMLSEC_IO_PREFETCH_READ_BUFFER_SIZE     4096
+
+typedef struct _xmlSecIOPrefetchItem {
+    xmlChar*                    uri;
+    xmlSecBufferPtr             buffer;
+    xmlSecIOPrefetchStatus      status;
+} xmlSecIOPrefetchItem, *xmlSecIOPrefetchItemPtr;
+
+struct _xmlSecIOPrefetch {
+    xmlSecPtrList               items;
+    xmlSecSize                  maxThreads;
+    xmlMutexPtr                 mutex;
+};
+
+static xmlSecIOPrefetchItemPtr  xmlSecIOPrefetchItemCreate      (const xmlChar* uri);
+static void                     xmlSecIOPrefetchItemDestroy     (xmlSecIOPrefetchItemPtr item);
+static int                      xmlSecIOPrefetchItemRead        (xmlSecIOPrefetchItemPtr item);
+static void                     xmlSecIOPrefetchWorker          (void* data);
+
+static xmlSecPtrListKlass xmlSecIOPrefetchItemPtrListKlass = {
+    BAD_CAST "io-prefetch-list",
+    NULL,                                                   /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecIOPrefetchItemDestroy,/* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                   /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL                                                    /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecIOPrefetchItemPtrListId   (&xmlSecIOPrefetchItemPtrListKlass)
+
+static xmlSecIOPrefetchItemPtr
+xmlSecIOPrefetchItemCreate(const xmlChar* uri) {
+    xmlSecIOPrefetchItemPtr item;
+
+    xmlSecAssert2(uri != NULL, NULL);
+
+    item = (xmlSecIOPrefetchItemPtr)xmlMalloc(sizeof(xmlSecIOPrefetchItem));
+    if(item == NULL) {
+        xmlSecMallocError(sizeof(xmlSecIOPrefetchItem), NULL);
+        return(NULL);
+    }
+    memset(item, 0, sizeof(xmlSecIOPrefetchItem));
+    item->status = xmlSecIOPrefetchStatusPending;
+
+    item->uri = xmlStrdup(uri);
+    if(item->uri == NULL) {
+        xmlSecStrdupError(uri, NULL);
+        xmlSecIOPrefetchItemDestroy(item);
+        return(NULL);
+    }
+    return(item);
+}
+
+static void
+xmlSecIOPrefetchItemDestroy(xmlSecIOPrefetchItemPtr item) {
+    xmlSecAssert(item != NULL);
+
+    if(item->uri != NULL) {
+        xmlFree(item->uri);
+    }
+    if(item->buffer != NULL) {
+        xmlSecBufferDestroy(item->buffer);
+    }
+    memset(item, 0, sizeof(xmlSecIOPrefetchItem));
+    xmlFree(item);
+}
+
+/* The failures are not reported: the URI is simply opened again
+ * later and the errors are reported then. */
+static int
+xmlSecIOPrefetchItemRead(xmlSecIOPrefetchItemPtr item) {
+    xmlSecIOCallbackPtr clbks;
+    void* clbksCtx = NULL;
+    xmlSecByte buf[XMLSEC_IO_PREFETCH_READ_BUFFER_SIZE];
+    xmlSecSize bufSize;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->uri != NULL, -1);
+    xmlSecAssert2(item->buffer == NULL, -1);
+
+    clbks = xmlSecIOCallbackOpen(item->uri, &clbksCtx);
+    if((clbks == NULL) || (clbksCtx == NULL) || (clbks->readcallback == NULL)) {
+        goto done;
+    }
+
+    item->buffer = xmlSecBufferCreate(0);
+    if(item->buffer == NULL) {
+        goto done;
+    }
+
+    while(1) {
+        ret = (clbks->readcallback)(clbksCtx, (char*)buf, (int)sizeof(buf));
+        if(ret < 0) {
+            goto done;
+        } else if(ret == 0) {
+            break;
+        }
+        XMLSEC_SAFE_CAST_INT_TO_SIZE(ret, bufSize, goto done, NULL);
+        if(xmlSecBufferAppend(item->buffer, buf, bufSize) < 0) {
+            goto done;
+        }
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if((clbks != NULL) && (clbksCtx != NULL) && (clbks->closecallback != NULL)) {
+        (clbks->closecallback)(clbksCtx);
+    }
+    if((res < 0) && (item->buffer != NULL)) {
+        xmlSecBufferDestroy(item->buffer);
+        item->buffer = NULL;
+    }
+    return(res);
+}
+
+static void
+xmlSecIOPrefetchWorker(void* data) {
+    xmlSecIOPrefetchPtr prefetch = (xmlSecIOPrefetchPtr)data;
+    xmlSecIOPrefetchItemPtr item;
+    xmlSecSize ii, size;
+    int ret;
+
+    xmlSecAssert(prefetch != NULL);
+    xmlSecAssert(prefetch->mutex != NULL);
+
+    while(1) {
+        /* grab the next pending item */
+        item = NULL;
+        xmlMutexLock(prefetch->mutex);
+        size = xmlSecPtrListGetSize(&(prefetch->items));
+        for(ii = 0; ii < size; ++ii) {
+            xmlSecIOPrefetchItemPtr tmp = (xmlSecIOPrefetchItemPtr)xmlSecPtrListGetItem(&(prefetch->items), ii);
+            if((tmp != NULL) && (tmp->status == xmlSecIOPrefetchStatusPending)) {
+                tmp->status = xmlSecIOPrefetchStatusRunning;
+                item = tmp;
+                break;
+            }
+        }
+        xmlMutexUnlock(prefetch->mutex);
+        if(item == NULL) {
+            break;
+        }
+
+        /* and read it outside of the lock */
+        ret = xmlSecIOPrefetchItemRead(item);
+
+        xmlMutexLock(prefetch->mutex);
+        item->status = (ret >= 0) ? xmlSecIOPrefetchStatusDone : xmlSecIOPrefetchStatusFailed;
+        xmlMutexUnlock(prefetch->mutex);
+    }
+}
+
+/**
+ * xmlSecIOPrefetchCreate:
+ * @maxThreads:         the max number of threads used to read the URIs
+ *                      (0 to use #XMLSEC_IO_PREFETCH_DEFAULT_THREADS).
+ *
+ * Creates the external URIs prefetch object. The caller is responsible
+ * for destroying returned object with #xmlSecIOPrefetchDestroy function.
+ *
+ * Returns: the pointer to newly allocated object or NULL if an error occurs.
+ */
+xmlSecIOPrefetchPtr
+xmlSecIOPrefetchCreate(xmlSecSize maxThreads) {
+    xmlSecIOPrefetchPtr prefetch;
+    int ret;
+
+    prefetch = (xmlSecIOPrefetchPtr)xmlMalloc(sizeof(xmlSecIOPrefetch));
+    if(prefetch == NULL) {
+        xmlSecMallocError(sizeof(xmlSecIOPrefetch), NULL);
+        return(NULL);
+    }
+    memset(prefetch, 0, sizeof(xmlSecIOPrefetch));
+    prefetch->maxThreads = (maxThreads > 0) ? maxThreads : XMLSEC_IO_PREFETCH_DEFAULT_THREADS;
+
+    ret = xmlSecPtrListInitialize(&(prefetch->items), xmlSecIOPrefetchItemPtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        xmlFree(prefetch);
+        return(NULL);
+    }
+
+    prefetch->mutex = xmlNewMutex();
+    if(prefetch->mutex == NULL) {
+        xmlSecXmlError("xmlNewMutex", NULL);
+        xmlSecIOPrefetchDestroy(prefetch);
+        return(NULL);
+    }
+    return(prefetch);
+}
+
+/**
+ * xmlSecIOPrefetchDestroy:
+ * @prefetch:           the pointer to prefetch object.
+ *
+ * Destroys the @prefetch object and all the prefetched data.
+ */
+void
+xmlSecIOPrefetchDestroy(xmlSecIOPrefetchPtr prefetch) {
+    xmlSecAssert(prefetch != NULL);
+
+    xmlSecPtrListFinalize(&(prefetch->items));
+    if(prefetch->mutex != NULL) {
+        xmlFreeMutex(prefetch->mutex);
+    }
+    memset(prefetch, 0, sizeof(xmlSecIOPrefetch));
+    xmlFree(prefetch);
+}
+
+/**
+ * xmlSecIOPrefetchAdd:
+ * @prefetch:           the pointer to prefetch object.
+ * @uri:                the URI (without the fragment part).
+ *
+ * Adds the @uri to the list of URIs to read in the next
+ * #xmlSecIOPrefetchRun call. Duplicate URIs are ignored.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecIOPrefetchAdd(xmlSecIOPrefetchPtr prefetch, const xmlChar* uri) {
+    xmlSecIOPrefetchItemPtr item;
+    xmlSecSize ii, size;
+    int ret;
+
+    xmlSecAssert2(prefetch != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    size = xmlSecPtrListGetSize(&(prefetch->items));
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecIOPrefetchItemPtr)xmlSecPtrListGetItem(&(prefetch->items), ii);
+        if((item != NULL) && xmlStrEqual(item->uri, uri)) {
+            return(0);
+        }
+    }
+
+    item = xmlSecIOPrefetchItemCreate(uri);
+    if(item == NULL) {
+        xmlSecInternalError("xmlSecIOPrefetchItemCreate", NULL);
+        return(-1);
+    }
+    ret = xmlSecPtrListAdd(&(prefetch->items), item);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        xmlSecIOPrefetchItemDestroy(item);
+        return(-1);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecIOPrefetchRun:
+ * @prefetch:           the pointer to prefetch object.
+ *
+ * Reads all the pending URIs using up to maxThreads threads (the current
+ * thread included) and waits until all the reads are finished. A failure
+ * to read an URI is not an error: the URI is opened again when it is
+ * actually used and the error is reported then.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecIOPrefetchRun(xmlSecIOPrefetchPtr prefetch) {
+    xmlSecThreadPtr* threads = NULL;
+    xmlSecIOPrefetchItemPtr item;
+    xmlSecSize ii, size, pending, threadsNum;
+    int ret;
+    int res = 0;
+
+    xmlSecAssert2(prefetch != NULL, -1);
+    xmlSecAssert2(prefetch->mutex != NULL, -1);
+    xmlSecAssert2(prefetch->maxThreads > 0, -1);
+
+    pending = 0;
+    size = xmlSecPtrListGetSize(&(prefetch->items));
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecIOPrefetchItemPtr)xmlSecPtrListGetItem(&(prefetch->items), ii);
+        if((item != NULL) && (item->status == xmlSecIOPrefetchStatusPending)) {
+            ++pending;
+        }
+    }
+    if(pending == 0) {
+        return(0);
+    }
+
+    /* the current thread is a worker too */
+    threadsNum = (pending < prefetch->maxThreads) ? pending : prefetch->maxThreads;
+    if((threadsNum > 1) && (xmlSecThreadsEnabled() != 0)) {
+        threads = (xmlSecThreadPtr*)xmlMalloc(sizeof(xmlSecThreadPtr) * (threadsNum - 1));
+        if(threads == NULL) {
+            xmlSecMallocError(sizeof(xmlSecThreadPtr) * (threadsNum - 1), NULL);
+            return(-1);
+        }
+        memset(threads, 0, sizeof(xmlSecThreadPtr) * (threadsNum - 1));
+
+        for(ii = 0; ii < threadsNum - 1; ++ii) {
+            /* if we can't start a thread then the remaining workers do the job */
+            threads[ii] = xmlSecThreadCreate(xmlSecIOPrefetchWorker, prefetch);
+            if(threads[ii] == NULL) {
+                break;
+            }
+        }
+    }
+
+    xmlSecIOPrefetchWorker(prefetch);
+
+    if(threads != NULL) {
+        for(ii = 0; (ii < threadsNum - 1) && (threads[ii] != NULL); ++ii) {
+            ret = xmlSecThreadJoin(threads[ii]);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecThreadJoin", NULL);
+                res = -1;
+            }
+        }
+        xmlFree(threads);
+    }
+    return(res);
+}
+
+/**
+ * xmlSecIOPrefetchGetBuffer:
+ * @prefetch:           the pointer to prefetch object.
+ * @uri:                the URI (without the fragment part).
+ *
+ * Gets the data read for the @uri by #xmlSecIOPrefetchRun.
+ *
+ * Returns: the pointer to the buffer owned by @prefetch or NULL if
+ * the @uri was not prefetched.
+ */
+xmlSecBufferPtr
+xmlSecIOPrefetchGetBuffer(xmlSecIOPrefetchPtr prefetch, const xmlChar* uri) {
+    xmlSecIOPrefetchItemPtr item;
+    xmlSecSize ii, size;
+
+    xmlSecAssert2(prefetch != NULL, NULL);
+    xmlSecAssert2(uri != NULL, NULL);
+
+    size = xmlSecPtrListGetSize(&(prefetch->items));
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecIOPrefetchItemPtr)xmlSecPtrListGetItem(&(prefetch->items), ii);
+        if((item != NULL) && (item->status == xmlSecIOPrefetchStatusDone) && xmlStrEqual(item->uri, uri)) {
+            return(item->buffer);
+        }
+    }
+    return(NULL);
+}
+
 /**************************************************************
  *
  * Input URI Transform
@@ -311,12 +730,21 @@ typedef struct _xmlSecInputURICtx                               xmlSecInputURICt
 struct _xmlSecInputURICtx {
     xmlSecIOCallbackPtr         clbks;
     void*                       clbksCtx;
+
+    /* prefetched (not owned) or memory mapped data */
+    xmlSecBufferPtr             buffer;
+    xmlSecSize                  bufferPos;
+    xmlSecBufferPtr             mapped;
 };
 
 XMLSEC_TRANSFORM_DECLARE(InputUri, xmlSecInputURICtx)
 #define xmlSecInputUriSize XMLSEC_TRANSFORM_SIZE(InputUri)
 
 static int              xmlSecTransformInputURIInitialize       (xmlSecTransformPtr transform);
+#ifndef XMLSEC_NO_FILES
+static int              xmlSecTransformInputURIOpenMmap         (xmlSecInputURICtxPtr ctx,
+                                                                 const xmlChar* uri);
+#endif /* XMLSEC_NO_FILES */
 static void             xmlSecTransformInputURIFinalize         (xmlSecTransformPtr transform);
 static int              xmlSecTransformInputURIPopBin           (xmlSecTransformPtr transform,
                                                                  xmlSecByte* data,
@@ -347,10 +775,79 @@ static xmlSecTransformKlass xmlSecTransformInputURIKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     NULL,                                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
+#ifndef XMLSEC_NO_FILES
+/* Returns 1 if the file was mapped, 0 if the uri should be opened with
+ * the I/O callbacks or a negative value if an error occurs. */
+static int
+xmlSecTransformInputURIOpenMmap(xmlSecInputURICtxPtr ctx, const xmlChar* uri) {
+    xmlSecIOCallbackPtr clbks;
+    char* unescaped;
+    const char* path;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->mapped == NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    unescaped = xmlURIUnescapeString((const char*)uri, 0, NULL);
+    if(unescaped == NULL) {
+        return(0);
+    }
+
+    /* only if the uri is handled by the default files I/O callbacks */
+    clbks = xmlSecIOCallbackPtrListFind(xmlSecPtrRegistryGet(&xmlSecAllIOCallbacks), unescaped);
+    if((clbks == NULL) || (clbks->opencallback != xmlFileOpen)) {
+        res = 0;
+        goto done;
+    }
+
+    /* same as in xmlFileOpen() */
+    if(xmlStrncasecmp(BAD_CAST unescaped, BAD_CAST "file://localhost/", 17) == 0) {
+        path = unescaped + 16;
+    } else if(xmlStrncasecmp(BAD_CAST unescaped, BAD_CAST "file:///", 8) == 0) {
+        path = unescaped + 7;
+    } else if(xmlStrncasecmp(BAD_CAST unescaped, BAD_CAST "file:", 5) == 0) {
+        res = 0;
+        goto done;
+    } else {
+        path = unescaped;
+    }
+
+    ctx->mapped = xmlSecBufferCreate(0);
+    if(ctx->mapped == NULL) {
+        xmlSecInternalError("xmlSecBufferCreate", NULL);
+        goto done;
+    }
+    ret = xmlSecBufferMapFile(ctx->mapped, path);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferMapFile", NULL,
+                             "filename=%s", xmlSecErrorsSafeString(path));
+        goto done;
+    } else if(ret == 0) {
+        res = 0;
+        goto done;
+    }
+
+    /* success */
+    ctx->buffer = ctx->mapped;
+    ctx->bufferPos = 0;
+    res = 1;
+
+done:
+    if((res <= 0) && (ctx->mapped != NULL)) {
+        xmlSecBufferDestroy(ctx->mapped);
+        ctx->mapped = NULL;
+    }
+    xmlFree(unescaped);
+    return(res);
+}
+#endif /* XMLSEC_NO_FILES */
+
 /**
  * xmlSecTransformInputURIGetKlass:
  *
@@ -375,6 +872,9 @@ xmlSecTransformInputURIGetKlass(void) {
 int
 xmlSecTransformInputURIOpen(xmlSecTransformPtr transform, const xmlChar *uri) {
     xmlSecInputURICtxPtr ctx;
+#ifndef XMLSEC_NO_FILES
+    int ret;
+#endif /* XMLSEC_NO_FILES */
 
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformInputURIId), -1);
     xmlSecAssert2(uri != NULL, -1);
@@ -383,36 +883,23 @@ xmlSecTransformInputURIOpen(xmlSecTransformPtr transform, const xmlChar *uri) {
     xmlSecAssert2(ctx != NULL, -1);
     xmlSecAssert2(ctx->clbks == NULL, -1);
     xmlSecAssert2(ctx->clbksCtx == NULL, -1);
+    xmlSecAssert2(ctx->buffer == NULL, -1);
 
-    /*
-     * Try to find one of the input accept method accepting that scheme
-     * Go in reverse to give precedence to user defined handlers.
-     * try with an unescaped version of the uri
-     */
-    if(ctx->clbks == NULL) {
-        char *unescaped;
-
-        unescaped = xmlURIUnescapeString((char*)uri, 0, NULL);
-        if (unescaped != NULL) {
-            ctx->clbks = xmlSecIOCallbackPtrListFind(&xmlSecAllIOCallbacks, unescaped);
-            if(ctx->clbks != NULL) {
-                ctx->clbksCtx = ctx->clbks->opencallback(unescaped);
-            }
-            xmlFree(unescaped);
-        }
-    }
-
-    /*
-     * If this failed try with a non-escaped uri this may be a strange
-     * filename
-     */
-    if (ctx->clbks == NULL) {
-        ctx->clbks = xmlSecIOCallbackPtrListFind(&xmlSecAllIOCallbacks, (char*)uri);
-        if(ctx->clbks != NULL) {
-            ctx->clbksCtx = ctx->clbks->opencallback((char*)uri);
+#ifndef XMLSEC_NO_FILES
+    /* large local files are memory mapped */
+    if(xmlSecBufferGetMmapThreshold() > 0) {
+        ret = xmlSecTransformInputURIOpenMmap(ctx, uri);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformInputURIOpenMmap", xmlSecTransformGetName(transform),
+                                "uri=%s", xmlSecErrorsSafeString(uri));
+            return(-1);
+        } else if(ret > 0) {
+            return(0);
         }
     }
+#endif /* XMLSEC_NO_FILES */
 
+    ctx->clbks = xmlSecIOCallbackOpen(uri, &(ctx->clbksCtx));
     if((ctx->clbks == NULL) || (ctx->clbksCtx == NULL)) {
         xmlSecInternalError2("ctx->clbks->opencallback", xmlSecTransformGetName(transform),
                             "uri=%s", xmlSecErrorsSafeString(uri));
@@ -423,6 +910,57 @@ xmlSecTransformInputURIOpen(xmlSecTransformPtr transform, const xmlChar *uri) {
 }
 
 
+/**
+ * xmlSecTransformInputURIOpenBuffer:
+ * @transform:          the pointer to IO transform.
+ * @buffer:             the prefetched URI data.
+ *
+ * Opens the prefetched URI data (see #xmlSecIOPrefetchGetBuffer) for reading.
+ * The @buffer is not copied and must stay alive until the @transform
+ * is closed.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformInputURIOpenBuffer(xmlSecTransformPtr transform, xmlSecBufferPtr buffer) {
+    xmlSecInputURICtxPtr ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformInputURIId), -1);
+    xmlSecAssert2(buffer != NULL, -1);
+
+    ctx = xmlSecInputUriGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->clbks == NULL, -1);
+    xmlSecAssert2(ctx->clbksCtx == NULL, -1);
+    xmlSecAssert2(ctx->buffer == NULL, -1);
+
+    ctx->buffer = buffer;
+    ctx->bufferPos = 0;
+    return(0);
+}
+
+/**
+ * xmlSecTransformInputURIGetBuffer:
+ * @transform:          the pointer to IO transform.
+ *
+ * Gets the in-memory (prefetched or memory mapped) data the @transform
+ * was opened on.
+ *
+ * Returns: the pointer to data or NULL if the @transform reads
+ * data using the I/O callbacks.
+ */
+xmlSecBufferPtr
+xmlSecTransformInputURIGetBuffer(xmlSecTransformPtr transform) {
+    xmlSecInputURICtxPtr ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformInputURIId), NULL);
+
+    ctx = xmlSecInputUriGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    return(ctx->buffer);
+}
+
 /**
  * xmlSecTransformInputURIClose:
  * @transform:          the pointer to IO transform.
@@ -446,6 +984,12 @@ xmlSecTransformInputURIClose(xmlSecTransformPtr transform) {
         ctx->clbksCtx = NULL;
         ctx->clbks = NULL;
     }
+    ctx->buffer = NULL;
+    ctx->bufferPos = 0;
+    if(ctx->mapped != NULL) {
+        xmlSecBufferDestroy(ctx->mapped);
+        ctx->mapped = NULL;
+    }
 
     /* done */
     return(0);
@@ -511,8 +1055,189 @@ xmlSecTransformInputURIPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
             return(-1);
         }
         XMLSEC_SAFE_CAST_INT_TO_SIZE(ret, (*dataSize), return(-1), NULL);
+    } else if(ctx->buffer != NULL) {
+        xmlSecSize size;
+
+        size = xmlSecBufferGetSize(ctx->buffer);
+        xmlSecAssert2(ctx->bufferPos <= size, -1);
+
+        (*dataSize) = size - ctx->bufferPos;
+        if((*dataSize) > maxDataSize) {
+            (*dataSize) = maxDataSize;
+        }
+        if((*dataSize) > 0) {
+            memcpy(data, xmlSecBufferGetData(ctx->buffer) + ctx->bufferPos, (*dataSize));
+            ctx->bufferPos += (*dataSize);
+        }
     } else {
         (*dataSize) = 0;
     }
     return(0);
 }
+
+/**************************************************************
+ *
+ * Output Buffer Transform
+ *
+ * xmlSecTransform + xmlSecOutputBufferCtx
+ *
+ **************************************************************/
+typedef struct _xmlSecOutputBufferCtx                           xmlSecOutputBufferCtx,
+                                                                *xmlSecOutputBufferCtxPtr;
+struct _xmlSecOutputBufferCtx {
+    xmlOutputBufferPtr          output;         /* not owned */
+};
+
+XMLSEC_TRANSFORM_DECLARE(OutputBuffer, xmlSecOutputBufferCtx)
+#define xmlSecOutputBufferSize XMLSEC_TRANSFORM_SIZE(OutputBuffer)
+
+static int              xmlSecTransformOutputBufferInitialize   (xmlSecTransformPtr transform);
+static void             xmlSecTransformOutputBufferFinalize     (xmlSecTransformPtr transform);
+static int              xmlSecTransformOutputBufferExecute      (xmlSecTransformPtr transform,
+                                                                 int last,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+
+static xmlSecTransformKlass xmlSecTransformOutputBufferKlass = {
+    /* klass/object sizes */
+    sizeof(xmlSecTransformKlass),               /* xmlSecSize klassSize */
+    xmlSecOutputBufferSize,                     /* xmlSecSize objSize */
+
+    BAD_CAST "output-buffer",                   /* const xmlChar* name; */
+    NULL,                                       /* const xmlChar* href; */
+    0,                                          /* xmlSecAlgorithmUsage usage; */
+
+    xmlSecTransformOutputBufferInitialize,      /* xmlSecTransformInitializeMethod initialize; */
+    xmlSecTransformOutputBufferFinalize,        /* xmlSecTransformFinalizeMethod finalize; */
+    NULL,                                       /* xmlSecTransformNodeReadMethod readNode; */
+    NULL,                                       /* xmlSecTransformNodeWriteMethod writeNode; */
+    NULL,                                       /* xmlSecTransformSetKeyReqMethod setKeyReq; */
+    NULL,                                       /* xmlSecTransformSetKeyMethod setKey; */
+    NULL,                                       /* xmlSecTransformValidateMethod validate; */
+    xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
+    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
+    NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
+    NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
+    xmlSecTransformOutputBufferExecute,         /* xmlSecTransformExecuteMethod execute; */
+
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecTransformOutputBufferGetKlass:
+ *
+ * The output buffer transform klass. Writes the binary data pushed to it
+ * into a libxml2 output buffer as soon as the data arrive and doesn't pass
+ * anything to the next transform.
+ *
+ * Returns: output buffer transform id.
+ */
+xmlSecTransformId
+xmlSecTransformOutputBufferGetKlass(void) {
+    return(&xmlSecTransformOutputBufferKlass);
+}
+
+/**
+ * xmlSecTransformOutputBufferSet:
+ * @transform:          the pointer to output buffer transform.
+ * @output:             the pointer to libxml2 output buffer.
+ *
+ * Sets the output buffer for the @transform. The caller is responsible for
+ * keeping @output alive while the transform is used and for closing it
+ * afterwards.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformOutputBufferSet(xmlSecTransformPtr transform, xmlOutputBufferPtr output) {
+    xmlSecOutputBufferCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufferId), -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    ctx = xmlSecOutputBufferGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->output == NULL, -1);
+
+    ctx->output = output;
+    return(0);
+}
+
+static int
+xmlSecTransformOutputBufferInitialize(xmlSecTransformPtr transform) {
+    xmlSecOutputBufferCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufferId), -1);
+
+    ctx = xmlSecOutputBufferGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    memset(ctx, 0, sizeof(xmlSecOutputBufferCtx));
+    return(0);
+}
+
+static void
+xmlSecTransformOutputBufferFinalize(xmlSecTransformPtr transform) {
+    xmlSecOutputBufferCtxPtr ctx;
+
+    xmlSecAssert(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufferId));
+
+    ctx = xmlSecOutputBufferGetCtx(transform);
+    xmlSecAssert(ctx != NULL);
+
+    memset(ctx, 0, sizeof(xmlSecOutputBufferCtx));
+}
+
+static int
+xmlSecTransformOutputBufferExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecOutputBufferCtxPtr ctx;
+    xmlSecBufferPtr in;
+    xmlSecSize inSize;
+    int inLen;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufferId), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecOutputBufferGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->output != NULL, -1);
+
+    in = &(transform->inBuf);
+    inSize = xmlSecBufferGetSize(in);
+
+    if(transform->status == xmlSecTransformStatusNone) {
+        transform->status = xmlSecTransformStatusWorking;
+    }
+
+    if(transform->status == xmlSecTransformStatusWorking) {
+        if(inSize > 0) {
+            XMLSEC_SAFE_CAST_SIZE_TO_INT(inSize, inLen, return(-1), xmlSecTransformGetName(transform));
+            ret = xmlOutputBufferWrite(ctx->output, inLen, (const char*)xmlSecBufferGetData(in));
+            if(ret < 0) {
+                xmlSecXmlError2("xmlOutputBufferWrite", xmlSecTransformGetName(transform),
+                                "size=" XMLSEC_SIZE_FMT, inSize);
+                return(-1);
+            }
+
+            ret = xmlSecBufferRemoveHead(in, inSize);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecBufferRemoveHead", xmlSecTransformGetName(transform),
+                                     "size=" XMLSEC_SIZE_FMT, inSize);
+                return(-1);
+            }
+        }
+
+        if(last != 0) {
+            transform->status = xmlSecTransformStatusFinished;
+        }
+    } else if(transform->status == xmlSecTransformStatusFinished) {
+        /* the only way we can get here is if there is no input */
+        xmlSecAssert2(inSize == 0, -1);
+    } else {
+        xmlSecInvalidTransfromStatusError(transform);
+        return(-1);
+    }
+    return(0);
+}
@@ -54,8 +54,10 @@
 #include <string.h>
 
 #include <libxml/tree.h>
+#include <libxml/hash.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/base64.h>
 #include <xmlsec/keys.h>
@@ -220,7 +222,7 @@ xmlSecKeyInfoCtxCreate(xmlSecKeysMngrPtr keysMngr) {
     int ret;
 
     /* Allocate a new xmlSecKeyInfoCtx and fill the fields. */
-    keyInfoCtx = (xmlSecKeyInfoCtxPtr)xmlMalloc(sizeof(xmlSecKeyInfoCtx));
+    keyInfoCtx = (xmlSecKeyInfoCtxPtr)xmlSecMalloc(sizeof(xmlSecKeyInfoCtx), xmlSecAllocatorObjectTypeCtx);
     if(keyInfoCtx == NULL) {
         xmlSecMallocError(sizeof(xmlSecKeyInfoCtx), NULL);
         return(NULL);
@@ -247,7 +249,7 @@ xmlSecKeyInfoCtxDestroy(xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlSecAssert(keyInfoCtx != NULL);
 
     xmlSecKeyInfoCtxFinalize(keyInfoCtx);
-    xmlFree(keyInfoCtx);
+    xmlSecFree(keyInfoCtx, sizeof(xmlSecKeyInfoCtx), xmlSecAllocatorObjectTypeCtx);
 }
 
 /**
@@ -473,6 +475,7 @@ xmlSecKeyInfoCtxCopyUserPref(xmlSecKeyInfoCtxPtr dst, xmlSecKeyInfoCtxPtr src) {
     }
     dst->maxEncryptedKeyLevel   = src->maxEncryptedKeyLevel;
 #endif /* XMLSEC_NO_XMLENC */
+    dst->encryptedKeys          = src->encryptedKeys;
 
     /* <dsig:X509Data /> */
 #ifndef XMLSEC_NO_X509
@@ -1566,10 +1569,178 @@ xmlSecKeyDataEncryptedKeyGetKlass(void) {
     return(&xmlSecKeyDataEncryptedKeyKlass);
 }
 
+/**************************************************************************
+ *
+ * The decrypted &lt;enc:EncryptedKey/&gt; elements cache: the items are
+ * found by the serialized element because &lt;dsig:RetrievalMethod/&gt;
+ * reads a new copy of the element every time. The list belongs to the
+ * application, the first item holds the hash index of all the items
+ * to avoid the linear scan.
+ *
+ *************************************************************************/
+typedef struct _xmlSecKeyInfoEncryptedKeyCacheItem      xmlSecKeyInfoEncryptedKeyCacheItem,
+                                                        *xmlSecKeyInfoEncryptedKeyCacheItemPtr;
+struct _xmlSecKeyInfoEncryptedKeyCacheItem {
+    xmlChar*                    content;
+    xmlSecBufferPtr             key;            /* NULL if decryption failed */
+    xmlHashTablePtr             index;          /* the first item only: content -> item */
+};
+
+static void
+xmlSecKeyInfoEncryptedKeyCacheItemDestroy(xmlSecKeyInfoEncryptedKeyCacheItemPtr item) {
+    xmlSecAssert(item != NULL);
+
+    if(item->content != NULL) {
+        xmlFree(item->content);
+    }
+    if(item->key != NULL) {
+        xmlSecBufferDestroy(item->key);
+    }
+    if(item->index != NULL) {
+        xmlHashFree(item->index, NULL);
+    }
+    memset(item, 0, sizeof(xmlSecKeyInfoEncryptedKeyCacheItem));
+    xmlFree(item);
+}
+
+static xmlSecPtrListKlass xmlSecKeyInfoEncryptedKeyCacheKlass = {
+    BAD_CAST "encrypted-key-cache",
+    NULL,                                                               /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecKeyInfoEncryptedKeyCacheItemDestroy, /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                               /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                               /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+/**
+ * xmlSecKeyInfoEncryptedKeyCacheGetKlass:
+ *
+ * The decrypted &lt;enc:EncryptedKey/&gt; elements cache klass. The
+ * application creates the list and sets it in the @encryptedKeys member
+ * of the #xmlSecKeyInfoCtx to decrypt every &lt;enc:EncryptedKey/&gt;
+ * element only once.
+ *
+ * Returns: the decrypted &lt;enc:EncryptedKey/&gt; elements cache klass.
+ */
+xmlSecPtrListId
+xmlSecKeyInfoEncryptedKeyCacheGetKlass(void) {
+    return(&xmlSecKeyInfoEncryptedKeyCacheKlass);
+}
+
+static xmlChar*
+xmlSecKeyInfoEncryptedKeyCacheGetContent(xmlNodePtr node) {
+    xmlBufferPtr buf;
+    xmlChar* res;
+
+    xmlSecAssert2(node != NULL, NULL);
+
+    buf = xmlBufferCreate();
+    if(buf == NULL) {
+        xmlSecXmlError("xmlBufferCreate", NULL);
+        return(NULL);
+    }
+    if(xmlNodeDump(buf, node->doc, node, 0, 0) < 0) {
+        xmlSecXmlError("xmlNodeDump", NULL);
+        xmlBufferFree(buf);
+        return(NULL);
+    }
+    res = xmlStrdup(xmlBufferContent(buf));
+    if(res == NULL) {
+        xmlSecStrdupError(xmlBufferContent(buf), NULL);
+    }
+    xmlBufferFree(buf);
+    return(res);
+}
+
+static xmlSecKeyInfoEncryptedKeyCacheItemPtr
+xmlSecKeyInfoEncryptedKeyCacheFind(xmlSecPtrListPtr cache, const xmlChar* content) {
+    xmlSecKeyInfoEncryptedKeyCacheItemPtr first;
+
+    xmlSecAssert2(xmlSecPtrListCheckId(cache, xmlSecKeyInfoEncryptedKeyCacheId), NULL);
+    xmlSecAssert2(content != NULL, NULL);
+
+    if(xmlSecPtrListGetSize(cache) == 0) {
+        return(NULL);
+    }
+    first = (xmlSecKeyInfoEncryptedKeyCacheItemPtr)xmlSecPtrListGetItem(cache, 0);
+    if((first == NULL) || (first->index == NULL)) {
+        return(NULL);
+    }
+    return((xmlSecKeyInfoEncryptedKeyCacheItemPtr)xmlHashLookup(first->index, content));
+}
+
+/* takes the ownership of @content */
+static int
+xmlSecKeyInfoEncryptedKeyCacheAdd(xmlSecPtrListPtr cache, xmlChar* content, xmlSecBufferPtr key) {
+    xmlSecKeyInfoEncryptedKeyCacheItemPtr item, first;
+    int ret;
+
+    xmlSecAssert2(xmlSecPtrListCheckId(cache, xmlSecKeyInfoEncryptedKeyCacheId), -1);
+    xmlSecAssert2(content != NULL, -1);
+
+    item = (xmlSecKeyInfoEncryptedKeyCacheItemPtr)xmlMalloc(sizeof(xmlSecKeyInfoEncryptedKeyCacheItem));
+    if(item == NULL) {
+        xmlSecMallocError(sizeof(xmlSecKeyInfoEncryptedKeyCacheItem), NULL);
+        xmlFree(content);
+        return(-1);
+    }
+    memset(item, 0, sizeof(xmlSecKeyInfoEncryptedKeyCacheItem));
+    item->content = content;
+
+    if(key != NULL) {
+        item->key = xmlSecBufferCreate(0);
+        if(item->key == NULL) {
+            xmlSecInternalError("xmlSecBufferCreate", NULL);
+            xmlSecKeyInfoEncryptedKeyCacheItemDestroy(item);
+            return(-1);
+        }
+        ret = xmlSecBufferSetData(item->key, xmlSecBufferGetData(key), xmlSecBufferGetSize(key));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferSetData", NULL);
+            xmlSecKeyInfoEncryptedKeyCacheItemDestroy(item);
+            return(-1);
+        }
+    }
+
+    /* the first item owns the index */
+    if(xmlSecPtrListGetSize(cache) == 0) {
+        item->index = xmlHashCreate(0);
+        if(item->index == NULL) {
+            xmlSecXmlError("xmlHashCreate", NULL);
+            xmlSecKeyInfoEncryptedKeyCacheItemDestroy(item);
+            return(-1);
+        }
+        first = item;
+    } else {
+        first = (xmlSecKeyInfoEncryptedKeyCacheItemPtr)xmlSecPtrListGetItem(cache, 0);
+        xmlSecAssert2(first != NULL, -1);
+        xmlSecAssert2(first->index != NULL, -1);
+    }
+    ret = xmlHashAddEntry(first->index, item->content, item);
+    if(ret < 0) {
+        xmlSecXmlError("xmlHashAddEntry", NULL);
+        xmlSecKeyInfoEncryptedKeyCacheItemDestroy(item);
+        return(-1);
+    }
+
+    ret = xmlSecPtrListAdd(cache, item);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        if(first != item) {
+            xmlHashRemoveEntry(first->index, item->content, NULL);
+        }
+        xmlSecKeyInfoEncryptedKeyCacheItemDestroy(item);
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePtr node, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecKeyInfoEncryptedKeyCacheItemPtr item;
+    xmlChar* content = NULL;
     xmlSecBufferPtr result;
     int ret;
+    int res = -1;
 
     xmlSecAssert2(id == xmlSecKeyDataEncryptedKeyId, -1);
     xmlSecAssert2(key != NULL, -1);
@@ -1584,6 +1755,30 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
         return(-1);
     }
 
+    /* the same element might be used for several &lt;enc:EncryptedData/&gt; elements */
+    if(keyInfoCtx->encryptedKeys != NULL) {
+        content = xmlSecKeyInfoEncryptedKeyCacheGetContent(node);
+        if(content == NULL) {
+            xmlSecInternalError("xmlSecKeyInfoEncryptedKeyCacheGetContent", xmlSecKeyDataKlassGetName(id));
+            goto done;
+        }
+        item = xmlSecKeyInfoEncryptedKeyCacheFind(keyInfoCtx->encryptedKeys, content);
+        if(item != NULL) {
+            if(item->key == NULL) {
+                /* see below */
+                if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_ENCKEY_DONT_STOP_ON_FAILED_DECRYPTION) != 0) {
+                    xmlSecOtherError(XMLSEC_ERRORS_R_INVALID_DATA, xmlSecKeyDataKlassGetName(id),
+                        "failed to decrypt the key before");
+                    goto done;
+                }
+                res = 0;
+                goto done;
+            }
+            result = item->key;
+            goto read;
+        }
+    }
+
     /* init Enc context */
     if(keyInfoCtx->encCtx != NULL) {
         xmlSecEncCtxReset(keyInfoCtx->encCtx);
@@ -1591,7 +1786,7 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
         ret = xmlSecKeyInfoCtxCreateEncCtx(keyInfoCtx);
         if(ret < 0) {
             xmlSecInternalError("xmlSecKeyInfoCtxCreateEncCtx", xmlSecKeyDataKlassGetName(id));
-            return(-1);
+            goto done;
         }
     }
     xmlSecAssert2(keyInfoCtx->encCtx != NULL, -1);
@@ -1600,30 +1795,44 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
     ret = xmlSecKeyInfoCtxCopyUserPref(&(keyInfoCtx->encCtx->keyInfoReadCtx), keyInfoCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecKeyInfoCtxCopyUserPref(readCtx)", xmlSecKeyDataKlassGetName(id));
-        return(-1);
+        goto done;
     }
     ret = xmlSecKeyInfoCtxCopyUserPref(&(keyInfoCtx->encCtx->keyInfoWriteCtx), keyInfoCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecKeyInfoCtxCopyUserPref(writeCtx)", xmlSecKeyDataKlassGetName(id));
-        return(-1);
+        goto done;
     }
 
     /* decrypt */
     ++keyInfoCtx->curEncryptedKeyLevel;
     result = xmlSecEncCtxDecryptToBuffer(keyInfoCtx->encCtx, node);
     --keyInfoCtx->curEncryptedKeyLevel;
-    if((result == NULL) || (xmlSecBufferGetData(result) == NULL)) {
+    if((result != NULL) && (xmlSecBufferGetData(result) == NULL)) {
+        result = NULL;
+    }
+    if(content != NULL) {
+        /* the cache takes the content */
+        ret = xmlSecKeyInfoEncryptedKeyCacheAdd(keyInfoCtx->encryptedKeys, content, result);
+        content = NULL;
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecKeyInfoEncryptedKeyCacheAdd", xmlSecKeyDataKlassGetName(id));
+            goto done;
+        }
+    }
+    if(result == NULL) {
         /* We might have multiple EncryptedKey elements, encrypted
          * for different recipients but application can enforce
          * correct enc key.
          */
         if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_ENCKEY_DONT_STOP_ON_FAILED_DECRYPTION) != 0) {
             xmlSecInternalError("xmlSecEncCtxDecryptToBuffer", xmlSecKeyDataKlassGetName(id));
-            return(-1);
+            goto done;
         }
-        return(0);
+        res = 0;
+        goto done;
     }
 
+read:
     ret = xmlSecKeyDataBinRead(keyInfoCtx->keyReq.keyId, key,
                            xmlSecBufferGetData(result),
                            xmlSecBufferGetSize(result),
@@ -1631,10 +1840,17 @@ xmlSecKeyDataEncryptedKeyXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePt
     if(ret < 0) {
         xmlSecInternalError("xmlSecKeyDataBinRead",
                             xmlSecKeyDataKlassGetName(id));
-        return(-1);
+        goto done;
     }
 
-    return(0);
+    /* success */
+    res = 0;
+
+done:
+    if(content != NULL) {
+        xmlFree(content);
+    }
+    return(res);
 }
 
 static int
@@ -22,6 +22,7 @@
 #include <libxml/tree.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/list.h>
 #include <xmlsec/keys.h>
@@ -113,7 +114,7 @@ xmlSecKeyUseWithCreate(const xmlChar* application, const xmlChar* identifier) {
     int ret;
 
     /* Allocate a new xmlSecKeyUseWith and fill the fields. */
-    keyUseWith = (xmlSecKeyUseWithPtr)xmlMalloc(sizeof(xmlSecKeyUseWith));
+    keyUseWith = (xmlSecKeyUseWithPtr)xmlSecMalloc(sizeof(xmlSecKeyUseWith), xmlSecAllocatorObjectTypeKey);
     if(keyUseWith == NULL) {
         xmlSecMallocError(sizeof(xmlSecKeyUseWith), NULL);
         return(NULL);
@@ -182,7 +183,7 @@ xmlSecKeyUseWithDestroy(xmlSecKeyUseWithPtr keyUseWith) {
     xmlSecAssert(keyUseWith != NULL);
 
     xmlSecKeyUseWithFinalize(keyUseWith);
-    xmlFree(keyUseWith);
+    xmlSecFree(keyUseWith, sizeof(xmlSecKeyUseWith), xmlSecAllocatorObjectTypeKey);
 }
 
 /**
@@ -510,7 +511,7 @@ xmlSecKeyCreate(void)  {
     xmlSecKeyPtr key;
 
     /* Allocate a new xmlSecKey and fill the fields. */
-    key = (xmlSecKeyPtr)xmlMalloc(sizeof(xmlSecKey));
+    key = (xmlSecKeyPtr)xmlSecMalloc(sizeof(xmlSecKey), xmlSecAllocatorObjectTypeKey);
     if(key == NULL) {
         xmlSecMallocError(sizeof(xmlSecKey), NULL);
         return(NULL);
@@ -554,7 +555,7 @@ xmlSecKeyDestroy(xmlSecKeyPtr key) {
     xmlSecAssert(key != NULL);
 
     xmlSecKeyEmpty(key);
-    xmlFree(key);
+    xmlSecFree(key, sizeof(xmlSecKey), xmlSecAllocatorObjectTypeKey);
 }
 
 /**
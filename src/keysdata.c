@@ -23,6 +23,7 @@
 #include <libxml/tree.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/keys.h>
 #include <xmlsec/keyinfo.h>
@@ -35,38 +36,42 @@
 
 #include "cast_helpers.h"
 #include "keysdata_helpers.h"
+#include "registry.h"
 
 /**************************************************************************
  *
  * Global xmlSecKeyDataIds list functions
  *
  *************************************************************************/
-static xmlSecPtrList xmlSecAllKeyDataIds;
-static xmlSecPtrList xmlSecEnabledKeyDataIds;
+static xmlSecPtrRegistry xmlSecAllKeyDataIds;
+static xmlSecPtrRegistry xmlSecEnabledKeyDataIds;
 static int xmlSecImportPersistKey = 0;
 
 /**
  * xmlSecKeyDataIdsGet:
  *
- * Gets global registered key data klasses list.
+ * Gets global registered key data klasses list. The returned list is
+ * a read-only snapshot that is safe to use from multiple threads while
+ * new key data klasses are registered.
  *
  * Returns: the pointer to list of all registered key data klasses.
  */
 xmlSecPtrListPtr
 xmlSecKeyDataIdsGet(void) {
-    return(&xmlSecAllKeyDataIds);
+    return(xmlSecPtrRegistryGet(&xmlSecAllKeyDataIds));
 }
 
 /**
  * xmlSecKeyDataIdsGetEnabled:
  *
- * Gets global enabled key data klasses list.
+ * Gets global enabled key data klasses list. The returned list is
+ * a read-only snapshot (see #xmlSecKeyDataIdsGet).
  *
  * Returns: the pointer to list of all enabled key data klasses.
  */
 xmlSecPtrListPtr
 xmlSecKeyDataIdsGetEnabled(void) {
-    return(&xmlSecEnabledKeyDataIds);
+    return(xmlSecPtrRegistryGet(&xmlSecEnabledKeyDataIds));
 }
 
 
@@ -82,15 +87,15 @@ int
 xmlSecKeyDataIdsInit(void) {
     int ret;
 
-    ret = xmlSecPtrListInitialize(&xmlSecAllKeyDataIds, xmlSecKeyDataIdListId);
+    ret = xmlSecPtrRegistryInitialize(&xmlSecAllKeyDataIds, xmlSecKeyDataIdListId);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListInitialize(xmlSecKeyDataIdListId)", NULL);
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(xmlSecKeyDataIdListId)", NULL);
         return(-1);
     }
 
-    ret = xmlSecPtrListInitialize(&xmlSecEnabledKeyDataIds, xmlSecKeyDataIdListId);
+    ret = xmlSecPtrRegistryInitialize(&xmlSecEnabledKeyDataIds, xmlSecKeyDataIdListId);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListInitialize(xmlSecKeyDataIdListId)", NULL);
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(xmlSecKeyDataIdListId)", NULL);
         return(-1);
     }
 
@@ -111,8 +116,8 @@ xmlSecKeyDataIdsInit(void) {
  */
 void
 xmlSecKeyDataIdsShutdown(void) {
-    xmlSecPtrListFinalize(&xmlSecAllKeyDataIds);
-    xmlSecPtrListFinalize(&xmlSecEnabledKeyDataIds);
+    xmlSecPtrRegistryFinalize(&xmlSecAllKeyDataIds);
+    xmlSecPtrRegistryFinalize(&xmlSecEnabledKeyDataIds);
 }
 
 /**
@@ -129,15 +134,15 @@ xmlSecKeyDataIdsRegister(xmlSecKeyDataId id) {
 
     xmlSecAssert2(id != xmlSecKeyDataIdUnknown, -1);
 
-    ret = xmlSecPtrListAdd(&xmlSecAllKeyDataIds, (xmlSecPtr)id);
+    ret = xmlSecPtrRegistryAdd(&xmlSecAllKeyDataIds, (xmlSecPtr)id);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListAdd(&xmlSecAllKeyDataIds)", xmlSecKeyDataKlassGetName(id));
+        xmlSecInternalError("xmlSecPtrRegistryAdd(&xmlSecAllKeyDataIds)", xmlSecKeyDataKlassGetName(id));
         return(-1);
     }
 
-    ret = xmlSecPtrListAdd(&xmlSecEnabledKeyDataIds, (xmlSecPtr)id);
+    ret = xmlSecPtrRegistryAdd(&xmlSecEnabledKeyDataIds, (xmlSecPtr)id);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListAdd(&xmlSecEnabledKeyDataIds)", xmlSecKeyDataKlassGetName(id));
+        xmlSecInternalError("xmlSecPtrRegistryAdd(&xmlSecEnabledKeyDataIds)", xmlSecKeyDataKlassGetName(id));
         return(-1);
     }
 
@@ -158,9 +163,9 @@ xmlSecKeyDataIdsRegisterDisabled(xmlSecKeyDataId id) {
 
     xmlSecAssert2(id != xmlSecKeyDataIdUnknown, -1);
 
-    ret = xmlSecPtrListAdd(&xmlSecAllKeyDataIds, (xmlSecPtr)id);
+    ret = xmlSecPtrRegistryAdd(&xmlSecAllKeyDataIds, (xmlSecPtr)id);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListAdd(&xmlSecAllKeyDataIds)", xmlSecKeyDataKlassGetName(id));
+        xmlSecInternalError("xmlSecPtrRegistryAdd(&xmlSecAllKeyDataIds)", xmlSecKeyDataKlassGetName(id));
         return(-1);
     }
 
@@ -244,7 +249,7 @@ xmlSecKeyDataCreate(xmlSecKeyDataId id)  {
     xmlSecAssert2(id->name != NULL, NULL);
 
     /* Allocate a new xmlSecKeyData and fill the fields. */
-    data = (xmlSecKeyDataPtr)xmlMalloc(id->objSize);
+    data = (xmlSecKeyDataPtr)xmlSecMalloc(id->objSize, xmlSecAllocatorObjectTypeKeyData);
     if(data == NULL) {
         xmlSecMallocError(id->objSize,
                           xmlSecKeyDataKlassGetName(id));
@@ -310,14 +315,17 @@ xmlSecKeyDataDuplicate(xmlSecKeyDataPtr data) {
  */
 void
 xmlSecKeyDataDestroy(xmlSecKeyDataPtr data) {
+    xmlSecSize objSize;
+
     xmlSecAssert(xmlSecKeyDataIsValid(data));
     xmlSecAssert(data->id->objSize > 0);
 
     if(data->id->finalize != NULL) {
         (data->id->finalize)(data);
     }
-    memset(data, 0, data->id->objSize);
-    xmlFree(data);
+    objSize = data->id->objSize;
+    memset(data, 0, objSize);
+    xmlSecFree(data, objSize, xmlSecAllocatorObjectTypeKeyData);
 }
 
 
@@ -3888,7 +3896,7 @@ xmlSecKeyDataStoreCreate(xmlSecKeyDataStoreId id)  {
     xmlSecAssert2(id->objSize > 0, NULL);
 
     /* Allocate a new xmlSecKeyDataStore and fill the fields. */
-    store = (xmlSecKeyDataStorePtr)xmlMalloc(id->objSize);
+    store = (xmlSecKeyDataStorePtr)xmlSecMalloc(id->objSize, xmlSecAllocatorObjectTypeStore);
     if(store == NULL) {
         xmlSecMallocError(id->objSize,
                           xmlSecKeyDataStoreKlassGetName(id));
@@ -3919,14 +3927,17 @@ xmlSecKeyDataStoreCreate(xmlSecKeyDataStoreId id)  {
  */
 void
 xmlSecKeyDataStoreDestroy(xmlSecKeyDataStorePtr store) {
+    xmlSecSize objSize;
+
     xmlSecAssert(xmlSecKeyDataStoreIsValid(store));
     xmlSecAssert(store->id->objSize > 0);
 
     if(store->id->finalize != NULL) {
         (store->id->finalize)(store);
     }
-    memset(store, 0, store->id->objSize);
-    xmlFree(store);
+    objSize = store->id->objSize;
+    memset(store, 0, objSize);
+    xmlSecFree(store, objSize, xmlSecAllocatorObjectTypeStore);
 }
 
 /***********************************************************************
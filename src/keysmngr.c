@@ -22,8 +22,11 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/hash.h>
+#include <libxml/threads.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/list.h>
 #include <xmlsec/keys.h>
@@ -33,6 +36,7 @@
 #include <xmlsec/private.h>
 
 #include "cast_helpers.h"
+#include "registry.h"
 
 /****************************************************************************
  *
@@ -43,7 +47,10 @@
  * xmlSecKeysMngrCreate:
  *
  * Creates new keys manager. Caller is responsible for freeing it with
- * #xmlSecKeysMngrDestroy function.
+ * #xmlSecKeysMngrDestroy function. Once the stores are adopted, the keys
+ * manager can be shared by all the threads: the simple keys store (and the
+ * OpenSSL X509 store) allow lookups concurrently with the keys, certs and
+ * CRLs adoption.
  *
  * Returns: the pointer to newly allocated keys manager or NULL if
  * an error occurs.
@@ -54,7 +61,7 @@ xmlSecKeysMngrCreate(void) {
     int ret;
 
     /* Allocate a new xmlSecKeysMngr and fill the fields. */
-    mngr = (xmlSecKeysMngrPtr)xmlMalloc(sizeof(xmlSecKeysMngr));
+    mngr = (xmlSecKeysMngrPtr)xmlSecMalloc(sizeof(xmlSecKeysMngr), xmlSecAllocatorObjectTypeStore);
     if(mngr == NULL) {
         xmlSecMallocError(sizeof(xmlSecKeysMngr), NULL);
         return(NULL);
@@ -89,7 +96,7 @@ xmlSecKeysMngrDestroy(xmlSecKeysMngrPtr mngr) {
     xmlSecPtrListFinalize(&(mngr->storesList));
 
     memset(mngr, 0, sizeof(xmlSecKeysMngr));
-    xmlFree(mngr);
+    xmlSecFree(mngr, sizeof(xmlSecKeysMngr), xmlSecAllocatorObjectTypeStore);
 }
 
 /**
@@ -153,7 +160,8 @@ xmlSecKeysMngrFindKeyFromX509Data(xmlSecKeysMngrPtr mngr, xmlSecKeyX509DataValue
  * @mngr:               the pointer to keys manager.
  * @store:              the pointer to keys store.
  *
- * Adopts keys store in the keys manager @mngr.
+ * Adopts keys store in the keys manager @mngr. The keys store can not be
+ * replaced after the @mngr is shared with other threads.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
@@ -191,7 +199,8 @@ xmlSecKeysMngrGetKeysStore(xmlSecKeysMngrPtr mngr) {
  * @mngr:               the pointer to keys manager.
  * @store:              the pointer to data store.
  *
- * Adopts data store in the keys manager.
+ * Adopts data store in the keys manager. The data stores can not be
+ * added or replaced after the @mngr is shared with other threads.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
@@ -267,7 +276,7 @@ xmlSecKeyStoreCreate(xmlSecKeyStoreId id)  {
     xmlSecAssert2(id->objSize > 0, NULL);
 
     /* Allocate a new xmlSecKeyStore and fill the fields. */
-    store = (xmlSecKeyStorePtr)xmlMalloc(id->objSize);
+    store = (xmlSecKeyStorePtr)xmlSecMalloc(id->objSize, xmlSecAllocatorObjectTypeStore);
     if(store == NULL) {
         xmlSecMallocError(id->objSize,
                           xmlSecKeyStoreKlassGetName(id));
@@ -297,14 +306,17 @@ xmlSecKeyStoreCreate(xmlSecKeyStoreId id)  {
  */
 void
 xmlSecKeyStoreDestroy(xmlSecKeyStorePtr store) {
+    xmlSecSize objSize;
+
     xmlSecAssert(xmlSecKeyStoreIsValid(store));
     xmlSecAssert(store->id->objSize > 0);
 
     if(store->id->finalize != NULL) {
         (store->id->finalize)(store);
     }
-    memset(store, 0, store->id->objSize);
-    xmlFree(store);
+    objSize = store->id->objSize;
+    memset(store, 0, objSize);
+    xmlSecFree(store, objSize, xmlSecAllocatorObjectTypeStore);
 }
 
 /**
@@ -356,10 +368,24 @@ xmlSecKeyStoreFindKeyFromX509Data(xmlSecKeyStorePtr store, xmlSecKeyX509DataValu
  *
  * Simple Keys Store
  *
- * xmlSecKeyStore + xmlSecPtrList (keys list)
+ * xmlSecKeyStore + xmlSecPtrRegistry (keys list)
+ *
+ * The keys lookups read the current keys list snapshot without locks
+ * and the adopted keys are published in a new snapshot, thus one store
+ * can be shared by all the threads. The store also remembers the
+ * &lt;dsig:KeyInfo/&gt; nodes the keys were loaded from to reload only
+ * the changed keys (see xmlSecSimpleKeysStoreReload()).
  *
  ***************************************************************************/
-XMLSEC_KEY_STORE_DECLARE(SimpleKeysStore, xmlSecPtrList)
+typedef struct _xmlSecSimpleKeysStoreCtx                xmlSecSimpleKeysStoreCtx,
+                                                        *xmlSecSimpleKeysStoreCtxPtr;
+struct _xmlSecSimpleKeysStoreCtx {
+    xmlSecPtrRegistry   keys;
+    xmlSecPtrList       sources;        /* the keys loaded from files */
+    xmlMutexPtr         sourcesMutex;   /* serializes the loads and reloads */
+};
+
+XMLSEC_KEY_STORE_DECLARE(SimpleKeysStore, xmlSecSimpleKeysStoreCtx)
 #define xmlSecSimpleKeysStoreSize XMLSEC_KEY_STORE_SIZE(SimpleKeysStore)
 
 static int                      xmlSecSimpleKeysStoreInitialize (xmlSecKeyStorePtr store);
@@ -397,29 +423,154 @@ xmlSecSimpleKeysStoreGetKlass(void) {
     return(&xmlSecSimpleKeysStoreKlass);
 }
 
+/****************************************************************************
+ *
+ * Simple Keys Store sources: the file and the &lt;dsig:KeyInfo/&gt; node
+ * for each key loaded from a file
+ *
+ ***************************************************************************/
+typedef struct _xmlSecSimpleKeysStoreSource             xmlSecSimpleKeysStoreSource,
+                                                        *xmlSecSimpleKeysStoreSourcePtr;
+struct _xmlSecSimpleKeysStoreSource {
+    xmlChar*            uri;
+    xmlChar*            node;           /* the serialized <dsig:KeyInfo/> node */
+    xmlSecKeyPtr        key;            /* not owned: the key is in the keys registry */
+    int                 used;           /* the node is still in the file */
+    xmlSecSimpleKeysStoreSourcePtr next; /* the next source with the same node (reload only) */
+};
+
+static void             xmlSecSimpleKeysStoreSourceDestroy      (xmlSecPtr ptr);
+
+static xmlSecPtrListKlass xmlSecSimpleKeysStoreSourceListKlass = {
+    BAD_CAST "simple-keys-store-sources",
+    NULL,                                       /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    xmlSecSimpleKeysStoreSourceDestroy,         /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+static xmlSecSimpleKeysStoreSourcePtr
+xmlSecSimpleKeysStoreSourceCreate(const char* uri, xmlChar* node, xmlSecKeyPtr key) {
+    xmlSecSimpleKeysStoreSourcePtr source;
+
+    xmlSecAssert2(uri != NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+    xmlSecAssert2(key != NULL, NULL);
+
+    source = (xmlSecSimpleKeysStoreSourcePtr)xmlSecMalloc(sizeof(xmlSecSimpleKeysStoreSource), xmlSecAllocatorObjectTypeStore);
+    if(source == NULL) {
+        xmlSecMallocError(sizeof(xmlSecSimpleKeysStoreSource), NULL);
+        return(NULL);
+    }
+    memset(source, 0, sizeof(xmlSecSimpleKeysStoreSource));
+
+    source->uri = xmlStrdup(BAD_CAST uri);
+    if(source->uri == NULL) {
+        xmlSecStrdupError(BAD_CAST uri, NULL);
+        xmlSecSimpleKeysStoreSourceDestroy(source);
+        return(NULL);
+    }
+    source->node = node;
+    source->key = key;
+    source->used = 1;
+    return(source);
+}
+
+static void
+xmlSecSimpleKeysStoreSourceDestroy(xmlSecPtr ptr) {
+    xmlSecSimpleKeysStoreSourcePtr source = (xmlSecSimpleKeysStoreSourcePtr)ptr;
+
+    xmlSecAssert(source != NULL);
+
+    if(source->uri != NULL) {
+        xmlFree(source->uri);
+    }
+    if(source->node != NULL) {
+        xmlFree(source->node);
+    }
+    memset(source, 0, sizeof(xmlSecSimpleKeysStoreSource));
+    xmlSecFree(source, sizeof(xmlSecSimpleKeysStoreSource), xmlSecAllocatorObjectTypeStore);
+}
+
+/* the keys loaded from the nodes that are not in the file anymore, sorted */
+typedef struct _xmlSecSimpleKeysStoreRemovedKeys {
+    xmlSecPtr*          keys;
+    xmlSecSize          size;
+} xmlSecSimpleKeysStoreRemovedKeys, *xmlSecSimpleKeysStoreRemovedKeysPtr;
+
+static int
+xmlSecSimpleKeysStoreKeyPtrCmp(const void* a, const void* b) {
+    xmlSecPtr aa = *((const xmlSecPtr*)a);
+    xmlSecPtr bb = *((const xmlSecPtr*)b);
+
+    return((aa < bb) ? -1 : ((aa > bb) ? 1 : 0));
+}
+
+static int
+xmlSecSimpleKeysStoreSourceIsRemovedKey(xmlSecPtr item, void* ctx) {
+    xmlSecSimpleKeysStoreRemovedKeysPtr removed = (xmlSecSimpleKeysStoreRemovedKeysPtr)ctx;
+
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(removed != NULL, -1);
+
+    if(removed->size == 0) {
+        return(0);
+    }
+    return((bsearch(&item, removed->keys, removed->size, sizeof(xmlSecPtr),
+        xmlSecSimpleKeysStoreKeyPtrCmp) != NULL) ? 1 : 0);
+}
+
+static xmlChar*
+xmlSecSimpleKeysStoreNodeDump(xmlNodePtr node) {
+    xmlBufferPtr buffer;
+    xmlChar* res;
+
+    xmlSecAssert2(node != NULL, NULL);
+
+    buffer = xmlBufferCreate();
+    if(buffer == NULL) {
+        xmlSecXmlError("xmlBufferCreate", NULL);
+        return(NULL);
+    }
+    if(xmlNodeDump(buffer, node->doc, node, 0, 0) < 0) {
+        xmlSecXmlError("xmlNodeDump", NULL);
+        xmlBufferFree(buffer);
+        return(NULL);
+    }
+    res = xmlStrdup(xmlBufferContent(buffer));
+    if(res == NULL) {
+        xmlSecStrdupError(xmlBufferContent(buffer), NULL);
+        xmlBufferFree(buffer);
+        return(NULL);
+    }
+    xmlBufferFree(buffer);
+    return(res);
+}
+
 /**
  * xmlSecSimpleKeysStoreAdoptKey:
  * @store:              the pointer to simple keys store.
  * @key:                the pointer to key.
  *
- * Adds @key to the @store.
+ * Adds @key to the @store. The @key is immediately visible to the
+ * lookups running in other threads. The @store owns the @key on success.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
 xmlSecSimpleKeysStoreAdoptKey(xmlSecKeyStorePtr store, xmlSecKeyPtr key) {
-    xmlSecPtrListPtr list;
+    xmlSecSimpleKeysStoreCtxPtr ctx;
     int ret;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
     xmlSecAssert2(key != NULL, -1);
 
-    list = xmlSecSimpleKeysStoreGetCtx(store);
-    xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), -1);
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
 
-    ret = xmlSecPtrListAdd(list, key);
+    ret = xmlSecPtrRegistryAdd(&(ctx->keys), key);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListAdd",
+        xmlSecInternalError("xmlSecPtrRegistryAdd",
                             xmlSecKeyStoreGetName(store));
         return(-1);
     }
@@ -427,23 +578,58 @@ xmlSecSimpleKeysStoreAdoptKey(xmlSecKeyStorePtr store, xmlSecKeyPtr key) {
     return(0);
 }
 
+static int              xmlSecSimpleKeysStoreLoadKeys           (xmlSecKeyStorePtr store,
+                                                                 const char *uri,
+                                                                 int reload);
+static int              xmlSecSimpleKeysStoreSaveKeys           (xmlSecKeyStorePtr store,
+                                                                 xmlSecPtrListPtr list,
+                                                                 const char *filename,
+                                                                 xmlSecKeyDataType type);
+
 /**
  * xmlSecSimpleKeysStoreLoad:
  * @store:              the pointer to simple keys store.
  * @uri:                the filename.
  * @keysMngr:           the pointer to associated keys manager.
  *
- * Reads keys from an XML file.
+ * Reads keys from an XML file. All the keys from the file are
+ * published at once.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
 xmlSecSimpleKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
-                            xmlSecKeysMngrPtr keysMngr) {
+                            xmlSecKeysMngrPtr keysMngr ATTRIBUTE_UNUSED) {
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(uri != NULL, -1);
+    UNREFERENCED_PARAMETER(keysMngr);
+
+    return(xmlSecSimpleKeysStoreLoadKeys(store, uri, 0));
+}
+
+/**
+ * xmlSecSimpleKeysStoreReload:
+ * @store:              the pointer to simple keys store.
+ * @uri:                the filename.
+ * @keysMngr:           the pointer to associated keys manager.
+ *
+ * Reloads keys from an XML file previously loaded with #xmlSecSimpleKeysStoreLoad:
+ * only the keys from the changed or new &lt;dsig:KeyInfo/&gt; nodes are read and
+ * the keys loaded from the nodes that are not in the file anymore are removed.
+ * All the changes are published at once: the operations running in other threads
+ * keep using the keys they already found. The keys added with #xmlSecSimpleKeysStoreAdoptKey
+ * are not affected.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecSimpleKeysStoreReload(xmlSecKeyStorePtr store, const char *uri,
+                            xmlSecKeysMngrPtr keysMngr ATTRIBUTE_UNUSED) {
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(uri != NULL, -1);
+    UNREFERENCED_PARAMETER(keysMngr);
 
-    return(xmlSecSimpleKeysStoreLoad_ex(store, uri, keysMngr,
-        xmlSecSimpleKeysStoreAdoptKey));
+    return(xmlSecSimpleKeysStoreLoadKeys(store, uri, 1));
 }
 
 static int
@@ -474,6 +660,89 @@ xmlSecSimpleKeysStoreEnableAllKeyData(xmlSecKeyInfoCtxPtr keyInfoCtx) {
     return(0);
 }
 
+static int
+xmlSecSimpleKeysStoreReadKey(xmlSecKeyStorePtr store, xmlNodePtr node, xmlSecKeyPtr* key) {
+    xmlSecKeyInfoCtx keyInfoCtx;
+    xmlSecKeyPtr res;
+    int ret;
+
+    xmlSecAssert2(store != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(key != NULL, -1);
+
+    res = xmlSecKeyCreate();
+    if(res == NULL) {
+        xmlSecInternalError("xmlSecKeyCreate", xmlSecKeyStoreGetName(store));
+        return(-1);
+    }
+
+    ret = xmlSecKeyInfoCtxInitialize(&keyInfoCtx, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecKeyInfoCtxInitialize", xmlSecKeyStoreGetName(store));
+        xmlSecKeyDestroy(res);
+        return(-1);
+    }
+
+    keyInfoCtx.mode           = xmlSecKeyInfoModeRead;
+    keyInfoCtx.keysMngr       = NULL;
+    keyInfoCtx.flags          = XMLSEC_KEYINFO_FLAGS_DONT_STOP_ON_KEY_FOUND |
+                                XMLSEC_KEYINFO_FLAGS_X509DATA_DONT_VERIFY_CERTS;
+    keyInfoCtx.keyReq.keyId   = xmlSecKeyDataIdUnknown;
+    keyInfoCtx.keyReq.keyType = xmlSecKeyDataTypeAny;
+    keyInfoCtx.keyReq.keyUsage= xmlSecKeyDataUsageAny;
+
+    /* enable all keydata for store */
+    ret = xmlSecSimpleKeysStoreEnableAllKeyData(&keyInfoCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecSimpleKeysStoreEnableAllKeyData", xmlSecKeyStoreGetName(store));
+        xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+        xmlSecKeyDestroy(res);
+        return(-1);
+    }
+
+    ret = xmlSecKeyInfoNodeRead(node, res, &keyInfoCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecKeyInfoNodeRead", xmlSecKeyStoreGetName(store));
+        xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+        xmlSecKeyDestroy(res);
+        return(-1);
+    }
+    xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+
+    if(!xmlSecKeyIsValid(res)) {
+        /* we have an unknown key in our file, just ignore it */
+        xmlSecKeyDestroy(res);
+        res = NULL;
+    }
+
+    (*key) = res;
+    return(0);
+}
+
+static xmlDocPtr
+xmlSecSimpleKeysStoreParseFile(xmlSecKeyStorePtr store, const char *uri) {
+    xmlDocPtr doc;
+    xmlNodePtr root;
+
+    xmlSecAssert2(store != NULL, NULL);
+    xmlSecAssert2(uri != NULL, NULL);
+
+    doc = xmlParseFile(uri);
+    if(doc == NULL) {
+        xmlSecXmlError2("xmlParseFile", xmlSecKeyStoreGetName(store),
+                        "uri=%s", xmlSecErrorsSafeString(uri));
+        return(NULL);
+    }
+
+    root = xmlDocGetRootElement(doc);
+    if((root == NULL) || (!xmlSecCheckNodeName(root, BAD_CAST "Keys", xmlSecNs))) {
+        xmlSecInvalidNodeError(root, BAD_CAST "Keys", xmlSecKeyStoreGetName(store));
+        xmlFreeDoc(doc);
+        return(NULL);
+    }
+    return(doc);
+}
+
 /**
  * xmlSecSimpleKeysStoreLoad_ex:
  * @store:              the pointer to simple keys store.
@@ -490,10 +759,8 @@ xmlSecSimpleKeysStoreLoad_ex(xmlSecKeyStorePtr store, const char *uri,
                             xmlSecKeysMngrPtr keysMngr ATTRIBUTE_UNUSED,
                             xmlSecSimpleKeysStoreAdoptKeyFunc adoptKeyFunc) {
     xmlDocPtr doc;
-    xmlNodePtr root;
     xmlNodePtr cur;
     xmlSecKeyPtr key;
-    xmlSecKeyInfoCtx keyInfoCtx;
     int ret;
 
     /* don't check store ID here because it might not be simple store ID;
@@ -503,89 +770,262 @@ xmlSecSimpleKeysStoreLoad_ex(xmlSecKeyStorePtr store, const char *uri,
     xmlSecAssert2(adoptKeyFunc != NULL, -1);
     UNREFERENCED_PARAMETER(keysMngr);
 
-    doc = xmlParseFile(uri);
+    doc = xmlSecSimpleKeysStoreParseFile(store, uri);
     if(doc == NULL) {
-        xmlSecXmlError2("xmlParseFile", xmlSecKeyStoreGetName(store),
-                        "uri=%s", xmlSecErrorsSafeString(uri));
+        xmlSecInternalError("xmlSecSimpleKeysStoreParseFile", xmlSecKeyStoreGetName(store));
         return(-1);
     }
 
-    root = xmlDocGetRootElement(doc);
-    if((root == NULL) || (!xmlSecCheckNodeName(root, BAD_CAST "Keys", xmlSecNs))) {
-        xmlSecInvalidNodeError(root, BAD_CAST "Keys", xmlSecKeyStoreGetName(store));
+    cur = xmlSecGetNextElementNode(xmlDocGetRootElement(doc)->children);
+    while((cur != NULL) && xmlSecCheckNodeName(cur, xmlSecNodeKeyInfo, xmlSecDSigNs)) {
+        key = NULL;
+        ret = xmlSecSimpleKeysStoreReadKey(store, cur, &key);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecSimpleKeysStoreReadKey", xmlSecKeyStoreGetName(store));
+            xmlFreeDoc(doc);
+            return(-1);
+        }
+
+        if(key != NULL) {
+            ret = adoptKeyFunc(store, key);
+            if(ret < 0) {
+                xmlSecInternalError("adoptKeyFunc", xmlSecKeyStoreGetName(store));
+                xmlSecKeyDestroy(key);
+                xmlFreeDoc(doc);
+                return(-1);
+            }
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+
+    if(cur != NULL) {
+        xmlSecUnexpectedNodeError(cur, xmlSecKeyStoreGetName(store));
         xmlFreeDoc(doc);
         return(-1);
     }
 
-    cur = xmlSecGetNextElementNode(root->children);
-    while((cur != NULL) && xmlSecCheckNodeName(cur, xmlSecNodeKeyInfo, xmlSecDSigNs)) {
-        key = xmlSecKeyCreate();
-        if(key == NULL) {
-            xmlSecInternalError("xmlSecKeyCreate", xmlSecKeyStoreGetName(store));
-            xmlFreeDoc(doc);
+    xmlFreeDoc(doc);
+    return(0);
+
+}
+
+/* the caller must hold the sources mutex */
+static int
+xmlSecSimpleKeysStoreLoadKeysFromDoc(xmlSecKeyStorePtr store, xmlSecSimpleKeysStoreCtxPtr ctx,
+    const char *uri, xmlDocPtr doc, int reload, xmlSecPtrListPtr keys
+) {
+    xmlSecSimpleKeysStoreSourcePtr source;
+    xmlSecSimpleKeysStoreRemovedKeys removed;
+    xmlHashTablePtr nodes = NULL;
+    xmlNodePtr cur;
+    xmlChar* node;
+    xmlSecKeyPtr key;
+    xmlSecSize ii, size;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(store != NULL, -1);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+    xmlSecAssert2(doc != NULL, -1);
+    xmlSecAssert2(keys != NULL, -1);
+
+    memset(&removed, 0, sizeof(removed));
+    size = xmlSecPtrListGetSize(&(ctx->sources));
+
+    /* the nodes we find in the file again are marked as used, the
+     * previously loaded nodes are found by the serialized node hash */
+    if(reload != 0) {
+        nodes = xmlHashCreate(0);
+        if(nodes == NULL) {
+            xmlSecXmlError("xmlHashCreate", xmlSecKeyStoreGetName(store));
             return(-1);
         }
-
-        ret = xmlSecKeyInfoCtxInitialize(&keyInfoCtx, NULL);
+    }
+    for(ii = 0; ii < size; ++ii) {
+        source = (xmlSecSimpleKeysStoreSourcePtr)xmlSecPtrListGetItem(&(ctx->sources), ii);
+        if((source == NULL) || (!xmlStrEqual(source->uri, BAD_CAST uri))) {
+            continue;
+        }
+        if(nodes == NULL) {
+            source->used = 1;
+            continue;
+        }
+        source->used = 0;
+        source->next = (xmlSecSimpleKeysStoreSourcePtr)xmlHashLookup(nodes, source->node);
+        ret = xmlHashUpdateEntry(nodes, source->node, source, NULL);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecKeyInfoCtxInitialize", xmlSecKeyStoreGetName(store));
-            xmlSecKeyDestroy(key);
-            xmlFreeDoc(doc);
-            return(-1);
+            xmlSecXmlError("xmlHashUpdateEntry", xmlSecKeyStoreGetName(store));
+            goto done;
         }
+    }
 
-        keyInfoCtx.mode           = xmlSecKeyInfoModeRead;
-        keyInfoCtx.keysMngr       = NULL;
-        keyInfoCtx.flags          = XMLSEC_KEYINFO_FLAGS_DONT_STOP_ON_KEY_FOUND |
-                                    XMLSEC_KEYINFO_FLAGS_X509DATA_DONT_VERIFY_CERTS;
-        keyInfoCtx.keyReq.keyId   = xmlSecKeyDataIdUnknown;
-        keyInfoCtx.keyReq.keyType = xmlSecKeyDataTypeAny;
-        keyInfoCtx.keyReq.keyUsage= xmlSecKeyDataUsageAny;
+    cur = xmlSecGetNextElementNode(xmlDocGetRootElement(doc)->children);
+    while((cur != NULL) && xmlSecCheckNodeName(cur, xmlSecNodeKeyInfo, xmlSecDSigNs)) {
+        node = xmlSecSimpleKeysStoreNodeDump(cur);
+        if(node == NULL) {
+            xmlSecInternalError("xmlSecSimpleKeysStoreNodeDump", xmlSecKeyStoreGetName(store));
+            goto done;
+        }
 
-        /* enable all keydata for store */
-        ret = xmlSecSimpleKeysStoreEnableAllKeyData(&keyInfoCtx);
-        if(ret < 0) {
-            xmlSecInternalError("xmlSecSimpleKeysStoreEnableAllKeyData", xmlSecKeyStoreGetName(store));
-            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
-            xmlSecKeyDestroy(key);
-            xmlFreeDoc(doc);
-            return(-1);
+        /* is the node unchanged? */
+        source = (nodes != NULL) ? (xmlSecSimpleKeysStoreSourcePtr)xmlHashLookup(nodes, node) : NULL;
+        while((source != NULL) && (source->used != 0)) {
+            source = source->next;
+        }
+        if(source != NULL) {
+            source->used = 1;
+            xmlFree(node);
+            cur = xmlSecGetNextElementNode(cur->next);
+            continue;
         }
 
-        ret = xmlSecKeyInfoNodeRead(cur, key, &keyInfoCtx);
+        /* new or changed node */
+        key = NULL;
+        ret = xmlSecSimpleKeysStoreReadKey(store, cur, &key);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecKeyInfoNodeRead", xmlSecKeyStoreGetName(store));
-            xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
+            xmlSecInternalError("xmlSecSimpleKeysStoreReadKey", xmlSecKeyStoreGetName(store));
+            xmlFree(node);
+            goto done;
+        }
+        if(key == NULL) {
+            xmlFree(node);
+            cur = xmlSecGetNextElementNode(cur->next);
+            continue;
+        }
+        ret = xmlSecPtrListAdd(keys, key);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", xmlSecKeyStoreGetName(store));
             xmlSecKeyDestroy(key);
-            xmlFreeDoc(doc);
-            return(-1);
+            xmlFree(node);
+            goto done;
         }
-        xmlSecKeyInfoCtxFinalize(&keyInfoCtx);
 
-        if(xmlSecKeyIsValid(key)) {
-            ret = adoptKeyFunc(store, key);
-            if(ret < 0) {
-                xmlSecInternalError("adoptKeyFunc", xmlSecKeyStoreGetName(store));
-                xmlSecKeyDestroy(key);
-                xmlFreeDoc(doc);
-                return(-1);
-            }
-        } else {
-            /* we have an unknown key in our file, just ignore it */
-            xmlSecKeyDestroy(key);
+        source = xmlSecSimpleKeysStoreSourceCreate(uri, node, key);
+        if(source == NULL) {
+            xmlSecInternalError("xmlSecSimpleKeysStoreSourceCreate", xmlSecKeyStoreGetName(store));
+            xmlFree(node);
+            goto done;
         }
+        ret = xmlSecPtrListAdd(&(ctx->sources), source);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", xmlSecKeyStoreGetName(store));
+            xmlSecSimpleKeysStoreSourceDestroy(source);
+            goto done;
+        }
+
         cur = xmlSecGetNextElementNode(cur->next);
     }
 
     if(cur != NULL) {
         xmlSecUnexpectedNodeError(cur, xmlSecKeyStoreGetName(store));
+        goto done;
+    }
+
+    /* collect the keys from the removed nodes */
+    if(nodes != NULL) {
+        removed.keys = (xmlSecPtr*)xmlMalloc(sizeof(xmlSecPtr) * (size + 1));
+        if(removed.keys == NULL) {
+            xmlSecMallocError(sizeof(xmlSecPtr) * (size + 1), xmlSecKeyStoreGetName(store));
+            goto done;
+        }
+        for(ii = 0; ii < size; ++ii) {
+            source = (xmlSecSimpleKeysStoreSourcePtr)xmlSecPtrListGetItem(&(ctx->sources), ii);
+            if((source != NULL) && (source->used == 0)) {
+                removed.keys[removed.size++] = source->key;
+            }
+        }
+        qsort(removed.keys, removed.size, sizeof(xmlSecPtr), xmlSecSimpleKeysStoreKeyPtrCmp);
+    }
+
+    /* publish all the changes at once */
+    ret = xmlSecPtrRegistryUpdate(&(ctx->keys), keys,
+        (nodes != NULL) ? xmlSecSimpleKeysStoreSourceIsRemovedKey : NULL,
+        &removed);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryUpdate", xmlSecKeyStoreGetName(store));
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(nodes != NULL) {
+        xmlHashFree(nodes, NULL);
+    }
+    if(removed.keys != NULL) {
+        xmlFree(removed.keys);
+    }
+    return(res);
+}
+
+static int
+xmlSecSimpleKeysStoreLoadKeys(xmlSecKeyStorePtr store, const char *uri, int reload) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+    xmlSecSimpleKeysStoreSourcePtr source;
+    xmlSecPtrList keys;
+    xmlDocPtr doc;
+    xmlSecSize sourcesSize, ii, jj;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->sourcesMutex != NULL, -1);
+
+    doc = xmlSecSimpleKeysStoreParseFile(store, uri);
+    if(doc == NULL) {
+        xmlSecInternalError("xmlSecSimpleKeysStoreParseFile", xmlSecKeyStoreGetName(store));
+        return(-1);
+    }
+
+    ret = xmlSecPtrListInitialize(&keys, xmlSecKeyPtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", xmlSecKeyStoreGetName(store));
         xmlFreeDoc(doc);
         return(-1);
     }
 
-    xmlFreeDoc(doc);
-    return(0);
+    xmlMutexLock(ctx->sourcesMutex);
+    sourcesSize = xmlSecPtrListGetSize(&(ctx->sources));
+
+    ret = xmlSecSimpleKeysStoreLoadKeysFromDoc(store, ctx, uri, doc, reload, &keys);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecSimpleKeysStoreLoadKeysFromDoc", xmlSecKeyStoreGetName(store));
 
+        /* the keys were not published: forget the new sources */
+        while(xmlSecPtrListGetSize(&(ctx->sources)) > sourcesSize) {
+            xmlSecPtrListRemove(&(ctx->sources), xmlSecPtrListGetSize(&(ctx->sources)) - 1);
+        }
+        goto done;
+    }
+
+    /* forget the sources of the removed keys */
+    for(ii = jj = 0; ii < ctx->sources.use; ++ii) {
+        source = (xmlSecSimpleKeysStoreSourcePtr)ctx->sources.data[ii];
+        if((source != NULL) && (source->used == 0)) {
+            xmlSecSimpleKeysStoreSourceDestroy(source);
+        } else {
+            ctx->sources.data[jj++] = source;
+        }
+    }
+    for(ii = jj; ii < ctx->sources.use; ++ii) {
+        ctx->sources.data[ii] = NULL;
+    }
+    ctx->sources.use = jj;
+
+    /* success */
+    res = 0;
+
+done:
+    xmlMutexUnlock(ctx->sourcesMutex);
+    xmlSecPtrListFinalize(&keys);
+    xmlFreeDoc(doc);
+    return(res);
 }
 
 /**
@@ -600,8 +1040,28 @@ xmlSecSimpleKeysStoreLoad_ex(xmlSecKeyStorePtr store, const char *uri,
  */
 int
 xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecKeyDataType type) {
-    xmlSecKeyInfoCtx keyInfoCtx;
     xmlSecPtrListPtr list;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
+    xmlSecAssert2(filename != NULL, -1);
+
+    list = xmlSecSimpleKeysStoreGetKeysSnapshot(store);
+    if(list == NULL) {
+        xmlSecInternalError("xmlSecSimpleKeysStoreGetKeysSnapshot", xmlSecKeyStoreGetName(store));
+        xmlSecSimpleKeysStoreReleaseKeysSnapshot(store, list);
+        return(-1);
+    }
+    ret = xmlSecSimpleKeysStoreSaveKeys(store, list, filename, type);
+    xmlSecSimpleKeysStoreReleaseKeysSnapshot(store, list);
+    return(ret);
+}
+
+static int
+xmlSecSimpleKeysStoreSaveKeys(xmlSecKeyStorePtr store, xmlSecPtrListPtr list,
+    const char *filename, xmlSecKeyDataType type
+) {
+    xmlSecKeyInfoCtx keyInfoCtx;
     xmlSecKeyPtr key;
     xmlSecSize i, keysSize;
     xmlDocPtr doc;
@@ -612,11 +1072,9 @@ xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecK
     xmlSecSize idsSize, j;
     int ret;
 
-    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
-    xmlSecAssert2(filename != NULL, -1);
-
-    list = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(store != NULL, -1);
     xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), -1);
+    xmlSecAssert2(filename != NULL, -1);
 
     /* create doc */
     doc = xmlSecCreateTree(BAD_CAST "Keys", xmlSecNs);
@@ -723,73 +1181,155 @@ xmlSecSimpleKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecK
  * xmlSecSimpleKeysStoreGetKeys:
  * @store:              the pointer to simple keys store.
  *
- * Gets list of keys from simple keys store.
+ * Gets the current snapshot of the keys list from simple keys store.
+ * The snapshot is read-only: use #xmlSecSimpleKeysStoreAdoptKey to
+ * add keys. The keys adopted after this call are not in the snapshot.
+ * The snapshot stays valid until the @store is destroyed or reloaded
+ * with #xmlSecSimpleKeysStoreReload: if the @store might be reloaded,
+ * then use #xmlSecSimpleKeysStoreGetKeysSnapshot instead.
  *
  * Returns: pointer to the list of keys stored in the keys store or NULL
  * if an error occurs.
  */
 xmlSecPtrListPtr
 xmlSecSimpleKeysStoreGetKeys(xmlSecKeyStorePtr store) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
     xmlSecPtrListPtr list;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
 
-    list = xmlSecSimpleKeysStoreGetCtx(store);
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    list = xmlSecPtrRegistryGet(&(ctx->keys));
     xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), NULL);
 
     return list;
 }
 
+/**
+ * xmlSecSimpleKeysStoreGetKeysSnapshot:
+ * @store:              the pointer to simple keys store.
+ *
+ * Gets the current snapshot of the keys list from simple keys store.
+ * The snapshot is read-only and the keys in it are not destroyed by
+ * #xmlSecSimpleKeysStoreReload until #xmlSecSimpleKeysStoreReleaseKeysSnapshot
+ * is called. Every call to this function must be paired with
+ * #xmlSecSimpleKeysStoreReleaseKeysSnapshot, even if it returns NULL.
+ *
+ * Returns: pointer to the list of keys stored in the keys store or NULL
+ * if an error occurs.
+ */
+xmlSecPtrListPtr
+xmlSecSimpleKeysStoreGetKeysSnapshot(xmlSecKeyStorePtr store) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    return(xmlSecPtrRegistryReadBegin(&(ctx->keys)));
+}
+
+/**
+ * xmlSecSimpleKeysStoreReleaseKeysSnapshot:
+ * @store:              the pointer to simple keys store.
+ * @list:               the keys list returned by #xmlSecSimpleKeysStoreGetKeysSnapshot
+ *                      (might be NULL).
+ *
+ * Releases the keys list snapshot returned by #xmlSecSimpleKeysStoreGetKeysSnapshot.
+ */
+void
+xmlSecSimpleKeysStoreReleaseKeysSnapshot(xmlSecKeyStorePtr store, xmlSecPtrListPtr list) {
+    xmlSecSimpleKeysStoreCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId));
+
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecPtrRegistryReadEnd(&(ctx->keys), list);
+}
+
 static int
 xmlSecSimpleKeysStoreInitialize(xmlSecKeyStorePtr store) {
-    xmlSecPtrListPtr list;
+    xmlSecSimpleKeysStoreCtxPtr ctx;
     int ret;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), -1);
 
-    list = xmlSecSimpleKeysStoreGetCtx(store);
-    xmlSecAssert2(list != NULL, -1);
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    memset(ctx, 0, sizeof(xmlSecSimpleKeysStoreCtx));
+
+    ret = xmlSecPtrRegistryInitialize(&(ctx->keys), xmlSecKeyPtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(xmlSecKeyPtrListId)",
+                            xmlSecKeyStoreGetName(store));
+        return(-1);
+    }
 
-    ret = xmlSecPtrListInitialize(list, xmlSecKeyPtrListId);
+    ret = xmlSecPtrListInitialize(&(ctx->sources), &xmlSecSimpleKeysStoreSourceListKlass);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListInitialize(xmlSecKeyPtrListId)",
+        xmlSecInternalError("xmlSecPtrListInitialize(sources)",
                             xmlSecKeyStoreGetName(store));
         return(-1);
     }
 
+    ctx->sourcesMutex = xmlNewMutex();
+    if(ctx->sourcesMutex == NULL) {
+        xmlSecXmlError("xmlNewMutex", xmlSecKeyStoreGetName(store));
+        return(-1);
+    }
+
     return(0);
 }
 
 static void
 xmlSecSimpleKeysStoreFinalize(xmlSecKeyStorePtr store) {
-    xmlSecPtrListPtr list;
+    xmlSecSimpleKeysStoreCtxPtr ctx;
 
     xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId));
 
-    list = xmlSecSimpleKeysStoreGetCtx(store);
-    xmlSecAssert(list != NULL);
+    ctx = xmlSecSimpleKeysStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
 
-    xmlSecPtrListFinalize(list);
+    if(ctx->sourcesMutex != NULL) {
+        xmlFreeMutex(ctx->sourcesMutex);
+    }
+    if(ctx->sources.id != NULL) {
+        xmlSecPtrListFinalize(&(ctx->sources));
+    }
+    xmlSecPtrRegistryFinalize(&(ctx->keys));
+    memset(ctx, 0, sizeof(xmlSecSimpleKeysStoreCtx));
 }
 
 static xmlSecKeyPtr
 xmlSecSimpleKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name, xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlSecPtrListPtr list;
     xmlSecKeyPtr key;
+    xmlSecKeyPtr res = NULL;
     xmlSecSize pos, size;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecSimpleKeysStoreId), NULL);
     xmlSecAssert2(keyInfoCtx != NULL, NULL);
 
-    list = xmlSecSimpleKeysStoreGetCtx(store);
-    xmlSecAssert2(xmlSecPtrListCheckId(list, xmlSecKeyPtrListId), NULL);
+    list = xmlSecSimpleKeysStoreGetKeysSnapshot(store);
+    if(list == NULL) {
+        xmlSecInternalError("xmlSecSimpleKeysStoreGetKeysSnapshot", xmlSecKeyStoreGetName(store));
+        xmlSecSimpleKeysStoreReleaseKeysSnapshot(store, list);
+        return(NULL);
+    }
 
     size = xmlSecPtrListGetSize(list);
     for(pos = 0; pos < size; ++pos) {
         key = (xmlSecKeyPtr)xmlSecPtrListGetItem(list, pos);
         if((key != NULL) && (xmlSecKeyMatch(key, name, &(keyInfoCtx->keyReq)) == 1)) {
-            return(xmlSecKeyDuplicate(key));
+            res = xmlSecKeyDuplicate(key);
+            break;
         }
     }
-    return(NULL);
+    xmlSecSimpleKeysStoreReleaseKeysSnapshot(store, list);
+    return(res);
 }
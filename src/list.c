@@ -21,6 +21,7 @@
 #include <libxml/tree.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/list.h>
 #include <xmlsec/errors.h>
 
@@ -41,6 +42,7 @@ static xmlSecSize gInitialSize = 64;
  */
 void
 xmlSecPtrListSetDefaultAllocMode(xmlSecAllocMode defAllocMode, xmlSecSize defInitialSize) {
+    xmlSecAssert(defAllocMode != xmlSecAllocModeMmap);
     xmlSecAssert(defInitialSize > 0);
 
     gAllocMode = defAllocMode;
@@ -64,7 +66,7 @@ xmlSecPtrListCreate(xmlSecPtrListId id) {
     xmlSecAssert2(id != xmlSecPtrListIdUnknown, NULL);
 
     /* Allocate a new xmlSecPtrList and fill the fields. */
-    list = (xmlSecPtrListPtr)xmlMalloc(sizeof(xmlSecPtrList));
+    list = (xmlSecPtrListPtr)xmlSecMalloc(sizeof(xmlSecPtrList), xmlSecAllocatorObjectTypeList);
     if(list == NULL) {
         xmlSecMallocError(sizeof(xmlSecPtrList),
                           xmlSecPtrListKlassGetName(id));
@@ -75,7 +77,7 @@ xmlSecPtrListCreate(xmlSecPtrListId id) {
     if(ret < 0) {
         xmlSecInternalError("xmlSecPtrListInitialize",
                             xmlSecPtrListKlassGetName(id));
-        xmlFree(list);
+        xmlSecFree(list, sizeof(xmlSecPtrList), xmlSecAllocatorObjectTypeList);
         return(NULL);
     }
 
@@ -92,7 +94,7 @@ void
 xmlSecPtrListDestroy(xmlSecPtrListPtr list) {
     xmlSecAssert(xmlSecPtrListIsValid(list));
     xmlSecPtrListFinalize(list);
-    xmlFree(list);
+    xmlSecFree(list, sizeof(xmlSecPtrList), xmlSecAllocatorObjectTypeList);
 }
 
 /**
@@ -156,7 +158,7 @@ xmlSecPtrListEmpty(xmlSecPtrListPtr list) {
         xmlSecAssert(list->data != NULL);
 
         memset(list->data, 0, sizeof(xmlSecPtr) * list->use);
-        xmlFree(list->data);
+        xmlSecFree(list->data, sizeof(xmlSecPtr) * list->max, xmlSecAllocatorObjectTypeList);
     }
     list->max = list->use = 0;
     list->data = NULL;
@@ -481,6 +483,7 @@ xmlSecPtrListEnsureSize(xmlSecPtrListPtr list, xmlSecSize size) {
             newSize = size + 8;
             break;
         case xmlSecAllocModeDouble:
+        case xmlSecAllocModeMmap: /* not used by lists */
             newSize = 2 * size + 32;
             break;
     }
@@ -490,9 +493,10 @@ xmlSecPtrListEnsureSize(xmlSecPtrListPtr list, xmlSecSize size) {
     }
 
     if(list->data != NULL) {
-        newData = (xmlSecPtr*)xmlRealloc(list->data, sizeof(xmlSecPtr) * newSize);
+        newData = (xmlSecPtr*)xmlSecRealloc(list->data, sizeof(xmlSecPtr) * list->max,
+            sizeof(xmlSecPtr) * newSize, xmlSecAllocatorObjectTypeList);
     } else {
-        newData = (xmlSecPtr*)xmlMalloc(sizeof(xmlSecPtr) * newSize);
+        newData = (xmlSecPtr*)xmlSecMalloc(sizeof(xmlSecPtr) * newSize, xmlSecAllocatorObjectTypeList);
     }
     if(newData == NULL) {
         xmlSecMallocError(sizeof(xmlSecPtr) * newSize,
@@ -70,7 +70,7 @@ static xmlSecTransformKlass xmlSecTransformMemBufKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecTransformMemBufExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
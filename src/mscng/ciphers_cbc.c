@@ -71,7 +71,7 @@ static xmlSecTransformKlass xmlSecMSCng ## name ## Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */         \
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */           \
     xmlSecMSCngCbcBlockCipherExecute,           /* xmlSecTransformExecuteMethod execute; */         \
-    NULL,                                       /* void* reserved0; */                              \
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */ \
     NULL,                                       /* void* reserved1; */                              \
 };
 
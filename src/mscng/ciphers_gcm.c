@@ -72,7 +72,7 @@ static xmlSecTransformKlass xmlSecMSCng ## name  ## Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */         \
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */           \
     xmlSecMSCngGcmBlockCipherExecute,           /* xmlSecTransformExecuteMethod execute; */         \
-    NULL,                                       /* void* reserved0; */                              \
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */ \
     NULL,                                       /* void* reserved1; */                              \
 };
 
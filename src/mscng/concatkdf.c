@@ -494,7 +494,7 @@ static xmlSecTransformKlass xmlSecMSCngConcatKdfKlass = {
     NULL,                                           /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngConcatKdfExecute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                           /* void* reserved0; */
+    NULL,                                           /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                           /* void* reserved1; */
 };
 
@@ -387,7 +387,7 @@ static xmlSecTransformKlass xmlSecMSCngMd5Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -431,7 +431,7 @@ static xmlSecTransformKlass xmlSecMSCngSha1Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -475,7 +475,7 @@ static xmlSecTransformKlass xmlSecMSCngSha256Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -519,7 +519,7 @@ static xmlSecTransformKlass xmlSecMSCngSha384Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -563,7 +563,7 @@ static xmlSecTransformKlass xmlSecMSCngSha512Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -643,7 +643,7 @@ static xmlSecTransformKlass xmlSecMSCngEcdhKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngEcdhExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
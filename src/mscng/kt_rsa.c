@@ -427,7 +427,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaPkcs1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngRsaPkcs1OaepExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -607,7 +607,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaOaepKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngRsaPkcs1OaepExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -647,7 +647,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaOaepEnc11Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngRsaPkcs1OaepExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -246,7 +246,7 @@ static xmlSecTransformKlass xmlSecMSCngKWAes128Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngKWAesExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -288,7 +288,7 @@ static xmlSecTransformKlass xmlSecMSCngKWAes192Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngKWAesExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -330,7 +330,7 @@ static xmlSecTransformKlass xmlSecMSCngKWAes256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngKWAesExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -679,7 +679,7 @@ static xmlSecTransformKlass xmlSecMSCngKWDes3Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngKWDes3Execute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -494,7 +494,7 @@ static xmlSecTransformKlass xmlSecMSCngPbkdf2Klass = {
     NULL,                                           /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngPbkdf2Execute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                           /* void* reserved0; */
+    NULL,                                           /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                           /* void* reserved1; */
 };
 
@@ -831,7 +831,7 @@ static xmlSecTransformKlass xmlSecMSCngDsaSha1Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -881,7 +881,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaMd5Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -927,7 +927,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaSha1Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -973,7 +973,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaSha256Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1019,7 +1019,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaSha384Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1065,7 +1065,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaSha512Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1112,7 +1112,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaPssSha1Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1158,7 +1158,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaPssSha256Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1204,7 +1204,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaPssSha384Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1250,7 +1250,7 @@ static xmlSecTransformKlass xmlSecMSCngRsaPssSha512Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1300,7 +1300,7 @@ static xmlSecTransformKlass xmlSecMSCngEcdsaSha1Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1346,7 +1346,7 @@ static xmlSecTransformKlass xmlSecMSCngEcdsaSha256Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1392,7 +1392,7 @@ static xmlSecTransformKlass xmlSecMSCngEcdsaSha384Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -1438,7 +1438,7 @@ static xmlSecTransformKlass xmlSecMSCngEcdsaSha512Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCngSignatureExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
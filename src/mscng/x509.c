@@ -40,6 +40,7 @@
 
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
+#include "../trace_helpers.h"
 #include "private.h"
 
 typedef struct _xmlSecMSCngX509DataCtx xmlSecMSCngX509DataCtx,
@@ -380,6 +381,7 @@ xmlSecMSCnVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data, xml
     PCCERT_CONTEXT cert;
     PCCERT_CONTEXT certCopy;
     PCCERT_CONTEXT keyCert;
+    xmlSecTraceSpan span;
     int ret;
 
     xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecMSCngKeyDataX509Id), -1);
@@ -404,7 +406,9 @@ xmlSecMSCnVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data, xml
         xmlSecInternalError("xmlSecKeysMngrGetDataStore", xmlSecKeyDataGetName(data));
         return(-1);
     }
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeX509Verify, keyInfoCtx, NULL, NULL);
     cert = xmlSecMSCngX509StoreVerify(x509Store, ctx->hMemStore, keyInfoCtx);
+    XMLSEC_TRACE_SPAN_END(&span, 0, (cert != NULL) ? 0 : -1);
     if (cert == NULL) {
         /* check if we want to fail if cert is not found */
         if ((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_X509DATA_STOP_ON_INVALID_CERT) != 0) {
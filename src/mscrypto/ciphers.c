@@ -685,7 +685,7 @@ static xmlSecTransformKlass xmlSecMSCryptoAes128CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoBlockCipherExecute,           /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -724,7 +724,7 @@ static xmlSecTransformKlass xmlSecMSCryptoAes192CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoBlockCipherExecute,           /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -763,7 +763,7 @@ static xmlSecTransformKlass xmlSecMSCryptoAes256CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoBlockCipherExecute,           /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -806,7 +806,7 @@ static xmlSecTransformKlass xmlSecMSCryptoDes3CbcKlass = {
     NULL,                                /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoBlockCipherExecute,    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                /* void* reserved0; */
+    NULL,                                /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                /* void* reserved1; */
 };
 
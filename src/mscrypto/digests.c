@@ -424,7 +424,7 @@ static xmlSecTransformKlass xmlSecMSCryptoMd5Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -468,7 +468,7 @@ static xmlSecTransformKlass xmlSecMSCryptoSha1Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -512,7 +512,7 @@ static xmlSecTransformKlass xmlSecMSCryptoSha256Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,               /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -556,7 +556,7 @@ static xmlSecTransformKlass xmlSecMSCryptoSha384Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,               /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -600,7 +600,7 @@ static xmlSecTransformKlass xmlSecMSCryptoSha512Klass = {
     NULL,                                      /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,               /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -644,7 +644,7 @@ static xmlSecTransformKlass xmlSecMSCryptoGostR3411_94Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -686,7 +686,7 @@ static xmlSecTransformKlass xmlSecMSCryptoGostR3411_2012_256Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -729,7 +729,7 @@ static xmlSecTransformKlass xmlSecMSCryptoGostR3411_2012_512Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -698,7 +698,7 @@ static xmlSecTransformKlass xmlSecMSCryptoRsaMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -744,7 +744,7 @@ static xmlSecTransformKlass xmlSecMSCryptoRsaSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -790,7 +790,7 @@ static xmlSecTransformKlass xmlSecMSCryptoRsaSha256Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,            /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -836,7 +836,7 @@ static xmlSecTransformKlass xmlSecMSCryptoRsaSha384Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,            /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -882,7 +882,7 @@ static xmlSecTransformKlass xmlSecMSCryptoRsaSha512Klass = {
     NULL,                                      /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,            /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                      /* void* reserved0; */
+    NULL,                                      /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                      /* void* reserved1; */
 };
 
@@ -931,7 +931,7 @@ static xmlSecTransformKlass xmlSecMSCryptoDsaSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -979,7 +979,7 @@ static xmlSecTransformKlass xmlSecMSCryptoGost2001GostR3411_94Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -1029,7 +1029,7 @@ static xmlSecTransformKlass xmlSecMSCryptoGost2012_256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -1074,7 +1074,7 @@ static xmlSecTransformKlass xmlSecMSCryptoGost2012_512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecMSCryptoSignatureExecute,             /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -46,6 +46,7 @@
 
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
+#include "../trace_helpers.h"
 
 /*************************************************************************
  *
@@ -936,8 +937,11 @@ xmlSecMSCryptoKeyDataX509VerifyAndExtractKey(xmlSecKeyDataPtr data, xmlSecKeyPtr
 
     if((ctx->keyCert == NULL) && (xmlSecKeyGetValue(key) == NULL)) {
         PCCERT_CONTEXT cert;
+        xmlSecTraceSpan span;
 
+        XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeX509Verify, keyInfoCtx, NULL, NULL);
         cert = xmlSecMSCryptoX509StoreVerify(x509Store, ctx->hMemStore, keyInfoCtx);
+        XMLSEC_TRACE_SPAN_END(&span, 0, (cert != NULL) ? 0 : -1);
         if(cert != NULL) {
             xmlSecKeyDataPtr keyValue = NULL;
         PCCERT_CONTEXT pCert = NULL;
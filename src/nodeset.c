@@ -29,15 +29,34 @@
 #include <xmlsec/private.h>
 
 #include "cast_helpers.h"
+#include "nodeset_helpers.h"
 
 #define xmlSecGetParent(node)           \
     (((node)->type != XML_NAMESPACE_DECL) ? \
         (node)->parent : \
         (xmlNodePtr)((xmlNsPtr)(node))->next)
 
+/* the private data that doesn't fit in the public xmlSecNodeSet layout,
+ * it is allocated together with the nodes set */
+typedef struct _xmlSecNodeSetBitmapData         xmlSecNodeSetBitmapData,
+                                                *xmlSecNodeSetBitmapDataPtr;
+typedef struct _xmlSecNodeSetPrivate            xmlSecNodeSetPrivate,
+                                                *xmlSecNodeSetPrivatePtr;
+struct _xmlSecNodeSetPrivate {
+    xmlSecNodeSet                       nset;       /* must be the first */
+    xmlSecNodeSetBitmapDataPtr          bitmap;     /* the bitmap nodes set (if not NULL) */
+};
+
+#define xmlSecNodeSetGetBitmap(nset) \
+    (((xmlSecNodeSetPrivatePtr)(nset))->bitmap)
+
 static int      xmlSecNodeSetOneContains                (xmlSecNodeSetPtr nset,
                                                          xmlNodePtr node,
                                                          xmlNodePtr parent);
+static int      xmlSecNodeSetBitmapContains             (xmlSecNodeSetBitmapDataPtr bitmap,
+                                                         xmlNodePtr node,
+                                                         xmlNodePtr parent);
+static void     xmlSecNodeSetBitmapDestroy              (xmlSecNodeSetBitmapDataPtr bitmap);
 static int      xmlSecNodeSetWalkRecursive              (xmlSecNodeSetPtr nset,
                                                          xmlSecNodeSetWalkCallback walkFunc,
                                                          void* data,
@@ -59,12 +78,12 @@ xmlSecNodeSetPtr
 xmlSecNodeSetCreate(xmlDocPtr doc, xmlNodeSetPtr nodes, xmlSecNodeSetType type) {
     xmlSecNodeSetPtr nset;
 
-    nset = (xmlSecNodeSetPtr)xmlMalloc(sizeof(xmlSecNodeSet));
+    nset = (xmlSecNodeSetPtr)xmlMalloc(sizeof(xmlSecNodeSetPrivate));
     if(nset == NULL) {
-        xmlSecMallocError(sizeof(xmlSecNodeSet), NULL);
+        xmlSecMallocError(sizeof(xmlSecNodeSetPrivate), NULL);
         return(NULL);
     }
-    memset(nset, 0,  sizeof(xmlSecNodeSet));
+    memset(nset, 0,  sizeof(xmlSecNodeSetPrivate));
 
     nset->doc   = doc;
     nset->nodes = nodes;
@@ -101,12 +120,15 @@ xmlSecNodeSetDestroy(xmlSecNodeSetPtr nset) {
         if(tmp->children != NULL) {
             xmlSecNodeSetDestroy(tmp->children);
         }
+        if(xmlSecNodeSetGetBitmap(tmp) != NULL) {
+            xmlSecNodeSetBitmapDestroy(xmlSecNodeSetGetBitmap(tmp));
+        }
         if((tmp->doc != NULL) && (tmp->destroyDoc != 0)) {
             /* all nodesets should belong to the same doc */
             xmlSecAssert((destroyDoc == NULL) || (tmp->doc == destroyDoc));
             destroyDoc = tmp->doc; /* can't destroy here because other node sets can refer to it */
         }
-        memset(tmp, 0,  sizeof(xmlSecNodeSet));
+        memset(tmp, 0,  sizeof(xmlSecNodeSetPrivate));
         xmlFree(tmp);
     }
 
@@ -137,6 +159,9 @@ xmlSecNodeSetOneContains(xmlSecNodeSetPtr nset, xmlNodePtr node, xmlNodePtr pare
     xmlSecAssert2(node != NULL, 0);
 
     /* special cases: */
+    if(xmlSecNodeSetGetBitmap(nset) != NULL) {
+        return(xmlSecNodeSetBitmapContains(xmlSecNodeSetGetBitmap(nset), node, parent));
+    }
     switch(nset->type) {
         case xmlSecNodeSetTreeWithoutComments:
         case xmlSecNodeSetTreeWithoutCommentsInvert:
@@ -548,6 +573,10 @@ xmlSecNodeSetDebugDump(xmlSecNodeSetPtr nset, FILE *output) {
     xmlSecAssert(output != NULL);
 
     fprintf(output, "== Nodes set ");
+    if(xmlSecNodeSetGetBitmap(nset) != NULL) {
+        fprintf(output, "(bitmap)\n");
+        return;
+    }
     switch(nset->type) {
     case xmlSecNodeSetNormal:
         fprintf(output, "(xmlSecNodeSetNormal)\n");
@@ -597,3 +626,553 @@ xmlSecNodeSetDebugDump(xmlSecNodeSetPtr nset, FILE *output) {
         }
     }
 }
+
+/**************************************************************************
+ *
+ * Nodes index
+ *
+ *****************************************************************************/
+#define XMLSEC_NODESET_INDEX_MIN_SIZE           256
+#define XMLSEC_NODESET_BITMAP_BYTES(size)       (((size) + 7) / 8)
+
+struct _xmlSecNodeSetIndex {
+    xmlDocPtr           doc;
+    xmlNodePtr*         nodes;      /* namespace nodes are the xmlNs from the tree */
+    xmlNodePtr*         parents;
+    xmlSecSize*         ends;       /* the last node in the subtree */
+    xmlSecSize          size;
+    xmlSecSize          max;
+    xmlSecSize*         hash;       /* open addressing: pos + 1 or 0 for the empty slot */
+    xmlSecSize          hashSize;   /* power of 2 */
+};
+
+static xmlSecSize
+xmlSecNodeSetIndexHash(xmlNodePtr node, xmlNodePtr parent) {
+    xmlSecSize res;
+
+    /* namespace node is the xmlNs and the element */
+    res = (xmlSecSize)(((uintptr_t)node) >> 3);
+    if(node->type == XML_NAMESPACE_DECL) {
+        res ^= (xmlSecSize)(((uintptr_t)parent) >> 3) * 31;
+    }
+    return(res * 2654435761U);
+}
+
+static int
+xmlSecNodeSetIndexAdd(xmlSecNodeSetIndexPtr index, xmlNodePtr node, xmlNodePtr parent) {
+    xmlSecAssert2(index != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    if(index->size >= index->max) {
+        xmlSecSize newMax;
+        xmlNodePtr* newNodes;
+        xmlNodePtr* newParents;
+        xmlSecSize* newEnds;
+
+        newMax = (index->max > 0) ? (2 * index->max) : XMLSEC_NODESET_INDEX_MIN_SIZE;
+        if((newMax <= index->max) || (newMax > XMLSEC_SIZE_MAX / sizeof(xmlSecSize))) {
+            xmlSecInvalidSizeOtherError("nodes index is too big", NULL);
+            return(-1);
+        }
+
+        newNodes = (xmlNodePtr*)xmlRealloc(index->nodes, newMax * sizeof(xmlNodePtr));
+        if(newNodes == NULL) {
+            xmlSecMallocError(newMax * sizeof(xmlNodePtr), NULL);
+            return(-1);
+        }
+        index->nodes = newNodes;
+
+        newParents = (xmlNodePtr*)xmlRealloc(index->parents, newMax * sizeof(xmlNodePtr));
+        if(newParents == NULL) {
+            xmlSecMallocError(newMax * sizeof(xmlNodePtr), NULL);
+            return(-1);
+        }
+        index->parents = newParents;
+
+        newEnds = (xmlSecSize*)xmlRealloc(index->ends, newMax * sizeof(xmlSecSize));
+        if(newEnds == NULL) {
+            xmlSecMallocError(newMax * sizeof(xmlSecSize), NULL);
+            return(-1);
+        }
+        index->ends = newEnds;
+        index->max = newMax;
+    }
+
+    index->nodes[index->size] = node;
+    index->parents[index->size] = parent;
+    index->ends[index->size] = index->size;
+    ++index->size;
+    return(0);
+}
+
+/* the same walk as xmlSecNodeSetWalkRecursive() */
+static int
+xmlSecNodeSetIndexAddRecursive(xmlSecNodeSetIndexPtr index, xmlNodePtr cur, xmlNodePtr parent) {
+    xmlSecSize pos;
+    int ret;
+
+    xmlSecAssert2(index != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    pos = index->size;
+    ret = xmlSecNodeSetIndexAdd(index, cur, parent);
+    if(ret < 0) {
+        return(-1);
+    }
+
+    /* element node has attributes, namespaces  */
+    if(cur->type == XML_ELEMENT_NODE) {
+        xmlAttrPtr attr;
+        xmlNodePtr node;
+        xmlNsPtr ns;
+
+        for(attr = cur->properties; attr != NULL; attr = attr->next) {
+            ret = xmlSecNodeSetIndexAdd(index, (xmlNodePtr)attr, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        for(node = cur; node != NULL; node = node->parent) {
+            for(ns = node->nsDef; ns != NULL; ns = ns->next) {
+                if(xmlSearchNs(index->doc, cur, ns->prefix) != ns) {
+                    continue;
+                }
+                ret = xmlSecNodeSetIndexAdd(index, (xmlNodePtr)ns, cur);
+                if(ret < 0) {
+                    return(-1);
+                }
+            }
+        }
+    }
+
+    /* element and document nodes have children */
+    if((cur->type == XML_ELEMENT_NODE) || (cur->type == XML_DOCUMENT_NODE)) {
+        xmlNodePtr node;
+
+        for(node = cur->children; node != NULL; node = node->next) {
+            if(node->type == XML_DTD_NODE) {
+                continue;
+            }
+            ret = xmlSecNodeSetIndexAddRecursive(index, node, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+    }
+
+    index->ends[pos] = index->size - 1;
+    return(0);
+}
+
+/**
+ * xmlSecNodeSetIndexCreate:
+ * @doc:                the pointer to XML document.
+ *
+ * Numbers the @doc node and all the nodes visited by #xmlSecNodeSetWalk
+ * in document order. Caller is responsible for freeing returned object
+ * by calling #xmlSecNodeSetIndexDestroy function.
+ *
+ * Returns: pointer to newly allocated index or NULL if an error occurs.
+ */
+xmlSecNodeSetIndexPtr
+xmlSecNodeSetIndexCreate(xmlDocPtr doc) {
+    xmlSecNodeSetIndexPtr index;
+    xmlSecSize pos, ii, mask;
+    int ret;
+
+    xmlSecAssert2(doc != NULL, NULL);
+
+    index = (xmlSecNodeSetIndexPtr)xmlMalloc(sizeof(xmlSecNodeSetIndex));
+    if(index == NULL) {
+        xmlSecMallocError(sizeof(xmlSecNodeSetIndex), NULL);
+        return(NULL);
+    }
+    memset(index, 0, sizeof(xmlSecNodeSetIndex));
+    index->doc = doc;
+
+    ret = xmlSecNodeSetIndexAddRecursive(index, (xmlNodePtr)doc, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNodeSetIndexAddRecursive", NULL);
+        xmlSecNodeSetIndexDestroy(index);
+        return(NULL);
+    }
+
+    /* the hash table is at most half full */
+    for(index->hashSize = XMLSEC_NODESET_INDEX_MIN_SIZE; index->hashSize < 2 * index->size; index->hashSize *= 2) {
+        if(index->hashSize > XMLSEC_SIZE_MAX / (2 * sizeof(xmlSecSize))) {
+            xmlSecInvalidSizeOtherError("nodes index is too big", NULL);
+            xmlSecNodeSetIndexDestroy(index);
+            return(NULL);
+        }
+    }
+    index->hash = (xmlSecSize*)xmlMalloc(index->hashSize * sizeof(xmlSecSize));
+    if(index->hash == NULL) {
+        xmlSecMallocError(index->hashSize * sizeof(xmlSecSize), NULL);
+        xmlSecNodeSetIndexDestroy(index);
+        return(NULL);
+    }
+    memset(index->hash, 0, index->hashSize * sizeof(xmlSecSize));
+
+    mask = index->hashSize - 1;
+    for(pos = 0; pos < index->size; ++pos) {
+        ii = xmlSecNodeSetIndexHash(index->nodes[pos], index->parents[pos]) & mask;
+        while(index->hash[ii] != 0) {
+            ii = (ii + 1) & mask;
+        }
+        index->hash[ii] = pos + 1;
+    }
+    return(index);
+}
+
+/**
+ * xmlSecNodeSetIndexDestroy:
+ * @index:              the pointer to nodes index.
+ *
+ * Destroys the index created with #xmlSecNodeSetIndexCreate function.
+ */
+void
+xmlSecNodeSetIndexDestroy(xmlSecNodeSetIndexPtr index) {
+    xmlSecAssert(index != NULL);
+
+    if(index->nodes != NULL) {
+        xmlFree(index->nodes);
+    }
+    if(index->parents != NULL) {
+        xmlFree(index->parents);
+    }
+    if(index->ends != NULL) {
+        xmlFree(index->ends);
+    }
+    if(index->hash != NULL) {
+        xmlFree(index->hash);
+    }
+    memset(index, 0, sizeof(xmlSecNodeSetIndex));
+    xmlFree(index);
+}
+
+/**
+ * xmlSecNodeSetIndexGetSize:
+ * @index:              the pointer to nodes index.
+ *
+ * Gets the number of nodes in the @index.
+ *
+ * Returns: the number of nodes in the @index.
+ */
+xmlSecSize
+xmlSecNodeSetIndexGetSize(xmlSecNodeSetIndexPtr index) {
+    xmlSecAssert2(index != NULL, 0);
+
+    return(index->size);
+}
+
+/**
+ * xmlSecNodeSetIndexGetNode:
+ * @index:              the pointer to nodes index.
+ * @pos:                the node number.
+ * @parent:             the pointer to the node parent (returned).
+ *
+ * Gets the node number @pos and its parent (for namespace nodes the parent
+ * is the element the namespace node belongs to).
+ *
+ * Returns: the node or NULL if an error occurs.
+ */
+xmlNodePtr
+xmlSecNodeSetIndexGetNode(xmlSecNodeSetIndexPtr index, xmlSecSize pos, xmlNodePtr* parent) {
+    xmlSecAssert2(index != NULL, NULL);
+    xmlSecAssert2(pos < index->size, NULL);
+    xmlSecAssert2(parent != NULL, NULL);
+
+    (*parent) = index->parents[pos];
+    return(index->nodes[pos]);
+}
+
+/**
+ * xmlSecNodeSetIndexFind:
+ * @index:              the pointer to nodes index.
+ * @node:               the pointer to XML node.
+ * @parent:             the pointer to @node parent node.
+ * @pos:                the node number (returned).
+ *
+ * Finds the @node number.
+ *
+ * Returns: 1 if the @node is found, 0 if not and a negative value
+ * if an error occurs.
+ */
+int
+xmlSecNodeSetIndexFind(xmlSecNodeSetIndexPtr index, xmlNodePtr node, xmlNodePtr parent, xmlSecSize* pos) {
+    xmlSecSize ii, mask, cur;
+
+    xmlSecAssert2(index != NULL, -1);
+    xmlSecAssert2(index->hash != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(pos != NULL, -1);
+
+    mask = index->hashSize - 1;
+    for(ii = xmlSecNodeSetIndexHash(node, parent) & mask; index->hash[ii] != 0; ii = (ii + 1) & mask) {
+        cur = index->hash[ii] - 1;
+        if((index->nodes[cur] == node) &&
+           ((node->type != XML_NAMESPACE_DECL) || (index->parents[cur] == parent)))
+        {
+            (*pos) = cur;
+            return(1);
+        }
+    }
+    return(0);
+}
+
+/**************************************************************************
+ *
+ * Bitmap nodes set
+ *
+ *****************************************************************************/
+struct _xmlSecNodeSetBitmapData {
+    xmlSecNodeSetIndexPtr   index;
+    xmlSecByte*             bits;
+};
+
+#define XMLSEC_NODESET_BITMAP_GET(bits, pos) \
+    (((bits)[(pos) / 8] & (1U << ((pos) % 8))) != 0)
+#define XMLSEC_NODESET_BITMAP_SET(bits, pos) \
+    ((bits)[(pos) / 8] |= (xmlSecByte)(1U << ((pos) % 8)))
+#define XMLSEC_NODESET_BITMAP_CLEAR(bits, pos) \
+    ((bits)[(pos) / 8] &= (xmlSecByte)(~(1U << ((pos) % 8))))
+
+static void
+xmlSecNodeSetBitmapDestroy(xmlSecNodeSetBitmapDataPtr bitmap) {
+    xmlSecAssert(bitmap != NULL);
+
+    if(bitmap->index != NULL) {
+        xmlSecNodeSetIndexDestroy(bitmap->index);
+    }
+    if(bitmap->bits != NULL) {
+        xmlFree(bitmap->bits);
+    }
+    memset(bitmap, 0, sizeof(xmlSecNodeSetBitmapData));
+    xmlFree(bitmap);
+}
+
+static int
+xmlSecNodeSetBitmapContains(xmlSecNodeSetBitmapDataPtr bitmap, xmlNodePtr node, xmlNodePtr parent) {
+    xmlSecSize pos = 0;
+    int ret;
+
+    xmlSecAssert2(bitmap != NULL, 0);
+    xmlSecAssert2(bitmap->index != NULL, 0);
+    xmlSecAssert2(bitmap->bits != NULL, 0);
+    xmlSecAssert2(node != NULL, 0);
+
+    /* this is a libxml hack! check xpath.c for details */
+    if((node->type == XML_NAMESPACE_DECL) && (parent != NULL) && (parent->type == XML_ATTRIBUTE_NODE)) {
+        parent = parent->parent;
+    }
+
+    ret = xmlSecNodeSetIndexFind(bitmap->index, node, parent, &pos);
+    if(ret <= 0) {
+        return(0);
+    }
+    return(XMLSEC_NODESET_BITMAP_GET(bitmap->bits, pos) ? 1 : 0);
+}
+
+/* finds the in-scope xmlNs for the XPath namespace node (a copy of xmlNs) */
+static xmlNsPtr
+xmlSecNodeSetBitmapFindNs(xmlNodePtr parent, const xmlChar* prefix) {
+    xmlNodePtr cur;
+    xmlNsPtr ns;
+
+    for(cur = parent; (cur != NULL) && (cur->type == XML_ELEMENT_NODE); cur = cur->parent) {
+        for(ns = cur->nsDef; ns != NULL; ns = ns->next) {
+            if(xmlStrEqual(ns->prefix, prefix)) {
+                return(ns);
+            }
+        }
+    }
+    return(NULL);
+}
+
+/**
+ * xmlSecNodeSetBitmapCreate:
+ * @index:              the pointer to nodes index.
+ *
+ * Creates new empty bitmap nodes set. The nodes set takes
+ * ownership of the @index on success. Caller is responsible for freeing
+ * returned object by calling #xmlSecNodeSetDestroy function.
+ *
+ * Returns: pointer to newly allocated node set or NULL if an error occurs.
+ */
+xmlSecNodeSetPtr
+xmlSecNodeSetBitmapCreate(xmlSecNodeSetIndexPtr index) {
+    xmlSecNodeSetPtr nset;
+    xmlSecNodeSetBitmapDataPtr bitmap;
+    xmlSecSize size;
+
+    xmlSecAssert2(index != NULL, NULL);
+    xmlSecAssert2(index->doc != NULL, NULL);
+
+    nset = xmlSecNodeSetCreate(index->doc, NULL, xmlSecNodeSetNormal);
+    if(nset == NULL) {
+        xmlSecInternalError("xmlSecNodeSetCreate", NULL);
+        return(NULL);
+    }
+
+    bitmap = (xmlSecNodeSetBitmapDataPtr)xmlMalloc(sizeof(xmlSecNodeSetBitmapData));
+    if(bitmap == NULL) {
+        xmlSecMallocError(sizeof(xmlSecNodeSetBitmapData), NULL);
+        xmlSecNodeSetDestroy(nset);
+        return(NULL);
+    }
+    memset(bitmap, 0, sizeof(xmlSecNodeSetBitmapData));
+    xmlSecNodeSetGetBitmap(nset) = bitmap;
+
+    size = XMLSEC_NODESET_BITMAP_BYTES(index->size) + 1;
+    bitmap->bits = (xmlSecByte*)xmlMalloc(size);
+    if(bitmap->bits == NULL) {
+        xmlSecMallocError(size, NULL);
+        xmlSecNodeSetDestroy(nset);
+        return(NULL);
+    }
+    memset(bitmap->bits, 0, size);
+
+    /* done */
+    bitmap->index = index;
+    return(nset);
+}
+
+/**
+ * xmlSecNodeSetBitmapGetIndex:
+ * @nset:               the pointer to bitmap nodes set.
+ *
+ * Gets the nodes index for the @nset.
+ *
+ * Returns: the nodes index or NULL if an error occurs.
+ */
+xmlSecNodeSetIndexPtr
+xmlSecNodeSetBitmapGetIndex(xmlSecNodeSetPtr nset) {
+    xmlSecAssert2(nset != NULL, NULL);
+    xmlSecAssert2(xmlSecNodeSetGetBitmap(nset) != NULL, NULL);
+
+    return(xmlSecNodeSetGetBitmap(nset)->index);
+}
+
+/**
+ * xmlSecNodeSetBitmapSet:
+ * @nset:               the pointer to bitmap nodes set.
+ * @pos:                the node number in the nodes index.
+ *
+ * Adds the node number @pos to the @nset.
+ */
+void
+xmlSecNodeSetBitmapSet(xmlSecNodeSetPtr nset, xmlSecSize pos) {
+    xmlSecAssert(nset != NULL);
+    xmlSecAssert(xmlSecNodeSetGetBitmap(nset) != NULL);
+    xmlSecAssert(xmlSecNodeSetGetBitmap(nset)->index != NULL);
+    xmlSecAssert(xmlSecNodeSetGetBitmap(nset)->bits != NULL);
+    xmlSecAssert(pos < xmlSecNodeSetGetBitmap(nset)->index->size);
+
+    XMLSEC_NODESET_BITMAP_SET(xmlSecNodeSetGetBitmap(nset)->bits, pos);
+}
+
+/**
+ * xmlSecNodeSetBitmapApply:
+ * @nset:               the pointer to bitmap nodes set.
+ * @nodes:              the nodes list.
+ * @op:                 the operation type.
+ *
+ * Combines the @nset with the @nodes and all their subtrees (i.e. the
+ * #xmlSecNodeSetTree nodes set) using @op operation. Costs O(number of
+ * nodes in the document) regardless of the number of nodes in the @nodes.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecNodeSetBitmapApply(xmlSecNodeSetPtr nset, xmlNodeSetPtr nodes, xmlSecNodeSetOp op) {
+    xmlSecNodeSetIndexPtr index;
+    xmlSecByte* bits;
+    xmlSecByte* tree;
+    xmlSecSize size, pos, ii, coverEnd;
+    xmlNodePtr node, parent;
+    int covered;
+    int i, ret;
+
+    xmlSecAssert2(nset != NULL, -1);
+    xmlSecAssert2(xmlSecNodeSetGetBitmap(nset) != NULL, -1);
+    xmlSecAssert2(xmlSecNodeSetGetBitmap(nset)->index != NULL, -1);
+    xmlSecAssert2(xmlSecNodeSetGetBitmap(nset)->bits != NULL, -1);
+
+    index = xmlSecNodeSetGetBitmap(nset)->index;
+    bits = xmlSecNodeSetGetBitmap(nset)->bits;
+    size = XMLSEC_NODESET_BITMAP_BYTES(index->size) + 1;
+
+    tree = (xmlSecByte*)xmlMalloc(size);
+    if(tree == NULL) {
+        xmlSecMallocError(size, NULL);
+        return(-1);
+    }
+    memset(tree, 0, size);
+
+    /* mark the nodes */
+    for(i = 0; (nodes != NULL) && (i < nodes->nodeNr); ++i) {
+        node = nodes->nodeTab[i];
+        if(node == NULL) {
+            continue;
+        }
+        parent = NULL;
+        if(node->type == XML_NAMESPACE_DECL) {
+            parent = (xmlNodePtr)(((xmlNsPtr)node)->next);
+            node = (xmlNodePtr)xmlSecNodeSetBitmapFindNs(parent, ((xmlNsPtr)node)->prefix);
+            if(node == NULL) {
+                continue;
+            }
+        }
+        ret = xmlSecNodeSetIndexFind(index, node, parent, &pos);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeSetIndexFind", NULL);
+            xmlFree(tree);
+            return(-1);
+        } else if(ret == 0) {
+            continue;
+        }
+        XMLSEC_NODESET_BITMAP_SET(tree, pos);
+    }
+
+    /* add subtrees: the subtrees are either nested or disjoint intervals. Same as
+     * xmlSecNodeSetTree, the document node doesn't include its children */
+    for(pos = 0, covered = 0, coverEnd = 0; pos < index->size; ++pos) {
+        if(covered && (pos > coverEnd)) {
+            covered = 0;
+        }
+        if(index->nodes[pos]->type == XML_DOCUMENT_NODE) {
+            continue;
+        }
+        if(XMLSEC_NODESET_BITMAP_GET(tree, pos)) {
+            if(!covered || (index->ends[pos] > coverEnd)) {
+                coverEnd = index->ends[pos];
+            }
+            covered = 1;
+        } else if(covered) {
+            XMLSEC_NODESET_BITMAP_SET(tree, pos);
+        }
+    }
+
+    /* combine */
+    for(ii = 0; ii < size; ++ii) {
+        switch(op) {
+        case xmlSecNodeSetIntersection:
+            bits[ii] &= tree[ii];
+            break;
+        case xmlSecNodeSetSubtraction:
+            bits[ii] &= (xmlSecByte)(~tree[ii]);
+            break;
+        case xmlSecNodeSetUnion:
+            bits[ii] |= tree[ii];
+            break;
+        default:
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_OPERATION, NULL,
+                "node set operation=" XMLSEC_ENUM_FMT, XMLSEC_ENUM_CAST(op));
+            xmlFree(tree);
+            return(-1);
+        }
+    }
+
+    xmlFree(tree);
+    return(0);
+}
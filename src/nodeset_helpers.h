@@ -0,0 +1,72 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * Document order numbering of the nodes and the bitmap nodes sets.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_NODESET_HELPERS_H__
+#define __XMLSEC_NODESET_HELPERS_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "nodeset_helpers.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/nodeset.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/********************************************************************
+ *
+ * Nodes index: numbers the document node and all the nodes visited by
+ * xmlSecNodeSetWalk() and C14N (elements, namespace nodes, attributes,
+ * children) in document order. The subtree of a node is an interval
+ * of the numbers.
+ *
+ ********************************************************************/
+typedef struct _xmlSecNodeSetIndex                  xmlSecNodeSetIndex,
+                                                    *xmlSecNodeSetIndexPtr;
+
+xmlSecNodeSetIndexPtr           xmlSecNodeSetIndexCreate        (xmlDocPtr doc);
+void                            xmlSecNodeSetIndexDestroy       (xmlSecNodeSetIndexPtr index);
+xmlSecSize                      xmlSecNodeSetIndexGetSize       (xmlSecNodeSetIndexPtr index);
+xmlNodePtr                      xmlSecNodeSetIndexGetNode       (xmlSecNodeSetIndexPtr index,
+                                                                 xmlSecSize pos,
+                                                                 xmlNodePtr* parent);
+int                             xmlSecNodeSetIndexFind          (xmlSecNodeSetIndexPtr index,
+                                                                 xmlNodePtr node,
+                                                                 xmlNodePtr parent,
+                                                                 xmlSecSize* pos);
+
+/********************************************************************
+ *
+ * Bitmap nodes set: one bit per node in the index. The bitmap is kept
+ * in the nodes set private data, the public type is #xmlSecNodeSetNormal.
+ *
+ ********************************************************************/
+xmlSecNodeSetPtr                xmlSecNodeSetBitmapCreate       (xmlSecNodeSetIndexPtr index);
+xmlSecNodeSetIndexPtr           xmlSecNodeSetBitmapGetIndex     (xmlSecNodeSetPtr nset);
+void                            xmlSecNodeSetBitmapSet          (xmlSecNodeSetPtr nset,
+                                                                 xmlSecSize pos);
+int                             xmlSecNodeSetBitmapApply        (xmlSecNodeSetPtr nset,
+                                                                 xmlNodeSetPtr nodes,
+                                                                 xmlSecNodeSetOp op);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_NODESET_HELPERS_H__ */
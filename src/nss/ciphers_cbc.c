@@ -645,7 +645,7 @@ static xmlSecTransformKlass xmlSecNssAes128CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssCbcCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -684,7 +684,7 @@ static xmlSecTransformKlass xmlSecNssAes192CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssCbcCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -723,7 +723,7 @@ static xmlSecTransformKlass xmlSecNssAes256CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssCbcCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -765,7 +765,7 @@ static xmlSecTransformKlass xmlSecNssDes3CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssCbcCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -501,7 +501,7 @@ static xmlSecTransformKlass xmlSecNssAes128GcmKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssGcmCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -540,7 +540,7 @@ static xmlSecTransformKlass xmlSecNssAes192GcmKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssGcmCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -579,7 +579,7 @@ static xmlSecTransformKlass xmlSecNssAes256GcmKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssGcmCipherExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -335,20 +335,24 @@ xmlSecNssKeysStoreFindKeyFromX509Data(xmlSecKeyStorePtr store, xmlSecKeyX509Data
     simplekeystore = xmlSecNssKeysStoreGetCtx(store);
     xmlSecAssert2(((simplekeystore != NULL) && (*simplekeystore != NULL)), NULL);
 
-    keysList = xmlSecSimpleKeysStoreGetKeys(*simplekeystore);
+    /* the keys in the snapshot can't be destroyed by a reload until we release it */
+    keysList = xmlSecSimpleKeysStoreGetKeysSnapshot(*simplekeystore);
     if(keysList == NULL) {
-        xmlSecInternalError("xmlSecSimpleKeysStoreGetKeys", NULL);
+        xmlSecInternalError("xmlSecSimpleKeysStoreGetKeysSnapshot", NULL);
+        xmlSecSimpleKeysStoreReleaseKeysSnapshot(*simplekeystore, keysList);
         return(NULL);
     }
 
     key = xmlSecNssX509FindKeyByValue(keysList, x509Data);
     if(key == NULL) {
         /* not found */
+        xmlSecSimpleKeysStoreReleaseKeysSnapshot(*simplekeystore, keysList);
         return(NULL);
     }
 
     /* since not all key stores can return key owned by someone else, we need to duplicate the key */
     res = xmlSecKeyDuplicate(key);
+    xmlSecSimpleKeysStoreReleaseKeysSnapshot(*simplekeystore, keysList);
     if(res == NULL) {
         xmlSecInternalError("xmlSecKeyDuplicate", NULL);
         return(NULL);
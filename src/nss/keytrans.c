@@ -695,7 +695,7 @@ static xmlSecTransformKlass xmlSecNssRsaPkcs1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssKeyTransportExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -743,7 +743,7 @@ static xmlSecTransformKlass xmlSecNssRsaOaepKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssKeyTransportExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -782,7 +782,7 @@ static xmlSecTransformKlass xmlSecNssRsaOaepEnc11Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssKeyTransportExecute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -435,7 +435,7 @@ static xmlSecTransformKlass xmlSecNssPbkdf2Klass = {
     NULL,                                           /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssPbkdf2Execute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                           /* void* reserved0; */
+    NULL,                                           /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                           /* void* reserved1; */
 };
 
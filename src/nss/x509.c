@@ -52,6 +52,7 @@
 
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
+#include "../trace_helpers.h"
 #include "private.h"
 
 /* workaround - NSS exports this but doesn't declare it */
@@ -986,6 +987,7 @@ xmlSecNssVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data,  xml
     xmlSecKeyDataPtr keyValue;
     CERTCertificate* cert;
     CERTCertificate* keyCert;
+    xmlSecTraceSpan span;
     int ret;
     SECStatus status;
     PRTime notBefore, notAfter;
@@ -1010,7 +1012,9 @@ xmlSecNssVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data,  xml
         xmlSecInternalError("xmlSecKeysMngrGetDataStore", xmlSecKeyDataGetName(data));
         return(-1);
     }
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeX509Verify, keyInfoCtx, NULL, NULL);
     cert = xmlSecNssX509StoreVerify(x509Store, ctx->certsList, keyInfoCtx);
+    XMLSEC_TRACE_SPAN_END(&span, 0, (cert != NULL) ? 0 : -1);
     if(cert == NULL) {
         /* check if we want to fail if cert is not found */
         if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_X509DATA_STOP_ON_INVALID_CERT) != 0) {
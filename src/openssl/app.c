@@ -1883,6 +1883,42 @@ xmlSecOpenSSLAppDefaultKeysMngrLoad(xmlSecKeysMngrPtr mngr, const char* uri) {
     return(0);
 }
 
+/**
+ * xmlSecOpenSSLAppDefaultKeysMngrReload:
+ * @mngr:               the pointer to keys manager.
+ * @uri:                the uri.
+ *
+ * Reloads XML keys file from @uri previously loaded to the keys manager @mngr
+ * with #xmlSecOpenSSLAppDefaultKeysMngrLoad function: only the changed keys
+ * are read and all the changes are published at once while the other threads
+ * keep using @mngr.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecOpenSSLAppDefaultKeysMngrReload(xmlSecKeysMngrPtr mngr, const char* uri) {
+    xmlSecKeyStorePtr store;
+    int ret;
+
+    xmlSecAssert2(mngr != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    store = xmlSecKeysMngrGetKeysStore(mngr);
+    if(store == NULL) {
+        xmlSecInternalError("xmlSecKeysMngrGetKeysStore", NULL);
+        return(-1);
+    }
+
+    ret = xmlSecOpenSSLKeysStoreReload(store, uri, mngr);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecOpenSSLKeysStoreReload", NULL,
+                             "uri=%s", xmlSecErrorsSafeString(uri));
+        return(-1);
+    }
+
+    return(0);
+}
+
 /**
  * xmlSecOpenSSLAppDefaultKeysMngrSave:
  * @mngr:               the pointer to keys manager.
@@ -38,6 +38,7 @@
 #include <xmlsec/openssl/x509.h>
 
 #include "openssl_compat.h"
+#include "private.h"
 #include "../cast_helpers.h"
 
 static int              xmlSecOpenSSLErrorsInit                 (void);
@@ -455,6 +456,10 @@ xmlSecOpenSSLInit (void)  {
         xmlSecInternalError("xmlSecCryptoDLFunctionsRegisterKeyDataAndTransforms", NULL);
         return(-1);
     }
+    if(xmlSecOpenSSLEvpDigestRegisterExecuteBatch(1) < 0) {
+        xmlSecInternalError("xmlSecOpenSSLEvpDigestRegisterExecuteBatch", NULL);
+        return(-1);
+    }
 
     return(0);
 }
@@ -468,6 +473,7 @@ xmlSecOpenSSLInit (void)  {
  */
 int
 xmlSecOpenSSLShutdown(void) {
+    xmlSecOpenSSLEvpDigestRegisterExecuteBatch(0);
     xmlSecOpenSSLSetDefaultTrustedCertsFolder(NULL);
     xmlSecOpenSSLErrorsShutdown();
     return(0);
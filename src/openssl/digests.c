@@ -26,12 +26,14 @@
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
 #include "openssl_compat.h"
+#include "private.h"
 
 #ifdef XMLSEC_OPENSSL_API_300
 #include <openssl/core_names.h>
 #endif /* XMLSEC_OPENSSL_API_300 */
 
 #include "../cast_helpers.h"
+#include "../transform_helpers.h"
 
 /**************************************************************************
  *
@@ -69,6 +71,13 @@ static int      xmlSecOpenSSLEvpDigestVerify            (xmlSecTransformPtr tran
 static int      xmlSecOpenSSLEvpDigestExecute           (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLEvpDigestExecuteOnce       (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize,
+                                                         xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLEvpDigestExecuteBatch      (xmlSecTransformPtr* transforms,
+                                                         xmlSecSize transformsSize,
+                                                         xmlSecTransformCtxPtr transformCtx);
 static int      xmlSecOpenSSLEvpDigestCheckId           (xmlSecTransformPtr transform);
 
 static int
@@ -488,6 +497,277 @@ xmlSecOpenSSLEvpDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTran
     return(0);
 }
 
+static int
+xmlSecOpenSSLEvpDigestExecuteOnce(xmlSecTransformPtr transform, const xmlSecByte* data,
+                                  xmlSecSize dataSize, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecOpenSSLEvpDigestCtxPtr ctx;
+    unsigned int dgstSize;
+    int ret;
+
+    xmlSecAssert2(xmlSecOpenSSLEvpDigestCheckId(transform), -1);
+    xmlSecAssert2((transform->operation == xmlSecTransformOperationSign) || (transform->operation == xmlSecTransformOperationVerify), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLEvpDigestSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusNone, -1);
+    xmlSecAssert2((data != NULL) || (dataSize == 0), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecOpenSSLEvpDigestGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digest != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+
+    /* EVP_Digest() would allocate a new EVP_MD_CTX on every call */
+    ret = EVP_DigestInit(ctx->digestCtx, ctx->digest);
+    if(ret != 1) {
+        xmlSecOpenSSLError("EVP_DigestInit", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    if(dataSize > 0) {
+        ret = EVP_DigestUpdate(ctx->digestCtx, data, dataSize);
+        if(ret != 1) {
+            xmlSecOpenSSLError2("EVP_DigestUpdate", xmlSecTransformGetName(transform),
+                "size=" XMLSEC_SIZE_FMT, dataSize);
+            return(-1);
+        }
+    }
+    ret = EVP_DigestFinal(ctx->digestCtx, ctx->dgst, &dgstSize);
+    if(ret != 1) {
+        xmlSecOpenSSLError("EVP_DigestFinal", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    xmlSecAssert2(dgstSize > 0, -1);
+    ctx->dgstSize = dgstSize;
+
+    if(transform->operation == xmlSecTransformOperationSign) {
+        ret = xmlSecBufferAppend(&(transform->outBuf), ctx->dgst, ctx->dgstSize);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(transform),
+                "size=" XMLSEC_SIZE_FMT, ctx->dgstSize);
+            return(-1);
+        }
+    }
+    transform->status = xmlSecTransformStatusFinished;
+    return(0);
+}
+
+#ifdef XMLSEC_OPENSSL_MB_DIGEST
+
+/* the number of the messages passed to xmlSecOpenSSLMbDigest() at once */
+#define XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE        64
+
+static int
+xmlSecOpenSSLEvpDigestGetMbType(xmlSecTransformId id, xmlSecOpenSSLMbDigestType* type, xmlSecSize* dgstSize) {
+    xmlSecAssert2(id != NULL, -1);
+    xmlSecAssert2(type != NULL, -1);
+    xmlSecAssert2(dgstSize != NULL, -1);
+
+#ifndef XMLSEC_NO_SHA224
+    if(id == xmlSecOpenSSLTransformSha224Id) {
+        (*type) = xmlSecOpenSSLMbDigestSha224;
+        (*dgstSize) = 28;
+        return(0);
+    }
+#endif /* XMLSEC_NO_SHA224 */
+    if(id == xmlSecOpenSSLTransformSha256Id) {
+        (*type) = xmlSecOpenSSLMbDigestSha256;
+        (*dgstSize) = 32;
+        return(0);
+    }
+#ifndef XMLSEC_NO_SHA384
+    if(id == xmlSecOpenSSLTransformSha384Id) {
+        (*type) = xmlSecOpenSSLMbDigestSha384;
+        (*dgstSize) = 48;
+        return(0);
+    }
+#endif /* XMLSEC_NO_SHA384 */
+    if(id == xmlSecOpenSSLTransformSha512Id) {
+        (*type) = xmlSecOpenSSLMbDigestSha512;
+        (*dgstSize) = 64;
+        return(0);
+    }
+
+    /* not supported */
+    return(-1);
+}
+
+static int
+xmlSecOpenSSLEvpDigestMbExecute(xmlSecTransformPtr* transforms, xmlSecSize transformsSize,
+                                xmlSecOpenSSLMbDigestType type, xmlSecSize dgstSize) {
+    const xmlSecByte* data[XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE] = { NULL };
+    xmlSecSize dataSizes[XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE] = { 0 };
+    xmlSecByte* dgsts[XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE] = { NULL };
+    xmlSecOpenSSLEvpDigestCtxPtr ctx;
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(transforms != NULL, -1);
+    xmlSecAssert2(transformsSize <= XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE, -1);
+    xmlSecAssert2(dgstSize <= EVP_MAX_MD_SIZE, -1);
+
+    for(ii = 0; ii < transformsSize; ++ii) {
+        ctx = xmlSecOpenSSLEvpDigestGetCtx(transforms[ii]);
+        xmlSecAssert2(ctx != NULL, -1);
+
+        data[ii] = xmlSecBufferGetData(&(transforms[ii]->inBuf));
+        dataSizes[ii] = xmlSecBufferGetSize(&(transforms[ii]->inBuf));
+        dgsts[ii] = ctx->dgst;
+    }
+
+    ret = xmlSecOpenSSLMbDigest(type, data, dataSizes, dgsts, transformsSize);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecOpenSSLMbDigest", xmlSecTransformGetName(transforms[0]),
+            "size=" XMLSEC_SIZE_FMT, transformsSize);
+        return(-1);
+    }
+
+    for(ii = 0; ii < transformsSize; ++ii) {
+        ctx = xmlSecOpenSSLEvpDigestGetCtx(transforms[ii]);
+        xmlSecAssert2(ctx != NULL, -1);
+
+        ctx->dgstSize = dgstSize;
+        if(transforms[ii]->operation == xmlSecTransformOperationSign) {
+            ret = xmlSecBufferAppend(&(transforms[ii]->outBuf), ctx->dgst, ctx->dgstSize);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(transforms[ii]),
+                    "size=" XMLSEC_SIZE_FMT, ctx->dgstSize);
+                return(-1);
+            }
+        }
+        transforms[ii]->status = xmlSecTransformStatusFinished;
+
+        ret = xmlSecBufferSetSize(&(transforms[ii]->inBuf), 0);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferSetSize", xmlSecTransformGetName(transforms[ii]));
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+#endif /* XMLSEC_OPENSSL_MB_DIGEST */
+
+/* the small inputs are hashed together with xmlSecOpenSSLMbDigest(),
+ * everything else with the OpenSSL one message at a time */
+static int
+xmlSecOpenSSLEvpDigestExecuteBatch(xmlSecTransformPtr* transforms, xmlSecSize transformsSize,
+                                   xmlSecTransformCtxPtr transformCtx) {
+#ifdef XMLSEC_OPENSSL_MB_DIGEST
+    xmlSecTransformPtr batch[XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE];
+    xmlSecSize batchSize = 0;
+    xmlSecOpenSSLMbDigestType type = xmlSecOpenSSLMbDigestSha256;
+    xmlSecSize dgstSize = 0;
+    int useMb = 0;
+#endif /* XMLSEC_OPENSSL_MB_DIGEST */
+    xmlSecTransformPtr transform;
+    xmlSecBufferPtr in;
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(transforms != NULL, -1);
+    xmlSecAssert2(transformsSize > 0, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+#ifdef XMLSEC_OPENSSL_MB_DIGEST
+    if((transformsSize > 1) && (xmlSecOpenSSLEvpDigestGetMbType(transforms[0]->id, &type, &dgstSize) == 0)) {
+        xmlSecOpenSSLEvpDigestCtxPtr ctx;
+
+        ctx = xmlSecOpenSSLEvpDigestGetCtx(transforms[0]);
+        xmlSecAssert2(ctx != NULL, -1);
+        xmlSecAssert2(ctx->digest != NULL, -1);
+
+        useMb = xmlSecOpenSSLMbDigestIsEnabled(type, ctx->digest);
+    }
+#endif /* XMLSEC_OPENSSL_MB_DIGEST */
+
+    for(ii = 0; ii < transformsSize; ++ii) {
+        transform = transforms[ii];
+        xmlSecAssert2(xmlSecOpenSSLEvpDigestCheckId(transform), -1);
+        xmlSecAssert2(transform->id == transforms[0]->id, -1);
+        xmlSecAssert2(transform->status == xmlSecTransformStatusNone, -1);
+
+        in = &(transform->inBuf);
+#ifdef XMLSEC_OPENSSL_MB_DIGEST
+        if((useMb != 0) && (xmlSecBufferGetSize(in) <= XMLSEC_OPENSSL_MB_DIGEST_MAX_DATA_SIZE)) {
+            batch[batchSize++] = transform;
+            if(batchSize == XMLSEC_OPENSSL_EVP_DIGEST_BATCH_SIZE) {
+                ret = xmlSecOpenSSLEvpDigestMbExecute(batch, batchSize, type, dgstSize);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecOpenSSLEvpDigestMbExecute", xmlSecTransformGetName(transform));
+                    return(-1);
+                }
+                batchSize = 0;
+            }
+            continue;
+        }
+#endif /* XMLSEC_OPENSSL_MB_DIGEST */
+
+        ret = xmlSecOpenSSLEvpDigestExecuteOnce(transform, xmlSecBufferGetData(in),
+            xmlSecBufferGetSize(in), transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecOpenSSLEvpDigestExecuteOnce", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+        ret = xmlSecBufferSetSize(in, 0);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferSetSize", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+    }
+
+#ifdef XMLSEC_OPENSSL_MB_DIGEST
+    if(batchSize > 0) {
+        ret = xmlSecOpenSSLEvpDigestMbExecute(batch, batchSize, type, dgstSize);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecOpenSSLEvpDigestMbExecute", xmlSecTransformGetName(batch[0]));
+            return(-1);
+        }
+    }
+#endif /* XMLSEC_OPENSSL_MB_DIGEST */
+
+    return(0);
+}
+
+/**
+ * xmlSecOpenSSLEvpDigestRegisterExecuteBatch:
+ * @enable:             1 to register or 0 to remove the batch execution methods.
+ *
+ * Registers (or removes) the batch execution method for the SHA-2 digests
+ * (see #XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpenSSLEvpDigestRegisterExecuteBatch(int enable) {
+    xmlSecTransformExecuteBatchMethod executeBatch;
+
+    executeBatch = (enable != 0) ? xmlSecOpenSSLEvpDigestExecuteBatch : NULL;
+#ifndef XMLSEC_NO_SHA224
+    if(xmlSecTransformExecuteBatchRegister(xmlSecOpenSSLTransformSha224Id, executeBatch) < 0) {
+        xmlSecInternalError("xmlSecTransformExecuteBatchRegister", xmlSecTransformKlassGetName(xmlSecOpenSSLTransformSha224Id));
+        return(-1);
+    }
+#endif /* XMLSEC_NO_SHA224 */
+#ifndef XMLSEC_NO_SHA256
+    if(xmlSecTransformExecuteBatchRegister(xmlSecOpenSSLTransformSha256Id, executeBatch) < 0) {
+        xmlSecInternalError("xmlSecTransformExecuteBatchRegister", xmlSecTransformKlassGetName(xmlSecOpenSSLTransformSha256Id));
+        return(-1);
+    }
+#endif /* XMLSEC_NO_SHA256 */
+#ifndef XMLSEC_NO_SHA384
+    if(xmlSecTransformExecuteBatchRegister(xmlSecOpenSSLTransformSha384Id, executeBatch) < 0) {
+        xmlSecInternalError("xmlSecTransformExecuteBatchRegister", xmlSecTransformKlassGetName(xmlSecOpenSSLTransformSha384Id));
+        return(-1);
+    }
+#endif /* XMLSEC_NO_SHA384 */
+#ifndef XMLSEC_NO_SHA512
+    if(xmlSecTransformExecuteBatchRegister(xmlSecOpenSSLTransformSha512Id, executeBatch) < 0) {
+        xmlSecInternalError("xmlSecTransformExecuteBatchRegister", xmlSecTransformKlassGetName(xmlSecOpenSSLTransformSha512Id));
+        return(-1);
+    }
+#endif /* XMLSEC_NO_SHA512 */
+    return(0);
+}
+
 
 #ifndef XMLSEC_NO_MD5
 /******************************************************************************
@@ -517,8 +797,8 @@ static xmlSecTransformKlass xmlSecOpenSSLMd5Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -563,8 +843,8 @@ static xmlSecTransformKlass xmlSecOpenSSLRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -610,8 +890,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha1Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -656,8 +936,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha224Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -702,8 +982,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha256Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -748,8 +1028,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha384Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -794,8 +1074,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha512Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -841,8 +1121,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_224Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -885,8 +1165,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_256Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -929,8 +1209,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_384Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -973,8 +1253,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_512Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,          /* xmlSecTransformExecuteOnceMethod executeOnce; */
 
-    NULL,                                       /* void* reserved0; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -1018,7 +1298,7 @@ static xmlSecTransformKlass xmlSecOpenSSLGostR3411_94Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,            /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -1063,7 +1343,7 @@ static xmlSecTransformKlass xmlSecOpenSSLGostR3411_2012_256Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,            /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -1105,7 +1385,7 @@ static xmlSecTransformKlass xmlSecOpenSSLGostR3411_2012_512Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
+    xmlSecOpenSSLEvpDigestExecuteOnce,            /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -0,0 +1,496 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Multi-buffer SHA-2 for OpenSSL: hashes several independent messages
+ * at once, one message per SIMD lane (8 lanes for SHA-224/SHA-256 and
+ * 4 lanes for SHA-384/SHA-512). The lanes are written with the compiler
+ * vector extensions thus the same code is compiled to SSE2, AVX2, NEON, ...
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <string.h>
+
+#include <openssl/evp.h>
+#include <openssl/engine.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private.h>
+
+#include <xmlsec/openssl/crypto.h>
+#include "openssl_compat.h"
+
+#ifdef XMLSEC_OPENSSL_API_300
+#include <openssl/provider.h>
+#endif /* XMLSEC_OPENSSL_API_300 */
+
+#include "private.h"
+
+#ifdef XMLSEC_OPENSSL_MB_DIGEST
+
+#define XMLSEC_OPENSSL_MB_MAX_LANES             8
+#define XMLSEC_OPENSSL_MB_MAX_BLOCK_SIZE        128
+
+/* pick the best instruction set at runtime (ifunc) */
+#if defined(__x86_64__) && defined(__ELF__) && !defined(__clang__)
+#define XMLSEC_OPENSSL_MB_TARGETS               __attribute__((target_clones("avx2", "default")))
+#else  /* defined(__x86_64__) && defined(__ELF__) && !defined(__clang__) */
+#define XMLSEC_OPENSSL_MB_TARGETS
+#endif /* defined(__x86_64__) && defined(__ELF__) && !defined(__clang__) */
+
+typedef unsigned int        xmlSecOpenSSLMbU32 __attribute__((vector_size(32)));
+typedef unsigned long long  xmlSecOpenSSLMbU64 __attribute__((vector_size(32)));
+
+typedef union _xmlSecOpenSSLMbState {
+    xmlSecOpenSSLMbU32      s32[8];
+    xmlSecOpenSSLMbU64      s64[8];
+} xmlSecOpenSSLMbState, *xmlSecOpenSSLMbStatePtr;
+
+typedef void    (*xmlSecOpenSSLMbCompressMethod)    (xmlSecOpenSSLMbStatePtr state,
+                                                     const xmlSecByte** blocks);
+typedef void    (*xmlSecOpenSSLMbLaneInitMethod)    (xmlSecOpenSSLMbStatePtr state,
+                                                     xmlSecSize lane,
+                                                     const void* iv);
+typedef void    (*xmlSecOpenSSLMbLaneFinalMethod)   (xmlSecOpenSSLMbStatePtr state,
+                                                     xmlSecSize lane,
+                                                     xmlSecByte* dgst,
+                                                     xmlSecSize dgstSize);
+
+typedef struct _xmlSecOpenSSLMbAlgorithm {
+    xmlSecSize                      lanes;
+    xmlSecSize                      blockSize;
+    xmlSecSize                      lengthSize;     /* the message length field size in the padding */
+    xmlSecSize                      dgstSize;
+    const void*                     iv;
+    xmlSecOpenSSLMbCompressMethod   compress;
+    xmlSecOpenSSLMbLaneInitMethod   laneInit;
+    xmlSecOpenSSLMbLaneFinalMethod  laneFinal;
+} xmlSecOpenSSLMbAlgorithm;
+
+typedef struct _xmlSecOpenSSLMbLane {
+    int                 active;
+    xmlSecSize          job;
+    const xmlSecByte*   data;
+    xmlSecSize          dataBlocks;     /* the number of full blocks in data */
+    xmlSecSize          totalBlocks;    /* dataBlocks + the padded tail blocks */
+    xmlSecSize          pos;
+    xmlSecByte          tail[2 * XMLSEC_OPENSSL_MB_MAX_BLOCK_SIZE];
+} xmlSecOpenSSLMbLane;
+
+/******************************************************************************
+ *
+ * SHA-224/SHA-256: 8 lanes of 32 bit words
+ *
+ *****************************************************************************/
+static const unsigned int xmlSecOpenSSLMbSha256K[64] = {
+    0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U,
+    0x3956c25bU, 0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U,
+    0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U,
+    0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U,
+    0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU,
+    0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+    0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U,
+    0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U,
+    0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U,
+    0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+    0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U,
+    0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+    0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U,
+    0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+    0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U,
+    0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U
+};
+
+static const unsigned int xmlSecOpenSSLMbSha224Iv[8] = {
+    0xc1059ed8U, 0x367cd507U, 0x3070dd17U, 0xf70e5939U,
+    0xffc00b31U, 0x68581511U, 0x64f98fa7U, 0xbefa4fa4U
+};
+
+static const unsigned int xmlSecOpenSSLMbSha256Iv[8] = {
+    0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU,
+    0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U
+};
+
+#define XMLSEC_OPENSSL_MB_ROTR32(x, n)      (((x) >> (n)) | ((x) << (32 - (n))))
+
+XMLSEC_OPENSSL_MB_TARGETS
+static void
+xmlSecOpenSSLMbSha256Compress(xmlSecOpenSSLMbStatePtr state, const xmlSecByte** blocks) {
+    xmlSecOpenSSLMbU32 w[16];
+    xmlSecOpenSSLMbU32 a, b, c, d, e, f, g, h, t1, t2, w1, w14;
+    xmlSecSize ii, lane;
+
+    for(ii = 0; ii < 16; ++ii) {
+        for(lane = 0; lane < 8; ++lane) {
+            const xmlSecByte* p = blocks[lane] + 4 * ii;
+            w[ii][lane] = ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+                          ((unsigned int)p[2] << 8)  | ((unsigned int)p[3]);
+        }
+    }
+
+    a = state->s32[0]; b = state->s32[1]; c = state->s32[2]; d = state->s32[3];
+    e = state->s32[4]; f = state->s32[5]; g = state->s32[6]; h = state->s32[7];
+    for(ii = 0; ii < 64; ++ii) {
+        if(ii >= 16) {
+            w1  = w[(ii + 1) & 15];
+            w14 = w[(ii + 14) & 15];
+            w[ii & 15] +=
+                (XMLSEC_OPENSSL_MB_ROTR32(w1, 7) ^ XMLSEC_OPENSSL_MB_ROTR32(w1, 18) ^ (w1 >> 3)) +
+                (XMLSEC_OPENSSL_MB_ROTR32(w14, 17) ^ XMLSEC_OPENSSL_MB_ROTR32(w14, 19) ^ (w14 >> 10)) +
+                w[(ii + 9) & 15];
+        }
+        t1 = h + (XMLSEC_OPENSSL_MB_ROTR32(e, 6) ^ XMLSEC_OPENSSL_MB_ROTR32(e, 11) ^ XMLSEC_OPENSSL_MB_ROTR32(e, 25)) +
+             ((e & f) ^ (~e & g)) + xmlSecOpenSSLMbSha256K[ii] + w[ii & 15];
+        t2 = (XMLSEC_OPENSSL_MB_ROTR32(a, 2) ^ XMLSEC_OPENSSL_MB_ROTR32(a, 13) ^ XMLSEC_OPENSSL_MB_ROTR32(a, 22)) +
+             ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state->s32[0] += a; state->s32[1] += b; state->s32[2] += c; state->s32[3] += d;
+    state->s32[4] += e; state->s32[5] += f; state->s32[6] += g; state->s32[7] += h;
+}
+
+static void
+xmlSecOpenSSLMbSha256LaneInit(xmlSecOpenSSLMbStatePtr state, xmlSecSize lane, const void* iv) {
+    const unsigned int* words = (const unsigned int*)iv;
+    xmlSecSize ii;
+
+    for(ii = 0; ii < 8; ++ii) {
+        state->s32[ii][lane] = words[ii];
+    }
+}
+
+static void
+xmlSecOpenSSLMbSha256LaneFinal(xmlSecOpenSSLMbStatePtr state, xmlSecSize lane, xmlSecByte* dgst, xmlSecSize dgstSize) {
+    xmlSecSize ii;
+
+    for(ii = 0; ii < dgstSize / 4; ++ii) {
+        unsigned int word = state->s32[ii][lane];
+
+        dgst[4 * ii]     = (xmlSecByte)(word >> 24);
+        dgst[4 * ii + 1] = (xmlSecByte)(word >> 16);
+        dgst[4 * ii + 2] = (xmlSecByte)(word >> 8);
+        dgst[4 * ii + 3] = (xmlSecByte)(word);
+    }
+}
+
+/******************************************************************************
+ *
+ * SHA-384/SHA-512: 4 lanes of 64 bit words
+ *
+ *****************************************************************************/
+static const unsigned long long xmlSecOpenSSLMbSha512K[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+    0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+    0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+    0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+    0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+    0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+    0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+    0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+    0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+    0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+    0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+    0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+    0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+    0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static const unsigned long long xmlSecOpenSSLMbSha384Iv[8] = {
+    0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL,
+    0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+    0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL,
+    0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL
+};
+
+static const unsigned long long xmlSecOpenSSLMbSha512Iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+#define XMLSEC_OPENSSL_MB_ROTR64(x, n)      (((x) >> (n)) | ((x) << (64 - (n))))
+
+XMLSEC_OPENSSL_MB_TARGETS
+static void
+xmlSecOpenSSLMbSha512Compress(xmlSecOpenSSLMbStatePtr state, const xmlSecByte** blocks) {
+    xmlSecOpenSSLMbU64 w[16];
+    xmlSecOpenSSLMbU64 a, b, c, d, e, f, g, h, t1, t2, w1, w14;
+    xmlSecSize ii, jj, lane;
+
+    for(ii = 0; ii < 16; ++ii) {
+        for(lane = 0; lane < 4; ++lane) {
+            const xmlSecByte* p = blocks[lane] + 8 * ii;
+            unsigned long long word = 0;
+
+            for(jj = 0; jj < 8; ++jj) {
+                word = (word << 8) | p[jj];
+            }
+            w[ii][lane] = word;
+        }
+    }
+
+    a = state->s64[0]; b = state->s64[1]; c = state->s64[2]; d = state->s64[3];
+    e = state->s64[4]; f = state->s64[5]; g = state->s64[6]; h = state->s64[7];
+    for(ii = 0; ii < 80; ++ii) {
+        if(ii >= 16) {
+            w1  = w[(ii + 1) & 15];
+            w14 = w[(ii + 14) & 15];
+            w[ii & 15] +=
+                (XMLSEC_OPENSSL_MB_ROTR64(w1, 1) ^ XMLSEC_OPENSSL_MB_ROTR64(w1, 8) ^ (w1 >> 7)) +
+                (XMLSEC_OPENSSL_MB_ROTR64(w14, 19) ^ XMLSEC_OPENSSL_MB_ROTR64(w14, 61) ^ (w14 >> 6)) +
+                w[(ii + 9) & 15];
+        }
+        t1 = h + (XMLSEC_OPENSSL_MB_ROTR64(e, 14) ^ XMLSEC_OPENSSL_MB_ROTR64(e, 18) ^ XMLSEC_OPENSSL_MB_ROTR64(e, 41)) +
+             ((e & f) ^ (~e & g)) + xmlSecOpenSSLMbSha512K[ii] + w[ii & 15];
+        t2 = (XMLSEC_OPENSSL_MB_ROTR64(a, 28) ^ XMLSEC_OPENSSL_MB_ROTR64(a, 34) ^ XMLSEC_OPENSSL_MB_ROTR64(a, 39)) +
+             ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state->s64[0] += a; state->s64[1] += b; state->s64[2] += c; state->s64[3] += d;
+    state->s64[4] += e; state->s64[5] += f; state->s64[6] += g; state->s64[7] += h;
+}
+
+static void
+xmlSecOpenSSLMbSha512LaneInit(xmlSecOpenSSLMbStatePtr state, xmlSecSize lane, const void* iv) {
+    const unsigned long long* words = (const unsigned long long*)iv;
+    xmlSecSize ii;
+
+    for(ii = 0; ii < 8; ++ii) {
+        state->s64[ii][lane] = words[ii];
+    }
+}
+
+static void
+xmlSecOpenSSLMbSha512LaneFinal(xmlSecOpenSSLMbStatePtr state, xmlSecSize lane, xmlSecByte* dgst, xmlSecSize dgstSize) {
+    xmlSecSize ii, jj;
+
+    for(ii = 0; ii < dgstSize / 8; ++ii) {
+        unsigned long long word = state->s64[ii][lane];
+
+        for(jj = 0; jj < 8; ++jj) {
+            dgst[8 * ii + jj] = (xmlSecByte)(word >> (56 - 8 * jj));
+        }
+    }
+}
+
+/******************************************************************************
+ *
+ * Lanes scheduler
+ *
+ *****************************************************************************/
+static const xmlSecOpenSSLMbAlgorithm xmlSecOpenSSLMbAlgorithms[] = {
+    /* xmlSecOpenSSLMbDigestSha224 */
+    { 8, 64, 8, 28, xmlSecOpenSSLMbSha224Iv, xmlSecOpenSSLMbSha256Compress,
+      xmlSecOpenSSLMbSha256LaneInit, xmlSecOpenSSLMbSha256LaneFinal },
+    /* xmlSecOpenSSLMbDigestSha256 */
+    { 8, 64, 8, 32, xmlSecOpenSSLMbSha256Iv, xmlSecOpenSSLMbSha256Compress,
+      xmlSecOpenSSLMbSha256LaneInit, xmlSecOpenSSLMbSha256LaneFinal },
+    /* xmlSecOpenSSLMbDigestSha384 */
+    { 4, 128, 16, 48, xmlSecOpenSSLMbSha384Iv, xmlSecOpenSSLMbSha512Compress,
+      xmlSecOpenSSLMbSha512LaneInit, xmlSecOpenSSLMbSha512LaneFinal },
+    /* xmlSecOpenSSLMbDigestSha512 */
+    { 4, 128, 16, 64, xmlSecOpenSSLMbSha512Iv, xmlSecOpenSSLMbSha512Compress,
+      xmlSecOpenSSLMbSha512LaneInit, xmlSecOpenSSLMbSha512LaneFinal }
+};
+
+static void
+xmlSecOpenSSLMbLaneStart(const xmlSecOpenSSLMbAlgorithm* alg, xmlSecOpenSSLMbStatePtr state,
+                         xmlSecOpenSSLMbLane* lane, xmlSecSize laneNo, xmlSecSize job,
+                         const xmlSecByte* data, xmlSecSize dataSize) {
+    unsigned long long bits;
+    xmlSecSize rem, tailSize, ii;
+
+    lane->active = 1;
+    lane->job = job;
+    lane->data = data;
+    lane->dataBlocks = dataSize / alg->blockSize;
+    lane->pos = 0;
+
+    /* the last partial block, 0x80, zeros and the message length in bits (big endian) */
+    rem = dataSize % alg->blockSize;
+    tailSize = ((rem + 1 + alg->lengthSize) <= alg->blockSize) ? alg->blockSize : 2 * alg->blockSize;
+    memset(lane->tail, 0, tailSize);
+    if(rem > 0) {
+        memcpy(lane->tail, data + lane->dataBlocks * alg->blockSize, rem);
+    }
+    lane->tail[rem] = 0x80;
+    bits = (unsigned long long)dataSize;
+    for(ii = 0; ii < 8; ++ii) {
+        lane->tail[tailSize - 1 - ii] = (xmlSecByte)((bits << 3) >> (8 * ii));
+    }
+    lane->tail[tailSize - 9] |= (xmlSecByte)(bits >> 61);
+    lane->totalBlocks = lane->dataBlocks + tailSize / alg->blockSize;
+
+    alg->laneInit(state, laneNo, alg->iv);
+}
+
+/**
+ * xmlSecOpenSSLMbDigestIsEnabled:
+ * @type:               the digest algorithm.
+ * @md:                 the OpenSSL digest used for @type otherwise.
+ *
+ * Checks if the multi-buffer implementation can be used instead of @md:
+ * only if @md comes from the OpenSSL "default" provider (or, before
+ * OpenSSL 3.0, if no engine is registered for it). The digests from the
+ * FIPS or any other provider or from an engine are never replaced.
+ *
+ * Returns: 1 if the multi-buffer digest can be used or 0 otherwise.
+ */
+int
+xmlSecOpenSSLMbDigestIsEnabled(xmlSecOpenSSLMbDigestType type, const EVP_MD* md) {
+    UNREFERENCED_PARAMETER(type);
+    xmlSecAssert2(md != NULL, 0);
+
+#ifdef XMLSEC_OPENSSL_API_300
+    {
+        const OSSL_PROVIDER* provider;
+        const char* name;
+
+        provider = EVP_MD_get0_provider(md);
+        if(provider == NULL) {
+            return(0);
+        }
+        name = OSSL_PROVIDER_get0_name(provider);
+        if((name == NULL) || (strcmp(name, "default") != 0)) {
+            return(0);
+        }
+    }
+#elif !defined(OPENSSL_NO_ENGINE)
+    {
+        ENGINE* engine;
+
+        engine = ENGINE_get_digest_engine(EVP_MD_type(md));
+        if(engine != NULL) {
+            ENGINE_finish(engine);
+            return(0);
+        }
+    }
+#endif /* XMLSEC_OPENSSL_API_300 */
+
+    return(1);
+}
+
+/**
+ * xmlSecOpenSSLMbDigest:
+ * @type:               the digest algorithm.
+ * @data:               the messages.
+ * @dataSizes:          the messages sizes.
+ * @dgsts:              the output buffers for the digests (each at least
+ *                      the digest size bytes).
+ * @count:              the number of messages.
+ *
+ * Calculates the digests of @count independent messages. Each lane hashes
+ * one message and picks up the next one as soon as it is done thus the
+ * messages might have different sizes.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpenSSLMbDigest(xmlSecOpenSSLMbDigestType type, const xmlSecByte** data,
+                      const xmlSecSize* dataSizes, xmlSecByte** dgsts, xmlSecSize count) {
+    static const xmlSecByte zeroBlock[XMLSEC_OPENSSL_MB_MAX_BLOCK_SIZE] = { 0 };
+    const xmlSecOpenSSLMbAlgorithm* alg;
+    xmlSecOpenSSLMbState state;
+    xmlSecOpenSSLMbLane lanes[XMLSEC_OPENSSL_MB_MAX_LANES];
+    const xmlSecByte* blocks[XMLSEC_OPENSSL_MB_MAX_LANES];
+    xmlSecSize next = 0;
+    xmlSecSize active = 0;
+    xmlSecSize ii;
+
+    xmlSecAssert2((xmlSecSize)type < sizeof(xmlSecOpenSSLMbAlgorithms) / sizeof(xmlSecOpenSSLMbAlgorithms[0]), -1);
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(dataSizes != NULL, -1);
+    xmlSecAssert2(dgsts != NULL, -1);
+
+    alg = &(xmlSecOpenSSLMbAlgorithms[type]);
+    xmlSecAssert2(alg->lanes <= XMLSEC_OPENSSL_MB_MAX_LANES, -1);
+    xmlSecAssert2(alg->blockSize <= XMLSEC_OPENSSL_MB_MAX_BLOCK_SIZE, -1);
+
+    memset(&state, 0, sizeof(state));
+    for(ii = 0; ii < alg->lanes; ++ii) {
+        lanes[ii].active = 0;
+        if(next < count) {
+            xmlSecAssert2((data[next] != NULL) || (dataSizes[next] == 0), -1);
+            xmlSecOpenSSLMbLaneStart(alg, &state, &(lanes[ii]), ii, next, data[next], dataSizes[next]);
+            ++next;
+            ++active;
+        }
+    }
+
+    while(active > 0) {
+        for(ii = 0; ii < alg->lanes; ++ii) {
+            xmlSecOpenSSLMbLane* lane = &(lanes[ii]);
+
+            if(lane->active == 0) {
+                blocks[ii] = zeroBlock;
+            } else if(lane->pos < lane->dataBlocks) {
+                blocks[ii] = lane->data + lane->pos * alg->blockSize;
+            } else {
+                blocks[ii] = lane->tail + (lane->pos - lane->dataBlocks) * alg->blockSize;
+            }
+        }
+
+        alg->compress(&state, blocks);
+
+        for(ii = 0; ii < alg->lanes; ++ii) {
+            xmlSecOpenSSLMbLane* lane = &(lanes[ii]);
+
+            if(lane->active == 0) {
+                continue;
+            }
+            ++lane->pos;
+            if(lane->pos < lane->totalBlocks) {
+                continue;
+            }
+
+            /* done with this message, take the next one */
+            xmlSecAssert2(dgsts[lane->job] != NULL, -1);
+            alg->laneFinal(&state, ii, dgsts[lane->job], alg->dgstSize);
+            lane->active = 0;
+            --active;
+            if(next < count) {
+                xmlSecAssert2((data[next] != NULL) || (dataSizes[next] == 0), -1);
+                xmlSecOpenSSLMbLaneStart(alg, &state, lane, ii, next, data[next], dataSizes[next]);
+                ++next;
+                ++active;
+            }
+        }
+    }
+    return(0);
+}
+
+#endif /* XMLSEC_OPENSSL_MB_DIGEST */
@@ -20,6 +20,8 @@
 #include <openssl/rand.h>
 #include <openssl/x509.h>
 
+#include <libxml/threads.h>
+
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/base64.h>
 #include <xmlsec/keys.h>
@@ -33,6 +35,7 @@
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
 #include "openssl_compat.h"
+#include "private.h"
 
 #ifdef XMLSEC_OPENSSL_API_300
 #include <openssl/core_names.h>
@@ -111,8 +114,252 @@ typedef struct _xmlSecOpenSSLEvpKeyDataCtx      xmlSecOpenSSLEvpKeyDataCtx,
                                                 *xmlSecOpenSSLEvpKeyDataCtxPtr;
 struct _xmlSecOpenSSLEvpKeyDataCtx {
     EVP_PKEY*           pKey;
+#ifdef XMLSEC_OPENSSL_API_300
+    xmlSecOpenSSLEvpPKeyCtxCachePtr pKeyCtxCache;
+#endif /* XMLSEC_OPENSSL_API_300 */
 };
 
+#ifdef XMLSEC_OPENSSL_API_300
+/**************************************************************************
+ *
+ * Cache of pre-initialized EVP_PKEY_CTX templates. The cache is created
+ * when the key is adopted and is shared (refcounted) between all the
+ * duplicates of the key data so the templates survive the key copies
+ * made by the keys manager for each operation.
+ *
+ *************************************************************************/
+#define XMLSEC_OPENSSL_EVP_PKEY_CTX_CACHE_SIZE          8
+
+#define XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_DECRYPT          0
+#define XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_ENCRYPT          1
+#define XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_DERIVE           2
+
+typedef struct _xmlSecOpenSSLEvpPKeyCtxCacheItem {
+    int                 op;
+    int                 padding;
+    const char*         mdName;         /* not owned, static string */
+    const char*         mgf1mdName;     /* not owned, static string */
+    EVP_PKEY_CTX*       pKeyCtx;
+} xmlSecOpenSSLEvpPKeyCtxCacheItem, *xmlSecOpenSSLEvpPKeyCtxCacheItemPtr;
+
+struct _xmlSecOpenSSLEvpPKeyCtxCache {
+    xmlMutexPtr                         mutex;
+    int                                 refCount;
+    xmlSecSize                          itemsUsed;
+    xmlSecOpenSSLEvpPKeyCtxCacheItem    items[XMLSEC_OPENSSL_EVP_PKEY_CTX_CACHE_SIZE];
+};
+
+static xmlSecOpenSSLEvpPKeyCtxCachePtr
+xmlSecOpenSSLEvpPKeyCtxCacheCreate(void) {
+    xmlSecOpenSSLEvpPKeyCtxCachePtr cache;
+
+    cache = (xmlSecOpenSSLEvpPKeyCtxCachePtr)xmlMalloc(sizeof(xmlSecOpenSSLEvpPKeyCtxCache));
+    if(cache == NULL) {
+        xmlSecMallocError(sizeof(xmlSecOpenSSLEvpPKeyCtxCache), NULL);
+        return(NULL);
+    }
+    memset(cache, 0, sizeof(xmlSecOpenSSLEvpPKeyCtxCache));
+
+    cache->mutex = xmlNewMutex();
+    if(cache->mutex == NULL) {
+        xmlSecXmlError("xmlNewMutex", NULL);
+        xmlFree(cache);
+        return(NULL);
+    }
+    cache->refCount = 1;
+    return(cache);
+}
+
+static xmlSecOpenSSLEvpPKeyCtxCachePtr
+xmlSecOpenSSLEvpPKeyCtxCacheRef(xmlSecOpenSSLEvpPKeyCtxCachePtr cache) {
+    xmlSecAssert2(cache != NULL, NULL);
+
+    xmlMutexLock(cache->mutex);
+    ++cache->refCount;
+    xmlMutexUnlock(cache->mutex);
+    return(cache);
+}
+
+static void
+xmlSecOpenSSLEvpPKeyCtxCacheRelease(xmlSecOpenSSLEvpPKeyCtxCachePtr cache) {
+    xmlSecSize ii;
+    int refCount;
+
+    xmlSecAssert(cache != NULL);
+
+    xmlMutexLock(cache->mutex);
+    refCount = --cache->refCount;
+    xmlMutexUnlock(cache->mutex);
+    if(refCount > 0) {
+        return;
+    }
+
+    for(ii = 0; ii < cache->itemsUsed; ++ii) {
+        EVP_PKEY_CTX_free(cache->items[ii].pKeyCtx);
+    }
+    xmlFreeMutex(cache->mutex);
+    memset(cache, 0, sizeof(xmlSecOpenSSLEvpPKeyCtxCache));
+    xmlFree(cache);
+}
+
+/* the digest names are static strings but compare them by value anyway */
+static int
+xmlSecOpenSSLEvpPKeyCtxCacheNamesEqual(const char* name1, const char* name2) {
+    if((name1 == NULL) || (name2 == NULL)) {
+        return((name1 == name2) ? 1 : 0);
+    }
+    return((strcmp(name1, name2) == 0) ? 1 : 0);
+}
+
+/* OpenSSL <= 3.0.7 mixes OAEP digest and OAEP MGF1 digest if both are set
+ * in one OSSL_PARAM array so we set one param at a time */
+static EVP_PKEY_CTX*
+xmlSecOpenSSLEvpPKeyCtxCreate(EVP_PKEY* pKey, int op, int padding,
+                              const char* mdName, const char* mgf1mdName) {
+    EVP_PKEY_CTX* pKeyCtx = NULL;
+    EVP_PKEY_CTX* res = NULL;
+    int ret;
+
+    xmlSecAssert2(pKey != NULL, NULL);
+
+    pKeyCtx = EVP_PKEY_CTX_new_from_pkey(xmlSecOpenSSLGetLibCtx(), pKey, NULL);
+    if (pKeyCtx == NULL) {
+        xmlSecOpenSSLError("EVP_PKEY_CTX_new_from_pkey", NULL);
+        goto done;
+    }
+
+    switch(op) {
+    case XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_DERIVE:
+        ret = EVP_PKEY_derive_init(pKeyCtx);
+        if (ret <= 0) {
+            xmlSecOpenSSLError("EVP_PKEY_derive_init", NULL);
+            goto done;
+        }
+        /* nothing else to setup for key agreement */
+        res = pKeyCtx;
+        pKeyCtx = NULL;
+        goto done;
+    case XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_ENCRYPT:
+        ret = EVP_PKEY_encrypt_init(pKeyCtx);
+        if (ret <= 0) {
+            xmlSecOpenSSLError("EVP_PKEY_encrypt_init", NULL);
+            goto done;
+        }
+        break;
+    default:
+        ret = EVP_PKEY_decrypt_init(pKeyCtx);
+        if (ret <= 0) {
+            xmlSecOpenSSLError("EVP_PKEY_decrypt_init", NULL);
+            goto done;
+        }
+        break;
+    }
+
+    ret = EVP_PKEY_CTX_set_rsa_padding(pKeyCtx, padding);
+    if (ret <= 0) {
+        xmlSecOpenSSLError("EVP_PKEY_CTX_set_rsa_padding", NULL);
+        goto done;
+    }
+
+    if(mdName != NULL) {
+        OSSL_PARAM params[2];
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_ASYM_CIPHER_PARAM_OAEP_DIGEST, (char*)mdName, 0);
+        params[1] = OSSL_PARAM_construct_end();
+
+        ret = EVP_PKEY_CTX_set_params(pKeyCtx, params);
+        if(ret <= 0) {
+            xmlSecOpenSSLError("EVP_PKEY_CTX_set_params(digest)", NULL);
+            goto done;
+        }
+    }
+    if(mgf1mdName != NULL) {
+        OSSL_PARAM params[2];
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_ASYM_CIPHER_PARAM_MGF1_DIGEST, (char*)mgf1mdName, 0);
+        params[1] = OSSL_PARAM_construct_end();
+
+        ret = EVP_PKEY_CTX_set_params(pKeyCtx, params);
+        if(ret <= 0) {
+            xmlSecOpenSSLError("EVP_PKEY_CTX_set_params(mgf1)", NULL);
+            goto done;
+        }
+    }
+
+    /* success */
+    res = pKeyCtx;
+    pKeyCtx = NULL;
+
+done:
+    if(pKeyCtx != NULL) {
+        EVP_PKEY_CTX_free(pKeyCtx);
+    }
+    return(res);
+}
+
+static EVP_PKEY_CTX*
+xmlSecOpenSSLEvpPKeyCtxCacheGet(xmlSecOpenSSLEvpPKeyCtxCachePtr cache, EVP_PKEY* pKey,
+                                int op, int padding,
+                                const char* mdName, const char* mgf1mdName) {
+    xmlSecOpenSSLEvpPKeyCtxCacheItemPtr item;
+    EVP_PKEY_CTX* pKeyCtx = NULL;
+    EVP_PKEY_CTX* res = NULL;
+    xmlSecSize ii;
+
+    xmlSecAssert2(cache != NULL, NULL);
+    xmlSecAssert2(pKey != NULL, NULL);
+
+    xmlMutexLock(cache->mutex);
+    for(ii = 0; ii < cache->itemsUsed; ++ii) {
+        item = &(cache->items[ii]);
+        if((item->op == op) && (item->padding == padding) &&
+           (xmlSecOpenSSLEvpPKeyCtxCacheNamesEqual(item->mdName, mdName) != 0) &&
+           (xmlSecOpenSSLEvpPKeyCtxCacheNamesEqual(item->mgf1mdName, mgf1mdName) != 0)
+        ) {
+            res = EVP_PKEY_CTX_dup(item->pKeyCtx);
+            if(res == NULL) {
+                xmlSecOpenSSLError("EVP_PKEY_CTX_dup", NULL);
+            }
+            goto done;
+        }
+    }
+
+    /* not found: create a new template */
+    pKeyCtx = xmlSecOpenSSLEvpPKeyCtxCreate(pKey, op, padding, mdName, mgf1mdName);
+    if(pKeyCtx == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLEvpPKeyCtxCreate", NULL);
+        goto done;
+    }
+
+    /* cache is full: simply give the new ctx to the caller */
+    if(cache->itemsUsed >= XMLSEC_OPENSSL_EVP_PKEY_CTX_CACHE_SIZE) {
+        res = pKeyCtx;
+        pKeyCtx = NULL;
+        goto done;
+    }
+
+    res = EVP_PKEY_CTX_dup(pKeyCtx);
+    if(res == NULL) {
+        xmlSecOpenSSLError("EVP_PKEY_CTX_dup", NULL);
+        goto done;
+    }
+
+    item = &(cache->items[cache->itemsUsed]);
+    item->op         = op;
+    item->padding    = padding;
+    item->mdName     = mdName;
+    item->mgf1mdName = mgf1mdName;
+    item->pKeyCtx    = pKeyCtx;
+    pKeyCtx = NULL;
+    ++cache->itemsUsed;
+
+done:
+    xmlMutexUnlock(cache->mutex);
+    if(pKeyCtx != NULL) {
+        EVP_PKEY_CTX_free(pKeyCtx);
+    }
+    return(res);
+}
+#endif /* XMLSEC_OPENSSL_API_300 */
+
 /******************************************************************************
  *
  * EVP key data (dsa/rsa)
@@ -146,6 +393,30 @@ xmlSecOpenSSLEvpKeyDataAdoptEvp(xmlSecKeyDataPtr data, EVP_PKEY* pKey) {
     ctx = xmlSecOpenSSLEvpKeyDataGetCtx(data);
     xmlSecAssert2(ctx != NULL, -1);
 
+#ifdef XMLSEC_OPENSSL_API_300
+    /* the templates are bound to the key so start from scratch */
+    if(ctx->pKeyCtxCache != NULL) {
+        xmlSecOpenSSLEvpPKeyCtxCacheRelease(ctx->pKeyCtxCache);
+        ctx->pKeyCtxCache = NULL;
+    }
+    switch(EVP_PKEY_base_id(pKey)) {
+    case EVP_PKEY_RSA:
+    case EVP_PKEY_EC:
+    case EVP_PKEY_DH:
+    case EVP_PKEY_DHX:
+        ctx->pKeyCtxCache = xmlSecOpenSSLEvpPKeyCtxCacheCreate();
+        if(ctx->pKeyCtxCache == NULL) {
+            xmlSecInternalError("xmlSecOpenSSLEvpPKeyCtxCacheCreate",
+                xmlSecKeyDataGetName(data));
+            return(-1);
+        }
+        break;
+    default:
+        /* no templates for signatures */
+        break;
+    }
+#endif /* XMLSEC_OPENSSL_API_300 */
+
     if(ctx->pKey != NULL) {
         EVP_PKEY_free(ctx->pKey);
     }
@@ -174,6 +445,52 @@ xmlSecOpenSSLEvpKeyDataGetEvp(xmlSecKeyDataPtr data) {
     return(ctx->pKey);
 }
 
+#ifdef XMLSEC_OPENSSL_API_300
+/**
+ * xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx:
+ * @data:               the pointer to EVP key data.
+ *
+ * Gets the EVP_PKEY_CTX initialized for the key agreement (EVP_PKEY_derive_init())
+ * with the private key from @data. The initialized context is cached in the key
+ * data (and shared with its duplicates) so encrypting to many recipients with
+ * the same originator key only needs to set the peer key and derive the secret.
+ *
+ * Returns: the new EVP_PKEY_CTX (caller is responsible for freeing it)
+ * or NULL if an error occurs.
+ */
+EVP_PKEY_CTX*
+xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx(xmlSecKeyDataPtr data) {
+    xmlSecOpenSSLEvpKeyDataCtxPtr ctx;
+    EVP_PKEY_CTX* res;
+
+    xmlSecAssert2(xmlSecKeyDataIsValid(data), NULL);
+    xmlSecAssert2(xmlSecKeyDataCheckSize(data, xmlSecOpenSSLEvpKeyDataSize), NULL);
+
+    ctx = xmlSecOpenSSLEvpKeyDataGetCtx(data);
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(ctx->pKey != NULL, NULL);
+
+    if(ctx->pKeyCtxCache != NULL) {
+        res = xmlSecOpenSSLEvpPKeyCtxCacheGet(ctx->pKeyCtxCache, ctx->pKey,
+            XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_DERIVE, 0, NULL, NULL);
+        if(res == NULL) {
+            xmlSecInternalError("xmlSecOpenSSLEvpPKeyCtxCacheGet",
+                xmlSecKeyDataGetName(data));
+            return(NULL);
+        }
+    } else {
+        res = xmlSecOpenSSLEvpPKeyCtxCreate(ctx->pKey,
+            XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_DERIVE, 0, NULL, NULL);
+        if(res == NULL) {
+            xmlSecInternalError("xmlSecOpenSSLEvpPKeyCtxCreate",
+                xmlSecKeyDataGetName(data));
+            return(NULL);
+        }
+    }
+    return(res);
+}
+#endif /* XMLSEC_OPENSSL_API_300 */
+
 /**
  * xmlSecOpenSSLKeyGetEvp:
  * @key:               the pointer to OpenSSL EVP key.
@@ -236,6 +553,11 @@ xmlSecOpenSSLEvpKeyDataDuplicate(xmlSecKeyDataPtr dst, xmlSecKeyDataPtr src) {
             return(-1);
         }
     }
+#ifdef XMLSEC_OPENSSL_API_300
+    if(ctxSrc->pKeyCtxCache != NULL) {
+        ctxDst->pKeyCtxCache = xmlSecOpenSSLEvpPKeyCtxCacheRef(ctxSrc->pKeyCtxCache);
+    }
+#endif /* XMLSEC_OPENSSL_API_300 */
 
     return(0);
 }
@@ -250,6 +572,11 @@ xmlSecOpenSSLEvpKeyDataFinalize(xmlSecKeyDataPtr data) {
     ctx = xmlSecOpenSSLEvpKeyDataGetCtx(data);
     xmlSecAssert(ctx != NULL);
 
+#ifdef XMLSEC_OPENSSL_API_300
+    if(ctx->pKeyCtxCache != NULL) {
+        xmlSecOpenSSLEvpPKeyCtxCacheRelease(ctx->pKeyCtxCache);
+    }
+#endif /* XMLSEC_OPENSSL_API_300 */
     if(ctx->pKey != NULL) {
         EVP_PKEY_free(ctx->pKey);
     }
@@ -3446,6 +3773,80 @@ xmlSecOpenSSLKeyDataRsaGetEvp(xmlSecKeyDataPtr data) {
     return(xmlSecOpenSSLEvpKeyDataGetEvp(data));
 }
 
+#ifdef XMLSEC_OPENSSL_API_300
+/**
+ * xmlSecOpenSSLKeyDataRsaGetPKeyCtx:
+ * @data:               the pointer to RSA key data.
+ * @encrypt:            the flag: encrypt (1) or decrypt (0).
+ * @padding:            the RSA padding (e.g. RSA_PKCS1_OAEP_PADDING).
+ * @mdName:             the OAEP digest name or NULL.
+ * @mgf1mdName:         the OAEP MGF1 digest name or NULL.
+ * @label:              the OAEP label or NULL.
+ * @labelSize:          the OAEP label size.
+ *
+ * Gets the EVP_PKEY_CTX initialized for the RSA encryption or decryption
+ * with given parameters. The initialized contexts are cached in the key data
+ * (and shared with its duplicates) per (operation, padding, digest, mgf1 digest)
+ * combination and the caller gets a copy so the provider lookups and params
+ * parsing are done only once.
+ *
+ * Returns: the new EVP_PKEY_CTX (caller is responsible for freeing it)
+ * or NULL if an error occurs.
+ */
+EVP_PKEY_CTX*
+xmlSecOpenSSLKeyDataRsaGetPKeyCtx(xmlSecKeyDataPtr data, int encrypt, int padding,
+                                  const char* mdName, const char* mgf1mdName,
+                                  const xmlSecByte* label, xmlSecSize labelSize) {
+    xmlSecOpenSSLEvpKeyDataCtxPtr ctx;
+    EVP_PKEY_CTX* res;
+    int op;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataRsaId), NULL);
+
+    ctx = xmlSecOpenSSLEvpKeyDataGetCtx(data);
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(ctx->pKey != NULL, NULL);
+
+    op = (encrypt != 0) ? XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_ENCRYPT : XMLSEC_OPENSSL_EVP_PKEY_CTX_OP_DECRYPT;
+    if(ctx->pKeyCtxCache != NULL) {
+        res = xmlSecOpenSSLEvpPKeyCtxCacheGet(ctx->pKeyCtxCache, ctx->pKey,
+            op, padding, mdName, mgf1mdName);
+        if(res == NULL) {
+            xmlSecInternalError("xmlSecOpenSSLEvpPKeyCtxCacheGet",
+                xmlSecKeyDataGetName(data));
+            return(NULL);
+        }
+    } else {
+        res = xmlSecOpenSSLEvpPKeyCtxCreate(ctx->pKey, op, padding,
+            mdName, mgf1mdName);
+        if(res == NULL) {
+            xmlSecInternalError("xmlSecOpenSSLEvpPKeyCtxCreate",
+                xmlSecKeyDataGetName(data));
+            return(NULL);
+        }
+    }
+
+    /* OpenSSL 3.0.x doesn't copy OAEP label in EVP_PKEY_CTX_dup()
+     * (shallow copy, double free) so the label is never cached and
+     * is set on each copy instead */
+    if((label != NULL) && (labelSize > 0)) {
+        OSSL_PARAM params[2];
+        params[0] = OSSL_PARAM_construct_octet_string(OSSL_ASYM_CIPHER_PARAM_OAEP_LABEL, (void*)label, labelSize);
+        params[1] = OSSL_PARAM_construct_end();
+
+        ret = EVP_PKEY_CTX_set_params(res, params);
+        if(ret <= 0) {
+            xmlSecOpenSSLError("EVP_PKEY_CTX_set_params(label)",
+                xmlSecKeyDataGetName(data));
+            EVP_PKEY_CTX_free(res);
+            return(NULL);
+        }
+    }
+    return(res);
+}
+#endif /* XMLSEC_OPENSSL_API_300 */
+
 static int
 xmlSecOpenSSLKeyDataRsaInitialize(xmlSecKeyDataPtr data) {
     xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataRsaId), -1);
@@ -549,7 +549,7 @@ static xmlSecTransformKlass xmlSecOpenSSLConcatKdfKlass = {
     NULL,                                           /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLKdfExecute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                           /* void* reserved0; */
+    NULL,                                           /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                           /* void* reserved1; */
 };
 
@@ -766,7 +766,7 @@ static xmlSecTransformKlass xmlSecOpenSSLPbkdf2Klass = {
     NULL,                                           /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLKdfExecute,                        /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                           /* void* reserved0; */
+    NULL,                                           /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                           /* void* reserved1; */
 };
 
@@ -32,6 +32,7 @@
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
 #include "openssl_compat.h"
+#include "private.h"
 
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
@@ -208,7 +209,9 @@ static int
 xmlSecOpenSSLEcdhGenerateSecret(xmlSecOpenSSLEcdhCtxPtr ctx, xmlSecTransformOperation operation, xmlSecBufferPtr secret) {
     EVP_PKEY_CTX *pKeyCtx = NULL;
     xmlSecKeyDataPtr myKeyValue, otherKeyValue;
+#ifndef XMLSEC_OPENSSL_API_300
     EVP_PKEY *myPrivKey;
+#endif /* XMLSEC_OPENSSL_API_300 */
     EVP_PKEY *otherPubKey;
     size_t secret_len = 0;
     xmlSecByte * secretData;
@@ -250,17 +253,27 @@ xmlSecOpenSSLEcdhGenerateSecret(xmlSecOpenSSLEcdhCtxPtr ctx, xmlSecTransformOper
     }
 
     /* get pkeys */
-    myPrivKey = xmlSecOpenSSLEvpKeyDataGetEvp(myKeyValue);
-    if(myPrivKey == NULL) {
-        xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetEvp(myKey)", NULL);
-        goto done;
-    }
     otherPubKey = xmlSecOpenSSLEvpKeyDataGetEvp(otherKeyValue);
     if(otherPubKey == NULL) {
         xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetEvp(otherKey)", NULL);
         goto done;
     }
 
+#ifdef XMLSEC_OPENSSL_API_300
+    /* get a copy of the derive ctx cached in the key data: when encrypting
+     * to many recipients, the originator key is the same for all of them */
+    pKeyCtx = xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx(myKeyValue);
+    if(pKeyCtx == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx(myKey)", NULL);
+        goto done;
+    }
+#else /* XMLSEC_OPENSSL_API_300 */
+    myPrivKey = xmlSecOpenSSLEvpKeyDataGetEvp(myKeyValue);
+    if(myPrivKey == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetEvp(myKey)", NULL);
+        goto done;
+    }
+
     /* create and init ctx */
     pKeyCtx = EVP_PKEY_CTX_new(myPrivKey, NULL);
     if(pKeyCtx == NULL) {
@@ -272,6 +285,7 @@ xmlSecOpenSSLEcdhGenerateSecret(xmlSecOpenSSLEcdhCtxPtr ctx, xmlSecTransformOper
         xmlSecOpenSSLError("EVP_PKEY_CTX_new", NULL);
         goto done;
     }
+#endif /* XMLSEC_OPENSSL_API_300 */
 	ret = EVP_PKEY_derive_set_peer(pKeyCtx, otherPubKey);
     if(ret != 1) {
         xmlSecOpenSSLError("EVP_PKEY_derive_set_peer", NULL);
@@ -489,7 +503,7 @@ static xmlSecTransformKlass xmlSecOpenSSLEcdhKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEcdhExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -678,7 +692,9 @@ static int
 xmlSecOpenSSLDhGenerateSecret(xmlSecOpenSSLDhCtxPtr ctx, xmlSecTransformOperation operation, xmlSecBufferPtr secret) {
     EVP_PKEY_CTX *pKeyCtx = NULL;
     xmlSecKeyDataPtr myKeyValue, otherKeyValue;
+#ifndef XMLSEC_OPENSSL_API_300
     EVP_PKEY *myPrivKey;
+#endif /* XMLSEC_OPENSSL_API_300 */
     EVP_PKEY *otherPubKey;
     size_t secret_len = 0;
     xmlSecByte * secretData;
@@ -720,17 +736,27 @@ xmlSecOpenSSLDhGenerateSecret(xmlSecOpenSSLDhCtxPtr ctx, xmlSecTransformOperatio
     }
 
     /* get pkeys */
-    myPrivKey = xmlSecOpenSSLEvpKeyDataGetEvp(myKeyValue);
-    if(myPrivKey == NULL) {
-        xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetEvp(myKey)", NULL);
-        goto done;
-    }
     otherPubKey = xmlSecOpenSSLEvpKeyDataGetEvp(otherKeyValue);
     if(otherPubKey == NULL) {
         xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetEvp(otherKey)", NULL);
         goto done;
     }
 
+#ifdef XMLSEC_OPENSSL_API_300
+    /* get a copy of the derive ctx cached in the key data: when encrypting
+     * to many recipients, the originator key is the same for all of them */
+    pKeyCtx = xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx(myKeyValue);
+    if(pKeyCtx == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx(myKey)", NULL);
+        goto done;
+    }
+#else /* XMLSEC_OPENSSL_API_300 */
+    myPrivKey = xmlSecOpenSSLEvpKeyDataGetEvp(myKeyValue);
+    if(myPrivKey == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLEvpKeyDataGetEvp(myKey)", NULL);
+        goto done;
+    }
+
     /* create and init ctx */
     pKeyCtx = EVP_PKEY_CTX_new(myPrivKey, NULL);
     if(pKeyCtx == NULL) {
@@ -742,6 +768,7 @@ xmlSecOpenSSLDhGenerateSecret(xmlSecOpenSSLDhCtxPtr ctx, xmlSecTransformOperatio
         xmlSecOpenSSLError("EVP_PKEY_CTX_new", NULL);
         goto done;
     }
+#endif /* XMLSEC_OPENSSL_API_300 */
 	ret = EVP_PKEY_derive_set_peer(pKeyCtx, otherPubKey);
     if(ret != 1) {
         xmlSecOpenSSLError("EVP_PKEY_derive_set_peer", NULL);
@@ -959,7 +986,7 @@ static xmlSecTransformKlass xmlSecOpenSSLDhKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLDhExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
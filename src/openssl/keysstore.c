@@ -143,20 +143,24 @@ xmlSecOpenSSLKeysStoreFindKeyFromX509Data(xmlSecKeyStorePtr store, xmlSecKeyX509
     simplekeystore = xmlSecOpenSSLKeysStoreGetCtx(store);
     xmlSecAssert2(((simplekeystore != NULL) && (*simplekeystore != NULL)), NULL);
 
-    keysList = xmlSecSimpleKeysStoreGetKeys(*simplekeystore);
+    /* the keys in the snapshot can't be destroyed by a reload until we release it */
+    keysList = xmlSecSimpleKeysStoreGetKeysSnapshot(*simplekeystore);
     if(keysList == NULL) {
-        xmlSecInternalError("xmlSecSimpleKeysStoreGetKeys", NULL);
+        xmlSecInternalError("xmlSecSimpleKeysStoreGetKeysSnapshot", NULL);
+        xmlSecSimpleKeysStoreReleaseKeysSnapshot(*simplekeystore, keysList);
         return(NULL);
     }
 
     key = xmlSecOpenSSLX509FindKeyByValue(keysList, x509Data);
     if(key == NULL) {
         /* not found */
+        xmlSecSimpleKeysStoreReleaseKeysSnapshot(*simplekeystore, keysList);
         return(NULL);
     }
 
     /* since not all key stores can return key owned by someone else, we need to duplicate the key */
     res = xmlSecKeyDuplicate(key);
+    xmlSecSimpleKeysStoreReleaseKeysSnapshot(*simplekeystore, keysList);
     if(res == NULL) {
         xmlSecInternalError("xmlSecKeyDuplicate", NULL);
         return(NULL);
@@ -208,9 +212,44 @@ xmlSecOpenSSLKeysStoreAdoptKey(xmlSecKeyStorePtr store, xmlSecKeyPtr key) {
  */
 int
 xmlSecOpenSSLKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
-                            xmlSecKeysMngrPtr keysMngr ATTRIBUTE_UNUSED) {
-    return(xmlSecSimpleKeysStoreLoad_ex(store, uri, keysMngr,
-        xmlSecOpenSSLKeysStoreAdoptKey));
+                            xmlSecKeysMngrPtr keysMngr) {
+    xmlSecKeyStorePtr *simplekeystore;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecOpenSSLKeysStoreId), -1);
+    xmlSecAssert2((uri != NULL), -1);
+
+    simplekeystore = xmlSecOpenSSLKeysStoreGetCtx(store);
+    xmlSecAssert2(((simplekeystore != NULL) && (*simplekeystore != NULL) &&
+                   (xmlSecKeyStoreCheckId(*simplekeystore, xmlSecSimpleKeysStoreId))), -1);
+
+    /* load in the simple keys store directly so it can reload the file later */
+    return (xmlSecSimpleKeysStoreLoad(*simplekeystore, uri, keysMngr));
+}
+
+/**
+ * xmlSecOpenSSLKeysStoreReload:
+ * @store:              the pointer to OpenSSL keys store.
+ * @uri:                the filename.
+ * @keysMngr:           the pointer to associated keys manager.
+ *
+ * Reloads keys from an XML file previously loaded with #xmlSecOpenSSLKeysStoreLoad
+ * (see #xmlSecSimpleKeysStoreReload).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpenSSLKeysStoreReload(xmlSecKeyStorePtr store, const char *uri,
+                            xmlSecKeysMngrPtr keysMngr) {
+    xmlSecKeyStorePtr *simplekeystore;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecOpenSSLKeysStoreId), -1);
+    xmlSecAssert2((uri != NULL), -1);
+
+    simplekeystore = xmlSecOpenSSLKeysStoreGetCtx(store);
+    xmlSecAssert2(((simplekeystore != NULL) && (*simplekeystore != NULL) &&
+                   (xmlSecKeyStoreCheckId(*simplekeystore, xmlSecSimpleKeysStoreId))), -1);
+
+    return (xmlSecSimpleKeysStoreReload(*simplekeystore, uri, keysMngr));
 }
 
 /**
@@ -35,6 +35,7 @@
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
 #include "openssl_compat.h"
+#include "private.h"
 
 #ifdef XMLSEC_OPENSSL_API_300
 #include <openssl/core_names.h>
@@ -103,7 +104,7 @@ static xmlSecTransformKlass xmlSecOpenSSLRsaPkcs1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLRsaPkcs1Execute,               /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -122,7 +123,7 @@ xmlSecOpenSSLTransformRsaPkcs1GetKlass(void) {
 #ifndef XMLSEC_OPENSSL_API_300
 
 static int
-xmlSecOpenSSLRsaPkcs1SetKeyImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, EVP_PKEY* pKey,
+xmlSecOpenSSLRsaPkcs1SetKeyImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, xmlSecKeyDataPtr keyValue, EVP_PKEY* pKey,
                                 int encrypt ATTRIBUTE_UNUSED) {
     RSA *rsa = NULL;
     int keyLen;
@@ -130,6 +131,7 @@ xmlSecOpenSSLRsaPkcs1SetKeyImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, EVP_PKEY* pKey,
     xmlSecAssert2(ctx != NULL, -1);
     xmlSecAssert2(ctx->pKey == NULL, -1);
     xmlSecAssert2(pKey != NULL, -1);
+    UNREFERENCED_PARAMETER(keyValue);
     UNREFERENCED_PARAMETER(encrypt);
 
     rsa = EVP_PKEY_get0_RSA(pKey);
@@ -196,13 +198,13 @@ xmlSecOpenSSLRsaPkcs1ProcessImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, const xmlSecBy
 #else /* XMLSEC_OPENSSL_API_300 */
 
 static int
-xmlSecOpenSSLRsaPkcs1SetKeyImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, EVP_PKEY* pKey,
+xmlSecOpenSSLRsaPkcs1SetKeyImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, xmlSecKeyDataPtr keyValue, EVP_PKEY* pKey,
                                 int encrypt) {
     int keyLen;
-    int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
     xmlSecAssert2(ctx->pKeyCtx == NULL, -1);
+    xmlSecAssert2(keyValue != NULL, -1);
     xmlSecAssert2(pKey != NULL, -1);
 
     keyLen = EVP_PKEY_get_size(pKey);
@@ -212,29 +214,10 @@ xmlSecOpenSSLRsaPkcs1SetKeyImpl(xmlSecOpenSSLRsaPkcs1CtxPtr ctx, EVP_PKEY* pKey,
     }
     XMLSEC_SAFE_CAST_INT_TO_SIZE(keyLen, ctx->keySize, return(-1), NULL);
 
-    ctx->pKeyCtx = EVP_PKEY_CTX_new_from_pkey(xmlSecOpenSSLGetLibCtx(), pKey, NULL);
+    ctx->pKeyCtx = xmlSecOpenSSLKeyDataRsaGetPKeyCtx(keyValue, encrypt,
+        RSA_PKCS1_PADDING, NULL, NULL, NULL, 0);
     if (ctx->pKeyCtx == NULL) {
-        xmlSecOpenSSLError("EVP_PKEY_CTX_new_from_pkey", NULL);
-        return (-1);
-    }
-
-    if (encrypt != 0) {
-        ret = EVP_PKEY_encrypt_init(ctx->pKeyCtx);
-        if (ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_encrypt_init", NULL);
-            return (-1);
-        }
-    } else {
-        ret = EVP_PKEY_decrypt_init(ctx->pKeyCtx);
-        if (ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_decrypt_init", NULL);
-            return (-1);
-        }
-    }
-
-    ret = EVP_PKEY_CTX_set_rsa_padding(ctx->pKeyCtx, RSA_PKCS1_PADDING);
-    if (ret <= 0) {
-        xmlSecOpenSSLError("EVP_PKEY_CTX_set_rsa_padding", NULL);
+        xmlSecInternalError("xmlSecOpenSSLKeyDataRsaGetPKeyCtx", NULL);
         return (-1);
     }
 
@@ -377,7 +360,7 @@ xmlSecOpenSSLRsaPkcs1SetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key) {
         return(-1);
     }
 
-    ret = xmlSecOpenSSLRsaPkcs1SetKeyImpl(ctx, pKey, encrypt);
+    ret = xmlSecOpenSSLRsaPkcs1SetKeyImpl(ctx, xmlSecKeyGetValue(key), pKey, encrypt);
     if(ret < 0) {
         xmlSecInternalError("xmlSecOpenSSLRsaPkcs1SetKeyImpl",
             xmlSecTransformGetName(transform));
@@ -527,7 +510,6 @@ struct _xmlSecOpenSSLRsaOaepCtx {
     EVP_PKEY_CTX*       pKeyCtx;
     const char*         mdName;
     const char*         mgf1mdName;
-    int                 paramsInitialized;
 #endif /* XMLSEC_OPENSSL_API_300 */
     xmlSecSize          keySize;
     xmlSecBuffer        oaepParams;
@@ -580,7 +562,7 @@ static xmlSecTransformKlass xmlSecOpenSSLRsaOaepKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLRsaOaepExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -619,7 +601,7 @@ static xmlSecTransformKlass xmlSecOpenSSLRsaOaepEnc11Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLRsaOaepExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -650,7 +632,7 @@ xmlSecOpenSSLRsaOaepCheckId(xmlSecTransformPtr transform) {
 #ifndef XMLSEC_OPENSSL_API_300
 
 static int
-xmlSecOpenSSLRsaOaepSetKeyImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, EVP_PKEY* pKey,
+xmlSecOpenSSLRsaOaepSetKeyImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, xmlSecKeyDataPtr keyValue, EVP_PKEY* pKey,
                             int encrypt ATTRIBUTE_UNUSED) {
     RSA *rsa = NULL;
     int keyLen;
@@ -658,6 +640,7 @@ xmlSecOpenSSLRsaOaepSetKeyImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, EVP_PKEY* pKey,
     xmlSecAssert2(ctx != NULL, -1);
     xmlSecAssert2(ctx->pKey == NULL, -1);
     xmlSecAssert2(pKey != NULL, -1);
+    UNREFERENCED_PARAMETER(keyValue);
     UNREFERENCED_PARAMETER(encrypt);
 
     rsa = EVP_PKEY_get0_RSA(pKey);
@@ -803,13 +786,13 @@ xmlSecOpenSSLRsaOaepProcessImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, const xmlSecByte
 #else /* XMLSEC_OPENSSL_API_300 */
 
 static int
-xmlSecOpenSSLRsaOaepSetKeyImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, EVP_PKEY* pKey,
+xmlSecOpenSSLRsaOaepSetKeyImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, xmlSecKeyDataPtr keyValue, EVP_PKEY* pKey,
                             int encrypt) {
     int keyLen;
-    int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
     xmlSecAssert2(ctx->pKeyCtx == NULL, -1);
+    xmlSecAssert2(keyValue != NULL, -1);
     xmlSecAssert2(pKey != NULL, -1);
 
     keyLen = EVP_PKEY_get_size(pKey);
@@ -819,104 +802,18 @@ xmlSecOpenSSLRsaOaepSetKeyImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, EVP_PKEY* pKey,
     }
     XMLSEC_SAFE_CAST_INT_TO_SIZE(keyLen, ctx->keySize, return(-1), NULL);
 
-    ctx->pKeyCtx = EVP_PKEY_CTX_new_from_pkey(xmlSecOpenSSLGetLibCtx(), pKey, NULL);
+    ctx->pKeyCtx = xmlSecOpenSSLKeyDataRsaGetPKeyCtx(keyValue, encrypt,
+        RSA_PKCS1_OAEP_PADDING, ctx->mdName, ctx->mgf1mdName,
+        xmlSecBufferGetData(&(ctx->oaepParams)), xmlSecBufferGetSize(&(ctx->oaepParams)));
     if (ctx->pKeyCtx == NULL) {
-        xmlSecOpenSSLError("EVP_PKEY_CTX_new_from_pkey", NULL);
+        xmlSecInternalError("xmlSecOpenSSLKeyDataRsaGetPKeyCtx", NULL);
         return (-1);
     }
 
-    if (encrypt != 0) {
-        ret = EVP_PKEY_encrypt_init(ctx->pKeyCtx);
-        if (ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_encrypt_init", NULL);
-            return (-1);
-        }
-    } else {
-        ret = EVP_PKEY_decrypt_init(ctx->pKeyCtx);
-        if (ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_decrypt_init", NULL);
-            return (-1);
-        }
-    }
-
-    ret = EVP_PKEY_CTX_set_rsa_padding(ctx->pKeyCtx, RSA_PKCS1_OAEP_PADDING);
-    if (ret <= 0) {
-         xmlSecOpenSSLError("EVP_PKEY_CTX_set_rsa_padding", NULL);
-        return(-1);
-    }
-
     /* success */
     return(0);
 }
 
-// We can put all the params into one OSSL_PARAM array and setup everything at-once.
-// However, in OpenSSL <= 3.0.7 there is a bug that mixes OAEP digest and
-// OAEP MGf1 digest (https://pullanswer.com/questions/mgf1-digest-not-set-correctly-when-configuring-rsa-evp_pkey_ctx-with-ossl_params)
-// so we do one param at a time.
-static int
-xmlSecOpenSSSLRsaOaepSetParamsIfNeeded(xmlSecOpenSSLRsaOaepCtxPtr ctx) {
-    xmlSecByte* label;
-    xmlSecSize labelSize;
-    int ret;
-    int res = -1;
-
-    xmlSecAssert2(ctx != NULL, -1);
-    xmlSecAssert2(ctx->pKeyCtx != NULL, -1);
-
-    /* check if we already initialized oaep params */
-    if(ctx->paramsInitialized != 0) {
-        return(0);
-    }
-
-    /* OAEP label */
-    label = xmlSecBufferGetData(&(ctx->oaepParams));
-    labelSize = xmlSecBufferGetSize(&(ctx->oaepParams));
-    if((label != NULL) && (labelSize > 0)) {
-        OSSL_PARAM params[2];
-        params[0] = OSSL_PARAM_construct_octet_string(OSSL_ASYM_CIPHER_PARAM_OAEP_LABEL, label, labelSize);
-        params[1] = OSSL_PARAM_construct_end();
-
-        ret = EVP_PKEY_CTX_set_params(ctx->pKeyCtx, params);
-        if(ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_CTX_set_params", NULL);
-            goto done;
-        }
-    }
-
-    /* Digest */
-    if(ctx->mdName != NULL) {
-        OSSL_PARAM params[2];
-        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_ASYM_CIPHER_PARAM_OAEP_DIGEST, (char*)ctx->mdName, 0);
-        params[1] = OSSL_PARAM_construct_end();
-
-        ret = EVP_PKEY_CTX_set_params(ctx->pKeyCtx, params);
-        if(ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_CTX_set_params", NULL);
-            goto done;
-        }
-    }
-
-    /* MGF1 digest */
-    if(ctx->mgf1mdName != NULL) {
-        OSSL_PARAM params[2];
-        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_ASYM_CIPHER_PARAM_MGF1_DIGEST, (char*)ctx->mgf1mdName, 0);
-        params[1] = OSSL_PARAM_construct_end();
-
-        ret = EVP_PKEY_CTX_set_params(ctx->pKeyCtx, params);
-        if(ret <= 0) {
-            xmlSecOpenSSLError("EVP_PKEY_CTX_set_params", NULL);
-            goto done;
-        }
-    }
-
-    /* success */
-    ctx->paramsInitialized = 1;
-    res = 0;
-
-done:
-    return(res);
-}
-
 static int
 xmlSecOpenSSLRsaOaepProcessImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, const xmlSecByte* inBuf, xmlSecSize inSize,
                             xmlSecByte* outBuf, xmlSecSize* outSize, int encrypt) {
@@ -930,12 +827,6 @@ xmlSecOpenSSLRsaOaepProcessImpl(xmlSecOpenSSLRsaOaepCtxPtr ctx, const xmlSecByte
     xmlSecAssert2(outBuf != NULL, -1);
     xmlSecAssert2(outSize != NULL, -1);
 
-    ret = xmlSecOpenSSSLRsaOaepSetParamsIfNeeded(ctx);
-    if(ret != 0) {
-        xmlSecInternalError("xmlSecOpenSSSLRsaOaepSetParamsIfNeeded", NULL);
-        return(-1);
-    }
-
     outSizeT = (*outSize);
     if(encrypt != 0) {
         ret = EVP_PKEY_encrypt(ctx->pKeyCtx, outBuf, &outSizeT, inBuf, inSize);
@@ -1235,7 +1126,7 @@ xmlSecOpenSSLRsaOaepSetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key) {
         return(-1);
     }
 
-    ret = xmlSecOpenSSLRsaOaepSetKeyImpl(ctx, pKey, encrypt);
+    ret = xmlSecOpenSSLRsaOaepSetKeyImpl(ctx, xmlSecKeyGetValue(key), pKey, encrypt);
     if(ret < 0) {
         xmlSecInternalError("xmlSecOpenSSLKeyDataRsaGetEvp",
             xmlSecTransformGetName(transform));
@@ -29,6 +29,58 @@ extern "C" {
 
 
 
+/******************************************************************************
+ *
+ * EVP keys
+ *
+ ******************************************************************************/
+#ifdef XMLSEC_OPENSSL_API_300
+typedef struct _xmlSecOpenSSLEvpPKeyCtxCache    xmlSecOpenSSLEvpPKeyCtxCache,
+                                                *xmlSecOpenSSLEvpPKeyCtxCachePtr;
+
+EVP_PKEY_CTX*   xmlSecOpenSSLEvpKeyDataGetDerivePKeyCtx         (xmlSecKeyDataPtr data);
+
+#ifndef XMLSEC_NO_RSA
+EVP_PKEY_CTX*   xmlSecOpenSSLKeyDataRsaGetPKeyCtx               (xmlSecKeyDataPtr data,
+                                                                 int encrypt,
+                                                                 int padding,
+                                                                 const char* mdName,
+                                                                 const char* mgf1mdName,
+                                                                 const xmlSecByte* label,
+                                                                 xmlSecSize labelSize);
+#endif /* XMLSEC_NO_RSA */
+#endif /* XMLSEC_OPENSSL_API_300 */
+
+/******************************************************************************
+ *
+ * Multi-buffer SHA-2 digests (several messages at once, see digests_mb.c)
+ *
+ ******************************************************************************/
+int             xmlSecOpenSSLEvpDigestRegisterExecuteBatch      (int enable);
+
+#if defined(__GNUC__) && !defined(XMLSEC_NO_SHA256) && !defined(XMLSEC_NO_SHA512)
+#define XMLSEC_OPENSSL_MB_DIGEST                1
+
+/* the lanes lose to the OpenSSL assembly (SHA-NI, AVX2) on the larger messages */
+#define XMLSEC_OPENSSL_MB_DIGEST_MAX_DATA_SIZE  512
+
+typedef enum {
+    xmlSecOpenSSLMbDigestSha224 = 0,
+    xmlSecOpenSSLMbDigestSha256,
+    xmlSecOpenSSLMbDigestSha384,
+    xmlSecOpenSSLMbDigestSha512
+} xmlSecOpenSSLMbDigestType;
+
+int             xmlSecOpenSSLMbDigestIsEnabled                  (xmlSecOpenSSLMbDigestType type,
+                                                                 const EVP_MD* md);
+int             xmlSecOpenSSLMbDigest                           (xmlSecOpenSSLMbDigestType type,
+                                                                 const xmlSecByte** data,
+                                                                 const xmlSecSize* dataSizes,
+                                                                 xmlSecByte** dgsts,
+                                                                 xmlSecSize count);
+
+#endif /* defined(__GNUC__) && !defined(XMLSEC_NO_SHA256) && !defined(XMLSEC_NO_SHA512) */
+
 /******************************************************************************
  *
  * X509 Util functions
@@ -62,7 +114,7 @@ int             xmlSecOpenSSLX509FindCertCtxMatch               (xmlSecOpenSSLX5
                                                                  X509* cert);
 
 
-
+/* returns a new reference to the found cert */
 X509*           xmlSecOpenSSLX509StoreFindCertByValue           (xmlSecKeyDataStorePtr store,
                                                                  xmlSecKeyX509DataValuePtr x509Value);
 
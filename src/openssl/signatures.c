@@ -87,6 +87,8 @@ struct _xmlSecOpenSSLEvpSignatureCtx {
     xmlSecSize          keySize;
     xmlSecOpenSSLEvpSignatureMode mode;
     int                 rsaPadding;
+    xmlSecByte          dgst[EVP_MAX_MD_SIZE];  /* calculated by xmlSecOpenSSLEvpSignatureExecuteOnce() */
+    unsigned int        dgstSize;
 };
 
 
@@ -132,6 +134,10 @@ static int      xmlSecOpenSSLEvpSignatureVerify                 (xmlSecTransform
 static int      xmlSecOpenSSLEvpSignatureExecute                (xmlSecTransformPtr transform,
                                                                  int last,
                                                                  xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLEvpSignatureExecuteOnce            (xmlSecTransformPtr transform,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 
 
 /* Helper macro to define the transform klass */
@@ -155,7 +161,7 @@ static xmlSecTransformKlass xmlSecOpenSSL ## name ## Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */             \
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */               \
     xmlSecOpenSSLEvpSignatureExecute,           /* xmlSecTransformExecuteMethod execute; */             \
-    NULL,                                       /* void* reserved0; */                                  \
+    xmlSecOpenSSLEvpSignatureExecuteOnce,       /* xmlSecTransformExecuteOnceMethod executeOnce; */     \
     NULL,                                       /* void* reserved1; */                                  \
 };
 
@@ -869,6 +875,13 @@ xmlSecOpenSSLEvpSignatureCalculateDigest(xmlSecTransformPtr transform, xmlSecOpe
     xmlSecAssert2(dgstSize != NULL, -1);
     xmlSecAssert2((*dgstSize) > 0, -1);
 
+    if(ctx->dgstSize > 0) {
+        xmlSecAssert2(ctx->dgstSize <= (*dgstSize), -1);
+        memcpy(dgst, ctx->dgst, ctx->dgstSize);
+        (*dgstSize) = ctx->dgstSize;
+        return(0);
+    }
+
     ret = EVP_MD_size(ctx->digest);
     if (ret <= 0) {
         xmlSecOpenSSLError("EVP_MD_size", xmlSecTransformGetName(transform));
@@ -1272,6 +1285,62 @@ xmlSecOpenSSLEvpSignatureExecute(xmlSecTransformPtr transform, int last, xmlSecT
     return(0);
 }
 
+static int
+xmlSecOpenSSLEvpSignatureExecuteOnce(xmlSecTransformPtr transform, const xmlSecByte* data,
+                                     xmlSecSize dataSize, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecOpenSSLEvpSignatureCtxPtr ctx;
+    unsigned int dgstSize;
+    int ret;
+
+    xmlSecAssert2(xmlSecOpenSSLEvpSignatureCheckId(transform), -1);
+    xmlSecAssert2((transform->operation == xmlSecTransformOperationSign) || (transform->operation == xmlSecTransformOperationVerify), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLEvpSignatureSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusNone, -1);
+    xmlSecAssert2((data != NULL) || (dataSize == 0), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecOpenSSLEvpSignatureGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digest != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+    xmlSecAssert2(ctx->pKey != NULL, -1);
+    xmlSecAssert2(xmlSecBufferGetSize(&(transform->outBuf)) == 0, -1);
+
+    /* the digest is used by xmlSecOpenSSLEvpSignatureSign() now or by
+     * xmlSecOpenSSLEvpSignatureVerify() later */
+    ret = EVP_DigestInit(ctx->digestCtx, ctx->digest);
+    if(ret != 1) {
+        xmlSecOpenSSLError("EVP_DigestInit", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    if(dataSize > 0) {
+        ret = EVP_DigestUpdate(ctx->digestCtx, data, dataSize);
+        if(ret != 1) {
+            xmlSecOpenSSLError2("EVP_DigestUpdate", xmlSecTransformGetName(transform),
+                "size=" XMLSEC_SIZE_FMT, dataSize);
+            return(-1);
+        }
+    }
+    dgstSize = sizeof(ctx->dgst);
+    ret = EVP_DigestFinal(ctx->digestCtx, ctx->dgst, &dgstSize);
+    if(ret != 1) {
+        xmlSecOpenSSLError("EVP_DigestFinal", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    xmlSecAssert2(dgstSize > 0, -1);
+    ctx->dgstSize = dgstSize;
+
+    if(transform->operation == xmlSecTransformOperationSign) {
+        ret = xmlSecOpenSSLEvpSignatureSign(transform, ctx, &(transform->outBuf));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecOpenSSLEvpSignatureSign", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+    }
+    transform->status = xmlSecTransformStatusFinished;
+    return(0);
+}
+
 
 /*************************************************************************
  *
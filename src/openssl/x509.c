@@ -56,6 +56,7 @@
 
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
+#include "../trace_helpers.h"
 
 #include "private.h"
 #include "openssl_compat.h"
@@ -878,13 +879,9 @@ xmlSecOpenSSLKeyDataX509Read(xmlSecKeyDataPtr data, xmlSecKeyX509DataValuePtr x5
             xmlSecOtherError(XMLSEC_ERRORS_R_CERT_NOT_FOUND, xmlSecKeyDataGetName(data), "cert lookup");
             goto done;
         }
-        /* if we found cert in a store, then duplicate it for key data */
+        /* if we found cert in a store, then we own a reference to it */
         if(storeCert != NULL) {
-            cert = X509_dup(storeCert);
-            if(cert == NULL) {
-                xmlSecOpenSSLError("X509_dup", xmlSecKeyDataGetName(data));
-                goto done;
-            }
+            cert = storeCert;
         }
     }
 
@@ -1401,36 +1398,31 @@ extern time_t timegm (struct tm *tm);
 
 #elif !defined(XMLSEC_WINDOWS)
 
-/* Absolutely not the best way but it's the only ANSI compatible way I know.
- * If you system has a native struct tm --> GMT time_t conversion function
- * (like timegm) use it instead.
+/* The struct tm (GMT) --> time_t conversion without mktime() and gmtime():
+ * they use the local timezone and the static buffer which is not thread safe.
+ * The days from the civil date are calculated as in the proleptic Gregorian
+ * calendar, the years are shifted to start in March.
  */
 static time_t
 my_timegm(struct tm *t) {
-    time_t tl, tb;
-    struct tm *tg;
-
-    tl = mktime (t);
-    if(tl == -1) {
-        t->tm_hour--;
-        tl = mktime (t);
-        if (tl == -1) {
-            return (-1);
-        }
-        tl += 3600;
-    }
-    tg = gmtime (&tl);
-    tg->tm_isdst = 0;
-    tb = mktime (tg);
-    if (tb == -1) {
-        tg->tm_hour--;
-        tb = mktime (tg);
-        if (tb == -1) {
-            return (-1);
-        }
-        tb += 3600;
+    long year, month, era, yoe, doy, doe, days;
+
+    year = (long)t->tm_year + 1900 + (long)(t->tm_mon / 12);
+    month = (long)(t->tm_mon % 12);
+    if(month < 0) {
+        month += 12;
+        --year;
+    }
+    if(month < 2) {
+        --year;
     }
-    return (tl - (tb - tl));
+    era = ((year >= 0) ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * ((month >= 2) ? month - 2 : month + 10) + 2) / 5 + (long)t->tm_mday - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + doe - 719468;
+
+    return((time_t)days * 86400 + (time_t)t->tm_hour * 3600 + (time_t)t->tm_min * 60 + (time_t)t->tm_sec);
 }
 
 #define timegm(tm) my_timegm(tm)
@@ -1554,6 +1546,7 @@ xmlSecOpenSSLVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data,
     xmlSecKeyDataPtr keyValue;
     X509* cert;
     X509* keyCert;
+    xmlSecTraceSpan span;
     int ret;
 
     xmlSecAssert2(xmlSecKeyDataCheckId(data, xmlSecOpenSSLKeyDataX509Id), -1);
@@ -1576,7 +1569,9 @@ xmlSecOpenSSLVerifyAndAdoptX509KeyData(xmlSecKeyPtr key, xmlSecKeyDataPtr data,
         xmlSecInternalError("xmlSecKeysMngrGetDataStore", xmlSecKeyDataGetName(data));
         return(-1);
     }
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeX509Verify, keyInfoCtx, NULL, NULL);
     cert = xmlSecOpenSSLX509StoreVerify(x509Store, ctx->certsList, ctx->crlsList, keyInfoCtx);
+    XMLSEC_TRACE_SPAN_END(&span, 0, (cert != NULL) ? 0 : -1);
     if(cert == NULL) {
         /* check if we want to fail if cert is not found */
         if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_X509DATA_STOP_ON_INVALID_CERT) != 0) {
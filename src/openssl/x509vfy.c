@@ -42,6 +42,7 @@
 #include <openssl/x509v3.h>
 
 #include "../cast_helpers.h"
+#include "../registry.h"
 #include "openssl_compat.h"
 #include "private.h"
 
@@ -59,12 +60,51 @@ typedef int x509_size_t;
 typedef struct _xmlSecOpenSSLX509StoreCtx               xmlSecOpenSSLX509StoreCtx,
                                                         *xmlSecOpenSSLX509StoreCtxPtr;
 struct _xmlSecOpenSSLX509StoreCtx {
-    X509_STORE*         xst;
-    STACK_OF(X509)*     untrusted;
-    STACK_OF(X509_CRL)* crls;
+    X509_STORE*         xst;            /* trusted certs, OpenSSL does the locking */
+    xmlSecPtrRegistry   untrusted;      /* untrusted certs, lock-free reads */
+    xmlSecPtrRegistry   crls;           /* crls, lock-free reads */
+    xmlSecPtrRegistry   found;          /* the certs returned by the deprecated find functions */
     X509_VERIFY_PARAM * vpm;
 };
 
+/****************************************************************************
+ *
+ * X509 certs and CRLs lists: the store owns the items
+ *
+ ***************************************************************************/
+static void             xmlSecOpenSSLX509CertListDestroyItem    (xmlSecPtr ptr);
+static void             xmlSecOpenSSLX509CrlListDestroyItem     (xmlSecPtr ptr);
+
+static xmlSecPtrListKlass xmlSecOpenSSLX509CertListKlass = {
+    BAD_CAST "openssl-x509-cert-list",
+    NULL,                                       /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    xmlSecOpenSSLX509CertListDestroyItem,       /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+static xmlSecPtrListKlass xmlSecOpenSSLX509CrlListKlass = {
+    BAD_CAST "openssl-x509-crl-list",
+    NULL,                                       /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    xmlSecOpenSSLX509CrlListDestroyItem,        /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+static void
+xmlSecOpenSSLX509CertListDestroyItem(xmlSecPtr ptr) {
+    xmlSecAssert(ptr != NULL);
+
+    X509_free((X509*)ptr);
+}
+
+static void
+xmlSecOpenSSLX509CrlListDestroyItem(xmlSecPtr ptr) {
+    xmlSecAssert(ptr != NULL);
+
+    X509_CRL_free((X509_CRL*)ptr);
+}
+
 /****************************************************************************
  *
  * xmlSecOpenSSLKeyDataStoreX509Id:
@@ -107,6 +147,10 @@ static int              xmlSecOpenSSLX509NameStringRead                 (const x
                                                                          xmlSecSize *outWritten,
                                                                          xmlSecByte delim,
                                                                          int ingoreTrailingSpaces);
+static int              xmlSecOpenSSLX509StoreIsSupersededCrl           (xmlSecPtr item,
+                                                                         void* ctx);
+static int              xmlSecOpenSSLX509StoreIsRemovedCert             (xmlSecPtr item,
+                                                                         void* ctx);
 static int              xmlSecOpenSSLX509NamesCompare                   (X509_NAME *a,
                                                                          X509_NAME *b);
 static STACK_OF(X509_NAME_ENTRY)*  xmlSecOpenSSLX509_NAME_ENTRIES_copy  (X509_NAME *a);
@@ -116,7 +160,8 @@ static int              xmlSecOpenSSLX509_NAME_ENTRY_cmp                (const X
                                                                          const X509_NAME_ENTRY * const *b);
 
 static STACK_OF(X509)*  xmlSecOpenSSLX509StoreCombineCerts              (STACK_OF(X509)* certs1,
-                                                                         STACK_OF(X509)* certs2);
+                                                                         xmlSecPtrListPtr certs2);
+static STACK_OF(X509_CRL)* xmlSecOpenSSLX509StoreCopyCrls               (xmlSecPtrListPtr crls);
 /**
  * xmlSecOpenSSLX509StoreGetKlass:
  *
@@ -139,6 +184,8 @@ xmlSecOpenSSLX509StoreGetKlass(void) {
  * @keyInfoCtx:         the pointer to &lt;dsig:KeyInfo/&gt; element processing context.
  *
  * Deprecated. Searches @store for a certificate that matches given criteria.
+ * The returned certificate is owned by the @store and might be freed by
+ * a concurrent xmlSecOpenSSLX509StoreUpdateCerts() call.
  *
  * Returns: pointer to found certificate or NULL if certificate is not found
  * or an error occurs.
@@ -180,8 +227,8 @@ xmlSecOpenSSLX509StoreFindCert(xmlSecKeyDataStorePtr store, xmlChar *subjectName
  *
  * Deprecated. Searches @store for a certificate that matches given criteria.
  *
- * Returns: pointer to found certificate or NULL if certificate is not found
- * or an error occurs.
+ * Returns: pointer to found certificate (owned by the @store until it is
+ * destroyed) or NULL if certificate is not found or an error occurs.
  */
 X509*
 xmlSecOpenSSLX509StoreFindCert_ex(xmlSecKeyDataStorePtr store,
@@ -192,7 +239,8 @@ xmlSecOpenSSLX509StoreFindCert_ex(xmlSecKeyDataStorePtr store,
 ) {
     xmlSecOpenSSLX509StoreCtxPtr ctx;
     xmlSecOpenSSLX509FindCertCtx findCertCtx;
-    x509_size_t ii;
+    xmlSecPtrListPtr untrusted;
+    xmlSecSize ii, size;
     int ret;
     X509* res = NULL;
 
@@ -203,7 +251,9 @@ xmlSecOpenSSLX509StoreFindCert_ex(xmlSecKeyDataStorePtr store,
     xmlSecAssert2(ctx != NULL, NULL);
 
     /* do we have any certs at all? */
-    if(ctx->untrusted == NULL) {
+    untrusted = xmlSecPtrRegistryReadBegin(&(ctx->untrusted));
+    if((untrusted == NULL) || (xmlSecPtrListGetSize(untrusted) <= 0)) {
+        xmlSecPtrRegistryReadEnd(&(ctx->untrusted), untrusted);
         return(NULL);
     }
     ret = xmlSecOpenSSLX509FindCertCtxInitialize(&findCertCtx,
@@ -212,11 +262,11 @@ xmlSecOpenSSLX509StoreFindCert_ex(xmlSecKeyDataStorePtr store,
             ski, skiSize);
     if(ret < 0) {
         xmlSecInternalError("xmlSecOpenSSLX509FindCertCtxInitialize", NULL);
-        xmlSecOpenSSLX509FindCertCtxFinalize(&findCertCtx);
-        return(NULL);
+        goto done;
     }
-    for(ii = 0; ii < sk_X509_num(ctx->untrusted); ++ii) {
-        X509 * cert = sk_X509_value(ctx->untrusted, ii);
+    size = xmlSecPtrListGetSize(untrusted);
+    for(ii = 0; ii < size; ++ii) {
+        X509 * cert = (X509*)xmlSecPtrListGetItem(untrusted, ii);
         if(cert == NULL) {
             continue;
         }
@@ -224,16 +274,28 @@ xmlSecOpenSSLX509StoreFindCert_ex(xmlSecKeyDataStorePtr store,
         ret = xmlSecOpenSSLX509FindCertCtxMatch(&findCertCtx, cert);
         if(ret < 0) {
             xmlSecInternalError("xmlSecOpenSSLX509FindCertCtxMatch", NULL);
-            xmlSecOpenSSLX509FindCertCtxFinalize(&findCertCtx);
-            return(NULL);
+            goto done;
         } else if(ret == 1) {
+            /* the cert can be removed by xmlSecOpenSSLX509StoreUpdateCerts()
+             * after we are done reading: the store keeps its own reference */
+            if(X509_up_ref(cert) != 1) {
+                xmlSecOpenSSLError("X509_up_ref", NULL);
+                goto done;
+            }
+            ret = xmlSecPtrRegistryAdd(&(ctx->found), cert);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecPtrRegistryAdd(found)", NULL);
+                X509_free(cert);
+                goto done;
+            }
             res = cert;
             break;
         }
     }
 
-    /* done */
+done:
     xmlSecOpenSSLX509FindCertCtxFinalize(&findCertCtx);
+    xmlSecPtrRegistryReadEnd(&(ctx->untrusted), untrusted);
     return(res);
 }
 
@@ -241,7 +303,8 @@ X509*
 xmlSecOpenSSLX509StoreFindCertByValue(xmlSecKeyDataStorePtr store, xmlSecKeyX509DataValuePtr x509Value) {
     xmlSecOpenSSLX509StoreCtxPtr ctx;
     xmlSecOpenSSLX509FindCertCtx findCertCtx;
-    x509_size_t ii;
+    xmlSecPtrListPtr untrusted;
+    xmlSecSize ii, size;
     int ret;
     X509* res = NULL;
 
@@ -253,17 +316,19 @@ xmlSecOpenSSLX509StoreFindCertByValue(xmlSecKeyDataStorePtr store, xmlSecKeyX509
     xmlSecAssert2(ctx != NULL, NULL);
 
     /* do we have any certs at all? */
-    if(ctx->untrusted == NULL) {
+    untrusted = xmlSecPtrRegistryReadBegin(&(ctx->untrusted));
+    if((untrusted == NULL) || (xmlSecPtrListGetSize(untrusted) <= 0)) {
+        xmlSecPtrRegistryReadEnd(&(ctx->untrusted), untrusted);
         return(NULL);
     }
     ret = xmlSecOpenSSLX509FindCertCtxInitializeFromValue(&findCertCtx, x509Value);
     if(ret < 0) {
         xmlSecInternalError("xmlSecOpenSSLX509FindCertCtxInitializeFromValue", NULL);
-        xmlSecOpenSSLX509FindCertCtxFinalize(&findCertCtx);
-        return(NULL);
+        goto done;
     }
-    for(ii = 0; ii < sk_X509_num(ctx->untrusted); ++ii) {
-        X509 * cert = sk_X509_value(ctx->untrusted, ii);
+    size = xmlSecPtrListGetSize(untrusted);
+    for(ii = 0; ii < size; ++ii) {
+        X509 * cert = (X509*)xmlSecPtrListGetItem(untrusted, ii);
         if(cert == NULL) {
             continue;
         }
@@ -271,16 +336,21 @@ xmlSecOpenSSLX509StoreFindCertByValue(xmlSecKeyDataStorePtr store, xmlSecKeyX509
         ret = xmlSecOpenSSLX509FindCertCtxMatch(&findCertCtx, cert);
         if(ret < 0) {
             xmlSecInternalError("xmlSecOpenSSLX509FindCertCtxMatch", NULL);
-            xmlSecOpenSSLX509FindCertCtxFinalize(&findCertCtx);
-            return(NULL);
+            goto done;
         } else if(ret == 1) {
+            /* the cert might be removed from the store once we are done */
+            if(X509_up_ref(cert) != 1) {
+                xmlSecOpenSSLError("X509_up_ref", NULL);
+                goto done;
+            }
             res = cert;
             break;
         }
     }
 
-    /* done */
+done:
     xmlSecOpenSSLX509FindCertCtxFinalize(&findCertCtx);
+    xmlSecPtrRegistryReadEnd(&(ctx->untrusted), untrusted);
     return(res);
 }
 
@@ -809,6 +879,9 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
     xmlSecOpenSSLX509StoreCtxPtr ctx;
     STACK_OF(X509)* all_untrusted_certs = NULL;
     STACK_OF(X509_CRL)* verified_crls = NULL;
+    STACK_OF(X509_CRL)* store_crls = NULL;
+    xmlSecPtrListPtr untrusted_snapshot = NULL;
+    xmlSecPtrListPtr crls_snapshot = NULL;
     X509 * res = NULL;
     X509 * cert;
     X509_STORE_CTX *xsc = NULL;
@@ -830,12 +903,21 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
         goto done;
     }
 
-    /* create a combined list of all untrusted certs*/
-    all_untrusted_certs = xmlSecOpenSSLX509StoreCombineCerts(certs, ctx->untrusted);
+    /* create a combined list of all untrusted certs and a copy of the store crls
+     * from the current snapshots: other threads might adopt or remove certs or crls
+     * while we are verifying */
+    untrusted_snapshot = xmlSecPtrRegistryReadBegin(&(ctx->untrusted));
+    crls_snapshot = xmlSecPtrRegistryReadBegin(&(ctx->crls));
+    all_untrusted_certs = xmlSecOpenSSLX509StoreCombineCerts(certs, untrusted_snapshot);
+    store_crls = xmlSecOpenSSLX509StoreCopyCrls(crls_snapshot);
     if(all_untrusted_certs == NULL) {
         xmlSecInternalError("xmlSecOpenSSLX509StoreCombineCerts", NULL);
         goto done;
     }
+    if(store_crls == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLX509StoreCopyCrls", NULL);
+        goto done;
+    }
 
     /* copy crls list but remove all non-verified (we assume that CRLs in the store are already verified) */
     verified_crls = xmlSecOpenSSLX509StoreVerifyAndCopyCrls(ctx->xst, xsc, all_untrusted_certs, crls, keyInfoCtx);
@@ -859,7 +941,7 @@ xmlSecOpenSSLX509StoreVerify(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509*
             goto done;
         }
 
-        ret = xmlSecOpenSSLX509StoreVerifyCert(ctx->xst, xsc, cert, all_untrusted_certs, verified_crls, ctx->crls, keyInfoCtx);
+        ret = xmlSecOpenSSLX509StoreVerifyCert(ctx->xst, xsc, cert, all_untrusted_certs, verified_crls, store_crls, keyInfoCtx);
         if(ret < 0) {
             xmlSecInternalError("xmlSecOpenSSLX509StoreVerifyCert", xmlSecKeyDataStoreGetName(store));
             goto done;
@@ -882,6 +964,11 @@ done:
     if(verified_crls != NULL) {
         sk_X509_CRL_free(verified_crls);
     }
+    if(store_crls != NULL) {
+        sk_X509_CRL_free(store_crls);
+    }
+    xmlSecPtrRegistryReadEnd(&(ctx->untrusted), untrusted_snapshot);
+    xmlSecPtrRegistryReadEnd(&(ctx->crls), crls_snapshot);
     if(xsc != NULL) {
         X509_STORE_CTX_free(xsc);
     }
@@ -914,6 +1001,9 @@ xmlSecOpenSSLX509StoreVerifyKey(xmlSecKeyDataStorePtr store, xmlSecKeyPtr key, x
     X509_STORE_CTX *xsc = NULL;
     STACK_OF(X509)* all_untrusted_certs = NULL;
     STACK_OF(X509_CRL)* verified_crls = NULL;
+    STACK_OF(X509_CRL)* store_crls = NULL;
+    xmlSecPtrListPtr untrusted_snapshot = NULL;
+    xmlSecPtrListPtr crls_snapshot = NULL;
     int ret;
     int res = -1;
 
@@ -955,18 +1045,27 @@ xmlSecOpenSSLX509StoreVerifyKey(xmlSecKeyDataStorePtr store, xmlSecKeyPtr key, x
         goto done;
     }
 
-    /* create a combined list of all untrusted certs*/
-    all_untrusted_certs = xmlSecOpenSSLX509StoreCombineCerts(certs, ctx->untrusted);
+    /* create a combined list of all untrusted certs and a copy of the store crls
+     * from the current snapshots: other threads might adopt or remove certs or crls
+     * while we are verifying */
+    untrusted_snapshot = xmlSecPtrRegistryReadBegin(&(ctx->untrusted));
+    crls_snapshot = xmlSecPtrRegistryReadBegin(&(ctx->crls));
+    all_untrusted_certs = xmlSecOpenSSLX509StoreCombineCerts(certs, untrusted_snapshot);
+    store_crls = xmlSecOpenSSLX509StoreCopyCrls(crls_snapshot);
     if(all_untrusted_certs == NULL) {
         xmlSecInternalError("xmlSecOpenSSLX509StoreCombineCerts", xmlSecKeyDataStoreGetName(store));
         goto done;
     }
+    if(store_crls == NULL) {
+        xmlSecInternalError("xmlSecOpenSSLX509StoreCopyCrls", xmlSecKeyDataStoreGetName(store));
+        goto done;
+    }
 
     /* copy crls list but remove all non-verified (we assume that CRLs in the store are already verified) */
     verified_crls = xmlSecOpenSSLX509StoreVerifyAndCopyCrls(ctx->xst, xsc, all_untrusted_certs, crls, keyInfoCtx);
 
     /* verify */
-    ret = xmlSecOpenSSLX509StoreVerifyCert(ctx->xst, xsc, keyCert, all_untrusted_certs, verified_crls, ctx->crls, keyInfoCtx);
+    ret = xmlSecOpenSSLX509StoreVerifyCert(ctx->xst, xsc, keyCert, all_untrusted_certs, verified_crls, store_crls, keyInfoCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecOpenSSLX509StoreVerifyCert", xmlSecKeyDataStoreGetName(store));
         goto done;
@@ -988,6 +1087,11 @@ done:
     if(verified_crls != NULL) {
         sk_X509_CRL_free(verified_crls);
     }
+    if(store_crls != NULL) {
+        sk_X509_CRL_free(store_crls);
+    }
+    xmlSecPtrRegistryReadEnd(&(ctx->untrusted), untrusted_snapshot);
+    xmlSecPtrRegistryReadEnd(&(ctx->crls), crls_snapshot);
     if(xsc != NULL) {
         X509_STORE_CTX_free(xsc);
     }
@@ -1027,11 +1131,9 @@ xmlSecOpenSSLX509StoreAdoptCert(xmlSecKeyDataStorePtr store, X509* cert, xmlSecK
         /* add cert increments the reference */
         X509_free(cert);
     } else {
-        xmlSecAssert2(ctx->untrusted != NULL, -1);
-
-        ret = sk_X509_push(ctx->untrusted, cert);
-        if(ret <= 0) {
-            xmlSecOpenSSLError("sk_X509_push", xmlSecKeyDataStoreGetName(store));
+        ret = xmlSecPtrRegistryAdd(&(ctx->untrusted), cert);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrRegistryAdd", xmlSecKeyDataStoreGetName(store));
             return(-1);
         }
     }
@@ -1050,6 +1152,7 @@ xmlSecOpenSSLX509StoreAdoptCert(xmlSecKeyDataStorePtr store, X509* cert, xmlSecK
 int
 xmlSecOpenSSLX509StoreAdoptCrl(xmlSecKeyDataStorePtr store, X509_CRL* crl) {
     xmlSecOpenSSLX509StoreCtxPtr ctx;
+    xmlSecPtrList add;
     int ret;
 
     xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecOpenSSLX509StoreId), -1);
@@ -1057,17 +1160,224 @@ xmlSecOpenSSLX509StoreAdoptCrl(xmlSecKeyDataStorePtr store, X509_CRL* crl) {
 
     ctx = xmlSecOpenSSLX509StoreGetCtx(store);
     xmlSecAssert2(ctx != NULL, -1);
-        xmlSecAssert2(ctx->crls != NULL, -1);
 
-        ret = sk_X509_CRL_push(ctx->crls, crl);
-        if(ret <= 0) {
-            xmlSecOpenSSLError("sk_X509_CRL_push", xmlSecKeyDataStoreGetName(store));
-            return(-1);
-        }
+    ret = xmlSecPtrListInitialize(&add, &xmlSecOpenSSLX509CrlListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+    ret = xmlSecPtrListAdd(&add, crl);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", xmlSecKeyDataStoreGetName(store));
+        xmlSecPtrListFinalize(&add);
+        return(-1);
+    }
+
+    /* the new CRL replaces the older CRLs from the same issuer */
+    ret = xmlSecPtrRegistryUpdate(&(ctx->crls), &add, xmlSecOpenSSLX509StoreIsSupersededCrl, crl);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryUpdate", xmlSecKeyDataStoreGetName(store));
+        /* the caller still owns the crl */
+        xmlSecPtrListRemoveAndReturn(&add, 0);
+        xmlSecPtrListFinalize(&add);
+        return(-1);
+    }
+    xmlSecPtrListFinalize(&add);
 
     return (0);
 }
 
+/**
+ * xmlSecOpenSSLX509StoreUpdateCerts:
+ * @store:              the pointer to X509 key data store klass.
+ * @addCerts:           the untrusted certificates to add (optional).
+ * @removeCerts:        the untrusted certificates to remove (optional).
+ *
+ * Atomically adds @addCerts and removes the certificates that match
+ * @removeCerts from the untrusted certificates in the @store. The
+ * verifications running in other threads keep using the old certificates
+ * until they are done, the new verifications see all the changes at once.
+ * The trusted certificates can not be removed from the OpenSSL X509_STORE.
+ *
+ * The @store takes a new reference to each certificate in @addCerts,
+ * both stacks are still owned by the caller.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpenSSLX509StoreUpdateCerts(xmlSecKeyDataStorePtr store, XMLSEC_STACK_OF_X509* addCerts,
+    XMLSEC_STACK_OF_X509* removeCerts
+) {
+    xmlSecOpenSSLX509StoreCtxPtr ctx;
+    xmlSecPtrList add;
+    X509* cert;
+    int ii, num;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecOpenSSLX509StoreId), -1);
+
+    ctx = xmlSecOpenSSLX509StoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    ret = xmlSecPtrListInitialize(&add, &xmlSecOpenSSLX509CertListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+
+    num = (addCerts != NULL) ? sk_X509_num(addCerts) : 0;
+    for(ii = 0; ii < num; ++ii) {
+        cert = sk_X509_value(addCerts, ii);
+        if(cert == NULL) {
+            continue;
+        }
+        ret = X509_up_ref(cert);
+        if(ret != 1) {
+            xmlSecOpenSSLError("X509_up_ref", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
+        ret = xmlSecPtrListAdd(&add, cert);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", xmlSecKeyDataStoreGetName(store));
+            X509_free(cert);
+            goto done;
+        }
+    }
+
+    ret = xmlSecPtrRegistryUpdate(&(ctx->untrusted), &add,
+        (removeCerts != NULL) ? xmlSecOpenSSLX509StoreIsRemovedCert : NULL,
+        removeCerts);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryUpdate", xmlSecKeyDataStoreGetName(store));
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    xmlSecPtrListFinalize(&add);
+    return(res);
+}
+
+/* returns the DER of the CRL extension or NULL if the extension is not present */
+static const ASN1_OCTET_STRING*
+xmlSecOpenSSLX509CrlGetExtData(X509_CRL* crl, int nid) {
+    X509_EXTENSION* ext;
+    int pos;
+
+    xmlSecAssert2(crl != NULL, NULL);
+
+    pos = X509_CRL_get_ext_by_NID(crl, nid, -1);
+    if(pos < 0) {
+        return(NULL);
+    }
+    ext = X509_CRL_get_ext(crl, pos);
+    if(ext == NULL) {
+        return(NULL);
+    }
+    return(X509_EXTENSION_get_data(ext));
+}
+
+/* the new CRL replaces the old one only if it is a full CRL for the same
+ * scope (issuer and issuing distribution point) and it is newer: the
+ * partitioned and delta CRLs are accumulated */
+static int
+xmlSecOpenSSLX509StoreIsSupersededCrl(xmlSecPtr item, void* ctx) {
+    X509_CRL* crl = (X509_CRL*)item;
+    X509_CRL* newCrl = (X509_CRL*)ctx;
+    X509_NAME* issuer;
+    X509_NAME* newIssuer;
+    const ASN1_OCTET_STRING* idp;
+    const ASN1_OCTET_STRING* newIdp;
+    ASN1_INTEGER* number;
+    ASN1_INTEGER* newNumber;
+    const ASN1_TIME* lastUpdate;
+    const ASN1_TIME* newLastUpdate;
+    time_t ts;
+    int ret;
+
+    xmlSecAssert2(crl != NULL, -1);
+    xmlSecAssert2(newCrl != NULL, -1);
+
+    issuer = X509_CRL_get_issuer(crl);
+    newIssuer = X509_CRL_get_issuer(newCrl);
+    if((issuer == NULL) || (newIssuer == NULL)) {
+        return(0);
+    }
+    if(xmlSecOpenSSLX509NamesCompare(issuer, newIssuer) != 0) {
+        return(0);
+    }
+
+    /* delta CRLs complement the full CRLs */
+    if((X509_CRL_get_ext_by_NID(crl, NID_delta_crl, -1) >= 0) ||
+       (X509_CRL_get_ext_by_NID(newCrl, NID_delta_crl, -1) >= 0)) {
+        return(0);
+    }
+
+    /* different issuing distribution points are different partitions */
+    idp = xmlSecOpenSSLX509CrlGetExtData(crl, NID_issuing_distribution_point);
+    newIdp = xmlSecOpenSSLX509CrlGetExtData(newCrl, NID_issuing_distribution_point);
+    if((idp != NULL) || (newIdp != NULL)) {
+        if((idp == NULL) || (newIdp == NULL) || (ASN1_OCTET_STRING_cmp(idp, newIdp) != 0)) {
+            return(0);
+        }
+    }
+
+    /* the CRL number is the most reliable way to order the CRLs */
+    number = (ASN1_INTEGER*)X509_CRL_get_ext_d2i(crl, NID_crl_number, NULL, NULL);
+    newNumber = (ASN1_INTEGER*)X509_CRL_get_ext_d2i(newCrl, NID_crl_number, NULL, NULL);
+    if((number != NULL) && (newNumber != NULL)) {
+        ret = ASN1_INTEGER_cmp(number, newNumber);
+        ASN1_INTEGER_free(number);
+        ASN1_INTEGER_free(newNumber);
+        return((ret < 0) ? 1 : 0);
+    }
+    if(number != NULL) {
+        ASN1_INTEGER_free(number);
+    }
+    if(newNumber != NULL) {
+        ASN1_INTEGER_free(newNumber);
+    }
+
+    lastUpdate = X509_CRL_get0_lastUpdate(crl);
+    newLastUpdate = X509_CRL_get0_lastUpdate(newCrl);
+    if((lastUpdate == NULL) || (newLastUpdate == NULL)) {
+        return(0);
+    }
+
+    /* return -1 if asn1_time is earlier than, or equal to, ts
+     * and 1 otherwise. These methods return 0 on error.*/
+    ts = xmlSecOpenSSLX509Asn1TimeToTime(newLastUpdate);
+    ret = X509_cmp_time(lastUpdate, &ts);
+    if(ret == 0) {
+        xmlSecOpenSSLError("X509_cmp_time(lastUpdate)", NULL);
+        return(-1);
+    }
+    return((ret < 0) ? 1 : 0);
+}
+
+static int
+xmlSecOpenSSLX509StoreIsRemovedCert(xmlSecPtr item, void* ctx) {
+    X509* cert = (X509*)item;
+    STACK_OF(X509)* removeCerts = (STACK_OF(X509)*)ctx;
+    X509* removeCert;
+    int ii, num;
+
+    xmlSecAssert2(cert != NULL, -1);
+    xmlSecAssert2(removeCerts != NULL, -1);
+
+    num = sk_X509_num(removeCerts);
+    for(ii = 0; ii < num; ++ii) {
+        removeCert = sk_X509_value(removeCerts, ii);
+        if((removeCert != NULL) && (X509_cmp(cert, removeCert) == 0)) {
+            return(1);
+        }
+    }
+    return(0);
+}
+
 /**
  * xmlSecOpenSSLX509StoreAddCertsPath:
  * @store: the pointer to OpenSSL x509 store.
@@ -1197,17 +1507,24 @@ xmlSecOpenSSLX509StoreInitialize(xmlSecKeyDataStorePtr store) {
         }
     }
 
-    ctx->untrusted = sk_X509_new_null();
-    if(ctx->untrusted == NULL) {
-        xmlSecOpenSSLError("sk_X509_new_null",
-                           xmlSecKeyDataStoreGetName(store));
+    ret = xmlSecPtrRegistryInitialize(&(ctx->untrusted), &xmlSecOpenSSLX509CertListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(untrusted)",
+                            xmlSecKeyDataStoreGetName(store));
         return(-1);
     }
 
-    ctx->crls = sk_X509_CRL_new_null();
-    if(ctx->crls == NULL) {
-        xmlSecOpenSSLError("sk_X509_CRL_new_null",
-                           xmlSecKeyDataStoreGetName(store));
+    ret = xmlSecPtrRegistryInitialize(&(ctx->crls), &xmlSecOpenSSLX509CrlListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(crls)",
+                            xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+
+    ret = xmlSecPtrRegistryInitialize(&(ctx->found), &xmlSecOpenSSLX509CertListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(found)",
+                            xmlSecKeyDataStoreGetName(store));
         return(-1);
     }
 
@@ -1236,12 +1553,9 @@ xmlSecOpenSSLX509StoreFinalize(xmlSecKeyDataStorePtr store) {
     if(ctx->xst != NULL) {
         X509_STORE_free(ctx->xst);
     }
-    if(ctx->untrusted != NULL) {
-        sk_X509_pop_free(ctx->untrusted, X509_free);
-    }
-    if(ctx->crls != NULL) {
-        sk_X509_CRL_pop_free(ctx->crls, X509_CRL_free);
-    }
+    xmlSecPtrRegistryFinalize(&(ctx->untrusted));
+    xmlSecPtrRegistryFinalize(&(ctx->crls));
+    xmlSecPtrRegistryFinalize(&(ctx->found));
     if(ctx->vpm != NULL) {
         X509_VERIFY_PARAM_free(ctx->vpm);
     }
@@ -1652,52 +1966,91 @@ xmlSecOpenSSLX509GetIssuerHash(X509* x) {
 }
 
 static STACK_OF(X509)*
-xmlSecOpenSSLX509StoreCombineCerts(STACK_OF(X509)* certs1, STACK_OF(X509)* certs2) {
+xmlSecOpenSSLX509StoreCombineCerts(STACK_OF(X509)* certs1, xmlSecPtrListPtr certs2) {
     STACK_OF(X509)* res = NULL;
+    X509 * cert;
+    xmlSecSize ii, size;
+    int ret;
 
     /* certs1 */
-    if((res == NULL) && (certs1 != NULL)) {
+    if(certs1 != NULL) {
         res = sk_X509_dup(certs1);
         if(res == NULL) {
             xmlSecOpenSSLError("sk_X509_dup(certs1)", NULL);
             return(NULL);
         }
-    }
-
-    /* certs2 */
-    if((res == NULL) && (certs2 != NULL)) {
-        res = sk_X509_dup(certs2);
+    } else {
+        res = sk_X509_new_null();
         if(res == NULL) {
-            xmlSecOpenSSLError("sk_X509_dup(certs2)", NULL);
+            xmlSecOpenSSLError("sk_X509_new_null", NULL);
             return(NULL);
         }
-    } else if(certs2 != NULL) {
-        X509 * cert;
-        x509_size_t ii, num;
-        int ret;
+    }
 
-        /* append certs2 to result */
-        num = sk_X509_num(certs2);
-        ret = sk_X509_reserve(res, num + sk_X509_num(res));
-        if(ret != 1) {
-            xmlSecOpenSSLError2("sk_X509_reserve(res)", NULL,
-                "size=%d", (int)(num + sk_X509_num(res)));
+    /* certs2: append to result */
+    size = (certs2 != NULL) ? xmlSecPtrListGetSize(certs2) : 0;
+    if(size <= 0) {
+        return(res);
+    }
+    ret = sk_X509_reserve(res, (x509_size_t)size + sk_X509_num(res));
+    if(ret != 1) {
+        xmlSecOpenSSLError2("sk_X509_reserve(res)", NULL,
+            "size=" XMLSEC_SIZE_FMT, size);
+        sk_X509_free(res);
+        return(NULL);
+    }
+    for(ii = 0; ii < size; ++ii) {
+        cert = (X509*)xmlSecPtrListGetItem(certs2, ii);
+        if(cert == NULL) {
+            continue;
+        }
+        ret = sk_X509_push(res, cert);
+        if(ret <= 0) {
+            xmlSecOpenSSLError("sk_X509_push(res)", NULL);
             sk_X509_free(res);
             return(NULL);
         }
+    }
 
-         for(ii = 0; ii < num; ++ii) {
-            cert = sk_X509_value(certs2, ii);
-            if(cert == NULL) {
-                continue;
-            }
-            ret = sk_X509_push(res, cert);
-            if(ret <= 0) {
-                xmlSecInternalError("sk_X509_push(res)", NULL);
-            sk_X509_free(res);
+    /* done */
+    return(res);
+}
+
+static STACK_OF(X509_CRL)*
+xmlSecOpenSSLX509StoreCopyCrls(xmlSecPtrListPtr crls) {
+    STACK_OF(X509_CRL)* res = NULL;
+    X509_CRL * crl;
+    xmlSecSize ii, size;
+    int ret;
+
+    res = sk_X509_CRL_new_null();
+    if(res == NULL) {
+        xmlSecOpenSSLError("sk_X509_CRL_new_null", NULL);
+        return(NULL);
+    }
+
+    size = (crls != NULL) ? xmlSecPtrListGetSize(crls) : 0;
+    if(size <= 0) {
+        return(res);
+    }
+    ret = sk_X509_CRL_reserve(res, (x509_size_t)size);
+    if(ret != 1) {
+        xmlSecOpenSSLError2("sk_X509_CRL_reserve(res)", NULL,
+            "size=" XMLSEC_SIZE_FMT, size);
+        sk_X509_CRL_free(res);
+        return(NULL);
+    }
+    for(ii = 0; ii < size; ++ii) {
+        crl = (X509_CRL*)xmlSecPtrListGetItem(crls, ii);
+        if(crl == NULL) {
+            continue;
+        }
+        ret = sk_X509_CRL_push(res, crl);
+        if(ret <= 0) {
+            xmlSecOpenSSLError("sk_X509_CRL_push(res)", NULL);
+            sk_X509_CRL_free(res);
             return(NULL);
-            }
-         }
+        }
     }
 
     /* done */
@@ -0,0 +1,568 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Copy-on-write registries for the global lists.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libxml/threads.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
+#include <xmlsec/list.h>
+#include <xmlsec/errors.h>
+
+#include "registry.h"
+#include "threads.h"
+
+#define XMLSEC_REGISTRY_MIN_SIZE        16
+
+struct _xmlSecPtrRegistrySnapshot {
+    xmlSecPtrList                   list;           /* the published (read-only) list, must be first */
+    xmlSecPtrRegistrySnapshotPtr    prev;           /* the previously published snapshot */
+    xmlSecPtr*                      ownedData;      /* the data array allocated for this snapshot */
+    xmlSecSize                      ownedDataMax;
+    volatile int                    readers;        /* the xmlSecPtrRegistryReadBegin() references */
+    int                             replaced;       /* replaced by xmlSecPtrRegistryUpdate() */
+    xmlSecPtrList                   retired;        /* owns the items removed by this update */
+};
+
+static xmlSecPtrRegistrySnapshotPtr
+xmlSecPtrRegistrySnapshotCreate(xmlSecPtrListId id, xmlSecPtr* data, xmlSecSize use) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+
+    snapshot = (xmlSecPtrRegistrySnapshotPtr)xmlSecMalloc(sizeof(xmlSecPtrRegistrySnapshot), xmlSecAllocatorObjectTypeList);
+    if(snapshot == NULL) {
+        xmlSecMallocError(sizeof(xmlSecPtrRegistrySnapshot), NULL);
+        return(NULL);
+    }
+    memset(snapshot, 0, sizeof(xmlSecPtrRegistrySnapshot));
+
+    /* max == use: nobody should add anything to the snapshot */
+    snapshot->list.id   = id;
+    snapshot->list.data = data;
+    snapshot->list.use  = use;
+    snapshot->list.max  = use;
+    snapshot->retired.id = id;
+    return(snapshot);
+}
+
+static void
+xmlSecPtrRegistrySnapshotDestroy(xmlSecPtrRegistrySnapshotPtr snapshot) {
+    xmlSecAssert(snapshot != NULL);
+
+    xmlSecPtrListFinalize(&(snapshot->retired));
+    if(snapshot->ownedData != NULL) {
+        xmlSecFree(snapshot->ownedData, sizeof(xmlSecPtr) * snapshot->ownedDataMax, xmlSecAllocatorObjectTypeList);
+    }
+    memset(snapshot, 0, sizeof(xmlSecPtrRegistrySnapshot));
+    xmlSecFree(snapshot, sizeof(xmlSecPtrRegistrySnapshot), xmlSecAllocatorObjectTypeList);
+}
+
+static xmlSecPtrRegistrySnapshotPtr
+xmlSecPtrRegistryGetSnapshot(xmlSecPtrRegistryPtr registry) {
+    xmlSecAssert2(registry != NULL, NULL);
+    return((xmlSecPtrRegistrySnapshotPtr)xmlSecAtomicPtrGet(&(registry->current)));
+}
+
+/* the caller must hold the registry mutex */
+static void
+xmlSecPtrRegistryPublish(xmlSecPtrRegistryPtr registry, xmlSecPtrRegistrySnapshotPtr snapshot, int replace) {
+    xmlSecPtrRegistrySnapshotPtr prev;
+
+    xmlSecAssert(registry != NULL);
+    xmlSecAssert(snapshot != NULL);
+
+    prev = (xmlSecPtrRegistrySnapshotPtr)registry->current;
+    if((prev != NULL) && (replace != 0)) {
+        prev->replaced = 1;
+        xmlSecAtomicIntIncrement(&(registry->reclaim));
+    }
+    snapshot->prev = prev;
+    xmlSecAtomicPtrSet(&(registry->current), snapshot);
+}
+
+/* the caller must hold the registry mutex */
+static void
+xmlSecPtrRegistryItemsRemove(xmlSecPtrRegistryPtr registry, xmlSecPtr item) {
+    xmlSecSize ii;
+
+    xmlSecAssert(registry != NULL);
+
+    /* the order of the items doesn't matter: move the last item in the hole */
+    for(ii = 0; ii < registry->items.use; ++ii) {
+        if(registry->items.data[ii] == item) {
+            registry->items.data[ii] = registry->items.data[registry->items.use - 1];
+            registry->items.data[registry->items.use - 1] = NULL;
+            --registry->items.use;
+            return;
+        }
+    }
+}
+
+/* the caller must hold the registry mutex */
+static void
+xmlSecPtrRegistryReclaim(xmlSecPtrRegistryPtr registry) {
+    xmlSecPtrRegistrySnapshotPtr current;
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+    xmlSecPtrRegistrySnapshotPtr prev;
+    xmlSecPtrRegistrySnapshotPtr* unused;
+
+    xmlSecAssert(registry != NULL);
+
+    /* a reader in xmlSecPtrRegistryReadBegin() might have loaded an old snapshot
+     * but not referenced it yet, the next xmlSecPtrRegistryReadEnd() will retry */
+    if(xmlSecAtomicIntGet(&(registry->entering)) != 0) {
+        if(xmlSecAtomicIntGet(&(registry->retry)) == 0) {
+            xmlSecAtomicIntIncrement(&(registry->retry));
+        }
+        return;
+    }
+    if(xmlSecAtomicIntGet(&(registry->retry)) != 0) {
+        xmlSecAtomicIntDecrement(&(registry->retry));
+    }
+
+    /* the new readers see only the current snapshot and an old snapshot might
+     * reference the items removed by any newer update: the snapshots older than
+     * the oldest snapshot with readers are not used anymore */
+    current = (xmlSecPtrRegistrySnapshotPtr)registry->current;
+    xmlSecAssert(current != NULL);
+    unused = &(current->prev);
+    for(snapshot = current->prev; snapshot != NULL; snapshot = snapshot->prev) {
+        if(xmlSecAtomicIntGet(&(snapshot->readers)) != 0) {
+            unused = &(snapshot->prev);
+        }
+    }
+
+    /* the replaced snapshots never share their data arrays with the newer
+     * snapshots; the others might be still used by xmlSecPtrRegistryGet() */
+    snapshot = (*unused);
+    (*unused) = NULL;
+    for(; snapshot != NULL; snapshot = prev) {
+        prev = snapshot->prev;
+        if(snapshot->replaced != 0) {
+            xmlSecPtrRegistrySnapshotDestroy(snapshot);
+            xmlSecAtomicIntDecrement(&(registry->reclaim));
+        } else {
+            snapshot->prev = registry->pinned;
+            registry->pinned = snapshot;
+        }
+    }
+}
+
+/**
+ * xmlSecPtrRegistryInitialize:
+ * @registry:           the pointer to registry.
+ * @id:                 the items list klass.
+ *
+ * Initializes the @registry and publishes an empty snapshot. Caller is
+ * responsible for cleaning up by calling #xmlSecPtrRegistryFinalize function.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecPtrRegistryInitialize(xmlSecPtrRegistryPtr registry, xmlSecPtrListId id) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+    int ret;
+
+    xmlSecAssert2(registry != NULL, -1);
+    xmlSecAssert2(id != xmlSecPtrListIdUnknown, -1);
+
+    memset(registry, 0, sizeof(xmlSecPtrRegistry));
+    registry->id = id;
+
+    ret = xmlSecPtrListInitialize(&(registry->items), id);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        return(-1);
+    }
+    registry->mutex = xmlNewMutex();
+    if(registry->mutex == NULL) {
+        xmlSecXmlError("xmlNewMutex", NULL);
+        xmlSecPtrRegistryFinalize(registry);
+        return(-1);
+    }
+
+    snapshot = xmlSecPtrRegistrySnapshotCreate(id, NULL, 0);
+    if(snapshot == NULL) {
+        xmlSecInternalError("xmlSecPtrRegistrySnapshotCreate", NULL);
+        xmlSecPtrRegistryFinalize(registry);
+        return(-1);
+    }
+    xmlSecPtrRegistryPublish(registry, snapshot, 0);
+    return(0);
+}
+
+/**
+ * xmlSecPtrRegistryFinalize:
+ * @registry:           the pointer to registry.
+ *
+ * Destroys all the snapshots and all the items ever added to the @registry.
+ * The registry must not be used by other threads.
+ */
+void
+xmlSecPtrRegistryFinalize(xmlSecPtrRegistryPtr registry) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+    xmlSecPtrRegistrySnapshotPtr prev;
+
+    xmlSecAssert(registry != NULL);
+
+    for(snapshot = (xmlSecPtrRegistrySnapshotPtr)registry->current; snapshot != NULL; snapshot = prev) {
+        prev = snapshot->prev;
+        xmlSecPtrRegistrySnapshotDestroy(snapshot);
+    }
+    for(snapshot = registry->pinned; snapshot != NULL; snapshot = prev) {
+        prev = snapshot->prev;
+        xmlSecPtrRegistrySnapshotDestroy(snapshot);
+    }
+    if(registry->items.id != NULL) {
+        xmlSecPtrListFinalize(&(registry->items));
+    }
+    if(registry->mutex != NULL) {
+        xmlFreeMutex(registry->mutex);
+    }
+    memset(registry, 0, sizeof(xmlSecPtrRegistry));
+}
+
+/**
+ * xmlSecPtrRegistryGet:
+ * @registry:           the pointer to registry.
+ *
+ * Gets the current snapshot of the @registry without locks. The snapshot
+ * is read-only and stays valid until #xmlSecPtrRegistryFinalize is called
+ * unless it is replaced by #xmlSecPtrRegistryUpdate: the registries that
+ * remove items must be read with #xmlSecPtrRegistryReadBegin instead.
+ *
+ * Returns: the pointer to the current snapshot list or NULL if the
+ * @registry is not initialized.
+ */
+xmlSecPtrListPtr
+xmlSecPtrRegistryGet(xmlSecPtrRegistryPtr registry) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+
+    xmlSecAssert2(registry != NULL, NULL);
+
+    snapshot = xmlSecPtrRegistryGetSnapshot(registry);
+    if(snapshot == NULL) {
+        return(NULL);
+    }
+    return(&(snapshot->list));
+}
+
+/**
+ * xmlSecPtrRegistryAdd:
+ * @registry:           the pointer to registry.
+ * @item:               the item.
+ *
+ * Adds @item to the end of the @registry and publishes the new snapshot.
+ * On success, the @registry owns the @item.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecPtrRegistryAdd(xmlSecPtrRegistryPtr registry, xmlSecPtr item) {
+    xmlSecPtrRegistrySnapshotPtr snapshot = NULL;
+    xmlSecPtr* newData = NULL;
+    xmlSecSize newMax = 0;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(registry != NULL, -1);
+    xmlSecAssert2(registry->mutex != NULL, -1);
+
+    xmlMutexLock(registry->mutex);
+
+    /* the items before dataUse are shared with the published snapshots and
+     * never change, we can only write after them */
+    if(registry->dataUse >= registry->dataMax) {
+        newMax = (registry->dataMax > 0) ? (2 * registry->dataMax) : XMLSEC_REGISTRY_MIN_SIZE;
+        newData = (xmlSecPtr*)xmlSecMalloc(sizeof(xmlSecPtr) * newMax, xmlSecAllocatorObjectTypeList);
+        if(newData == NULL) {
+            xmlSecMallocError(sizeof(xmlSecPtr) * newMax, NULL);
+            goto done;
+        }
+        memset(newData, 0, sizeof(xmlSecPtr) * newMax);
+        if((registry->dataUse > 0) && (registry->data != NULL)) {
+            memcpy(newData, registry->data, sizeof(xmlSecPtr) * registry->dataUse);
+        }
+    }
+
+    snapshot = xmlSecPtrRegistrySnapshotCreate(registry->id,
+        (newData != NULL) ? newData : registry->data, registry->dataUse + 1);
+    if(snapshot == NULL) {
+        xmlSecInternalError("xmlSecPtrRegistrySnapshotCreate", NULL);
+        goto done;
+    }
+
+    ret = xmlSecPtrListAdd(&(registry->items), item);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        goto done;
+    }
+
+    /* commit */
+    if(newData != NULL) {
+        snapshot->ownedData = newData;
+        snapshot->ownedDataMax = newMax;
+        registry->data = newData;
+        registry->dataMax = newMax;
+        newData = NULL;
+    }
+    registry->data[registry->dataUse++] = item;
+    xmlSecPtrRegistryPublish(registry, snapshot, 0);
+    snapshot = NULL;
+
+    /* success */
+    res = 0;
+
+done:
+    xmlMutexUnlock(registry->mutex);
+    if(snapshot != NULL) {
+        xmlSecPtrRegistrySnapshotDestroy(snapshot);
+    }
+    if(newData != NULL) {
+        xmlSecFree(newData, sizeof(xmlSecPtr) * newMax, xmlSecAllocatorObjectTypeList);
+    }
+    return(res);
+}
+
+/**
+ * xmlSecPtrRegistryEmpty:
+ * @registry:           the pointer to registry.
+ *
+ * Publishes an empty snapshot. The items are not destroyed until
+ * #xmlSecPtrRegistryFinalize is called because the other threads
+ * might still use them.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecPtrRegistryEmpty(xmlSecPtrRegistryPtr registry) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+
+    xmlSecAssert2(registry != NULL, -1);
+    xmlSecAssert2(registry->mutex != NULL, -1);
+
+    snapshot = xmlSecPtrRegistrySnapshotCreate(registry->id, NULL, 0);
+    if(snapshot == NULL) {
+        xmlSecInternalError("xmlSecPtrRegistrySnapshotCreate", NULL);
+        return(-1);
+    }
+
+    xmlMutexLock(registry->mutex);
+    registry->data = NULL;
+    registry->dataUse = 0;
+    registry->dataMax = 0;
+    xmlSecPtrRegistryPublish(registry, snapshot, 0);
+    xmlMutexUnlock(registry->mutex);
+
+    return(0);
+}
+
+/**
+ * xmlSecPtrRegistryReadBegin:
+ * @registry:           the pointer to registry.
+ *
+ * Gets the current snapshot of the @registry without locks. The snapshot
+ * is read-only and stays valid until #xmlSecPtrRegistryReadEnd is called.
+ * Every call to this function must be paired with #xmlSecPtrRegistryReadEnd,
+ * even if it returns NULL.
+ *
+ * Returns: the pointer to the current snapshot list or NULL if the
+ * @registry is not initialized.
+ */
+xmlSecPtrListPtr
+xmlSecPtrRegistryReadBegin(xmlSecPtrRegistryPtr registry) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+
+    xmlSecAssert2(registry != NULL, NULL);
+
+    /* the snapshot can't be destroyed until we reference it */
+    xmlSecAtomicIntIncrement(&(registry->entering));
+    snapshot = xmlSecPtrRegistryGetSnapshot(registry);
+    if(snapshot != NULL) {
+        xmlSecAtomicIntIncrement(&(snapshot->readers));
+    }
+    xmlSecAtomicIntDecrement(&(registry->entering));
+
+    if(snapshot == NULL) {
+        return(NULL);
+    }
+    return(&(snapshot->list));
+}
+
+/**
+ * xmlSecPtrRegistryReadEnd:
+ * @registry:           the pointer to registry.
+ * @list:               the snapshot list returned by #xmlSecPtrRegistryReadBegin.
+ *
+ * Releases the snapshot returned by #xmlSecPtrRegistryReadBegin. The last
+ * reader of a snapshot destroys the replaced snapshots and the removed items
+ * that are not used anymore.
+ */
+void
+xmlSecPtrRegistryReadEnd(xmlSecPtrRegistryPtr registry, xmlSecPtrListPtr list) {
+    xmlSecPtrRegistrySnapshotPtr snapshot;
+    int readers;
+
+    xmlSecAssert(registry != NULL);
+
+    if(list == NULL) {
+        return;
+    }
+    xmlSecAssert(list->id == registry->id);
+    snapshot = (xmlSecPtrRegistrySnapshotPtr)list;
+
+    /* the snapshot might be destroyed by another thread right after this */
+    readers = xmlSecAtomicIntDecrement(&(snapshot->readers));
+    if((xmlSecAtomicIntGet(&(registry->reclaim)) != 0) &&
+       ((readers == 0) || (xmlSecAtomicIntGet(&(registry->retry)) != 0)) &&
+       (registry->mutex != NULL)
+    ) {
+        xmlMutexLock(registry->mutex);
+        xmlSecPtrRegistryReclaim(registry);
+        xmlMutexUnlock(registry->mutex);
+    }
+}
+
+/**
+ * xmlSecPtrRegistryUpdate:
+ * @registry:           the pointer to registry.
+ * @add:                the items to add (optional).
+ * @removeMatch:        the callback to select the items to remove (optional).
+ * @removeCtx:          the @removeMatch callback context.
+ *
+ * Removes the items selected by @removeMatch, adds the items from @add and
+ * publishes all the changes in one snapshot. On success, the @registry owns
+ * the items from @add and the @add list is emptied. The replaced snapshot and
+ * the removed items are destroyed once there are no readers of this or older
+ * snapshots (see #xmlSecPtrRegistryReadBegin).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecPtrRegistryUpdate(xmlSecPtrRegistryPtr registry, xmlSecPtrListPtr add,
+    xmlSecPtrRegistryMatchMethod removeMatch, void* removeCtx
+) {
+    xmlSecPtrRegistrySnapshotPtr current;
+    xmlSecPtrRegistrySnapshotPtr snapshot = NULL;
+    xmlSecPtr* newData = NULL;
+    xmlSecSize newMax, newUse = 0;
+    xmlSecSize itemsUse, retiredUse;
+    xmlSecSize addSize, ii;
+    xmlSecPtr item;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(registry != NULL, -1);
+    xmlSecAssert2(registry->mutex != NULL, -1);
+    xmlSecAssert2(registry->current != NULL, -1);
+
+    addSize = (add != NULL) ? xmlSecPtrListGetSize(add) : 0;
+
+    xmlMutexLock(registry->mutex);
+    current = (xmlSecPtrRegistrySnapshotPtr)registry->current;
+    itemsUse = registry->items.use;
+    retiredUse = current->retired.use;
+
+    /* we can't change the data array shared with the published snapshots */
+    newMax = (registry->dataMax > 0) ? registry->dataMax : XMLSEC_REGISTRY_MIN_SIZE;
+    while(newMax < registry->dataUse + addSize) {
+        newMax *= 2;
+    }
+    newData = (xmlSecPtr*)xmlSecMalloc(sizeof(xmlSecPtr) * newMax, xmlSecAllocatorObjectTypeList);
+    if(newData == NULL) {
+        xmlSecMallocError(sizeof(xmlSecPtr) * newMax, NULL);
+        goto done;
+    }
+    memset(newData, 0, sizeof(xmlSecPtr) * newMax);
+
+    for(ii = 0; ii < registry->dataUse; ++ii) {
+        item = registry->data[ii];
+        if(removeMatch != NULL) {
+            ret = removeMatch(item, removeCtx);
+            if(ret < 0) {
+                xmlSecInternalError("removeMatch", NULL);
+                goto done;
+            } else if(ret == 1) {
+                ret = xmlSecPtrListAdd(&(current->retired), item);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecPtrListAdd(retired)", NULL);
+                    goto done;
+                }
+                continue;
+            }
+        }
+        newData[newUse++] = item;
+    }
+    for(ii = 0; ii < addSize; ++ii) {
+        item = xmlSecPtrListGetItem(add, ii);
+        if(item == NULL) {
+            continue;
+        }
+        ret = xmlSecPtrListAdd(&(registry->items), item);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", NULL);
+            goto done;
+        }
+        newData[newUse++] = item;
+    }
+
+    snapshot = xmlSecPtrRegistrySnapshotCreate(registry->id, newData, newUse);
+    if(snapshot == NULL) {
+        xmlSecInternalError("xmlSecPtrRegistrySnapshotCreate", NULL);
+        goto done;
+    }
+
+    /* commit: the removed items are owned by the replaced snapshot */
+    for(ii = retiredUse; ii < current->retired.use; ++ii) {
+        xmlSecPtrRegistryItemsRemove(registry, current->retired.data[ii]);
+    }
+    if(addSize > 0) {
+        memset(add->data, 0, sizeof(xmlSecPtr) * addSize);
+        add->use = 0;
+    }
+    snapshot->ownedData = newData;
+    snapshot->ownedDataMax = newMax;
+    registry->data = newData;
+    registry->dataUse = newUse;
+    registry->dataMax = newMax;
+    newData = NULL;
+    xmlSecPtrRegistryPublish(registry, snapshot, 1);
+    snapshot = NULL;
+
+    xmlSecPtrRegistryReclaim(registry);
+
+    /* success */
+    res = 0;
+
+done:
+    if(res < 0) {
+        /* rollback: the caller still owns the new items and
+         * the removed items are still in the registry */
+        for(ii = itemsUse; ii < registry->items.use; ++ii) {
+            registry->items.data[ii] = NULL;
+        }
+        registry->items.use = itemsUse;
+        for(ii = retiredUse; ii < current->retired.use; ++ii) {
+            current->retired.data[ii] = NULL;
+        }
+        current->retired.use = retiredUse;
+    }
+    xmlMutexUnlock(registry->mutex);
+    if(snapshot != NULL) {
+        xmlSecPtrRegistrySnapshotDestroy(snapshot);
+    }
+    if(newData != NULL) {
+        xmlSecFree(newData, sizeof(xmlSecPtr) * newMax, xmlSecAllocatorObjectTypeList);
+    }
+    return(res);
+}
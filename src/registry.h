@@ -0,0 +1,99 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * Copy-on-write registries for the global lists (transforms, key data,
+ * IO callbacks, ...).
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_REGISTRY_H__
+#define __XMLSEC_REGISTRY_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "this file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <libxml/threads.h>
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/list.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/********************************************************************
+ *
+ * Registry: the readers get an immutable snapshot of the list without
+ * any locks, the writers (serialized by the mutex) publish a new snapshot.
+ * The snapshots are append-only and share the data array thus adding
+ * an item is O(1) amortized. The snapshots published by xmlSecPtrRegistryAdd()
+ * and xmlSecPtrRegistryEmpty() and the items are freed only in
+ * xmlSecPtrRegistryFinalize() because a reader might still use them.
+ *
+ * The registries that remove items with xmlSecPtrRegistryUpdate() must be
+ * read between xmlSecPtrRegistryReadBegin() and xmlSecPtrRegistryReadEnd():
+ * every snapshot counts its readers, the snapshot replaced by the update
+ * and the removed items are freed as soon as the last reader of this or
+ * an older snapshot is gone.
+ *
+ ********************************************************************/
+typedef struct _xmlSecPtrRegistrySnapshot           xmlSecPtrRegistrySnapshot,
+                                                    *xmlSecPtrRegistrySnapshotPtr;
+typedef struct _xmlSecPtrRegistry                   xmlSecPtrRegistry,
+                                                    *xmlSecPtrRegistryPtr;
+
+/**
+ * xmlSecPtrRegistryMatchMethod:
+ * @item:               the registry item.
+ * @ctx:                the callback context.
+ *
+ * The callback used by xmlSecPtrRegistryUpdate() to select the items to remove.
+ *
+ * Returns: 1 if @item should be removed, 0 if not or a negative value
+ * if an error occurs.
+ */
+typedef int             (*xmlSecPtrRegistryMatchMethod) (xmlSecPtr item,
+                                                         void* ctx);
+
+struct _xmlSecPtrRegistry {
+    xmlSecPtrListId                 id;
+    void* volatile                  current;    /* the snapshot, use xmlSecPtrRegistryGet() to read it */
+    xmlSecPtrList                   items;      /* owns all the registered items */
+    xmlSecPtrRegistrySnapshotPtr    pinned;     /* the old snapshots kept until xmlSecPtrRegistryFinalize() */
+    xmlSecPtr*                      data;       /* the data array of the current snapshot */
+    xmlSecSize                      dataUse;
+    xmlSecSize                      dataMax;
+    volatile int                    entering;   /* the readers in xmlSecPtrRegistryReadBegin() */
+    volatile int                    reclaim;    /* the number of replaced snapshots to destroy */
+    volatile int                    retry;      /* the last reclaim was interrupted by a reader */
+    xmlMutexPtr                     mutex;
+};
+
+XMLSEC_EXPORT int               xmlSecPtrRegistryInitialize     (xmlSecPtrRegistryPtr registry,
+                                                                 xmlSecPtrListId id);
+XMLSEC_EXPORT void              xmlSecPtrRegistryFinalize       (xmlSecPtrRegistryPtr registry);
+XMLSEC_EXPORT xmlSecPtrListPtr  xmlSecPtrRegistryGet            (xmlSecPtrRegistryPtr registry);
+XMLSEC_EXPORT int               xmlSecPtrRegistryAdd            (xmlSecPtrRegistryPtr registry,
+                                                                 xmlSecPtr item);
+XMLSEC_EXPORT int               xmlSecPtrRegistryEmpty          (xmlSecPtrRegistryPtr registry);
+XMLSEC_EXPORT xmlSecPtrListPtr  xmlSecPtrRegistryReadBegin      (xmlSecPtrRegistryPtr registry);
+XMLSEC_EXPORT void              xmlSecPtrRegistryReadEnd        (xmlSecPtrRegistryPtr registry,
+                                                                 xmlSecPtrListPtr list);
+XMLSEC_EXPORT int               xmlSecPtrRegistryUpdate         (xmlSecPtrRegistryPtr registry,
+                                                                 xmlSecPtrListPtr add,
+                                                                 xmlSecPtrRegistryMatchMethod removeMatch,
+                                                                 void* removeCtx);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_REGISTRY_H__ */
@@ -0,0 +1,653 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Minimal threads support for the parallel processing.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else  /* defined(_WIN32) */
+#include <pthread.h>
+#include <sched.h>
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+#include <libxml/globals.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private.h>
+
+#include "threads.h"
+
+struct _xmlSecThread {
+    xmlSecThreadFunc    func;
+    void*               data;
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    HANDLE              handle;
+#else  /* defined(_WIN32) */
+    pthread_t           handle;
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+};
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+static unsigned __stdcall
+xmlSecThreadMain(void* arg) {
+    xmlSecThreadPtr thread = (xmlSecThreadPtr)arg;
+
+    xmlSecAssert2(thread != NULL, 0);
+    xmlSecAssert2(thread->func != NULL, 0);
+
+    (thread->func)(thread->data);
+    return(0);
+}
+#else  /* defined(_WIN32) */
+static void*
+xmlSecThreadMain(void* arg) {
+    xmlSecThreadPtr thread = (xmlSecThreadPtr)arg;
+
+    xmlSecAssert2(thread != NULL, NULL);
+    xmlSecAssert2(thread->func != NULL, NULL);
+
+    (thread->func)(thread->data);
+    return(NULL);
+}
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+/**
+ * xmlSecThreadsEnabled:
+ *
+ * Checks if xmlsec was compiled with threads support.
+ *
+ * Returns: 1 if threads are supported or 0 otherwise.
+ */
+int
+xmlSecThreadsEnabled(void) {
+#if !defined(XMLSEC_NO_THREADS)
+    return(1);
+#else  /* !defined(XMLSEC_NO_THREADS) */
+    return(0);
+#endif /* !defined(XMLSEC_NO_THREADS) */
+}
+
+/**
+ * xmlSecThreadCreate:
+ * @func:               the thread function.
+ * @data:               the thread function parameter.
+ *
+ * Starts a new thread executing @func(@data). If threads support
+ * is disabled then @func is executed synchronously.
+ *
+ * Returns: the pointer to the thread (the caller must call
+ * #xmlSecThreadJoin) or NULL if an error occurs.
+ */
+xmlSecThreadPtr
+xmlSecThreadCreate(xmlSecThreadFunc func, void* data) {
+    xmlSecThreadPtr thread;
+
+    xmlSecAssert2(func != NULL, NULL);
+
+    thread = (xmlSecThreadPtr)xmlMalloc(sizeof(xmlSecThread));
+    if(thread == NULL) {
+        xmlSecMallocError(sizeof(xmlSecThread), NULL);
+        return(NULL);
+    }
+    memset(thread, 0, sizeof(xmlSecThread));
+    thread->func = func;
+    thread->data = data;
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    thread->handle = (HANDLE)_beginthreadex(NULL, 0, xmlSecThreadMain, thread, 0, NULL);
+    if(thread->handle == 0) {
+        xmlSecInternalError2("_beginthreadex", NULL, "errno=%d", errno);
+        xmlFree(thread);
+        return(NULL);
+    }
+#else  /* defined(_WIN32) */
+    {
+        int ret;
+
+        ret = pthread_create(&(thread->handle), NULL, xmlSecThreadMain, thread);
+        if(ret != 0) {
+            xmlSecInternalError2("pthread_create", NULL, "ret=%d", ret);
+            xmlFree(thread);
+            return(NULL);
+        }
+    }
+#endif /* defined(_WIN32) */
+#else  /* !defined(XMLSEC_NO_THREADS) */
+    (thread->func)(thread->data);
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+    return(thread);
+}
+
+/**
+ * xmlSecThreadJoin:
+ * @thread:             the pointer to thread.
+ *
+ * Waits for the @thread to finish and frees it.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecThreadJoin(xmlSecThreadPtr thread) {
+#if !defined(XMLSEC_NO_THREADS) && !defined(_WIN32)
+    int ret;
+#endif /* !defined(XMLSEC_NO_THREADS) && !defined(_WIN32) */
+    int res = 0;
+
+    xmlSecAssert2(thread != NULL, -1);
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    if(WaitForSingleObject(thread->handle, INFINITE) != WAIT_OBJECT_0) {
+        xmlSecInternalError("WaitForSingleObject", NULL);
+        res = -1;
+    }
+    CloseHandle(thread->handle);
+#else  /* defined(_WIN32) */
+    ret = pthread_join(thread->handle, NULL);
+    if(ret != 0) {
+        xmlSecInternalError2("pthread_join", NULL, "ret=%d", ret);
+        res = -1;
+    }
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+    memset(thread, 0, sizeof(xmlSecThread));
+    xmlFree(thread);
+    return(res);
+}
+
+/**
+ * xmlSecThreadYield:
+ *
+ * Gives up the CPU to the other threads (does nothing if threads
+ * support is disabled).
+ */
+void
+xmlSecThreadYield(void) {
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    SwitchToThread();
+#else  /* defined(_WIN32) */
+    sched_yield();
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+}
+
+/* gcc 4.7+ and clang provide the __atomic builtins, MSVC has MemoryBarrier(), otherwise
+ * we fall back to the volatile access */
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+#define XMLSEC_ATOMIC_LOAD(ptr)                 __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define XMLSEC_ATOMIC_STORE(ptr, value)         __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define XMLSEC_ATOMIC_INCREMENT(ptr)            __atomic_add_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#define XMLSEC_ATOMIC_DECREMENT(ptr)            __atomic_sub_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#elif defined(_WIN32)
+#define XMLSEC_ATOMIC_BARRIER()                 MemoryBarrier()
+#define XMLSEC_ATOMIC_INCREMENT(ptr)            ((int)InterlockedIncrement((volatile LONG*)(ptr)))
+#define XMLSEC_ATOMIC_DECREMENT(ptr)            ((int)InterlockedDecrement((volatile LONG*)(ptr)))
+#endif /* defined(__clang__) || (defined(__GNUC__) && ...) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+/**
+ * xmlSecAtomicPtrGet:
+ * @ptr:                the pointer to the published pointer.
+ *
+ * Atomically loads the pointer published with #xmlSecAtomicPtrSet.
+ *
+ * Returns: the loaded pointer.
+ */
+void*
+xmlSecAtomicPtrGet(void* const volatile* ptr) {
+    void* res;
+
+    xmlSecAssert2(ptr != NULL, NULL);
+
+#if defined(XMLSEC_ATOMIC_LOAD)
+    res = XMLSEC_ATOMIC_LOAD(ptr);
+#elif defined(XMLSEC_ATOMIC_BARRIER)
+    XMLSEC_ATOMIC_BARRIER();
+    res = (*ptr);
+    XMLSEC_ATOMIC_BARRIER();
+#else  /* defined(XMLSEC_ATOMIC_LOAD) */
+    res = (*ptr);
+#endif /* defined(XMLSEC_ATOMIC_LOAD) */
+    return(res);
+}
+
+/**
+ * xmlSecAtomicPtrSet:
+ * @ptr:                the pointer to the published pointer.
+ * @value:              the new value.
+ *
+ * Atomically publishes the @value: all the writes done before this call
+ * are visible to the threads that load @value with #xmlSecAtomicPtrGet.
+ */
+void
+xmlSecAtomicPtrSet(void* volatile* ptr, void* value) {
+    xmlSecAssert(ptr != NULL);
+
+#if defined(XMLSEC_ATOMIC_STORE)
+    XMLSEC_ATOMIC_STORE(ptr, value);
+#elif defined(XMLSEC_ATOMIC_BARRIER)
+    XMLSEC_ATOMIC_BARRIER();
+    (*ptr) = value;
+    XMLSEC_ATOMIC_BARRIER();
+#else  /* defined(XMLSEC_ATOMIC_STORE) */
+    (*ptr) = value;
+#endif /* defined(XMLSEC_ATOMIC_STORE) */
+}
+
+/**
+ * xmlSecAtomicSizeGet:
+ * @ptr:                the pointer to the published size.
+ *
+ * Atomically loads the size published with #xmlSecAtomicSizeSet.
+ *
+ * Returns: the loaded size.
+ */
+xmlSecSize
+xmlSecAtomicSizeGet(const volatile xmlSecSize* ptr) {
+    xmlSecSize res;
+
+    xmlSecAssert2(ptr != NULL, 0);
+
+#if defined(XMLSEC_ATOMIC_LOAD)
+    res = XMLSEC_ATOMIC_LOAD(ptr);
+#elif defined(XMLSEC_ATOMIC_BARRIER)
+    XMLSEC_ATOMIC_BARRIER();
+    res = (*ptr);
+    XMLSEC_ATOMIC_BARRIER();
+#else  /* defined(XMLSEC_ATOMIC_LOAD) */
+    res = (*ptr);
+#endif /* defined(XMLSEC_ATOMIC_LOAD) */
+    return(res);
+}
+
+/**
+ * xmlSecAtomicSizeSet:
+ * @ptr:                the pointer to the published size.
+ * @value:              the new value.
+ *
+ * Atomically publishes the size @value.
+ */
+void
+xmlSecAtomicSizeSet(volatile xmlSecSize* ptr, xmlSecSize value) {
+    xmlSecAssert(ptr != NULL);
+
+#if defined(XMLSEC_ATOMIC_STORE)
+    XMLSEC_ATOMIC_STORE(ptr, value);
+#elif defined(XMLSEC_ATOMIC_BARRIER)
+    XMLSEC_ATOMIC_BARRIER();
+    (*ptr) = value;
+    XMLSEC_ATOMIC_BARRIER();
+#else  /* defined(XMLSEC_ATOMIC_STORE) */
+    (*ptr) = value;
+#endif /* defined(XMLSEC_ATOMIC_STORE) */
+}
+
+/**
+ * xmlSecAtomicIntGet:
+ * @ptr:                the pointer to the counter.
+ *
+ * Atomically loads the counter.
+ *
+ * Returns: the loaded value.
+ */
+int
+xmlSecAtomicIntGet(const volatile int* ptr) {
+    int res;
+
+    xmlSecAssert2(ptr != NULL, 0);
+
+#if defined(XMLSEC_ATOMIC_LOAD)
+    res = XMLSEC_ATOMIC_LOAD(ptr);
+#elif defined(XMLSEC_ATOMIC_BARRIER)
+    XMLSEC_ATOMIC_BARRIER();
+    res = (*ptr);
+    XMLSEC_ATOMIC_BARRIER();
+#else  /* defined(XMLSEC_ATOMIC_LOAD) */
+    res = (*ptr);
+#endif /* defined(XMLSEC_ATOMIC_LOAD) */
+    return(res);
+}
+
+/**
+ * xmlSecAtomicIntIncrement:
+ * @ptr:                the pointer to the counter.
+ *
+ * Atomically increments the counter.
+ *
+ * Returns: the new value.
+ */
+int
+xmlSecAtomicIntIncrement(volatile int* ptr) {
+    xmlSecAssert2(ptr != NULL, 0);
+
+#if defined(XMLSEC_ATOMIC_INCREMENT)
+    return(XMLSEC_ATOMIC_INCREMENT(ptr));
+#else  /* defined(XMLSEC_ATOMIC_INCREMENT) */
+    return(++(*ptr));
+#endif /* defined(XMLSEC_ATOMIC_INCREMENT) */
+}
+
+/**
+ * xmlSecAtomicIntDecrement:
+ * @ptr:                the pointer to the counter.
+ *
+ * Atomically decrements the counter.
+ *
+ * Returns: the new value.
+ */
+int
+xmlSecAtomicIntDecrement(volatile int* ptr) {
+    xmlSecAssert2(ptr != NULL, 0);
+
+#if defined(XMLSEC_ATOMIC_DECREMENT)
+    return(XMLSEC_ATOMIC_DECREMENT(ptr));
+#else  /* defined(XMLSEC_ATOMIC_DECREMENT) */
+    return(--(*ptr));
+#endif /* defined(XMLSEC_ATOMIC_DECREMENT) */
+}
+
+/**************************************************************************
+ *
+ * Single producer / single consumer queue: the producer owns @tail and
+ * the consumer owns @head, each side only reads the other's counter.
+ *
+ *************************************************************************/
+#define XMLSEC_THREAD_QUEUE_SPIN_NUM            64
+
+struct _xmlSecThreadQueue {
+    void**                      items;
+    xmlSecSize                  size;
+    volatile xmlSecSize         head;
+    volatile xmlSecSize         tail;
+    volatile int                closed;
+#if !defined(XMLSEC_NO_THREADS)
+    volatile int                waiting;
+#if defined(_WIN32)
+    CRITICAL_SECTION            lock;
+    CONDITION_VARIABLE          cond;
+#else  /* defined(_WIN32) */
+    pthread_mutex_t             lock;
+    pthread_cond_t              cond;
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+};
+
+/* checks if the producer (@push is 1) at @pos or the consumer (@push is 0) at @pos has to wait */
+static int
+xmlSecThreadQueueIsBlocked(xmlSecThreadQueuePtr queue, xmlSecSize pos, int push) {
+    xmlSecAssert2(queue != NULL, 0);
+
+    if(xmlSecAtomicIntGet(&(queue->closed)) != 0) {
+        return(0);
+    }
+    if(push != 0) {
+        return(((pos - xmlSecAtomicSizeGet(&(queue->head))) >= queue->size) ? 1 : 0);
+    } else {
+        return((xmlSecAtomicSizeGet(&(queue->tail)) == pos) ? 1 : 0);
+    }
+}
+
+/* the waiter registers itself in @waiting before re-checking the queue state under
+ * the lock and the other side changes the state before checking @waiting: since all
+ * the atomics are sequentially consistent, one of them sees the other's change and
+ * the wake up can't be lost */
+static void
+xmlSecThreadQueueWait(xmlSecThreadQueuePtr queue, xmlSecSize pos, int push) {
+    xmlSecAssert(queue != NULL);
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    EnterCriticalSection(&(queue->lock));
+    xmlSecAtomicIntIncrement(&(queue->waiting));
+    while(xmlSecThreadQueueIsBlocked(queue, pos, push) != 0) {
+        SleepConditionVariableCS(&(queue->cond), &(queue->lock), INFINITE);
+    }
+    xmlSecAtomicIntDecrement(&(queue->waiting));
+    LeaveCriticalSection(&(queue->lock));
+#else  /* defined(_WIN32) */
+    pthread_mutex_lock(&(queue->lock));
+    xmlSecAtomicIntIncrement(&(queue->waiting));
+    while(xmlSecThreadQueueIsBlocked(queue, pos, push) != 0) {
+        pthread_cond_wait(&(queue->cond), &(queue->lock));
+    }
+    xmlSecAtomicIntDecrement(&(queue->waiting));
+    pthread_mutex_unlock(&(queue->lock));
+#endif /* defined(_WIN32) */
+#else  /* !defined(XMLSEC_NO_THREADS) */
+    UNREFERENCED_PARAMETER(pos);
+    UNREFERENCED_PARAMETER(push);
+    xmlSecThreadYield();
+#endif /* !defined(XMLSEC_NO_THREADS) */
+}
+
+/* wakes up the other side if it is blocked in xmlSecThreadQueueWait() */
+static void
+xmlSecThreadQueueNotify(xmlSecThreadQueuePtr queue) {
+    xmlSecAssert(queue != NULL);
+
+#if !defined(XMLSEC_NO_THREADS)
+    if(xmlSecAtomicIntGet(&(queue->waiting)) == 0) {
+        return;
+    }
+#if defined(_WIN32)
+    EnterCriticalSection(&(queue->lock));
+    WakeAllConditionVariable(&(queue->cond));
+    LeaveCriticalSection(&(queue->lock));
+#else  /* defined(_WIN32) */
+    pthread_mutex_lock(&(queue->lock));
+    pthread_cond_broadcast(&(queue->cond));
+    pthread_mutex_unlock(&(queue->lock));
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+}
+
+/**
+ * xmlSecThreadQueueCreate:
+ * @size:               the max number of items in the queue.
+ *
+ * Creates the queue between one producer and one consumer threads.
+ *
+ * Returns: the pointer to the queue (the caller must destroy it with
+ * #xmlSecThreadQueueDestroy) or NULL if an error occurs.
+ */
+xmlSecThreadQueuePtr
+xmlSecThreadQueueCreate(xmlSecSize size) {
+    xmlSecThreadQueuePtr queue;
+
+    xmlSecAssert2(size > 0, NULL);
+
+    queue = (xmlSecThreadQueuePtr)xmlMalloc(sizeof(xmlSecThreadQueue));
+    if(queue == NULL) {
+        xmlSecMallocError(sizeof(xmlSecThreadQueue), NULL);
+        return(NULL);
+    }
+    memset(queue, 0, sizeof(xmlSecThreadQueue));
+
+    queue->items = (void**)xmlMalloc(sizeof(void*) * size);
+    if(queue->items == NULL) {
+        xmlSecMallocError(sizeof(void*) * size, NULL);
+        xmlFree(queue);
+        return(NULL);
+    }
+    memset(queue->items, 0, sizeof(void*) * size);
+    queue->size = size;
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    InitializeCriticalSection(&(queue->lock));
+    InitializeConditionVariable(&(queue->cond));
+#else  /* defined(_WIN32) */
+    {
+        int ret;
+
+        ret = pthread_mutex_init(&(queue->lock), NULL);
+        if(ret != 0) {
+            xmlSecInternalError2("pthread_mutex_init", NULL, "ret=%d", ret);
+            xmlFree(queue->items);
+            xmlFree(queue);
+            return(NULL);
+        }
+        ret = pthread_cond_init(&(queue->cond), NULL);
+        if(ret != 0) {
+            xmlSecInternalError2("pthread_cond_init", NULL, "ret=%d", ret);
+            pthread_mutex_destroy(&(queue->lock));
+            xmlFree(queue->items);
+            xmlFree(queue);
+            return(NULL);
+        }
+    }
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+    return(queue);
+}
+
+/**
+ * xmlSecThreadQueueDestroy:
+ * @queue:              the pointer to the queue.
+ *
+ * Destroys the @queue (but not the items left in it). Both threads
+ * must be done with the @queue.
+ */
+void
+xmlSecThreadQueueDestroy(xmlSecThreadQueuePtr queue) {
+    xmlSecAssert(queue != NULL);
+
+#if !defined(XMLSEC_NO_THREADS)
+#if defined(_WIN32)
+    DeleteCriticalSection(&(queue->lock));
+#else  /* defined(_WIN32) */
+    pthread_cond_destroy(&(queue->cond));
+    pthread_mutex_destroy(&(queue->lock));
+#endif /* defined(_WIN32) */
+#endif /* !defined(XMLSEC_NO_THREADS) */
+
+    if(queue->items != NULL) {
+        xmlFree(queue->items);
+    }
+    memset(queue, 0, sizeof(xmlSecThreadQueue));
+    xmlFree(queue);
+}
+
+/**
+ * xmlSecThreadQueuePush:
+ * @queue:              the pointer to the queue.
+ * @item:               the item (must not be NULL).
+ *
+ * Adds the @item to the @queue, waits while the @queue is full
+ * (spins for a while and then blocks).
+ * Must be called only from the producer thread.
+ *
+ * Returns: 0 on success or a negative value if the @queue is closed.
+ */
+int
+xmlSecThreadQueuePush(xmlSecThreadQueuePtr queue, void* item) {
+    xmlSecSize tail;
+    xmlSecSize spin;
+
+    xmlSecAssert2(queue != NULL, -1);
+    xmlSecAssert2(queue->items != NULL, -1);
+    xmlSecAssert2(item != NULL, -1);
+
+    tail = xmlSecAtomicSizeGet(&(queue->tail));
+    for(spin = 0; (tail - xmlSecAtomicSizeGet(&(queue->head))) >= queue->size; ++spin) {
+        if(xmlSecAtomicIntGet(&(queue->closed)) != 0) {
+            return(-1);
+        }
+        if(spin < XMLSEC_THREAD_QUEUE_SPIN_NUM) {
+            xmlSecThreadYield();
+        } else {
+            xmlSecThreadQueueWait(queue, tail, 1);
+        }
+    }
+    if(xmlSecAtomicIntGet(&(queue->closed)) != 0) {
+        return(-1);
+    }
+
+    queue->items[tail % queue->size] = item;
+    xmlSecAtomicSizeSet(&(queue->tail), tail + 1);
+    xmlSecThreadQueueNotify(queue);
+    return(0);
+}
+
+/**
+ * xmlSecThreadQueuePop:
+ * @queue:              the pointer to the queue.
+ *
+ * Removes the first item from the @queue, waits while the @queue is
+ * empty (spins for a while and then blocks). Must be called only from the consumer thread.
+ *
+ * Returns: the item or NULL if the @queue is closed and empty.
+ */
+void*
+xmlSecThreadQueuePop(xmlSecThreadQueuePtr queue) {
+    xmlSecSize head;
+    xmlSecSize spin;
+    void* item;
+
+    xmlSecAssert2(queue != NULL, NULL);
+    xmlSecAssert2(queue->items != NULL, NULL);
+
+    head = xmlSecAtomicSizeGet(&(queue->head));
+    for(spin = 0; xmlSecAtomicSizeGet(&(queue->tail)) == head; ++spin) {
+        if(xmlSecAtomicIntGet(&(queue->closed)) != 0) {
+            /* the items pushed before closing are visible now */
+            if(xmlSecAtomicSizeGet(&(queue->tail)) == head) {
+                return(NULL);
+            }
+            break;
+        }
+        if(spin < XMLSEC_THREAD_QUEUE_SPIN_NUM) {
+            xmlSecThreadYield();
+        } else {
+            xmlSecThreadQueueWait(queue, head, 0);
+        }
+    }
+
+    item = queue->items[head % queue->size];
+    queue->items[head % queue->size] = NULL;
+    xmlSecAtomicSizeSet(&(queue->head), head + 1);
+    xmlSecThreadQueueNotify(queue);
+    return(item);
+}
+
+/**
+ * xmlSecThreadQueueClose:
+ * @queue:              the pointer to the queue.
+ *
+ * Closes the @queue: the producer closes it after the last item and
+ * the consumer closes it to stop the producer.
+ */
+void
+xmlSecThreadQueueClose(xmlSecThreadQueuePtr queue) {
+    xmlSecAssert(queue != NULL);
+
+    if(xmlSecAtomicIntGet(&(queue->closed)) == 0) {
+        xmlSecAtomicIntIncrement(&(queue->closed));
+    }
+    xmlSecThreadQueueNotify(queue);
+}
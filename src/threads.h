@@ -0,0 +1,89 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * Minimal threads support for the parallel processing.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_THREADS_H__
+#define __XMLSEC_THREADS_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "this file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/********************************************************************
+ *
+ * Threads: if threads support is disabled (XMLSEC_NO_THREADS) then
+ * the thread function is executed synchronously in
+ * xmlSecThreadCreate() and xmlSecThreadJoin() just frees the thread.
+ *
+ * Use libxml2 mutexes (xmlNewMutex(), etc.) for the synchronization.
+ *
+ ********************************************************************/
+typedef struct _xmlSecThread                        xmlSecThread,
+                                                    *xmlSecThreadPtr;
+typedef void    (*xmlSecThreadFunc)                 (void* data);
+
+XMLSEC_EXPORT xmlSecThreadPtr   xmlSecThreadCreate  (xmlSecThreadFunc func,
+                                                     void* data);
+XMLSEC_EXPORT int               xmlSecThreadJoin    (xmlSecThreadPtr thread);
+XMLSEC_EXPORT int               xmlSecThreadsEnabled(void);
+XMLSEC_EXPORT void              xmlSecThreadYield   (void);
+
+/********************************************************************
+ *
+ * Atomics: the pointer and size values published by one thread and
+ * read without locks by the others. All the operations are sequentially
+ * consistent: everything written before the store is visible to the thread
+ * that loads the stored value.
+ *
+ ********************************************************************/
+XMLSEC_EXPORT void*             xmlSecAtomicPtrGet  (void* const volatile* ptr);
+XMLSEC_EXPORT void              xmlSecAtomicPtrSet  (void* volatile* ptr,
+                                                     void* value);
+XMLSEC_EXPORT xmlSecSize        xmlSecAtomicSizeGet (const volatile xmlSecSize* ptr);
+XMLSEC_EXPORT void              xmlSecAtomicSizeSet (volatile xmlSecSize* ptr,
+                                                     xmlSecSize value);
+XMLSEC_EXPORT int               xmlSecAtomicIntGet  (const volatile int* ptr);
+XMLSEC_EXPORT int               xmlSecAtomicIntIncrement(volatile int* ptr);
+XMLSEC_EXPORT int               xmlSecAtomicIntDecrement(volatile int* ptr);
+
+/********************************************************************
+ *
+ * Queue: the bounded lock-free queue of pointers between exactly one
+ * producer thread and exactly one consumer thread. Push waits while the
+ * queue is full and pop waits while the queue is empty (yielding the CPU
+ * for a few rounds and then blocking on a condition variable).
+ * After the queue is closed (by either side) push fails and pop returns
+ * the remaining items and then NULL.
+ *
+ ********************************************************************/
+typedef struct _xmlSecThreadQueue                   xmlSecThreadQueue,
+                                                    *xmlSecThreadQueuePtr;
+
+XMLSEC_EXPORT xmlSecThreadQueuePtr xmlSecThreadQueueCreate(xmlSecSize size);
+XMLSEC_EXPORT void              xmlSecThreadQueueDestroy(xmlSecThreadQueuePtr queue);
+XMLSEC_EXPORT int               xmlSecThreadQueuePush(xmlSecThreadQueuePtr queue,
+                                                     void* item);
+XMLSEC_EXPORT void*             xmlSecThreadQueuePop(xmlSecThreadQueuePtr queue);
+XMLSEC_EXPORT void              xmlSecThreadQueueClose(xmlSecThreadQueuePtr queue);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_THREADS_H__ */
@@ -0,0 +1,50 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Monotonic timer for the statistics collection.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif /* defined(_WIN32) */
+
+#include <xmlsec/xmlsec.h>
+
+#include "timer.h"
+
+/**
+ * xmlSecTimerGetTime:
+ *
+ * Gets the current value of the monotonic clock. The value is only
+ * meaningful when compared with another value returned by this function.
+ *
+ * Returns: the current time in seconds.
+ */
+double
+xmlSecTimerGetTime(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER counter;
+
+    if(freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&counter);
+    return((double)counter.QuadPart / (double)freq.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0);
+#else  /* defined(_WIN32) */
+    return((double)clock() / (double)CLOCKS_PER_SEC);
+#endif /* defined(_WIN32) */
+}
@@ -0,0 +1,175 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Tracing hooks.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+/**
+ * SECTION:trace
+ * @Short_description: Tracing hooks functions.
+ * @Stability: Stable
+ *
+ * The tracing hooks allow applications to receive span events for
+ * the signature, encryption, key lookup and X509 verification operations
+ * (e.g. to export them to a tracing or metrics system).
+ */
+#include "globals.h"
+
+#include <string.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/keys.h>
+#include <xmlsec/transforms.h>
+#include <xmlsec/trace.h>
+#include <xmlsec/errors.h>
+
+#include "timer.h"
+#include "trace_helpers.h"
+
+xmlSecTraceCallback     xmlSecTraceClbk = NULL;
+static void*            xmlSecTraceClbkContext = NULL;
+
+/**
+ * xmlSecTraceSetCallback:
+ * @callback:           the new tracing callback function or NULL to disable tracing.
+ * @context:            the context passed to @callback.
+ *
+ * Sets the tracing callback function to @callback that will be called
+ * every time a span starts or ends. The callback is global and should
+ * be set before the library is used from multiple threads.
+ */
+void
+xmlSecTraceSetCallback(xmlSecTraceCallback callback, void* context) {
+    xmlSecTraceClbkContext = context;
+    xmlSecTraceClbk = callback;
+}
+
+/**
+ * xmlSecTraceGetCallback:
+ *
+ * Gets the current tracing callback function.
+ *
+ * Returns: the current tracing callback or NULL if tracing is disabled.
+ */
+xmlSecTraceCallback
+xmlSecTraceGetCallback(void) {
+    return(xmlSecTraceClbk);
+}
+
+/**
+ * xmlSecTraceSpanTypeGetName:
+ * @type:               the span type.
+ *
+ * Gets the span type name (e.g. for exporting spans).
+ *
+ * Returns: the span type name.
+ */
+const char*
+xmlSecTraceSpanTypeGetName(xmlSecTraceSpanType type) {
+    switch(type) {
+    case xmlSecTraceSpanTypeDSigSign:
+        return("dsig-sign");
+    case xmlSecTraceSpanTypeDSigVerify:
+        return("dsig-verify");
+    case xmlSecTraceSpanTypeDSigReference:
+        return("dsig-reference");
+    case xmlSecTraceSpanTypeEncEncrypt:
+        return("enc-encrypt");
+    case xmlSecTraceSpanTypeEncDecrypt:
+        return("enc-decrypt");
+    case xmlSecTraceSpanTypeKeyLookup:
+        return("key-lookup");
+    case xmlSecTraceSpanTypeX509Verify:
+        return("x509-verify");
+    case xmlSecTraceSpanTypeUnknown:
+    default:
+        return("unknown");
+    }
+}
+
+/**
+ * xmlSecTraceSpanStart:
+ * @span:               the pointer to the span.
+ * @type:               the span type.
+ * @ctx:                the operation context.
+ * @name:               the optional span name.
+ * @transformCtx:       the optional transforms context to collect the stats
+ *                      for the span size.
+ *
+ * Starts the @span and reports it to the tracing callback. Use
+ * XMLSEC_TRACE_SPAN_START macro instead of calling this function directly.
+ */
+void
+xmlSecTraceSpanStart(xmlSecTraceSpanPtr span, xmlSecTraceSpanType type, void* ctx,
+                     const xmlChar* name, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTraceCallback callback = xmlSecTraceClbk;
+
+    xmlSecAssert(span != NULL);
+
+    memset(span, 0, sizeof(xmlSecTraceSpan));
+    if(callback == NULL) {
+        /* tracing was disabled after the check */
+        return;
+    }
+
+    span->type      = type;
+    span->ctx       = ctx;
+    span->name      = name;
+    if(transformCtx != NULL) {
+        transformCtx->flags |= XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS;
+    }
+    span->startTime = xmlSecTimerGetTime();
+
+    callback(xmlSecTraceEventStart, span, xmlSecTraceClbkContext);
+}
+
+/**
+ * xmlSecTraceSpanEnd:
+ * @span:               the pointer to the span.
+ * @size:               the number of bytes processed.
+ * @status:             0 on success or a negative value otherwise.
+ *
+ * Ends the @span and reports it to the tracing callback. Use
+ * XMLSEC_TRACE_SPAN_END macro instead of calling this function directly.
+ */
+void
+xmlSecTraceSpanEnd(xmlSecTraceSpanPtr span, xmlSecSize size, int status) {
+    xmlSecTraceCallback callback = xmlSecTraceClbk;
+
+    xmlSecAssert(span != NULL);
+
+    span->duration  = xmlSecTimerGetTime() - span->startTime;
+    span->size      = size;
+    span->status    = status;
+
+    if(callback != NULL) {
+        callback(xmlSecTraceEventEnd, span, xmlSecTraceClbkContext);
+    }
+    span->type = xmlSecTraceSpanTypeUnknown;
+}
+
+/**
+ * xmlSecTraceSpanEndKeyLookup:
+ * @span:               the pointer to the span.
+ * @key:                the found key or NULL if the key was not found.
+ *
+ * Ends the key lookup @span: the span name is set to the @key name
+ * and the span size is set to the @key size in bits. Use
+ * XMLSEC_TRACE_SPAN_END_KEY_LOOKUP macro instead of calling this function
+ * directly.
+ */
+void
+xmlSecTraceSpanEndKeyLookup(xmlSecTraceSpanPtr span, xmlSecKeyPtr key) {
+    xmlSecAssert(span != NULL);
+
+    if(key == NULL) {
+        xmlSecTraceSpanEnd(span, 0, -1);
+        return;
+    }
+    span->name = xmlSecKeyGetName(key);
+    xmlSecTraceSpanEnd(span, xmlSecKeyGetSize(key), 0);
+}
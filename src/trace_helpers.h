@@ -0,0 +1,120 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Internal header only used during the compilation,
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2022 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+
+#ifndef __XMLSEC_TRACE_HELPERS_H__
+#define __XMLSEC_TRACE_HELPERS_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "trace_helpers.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/keys.h>
+#include <xmlsec/transforms.h>
+#include <xmlsec/trace.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**********************************************************************
+ *
+ * Tracing spans: if no tracing callback is installed then starting
+ * a span costs a single branch and ending it costs another one.
+ *
+ **********************************************************************/
+XMLSEC_EXPORT void              xmlSecTraceSpanStart            (xmlSecTraceSpanPtr span,
+                                                                 xmlSecTraceSpanType type,
+                                                                 void* ctx,
+                                                                 const xmlChar* name,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+XMLSEC_EXPORT void              xmlSecTraceSpanEnd              (xmlSecTraceSpanPtr span,
+                                                                 xmlSecSize size,
+                                                                 int status);
+XMLSEC_EXPORT void              xmlSecTraceSpanEndKeyLookup     (xmlSecTraceSpanPtr span,
+                                                                 xmlSecKeyPtr key);
+
+/* the crypto libraries can't import the data from the core library on Windows */
+#if defined(IN_XMLSEC)
+extern xmlSecTraceCallback      xmlSecTraceClbk;
+#define XMLSEC_TRACE_IS_ENABLED() \
+    (xmlSecTraceClbk != NULL)
+#else  /* defined(IN_XMLSEC) */
+#define XMLSEC_TRACE_IS_ENABLED() \
+    (xmlSecTraceGetCallback() != NULL)
+#endif /* defined(IN_XMLSEC) */
+
+/**
+ * XMLSEC_TRACE_SPAN_START:
+ * @span:               the pointer to the span (usually on stack).
+ * @spanType:           the span type.
+ * @spanCtx:            the operation context.
+ * @spanName:           the optional span name.
+ * @spanTransformCtx:   the optional transforms context: the transforms
+ *                      stats are collected to report the span size.
+ *
+ * Macro. Starts the span if the tracing callback is installed.
+ */
+#define XMLSEC_TRACE_SPAN_START(span, spanType, spanCtx, spanName, spanTransformCtx) \
+    do {                                                                    \
+        if(XMLSEC_TRACE_IS_ENABLED()) {                                     \
+            xmlSecTraceSpanStart((span), (spanType), (spanCtx),             \
+                                 (spanName), (spanTransformCtx));           \
+        } else {                                                            \
+            (span)->type = xmlSecTraceSpanTypeUnknown;                      \
+        }                                                                   \
+    } while(0)
+
+/**
+ * XMLSEC_TRACE_SPAN_IS_ACTIVE:
+ * @span:               the pointer to the span.
+ *
+ * Macro. Returns 1 if the span was started with the tracing
+ * callback installed (i.e. the span size needs to be calculated).
+ */
+#define XMLSEC_TRACE_SPAN_IS_ACTIVE(span) \
+    ((span)->type != xmlSecTraceSpanTypeUnknown)
+
+/**
+ * XMLSEC_TRACE_SPAN_END:
+ * @span:               the pointer to the span.
+ * @spanSize:           the number of bytes processed.
+ * @spanStatus:         0 on success or a negative value otherwise.
+ *
+ * Macro. Ends the span if it was started.
+ */
+#define XMLSEC_TRACE_SPAN_END(span, spanSize, spanStatus) \
+    do {                                                                    \
+        if(XMLSEC_TRACE_SPAN_IS_ACTIVE(span)) {                             \
+            xmlSecTraceSpanEnd((span), (spanSize), (spanStatus));           \
+        }                                                                   \
+    } while(0)
+
+/**
+ * XMLSEC_TRACE_SPAN_END_KEY_LOOKUP:
+ * @span:               the pointer to the span.
+ * @key:                the found key or NULL if the key was not found.
+ *
+ * Macro. Ends the key lookup span if it was started.
+ */
+#define XMLSEC_TRACE_SPAN_END_KEY_LOOKUP(span, key) \
+    do {                                                                    \
+        if(XMLSEC_TRACE_SPAN_IS_ACTIVE(span)) {                             \
+            xmlSecTraceSpanEndKeyLookup((span), (key));                     \
+        }                                                                   \
+    } while(0)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_TRACE_HELPERS_H__ */
@@ -21,6 +21,10 @@
 #include <xmlsec/keyinfo.h>
 #include <xmlsec/transforms.h>
 
+#ifdef LIBXML_READER_ENABLED
+#include <libxml/xmlreader.h>
+#endif /* LIBXML_READER_ENABLED */
+
 
 /**************************** Common Key Agreement params ********************************/
 struct _xmlSecTransformKeyAgreementParams {
@@ -46,6 +50,72 @@ XMLSEC_EXPORT int   xmlSecTransformKeyAgreementParamsWrite         (xmlSecTransf
                                                                     xmlSecTransformCtxPtr transformCtx);
 
 
+/**************************** C14N ********************************/
+XMLSEC_EXPORT int xmlSecTransformC14NExecuteSubtree             (xmlSecTransformPtr transform,
+                                                                 xmlNodePtr node,
+                                                                 xmlSecBufferPtr out);
+
+#ifdef LIBXML_READER_ENABLED
+typedef struct _xmlSecTransformC14NStream                       xmlSecTransformC14NStream,
+                                                                *xmlSecTransformC14NStreamPtr;
+
+XMLSEC_EXPORT xmlSecTransformC14NStreamPtr xmlSecTransformC14NStreamCreate(xmlSecTransformPtr transform);
+XMLSEC_EXPORT void xmlSecTransformC14NStreamDestroy             (xmlSecTransformC14NStreamPtr stream);
+XMLSEC_EXPORT int xmlSecTransformC14NStreamRead                 (xmlSecTransformC14NStreamPtr stream,
+                                                                 xmlTextReaderPtr reader,
+                                                                 xmlSecBufferPtr out);
+XMLSEC_EXPORT int xmlSecTransformC14NStreamEndElement           (xmlSecTransformC14NStreamPtr stream,
+                                                                 xmlTextReaderPtr reader,
+                                                                 xmlSecBufferPtr out);
+#endif /* LIBXML_READER_ENABLED */
+
+
+/**************************** Transforms ctx private data ********************************/
+XMLSEC_EXPORT int xmlSecTransformCtxSetPrefetch                  (xmlSecTransformCtxPtr ctx,
+                                                                 xmlSecIOPrefetchPtr prefetch);
+XMLSEC_EXPORT xmlSecIOPrefetchPtr xmlSecTransformCtxGetPrefetch  (xmlSecTransformCtxPtr ctx);
+XMLSEC_EXPORT int xmlSecTransformCtxSetArena                     (xmlSecTransformCtxPtr ctx,
+                                                                 xmlSecArenaPtr arena);
+XMLSEC_EXPORT xmlSecArenaPtr xmlSecTransformCtxGetArena          (xmlSecTransformCtxPtr ctx);
+XMLSEC_EXPORT void xmlSecTransformCtxSetStatsCurrent              (xmlSecTransformCtxPtr ctx,
+                                                                 xmlSecTransformPtr transform);
+
+/**************************** Transforms batch execution ********************************/
+/**
+ * xmlSecTransformExecuteBatchMethod:
+ * @transforms:                 the transforms of the same klass.
+ * @transformsSize:             the number of transforms in @transforms.
+ * @transformCtx:               the pointer to transform context object.
+ *
+ * Transform specific method to process the inputs of several transforms
+ * at once, e.g. the digests of many small references. Each transform has
+ * the whole input in its input buffer. The method puts the results in the
+ * transforms output buffers, empties the input buffers and sets the
+ * transforms status to #xmlSecTransformStatusFinished.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+typedef int             (*xmlSecTransformExecuteBatchMethod)    (xmlSecTransformPtr* transforms,
+                                                                 xmlSecSize transformsSize,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+
+XMLSEC_EXPORT int xmlSecTransformExecuteBatchRegister            (xmlSecTransformId id,
+                                                                 xmlSecTransformExecuteBatchMethod executeBatch);
+XMLSEC_EXPORT xmlSecTransformExecuteBatchMethod xmlSecTransformExecuteBatchFind(xmlSecTransformId id);
+
+/**************************** Transforms private data ********************************/
+XMLSEC_EXPORT xmlSecTransformStatsPtr xmlSecTransformGetStats    (xmlSecTransformPtr transform);
+
+
+/**************************** Pipeline ********************************/
+XMLSEC_EXPORT xmlOutputBufferPtr xmlSecTransformCreatePipelineOutputBuffer(xmlSecTransformPtr transform,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+
+
+/**************************** Input URI ********************************/
+XMLSEC_EXPORT xmlSecBufferPtr xmlSecTransformInputURIGetBuffer      (xmlSecTransformPtr transform);
+
+
 /**************************** ConcatKDF ********************************/
 #ifndef XMLSEC_NO_CONCATKDF
 
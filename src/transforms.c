@@ -59,6 +59,7 @@
 #include <libxml/xpointer.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/buffer.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/keysdata.h>
@@ -74,28 +75,64 @@
 
 #include "xslt.h"
 #include "cast_helpers.h"
+#include "registry.h"
+#include "threads.h"
+#include "timer.h"
+#include "trace_helpers.h"
 #include "transform_helpers.h"
 
 #define XMLSEC_TRANSFORM_XPOINTER_TMPL "xpointer(id(\'%s\'))"
 
+/* the private data that doesn't fit in the public xmlSecTransform layout,
+ * it is allocated together with the transform object (right after the
+ * klass objSize bytes) and stored in transform->reserved0 */
+typedef struct _xmlSecTransformPrivate          xmlSecTransformPrivate,
+                                                *xmlSecTransformPrivatePtr;
+struct _xmlSecTransformPrivate {
+    xmlSecArenaPtr                      arena;      /* the transform memory is released with the arena */
+    xmlSecTransformStats                stats;      /* see XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS */
+};
+
+#define XMLSEC_TRANSFORM_PRIVATE_ALIGN          16
+#define xmlSecTransformPrivateOffset(id) \
+    ((((id)->objSize) + XMLSEC_TRANSFORM_PRIVATE_ALIGN - 1) & ~((xmlSecSize)XMLSEC_TRANSFORM_PRIVATE_ALIGN - 1))
+#define xmlSecTransformAllocSize(id) \
+    (xmlSecTransformPrivateOffset(id) + sizeof(xmlSecTransformPrivate))
+#define xmlSecTransformGetPrivate(transform) \
+    ((xmlSecTransformPrivatePtr)((transform)->reserved0))
+
 /**************************************************************************
  *
  * Global xmlSecTransformIds list functions
  *
  *************************************************************************/
-static xmlSecPtrList xmlSecAllTransformIds;
+static xmlSecPtrRegistry xmlSecAllTransformIds;
+
+/* the transform klasses that can be executed in batches (see transform_helpers.h),
+ * the table is filled in by the crypto libraries initialization */
+#define XMLSEC_TRANSFORM_EXECUTE_BATCH_MAX_SIZE         16
+
+typedef struct _xmlSecTransformExecuteBatchItem {
+    xmlSecTransformId                   id;
+    xmlSecTransformExecuteBatchMethod   executeBatch;
+} xmlSecTransformExecuteBatchItem;
+
+static xmlSecTransformExecuteBatchItem xmlSecTransformExecuteBatchItems[XMLSEC_TRANSFORM_EXECUTE_BATCH_MAX_SIZE];
+static xmlSecSize xmlSecTransformExecuteBatchItemsSize = 0;
 
 
 /**
  * xmlSecTransformIdsGet:
  *
- * Gets global registered transform klasses list.
+ * Gets global registered transform klasses list. The returned list is
+ * a read-only snapshot that is safe to use from multiple threads while
+ * new transform klasses are registered.
  *
  * Returns: the pointer to list of all registered transform klasses.
  */
 xmlSecPtrListPtr
 xmlSecTransformIdsGet(void) {
-    return(&xmlSecAllTransformIds);
+    return(xmlSecPtrRegistryGet(&xmlSecAllTransformIds));
 }
 
 /**
@@ -110,9 +147,9 @@ int
 xmlSecTransformIdsInit(void) {
     int ret;
 
-    ret = xmlSecPtrListInitialize(xmlSecTransformIdsGet(), xmlSecTransformIdListId);
+    ret = xmlSecPtrRegistryInitialize(&xmlSecAllTransformIds, xmlSecTransformIdListId);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListInitialize(xmlSecTransformIdListId)", NULL);
+        xmlSecInternalError("xmlSecPtrRegistryInitialize(xmlSecTransformIdListId)", NULL);
         return(-1);
     }
 
@@ -141,14 +178,81 @@ xmlSecTransformIdsShutdown(void) {
     xmlSecTransformXsltShutdown();
 #endif /* XMLSEC_NO_XSLT */
 
-    xmlSecPtrListFinalize(xmlSecTransformIdsGet());
+    xmlSecPtrRegistryFinalize(&xmlSecAllTransformIds);
+
+    memset(xmlSecTransformExecuteBatchItems, 0, sizeof(xmlSecTransformExecuteBatchItems));
+    xmlSecTransformExecuteBatchItemsSize = 0;
+}
+
+/**
+ * xmlSecTransformExecuteBatchRegister:
+ * @id:                 the transform klass.
+ * @executeBatch:       the method to process the inputs of several @id
+ *                      transforms at once or NULL to remove it.
+ *
+ * Sets the batch execution method for @id transforms (see
+ * #XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE). This function is not thread
+ * safe and should be called from the crypto library initialization or
+ * shutdown.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformExecuteBatchRegister(xmlSecTransformId id, xmlSecTransformExecuteBatchMethod executeBatch) {
+    xmlSecSize ii;
+
+    xmlSecAssert2(id != xmlSecTransformIdUnknown, -1);
+
+    for(ii = 0; ii < xmlSecTransformExecuteBatchItemsSize; ++ii) {
+        if(xmlSecTransformExecuteBatchItems[ii].id == id) {
+            xmlSecTransformExecuteBatchItems[ii].executeBatch = executeBatch;
+            return(0);
+        }
+    }
+    if(executeBatch == NULL) {
+        return(0);
+    }
+    if(xmlSecTransformExecuteBatchItemsSize >= XMLSEC_TRANSFORM_EXECUTE_BATCH_MAX_SIZE) {
+        xmlSecInvalidSizeMoreThanError("Batch transforms",
+            xmlSecTransformExecuteBatchItemsSize + 1, (xmlSecSize)XMLSEC_TRANSFORM_EXECUTE_BATCH_MAX_SIZE,
+            xmlSecTransformKlassGetName(id));
+        return(-1);
+    }
+    xmlSecTransformExecuteBatchItems[xmlSecTransformExecuteBatchItemsSize].id = id;
+    xmlSecTransformExecuteBatchItems[xmlSecTransformExecuteBatchItemsSize].executeBatch = executeBatch;
+    ++xmlSecTransformExecuteBatchItemsSize;
+    return(0);
+}
+
+/**
+ * xmlSecTransformExecuteBatchFind:
+ * @id:                 the transform klass.
+ *
+ * Gets the batch execution method for @id transforms.
+ *
+ * Returns: the batch execution method or NULL if @id transforms can not
+ * be executed in batches.
+ */
+xmlSecTransformExecuteBatchMethod
+xmlSecTransformExecuteBatchFind(xmlSecTransformId id) {
+    xmlSecSize ii;
+
+    xmlSecAssert2(id != xmlSecTransformIdUnknown, NULL);
+
+    for(ii = 0; ii < xmlSecTransformExecuteBatchItemsSize; ++ii) {
+        if(xmlSecTransformExecuteBatchItems[ii].id == id) {
+            return(xmlSecTransformExecuteBatchItems[ii].executeBatch);
+        }
+    }
+    return(NULL);
 }
 
 /**
  * xmlSecTransformIdsRegister:
  * @id:                 the transform klass.
  *
- * Registers @id in the global list of transform klasses.
+ * Registers @id in the global list of transform klasses. This function
+ * is thread safe: the new list is published atomically.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
@@ -158,9 +262,9 @@ xmlSecTransformIdsRegister(xmlSecTransformId id) {
 
     xmlSecAssert2(id != xmlSecTransformIdUnknown, -1);
 
-    ret = xmlSecPtrListAdd(xmlSecTransformIdsGet(), (xmlSecPtr)id);
+    ret = xmlSecPtrRegistryAdd(&xmlSecAllTransformIds, (xmlSecPtr)id);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecPtrListAdd",
+        xmlSecInternalError("xmlSecPtrRegistryAdd",
                             xmlSecTransformKlassGetName(id));
         return(-1);
     }
@@ -282,7 +386,7 @@ xmlSecTransformUriTypeCheck(xmlSecTransformUriType type, const xmlChar* uri) {
  * xmlSecTransformCtx
  *
  *************************************************************************/
-static xmlSecSize g_xmlSecTransformCtxDefaultBinaryChunkSize = (64*1024); /* 64kb */
+static volatile xmlSecSize g_xmlSecTransformCtxDefaultBinaryChunkSize = (64*1024); /* 64kb */
 
 /**
  * xmlSecTransformCtxGetDefaultBinaryChunkSize:
@@ -294,7 +398,7 @@ static xmlSecSize g_xmlSecTransformCtxDefaultBinaryChunkSize = (64*1024); /* 64k
  */
 xmlSecSize
 xmlSecTransformCtxGetDefaultBinaryChunkSize(void) {
-    return(g_xmlSecTransformCtxDefaultBinaryChunkSize);
+    return(xmlSecAtomicSizeGet(&g_xmlSecTransformCtxDefaultBinaryChunkSize));
 }
 
 
@@ -304,15 +408,173 @@ xmlSecTransformCtxGetDefaultBinaryChunkSize(void) {
  *
  * Sets the default binary chunk size. Increasing the chunk size improves
  * XMLSec library performance at the expense of increased memory usage.
- * This function is not thread safe and should only be called during initialization.
+ * The new value is used by the transform contexts initialized after this call.
  */
 void
 xmlSecTransformCtxSetDefaultBinaryChunkSize(xmlSecSize binaryChunkSize) {
     xmlSecAssert(binaryChunkSize > 0);
-    g_xmlSecTransformCtxDefaultBinaryChunkSize = binaryChunkSize;
+    xmlSecAtomicSizeSet(&g_xmlSecTransformCtxDefaultBinaryChunkSize, binaryChunkSize);
+}
+
+
+/* the private data that doesn't fit in the public xmlSecTransformCtx
+ * layout, it is created on demand and stored in ctx->reserved0 */
+typedef struct _xmlSecTransformCtxPrivate       xmlSecTransformCtxPrivate,
+                                                *xmlSecTransformCtxPrivatePtr;
+struct _xmlSecTransformCtxPrivate {
+    xmlSecIOPrefetchPtr                         prefetch;       /* not owned */
+    xmlSecArenaPtr                              arena;          /* not owned */
+    xmlSecTransformPtr                          statsCurrent;   /* the currently executed transform */
+    int                                         pipelined;      /* the transforms are owned by the pipeline thread */
+};
+
+static xmlSecTransformCtxPrivatePtr
+xmlSecTransformCtxGetPrivate(xmlSecTransformCtxPtr ctx, int create) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    priv = (xmlSecTransformCtxPrivatePtr)ctx->reserved0;
+    if((priv != NULL) || (create == 0)) {
+        return(priv);
+    }
+
+    priv = (xmlSecTransformCtxPrivatePtr)xmlSecMalloc(sizeof(xmlSecTransformCtxPrivate), xmlSecAllocatorObjectTypeCtx);
+    if(priv == NULL) {
+        xmlSecMallocError(sizeof(xmlSecTransformCtxPrivate), NULL);
+        return(NULL);
+    }
+    memset(priv, 0, sizeof(xmlSecTransformCtxPrivate));
+    ctx->reserved0 = priv;
+    return(priv);
 }
 
+/* checks that the @ctx is not handed off to the pipeline thread: until the
+ * pipeline output buffer is closed the caller must not touch the @ctx */
+static int
+xmlSecTransformCtxIsOwned(xmlSecTransformCtxPtr ctx) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert2(ctx != NULL, 0);
 
+    priv = xmlSecTransformCtxGetPrivate(ctx, 0);
+    return(((priv == NULL) || (priv->pipelined == 0)) ? 1 : 0);
+}
+
+/**
+ * xmlSecTransformCtxSetPrefetch:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @prefetch:           the prefetched external URIs (not owned by the @ctx) or NULL.
+ *
+ * Sets the prefetched URIs: if the data source URI was prefetched then
+ * the data is taken from the memory instead of re-opening the URI.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformCtxSetPrefetch(xmlSecTransformCtxPtr ctx, xmlSecIOPrefetchPtr prefetch) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert2(ctx != NULL, -1);
+
+    priv = xmlSecTransformCtxGetPrivate(ctx, (prefetch != NULL) ? 1 : 0);
+    if(priv == NULL) {
+        if(prefetch != NULL) {
+            xmlSecInternalError("xmlSecTransformCtxGetPrivate", NULL);
+            return(-1);
+        }
+        return(0);
+    }
+    priv->prefetch = prefetch;
+    return(0);
+}
+
+/**
+ * xmlSecTransformCtxGetPrefetch:
+ * @ctx:                the pointer to transforms chain processing context.
+ *
+ * Gets the prefetched URIs set with #xmlSecTransformCtxSetPrefetch.
+ *
+ * Returns: the prefetched URIs or NULL.
+ */
+xmlSecIOPrefetchPtr
+xmlSecTransformCtxGetPrefetch(xmlSecTransformCtxPtr ctx) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    priv = xmlSecTransformCtxGetPrivate(ctx, 0);
+    return((priv != NULL) ? priv->prefetch : NULL);
+}
+
+/**
+ * xmlSecTransformCtxSetArena:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @arena:              the per-operation arena (not owned by the @ctx) or NULL.
+ *
+ * Sets the arena: the transforms created by the @ctx are allocated from
+ * the @arena and must not outlive it.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformCtxSetArena(xmlSecTransformCtxPtr ctx, xmlSecArenaPtr arena) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert2(ctx != NULL, -1);
+
+    priv = xmlSecTransformCtxGetPrivate(ctx, (arena != NULL) ? 1 : 0);
+    if(priv == NULL) {
+        if(arena != NULL) {
+            xmlSecInternalError("xmlSecTransformCtxGetPrivate", NULL);
+            return(-1);
+        }
+        return(0);
+    }
+    priv->arena = arena;
+    return(0);
+}
+
+/**
+ * xmlSecTransformCtxGetArena:
+ * @ctx:                the pointer to transforms chain processing context.
+ *
+ * Gets the arena set with #xmlSecTransformCtxSetArena.
+ *
+ * Returns: the arena or NULL.
+ */
+xmlSecArenaPtr
+xmlSecTransformCtxGetArena(xmlSecTransformCtxPtr ctx) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    priv = xmlSecTransformCtxGetPrivate(ctx, 0);
+    return((priv != NULL) ? priv->arena : NULL);
+}
+
+/**
+ * xmlSecTransformCtxSetStatsCurrent:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @transform:          the transform that produces the data pushed next or NULL.
+ *
+ * Sets the currently executed transform: the data pushed to the next
+ * transforms are counted as the @transform output and the time spent in
+ * the next transforms is excluded from the @transform time (see
+ * #XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS).
+ */
+void
+xmlSecTransformCtxSetStatsCurrent(xmlSecTransformCtxPtr ctx, xmlSecTransformPtr transform) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    xmlSecAssert(ctx != NULL);
+
+    /* the stats are best effort: no caller if we can't allocate the private data */
+    priv = xmlSecTransformCtxGetPrivate(ctx, (transform != NULL) ? 1 : 0);
+    if(priv != NULL) {
+        priv->statsCurrent = transform;
+    }
+}
 
 /**
  * xmlSecTransformCtxCreate:
@@ -330,7 +592,7 @@ xmlSecTransformCtxCreate(void) {
     int ret;
 
     /* Allocate a new xmlSecTransform and fill the fields. */
-    ctx = (xmlSecTransformCtxPtr)xmlMalloc(sizeof(xmlSecTransformCtx));
+    ctx = (xmlSecTransformCtxPtr)xmlSecMalloc(sizeof(xmlSecTransformCtx), xmlSecAllocatorObjectTypeTransform);
     if(ctx == NULL) {
         xmlSecMallocError(sizeof(xmlSecTransformCtx), NULL);
         return(NULL);
@@ -357,7 +619,7 @@ xmlSecTransformCtxDestroy(xmlSecTransformCtxPtr ctx) {
     xmlSecAssert(ctx != NULL);
 
     xmlSecTransformCtxFinalize(ctx);
-    xmlFree(ctx);
+    xmlSecFree(ctx, sizeof(xmlSecTransformCtx), xmlSecAllocatorObjectTypeTransform);
 }
 
 /**
@@ -401,6 +663,9 @@ xmlSecTransformCtxFinalize(xmlSecTransformCtxPtr ctx) {
 
     xmlSecTransformCtxReset(ctx);
     xmlSecPtrListFinalize(&(ctx->enabledTransforms));
+    if(ctx->reserved0 != NULL) {
+        xmlSecFree(ctx->reserved0, sizeof(xmlSecTransformCtxPrivate), xmlSecAllocatorObjectTypeCtx);
+    }
     memset(ctx, 0, sizeof(xmlSecTransformCtx));
 }
 
@@ -415,6 +680,7 @@ xmlSecTransformCtxReset(xmlSecTransformCtxPtr ctx) {
     xmlSecTransformPtr transform, tmp;
 
     xmlSecAssert(ctx != NULL);
+    xmlSecAssert(xmlSecTransformCtxIsOwned(ctx) != 0);
 
     ctx->result = NULL;
     ctx->status = xmlSecTransformStatusNone;
@@ -435,6 +701,7 @@ xmlSecTransformCtxReset(xmlSecTransformCtxPtr ctx) {
         xmlSecTransformDestroy(transform);
     }
     ctx->first = ctx->last = NULL;
+    xmlSecTransformCtxSetStatsCurrent(ctx, NULL);
 }
 
 /**
@@ -459,6 +726,12 @@ xmlSecTransformCtxCopyUserPref(xmlSecTransformCtxPtr dst, xmlSecTransformCtxPtr
     dst->enabledUris     = src->enabledUris;
     dst->preExecCallback = src->preExecCallback;
 
+    ret = xmlSecTransformCtxSetPrefetch(dst, xmlSecTransformCtxGetPrefetch(src));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxSetPrefetch", NULL);
+        return(-1);
+    }
+
     ret = xmlSecPtrListCopy(&(dst->enabledTransforms), &(src->enabledTransforms));
     if(ret < 0) {
         xmlSecInternalError("xmlSecPtrListCopy(enabledTransforms)", NULL);
@@ -483,6 +756,7 @@ xmlSecTransformCtxAppend(xmlSecTransformCtxPtr ctx, xmlSecTransformPtr transform
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
 
@@ -517,6 +791,7 @@ xmlSecTransformCtxPrepend(xmlSecTransformCtxPtr ctx, xmlSecTransformPtr transfor
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
 
@@ -552,10 +827,11 @@ xmlSecTransformCtxCreateAndAppend(xmlSecTransformCtxPtr ctx, xmlSecTransformId i
     int ret;
 
     xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, NULL);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, NULL);
     xmlSecAssert2(id != xmlSecTransformIdUnknown, NULL);
 
-    transform = xmlSecTransformCreate(id);
+    transform = xmlSecTransformCreateInArena(id, xmlSecTransformCtxGetArena(ctx));
     if(!xmlSecTransformIsValid(transform)) {
         xmlSecInternalError("xmlSecTransformCreate",
                             xmlSecTransformKlassGetName(id));
@@ -589,10 +865,11 @@ xmlSecTransformCtxCreateAndPrepend(xmlSecTransformCtxPtr ctx, xmlSecTransformId
     int ret;
 
     xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, NULL);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, NULL);
     xmlSecAssert2(id != xmlSecTransformIdUnknown, NULL);
 
-    transform = xmlSecTransformCreate(id);
+    transform = xmlSecTransformCreateInArena(id, xmlSecTransformCtxGetArena(ctx));
     if(!xmlSecTransformIsValid(transform)) {
         xmlSecInternalError("xmlSecTransformCreate",
                             xmlSecTransformKlassGetName(id));
@@ -628,6 +905,7 @@ xmlSecTransformCtxNodeRead(xmlSecTransformCtxPtr ctx, xmlNodePtr node,
     int ret;
 
     xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, NULL);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, NULL);
     xmlSecAssert2(node != NULL, NULL);
 
@@ -667,6 +945,7 @@ xmlSecTransformCtxNodesListRead(xmlSecTransformCtxPtr ctx, xmlNodePtr node, xmlS
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
     xmlSecAssert2(node != NULL, -1);
 
@@ -745,6 +1024,7 @@ xmlSecTransformCtxSetUri(xmlSecTransformCtxPtr ctx, const xmlChar* uri, xmlNodeP
     int res = -1;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->uri == NULL, -1);
     xmlSecAssert2(ctx->xptrExpr == NULL, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
@@ -892,6 +1172,7 @@ xmlSecTransformCtxPrepare(xmlSecTransformCtxPtr ctx, xmlSecTransformDataType inp
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->result == NULL, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
 
@@ -959,6 +1240,7 @@ xmlSecTransformCtxBinaryExecute(xmlSecTransformCtxPtr ctx,
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->result == NULL, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
 
@@ -994,9 +1276,12 @@ xmlSecTransformCtxBinaryExecute(xmlSecTransformCtxPtr ctx,
 int
 xmlSecTransformCtxUriExecute(xmlSecTransformCtxPtr ctx, const xmlChar* uri) {
     xmlSecTransformPtr uriTransform;
+    xmlSecIOPrefetchPtr prefetch;
+    xmlSecBufferPtr inputBuffer;
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
     xmlSecAssert2(uri != NULL, -1);
 
@@ -1009,11 +1294,23 @@ xmlSecTransformCtxUriExecute(xmlSecTransformCtxPtr ctx, const xmlChar* uri) {
         return(-1);
     }
 
-    ret = xmlSecTransformInputURIOpen(uriTransform, uri);
-    if(ret < 0) {
-        xmlSecInternalError2("xmlSecTransformInputURIOpen", NULL,
-                            "uri=%s", xmlSecErrorsSafeString(uri));
-        return(-1);
+    /* use the prefetched data if we have it */
+    prefetch = xmlSecTransformCtxGetPrefetch(ctx);
+    inputBuffer = (prefetch != NULL) ? xmlSecIOPrefetchGetBuffer(prefetch, uri) : NULL;
+    if(inputBuffer != NULL) {
+        ret = xmlSecTransformInputURIOpenBuffer(uriTransform, inputBuffer);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformInputURIOpenBuffer", NULL,
+                                "uri=%s", xmlSecErrorsSafeString(uri));
+            return(-1);
+        }
+    } else {
+        ret = xmlSecTransformInputURIOpen(uriTransform, uri);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformInputURIOpen", NULL,
+                                "uri=%s", xmlSecErrorsSafeString(uri));
+            return(-1);
+        }
     }
 
     /* we do not need to do something special for this transform */
@@ -1024,13 +1321,39 @@ xmlSecTransformCtxUriExecute(xmlSecTransformCtxPtr ctx, const xmlChar* uri) {
     }
 
     /* Now we have a choice: we either can push from first transform or pop
-     * from last. Our C14N transforms prefers push, so push data!
+     * from last. Our C14N transforms prefers push, so push data! The in-memory
+     * (prefetched or memory mapped) data is pushed as-is without copying.
      */
-    ret = xmlSecTransformPump(uriTransform, uriTransform->next, ctx);
-    if(ret < 0) {
-        xmlSecInternalError("xmlSecTransformPump",
-                            xmlSecTransformGetName(uriTransform));
-        return(-1);
+    inputBuffer = xmlSecTransformInputURIGetBuffer(uriTransform);
+    if((inputBuffer != NULL) && (uriTransform->next != NULL) &&
+       ((xmlSecTransformGetDataType(uriTransform->next, xmlSecTransformModePush, ctx) & xmlSecTransformDataTypeBin) != 0))
+    {
+        const xmlSecByte* data = xmlSecBufferGetData(inputBuffer);
+        xmlSecSize dataSize = xmlSecBufferGetSize(inputBuffer);
+        xmlSecSize chunkSize;
+        int final;
+
+        xmlSecAssert2(ctx->binaryChunkSize > 0, -1);
+        do {
+            chunkSize = (dataSize < ctx->binaryChunkSize) ? dataSize : ctx->binaryChunkSize;
+            final = (chunkSize == dataSize) ? 1 : 0;
+            ret = xmlSecTransformPushBin(uriTransform->next, data, chunkSize, final, ctx);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecTransformPushBin",
+                                    xmlSecTransformGetName(uriTransform->next),
+                                    "size=" XMLSEC_SIZE_FMT, chunkSize);
+                return(-1);
+            }
+            data += chunkSize;
+            dataSize -= chunkSize;
+        } while(final == 0);
+    } else {
+        ret = xmlSecTransformPump(uriTransform, uriTransform->next, ctx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformPump",
+                                xmlSecTransformGetName(uriTransform));
+            return(-1);
+        }
     }
 
     /* Close to free up file handle */
@@ -1060,6 +1383,7 @@ xmlSecTransformCtxXmlExecute(xmlSecTransformCtxPtr ctx, xmlSecNodeSetPtr nodes)
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->result == NULL, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
     xmlSecAssert2(nodes != NULL, -1);
@@ -1099,6 +1423,7 @@ xmlSecTransformCtxExecute(xmlSecTransformCtxPtr ctx, xmlDocPtr doc) {
     int ret;
 
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(ctx) != 0, -1);
     xmlSecAssert2(ctx->result == NULL, -1);
     xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, -1);
     xmlSecAssert2(doc != NULL, -1);
@@ -1173,6 +1498,17 @@ xmlSecTransformCtxDebugDump(xmlSecTransformCtxPtr ctx, FILE* output) {
             (ctx->xptrExpr != NULL) ? ctx->xptrExpr : BAD_CAST "NULL");
     for(transform = ctx->first; transform != NULL; transform = transform->next) {
         xmlSecTransformDebugDump(transform, output);
+        if((ctx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+            xmlSecTransformStatsDebugDump(xmlSecTransformGetStats(transform), output);
+        }
+    }
+    if((ctx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+        xmlSecTransformStats stats;
+
+        if(xmlSecTransformCtxGetStats(ctx, &stats) == 0) {
+            fprintf(output, "=== total:\n");
+            xmlSecTransformStatsDebugDump(&stats, output);
+        }
     }
 }
 
@@ -1214,10 +1550,172 @@ xmlSecTransformCtxDebugXmlDump(xmlSecTransformCtxPtr ctx, FILE* output) {
 
     for(transform = ctx->first; transform != NULL; transform = transform->next) {
         xmlSecTransformDebugXmlDump(transform, output);
+        if((ctx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+            xmlSecTransformStatsDebugXmlDump(xmlSecTransformGetStats(transform), output);
+        }
+    }
+    if((ctx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+        xmlSecTransformStats stats;
+
+        if(xmlSecTransformCtxGetStats(ctx, &stats) == 0) {
+            fprintf(output, "<TotalStats>\n");
+            xmlSecTransformStatsDebugXmlDump(&stats, output);
+            fprintf(output, "</TotalStats>\n");
+        }
     }
     fprintf(output, "</TransformCtx>\n");
 }
 
+/**************************************************************************
+ *
+ * xmlSecTransformStats
+ *
+ *************************************************************************/
+/**
+ * xmlSecTransformCtxGetStats:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @stats:              the pointer to the result statistics.
+ *
+ * Gets the statistics for the whole transforms chain: the time, the number
+ * of XML calls and the buffers high-water marks are summed up (maximums
+ * for the buffers) for all the transforms in the chain; the input bytes
+ * and chunks are taken from the first transform; the output bytes and
+ * chunks are taken from the result buffer or the last transform. The
+ * statistics are collected only if the #XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS
+ * flag is set and are available until the @ctx is reset.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformCtxGetStats(xmlSecTransformCtxPtr ctx, xmlSecTransformStatsPtr stats) {
+    xmlSecTransformPtr transform;
+    xmlSecTransformStatsPtr transformStats;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(stats != NULL, -1);
+
+    memset(stats, 0, sizeof(xmlSecTransformStats));
+    for(transform = ctx->first; transform != NULL; transform = transform->next) {
+        transformStats = xmlSecTransformGetStats(transform);
+        stats->time += transformStats->time;
+        stats->xmlCalls += transformStats->xmlCalls;
+        if(stats->inBufMaxSize < transformStats->inBufMaxSize) {
+            stats->inBufMaxSize = transformStats->inBufMaxSize;
+        }
+        if(stats->outBufMaxSize < transformStats->outBufMaxSize) {
+            stats->outBufMaxSize = transformStats->outBufMaxSize;
+        }
+    }
+    if(ctx->first != NULL) {
+        stats->bytesIn  = xmlSecTransformGetStats(ctx->first)->bytesIn;
+        stats->chunksIn = xmlSecTransformGetStats(ctx->first)->chunksIn;
+    }
+    if(ctx->result != NULL) {
+        stats->bytesOut  = xmlSecBufferGetSize(ctx->result);
+        stats->chunksOut = (stats->bytesOut > 0) ? 1 : 0;
+    } else if(ctx->last != NULL) {
+        stats->bytesOut  = xmlSecTransformGetStats(ctx->last)->bytesOut;
+        stats->chunksOut = xmlSecTransformGetStats(ctx->last)->chunksOut;
+    }
+    return(0);
+}
+
+/**
+ * xmlSecTransformStatsDebugDump:
+ * @stats:              the pointer to transform statistics.
+ * @output:             the pointer to output FILE.
+ *
+ * Prints transform statistics to @output.
+ */
+void
+xmlSecTransformStatsDebugDump(xmlSecTransformStatsPtr stats, FILE* output) {
+    xmlSecAssert(stats != NULL);
+    xmlSecAssert(output != NULL);
+
+    fprintf(output, "==== time: %.6f sec\n", stats->time);
+    fprintf(output, "==== in: " XMLSEC_SIZE_FMT " bytes in " XMLSEC_SIZE_FMT " chunks\n",
+        stats->bytesIn, stats->chunksIn);
+    fprintf(output, "==== out: " XMLSEC_SIZE_FMT " bytes in " XMLSEC_SIZE_FMT " chunks\n",
+        stats->bytesOut, stats->chunksOut);
+    fprintf(output, "==== xml calls: " XMLSEC_SIZE_FMT "\n", stats->xmlCalls);
+    fprintf(output, "==== buffers high-water marks: in=" XMLSEC_SIZE_FMT ", out=" XMLSEC_SIZE_FMT "\n",
+        stats->inBufMaxSize, stats->outBufMaxSize);
+}
+
+/**
+ * xmlSecTransformStatsDebugXmlDump:
+ * @stats:              the pointer to transform statistics.
+ * @output:             the pointer to output FILE.
+ *
+ * Prints transform statistics to @output in XML format.
+ */
+void
+xmlSecTransformStatsDebugXmlDump(xmlSecTransformStatsPtr stats, FILE* output) {
+    xmlSecAssert(stats != NULL);
+    xmlSecAssert(output != NULL);
+
+    fprintf(output, "<Stats time=\"%.6f\" bytesIn=\"" XMLSEC_SIZE_FMT "\" chunksIn=\"" XMLSEC_SIZE_FMT "\"",
+        stats->time, stats->bytesIn, stats->chunksIn);
+    fprintf(output, " bytesOut=\"" XMLSEC_SIZE_FMT "\" chunksOut=\"" XMLSEC_SIZE_FMT "\"",
+        stats->bytesOut, stats->chunksOut);
+    fprintf(output, " xmlCalls=\"" XMLSEC_SIZE_FMT "\" inBufMaxSize=\"" XMLSEC_SIZE_FMT "\" outBufMaxSize=\"" XMLSEC_SIZE_FMT "\" />\n",
+        stats->xmlCalls, stats->inBufMaxSize, stats->outBufMaxSize);
+}
+
+/**
+ * xmlSecTransformGetStats:
+ * @transform:          the pointer to transform.
+ *
+ * Gets the @transform statistics collected with the
+ * #XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS flag.
+ *
+ * Returns: the pointer to the @transform statistics.
+ */
+xmlSecTransformStatsPtr
+xmlSecTransformGetStats(xmlSecTransformPtr transform) {
+    xmlSecAssert2(transform != NULL, NULL);
+    xmlSecAssert2(transform->reserved0 != NULL, NULL);
+
+    return(&(xmlSecTransformGetPrivate(transform)->stats));
+}
+
+/* the transform's time excludes the time spent in the transforms it calls */
+static void
+xmlSecTransformStatsStart(xmlSecTransformPtr transform, xmlSecTransformCtxPtr transformCtx,
+                          xmlSecTransformPtr* caller, double* start) {
+    xmlSecTransformCtxPrivatePtr priv;
+
+    priv = xmlSecTransformCtxGetPrivate(transformCtx, 1);
+    (*caller) = (priv != NULL) ? priv->statsCurrent : NULL;
+    xmlSecTransformCtxSetStatsCurrent(transformCtx, transform);
+    (*start) = xmlSecTimerGetTime();
+}
+
+static void
+xmlSecTransformStatsEnd(xmlSecTransformPtr transform, xmlSecTransformCtxPtr transformCtx,
+                        xmlSecTransformPtr caller, double start) {
+    xmlSecTransformStatsPtr stats;
+    double elapsed;
+    xmlSecSize size;
+
+    stats = xmlSecTransformGetStats(transform);
+    elapsed = xmlSecTimerGetTime() - start;
+    stats->time += elapsed;
+    if((caller != NULL) && (caller != transform)) {
+        xmlSecTransformGetStats(caller)->time -= elapsed;
+    }
+    xmlSecTransformCtxSetStatsCurrent(transformCtx, caller);
+
+    size = xmlSecBufferGetMaxSize(&(transform->inBuf));
+    if(stats->inBufMaxSize < size) {
+        stats->inBufMaxSize = size;
+    }
+    size = xmlSecBufferGetMaxSize(&(transform->outBuf));
+    if(stats->outBufMaxSize < size) {
+        stats->outBufMaxSize = size;
+    }
+}
+
 /**************************************************************************
  *
  * xmlSecTransform
@@ -1234,7 +1732,26 @@ xmlSecTransformCtxDebugXmlDump(xmlSecTransformCtxPtr ctx, FILE* output) {
  */
 xmlSecTransformPtr
 xmlSecTransformCreate(xmlSecTransformId id) {
+    return(xmlSecTransformCreateInArena(id, NULL));
+}
+
+/**
+ * xmlSecTransformCreateInArena:
+ * @id:                 the transform id to create.
+ * @arena:              the arena to allocate the transform from or NULL.
+ *
+ * Creates new transform of the @id klass allocated from the @arena
+ * (see #xmlSecTransformCreate if @arena is NULL). The transform still
+ * must be destroyed using #xmlSecTransformDestroy function (to release
+ * the transform resources) before the @arena is reset or destroyed.
+ *
+ * Returns: pointer to newly created transform or NULL if an error occurs.
+ */
+xmlSecTransformPtr
+xmlSecTransformCreateInArena(xmlSecTransformId id, xmlSecArenaPtr arena) {
     xmlSecTransformPtr transform;
+    xmlSecTransformPrivatePtr priv;
+    xmlSecSize size;
     int ret;
 
     xmlSecAssert2(id != NULL, NULL);
@@ -1243,13 +1760,21 @@ xmlSecTransformCreate(xmlSecTransformId id) {
     xmlSecAssert2(id->name != NULL, NULL);
 
     /* Allocate a new xmlSecTransform and fill the fields. */
-    transform = (xmlSecTransformPtr)xmlMalloc(id->objSize);
+    size = xmlSecTransformAllocSize(id);
+    if(arena != NULL) {
+        transform = (xmlSecTransformPtr)xmlSecArenaMalloc(arena, size);
+    } else {
+        transform = (xmlSecTransformPtr)xmlSecMalloc(size, xmlSecAllocatorObjectTypeTransform);
+    }
     if(transform == NULL) {
-        xmlSecMallocError(id->objSize, NULL);
+        xmlSecMallocError(size, NULL);
         return(NULL);
     }
-    memset(transform, 0, id->objSize);
+    memset(transform, 0, size);
+    priv = (xmlSecTransformPrivatePtr)(((xmlSecByte*)transform) + xmlSecTransformPrivateOffset(id));
+    priv->arena = arena;
     transform->id = id;
+    transform->reserved0 = priv;
 
     if(id->initialize != NULL) {
         ret = (id->initialize)(transform);
@@ -1288,6 +1813,10 @@ xmlSecTransformCreate(xmlSecTransformId id) {
  */
 void
 xmlSecTransformDestroy(xmlSecTransformPtr transform) {
+    xmlSecTransformPrivatePtr priv;
+    xmlSecArenaPtr arena;
+    xmlSecSize size;
+
     xmlSecAssert(xmlSecTransformIsValid(transform));
     xmlSecAssert(transform->id->objSize > 0);
 
@@ -1307,8 +1836,16 @@ xmlSecTransformDestroy(xmlSecTransformPtr transform) {
     if(transform->id->finalize != NULL) {
         (transform->id->finalize)(transform);
     }
-    memset(transform, 0, transform->id->objSize);
-    xmlFree(transform);
+    priv = xmlSecTransformGetPrivate(transform);
+    xmlSecAssert(priv != NULL);
+    size = xmlSecTransformAllocSize(transform->id);
+    arena = priv->arena;
+    memset(transform, 0, size);
+
+    /* the arena memory is released with the arena */
+    if(arena == NULL) {
+        xmlSecFree(transform, size, xmlSecAllocatorObjectTypeTransform);
+    }
 }
 
 /**
@@ -1364,7 +1901,7 @@ xmlSecTransformNodeRead(xmlNodePtr node, xmlSecTransformUsage usage, xmlSecTrans
         return(NULL);
     }
 
-    transform = xmlSecTransformCreate(id);
+    transform = xmlSecTransformCreateInArena(id, xmlSecTransformCtxGetArena(transformCtx));
     if(!xmlSecTransformIsValid(transform)) {
         xmlSecInternalError("xmlSecTransformCreate(id)",
                             xmlSecTransformKlassGetName(id));
@@ -1623,11 +2160,32 @@ xmlSecTransformGetDataType(xmlSecTransformPtr transform, xmlSecTransformMode mod
 int
 xmlSecTransformPushBin(xmlSecTransformPtr transform, const xmlSecByte* data,
                     xmlSecSize dataSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPtr caller;
+    double start;
+    int ret;
+
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(transform->id->pushBin != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
-    return((transform->id->pushBin)(transform, data, dataSize, final, transformCtx));
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) == 0) {
+        return((transform->id->pushBin)(transform, data, dataSize, final, transformCtx));
+    }
+
+    xmlSecTransformStatsStart(transform, transformCtx, &caller, &start);
+    ret = (transform->id->pushBin)(transform, data, dataSize, final, transformCtx);
+    xmlSecTransformStatsEnd(transform, transformCtx, caller, start);
+
+    /* count the data only if they were processed */
+    if((ret >= 0) && (dataSize > 0)) {
+        xmlSecTransformGetStats(transform)->bytesIn += dataSize;
+        ++xmlSecTransformGetStats(transform)->chunksIn;
+        if((caller != NULL) && (caller != transform)) {
+            xmlSecTransformGetStats(caller)->bytesOut += dataSize;
+            ++xmlSecTransformGetStats(caller)->chunksOut;
+        }
+    }
+    return(ret);
 }
 
 /**
@@ -1647,13 +2205,33 @@ xmlSecTransformPushBin(xmlSecTransformPtr transform, const xmlSecByte* data,
 int
 xmlSecTransformPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
                     xmlSecSize maxDataSize, xmlSecSize* dataSize, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPtr caller;
+    double start;
+    int ret;
+
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(transform->id->popBin != NULL, -1);
     xmlSecAssert2(data != NULL, -1);
     xmlSecAssert2(dataSize != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
-    return((transform->id->popBin)(transform, data, maxDataSize, dataSize, transformCtx));
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) == 0) {
+        return((transform->id->popBin)(transform, data, maxDataSize, dataSize, transformCtx));
+    }
+
+    xmlSecTransformStatsStart(transform, transformCtx, &caller, &start);
+    ret = (transform->id->popBin)(transform, data, maxDataSize, dataSize, transformCtx);
+    xmlSecTransformStatsEnd(transform, transformCtx, caller, start);
+
+    if((ret >= 0) && ((*dataSize) > 0)) {
+        xmlSecTransformGetStats(transform)->bytesOut += (*dataSize);
+        ++xmlSecTransformGetStats(transform)->chunksOut;
+        if((caller != NULL) && (caller != transform)) {
+            xmlSecTransformGetStats(caller)->bytesIn += (*dataSize);
+            ++xmlSecTransformGetStats(caller)->chunksIn;
+        }
+    }
+    return(ret);
 }
 
 /**
@@ -1669,11 +2247,24 @@ xmlSecTransformPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
 int
 xmlSecTransformPushXml(xmlSecTransformPtr transform, xmlSecNodeSetPtr nodes,
                     xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPtr caller;
+    double start;
+    int ret;
+
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(transform->id->pushXml != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
-    return((transform->id->pushXml)(transform, nodes, transformCtx));
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) == 0) {
+        return((transform->id->pushXml)(transform, nodes, transformCtx));
+    }
+
+    xmlSecTransformStatsStart(transform, transformCtx, &caller, &start);
+    ret = (transform->id->pushXml)(transform, nodes, transformCtx);
+    xmlSecTransformStatsEnd(transform, transformCtx, caller, start);
+
+    ++xmlSecTransformGetStats(transform)->xmlCalls;
+    return(ret);
 }
 
 /**
@@ -1690,11 +2281,101 @@ xmlSecTransformPushXml(xmlSecTransformPtr transform, xmlSecNodeSetPtr nodes,
 int
 xmlSecTransformPopXml(xmlSecTransformPtr transform, xmlSecNodeSetPtr* nodes,
                     xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPtr caller;
+    double start;
+    int ret;
+
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(transform->id->popXml != NULL, -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
-    return((transform->id->popXml)(transform, nodes, transformCtx));
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) == 0) {
+        return((transform->id->popXml)(transform, nodes, transformCtx));
+    }
+
+    xmlSecTransformStatsStart(transform, transformCtx, &caller, &start);
+    ret = (transform->id->popXml)(transform, nodes, transformCtx);
+    xmlSecTransformStatsEnd(transform, transformCtx, caller, start);
+
+    ++xmlSecTransformGetStats(transform)->xmlCalls;
+    return(ret);
+}
+
+/**
+ * xmlSecTransformExecuteBatch:
+ * @transforms:         the transforms of the same klass.
+ * @transformsSize:     the number of transforms in @transforms.
+ * @transformCtx:       the transform's chain processing context.
+ *
+ * Finishes the transforms left with the whole input in the input buffer
+ * because of the #XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE flag: calls
+ * the registered batch execution method for all of them at once if
+ * available or processes them one by one otherwise. The results are not pushed
+ * to the next transforms.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformExecuteBatch(xmlSecTransformPtr* transforms, xmlSecSize transformsSize,
+                            xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformExecuteBatchMethod executeBatch;
+    xmlSecTransformId id;
+    xmlSecBufferPtr in;
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(transforms != NULL, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    if(transformsSize == 0) {
+        return(0);
+    }
+    xmlSecAssert2(xmlSecTransformIsValid(transforms[0]), -1);
+
+    id = transforms[0]->id;
+    for(ii = 0; ii < transformsSize; ++ii) {
+        xmlSecAssert2(xmlSecTransformCheckId(transforms[ii], id), -1);
+        xmlSecAssert2(transforms[ii]->status == xmlSecTransformStatusNone, -1);
+    }
+
+    executeBatch = xmlSecTransformExecuteBatchFind(id);
+    if(executeBatch != NULL) {
+        ret = executeBatch(transforms, transformsSize, transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError2("executeBatch", xmlSecTransformKlassGetName(id),
+                "size=" XMLSEC_SIZE_FMT, transformsSize);
+            return(-1);
+        }
+    } else {
+        for(ii = 0; ii < transformsSize; ++ii) {
+            in = &(transforms[ii]->inBuf);
+            if(id->executeOnce != NULL) {
+                ret = (id->executeOnce)(transforms[ii], xmlSecBufferGetData(in),
+                    xmlSecBufferGetSize(in), transformCtx);
+                if(ret < 0) {
+                    xmlSecInternalError("executeOnce", xmlSecTransformKlassGetName(id));
+                    return(-1);
+                }
+                ret = xmlSecBufferSetSize(in, 0);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecBufferSetSize", xmlSecTransformKlassGetName(id));
+                    return(-1);
+                }
+            } else {
+                ret = xmlSecTransformExecute(transforms[ii], 1, transformCtx);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecTransformExecute", xmlSecTransformKlassGetName(id));
+                    return(-1);
+                }
+            }
+        }
+    }
+
+    for(ii = 0; ii < transformsSize; ++ii) {
+        xmlSecAssert2(transforms[ii]->status == xmlSecTransformStatusFinished, -1);
+        xmlSecAssert2(xmlSecBufferGetSize(&(transforms[ii]->inBuf)) == 0, -1);
+    }
+    return(0);
 }
 
 /**
@@ -1915,6 +2596,56 @@ xmlSecTransformDefaultGetDataType(xmlSecTransformPtr transform, xmlSecTransformM
     return(type);
 }
 
+static int
+xmlSecTransformDefaultExecuteOnce(xmlSecTransformPtr transform, const xmlSecByte* data,
+                        xmlSecSize dataSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecBufferPtr in;
+    int deferred;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
+    xmlSecAssert2(transform->id->executeOnce != NULL, -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusNone, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    /* keep the data until we get the last chunk (or until the batch is executed) */
+    in = &(transform->inBuf);
+    deferred = (((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE) != 0) &&
+                (xmlSecTransformExecuteBatchFind(transform->id) != NULL)) ? 1 : 0;
+    if((final == 0) || (deferred != 0) || (xmlSecBufferGetSize(in) > 0)) {
+        if(dataSize > 0) {
+            xmlSecAssert2(data != NULL, -1);
+
+            ret = xmlSecBufferAppend(in, data, dataSize);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(transform),
+                    "size=" XMLSEC_SIZE_FMT, dataSize);
+                return(-1);
+            }
+        }
+        if((final == 0) || (deferred != 0)) {
+            return(0);
+        }
+        data = xmlSecBufferGetData(in);
+        dataSize = xmlSecBufferGetSize(in);
+    }
+
+    ret = (transform->id->executeOnce)(transform, data, dataSize, transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError2("executeOnce", xmlSecTransformGetName(transform),
+            "size=" XMLSEC_SIZE_FMT, dataSize);
+        return(-1);
+    }
+    xmlSecAssert2(transform->status == xmlSecTransformStatusFinished, -1);
+
+    ret = xmlSecBufferSetSize(in, 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferSetSize", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    return(0);
+}
+
 /**
  * xmlSecTransformDefaultPushBin:
  * @transform:          the pointer to transform object.
@@ -1925,7 +2656,10 @@ xmlSecTransformDefaultGetDataType(xmlSecTransformPtr transform, xmlSecTransformM
  * @transformCtx:       the pointer to transform context object.
  *
  * Process binary @data by calling transform's execute method and pushes
- * results to next transform.
+ * results to next transform. If the transform has the executeOnce method
+ * then the inputs that fit in one binary chunk are collected and processed
+ * in one call (or left for #xmlSecTransformExecuteBatch if the
+ * #XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE flag is set).
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
@@ -1940,6 +2674,24 @@ xmlSecTransformDefaultPushBin(xmlSecTransformPtr transform, const xmlSecByte* da
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
+    /* collect small inputs and process them in one call */
+    if((transform->id->executeOnce != NULL) && (transform->status == xmlSecTransformStatusNone) &&
+       (xmlSecBufferGetSize(&(transform->inBuf)) + dataSize <= transformCtx->binaryChunkSize)) {
+        ret = xmlSecTransformDefaultExecuteOnce(transform, data, dataSize, final, transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformDefaultExecuteOnce", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+        if((final == 0) || (transform->status != xmlSecTransformStatusFinished)) {
+            /* more data to come or waiting for xmlSecTransformExecuteBatch() */
+            return(0);
+        }
+
+        /* push the result to the next transform below */
+        data = NULL;
+        dataSize = 0;
+    }
+
     do {
         /* append data to input buffer */
         if(dataSize > 0) {
@@ -2514,7 +3266,7 @@ xmlSecTransformIOBufferCreate(xmlSecTransformIOBufferMode mode, xmlSecTransformP
     xmlSecAssert2(xmlSecTransformIsValid(transform), NULL);
     xmlSecAssert2(transformCtx != NULL, NULL);
 
-    buffer = (xmlSecTransformIOBufferPtr)xmlMalloc(sizeof(xmlSecTransformIOBuffer));
+    buffer = (xmlSecTransformIOBufferPtr)xmlSecMalloc(sizeof(xmlSecTransformIOBuffer), xmlSecAllocatorObjectTypeTransform);
     if(buffer == NULL) {
         xmlSecMallocError(sizeof(xmlSecTransformIOBuffer), NULL);
         return(NULL);
@@ -2533,7 +3285,7 @@ xmlSecTransformIOBufferDestroy(xmlSecTransformIOBufferPtr buffer) {
     xmlSecAssert(buffer != NULL);
 
     memset(buffer, 0, sizeof(xmlSecTransformIOBuffer));
-    xmlFree(buffer);
+    xmlSecFree(buffer, sizeof(xmlSecTransformIOBuffer), xmlSecAllocatorObjectTypeTransform);
 }
 
 static int
@@ -2607,6 +3359,331 @@ xmlSecTransformIOBufferClose(xmlSecTransformIOBufferPtr buffer) {
 }
 
 
+/************************************************************************
+ *
+ * Pipeline output buffer: the data written to the buffer are collected
+ * in blocks and pushed to the transform in a separate thread. The blocks
+ * go around in two queues: the filled blocks from the writer to the
+ * pipeline thread and the empty blocks back to the writer.
+ *
+ ************************************************************************/
+#define XMLSEC_TRANSFORM_PIPELINE_BLOCKS_NUM            8
+#define XMLSEC_TRANSFORM_PIPELINE_MIN_BLOCK_SIZE        (64*1024)
+
+typedef struct _xmlSecTransformPipeline                 xmlSecTransformPipeline,
+                                                        *xmlSecTransformPipelinePtr;
+
+struct _xmlSecTransformPipeline {
+    xmlSecTransformPtr                  transform;
+    xmlSecTransformCtxPtr               transformCtx;
+    xmlSecBuffer                        blocks[XMLSEC_TRANSFORM_PIPELINE_BLOCKS_NUM];
+    xmlSecSize                          blockSize;
+    xmlSecBufferPtr                     current;
+    xmlSecThreadQueuePtr                filled;
+    xmlSecThreadQueuePtr                empty;
+    xmlSecThreadPtr                     thread;
+    volatile int                        failed;
+};
+
+static xmlSecTransformPipelinePtr xmlSecTransformPipelineCreate (xmlSecTransformPtr transform,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+static void     xmlSecTransformPipelineDestroy                  (xmlSecTransformPipelinePtr pipeline);
+static void     xmlSecTransformPipelineMain                     (void* data);
+static int      xmlSecTransformPipelineWrite                    (xmlSecTransformPipelinePtr pipeline,
+                                                                 const xmlSecByte *buf,
+                                                                 int len);
+static int      xmlSecTransformPipelineClose                    (xmlSecTransformPipelinePtr pipeline);
+
+/**
+ * xmlSecTransformCreatePipelineOutputBuffer:
+ * @transform:          the pointer to transform.
+ * @transformCtx:       the pointer to transform context object.
+ *
+ * Creates output buffer to write data to @transform running in a separate
+ * thread: @transform and the transforms after it process the data while
+ * the caller produces the next blocks. Closing the buffer waits for the
+ * thread and returns an error if any of the transforms failed. Until the
+ * buffer is closed @transform, the transforms after it and @transformCtx
+ * belong to the pipeline thread: the caller must not use or change them
+ * (the @transformCtx functions assert on it). Falls back to
+ * #xmlSecTransformCreateOutputBuffer if threads support is disabled or
+ * the transforms statistics are collected.
+ *
+ * Returns: pointer to new output buffer or NULL if an error occurs.
+ */
+xmlOutputBufferPtr
+xmlSecTransformCreatePipelineOutputBuffer(xmlSecTransformPtr transform, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPipelinePtr pipeline;
+    xmlSecTransformDataType type;
+    xmlOutputBufferPtr output;
+
+    xmlSecAssert2(xmlSecTransformIsValid(transform), NULL);
+    xmlSecAssert2(transformCtx != NULL, NULL);
+    xmlSecAssert2(xmlSecTransformCtxIsOwned(transformCtx) != 0, NULL);
+
+    /* the statistics are collected in the context without locks */
+    if((xmlSecThreadsEnabled() == 0) || ((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0)) {
+        return(xmlSecTransformCreateOutputBuffer(transform, transformCtx));
+    }
+
+    /* check that we have binary push method for this transform */
+    type = xmlSecTransformDefaultGetDataType(transform, xmlSecTransformModePush, transformCtx);
+    if((type & xmlSecTransformDataTypeBin) == 0) {
+        xmlSecInvalidTransfromError2(transform,
+            "push binary data not supported, type=\"" XMLSEC_ENUM_FMT "\"",
+            XMLSEC_ENUM_CAST(type));
+        return(NULL);
+    }
+
+    pipeline = xmlSecTransformPipelineCreate(transform, transformCtx);
+    if(pipeline == NULL) {
+        xmlSecInternalError("xmlSecTransformPipelineCreate",
+                            xmlSecTransformGetName(transform));
+        return(NULL);
+    }
+
+    output = xmlOutputBufferCreateIO((xmlOutputWriteCallback)xmlSecTransformPipelineWrite,
+                                     (xmlOutputCloseCallback)xmlSecTransformPipelineClose,
+                                     pipeline,
+                                     NULL);
+    if(output == NULL) {
+        xmlSecXmlError("xmlOutputBufferCreateIO", xmlSecTransformGetName(transform));
+        /* stop the pipeline thread without finishing the transform */
+        xmlSecAtomicIntIncrement(&(pipeline->failed));
+        (void)xmlSecTransformPipelineClose(pipeline);
+        return(NULL);
+    }
+
+    return(output);
+}
+
+static xmlSecTransformPipelinePtr
+xmlSecTransformPipelineCreate(xmlSecTransformPtr transform, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPipelinePtr pipeline;
+    xmlSecTransformCtxPrivatePtr priv;
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformIsValid(transform), NULL);
+    xmlSecAssert2(transformCtx != NULL, NULL);
+
+    pipeline = (xmlSecTransformPipelinePtr)xmlSecMalloc(sizeof(xmlSecTransformPipeline), xmlSecAllocatorObjectTypeTransform);
+    if(pipeline == NULL) {
+        xmlSecMallocError(sizeof(xmlSecTransformPipeline), NULL);
+        return(NULL);
+    }
+    memset(pipeline, 0, sizeof(xmlSecTransformPipeline));
+
+    pipeline->transform = transform;
+    pipeline->transformCtx = transformCtx;
+    pipeline->blockSize = transformCtx->binaryChunkSize;
+    if(pipeline->blockSize < XMLSEC_TRANSFORM_PIPELINE_MIN_BLOCK_SIZE) {
+        pipeline->blockSize = XMLSEC_TRANSFORM_PIPELINE_MIN_BLOCK_SIZE;
+    }
+
+    pipeline->filled = xmlSecThreadQueueCreate(XMLSEC_TRANSFORM_PIPELINE_BLOCKS_NUM);
+    if(pipeline->filled == NULL) {
+        xmlSecInternalError("xmlSecThreadQueueCreate", NULL);
+        xmlSecTransformPipelineDestroy(pipeline);
+        return(NULL);
+    }
+    pipeline->empty = xmlSecThreadQueueCreate(XMLSEC_TRANSFORM_PIPELINE_BLOCKS_NUM);
+    if(pipeline->empty == NULL) {
+        xmlSecInternalError("xmlSecThreadQueueCreate", NULL);
+        xmlSecTransformPipelineDestroy(pipeline);
+        return(NULL);
+    }
+
+    for(ii = 0; ii < XMLSEC_TRANSFORM_PIPELINE_BLOCKS_NUM; ++ii) {
+        ret = xmlSecBufferInitialize(&(pipeline->blocks[ii]), pipeline->blockSize);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferInitialize", NULL,
+                "size=" XMLSEC_SIZE_FMT, pipeline->blockSize);
+            xmlSecTransformPipelineDestroy(pipeline);
+            return(NULL);
+        }
+        ret = xmlSecThreadQueuePush(pipeline->empty, &(pipeline->blocks[ii]));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecThreadQueuePush", NULL);
+            xmlSecTransformPipelineDestroy(pipeline);
+            return(NULL);
+        }
+    }
+
+    /* hand off the transforms to the pipeline thread until the buffer is closed */
+    priv = xmlSecTransformCtxGetPrivate(transformCtx, 1);
+    if(priv == NULL) {
+        xmlSecInternalError("xmlSecTransformCtxGetPrivate", NULL);
+        xmlSecTransformPipelineDestroy(pipeline);
+        return(NULL);
+    }
+    priv->pipelined = 1;
+
+    pipeline->thread = xmlSecThreadCreate(xmlSecTransformPipelineMain, pipeline);
+    if(pipeline->thread == NULL) {
+        xmlSecInternalError("xmlSecThreadCreate", NULL);
+        priv->pipelined = 0;
+        xmlSecTransformPipelineDestroy(pipeline);
+        return(NULL);
+    }
+
+    return(pipeline);
+}
+
+static void
+xmlSecTransformPipelineDestroy(xmlSecTransformPipelinePtr pipeline) {
+    xmlSecSize ii;
+
+    xmlSecAssert(pipeline != NULL);
+    xmlSecAssert(pipeline->thread == NULL);
+
+    for(ii = 0; ii < XMLSEC_TRANSFORM_PIPELINE_BLOCKS_NUM; ++ii) {
+        xmlSecBufferFinalize(&(pipeline->blocks[ii]));
+    }
+    if(pipeline->filled != NULL) {
+        xmlSecThreadQueueDestroy(pipeline->filled);
+    }
+    if(pipeline->empty != NULL) {
+        xmlSecThreadQueueDestroy(pipeline->empty);
+    }
+    memset(pipeline, 0, sizeof(xmlSecTransformPipeline));
+    xmlSecFree(pipeline, sizeof(xmlSecTransformPipeline), xmlSecAllocatorObjectTypeTransform);
+}
+
+/* the pipeline thread: pushes the filled blocks to the transform until the
+ * writer closes the queue, after an error it only returns the blocks */
+static void
+xmlSecTransformPipelineMain(void* data) {
+    xmlSecTransformPipelinePtr pipeline = (xmlSecTransformPipelinePtr)data;
+    xmlSecBufferPtr block;
+    int ret;
+
+    xmlSecAssert(pipeline != NULL);
+    xmlSecAssert(pipeline->filled != NULL);
+    xmlSecAssert(pipeline->empty != NULL);
+
+    while((block = (xmlSecBufferPtr)xmlSecThreadQueuePop(pipeline->filled)) != NULL) {
+        if(xmlSecAtomicIntGet(&(pipeline->failed)) == 0) {
+            ret = xmlSecTransformPushBin(pipeline->transform, xmlSecBufferGetData(block),
+                xmlSecBufferGetSize(block), 0, pipeline->transformCtx);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecTransformPushBin",
+                                    xmlSecTransformGetName(pipeline->transform));
+                xmlSecAtomicIntIncrement(&(pipeline->failed));
+                /* wake up the writer waiting for an empty block */
+                xmlSecThreadQueueClose(pipeline->empty);
+            }
+        }
+        xmlSecBufferEmpty(block);
+        (void)xmlSecThreadQueuePush(pipeline->empty, block);
+    }
+
+    if(xmlSecAtomicIntGet(&(pipeline->failed)) == 0) {
+        ret = xmlSecTransformPushBin(pipeline->transform, NULL, 0, 1, pipeline->transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformPushBin",
+                                xmlSecTransformGetName(pipeline->transform));
+            xmlSecAtomicIntIncrement(&(pipeline->failed));
+        }
+    }
+}
+
+static int
+xmlSecTransformPipelineWrite(xmlSecTransformPipelinePtr pipeline,
+                             const xmlSecByte *buf, int len) {
+    xmlSecSize size, avail;
+    int ret;
+
+    xmlSecAssert2(pipeline != NULL, -1);
+    xmlSecAssert2(pipeline->thread != NULL, -1);
+    xmlSecAssert2(buf != NULL, -1);
+    xmlSecAssert2(len >= 0, -1);
+
+    if(xmlSecAtomicIntGet(&(pipeline->failed)) != 0) {
+        return(-1);
+    }
+
+    XMLSEC_SAFE_CAST_INT_TO_SIZE(len, size, return(-1), xmlSecTransformGetName(pipeline->transform));
+    while(size > 0) {
+        if(pipeline->current == NULL) {
+            pipeline->current = (xmlSecBufferPtr)xmlSecThreadQueuePop(pipeline->empty);
+            if(pipeline->current == NULL) {
+                xmlSecInternalError("xmlSecThreadQueuePop",
+                                    xmlSecTransformGetName(pipeline->transform));
+                return(-1);
+            }
+        }
+
+        avail = pipeline->blockSize - xmlSecBufferGetSize(pipeline->current);
+        if(avail > size) {
+            avail = size;
+        }
+        ret = xmlSecBufferAppend(pipeline->current, buf, avail);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(pipeline->transform),
+                "size=" XMLSEC_SIZE_FMT, avail);
+            return(-1);
+        }
+        buf += avail;
+        size -= avail;
+
+        if(xmlSecBufferGetSize(pipeline->current) >= pipeline->blockSize) {
+            ret = xmlSecThreadQueuePush(pipeline->filled, pipeline->current);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecThreadQueuePush",
+                                    xmlSecTransformGetName(pipeline->transform));
+                return(-1);
+            }
+            pipeline->current = NULL;
+        }
+    }
+    return(len);
+}
+
+static int
+xmlSecTransformPipelineClose(xmlSecTransformPipelinePtr pipeline) {
+    xmlSecTransformCtxPrivatePtr priv;
+    int res = 0;
+    int ret;
+
+    xmlSecAssert2(pipeline != NULL, -1);
+    xmlSecAssert2(pipeline->filled != NULL, -1);
+
+    /* send the last block and wait for the pipeline thread */
+    if((pipeline->current != NULL) && (xmlSecBufferGetSize(pipeline->current) > 0)) {
+        ret = xmlSecThreadQueuePush(pipeline->filled, pipeline->current);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecThreadQueuePush",
+                                xmlSecTransformGetName(pipeline->transform));
+            res = -1;
+        }
+    }
+    pipeline->current = NULL;
+    xmlSecThreadQueueClose(pipeline->filled);
+
+    if(pipeline->thread != NULL) {
+        ret = xmlSecThreadJoin(pipeline->thread);
+        pipeline->thread = NULL;
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecThreadJoin",
+                                xmlSecTransformGetName(pipeline->transform));
+            res = -1;
+        }
+
+        /* the pipeline thread is done, the transforms are back to the caller */
+        priv = xmlSecTransformCtxGetPrivate(pipeline->transformCtx, 0);
+        if(priv != NULL) {
+            priv->pipelined = 0;
+        }
+    }
+    if(xmlSecAtomicIntGet(&(pipeline->failed)) != 0) {
+        res = -1;
+    }
+
+    xmlSecTransformPipelineDestroy(pipeline);
+    return(res);
+}
+
 /*********************************************************************
  *
  * Helper transform functions
@@ -2919,6 +3996,7 @@ xmlSecTransformKeyAgreementReadKey(xmlSecKeyDataType keyType, xmlNodePtr node,
     xmlSecKeysMngrPtr keysMngr;
     xmlSecKeyPtr key = NULL;
     xmlSecKeyPtr res = NULL;
+    xmlSecTraceSpan span;
     int ret;
 
     xmlSecAssert2(node != NULL, NULL);
@@ -2950,7 +4028,9 @@ xmlSecTransformKeyAgreementReadKey(xmlSecKeyDataType keyType, xmlNodePtr node,
     }
     keyInfoCtx.keyReq.keyType = keyType;
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeKeyLookup, &keyInfoCtx, NULL, NULL);
     key = (keysMngr->getKey)(node, &keyInfoCtx);
+    XMLSEC_TRACE_SPAN_END_KEY_LOOKUP(&span, key);
     if(key == NULL) {
         xmlSecOtherError(XMLSEC_ERRORS_R_KEY_NOT_FOUND, xmlSecNodeGetName(node), "key not found");
         goto done;
@@ -25,26 +25,41 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xmlIO.h>
+#ifdef LIBXML_READER_ENABLED
+#include <libxml/xmlreader.h>
+#endif /* LIBXML_READER_ENABLED */
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/buffer.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/keys.h>
 #include <xmlsec/keysmngr.h>
 #include <xmlsec/transforms.h>
 #include <xmlsec/membuf.h>
+#include <xmlsec/parser.h>
+#include <xmlsec/io.h>
 #include <xmlsec/xmldsig.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/private.h>
 
 #include "cast_helpers.h"
+#include "trace_helpers.h"
+#include "transform_helpers.h"
 
 /**************************************************************************
  *
  * xmlSecDSigCtx
  *
  *************************************************************************/
+/* the document read by xmlTextReader, see xmlSecDSigCtxSignReader() and xmlSecDSigCtxVerifyReader() */
+typedef struct _xmlSecDSigStream                        xmlSecDSigStream,
+                                                        *xmlSecDSigStreamPtr;
+
 static int      xmlSecDSigCtxProcessSignatureNode       (xmlSecDSigCtxPtr dsigCtx,
-                                                         xmlNodePtr node);
+                                                         xmlNodePtr node,
+                                                         xmlSecDSigStreamPtr stream);
 static int      xmlSecDSigCtxProcessSignedInfoNode      (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlNodePtr node,
                                                          xmlNodePtr * firstReferenceNode);
@@ -56,16 +71,97 @@ static int      xmlSecDSigCtxProcessManifestNode        (xmlSecDSigCtxPtr dsigCt
                                                          xmlNodePtr node);
 
 static int      xmlSecDSigCtxProcessReferences          (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr firstReferenceNode,
+                                                         xmlSecDSigStreamPtr stream);
+static int      xmlSecDSigCtxVerifyBatchedReferences    (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlNodePtr firstReferenceNode);
+static int      xmlSecDSigCtxPrefetchUris               (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr node);
+static int      xmlSecDSigCtxExecuteSignedInfo          (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr signedInfoNode);
+static int      xmlSecDSigCtxSetSignatureValue          (xmlSecDSigCtxPtr dsigCtx);
+
+static int      xmlSecDSigReferenceCtxProcess           (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr node,
+                                                         xmlSecDSigStreamPtr stream);
+static int      xmlSecDSigReferenceCtxCompleteDigest    (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr digestValueNode);
+static int      xmlSecDSigStreamAddReference            (xmlSecDSigStreamPtr stream,
+                                                         xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr digestValueNode);
+static int      xmlSecDSigStreamRun                     (xmlSecDSigStreamPtr stream);
 
 
 static void     xmlSecDSigCtxMarkAsSucceeded            (xmlSecDSigCtxPtr dsigCtx);
 static void     xmlSecDSigCtxMarkAsFailed               (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlSecDSigFailureReason failureReason);
+static xmlSecSize xmlSecDSigCtxGetTraceSize             (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlSecTraceSpanPtr span);
+
+/* the initial size of the canonicalized SignedInfo buffer */
+#define XMLSEC_DSIG_SIGNEDINFO_BUFFER_SIZE      1024
+
+/* the references window for the batched digests (the max number of digests
+ * calculated in one xmlSecTransformExecuteBatch() call) */
+#define XMLSEC_DSIG_BATCH_DIGESTS_SIZE          64
+
+/* the canonical data size pushed to the digest in one call while streaming */
+#define XMLSEC_DSIG_STREAM_BUFFER_SIZE          16384
 
 /* The ID attribute in XMLDSig is 'Id' */
 static const xmlChar*           xmlSecDSigIds[] = { xmlSecAttrId, NULL };
 
+/* the private data that doesn't fit in the public xmlSecDSigCtx
+ * layout, it is created on demand and stored in dsigCtx->reserved0 */
+typedef struct _xmlSecDSigCtxPrivate            xmlSecDSigCtxPrivate,
+                                                *xmlSecDSigCtxPrivatePtr;
+struct _xmlSecDSigCtxPrivate {
+    xmlSecIOPrefetchPtr                         prefetch;
+    xmlSecArenaPtr                              arena;
+    xmlDocPtr                                   signatureDoc;   /* see xmlSecDSigCtxVerifyReader() */
+};
+
+static xmlSecDSigCtxPrivatePtr
+xmlSecDSigCtxGetPrivate(xmlSecDSigCtxPtr dsigCtx, int create) {
+    xmlSecDSigCtxPrivatePtr priv;
+
+    xmlSecAssert2(dsigCtx != NULL, NULL);
+
+    priv = (xmlSecDSigCtxPrivatePtr)dsigCtx->reserved0;
+    if((priv != NULL) || (create == 0)) {
+        return(priv);
+    }
+
+    priv = (xmlSecDSigCtxPrivatePtr)xmlSecMalloc(sizeof(xmlSecDSigCtxPrivate), xmlSecAllocatorObjectTypeCtx);
+    if(priv == NULL) {
+        xmlSecMallocError(sizeof(xmlSecDSigCtxPrivate), NULL);
+        return(NULL);
+    }
+    memset(priv, 0, sizeof(xmlSecDSigCtxPrivate));
+    dsigCtx->reserved0 = priv;
+    return(priv);
+}
+
+static xmlSecIOPrefetchPtr
+xmlSecDSigCtxGetPrefetch(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecDSigCtxPrivatePtr priv;
+
+    xmlSecAssert2(dsigCtx != NULL, NULL);
+
+    priv = xmlSecDSigCtxGetPrivate(dsigCtx, 0);
+    return((priv != NULL) ? priv->prefetch : NULL);
+}
+
+static xmlSecArenaPtr
+xmlSecDSigCtxGetArena(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecDSigCtxPrivatePtr priv;
+
+    xmlSecAssert2(dsigCtx != NULL, NULL);
+
+    priv = xmlSecDSigCtxGetPrivate(dsigCtx, 0);
+    return((priv != NULL) ? priv->arena : NULL);
+}
+
 /**
  * xmlSecDSigCtxCreate:
  * @keysMngr:           the pointer to keys manager.
@@ -82,7 +178,7 @@ xmlSecDSigCtxCreate(xmlSecKeysMngrPtr keysMngr) {
     xmlSecDSigCtxPtr dsigCtx;
     int ret;
 
-    dsigCtx = (xmlSecDSigCtxPtr) xmlMalloc(sizeof(xmlSecDSigCtx));
+    dsigCtx = (xmlSecDSigCtxPtr) xmlSecMalloc(sizeof(xmlSecDSigCtx), xmlSecAllocatorObjectTypeCtx);
     if(dsigCtx == NULL) {
         xmlSecMallocError(sizeof(xmlSecDSigCtx), NULL);
         return(NULL);
@@ -108,7 +204,7 @@ xmlSecDSigCtxDestroy(xmlSecDSigCtxPtr dsigCtx) {
     xmlSecAssert(dsigCtx != NULL);
 
     xmlSecDSigCtxFinalize(dsigCtx);
-    xmlFree(dsigCtx);
+    xmlSecFree(dsigCtx, sizeof(xmlSecDSigCtx), xmlSecAllocatorObjectTypeCtx);
 }
 
 /**
@@ -180,8 +276,12 @@ xmlSecDSigCtxInitialize(xmlSecDSigCtxPtr dsigCtx, xmlSecKeysMngrPtr keysMngr) {
  */
 void
 xmlSecDSigCtxFinalize(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecDSigCtxPrivatePtr priv;
+
     xmlSecAssert(dsigCtx != NULL);
 
+    xmlSecDSigCtxReset(dsigCtx);
+
     xmlSecTransformCtxFinalize(&(dsigCtx->transformCtx));
     xmlSecKeyInfoCtxFinalize(&(dsigCtx->keyInfoReadCtx));
     xmlSecKeyInfoCtxFinalize(&(dsigCtx->keyInfoWriteCtx));
@@ -191,13 +291,70 @@ xmlSecDSigCtxFinalize(xmlSecDSigCtxPtr dsigCtx) {
     if(dsigCtx->enabledReferenceTransforms != NULL) {
         xmlSecPtrListDestroy(dsigCtx->enabledReferenceTransforms);
     }
+
+    /* MUST be the last one: the objects above might be allocated from the arena */
+    priv = xmlSecDSigCtxGetPrivate(dsigCtx, 0);
+    if(priv != NULL) {
+        if(priv->arena != NULL) {
+            xmlSecArenaDestroy(priv->arena);
+        }
+        xmlSecFree(priv, sizeof(xmlSecDSigCtxPrivate), xmlSecAllocatorObjectTypeCtx);
+    }
+    memset(dsigCtx, 0, sizeof(xmlSecDSigCtx));
+}
+
+/**
+ * xmlSecDSigCtxReset:
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ *
+ * Resets @dsigCtx object for the next operation, user settings are not touched.
+ */
+void
+xmlSecDSigCtxReset(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecDSigCtxPrivatePtr priv;
+
+    xmlSecAssert(dsigCtx != NULL);
+
+    xmlSecTransformCtxReset(&(dsigCtx->transformCtx));
+    xmlSecKeyInfoCtxReset(&(dsigCtx->keyInfoReadCtx));
+    xmlSecKeyInfoCtxReset(&(dsigCtx->keyInfoWriteCtx));
+    xmlSecPtrListEmpty(&(dsigCtx->signedInfoReferences));
+    xmlSecPtrListEmpty(&(dsigCtx->manifestReferences));
+
+    dsigCtx->operation           = xmlSecTransformOperationNone;
+    dsigCtx->result              = NULL;
+    dsigCtx->status              = xmlSecDSigStatusUnknown;
+    dsigCtx->failureReason       = xmlSecDSigFailureReasonUnknown;
+    dsigCtx->signMethod          = NULL;
+    dsigCtx->c14nMethod          = NULL;
+    dsigCtx->preSignMemBufMethod = NULL;
+    dsigCtx->signValueNode       = NULL;
+
     if(dsigCtx->signKey != NULL) {
         xmlSecKeyDestroy(dsigCtx->signKey);
+        dsigCtx->signKey = NULL;
     }
     if(dsigCtx->id != NULL) {
         xmlFree(dsigCtx->id);
+        dsigCtx->id = NULL;
+    }
+
+    priv = xmlSecDSigCtxGetPrivate(dsigCtx, 0);
+    if(priv != NULL) {
+        if(priv->signatureDoc != NULL) {
+            xmlFreeDoc(priv->signatureDoc);
+            priv->signatureDoc = NULL;
+        }
+        if(priv->prefetch != NULL) {
+            xmlSecIOPrefetchDestroy(priv->prefetch);
+            priv->prefetch = NULL;
+        }
+
+        /* MUST be the last one: the objects above might be allocated from the arena */
+        if(priv->arena != NULL) {
+            xmlSecArenaReset(priv->arena);
+        }
     }
-    memset(dsigCtx, 0, sizeof(xmlSecDSigCtx));
 }
 
 /**
@@ -280,9 +437,8 @@ xmlSecDSigCtxGetPreSignBuffer(xmlSecDSigCtxPtr dsigCtx) {
  */
 int
 xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
-    xmlSecByte* outBuf;
-    xmlSecSize outSize;
-    int outLen;
+    xmlSecTraceSpan span;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(dsigCtx != NULL, -1);
@@ -290,24 +446,310 @@ xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
     xmlSecAssert2(tmpl != NULL, -1);
     xmlSecAssert2(tmpl->doc != NULL, -1);
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeDSigSign, dsigCtx, NULL, &(dsigCtx->transformCtx));
+
     /* add ids for Signature nodes */
     dsigCtx->operation  = xmlSecTransformOperationSign;
     dsigCtx->status     = xmlSecDSigStatusUnknown;
     xmlSecAddIDs(tmpl->doc, tmpl, xmlSecDSigIds);
 
     /* read signature template */
-    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, tmpl);
+    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, tmpl, NULL);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessSignatureNode", NULL);
+        goto done;
+    }
+    if((dsigCtx->signMethod == NULL) || (dsigCtx->signValueNode == NULL)) {
+        xmlSecInvalidDataError("the signature method or value is not found", NULL);
+        goto done;
+    }
+
+    /* references processing might change the status */
+    if(dsigCtx->status != xmlSecDSigStatusUnknown) {
+        res = 0;
+        goto done;
+    }
+
+    /* write signed data to xml */
+    ret = xmlSecDSigCtxSetSignatureValue(dsigCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigCtxSetSignatureValue", NULL);
+        goto done;
+    }
+
+    /* set success status and we are done */
+    xmlSecDSigCtxMarkAsSucceeded(dsigCtx);
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecDSigCtxGetTraceSize(dsigCtx, &span), res);
+    return(res);
+}
+
+#ifdef LIBXML_READER_ENABLED
+/* the reference digested while the document is read */
+typedef struct _xmlSecDSigStreamReference {
+    xmlSecDSigReferenceCtxPtr       dsigRefCtx;
+    xmlNodePtr                      digestValueNode;
+    xmlSecTransformPtr              c14n;
+    xmlSecTransformC14NStreamPtr    c14nStream;
+    xmlSecBuffer                    buffer;
+    const xmlChar*                  id;         /* the referenced element id or NULL for the whole document */
+    int                             enveloped;
+    int                             depth;      /* the referenced element depth or -1 if not found yet */
+    int                             finished;
+} xmlSecDSigStreamReference, *xmlSecDSigStreamReferencePtr;
+
+struct _xmlSecDSigStream {
+    xmlTextReaderPtr            reader;
+    xmlSecPtrList               references;
+
+    /* signature */
+    xmlOutputBufferPtr          output;
+    xmlSecBuffer                tail;       /* the canonical document after the signature */
+    int                         afterSignature;
+
+    /* verification: the canonical document before the signature is replayed
+     * once the references are known */
+    xmlSecTransformPtr          spoolC14N;
+    xmlSecTransformC14NStreamPtr spoolStream;
+    xmlSecBuffer                spool;
+    FILE*                       spoolFile;
+    int                         spoolMarkers;
+    xmlTextReaderPtr            replay;
+};
+
+static int      xmlSecDSigStreamInitialize              (xmlSecDSigStreamPtr stream,
+                                                         xmlTextReaderPtr reader,
+                                                         xmlOutputBufferPtr output);
+static void     xmlSecDSigStreamFinalize                (xmlSecDSigStreamPtr stream);
+static xmlNodePtr xmlSecDSigStreamReadSignature         (xmlSecDSigStreamPtr stream,
+                                                         xmlDocPtr* signatureDoc);
+
+/**
+ * xmlSecDSigCtxSignReader:
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @tmpl:               the pointer to &lt;dsig:Signature/&gt; template, the root
+ *                      element of its own document.
+ * @reader:             the reader for the document to sign.
+ * @output:             the output buffer (without encoder) for the signed document.
+ *
+ * Signs the document read by @reader in one pass without building the
+ * document tree: the document is canonicalized and digested as the reader
+ * returns the nodes and written to @output, the &lt;dsig:Signature/&gt;
+ * element is inserted before the document element end tag. The output
+ * is the canonical form (UTF-8, no XML declaration and DTD) of the document.
+ *
+ * Only the enveloped signature is supported: @tmpl should have exactly
+ * one &lt;dsig:Reference/&gt; with empty URI and the enveloped signature
+ * transform followed by one of the C14N transforms (without comments),
+ * the &lt;dsig:SignedInfo/&gt; canonicalization method should be the
+ * exclusive C14N without the inclusive namespaces prefix list. The other
+ * templates require the document tree, use #xmlSecDSigCtxSign.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxSignReader(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl, xmlTextReaderPtr reader,
+                        xmlOutputBufferPtr output) {
+    xmlSecDSigStream stream;
+    xmlSecTraceSpan span;
+    xmlSecSize tailSize;
+    int tailLen;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(tmpl->doc != NULL, -1);
+    xmlSecAssert2(reader != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    /* the template is written as is and can't inherit anything */
+    if(xmlDocGetRootElement(tmpl->doc) != tmpl) {
+        xmlSecInvalidDataError("the signature template is not the document root element", NULL);
+        return(-1);
+    }
+
+    ret = xmlSecDSigStreamInitialize(&stream, reader, output);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigStreamInitialize", NULL);
         return(-1);
     }
-    xmlSecAssert2(dsigCtx->signMethod != NULL, -1);
-    xmlSecAssert2(dsigCtx->signValueNode != NULL, -1);
+
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeDSigSign, dsigCtx, NULL, &(dsigCtx->transformCtx));
+
+    /* add ids for Signature nodes */
+    dsigCtx->operation  = xmlSecTransformOperationSign;
+    dsigCtx->status     = xmlSecDSigStatusUnknown;
+    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecDSigIds);
+
+    /* read signature template and the document */
+    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, tmpl, &stream);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigCtxProcessSignatureNode", NULL);
+        goto done;
+    }
+    if((dsigCtx->signMethod == NULL) || (dsigCtx->signValueNode == NULL)) {
+        xmlSecInvalidDataError("the signature method or value is not found", NULL);
+        goto done;
+    }
 
     /* references processing might change the status */
     if(dsigCtx->status != xmlSecDSigStatusUnknown) {
-        return(0);
+        res = 0;
+        goto done;
+    }
+
+    ret = xmlSecDSigCtxSetSignatureValue(dsigCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigCtxSetSignatureValue", NULL);
+        goto done;
+    }
+
+    /* write the signature and the rest of the document */
+    xmlNodeDumpOutput(output, tmpl->doc, tmpl, 0, 0, NULL);
+    tailSize = xmlSecBufferGetSize(&(stream.tail));
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(tailSize, tailLen, goto done, NULL);
+    if(tailLen > 0) {
+        ret = xmlOutputBufferWrite(output, tailLen, (const char*)xmlSecBufferGetData(&(stream.tail)));
+        if(ret < 0) {
+            xmlSecXmlError("xmlOutputBufferWrite", NULL);
+            goto done;
+        }
+    }
+    ret = xmlOutputBufferFlush(output);
+    if((ret < 0) || (output->error != 0)) {
+        xmlSecXmlError("xmlOutputBufferFlush", NULL);
+        goto done;
+    }
+
+    /* set success status and we are done */
+    xmlSecDSigCtxMarkAsSucceeded(dsigCtx);
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecDSigCtxGetTraceSize(dsigCtx, &span), res);
+    xmlSecDSigStreamFinalize(&stream);
+    return(res);
+}
+
+/**
+ * xmlSecDSigCtxVerifyReader:
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @reader:             the reader for the signed document.
+ *
+ * Validates the first &lt;dsig:Signature/&gt; element in the document read
+ * by @reader in one pass without building the document tree: only the
+ * signature element (with its ancestors) is copied to a document owned
+ * by @dsigCtx (until #xmlSecDSigCtxReset), the same-document
+ * references are canonicalized and digested as the reader returns the
+ * nodes. The document before the signature is kept in the canonical form
+ * (in a temporary file if it is large) until the references are known.
+ * The verification result is returned in #status member of the @dsigCtx
+ * object.
+ *
+ * The references should have empty URI or the "#id" URI to an element with
+ * "Id", "ID", "id" or "xml:id" attribute, the enveloped signature transform
+ * and one of the C14N transforms (without comments) followed by the binary
+ * transforms. The XPath, XPointer or XSLT transforms require the document
+ * tree and fail with XMLSEC_ERRORS_R_NOT_IMPLEMENTED error, use
+ * #xmlSecDSigCtxVerify. The references to the signature elements
+ * and the external URIs are processed as usual, the &lt;dsig:Manifest/&gt;
+ * references can't point to the document outside of the signature.
+ *
+ * Returns: 0 on success (check #status member of @dsigCtx to get
+ * signature verification result) or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxVerifyReader(xmlSecDSigCtxPtr dsigCtx, xmlTextReaderPtr reader) {
+    xmlSecDSigCtxPrivatePtr priv;
+    xmlSecDSigStream stream;
+    xmlSecTraceSpan span;
+    xmlNodePtr node;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(reader != NULL, -1);
+
+    priv = xmlSecDSigCtxGetPrivate(dsigCtx, 1);
+    if(priv == NULL) {
+        xmlSecInternalError("xmlSecDSigCtxGetPrivate", NULL);
+        return(-1);
+    }
+    xmlSecAssert2(priv->signatureDoc == NULL, -1);
+
+    ret = xmlSecDSigStreamInitialize(&stream, reader, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigStreamInitialize", NULL);
+        return(-1);
+    }
+
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeDSigVerify, dsigCtx, NULL, &(dsigCtx->transformCtx));
+
+    /* find the signature */
+    node = xmlSecDSigStreamReadSignature(&stream, &(priv->signatureDoc));
+    if(node == NULL) {
+        xmlSecInternalError("xmlSecDSigStreamReadSignature", NULL);
+        goto done;
+    }
+
+    /* add ids for Signature nodes */
+    dsigCtx->operation  = xmlSecTransformOperationVerify;
+    dsigCtx->status     = xmlSecDSigStatusUnknown;
+    xmlSecAddIDs(node->doc, node, xmlSecDSigIds);
+
+    /* read signature info and the rest of the document */
+    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, node, &stream);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigCtxProcessSignatureNode", NULL);
+        goto done;
+    }
+    if((dsigCtx->signMethod == NULL) || (dsigCtx->signValueNode == NULL)) {
+        xmlSecInvalidDataError("the signature method or value is not found", NULL);
+        goto done;
+    }
+
+    /* references processing might change the status */
+    if(dsigCtx->status != xmlSecDSigStatusUnknown) {
+        res = 0;
+        goto done;
+    }
+
+    /* verify SignatureValue node content */
+    ret = xmlSecTransformVerifyNodeContent(dsigCtx->signMethod, dsigCtx->signValueNode,
+                                           &(dsigCtx->transformCtx));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformVerifyNodeContent", NULL);
+        goto done;
+    }
+
+    /* set status and we are done */
+    if(dsigCtx->signMethod->status == xmlSecTransformStatusOk) {
+        xmlSecDSigCtxMarkAsSucceeded(dsigCtx);
+    } else {
+        xmlSecDSigCtxMarkAsFailed(dsigCtx, xmlSecDSigFailureReasonSignature);
     }
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecDSigCtxGetTraceSize(dsigCtx, &span), res);
+    xmlSecDSigStreamFinalize(&stream);
+    return(res);
+}
+#endif /* LIBXML_READER_ENABLED */
+
+/* writes the signature transforms result to the SignatureValue node */
+static int
+xmlSecDSigCtxSetSignatureValue(xmlSecDSigCtxPtr dsigCtx) {
+    xmlSecByte* outBuf;
+    xmlSecSize outSize;
+    int outLen;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigCtx->signValueNode != NULL, -1);
 
     /* check what we've got */
     dsigCtx->result = dsigCtx->transformCtx.result;
@@ -316,14 +758,10 @@ xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
         return(-1);
     }
 
-    /* write signed data to xml */
     outBuf = xmlSecBufferGetData(dsigCtx->result);
     outSize = xmlSecBufferGetSize(dsigCtx->result);
     XMLSEC_SAFE_CAST_SIZE_TO_INT(outSize, outLen, return(-1), NULL);
     xmlNodeSetContentLen(dsigCtx->signValueNode, outBuf, outLen);
-
-    /* set success status and we are done */
-    xmlSecDSigCtxMarkAsSucceeded(dsigCtx);
     return(0);
 }
 
@@ -340,29 +778,36 @@ xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
  */
 int
 xmlSecDSigCtxVerify(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
+    xmlSecTraceSpan span;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(dsigCtx != NULL, -1);
     xmlSecAssert2(node != NULL, -1);
     xmlSecAssert2(node->doc != NULL, -1);
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeDSigVerify, dsigCtx, NULL, &(dsigCtx->transformCtx));
+
     /* add ids for Signature nodes */
     dsigCtx->operation  = xmlSecTransformOperationVerify;
     dsigCtx->status     = xmlSecDSigStatusUnknown;
     xmlSecAddIDs(node->doc, node, xmlSecDSigIds);
 
     /* read signature info */
-    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, node);
+    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, node, NULL);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessSignatureNode", NULL);
-        return(-1);
+        goto done;
+    }
+    if((dsigCtx->signMethod == NULL) || (dsigCtx->signValueNode == NULL)) {
+        xmlSecInvalidDataError("the signature method or value is not found", NULL);
+        goto done;
     }
-    xmlSecAssert2(dsigCtx->signMethod != NULL, -1);
-    xmlSecAssert2(dsigCtx->signValueNode != NULL, -1);
 
     /* references processing might change the status */
     if(dsigCtx->status != xmlSecDSigStatusUnknown) {
-        return(0);
+        res = 0;
+        goto done;
     }
 
     /* verify SignatureValue node content */
@@ -370,7 +815,7 @@ xmlSecDSigCtxVerify(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
                                            &(dsigCtx->transformCtx));
     if(ret < 0) {
         xmlSecInternalError("xmlSecTransformVerifyNodeContent", NULL);
-        return(-1);
+        goto done;
     }
 
     /* set status and we are done */
@@ -379,7 +824,36 @@ xmlSecDSigCtxVerify(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     } else {
         xmlSecDSigCtxMarkAsFailed(dsigCtx, xmlSecDSigFailureReasonSignature);
     }
-    return(0);
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecDSigCtxGetTraceSize(dsigCtx, &span), res);
+    return(res);
+}
+
+/* sums up the bytes digested for SignedInfo and all the SignedInfo references */
+static xmlSecSize
+xmlSecDSigCtxGetTraceSize(xmlSecDSigCtxPtr dsigCtx, xmlSecTraceSpanPtr span) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecSize res = 0;
+    xmlSecSize ii, size;
+
+    xmlSecAssert2(dsigCtx != NULL, 0);
+    xmlSecAssert2(span != NULL, 0);
+
+    if(dsigCtx->signMethod != NULL) {
+        span->href = dsigCtx->signMethod->id->href;
+        res += xmlSecTransformGetStats(dsigCtx->signMethod)->bytesIn;
+    }
+
+    size = xmlSecPtrListGetSize(&(dsigCtx->signedInfoReferences));
+    for(ii = 0; ii < size; ++ii) {
+        dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->signedInfoReferences), ii);
+        if((dsigRefCtx != NULL) && (dsigRefCtx->digestMethod != NULL)) {
+            res += xmlSecTransformGetStats(dsigRefCtx->digestMethod)->bytesIn;
+        }
+    }
+    return(res);
 }
 
 static void
@@ -451,7 +925,7 @@ xmlSecDSigCtxMarkAsFailed(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigFailureReason fail
  *
  */
 static int
-xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
+xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xmlSecDSigStreamPtr stream) {
     xmlSecTransformDataType firstType;
     xmlNodePtr signedInfoNode = NULL;
     xmlNodePtr keyInfoNode = NULL;
@@ -476,6 +950,42 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     xmlSecAssert2(dsigCtx->id == NULL, -1);
     dsigCtx->id = xmlGetProp(node, xmlSecAttrId);
 
+    if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_COLLECT_TRANSFORM_STATS) != 0) {
+        dsigCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS;
+    }
+
+    /* allocate the per-operation objects from the arena */
+    if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_USE_ARENA) != 0) {
+        xmlSecDSigCtxPrivatePtr priv;
+
+        priv = xmlSecDSigCtxGetPrivate(dsigCtx, 1);
+        if(priv == NULL) {
+            xmlSecInternalError("xmlSecDSigCtxGetPrivate", NULL);
+            return(-1);
+        }
+        if(priv->arena == NULL) {
+            priv->arena = xmlSecArenaCreate(0);
+            if(priv->arena == NULL) {
+                xmlSecInternalError("xmlSecArenaCreate", NULL);
+                return(-1);
+            }
+        }
+    }
+    ret = xmlSecTransformCtxSetArena(&(dsigCtx->transformCtx), xmlSecDSigCtxGetArena(dsigCtx));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxSetArena", NULL);
+        return(-1);
+    }
+
+    /* read all the external URIs before processing references */
+    if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_PREFETCH_URIS) != 0) {
+        ret = xmlSecDSigCtxPrefetchUris(dsigCtx, node);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigCtxPrefetchUris", NULL);
+            return(-1);
+        }
+    }
+
     /* first node is required SignedInfo */
     cur = xmlSecGetNextElementNode(node->children);
     if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeSignedInfo, xmlSecDSigNs))) {
@@ -531,6 +1041,19 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     xmlSecAssert2(dsigCtx->signMethod != NULL, -1);
     xmlSecAssert2(dsigCtx->c14nMethod != NULL, -1);
 
+    /* the streamed SignedInfo is canonicalized in the template document:
+     * it must not depend on the ancestors in the signed document */
+    if((stream != NULL) && (dsigCtx->operation == xmlSecTransformOperationSign) &&
+       ((!xmlSecTransformCheckId(dsigCtx->c14nMethod, xmlSecTransformExclC14NId) &&
+         !xmlSecTransformCheckId(dsigCtx->c14nMethod, xmlSecTransformExclC14NWithCommentsId)) ||
+        ((dsigCtx->c14nMethod->hereNode != NULL) &&
+         (xmlSecFindChild(dsigCtx->c14nMethod->hereNode, xmlSecNodeInclusiveNamespaces, xmlSecNsExcC14N) != NULL))))
+    {
+        xmlSecOtherError(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, xmlSecTransformGetName(dsigCtx->c14nMethod),
+            "the streaming signature requires exclusive c14n without inclusive namespaces");
+        return(-1);
+    }
+
     /* now read key info node */
     ret = xmlSecDSigCtxProcessKeyInfoNode(dsigCtx, keyInfoNode);
     if(ret < 0) {
@@ -541,7 +1064,7 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     xmlSecAssert2(dsigCtx->signKey != NULL, -1);
 
     /* now actually process references and calculate digests */
-    ret = xmlSecDSigCtxProcessReferences(dsigCtx, firstReferenceNode);
+    ret = xmlSecDSigCtxProcessReferences(dsigCtx, firstReferenceNode, stream);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessReferences", NULL);
         return(-1);
@@ -572,6 +1095,16 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
         xmlSecNodeSetPtr nodeset = NULL;
 
         xmlSecAssert2(signedInfoNode != NULL, -1);
+
+        /* try the fast path first */
+        ret = xmlSecDSigCtxExecuteSignedInfo(dsigCtx, signedInfoNode);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigCtxExecuteSignedInfo", NULL);
+            return(-1);
+        } else if(ret == 1) {
+            return(0);
+        }
+
         nodeset = xmlSecNodeSetGetChildren(signedInfoNode->doc, signedInfoNode, 1, 0);
         if(nodeset == NULL) {
             xmlSecInternalError("xmlSecNodeSetGetChildren(signedInfoNode)", NULL);
@@ -594,32 +1127,250 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     return(0);
 }
 
-/**
- * xmlSecDSigCtxProcessSignedInfoNode:
- *
- * The SignedInfo Element (http://www.w3.org/TR/xmldsig-core/#sec-SignedInfo)
- *
- * The structure of SignedInfo includes the canonicalization algorithm,
- * a result algorithm, and one or more references. The SignedInfo element
- * may contain an optional ID attribute that will allow it to be referenced by
- * other signatures and objects.
- *
- * SignedInfo does not include explicit result or digest properties (such as
- * calculation time, cryptographic device serial number, etc.). If an
- * application needs to associate properties with the result or digest,
- * it may include such information in a SignatureProperties element within
- * an Object element.
- *
- * Schema Definition:
- *
- *  <element name="SignedInfo" type="ds:SignedInfoType"/>
- *  <complexType name="SignedInfoType">
- *    <sequence>
- *      <element ref="ds:CanonicalizationMethod"/>
- *      <element ref="ds:SignatureMethod"/>
- *      <element ref="ds:Reference" maxOccurs="unbounded"/>
- *    </sequence>
- *    <attribute name="Id" type="ID" use="optional"/>
+/*
+ * SignedInfo is small and the C14N is almost always the only transform
+ * before the signature: canonicalize the SignedInfo subtree directly into
+ * a buffer and push it to the signature transform in one call. Returns 1
+ * if the signature was calculated, 0 if the generic transforms chain
+ * should be used or a negative value if an error occurs.
+ */
+static int
+xmlSecDSigCtxExecuteSignedInfo(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr signedInfoNode) {
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecBuffer buffer;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(signedInfoNode != NULL, -1);
+
+    transformCtx = &(dsigCtx->transformCtx);
+    if((dsigCtx->c14nMethod == NULL) || (transformCtx->first != dsigCtx->c14nMethod) ||
+       (dsigCtx->c14nMethod->next == NULL)) {
+        return(0);
+    }
+
+    ret = xmlSecBufferInitialize(&buffer, XMLSEC_DSIG_SIGNEDINFO_BUFFER_SIZE);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", NULL);
+        return(-1);
+    }
+    ret = xmlSecTransformC14NExecuteSubtree(dsigCtx->c14nMethod, signedInfoNode, &buffer);
+    if(ret != 1) {
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformC14NExecuteSubtree",
+                                xmlSecTransformGetName(dsigCtx->c14nMethod));
+        }
+        xmlSecBufferFinalize(&buffer);
+        return(ret);
+    }
+
+    ret = xmlSecTransformCtxPrepare(transformCtx, xmlSecTransformDataTypeXml);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxPrepare(TypeXml)", NULL);
+        xmlSecBufferFinalize(&buffer);
+        return(-1);
+    }
+
+    /* the pushed data are counted as the c14n transform output */
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+        ++xmlSecTransformGetStats(dsigCtx->c14nMethod)->xmlCalls;
+        xmlSecTransformCtxSetStatsCurrent(transformCtx, dsigCtx->c14nMethod);
+    }
+    ret = xmlSecTransformPushBin(dsigCtx->c14nMethod->next, xmlSecBufferGetData(&buffer),
+                xmlSecBufferGetSize(&buffer), 1, transformCtx);
+    xmlSecTransformCtxSetStatsCurrent(transformCtx, NULL);
+    xmlSecBufferFinalize(&buffer);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformPushBin",
+                            xmlSecTransformGetName(dsigCtx->c14nMethod->next));
+        return(-1);
+    }
+
+    dsigCtx->c14nMethod->status = xmlSecTransformStatusFinished;
+    transformCtx->status = xmlSecTransformStatusFinished;
+    return(1);
+}
+
+/* the application can abort the processing from the references callback,
+ * it has to be done before we start reading the URI */
+static int
+xmlSecDSigCtxPrefetchCheckReference(xmlSecDSigCtxPtr dsigCtx, const xmlChar* uri, xmlNodePtr node) {
+    xmlSecTransformCtx transformCtx;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    if(dsigCtx->referencePreExecuteCallback == NULL) {
+        return(0);
+    }
+
+    ret = xmlSecTransformCtxInitialize(&transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxInitialize", NULL);
+        return(-1);
+    }
+    transformCtx.userData = dsigCtx->userData;
+    transformCtx.enabledUris = dsigCtx->enabledReferenceUris;
+
+    ret = xmlSecTransformCtxSetUri(&transformCtx, uri, node);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecTransformCtxSetUri", NULL,
+                             "uri=%s", xmlSecErrorsSafeString(uri));
+        goto done;
+    }
+
+    ret = (dsigCtx->referencePreExecuteCallback)(&transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError2("referencePreExecuteCallback", NULL,
+                             "uri=%s", xmlSecErrorsSafeString(uri));
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    xmlSecTransformCtxFinalize(&transformCtx);
+    return(res);
+}
+
+static int
+xmlSecDSigCtxPrefetchAddReferences(xmlSecDSigCtxPtr dsigCtx, xmlSecIOPrefetchPtr prefetch, xmlNodePtr node) {
+    xmlNodePtr cur;
+    xmlChar* uri;
+    const xmlChar* xptr;
+    int uriLen;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(prefetch != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    for(cur = xmlSecGetNextElementNode(node->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(!xmlSecCheckNodeName(cur, xmlSecNodeReference, xmlSecDSigNs)) {
+            continue;
+        }
+
+        /* only external URIs allowed for the references */
+        uri = xmlGetProp(cur, xmlSecAttrURI);
+        if((uri == NULL) || (uri[0] == '\0') || (uri[0] == '#') ||
+           (xmlSecTransformUriTypeCheck(dsigCtx->enabledReferenceUris, uri) != 1))
+        {
+            if(uri != NULL) {
+                xmlFree(uri);
+            }
+            continue;
+        }
+
+        ret = xmlSecDSigCtxPrefetchCheckReference(dsigCtx, uri, cur);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigCtxPrefetchCheckReference", NULL);
+            xmlFree(uri);
+            return(-1);
+        }
+
+        /* strip the xpointer part */
+        xptr = xmlStrchr(uri, '#');
+        if(xptr != NULL) {
+            XMLSEC_SAFE_CAST_PTRDIFF_TO_INT((xptr - uri), uriLen, xmlFree(uri); return(-1), NULL);
+            uri[uriLen] = '\0';
+        }
+
+        ret = xmlSecIOPrefetchAdd(prefetch, uri);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecIOPrefetchAdd", NULL,
+                                 "uri=%s", xmlSecErrorsSafeString(uri));
+            xmlFree(uri);
+            return(-1);
+        }
+        xmlFree(uri);
+    }
+    return(0);
+}
+
+static int
+xmlSecDSigCtxPrefetchUris(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
+    xmlSecDSigCtxPrivatePtr priv;
+    xmlNodePtr cur, manifest;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    priv = xmlSecDSigCtxGetPrivate(dsigCtx, 1);
+    if(priv == NULL) {
+        xmlSecInternalError("xmlSecDSigCtxGetPrivate", NULL);
+        return(-1);
+    }
+    if(priv->prefetch == NULL) {
+        priv->prefetch = xmlSecIOPrefetchCreate(0);
+        if(priv->prefetch == NULL) {
+            xmlSecInternalError("xmlSecIOPrefetchCreate", NULL);
+            return(-1);
+        }
+    }
+
+    /* the structure is checked later, just collect all the references */
+    for(cur = xmlSecGetNextElementNode(node->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(xmlSecCheckNodeName(cur, xmlSecNodeSignedInfo, xmlSecDSigNs)) {
+            ret = xmlSecDSigCtxPrefetchAddReferences(dsigCtx, priv->prefetch, cur);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigCtxPrefetchAddReferences(SignedInfo)", NULL);
+                return(-1);
+            }
+        } else if(xmlSecCheckNodeName(cur, xmlSecNodeObject, xmlSecDSigNs) &&
+                 ((dsigCtx->flags & XMLSEC_DSIG_FLAGS_IGNORE_MANIFESTS) == 0))
+        {
+            for(manifest = xmlSecGetNextElementNode(cur->children); manifest != NULL; manifest = xmlSecGetNextElementNode(manifest->next)) {
+                if(!xmlSecCheckNodeName(manifest, xmlSecNodeManifest, xmlSecDSigNs)) {
+                    continue;
+                }
+                ret = xmlSecDSigCtxPrefetchAddReferences(dsigCtx, priv->prefetch, manifest);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecDSigCtxPrefetchAddReferences(Manifest)", NULL);
+                    return(-1);
+                }
+            }
+        }
+    }
+
+    ret = xmlSecIOPrefetchRun(priv->prefetch);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecIOPrefetchRun", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecDSigCtxProcessSignedInfoNode:
+ *
+ * The SignedInfo Element (http://www.w3.org/TR/xmldsig-core/#sec-SignedInfo)
+ *
+ * The structure of SignedInfo includes the canonicalization algorithm,
+ * a result algorithm, and one or more references. The SignedInfo element
+ * may contain an optional ID attribute that will allow it to be referenced by
+ * other signatures and objects.
+ *
+ * SignedInfo does not include explicit result or digest properties (such as
+ * calculation time, cryptographic device serial number, etc.). If an
+ * application needs to associate properties with the result or digest,
+ * it may include such information in a SignatureProperties element within
+ * an Object element.
+ *
+ * Schema Definition:
+ *
+ *  <element name="SignedInfo" type="ds:SignedInfoType"/>
+ *  <complexType name="SignedInfoType">
+ *    <sequence>
+ *      <element ref="ds:CanonicalizationMethod"/>
+ *      <element ref="ds:SignatureMethod"/>
+ *      <element ref="ds:Reference" maxOccurs="unbounded"/>
+ *    </sequence>
+ *    <attribute name="Id" type="ID" use="optional"/>
  *  </complexType>
  *
  * DTD:
@@ -742,8 +1493,9 @@ xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xm
 
 
 static int
-xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferenceNode) {
+xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferenceNode, xmlSecDSigStreamPtr stream) {
     xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecSize batchedRefs = 0;
     xmlNodePtr cur;
     int ret;
 
@@ -753,6 +1505,14 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
     xmlSecAssert2(xmlSecPtrListGetSize(&(dsigCtx->signedInfoReferences)) == 0, -1);
     xmlSecAssert2(firstReferenceNode != NULL, -1);
 
+    /* the signed document is written only once */
+    if((stream != NULL) && (dsigCtx->operation == xmlSecTransformOperationSign) &&
+       (xmlSecGetNextElementNode(firstReferenceNode->next) != NULL)) {
+        xmlSecOtherError(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+            "the streaming signature supports only one reference");
+        return(-1);
+    }
+
     /* process references */
     for(cur = firstReferenceNode; (cur != NULL); cur = xmlSecGetNextElementNode(cur->next)) {
         /* already checked but we trust none */
@@ -777,13 +1537,26 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
         }
 
         /* process */
-        ret = xmlSecDSigReferenceCtxProcessNode(dsigRefCtx, cur);
+        ret = xmlSecDSigReferenceCtxProcess(dsigRefCtx, cur, stream);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecDSigReferenceCtxProcessNode",
+            xmlSecInternalError("xmlSecDSigReferenceCtxProcess",
                                 xmlSecNodeGetName(cur));
             return(-1);
         }
 
+        /* the digest is calculated while reading the document */
+        if((dsigRefCtx->status == xmlSecDSigStatusUnknown) && (stream != NULL) &&
+           (dsigRefCtx->transformCtx.status != xmlSecTransformStatusFinished)) {
+            continue;
+        }
+
+        /* the digest is batched */
+        if((dsigRefCtx->status == xmlSecDSigStatusUnknown) && (dsigRefCtx->digestMethod != NULL) &&
+           (dsigRefCtx->digestMethod->status == xmlSecTransformStatusNone)) {
+            ++batchedRefs;
+            continue;
+        }
+
         /* bail out if next Reference processing failed */
         if(dsigRefCtx->status != xmlSecDSigStatusSucceeded) {
             xmlSecDSigCtxMarkAsFailed(dsigCtx, xmlSecDSigFailureReasonReference);
@@ -791,10 +1564,131 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
         }
     }
 
+    /* read the document */
+    if(stream != NULL) {
+        xmlSecSize ii, size;
+
+        ret = xmlSecDSigStreamRun(stream);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigStreamRun", NULL);
+            return(-1);
+        }
+
+        size = xmlSecPtrListGetSize(&(dsigCtx->signedInfoReferences));
+        for(ii = 0; ii < size; ++ii) {
+            dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->signedInfoReferences), ii);
+            xmlSecAssert2(dsigRefCtx != NULL, -1);
+
+            if(dsigRefCtx->status == xmlSecDSigStatusInvalid) {
+                xmlSecDSigCtxMarkAsFailed(dsigCtx, xmlSecDSigFailureReasonReference);
+                return(0);
+            }
+        }
+    }
+
+    if(batchedRefs > 0) {
+        ret = xmlSecDSigCtxVerifyBatchedReferences(dsigCtx, firstReferenceNode);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigCtxVerifyBatchedReferences", NULL);
+            return(-1);
+        }
+    }
+
     /* done */
     return(0);
 }
 
+/* calculates the batched digests (grouped by the digest method) and checks
+ * them in the references order: the references are processed in windows of
+ * XMLSEC_DSIG_BATCH_DIGESTS_SIZE thus we stop soon after the first invalid one */
+static int
+xmlSecDSigCtxVerifyBatchedReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferenceNode) {
+    xmlSecTransformPtr batch[XMLSEC_DSIG_BATCH_DIGESTS_SIZE];
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecDSigReferenceCtxPtr firstRefCtx;
+    xmlSecSize refsSize, batchSize, start, end, ii;
+    xmlNodePtr cur, digestValueNode;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(firstReferenceNode != NULL, -1);
+
+    refsSize = xmlSecPtrListGetSize(&(dsigCtx->signedInfoReferences));
+    cur = firstReferenceNode;
+    for(start = 0; (start < refsSize) && (cur != NULL); start = end) {
+        end = start + XMLSEC_DSIG_BATCH_DIGESTS_SIZE;
+        if(end > refsSize) {
+            end = refsSize;
+        }
+
+        /* calculate the digests in the window */
+        do {
+            firstRefCtx = NULL;
+            batchSize = 0;
+            for(ii = start; ii < end; ++ii) {
+                dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->signedInfoReferences), ii);
+                xmlSecAssert2(dsigRefCtx != NULL, -1);
+                xmlSecAssert2(dsigRefCtx->digestMethod != NULL, -1);
+
+                if(dsigRefCtx->digestMethod->status != xmlSecTransformStatusNone) {
+                    continue;
+                }
+                if(firstRefCtx == NULL) {
+                    firstRefCtx = dsigRefCtx;
+                } else if(dsigRefCtx->digestMethod->id != firstRefCtx->digestMethod->id) {
+                    continue;
+                }
+                batch[batchSize++] = dsigRefCtx->digestMethod;
+            }
+            if(batchSize == 0) {
+                break;
+            }
+
+            xmlSecAssert2(firstRefCtx != NULL, -1);
+            ret = xmlSecTransformExecuteBatch(batch, batchSize, &(firstRefCtx->transformCtx));
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecTransformExecuteBatch",
+                    xmlSecTransformGetName(firstRefCtx->digestMethod));
+                return(-1);
+            }
+        } while(1);
+
+        /* the references list follows the <dsig:Reference/> nodes */
+        for(ii = start; (ii < end) && (cur != NULL); ++ii, cur = xmlSecGetNextElementNode(cur->next)) {
+            dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->signedInfoReferences), ii);
+            xmlSecAssert2(dsigRefCtx != NULL, -1);
+            xmlSecAssert2(dsigRefCtx->digestMethod != NULL, -1);
+
+            if(dsigRefCtx->status == xmlSecDSigStatusUnknown) {
+                digestValueNode = xmlSecFindChild(cur, xmlSecNodeDigestValue, xmlSecDSigNs);
+                if(digestValueNode == NULL) {
+                    xmlSecNodeNotFoundError("xmlSecFindChild", cur, xmlSecNodeDigestValue, NULL);
+                    return(-1);
+                }
+
+                ret = xmlSecTransformVerifyNodeContent(dsigRefCtx->digestMethod,
+                                    digestValueNode, &(dsigRefCtx->transformCtx));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecTransformVerifyNodeContent", NULL);
+                    return(-1);
+                }
+                if(dsigRefCtx->digestMethod->status == xmlSecTransformStatusOk) {
+                    dsigRefCtx->status = xmlSecDSigStatusSucceeded;
+                } else {
+                    dsigRefCtx->status = xmlSecDSigStatusInvalid;
+                }
+            }
+
+            /* bail out if next Reference processing failed */
+            if(dsigRefCtx->status != xmlSecDSigStatusSucceeded) {
+                xmlSecDSigCtxMarkAsFailed(dsigCtx, xmlSecDSigFailureReasonReference);
+                return(0);
+            }
+        }
+    }
+    return(0);
+}
+
 
 static int
 xmlSecDSigCtxProcessKeyInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
@@ -814,7 +1708,11 @@ xmlSecDSigCtxProcessKeyInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     /* todo: throw an error if key is set and node != NULL? */
     if((dsigCtx->signKey == NULL) && (dsigCtx->keyInfoReadCtx.keysMngr != NULL)
                         && (dsigCtx->keyInfoReadCtx.keysMngr->getKey != NULL)) {
+        xmlSecTraceSpan span;
+
+        XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeKeyLookup, &(dsigCtx->keyInfoReadCtx), NULL, NULL);
         dsigCtx->signKey = (dsigCtx->keyInfoReadCtx.keysMngr->getKey)(node, &(dsigCtx->keyInfoReadCtx));
+        XMLSEC_TRACE_SPAN_END_KEY_LOOKUP(&span, dsigCtx->signKey);
     }
 
     /* check that we have exactly what we want */
@@ -1202,11 +2100,17 @@ xmlSecDSigCtxDebugXmlDump(xmlSecDSigCtxPtr dsigCtx, FILE* output) {
 xmlSecDSigReferenceCtxPtr
 xmlSecDSigReferenceCtxCreate(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigReferenceOrigin origin) {
     xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecArenaPtr arena;
     int ret;
 
     xmlSecAssert2(dsigCtx != NULL, NULL);
 
-    dsigRefCtx = (xmlSecDSigReferenceCtxPtr) xmlMalloc(sizeof(xmlSecDSigReferenceCtx));
+    arena = xmlSecDSigCtxGetArena(dsigCtx);
+    if(arena != NULL) {
+        dsigRefCtx = (xmlSecDSigReferenceCtxPtr) xmlSecArenaMalloc(arena, sizeof(xmlSecDSigReferenceCtx));
+    } else {
+        dsigRefCtx = (xmlSecDSigReferenceCtxPtr) xmlSecMalloc(sizeof(xmlSecDSigReferenceCtx), xmlSecAllocatorObjectTypeCtx);
+    }
     if(dsigRefCtx == NULL) {
         xmlSecMallocError(sizeof(xmlSecDSigReferenceCtx), NULL);
         return(NULL);
@@ -1215,9 +2119,15 @@ xmlSecDSigReferenceCtxCreate(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigReferenceOrigin
     ret = xmlSecDSigReferenceCtxInitialize(dsigRefCtx, dsigCtx, origin);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigReferenceCtxInitialize", NULL);
-        xmlSecDSigReferenceCtxDestroy(dsigRefCtx);
+        xmlSecDSigReferenceCtxFinalize(dsigRefCtx);
+        if(arena == NULL) {
+            xmlSecFree(dsigRefCtx, sizeof(xmlSecDSigReferenceCtx), xmlSecAllocatorObjectTypeCtx);
+        }
         return(NULL);
     }
+
+    /* xmlSecDSigReferenceCtxDestroy() needs to know where the memory is from */
+    dsigRefCtx->reserved0 = arena;
     return(dsigRefCtx);
 }
 
@@ -1229,10 +2139,17 @@ xmlSecDSigReferenceCtxCreate(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigReferenceOrigin
  */
 void
 xmlSecDSigReferenceCtxDestroy(xmlSecDSigReferenceCtxPtr dsigRefCtx) {
+    xmlSecArenaPtr arena;
+
     xmlSecAssert(dsigRefCtx != NULL);
 
+    arena = (xmlSecArenaPtr)dsigRefCtx->reserved0;
     xmlSecDSigReferenceCtxFinalize(dsigRefCtx);
-    xmlFree(dsigRefCtx);
+
+    /* the arena memory is released with the arena */
+    if(arena == NULL) {
+        xmlSecFree(dsigRefCtx, sizeof(xmlSecDSigReferenceCtx), xmlSecAllocatorObjectTypeCtx);
+    }
 }
 
 /**
@@ -1266,6 +2183,11 @@ xmlSecDSigReferenceCtxInitialize(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlSecDSi
         xmlSecInternalError("xmlSecTransformCtxInitialize", NULL);
         return(-1);
     }
+    ret = xmlSecTransformCtxSetArena(&(dsigRefCtx->transformCtx), xmlSecDSigCtxGetArena(dsigCtx));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxSetArena", NULL);
+        return(-1);
+    }
 
     /* copy enabled transforms */
     if(dsigCtx->enabledReferenceTransforms != NULL) {
@@ -1279,10 +2201,27 @@ xmlSecDSigReferenceCtxInitialize(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlSecDSi
     dsigRefCtx->transformCtx.preExecCallback = dsigCtx->referencePreExecuteCallback;
     dsigRefCtx->transformCtx.enabledUris = dsigCtx->enabledReferenceUris;
     dsigRefCtx->transformCtx.userData = dsigCtx->userData;
+    ret = xmlSecTransformCtxSetPrefetch(&(dsigRefCtx->transformCtx), xmlSecDSigCtxGetPrefetch(dsigCtx));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxSetPrefetch", NULL);
+        return(-1);
+    }
 
     if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK) != 0) {
         dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_USE_VISA3D_HACK;
     }
+    if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_COLLECT_TRANSFORM_STATS) != 0) {
+        dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS;
+    }
+    if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_PIPELINE_C14N) != 0) {
+        dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_PIPELINE_C14N;
+    }
+    if(((dsigCtx->flags & XMLSEC_DSIG_FLAGS_BATCH_DIGESTS) != 0) &&
+       (dsigCtx->operation == xmlSecTransformOperationVerify) &&
+       (origin == xmlSecDSigReferenceOriginSignedInfo)) {
+        /* the digests are finished in xmlSecDSigCtxProcessReferences() */
+        dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE;
+    }
     return(0);
 }
 
@@ -1328,6 +2267,25 @@ xmlSecDSigReferenceCtxGetPreDigestBuffer(xmlSecDSigReferenceCtxPtr dsigRefCtx) {
             xmlSecTransformMemBufGetBuffer(dsigRefCtx->preDigestMemBufMethod) : NULL);
 }
 
+/**
+ * xmlSecDSigReferenceCtxGetStats:
+ * @dsigRefCtx:         the pointer to &lt;dsig:Reference/&gt; element processing context.
+ * @stats:              the pointer to the result statistics.
+ *
+ * Gets the &lt;dsig:Reference/&gt; transforms execution statistics including
+ * the digest method (valid only if #XMLSEC_DSIG_FLAGS_COLLECT_TRANSFORM_STATS
+ * flag of signature context is set).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecDSigReferenceCtxGetStats(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlSecTransformStatsPtr stats) {
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(stats != NULL, -1);
+
+    return(xmlSecTransformCtxGetStats(&(dsigRefCtx->transformCtx), stats));
+}
+
 /**
  * xmlSecDSigReferenceCtxProcessNode:
  * @dsigRefCtx:         the pointer to &lt;dsig:Reference/&gt; element processing context.
@@ -1350,9 +2308,16 @@ xmlSecDSigReferenceCtxGetPreDigestBuffer(xmlSecDSigReferenceCtxPtr dsigRefCtx) {
  */
 int
 xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node) {
+    return(xmlSecDSigReferenceCtxProcess(dsigRefCtx, node, NULL));
+}
+
+static int
+xmlSecDSigReferenceCtxProcess(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node, xmlSecDSigStreamPtr stream) {
     xmlSecTransformCtxPtr transformCtx;
     xmlNodePtr digestValueNode;
     xmlNodePtr cur;
+    xmlSecTraceSpan span;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(dsigRefCtx != NULL, -1);
@@ -1370,12 +2335,14 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
     dsigRefCtx->id  = xmlGetProp(node, xmlSecAttrId);
     dsigRefCtx->type= xmlGetProp(node, xmlSecAttrType);
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeDSigReference, dsigRefCtx, dsigRefCtx->uri, transformCtx);
+
     /* set start URI (and check that it is enabled!) */
     ret = xmlSecTransformCtxSetUri(transformCtx, dsigRefCtx->uri, node);
     if(ret < 0) {
         xmlSecInternalError2("xmlSecTransformCtxSetUri", NULL,
                              "uri=%s", xmlSecErrorsSafeString(dsigRefCtx->uri));
-        return(-1);
+        goto done;
     }
 
     /* first is optional Transforms node */
@@ -1386,7 +2353,7 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
         if(ret < 0) {
             xmlSecInternalError2("xmlSecTransformCtxNodesListRead", NULL,
                                  "node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
-            return(-1);
+            goto done;
         }
 
         cur = xmlSecGetNextElementNode(cur->next);
@@ -1398,13 +2365,12 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
        ((dsigRefCtx->origin == xmlSecDSigReferenceOriginManifest) &&
         ((dsigRefCtx->dsigCtx->flags & XMLSEC_DSIG_FLAGS_STORE_MANIFEST_REFERENCES) != 0))) {
 
-        xmlSecAssert2(dsigRefCtx->preDigestMemBufMethod == NULL, -1);
         dsigRefCtx->preDigestMemBufMethod = xmlSecTransformCtxCreateAndAppend(
                                                 transformCtx,
                                                 xmlSecTransformMemBufId);
         if(dsigRefCtx->preDigestMemBufMethod == NULL) {
             xmlSecInternalError("xmlSecTransformCtxCreateAndAppend(xmlSecTransformMemBufId)", NULL);
-            return(-1);
+            goto done;
         }
     }
 
@@ -1415,7 +2381,7 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
         if(dsigRefCtx->digestMethod == NULL) {
             xmlSecInternalError("xmlSecTransformCtxNodeRead",
                                 xmlSecNodeGetName(cur));
-            return(-1);
+            goto done;
         }
 
         cur = xmlSecGetNextElementNode(cur->next);
@@ -1427,14 +2393,14 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
                                                               dsigRefCtx->dsigCtx->defSignMethodId);
         if(dsigRefCtx->digestMethod == NULL) {
             xmlSecInternalError("xmlSecTransformCtxCreateAndAppend", NULL);
-            return(-1);
+            goto done;
         }
     } else {
         /* if digest method is not specified in the template and not specified in
          * the dsig context then it's an error.
          */
         xmlSecInvalidNodeError(cur, xmlSecNodeDigestMethod, NULL);
-        return(-1);
+        goto done;
     }
     dsigRefCtx->digestMethod->operation = dsigRefCtx->dsigCtx->operation;
 
@@ -1444,13 +2410,13 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
         cur = xmlSecGetNextElementNode(cur->next);
     } else {
         xmlSecInvalidNodeError(cur, xmlSecNodeDigestValue, NULL);
-        return(-1);
+        goto done;
     }
 
     /* if we have something else then it's an error */
     if(cur != NULL) {
         xmlSecUnexpectedNodeError(cur,  NULL);
-        return(-1);
+        goto done;
     }
 
     /* if we need to write result to xml node then we need base64 encode result */
@@ -1461,26 +2427,72 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
         base64Encode = xmlSecTransformCtxCreateAndAppend(transformCtx, xmlSecTransformBase64Id);
         if(base64Encode == NULL) {
             xmlSecInternalError("xmlSecTransformCtxCreateAndAppend", NULL);
-            return(-1);
+            goto done;
         }
         base64Encode->operation = xmlSecTransformOperationEncode;
     }
 
     /* finally get transforms results */
+    if(stream != NULL) {
+        ret = xmlSecDSigStreamAddReference(stream, dsigRefCtx, digestValueNode);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigStreamAddReference", NULL);
+            goto done;
+        } else if(ret == 1) {
+            /* the digest is calculated in xmlSecDSigStreamRun() */
+            res = 0;
+            goto done;
+        }
+    }
     ret = xmlSecTransformCtxExecute(transformCtx, node->doc);
     if(ret < 0) {
         xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
-        return(-1);
+        goto done;
+    }
+
+    if((dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationVerify) &&
+       (dsigRefCtx->digestMethod->status == xmlSecTransformStatusNone)) {
+        /* the digest is batched, see xmlSecDSigCtxProcessReferences() */
+        if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE) == 0) {
+            xmlSecInvalidTransfromStatusError(dsigRefCtx->digestMethod);
+            goto done;
+        }
+        dsigRefCtx->result = transformCtx->result;
+    } else {
+        ret = xmlSecDSigReferenceCtxCompleteDigest(dsigRefCtx, digestValueNode);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigReferenceCtxCompleteDigest", NULL);
+            goto done;
+        }
+    }
+    res = 0;
+
+done:
+    if(XMLSEC_TRACE_SPAN_IS_ACTIVE(&span) && (dsigRefCtx->digestMethod != NULL)) {
+        span.href = dsigRefCtx->digestMethod->id->href;
     }
-    dsigRefCtx->result = transformCtx->result;
+    XMLSEC_TRACE_SPAN_END(&span,
+        (dsigRefCtx->digestMethod != NULL) ? xmlSecTransformGetStats(dsigRefCtx->digestMethod)->bytesIn : 0,
+        res);
+    return(res);
+}
 
+/* writes (signature) or verifies the reference digest */
+static int
+xmlSecDSigReferenceCtxCompleteDigest(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr digestValueNode) {
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx->dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx->digestMethod != NULL, -1);
+    xmlSecAssert2(digestValueNode != NULL, -1);
+
+    dsigRefCtx->result = dsigRefCtx->transformCtx.result;
     if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
         xmlSecByte* outBuf;
         xmlSecSize outSize;
         int outLen;
 
         if((dsigRefCtx->result == NULL) || (xmlSecBufferGetData(dsigRefCtx->result) == NULL)) {
-            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            xmlSecOtherError(XMLSEC_ERRORS_R_INVALID_RESULT, NULL, NULL);
             return(-1);
         }
 
@@ -1493,9 +2505,11 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
         /* set success status and we are done */
         dsigRefCtx->status = xmlSecDSigStatusSucceeded;
     } else {
+        int ret;
+
         /* verify SignatureValue node content */
         ret = xmlSecTransformVerifyNodeContent(dsigRefCtx->digestMethod,
-                            digestValueNode, transformCtx);
+                            digestValueNode, &(dsigRefCtx->transformCtx));
         if(ret < 0) {
             xmlSecInternalError("xmlSecTransformVerifyNodeContent", NULL);
             return(-1);
@@ -1508,10 +2522,794 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
             dsigRefCtx->status = xmlSecDSigStatusInvalid;
         }
     }
-
     return(0);
 }
 
+#ifdef LIBXML_READER_ENABLED
+/* the processing instruction that ends the replayed document */
+#define XMLSEC_DSIG_STREAM_SPOOL_MARKER         BAD_CAST "dsig-stream-end"
+
+/* the canonical document before the signature is moved to a temporary file above this size */
+#define XMLSEC_DSIG_STREAM_SPOOL_SIZE           (1024 * 1024)
+
+static void
+xmlSecDSigStreamReferenceDestroy(xmlSecDSigStreamReferencePtr ref) {
+    xmlSecAssert(ref != NULL);
+
+    if(ref->c14nStream != NULL) {
+        xmlSecTransformC14NStreamDestroy(ref->c14nStream);
+    }
+    xmlSecBufferFinalize(&(ref->buffer));
+    memset(ref, 0, sizeof(xmlSecDSigStreamReference));
+    xmlFree(ref);
+}
+
+static xmlSecPtrListKlass xmlSecDSigStreamReferenceListKlass = {
+    BAD_CAST "dsig-stream-reference-list",
+    NULL,                                                               /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecDSigStreamReferenceDestroy,       /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                               /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                               /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+static int
+xmlSecDSigStreamInitialize(xmlSecDSigStreamPtr stream, xmlTextReaderPtr reader, xmlOutputBufferPtr output) {
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(reader != NULL, -1);
+
+    memset(stream, 0, sizeof(xmlSecDSigStream));
+    stream->reader = reader;
+    stream->output = output;
+
+    ret = xmlSecBufferInitialize(&(stream->tail), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", NULL);
+        return(-1);
+    }
+    ret = xmlSecBufferInitialize(&(stream->spool), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", NULL);
+        xmlSecBufferFinalize(&(stream->tail));
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(stream->references), &xmlSecDSigStreamReferenceListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        xmlSecBufferFinalize(&(stream->spool));
+        xmlSecBufferFinalize(&(stream->tail));
+        return(-1);
+    }
+    return(0);
+}
+
+static void
+xmlSecDSigStreamFinalize(xmlSecDSigStreamPtr stream) {
+    xmlSecAssert(stream != NULL);
+
+    /* the canonicalizers might point to the replayed nodes */
+    xmlSecPtrListFinalize(&(stream->references));
+    if(stream->replay != NULL) {
+        xmlFreeTextReader(stream->replay);
+    }
+    if(stream->spoolStream != NULL) {
+        xmlSecTransformC14NStreamDestroy(stream->spoolStream);
+    }
+    if(stream->spoolC14N != NULL) {
+        xmlSecTransformDestroy(stream->spoolC14N);
+    }
+    if(stream->spoolFile != NULL) {
+        fclose(stream->spoolFile);
+    }
+    xmlSecBufferFinalize(&(stream->spool));
+    xmlSecBufferFinalize(&(stream->tail));
+    memset(stream, 0, sizeof(xmlSecDSigStream));
+}
+
+/* copies the element and its ancestors (without other children) to @doc,
+ * returns the copy of the element */
+static xmlNodePtr
+xmlSecDSigStreamCopyAncestors(xmlDocPtr doc, xmlNodePtr node) {
+    xmlNodePtr parent = NULL;
+    xmlNodePtr copy;
+
+    xmlSecAssert2(doc != NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+
+    if((node->parent != NULL) && (node->parent->type == XML_ELEMENT_NODE)) {
+        parent = xmlSecDSigStreamCopyAncestors(doc, node->parent);
+        if(parent == NULL) {
+            return(NULL);
+        }
+    }
+
+    copy = xmlDocCopyNode(node, doc, 2);
+    if(copy == NULL) {
+        xmlSecXmlError2("xmlDocCopyNode", NULL, "node=%s", xmlSecErrorsSafeString(node->name));
+        return(NULL);
+    }
+    if(parent == NULL) {
+        xmlDocSetRootElement(doc, copy);
+    } else if(xmlAddChild(parent, copy) == NULL) {
+        xmlSecXmlError("xmlAddChild", NULL);
+        xmlFreeNode(copy);
+        return(NULL);
+    }
+    return(copy);
+}
+
+/* writes the spool buffer to the temporary file */
+static int
+xmlSecDSigStreamSpoolWrite(xmlSecDSigStreamPtr stream) {
+    xmlSecSize size;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+
+    size = xmlSecBufferGetSize(&(stream->spool));
+    if(stream->spoolFile == NULL) {
+        stream->spoolFile = tmpfile();
+        if(stream->spoolFile == NULL) {
+            xmlSecIOError("tmpfile", NULL, NULL);
+            return(-1);
+        }
+    }
+    if((size > 0) && (fwrite(xmlSecBufferGetData(&(stream->spool)), size, 1, stream->spoolFile) != 1)) {
+        xmlSecIOError("fwrite", NULL, NULL);
+        return(-1);
+    }
+    ret = xmlSecBufferSetSize(&(stream->spool), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferSetSize", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecDSigStreamSpoolRead(void* context, char* buffer, int len) {
+    FILE* f = (FILE*)context;
+    size_t size;
+    int res;
+
+    xmlSecAssert2(f != NULL, -1);
+    xmlSecAssert2(buffer != NULL, -1);
+    xmlSecAssert2(len >= 0, -1);
+
+    size = fread(buffer, 1, (size_t)len, f);
+    if(ferror(f)) {
+        xmlSecIOError("fread", NULL, NULL);
+        return(-1);
+    }
+    XMLSEC_SAFE_CAST_SIZE_T_TO_INT(size, res, return(-1), NULL);
+    return(res);
+}
+
+/*
+ * Reads the document up to the first <dsig:Signature/> element: the
+ * document before the signature is canonicalized (inclusive C14N without
+ * comments keeps everything the references canonicalization needs) to
+ * the spool, the signature element and its ancestors are copied to the
+ * new document. The reader is left on the signature element.
+ */
+static xmlNodePtr
+xmlSecDSigStreamReadSignature(xmlSecDSigStreamPtr stream, xmlDocPtr* signatureDoc) {
+    xmlDocPtr doc;
+    xmlNodePtr cur, parent, node;
+    int type;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, NULL);
+    xmlSecAssert2(stream->reader != NULL, NULL);
+    xmlSecAssert2(stream->spoolStream == NULL, NULL);
+    xmlSecAssert2(signatureDoc != NULL, NULL);
+    xmlSecAssert2((*signatureDoc) == NULL, NULL);
+
+    stream->spoolC14N = xmlSecTransformCreate(xmlSecTransformInclC14NId);
+    if(stream->spoolC14N == NULL) {
+        xmlSecInternalError("xmlSecTransformCreate(xmlSecTransformInclC14NId)", NULL);
+        return(NULL);
+    }
+    stream->spoolStream = xmlSecTransformC14NStreamCreate(stream->spoolC14N);
+    if(stream->spoolStream == NULL) {
+        xmlSecInternalError("xmlSecTransformC14NStreamCreate", xmlSecTransformGetName(stream->spoolC14N));
+        return(NULL);
+    }
+
+    while((ret = xmlTextReaderRead(stream->reader)) == 1) {
+        type = xmlTextReaderNodeType(stream->reader);
+        cur = xmlTextReaderCurrentNode(stream->reader);
+        if((type == XML_READER_TYPE_ELEMENT) && (cur != NULL) &&
+           xmlSecCheckNodeName(cur, xmlSecNodeSignature, xmlSecDSigNs)) {
+            break;
+        }
+
+        /* the marker might be in the document */
+        if((type == XML_READER_TYPE_PROCESSING_INSTRUCTION) &&
+           xmlStrEqual(xmlTextReaderConstName(stream->reader), XMLSEC_DSIG_STREAM_SPOOL_MARKER)) {
+            ++stream->spoolMarkers;
+        }
+        ret = xmlSecTransformC14NStreamRead(stream->spoolStream, stream->reader, &(stream->spool));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformC14NStreamRead", NULL);
+            return(NULL);
+        }
+        if((type == XML_READER_TYPE_ELEMENT) && (xmlTextReaderIsEmptyElement(stream->reader) == 1)) {
+            ret = xmlSecTransformC14NStreamEndElement(stream->spoolStream, stream->reader, &(stream->spool));
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecTransformC14NStreamEndElement", NULL);
+                return(NULL);
+            }
+        }
+        if(xmlSecBufferGetSize(&(stream->spool)) >= XMLSEC_DSIG_STREAM_SPOOL_SIZE) {
+            ret = xmlSecDSigStreamSpoolWrite(stream);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigStreamSpoolWrite", NULL);
+                return(NULL);
+            }
+        }
+    }
+    if(ret < 0) {
+        xmlSecXmlError("xmlTextReaderRead", NULL);
+        return(NULL);
+    } else if(ret == 0) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_NODE_NOT_FOUND, NULL,
+            "node=%s", xmlSecErrorsSafeString(xmlSecNodeSignature));
+        return(NULL);
+    }
+
+    /* copy the signature */
+    cur = xmlTextReaderExpand(stream->reader);
+    if(cur == NULL) {
+        xmlSecXmlError("xmlTextReaderExpand", NULL);
+        return(NULL);
+    }
+    doc = xmlNewDoc(BAD_CAST "1.0");
+    if(doc == NULL) {
+        xmlSecXmlError("xmlNewDoc", NULL);
+        return(NULL);
+    }
+    (*signatureDoc) = doc;
+
+    parent = NULL;
+    if((cur->parent != NULL) && (cur->parent->type == XML_ELEMENT_NODE)) {
+        parent = xmlSecDSigStreamCopyAncestors(doc, cur->parent);
+        if(parent == NULL) {
+            xmlSecInternalError("xmlSecDSigStreamCopyAncestors", NULL);
+            return(NULL);
+        }
+    }
+    node = xmlDocCopyNode(cur, doc, 1);
+    if(node == NULL) {
+        xmlSecXmlError("xmlDocCopyNode", NULL);
+        return(NULL);
+    }
+    if(parent == NULL) {
+        xmlDocSetRootElement(doc, node);
+    } else if(xmlAddChild(parent, node) == NULL) {
+        xmlSecXmlError("xmlAddChild", NULL);
+        xmlFreeNode(node);
+        return(NULL);
+    }
+    return(node);
+}
+
+/* checks the element "Id", "ID", "id" and "xml:id" attributes */
+static int
+xmlSecDSigStreamCheckId(xmlNodePtr node, const xmlChar* id) {
+    xmlAttrPtr attr;
+    xmlChar* value;
+    int res;
+
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(id != NULL, -1);
+
+    for(attr = node->properties; attr != NULL; attr = attr->next) {
+        if(attr->ns == NULL) {
+            if(!xmlStrEqual(attr->name, xmlSecAttrId) && !xmlStrEqual(attr->name, BAD_CAST "ID") &&
+               !xmlStrEqual(attr->name, BAD_CAST "id")) {
+                continue;
+            }
+        } else if(!xmlStrEqual(attr->ns->href, XML_XML_NAMESPACE) || !xmlStrEqual(attr->name, BAD_CAST "id")) {
+            continue;
+        }
+
+        value = xmlNodeListGetString(node->doc, attr->children, 1);
+        if(value == NULL) {
+            continue;
+        }
+        res = xmlStrEqual(value, id);
+        xmlFree(value);
+        if(res) {
+            return(1);
+        }
+    }
+    return(0);
+}
+
+/*
+ * Adds the reference that is canonicalized and digested while the
+ * document is read. Returns 1 if the reference was added, 0 if it should
+ * be processed with the signature document (verification only) or a
+ * negative value if an error occurs or the reference transforms require
+ * the document tree.
+ */
+static int
+xmlSecDSigStreamAddReference(xmlSecDSigStreamPtr stream, xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                             xmlNodePtr digestValueNode) {
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecDSigStreamReferencePtr ref;
+    xmlSecTransformPtr transform;
+    xmlSecTransformPtr c14n;
+    const xmlChar* id = NULL;
+    int sign;
+    int enveloped = 0;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx->dsigCtx != NULL, -1);
+    xmlSecAssert2(digestValueNode != NULL, -1);
+
+    transformCtx = &(dsigRefCtx->transformCtx);
+    sign = (dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) ? 1 : 0;
+
+    /* the document, an element in the document or anything else */
+    if((dsigRefCtx->uri != NULL) && (dsigRefCtx->uri[0] == '#') && (sign == 0)) {
+        id = dsigRefCtx->uri + 1;
+        if(xmlStrchr(id, '(') != NULL) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+                "the reference uri requires the document tree, uri=%s",
+                xmlSecErrorsSafeString(dsigRefCtx->uri));
+            return(-1);
+        }
+        /* the signature elements are available */
+        if(xmlGetID(digestValueNode->doc, id) != NULL) {
+            return(0);
+        }
+    } else if((dsigRefCtx->uri == NULL) || (dsigRefCtx->uri[0] != '\0')) {
+        if(sign != 0) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+                "the streaming signature requires the empty reference uri, uri=%s",
+                xmlSecErrorsSafeString(dsigRefCtx->uri));
+            return(-1);
+        }
+        /* the external data are not a part of the document */
+        return(0);
+    }
+
+    ret = xmlSecTransformCtxPrepare(transformCtx, xmlSecTransformDataTypeXml);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxPrepare(TypeXml)", NULL);
+        return(-1);
+    }
+
+    /* the id selection, enveloped signature, c14n and the binary transforms */
+    transform = transformCtx->first;
+    if((id != NULL) && (transform != NULL) && xmlSecTransformCheckId(transform, xmlSecTransformXPointerId)) {
+        transform = transform->next;
+    }
+    if((transform != NULL) && xmlSecTransformCheckId(transform, xmlSecTransformEnvelopedId)) {
+        enveloped = 1;
+        transform = transform->next;
+    }
+    if((id == NULL) && (enveloped == 0)) {
+        xmlSecOtherError(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+            "the streamed document reference requires the enveloped signature transform");
+        return(-1);
+    }
+    c14n = transform;
+    if((c14n == NULL) ||
+       (!xmlSecTransformCheckId(c14n, xmlSecTransformInclC14NId) &&
+        !xmlSecTransformCheckId(c14n, xmlSecTransformInclC14N11Id) &&
+        !xmlSecTransformCheckId(c14n, xmlSecTransformExclC14NId)))
+    {
+        xmlSecOtherError(XMLSEC_ERRORS_R_NOT_IMPLEMENTED,
+            (c14n != NULL) ? xmlSecTransformGetName(c14n) : NULL,
+            "the transform requires the document tree, only c14n can follow the enveloped signature transform");
+        return(-1);
+    }
+    for(transform = c14n->next; transform != NULL; transform = transform->next) {
+        if((transform != dsigRefCtx->digestMethod) &&
+           !xmlSecTransformCheckId(transform, xmlSecTransformMemBufId) &&
+           !xmlSecTransformCheckId(transform, xmlSecTransformBase64Id))
+        {
+            xmlSecOtherError(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, xmlSecTransformGetName(transform),
+                "the transform is not supported by the streamed reference");
+            return(-1);
+        }
+    }
+
+    ref = (xmlSecDSigStreamReferencePtr)xmlMalloc(sizeof(xmlSecDSigStreamReference));
+    if(ref == NULL) {
+        xmlSecMallocError(sizeof(xmlSecDSigStreamReference), NULL);
+        return(-1);
+    }
+    memset(ref, 0, sizeof(xmlSecDSigStreamReference));
+    ref->dsigRefCtx = dsigRefCtx;
+    ref->digestValueNode = digestValueNode;
+    ref->c14n = c14n;
+    ref->id = id;
+    ref->enveloped = enveloped;
+    ref->depth = -1;
+
+    ret = xmlSecBufferInitialize(&(ref->buffer), XMLSEC_DSIG_STREAM_BUFFER_SIZE);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", NULL);
+        xmlFree(ref);
+        return(-1);
+    }
+    ref->c14nStream = xmlSecTransformC14NStreamCreate(c14n);
+    if(ref->c14nStream == NULL) {
+        xmlSecInternalError("xmlSecTransformC14NStreamCreate", xmlSecTransformGetName(c14n));
+        xmlSecDSigStreamReferenceDestroy(ref);
+        return(-1);
+    }
+    ret = xmlSecPtrListAdd(&(stream->references), ref);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        xmlSecDSigStreamReferenceDestroy(ref);
+        return(-1);
+    }
+
+    /* the digest gets the data in chunks, nothing to batch */
+    transformCtx->flags &= ~((unsigned int)XMLSEC_TRANSFORMCTX_FLAGS_BATCH_EXECUTE);
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+        ++xmlSecTransformGetStats(c14n)->xmlCalls;
+    }
+    return(1);
+}
+
+/* pushes the canonical data to the digest and writes them to the output
+ * (or keeps them for the output after the signature) */
+static int
+xmlSecDSigStreamFlush(xmlSecDSigStreamPtr stream, xmlSecDSigStreamReferencePtr ref, int final) {
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecByte* data;
+    xmlSecSize size;
+    int len;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(ref != NULL, -1);
+    xmlSecAssert2(ref->dsigRefCtx != NULL, -1);
+    xmlSecAssert2(ref->c14n != NULL, -1);
+
+    transformCtx = &(ref->dsigRefCtx->transformCtx);
+    data = xmlSecBufferGetData(&(ref->buffer));
+    size = xmlSecBufferGetSize(&(ref->buffer));
+
+    /* the pushed data are counted as the c14n transform output */
+    if((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_COLLECT_STATS) != 0) {
+        xmlSecTransformCtxSetStatsCurrent(transformCtx, ref->c14n);
+    }
+    ret = xmlSecTransformPushBin(ref->c14n->next, data, size, final, transformCtx);
+    xmlSecTransformCtxSetStatsCurrent(transformCtx, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformPushBin", xmlSecTransformGetName(ref->c14n->next));
+        return(-1);
+    }
+    if(size == 0) {
+        return(0);
+    }
+
+    if(stream->output == NULL) {
+        /* nothing to write */
+    } else if(stream->afterSignature != 0) {
+        ret = xmlSecBufferAppend(&(stream->tail), data, size);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferAppend", NULL);
+            return(-1);
+        }
+    } else {
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(size, len, return(-1), NULL);
+        ret = xmlOutputBufferWrite(stream->output, len, (const char*)data);
+        if(ret < 0) {
+            xmlSecXmlError("xmlOutputBufferWrite", NULL);
+            return(-1);
+        }
+    }
+
+    ret = xmlSecBufferSetSize(&(ref->buffer), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferSetSize", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/* passes the reader current node to the references canonicalization */
+static int
+xmlSecDSigStreamReadNode(xmlSecDSigStreamPtr stream, xmlTextReaderPtr reader) {
+    xmlSecDSigStreamReferencePtr ref;
+    xmlSecSize ii, size;
+    xmlNodePtr cur;
+    int type, depth, isEmpty;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(reader != NULL, -1);
+
+    type = xmlTextReaderNodeType(reader);
+    depth = xmlTextReaderDepth(reader);
+    isEmpty = ((type == XML_READER_TYPE_ELEMENT) && (xmlTextReaderIsEmptyElement(reader) == 1)) ? 1 : 0;
+
+    size = xmlSecPtrListGetSize(&(stream->references));
+    for(ii = 0; ii < size; ++ii) {
+        ref = (xmlSecDSigStreamReferencePtr)xmlSecPtrListGetItem(&(stream->references), ii);
+        xmlSecAssert2(ref != NULL, -1);
+
+        /* find the referenced element, the id should be unique */
+        if((ref->id != NULL) && (type == XML_READER_TYPE_ELEMENT)) {
+            cur = xmlTextReaderCurrentNode(reader);
+            xmlSecAssert2(cur != NULL, -1);
+
+            ret = xmlSecDSigStreamCheckId(cur, ref->id);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigStreamCheckId", NULL);
+                return(-1);
+            } else if((ret == 1) && (ref->depth >= 0)) {
+                xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                    "duplicate id=%s", xmlSecErrorsSafeString(ref->id));
+                return(-1);
+            } else if(ret == 1) {
+                ref->depth = depth;
+            }
+        }
+        if((ref->finished != 0) || ((ref->id != NULL) && (ref->depth < 0))) {
+            continue;
+        }
+
+        /* the signature goes right before the document element end tag */
+        if((stream->output != NULL) && (type == XML_READER_TYPE_END_ELEMENT) && (depth == 0)) {
+            ret = xmlSecDSigStreamFlush(stream, ref, 0);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigStreamFlush", NULL);
+                return(-1);
+            }
+            stream->afterSignature = 1;
+        }
+        ret = xmlSecTransformC14NStreamRead(ref->c14nStream, reader, &(ref->buffer));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformC14NStreamRead", NULL);
+            return(-1);
+        }
+        if(isEmpty != 0) {
+            if((stream->output != NULL) && (depth == 0)) {
+                ret = xmlSecDSigStreamFlush(stream, ref, 0);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecDSigStreamFlush", NULL);
+                    return(-1);
+                }
+                stream->afterSignature = 1;
+            }
+            ret = xmlSecTransformC14NStreamEndElement(ref->c14nStream, reader, &(ref->buffer));
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecTransformC14NStreamEndElement", NULL);
+                return(-1);
+            }
+        }
+
+        if((ref->id != NULL) && (depth == ref->depth) && ((type == XML_READER_TYPE_END_ELEMENT) || (isEmpty != 0))) {
+            ret = xmlSecDSigStreamFlush(stream, ref, 1);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigStreamFlush", NULL);
+                return(-1);
+            }
+            ref->finished = 1;
+        } else if(xmlSecBufferGetSize(&(ref->buffer)) >= XMLSEC_DSIG_STREAM_BUFFER_SIZE) {
+            ret = xmlSecDSigStreamFlush(stream, ref, 0);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigStreamFlush", NULL);
+                return(-1);
+            }
+        }
+    }
+    return(0);
+}
+
+/* reads the canonical document before the signature: the marker and the
+ * end tags for the signature ancestors are appended to make it well-formed */
+static int
+xmlSecDSigStreamReplay(xmlSecDSigStreamPtr stream) {
+    xmlNodePtr cur;
+    xmlSecSize size;
+    int len, markers;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(stream->reader != NULL, -1);
+    xmlSecAssert2(stream->replay == NULL, -1);
+
+    ret = xmlSecBufferAppend(&(stream->spool), BAD_CAST "<?", 2);
+    if(ret >= 0) {
+        ret = xmlSecBufferAppend(&(stream->spool), XMLSEC_DSIG_STREAM_SPOOL_MARKER,
+                                 xmlSecStrlen(XMLSEC_DSIG_STREAM_SPOOL_MARKER));
+    }
+    if(ret >= 0) {
+        ret = xmlSecBufferAppend(&(stream->spool), BAD_CAST "?>", 2);
+    }
+    cur = xmlTextReaderCurrentNode(stream->reader);
+    xmlSecAssert2(cur != NULL, -1);
+    for(cur = cur->parent; (ret >= 0) && (cur != NULL) && (cur->type == XML_ELEMENT_NODE); cur = cur->parent) {
+        ret = xmlSecBufferAppend(&(stream->spool), BAD_CAST "</", 2);
+        if((ret >= 0) && (cur->ns != NULL) && (cur->ns->prefix != NULL)) {
+            ret = xmlSecBufferAppend(&(stream->spool), cur->ns->prefix, xmlSecStrlen(cur->ns->prefix));
+            if(ret >= 0) {
+                ret = xmlSecBufferAppend(&(stream->spool), BAD_CAST ":", 1);
+            }
+        }
+        if(ret >= 0) {
+            ret = xmlSecBufferAppend(&(stream->spool), cur->name, xmlSecStrlen(cur->name));
+        }
+        if(ret >= 0) {
+            ret = xmlSecBufferAppend(&(stream->spool), BAD_CAST ">", 1);
+        }
+    }
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferAppend", NULL);
+        return(-1);
+    }
+
+    if(stream->spoolFile != NULL) {
+        ret = xmlSecDSigStreamSpoolWrite(stream);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigStreamSpoolWrite", NULL);
+            return(-1);
+        }
+        rewind(stream->spoolFile);
+        stream->replay = xmlReaderForIO(xmlSecDSigStreamSpoolRead, NULL, stream->spoolFile,
+                                        NULL, NULL, xmlSecParserGetDefaultOptions());
+    } else {
+        size = xmlSecBufferGetSize(&(stream->spool));
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(size, len, return(-1), NULL);
+        stream->replay = xmlReaderForMemory((const char*)xmlSecBufferGetData(&(stream->spool)), len,
+                                            NULL, NULL, xmlSecParserGetDefaultOptions());
+    }
+    if(stream->replay == NULL) {
+        xmlSecXmlError("xmlReaderForMemory", NULL);
+        return(-1);
+    }
+
+    /* the replay reader is kept: the canonicalization might use its nodes */
+    markers = stream->spoolMarkers;
+    while((ret = xmlTextReaderRead(stream->replay)) == 1) {
+        if((xmlTextReaderNodeType(stream->replay) == XML_READER_TYPE_PROCESSING_INSTRUCTION) &&
+           xmlStrEqual(xmlTextReaderConstName(stream->replay), XMLSEC_DSIG_STREAM_SPOOL_MARKER) &&
+           ((markers--) == 0))
+        {
+            return(0);
+        }
+        ret = xmlSecDSigStreamReadNode(stream, stream->replay);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigStreamReadNode", NULL);
+            return(-1);
+        }
+    }
+    xmlSecXmlError("xmlTextReaderRead", NULL);
+    return(-1);
+}
+
+/* reads the document and finishes the streamed references digests */
+static int
+xmlSecDSigStreamRun(xmlSecDSigStreamPtr stream) {
+    xmlSecDSigStreamReferencePtr ref;
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecTransformPtr transform;
+    xmlSecSize ii, size;
+    int ret;
+
+    xmlSecAssert2(stream != NULL, -1);
+    xmlSecAssert2(stream->reader != NULL, -1);
+
+    size = xmlSecPtrListGetSize(&(stream->references));
+    if(size == 0) {
+        return(0);
+    }
+
+    if(stream->output == NULL) {
+        /* the document before the signature */
+        ret = xmlSecDSigStreamReplay(stream);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigStreamReplay", NULL);
+            return(-1);
+        }
+
+        /* the referenced elements that contain the signature */
+        for(ii = 0; ii < size; ++ii) {
+            ref = (xmlSecDSigStreamReferencePtr)xmlSecPtrListGetItem(&(stream->references), ii);
+            xmlSecAssert2(ref != NULL, -1);
+
+            if((ref->finished == 0) && (ref->depth >= 0) && (ref->enveloped == 0)) {
+                xmlSecOtherError2(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+                    "the referenced element contains the signature, the enveloped signature transform is required, id=%s",
+                    xmlSecErrorsSafeString(ref->id));
+                return(-1);
+            }
+        }
+
+        /* skip the signature */
+        ret = xmlTextReaderNext(stream->reader);
+    } else {
+        ret = xmlTextReaderRead(stream->reader);
+    }
+    while(ret == 1) {
+        ret = xmlSecDSigStreamReadNode(stream, stream->reader);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigStreamReadNode", NULL);
+            return(-1);
+        }
+        ret = xmlTextReaderRead(stream->reader);
+    }
+    if(ret < 0) {
+        xmlSecXmlError("xmlTextReaderRead", NULL);
+        return(-1);
+    }
+    if((stream->output != NULL) && (stream->afterSignature == 0)) {
+        xmlSecInvalidDataError("the document element is not found", NULL);
+        return(-1);
+    }
+
+    for(ii = 0; ii < size; ++ii) {
+        ref = (xmlSecDSigStreamReferencePtr)xmlSecPtrListGetItem(&(stream->references), ii);
+        xmlSecAssert2(ref != NULL, -1);
+        xmlSecAssert2(ref->dsigRefCtx != NULL, -1);
+
+        if(ref->finished == 0) {
+            if(ref->id != NULL) {
+                xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                    "the referenced element is not found, id=%s", xmlSecErrorsSafeString(ref->id));
+                return(-1);
+            }
+            ret = xmlSecDSigStreamFlush(stream, ref, 1);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigStreamFlush", NULL);
+                return(-1);
+            }
+            ref->finished = 1;
+        }
+
+        /* the transforms before the digest are done */
+        transformCtx = &(ref->dsigRefCtx->transformCtx);
+        for(transform = transformCtx->first; transform != ref->c14n->next; transform = transform->next) {
+            transform->status = xmlSecTransformStatusFinished;
+        }
+        transformCtx->status = xmlSecTransformStatusFinished;
+
+        ret = xmlSecDSigReferenceCtxCompleteDigest(ref->dsigRefCtx, ref->digestValueNode);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigReferenceCtxCompleteDigest", NULL);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+#else  /* LIBXML_READER_ENABLED */
+
+static int
+xmlSecDSigStreamAddReference(xmlSecDSigStreamPtr stream ATTRIBUTE_UNUSED,
+                             xmlSecDSigReferenceCtxPtr dsigRefCtx ATTRIBUTE_UNUSED,
+                             xmlNodePtr digestValueNode ATTRIBUTE_UNUSED) {
+    UNREFERENCED_PARAMETER(stream);
+    UNREFERENCED_PARAMETER(dsigRefCtx);
+    UNREFERENCED_PARAMETER(digestValueNode);
+
+    xmlSecNotImplementedError("libxml2 reader");
+    return(-1);
+}
+
+static int
+xmlSecDSigStreamRun(xmlSecDSigStreamPtr stream ATTRIBUTE_UNUSED) {
+    UNREFERENCED_PARAMETER(stream);
+
+    xmlSecNotImplementedError("libxml2 reader");
+    return(-1);
+}
+
+#endif /* LIBXML_READER_ENABLED */
+
 /**
  * xmlSecDSigReferenceCtxDebugDump:
  * @dsigRefCtx:         the pointer to &lt;dsig:Reference/&gt; element processing context.
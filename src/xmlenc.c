@@ -25,33 +25,83 @@
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/encoding.h>
+#include <libxml/xmlIO.h>
 
 #include <xmlsec/xmlsec.h>
+#include <xmlsec/allocator.h>
 #include <xmlsec/buffer.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/keys.h>
 #include <xmlsec/keysmngr.h>
 #include <xmlsec/transforms.h>
 #include <xmlsec/keyinfo.h>
+#include <xmlsec/templates.h>
 #include <xmlsec/xmlenc.h>
 #include <xmlsec/errors.h>
+#include <xmlsec/io.h>
+#include <xmlsec/parser.h>
 
 #include "cast_helpers.h"
+#include "threads.h"
+#include "trace_helpers.h"
+#include "transform_helpers.h"
 
 static int      xmlSecEncCtxEncDataNodeRead             (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
 static int      xmlSecEncCtxEncDataNodeWrite            (xmlSecEncCtxPtr encCtx);
+static int      xmlSecEncCtxEncryptToOutput             (xmlSecEncCtxPtr encCtx,
+                                                         xmlNodePtr tmpl,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize,
+                                                         const xmlChar* uri,
+                                                         xmlOutputBufferPtr output);
 static int      xmlSecEncCtxCipherDataNodeRead          (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
 static int      xmlSecEncCtxCipherReferenceNodeRead     (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
 
+static int      xmlSecEncCtxRecipientsExpand            (xmlNodePtr tmpl,
+                                                         const xmlChar** recipients,
+                                                         xmlSecSize recipientsSize);
+
 static void     xmlSecEncCtxMarkAsFailed                (xmlSecEncCtxPtr encCtx,
                                                          xmlSecEncFailureReason failureReason);
+static xmlSecSize xmlSecEncCtxGetTraceSize              (xmlSecEncCtxPtr encCtx,
+                                                         xmlSecTraceSpanPtr span);
 
 /* The ID attribute in XMLEnc is 'Id' */
 static const xmlChar*           xmlSecEncIds[] = { BAD_CAST "Id", NULL };
 
+/* the private data that doesn't fit in the public xmlSecEncCtx
+ * layout, it is created on demand and stored in encCtx->reserved1 */
+typedef struct _xmlSecEncCtxPrivate             xmlSecEncCtxPrivate,
+                                                *xmlSecEncCtxPrivatePtr;
+struct _xmlSecEncCtxPrivate {
+    xmlSecArenaPtr                              arena;
+};
+
+static xmlSecEncCtxPrivatePtr
+xmlSecEncCtxGetPrivate(xmlSecEncCtxPtr encCtx, int create) {
+    xmlSecEncCtxPrivatePtr priv;
+
+    xmlSecAssert2(encCtx != NULL, NULL);
+
+    priv = (xmlSecEncCtxPrivatePtr)encCtx->reserved1;
+    if((priv != NULL) || (create == 0)) {
+        return(priv);
+    }
+
+    priv = (xmlSecEncCtxPrivatePtr)xmlSecMalloc(sizeof(xmlSecEncCtxPrivate), xmlSecAllocatorObjectTypeCtx);
+    if(priv == NULL) {
+        xmlSecMallocError(sizeof(xmlSecEncCtxPrivate), NULL);
+        return(NULL);
+    }
+    memset(priv, 0, sizeof(xmlSecEncCtxPrivate));
+    encCtx->reserved1 = priv;
+    return(priv);
+}
+
 
 /**
  * xmlSecEncCtxCreate:
@@ -69,7 +119,7 @@ xmlSecEncCtxCreate(xmlSecKeysMngrPtr keysMngr) {
     xmlSecEncCtxPtr encCtx;
     int ret;
 
-    encCtx = (xmlSecEncCtxPtr) xmlMalloc(sizeof(xmlSecEncCtx));
+    encCtx = (xmlSecEncCtxPtr) xmlSecMalloc(sizeof(xmlSecEncCtx), xmlSecAllocatorObjectTypeCtx);
     if(encCtx == NULL) {
         xmlSecMallocError(sizeof(xmlSecEncCtx), NULL);
         return(NULL);
@@ -95,7 +145,7 @@ xmlSecEncCtxDestroy(xmlSecEncCtxPtr encCtx) {
     xmlSecAssert(encCtx != NULL);
 
     xmlSecEncCtxFinalize(encCtx);
-    xmlFree(encCtx);
+    xmlSecFree(encCtx, sizeof(xmlSecEncCtx), xmlSecAllocatorObjectTypeCtx);
 }
 
 static void
@@ -160,6 +210,8 @@ xmlSecEncCtxInitialize(xmlSecEncCtxPtr encCtx, xmlSecKeysMngrPtr keysMngr) {
  */
 void
 xmlSecEncCtxFinalize(xmlSecEncCtxPtr encCtx) {
+    xmlSecEncCtxPrivatePtr priv;
+
     xmlSecAssert(encCtx != NULL);
 
     xmlSecEncCtxReset(encCtx);
@@ -168,6 +220,14 @@ xmlSecEncCtxFinalize(xmlSecEncCtxPtr encCtx) {
     xmlSecKeyInfoCtxFinalize(&(encCtx->keyInfoReadCtx));
     xmlSecKeyInfoCtxFinalize(&(encCtx->keyInfoWriteCtx));
 
+    /* MUST be the last one: the objects above might be allocated from the arena */
+    priv = xmlSecEncCtxGetPrivate(encCtx, 0);
+    if(priv != NULL) {
+        if(priv->arena != NULL) {
+            xmlSecArenaDestroy(priv->arena);
+        }
+        xmlSecFree(priv, sizeof(xmlSecEncCtxPrivate), xmlSecAllocatorObjectTypeCtx);
+    }
     memset(encCtx, 0, sizeof(xmlSecEncCtx));
 }
 
@@ -179,6 +239,8 @@ xmlSecEncCtxFinalize(xmlSecEncCtxPtr encCtx) {
  */
 void
 xmlSecEncCtxReset(xmlSecEncCtxPtr encCtx) {
+    xmlSecEncCtxPrivatePtr priv;
+
     xmlSecAssert(encCtx != NULL);
 
     xmlSecTransformCtxReset(&(encCtx->transformCtx));
@@ -234,9 +296,48 @@ xmlSecEncCtxReset(xmlSecEncCtxPtr encCtx) {
     encCtx->encDataNode = encCtx->encMethodNode =
     encCtx->keyInfoNode = encCtx->cipherValueNode = NULL;
 
+    /* MUST be the last one: the objects above might be allocated from the arena */
+    priv = xmlSecEncCtxGetPrivate(encCtx, 0);
+    if((priv != NULL) && (priv->arena != NULL)) {
+        xmlSecArenaReset(priv->arena);
+    }
+
     xmlSecEncCtxSetDefaults(encCtx);
 }
 
+static int
+xmlSecEncCtxArenaPrepare(xmlSecEncCtxPtr encCtx) {
+    xmlSecEncCtxPrivatePtr priv;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+
+    /* allocate the per-operation objects from the arena */
+    if((encCtx->flags & XMLSEC_ENC_USE_ARENA) != 0) {
+        priv = xmlSecEncCtxGetPrivate(encCtx, 1);
+        if(priv == NULL) {
+            xmlSecInternalError("xmlSecEncCtxGetPrivate", NULL);
+            return(-1);
+        }
+        if(priv->arena == NULL) {
+            priv->arena = xmlSecArenaCreate(0);
+            if(priv->arena == NULL) {
+                xmlSecInternalError("xmlSecArenaCreate", NULL);
+                return(-1);
+            }
+        }
+    } else {
+        priv = xmlSecEncCtxGetPrivate(encCtx, 0);
+    }
+
+    ret = xmlSecTransformCtxSetArena(&(encCtx->transformCtx), (priv != NULL) ? priv->arena : NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxSetArena", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
 /**
  * xmlSecEncCtxCopyUserPref:
  * @dst:                the pointer to destination context.
@@ -294,6 +395,8 @@ xmlSecEncCtxCopyUserPref(xmlSecEncCtxPtr dst, xmlSecEncCtxPtr src) {
 int
 xmlSecEncCtxBinaryEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
                           const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecTraceSpan span;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
@@ -301,33 +404,48 @@ xmlSecEncCtxBinaryEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
     xmlSecAssert2(tmpl != NULL, -1);
     xmlSecAssert2(data != NULL, -1);
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeEncEncrypt, encCtx, NULL, &(encCtx->transformCtx));
+
     /* initialize context and add ID atributes to the list of known ids */
     encCtx->operation = xmlSecTransformOperationEncrypt;
     xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
 
+    ret = xmlSecEncCtxArenaPrepare(encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxArenaPrepare", NULL);
+        goto done;
+    }
+
     /* read the template and set encryption method, key, etc. */
     ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
-        return(-1);
+        goto done;
     }
 
     ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, dataSize);
     if(ret < 0) {
         xmlSecInternalError2("xmlSecTransformCtxBinaryExecute", NULL,
                              "dataSize=" XMLSEC_SIZE_FMT,  dataSize);
-        return(-1);
+        goto done;
     }
 
     encCtx->result = encCtx->transformCtx.result;
-    xmlSecAssert2(encCtx->result != NULL, -1);
+    if(encCtx->result == NULL) {
+        xmlSecInvalidDataError("the transforms chain has no result", NULL);
+        goto done;
+    }
 
     ret = xmlSecEncCtxEncDataNodeWrite(encCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeWrite", NULL);
-        return(-1);
+        goto done;
     }
-    return(0);
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecEncCtxGetTraceSize(encCtx, &span), res);
+    return(res);
 }
 
 /**
@@ -344,6 +462,8 @@ xmlSecEncCtxBinaryEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
 int
 xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node) {
     xmlOutputBufferPtr output;
+    xmlSecTraceSpan span;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
@@ -352,30 +472,41 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
     xmlSecAssert2(node != NULL, -1);
     xmlSecAssert2(node->doc != NULL, -1);
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeEncEncrypt, encCtx, NULL, &(encCtx->transformCtx));
+
     /* initialize context and add ID atributes to the list of known ids */
     encCtx->operation = xmlSecTransformOperationEncrypt;
     xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
 
+    ret = xmlSecEncCtxArenaPrepare(encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxArenaPrepare", NULL);
+        goto done;
+    }
+
     /* read the template and set encryption method, key, etc. */
     ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
-        return(-1);
+        goto done;
     }
 
     ret = xmlSecTransformCtxPrepare(&(encCtx->transformCtx), xmlSecTransformDataTypeBin);
     if(ret < 0) {
         xmlSecInternalError("xmlSecTransformCtxPrepare(TypeBin)", NULL);
-        return(-1);
+        goto done;
     }
 
-    xmlSecAssert2(encCtx->transformCtx.first != NULL, -1);
+    if(encCtx->transformCtx.first == NULL) {
+        xmlSecInvalidDataError("the transforms chain is empty", NULL);
+        goto done;
+    }
     output = xmlSecTransformCreateOutputBuffer(encCtx->transformCtx.first,
                                                 &(encCtx->transformCtx));
     if(output == NULL) {
         xmlSecInternalError("xmlSecTransformCreateOutputBuffer",
                             xmlSecTransformGetName(encCtx->transformCtx.first));
-        return(-1);
+        goto done;
     }
 
     /* push data thru */
@@ -393,23 +524,26 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
         xmlSecInvalidStringTypeError("encryption type", encCtx->type,
                 "supported encryption type", NULL);
         (void)xmlOutputBufferClose(output);
-        return(-1);
+        goto done;
     }
 
     /* close the buffer and flush everything */
     ret = xmlOutputBufferClose(output);
     if(ret < 0) {
         xmlSecXmlError("xmlOutputBufferClose", NULL);
-        return(-1);
+        goto done;
     }
 
     encCtx->result = encCtx->transformCtx.result;
-    xmlSecAssert2(encCtx->result != NULL, -1);
+    if(encCtx->result == NULL) {
+        xmlSecInvalidDataError("the transforms chain has no result", NULL);
+        goto done;
+    }
 
     ret = xmlSecEncCtxEncDataNodeWrite(encCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeWrite", NULL);
-        return(-1);
+        goto done;
     }
 
     /* now we need to update our original document */
@@ -420,14 +554,14 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceNodeAndReturn",
                                     xmlSecNodeGetName(node));
-                return(-1);
+                goto done;
             }
         } else {
             ret = xmlSecReplaceNode(node, tmpl);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceNode",
                                     xmlSecNodeGetName(node));
-                return(-1);
+                goto done;
             }
         }
         encCtx->resultReplaced = 1;
@@ -438,14 +572,14 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceContentAndReturn",
                                     xmlSecNodeGetName(node));
-                return(-1);
+                goto done;
             }
         } else {
             ret = xmlSecReplaceContent(node, tmpl);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceContent",
                                     xmlSecNodeGetName(node));
-                return(-1);
+                goto done;
             }
         }
         encCtx->resultReplaced = 1;
@@ -453,10 +587,13 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
         /* we should've caught this error before */
         xmlSecInvalidStringTypeError("encryption type", encCtx->type,
                 "supported encryption type", NULL);
-        return(-1);
+        goto done;
     }
-    /* done */
-    return(0);
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecEncCtxGetTraceSize(encCtx, &span), res);
+    return(res);
 }
 
 /**
@@ -471,6 +608,8 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
  */
 int
 xmlSecEncCtxUriEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, const xmlChar *uri) {
+    xmlSecTraceSpan span;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
@@ -478,177 +617,1099 @@ xmlSecEncCtxUriEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, const xmlChar *u
     xmlSecAssert2(tmpl != NULL, -1);
     xmlSecAssert2(uri != NULL, -1);
 
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeEncEncrypt, encCtx, NULL, &(encCtx->transformCtx));
+
     /* initialize context and add ID atributes to the list of known ids */
     encCtx->operation = xmlSecTransformOperationEncrypt;
     xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
 
+    ret = xmlSecEncCtxArenaPrepare(encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxArenaPrepare", NULL);
+        goto done;
+    }
+
     /* we need to add input uri transform first */
     ret = xmlSecTransformCtxSetUri(&(encCtx->transformCtx), uri, tmpl);
     if(ret < 0) {
         xmlSecInternalError2("xmlSecTransformCtxSetUri", NULL,
                              "uri=%s", xmlSecErrorsSafeString(uri));
-        return(-1);
+        goto done;
     }
 
     /* read the template and set encryption method, key, etc. */
     ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
-        return(-1);
+        goto done;
     }
 
     /* encrypt the data */
     ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), tmpl->doc);
     if(ret < 0) {
         xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
-        return(-1);
+        goto done;
     }
 
     encCtx->result = encCtx->transformCtx.result;
-    xmlSecAssert2(encCtx->result != NULL, -1);
+    if(encCtx->result == NULL) {
+        xmlSecInvalidDataError("the transforms chain has no result", NULL);
+        goto done;
+    }
 
     ret = xmlSecEncCtxEncDataNodeWrite(encCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeWrite", NULL);
-        return(-1);
+        goto done;
     }
 
-    return(0);
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecEncCtxGetTraceSize(encCtx, &span), res);
+    return(res);
 }
 
 /**
- * xmlSecEncCtxDecrypt:
+ * xmlSecEncCtxBinaryEncryptToOutput:
  * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
- * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
+ * @data:               the pointer for binary buffer.
+ * @dataSize:           the @data buffer size.
+ * @output:             the output buffer for the result document.
  *
- * Decrypts @node and if necessary replaces @node with decrypted data.
+ * Encrypts @data according to template @tmpl and writes the document
+ * of @tmpl with the result &lt;enc:EncryptedData/&gt; node to @output.
+ * The base64 encoded cipher value is written to @output as it is produced
+ * and it is not stored in @encCtx result or in the &lt;enc:CipherValue/&gt;
+ * node. The template must have the &lt;enc:CipherValue/&gt; node. The
+ * document is written in its own encoding, thus @output should not have
+ * an encoder, and the encoding must be ASCII compatible (e.g. the UTF-16
+ * documents are rejected). The caller is responsible for closing @output.
+ *
+ * The document is written while the data are encrypted: if an error occurs
+ * after the first bytes were written then @output has a partial document.
+ * In this case, @output is marked as failed (#xmlOutputBufferClose returns
+ * an error) and the caller must discard the written data.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
-xmlSecEncCtxDecrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
-    xmlSecBufferPtr buffer;
+xmlSecEncCtxBinaryEncryptToOutput(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                                  const xmlSecByte* data, xmlSecSize dataSize,
+                                  xmlOutputBufferPtr output) {
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
-    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
 
-    /* decrypt */
-    buffer = xmlSecEncCtxDecryptToBuffer(encCtx, node);
-    if(buffer == NULL) {
-        xmlSecInternalError("xmlSecEncCtxDecryptToBuffer", NULL);
+    ret = xmlSecEncCtxEncryptToOutput(encCtx, tmpl, data, dataSize, NULL, output);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecEncCtxEncryptToOutput", NULL,
+                             "dataSize=" XMLSEC_SIZE_FMT,  dataSize);
         return(-1);
     }
-
-    /* replace original node if requested */
-    if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncElement)) {
-        /* check if we need to return the replaced node */
-        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
-                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        } else {
-                ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        }
-
-        encCtx->resultReplaced = 1;
-    } else if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncContent)) {
-        /* replace the node with the buffer */
-
-        /* check if we need to return the replaced node */
-        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
-                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        } else {
-            ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        }
-        encCtx->resultReplaced = 1;
-    }
-
     return(0);
 }
 
 /**
- * xmlSecEncCtxDecryptToBuffer:
- * @encCtx:             the pointer to encryption processing context.
- * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ * xmlSecEncCtxUriEncryptToOutput:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
+ * @uri:                the URI.
+ * @output:             the output buffer for the result document.
  *
- * Decrypts @node data to the result.
+ * Encrypts data from @uri according to template @tmpl and writes the document
+ * of @tmpl with the result &lt;enc:EncryptedData/&gt; node to @output. The data
+ * are read from @uri, encrypted and written to @output in chunks, thus the
+ * memory usage doesn't depend on the data size. See
+ * #xmlSecEncCtxBinaryEncryptToOutput for details.
  *
- * Returns: a buffer with key on success or NULL if an error occurs.
+ * Returns: 0 on success or a negative value if an error occurs.
  */
-xmlSecBufferPtr
-xmlSecEncCtxDecryptToBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
-    xmlSecBufferPtr res = NULL;
-    xmlChar* data = NULL;
+int
+xmlSecEncCtxUriEncryptToOutput(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                               const xmlChar *uri, xmlOutputBufferPtr output) {
     int ret;
 
-    xmlSecAssert2(encCtx != NULL, NULL);
-    xmlSecAssert2(encCtx->result == NULL, NULL);
-    xmlSecAssert2(node != NULL, NULL);
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    ret = xmlSecEncCtxEncryptToOutput(encCtx, tmpl, NULL, 0, uri, output);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecEncCtxEncryptToOutput", NULL,
+                             "uri=%s", xmlSecErrorsSafeString(uri));
+        return(-1);
+    }
+    return(0);
+}
+
+/* The &lt;enc:CipherValue/&gt; node content is replaced with this marker while
+ * the template document is serialized: the document text before the marker
+ * is written before the cipher value and the text after it is written after. */
+#define XMLSEC_ENC_CIPHER_VALUE_MARKER          "@xmlsec-enc-cipher-value@"
+
+static int
+xmlSecEncCtxEncryptToOutput(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                            const xmlSecByte* data, xmlSecSize dataSize,
+                            const xmlChar* uri, xmlOutputBufferPtr output) {
+    xmlSecTransformPtr outputTransform;
+    xmlSecTraceSpan span;
+    xmlChar* doc = NULL;
+    int docLen = 0;
+    const xmlChar* marker;
+    int markerPos, markerLen;
+    int started = 0;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(tmpl->doc != NULL, -1);
+    xmlSecAssert2((data != NULL) || (uri != NULL), -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    /* the cipher value marker is found and the base64 text is written as bytes */
+    if(tmpl->doc->encoding != NULL) {
+        switch(xmlParseCharEncoding((const char*)tmpl->doc->encoding)) {
+        case XML_CHAR_ENCODING_UTF16LE:
+        case XML_CHAR_ENCODING_UTF16BE:
+        case XML_CHAR_ENCODING_UCS4LE:
+        case XML_CHAR_ENCODING_UCS4BE:
+        case XML_CHAR_ENCODING_UCS4_2143:
+        case XML_CHAR_ENCODING_UCS4_3412:
+        case XML_CHAR_ENCODING_UCS2:
+        case XML_CHAR_ENCODING_EBCDIC:
+            xmlSecInvalidStringDataError("encoding", tmpl->doc->encoding,
+                "ASCII compatible encoding", NULL);
+            return(-1);
+        default:
+            break;
+        }
+    }
+
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeEncEncrypt, encCtx, NULL, &(encCtx->transformCtx));
 
     /* initialize context and add ID atributes to the list of known ids */
-    encCtx->operation = xmlSecTransformOperationDecrypt;
-    xmlSecAddIDs(node->doc, node, xmlSecEncIds);
+    encCtx->operation = xmlSecTransformOperationEncrypt;
+    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
 
-    ret = xmlSecEncCtxEncDataNodeRead(encCtx, node);
+    ret = xmlSecEncCtxArenaPrepare(encCtx);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        xmlSecInternalError("xmlSecEncCtxArenaPrepare", NULL);
         goto done;
     }
 
-    /* decrypt the data */
-    if(encCtx->cipherValueNode != NULL) {
-        data = xmlNodeGetContent(encCtx->cipherValueNode);
-        if(data == NULL) {
-            xmlSecInvalidNodeContentError(encCtx->cipherValueNode, NULL, "empty");
-            goto done;
-        }
-
-        ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, xmlSecStrlen(data));
+    /* we need to add input uri transform first */
+    if(uri != NULL) {
+        ret = xmlSecTransformCtxSetUri(&(encCtx->transformCtx), uri, tmpl);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecTransformCtxBinaryExecute", NULL);
+            xmlSecInternalError2("xmlSecTransformCtxSetUri", NULL,
+                                 "uri=%s", xmlSecErrorsSafeString(uri));
             goto done;
         }
-    } else {
-        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
+    }
+
+    /* read the template and set encryption method, key, etc. */
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        goto done;
+    }
+    if(encCtx->cipherValueNode == NULL) {
+        xmlSecNodeNotFoundError("xmlSecEncCtxEncDataNodeRead", tmpl,
+                                xmlSecNodeCipherValue, NULL);
+        goto done;
+    }
+
+    /* update &lt;enc:KeyInfo/&gt; node before the template is written out */
+    if(encCtx->keyInfoNode != NULL) {
+        ret = xmlSecKeyInfoNodeWrite(encCtx->keyInfoNode, encCtx->encKey, &(encCtx->keyInfoWriteCtx));
         if(ret < 0) {
-            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            xmlSecInternalError("xmlSecKeyInfoNodeWrite", NULL);
             goto done;
         }
     }
 
-    /* success  */
-    res = encCtx->result = encCtx->transformCtx.result;
-    xmlSecAssert2(encCtx->result != NULL, NULL);
+    /* the base64 encoded cipher value goes directly to the output */
+    outputTransform = xmlSecTransformCtxCreateAndAppend(&(encCtx->transformCtx), xmlSecTransformOutputBufferId);
+    if(outputTransform == NULL) {
+        xmlSecInternalError("xmlSecTransformCtxCreateAndAppend(xmlSecTransformOutputBufferId)", NULL);
+        goto done;
+    }
+    ret = xmlSecTransformOutputBufferSet(outputTransform, output);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformOutputBufferSet",
+                            xmlSecTransformGetName(outputTransform));
+        goto done;
+    }
 
-done:
-    if(data != NULL) {
-        xmlFree(data);
+    /* serialize the template and find the cipher value position */
+    xmlNodeSetContent(encCtx->cipherValueNode, BAD_CAST XMLSEC_ENC_CIPHER_VALUE_MARKER);
+    xmlDocDumpMemory(tmpl->doc, &doc, &docLen);
+    xmlNodeSetContent(encCtx->cipherValueNode, NULL);
+    if((doc == NULL) || (docLen <= 0)) {
+        xmlSecXmlError("xmlDocDumpMemory", NULL);
+        goto done;
     }
-    return(res);
-}
 
-static int
-xmlSecEncCtxEncDataNodeRead(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
-    xmlNodePtr cur;
+    marker = xmlStrstr(doc, BAD_CAST XMLSEC_ENC_CIPHER_VALUE_MARKER);
+    markerLen = xmlStrlen(BAD_CAST XMLSEC_ENC_CIPHER_VALUE_MARKER);
+    if((marker == NULL) || (xmlStrstr(marker + markerLen, BAD_CAST XMLSEC_ENC_CIPHER_VALUE_MARKER) != NULL)) {
+        xmlSecInvalidDataError("the template document has no or several cipher value positions", NULL);
+        goto done;
+    }
+    markerPos = (int)(marker - doc);
+    if(markerPos + markerLen > docLen) {
+        xmlSecInvalidDataError("the cipher value position is outside of the template document", NULL);
+        goto done;
+    }
+
+    started = 1;
+    ret = xmlOutputBufferWrite(output, markerPos, (const char*)doc);
+    if(ret < 0) {
+        xmlSecXmlError2("xmlOutputBufferWrite", NULL, "size=%d", markerPos);
+        goto done;
+    }
+
+    /* encrypt the data */
+    if(uri != NULL) {
+        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), tmpl->doc);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            goto done;
+        }
+    } else {
+        ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, dataSize);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformCtxBinaryExecute", NULL,
+                                 "dataSize=" XMLSEC_SIZE_FMT,  dataSize);
+            goto done;
+        }
+    }
+
+    /* the result buffer stays empty: everything was written to the output */
+    encCtx->result = encCtx->transformCtx.result;
+    if(encCtx->result == NULL) {
+        xmlSecInvalidDataError("the transforms chain has no result", NULL);
+        goto done;
+    }
+
+    ret = xmlOutputBufferWrite(output, docLen - markerPos - markerLen, (const char*)(marker + markerLen));
+    if(ret < 0) {
+        xmlSecXmlError2("xmlOutputBufferWrite", NULL, "size=%d", docLen - markerPos - markerLen);
+        goto done;
+    }
+    ret = xmlOutputBufferFlush(output);
+    if(ret < 0) {
+        xmlSecXmlError("xmlOutputBufferFlush", NULL);
+        goto done;
+    }
+    res = 0;
+
+done:
+    if((res < 0) && (started != 0) && (output->error == 0)) {
+        /* the output has a partial document, make sure the caller notices */
+        output->error = XML_ERR_INTERNAL_ERROR;
+    }
+    if(doc != NULL) {
+        xmlFree(doc);
+    }
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecEncCtxGetTraceSize(encCtx, &span), res);
+    return(res);
+}
+
+/**
+ * xmlSecEncCtxBinaryEncryptRecipients:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
+ * @recipients:         the array of recipient key names.
+ * @recipientsSize:     the number of elements in @recipients.
+ * @data:               the pointer for binary buffer.
+ * @dataSize:           the @data buffer size.
+ *
+ * Encrypts @data according to template @tmpl for several recipients at once.
+ * The first &lt;enc:EncryptedKey/&gt; node in the &lt;dsig:KeyInfo/&gt; of
+ * @tmpl is used as a template for each recipient: see
+ * #xmlSecEncCtxXmlEncryptRecipients for details. The content is encrypted
+ * only once with the session key and the session key is encrypted for each
+ * recipient.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxBinaryEncryptRecipients(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                          const xmlChar** recipients, xmlSecSize recipientsSize,
+                          const xmlSecByte* data, xmlSecSize dataSize) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(recipients != NULL, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ret = xmlSecEncCtxRecipientsExpand(tmpl, recipients, recipientsSize);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecEncCtxRecipientsExpand", NULL,
+            "recipientsSize=" XMLSEC_SIZE_FMT, recipientsSize);
+        return(-1);
+    }
+
+    ret = xmlSecEncCtxBinaryEncrypt(encCtx, tmpl, data, dataSize);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxBinaryEncrypt", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecEncCtxXmlEncryptRecipients:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
+ * @recipients:         the array of recipient key names.
+ * @recipientsSize:     the number of elements in @recipients.
+ * @node:               the pointer to node for encryption.
+ *
+ * Encrypts @node according to template @tmpl for several recipients at once.
+ * The first &lt;enc:EncryptedKey/&gt; node in the &lt;dsig:KeyInfo/&gt; of
+ * @tmpl is copied for each recipient. Each copy gets the Recipient attribute
+ * and the recipient key name in the &lt;dsig:KeyName/&gt; node of
+ * &lt;enc:RecipientKeyInfo/&gt; (key agreement) or of the &lt;enc:EncryptedKey/&gt;
+ * own &lt;dsig:KeyInfo/&gt; (key transport or key wrap). The content is
+ * encrypted only once with the session key and the session key is encrypted
+ * for each recipient. If requested, @node is replaced with result
+ * &lt;enc:EncryptedData/&gt; node.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxXmlEncryptRecipients(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
+                          const xmlChar** recipients, xmlSecSize recipientsSize,
+                          xmlNodePtr node) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(recipients != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    ret = xmlSecEncCtxRecipientsExpand(tmpl, recipients, recipientsSize);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecEncCtxRecipientsExpand", NULL,
+            "recipientsSize=" XMLSEC_SIZE_FMT, recipientsSize);
+        return(-1);
+    }
+
+    ret = xmlSecEncCtxXmlEncrypt(encCtx, tmpl, node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxXmlEncrypt", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecEncCtxRecipientSet(xmlNodePtr encKeyNode, const xmlChar* recipient) {
+    xmlNodePtr keyInfoNode;
+    xmlNodePtr agreementNode;
+    xmlNodePtr keyNameNode;
+    int ret;
+
+    xmlSecAssert2(encKeyNode != NULL, -1);
+    xmlSecAssert2(recipient != NULL, -1);
+
+    if(xmlSetProp(encKeyNode, xmlSecAttrRecipient, recipient) == NULL) {
+        xmlSecXmlError2("xmlSetProp", NULL,
+            "name=%s", xmlSecErrorsSafeString(xmlSecAttrRecipient));
+        return(-1);
+    }
+
+    keyInfoNode = xmlSecTmplEncDataEnsureKeyInfo(encKeyNode, NULL);
+    if(keyInfoNode == NULL) {
+        xmlSecInternalError("xmlSecTmplEncDataEnsureKeyInfo", NULL);
+        return(-1);
+    }
+
+    /* for key agreement, the recipient key is in the RecipientKeyInfo */
+    agreementNode = xmlSecFindChild(keyInfoNode, xmlSecNodeAgreementMethod, xmlSecEncNs);
+    if(agreementNode != NULL) {
+        keyInfoNode = xmlSecFindChild(agreementNode, xmlSecNodeRecipientKeyInfo, xmlSecEncNs);
+        if(keyInfoNode == NULL) {
+            keyInfoNode = xmlSecAddChild(agreementNode, xmlSecNodeRecipientKeyInfo, xmlSecEncNs);
+            if(keyInfoNode == NULL) {
+                xmlSecInternalError("xmlSecAddChild(RecipientKeyInfo)", NULL);
+                return(-1);
+            }
+        }
+    }
+
+    keyNameNode = xmlSecFindChild(keyInfoNode, xmlSecNodeKeyName, xmlSecDSigNs);
+    if(keyNameNode == NULL) {
+        keyNameNode = xmlSecAddChild(keyInfoNode, xmlSecNodeKeyName, xmlSecDSigNs);
+        if(keyNameNode == NULL) {
+            xmlSecInternalError("xmlSecAddChild(KeyName)", NULL);
+            return(-1);
+        }
+    }
+    ret = xmlSecNodeEncodeAndSetContent(keyNameNode, recipient);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNodeEncodeAndSetContent", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecEncCtxRecipientsExpand(xmlNodePtr tmpl, const xmlChar** recipients, xmlSecSize recipientsSize) {
+    xmlNodePtr keyInfoNode;
+    xmlNodePtr encKeyNode;
+    xmlNodePtr cur;
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(recipients != NULL, -1);
+
+    if(recipientsSize == 0) {
+        xmlSecInvalidSizeLessThanError("recipients", recipientsSize, (xmlSecSize)1, NULL);
+        return(-1);
+    }
+
+    keyInfoNode = xmlSecFindChild(tmpl, xmlSecNodeKeyInfo, xmlSecDSigNs);
+    if(keyInfoNode == NULL) {
+        xmlSecNodeNotFoundError("xmlSecFindChild", tmpl, xmlSecNodeKeyInfo, NULL);
+        return(-1);
+    }
+    encKeyNode = xmlSecFindChild(keyInfoNode, xmlSecNodeEncryptedKey, xmlSecEncNs);
+    if(encKeyNode == NULL) {
+        xmlSecNodeNotFoundError("xmlSecFindChild", keyInfoNode, xmlSecNodeEncryptedKey, NULL);
+        return(-1);
+    }
+
+    /* copy the pristine template first (in reverse order to keep the recipients order) */
+    for(ii = recipientsSize - 1; ii > 0; --ii) {
+        cur = xmlDocCopyNode(encKeyNode, encKeyNode->doc, 1);
+        if(cur == NULL) {
+            xmlSecXmlError("xmlDocCopyNode", NULL);
+            return(-1);
+        }
+        /* the Id attribute must be unique in the document */
+        xmlUnsetProp(cur, xmlSecAttrId);
+
+        if(xmlAddNextSibling(encKeyNode, cur) == NULL) {
+            xmlSecXmlError("xmlAddNextSibling", NULL);
+            xmlFreeNode(cur);
+            return(-1);
+        }
+    }
+
+    /* and set recipient for each copy */
+    for(ii = 0, cur = encKeyNode; (ii < recipientsSize) && (cur != NULL); ++ii, cur = xmlSecGetNextElementNode(cur->next)) {
+        xmlSecAssert2(recipients[ii] != NULL, -1);
+
+        ret = xmlSecEncCtxRecipientSet(cur, recipients[ii]);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecEncCtxRecipientSet", NULL,
+                "recipient=%s", xmlSecErrorsSafeString(recipients[ii]));
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+/**
+ * xmlSecEncCtxDecrypt:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ *
+ * Decrypts @node and if necessary replaces @node with decrypted data.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxDecrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    xmlSecBufferPtr buffer;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    /* decrypt */
+    buffer = xmlSecEncCtxDecryptToBuffer(encCtx, node);
+    if(buffer == NULL) {
+        xmlSecInternalError("xmlSecEncCtxDecryptToBuffer", NULL);
+        return(-1);
+    }
+
+    /* replace original node if requested */
+    if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncElement)) {
+        /* check if we need to return the replaced node */
+        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
+                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        } else {
+                ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        }
+
+        encCtx->resultReplaced = 1;
+    } else if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncContent)) {
+        /* replace the node with the buffer */
+
+        /* check if we need to return the replaced node */
+        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
+                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        } else {
+            ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        }
+        encCtx->resultReplaced = 1;
+    }
+
+    return(0);
+}
+
+/**
+ * xmlSecEncCtxDecryptToBuffer:
+ * @encCtx:             the pointer to encryption processing context.
+ * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ *
+ * Decrypts @node data to the result.
+ *
+ * Returns: a buffer with key on success or NULL if an error occurs.
+ */
+xmlSecBufferPtr
+xmlSecEncCtxDecryptToBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    xmlSecBufferPtr res = NULL;
+    xmlChar* data = NULL;
+    xmlSecTraceSpan span;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, NULL);
+    xmlSecAssert2(encCtx->result == NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeEncDecrypt, encCtx, NULL, &(encCtx->transformCtx));
+
+    /* initialize context and add ID atributes to the list of known ids */
+    encCtx->operation = xmlSecTransformOperationDecrypt;
+    xmlSecAddIDs(node->doc, node, xmlSecEncIds);
+
+    ret = xmlSecEncCtxArenaPrepare(encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxArenaPrepare", NULL);
+        goto done;
+    }
+
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        goto done;
+    }
+
+    /* decrypt the data */
+    if(encCtx->cipherValueNode != NULL) {
+        data = xmlNodeGetContent(encCtx->cipherValueNode);
+        if(data == NULL) {
+            xmlSecInvalidNodeContentError(encCtx->cipherValueNode, NULL, "empty");
+            goto done;
+        }
+
+        ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, xmlSecStrlen(data));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxBinaryExecute", NULL);
+            goto done;
+        }
+    } else {
+        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            goto done;
+        }
+    }
+
+    /* success  */
+    encCtx->result = encCtx->transformCtx.result;
+    if(encCtx->result == NULL) {
+        xmlSecInvalidDataError("the transforms chain has no result", NULL);
+        goto done;
+    }
+    res = encCtx->result;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecEncCtxGetTraceSize(encCtx, &span), (res != NULL) ? 0 : -1);
+    if(data != NULL) {
+        xmlFree(data);
+    }
+    return(res);
+}
+
+/**************************************************************************
+ *
+ * Decrypt all the &lt;enc:EncryptedData/&gt; elements: the keys are resolved
+ * and the &lt;enc:CipherReference/&gt; elements are processed in the current
+ * thread because both might touch the document or the keys manager. The
+ * &lt;enc:CipherValue/&gt; payloads only use the per-element transforms and
+ * are decrypted in parallel.
+ *
+ *************************************************************************/
+typedef struct _xmlSecEncCtxDecryptAllItem {
+    xmlNodePtr                  node;
+    xmlSecEncCtxPtr             encCtx;
+    xmlChar*                    data;           /* the <enc:CipherValue/> content */
+    int                         status;         /* 0 - pending, 1 - done, -1 - failed */
+    xmlNodePtr                  results;        /* the parsed decrypted data */
+} xmlSecEncCtxDecryptAllItem, *xmlSecEncCtxDecryptAllItemPtr;
+
+typedef struct _xmlSecEncCtxDecryptAllJob {
+    xmlSecEncCtxDecryptAllItemPtr items;
+    xmlSecSize                  itemsSize;
+    volatile int                next;           /* the number of the items taken by workers */
+} xmlSecEncCtxDecryptAllJob, *xmlSecEncCtxDecryptAllJobPtr;
+
+static int
+xmlSecEncCtxDecryptAllCheckType(xmlNodePtr node) {
+    xmlChar* type;
+    int res;
+
+    xmlSecAssert2(node != NULL, 0);
+
+    /* the binary data can't replace the node */
+    type = xmlGetProp(node, xmlSecAttrType);
+    res = (type != NULL) && (xmlStrEqual(type, xmlSecTypeEncElement) || xmlStrEqual(type, xmlSecTypeEncContent));
+    if(type != NULL) {
+        xmlFree(type);
+    }
+    return(res);
+}
+
+/* finds the elements to decrypt (skipping the nested ones), fills @items if not NULL */
+static xmlSecSize
+xmlSecEncCtxDecryptAllFind(xmlNodePtr node, xmlSecEncCtxDecryptAllItemPtr items, xmlSecSize pos) {
+    xmlNodePtr cur;
+
+    xmlSecAssert2(node != NULL, pos);
+
+    if(xmlSecCheckNodeName(node, xmlSecNodeEncryptedData, xmlSecEncNs)) {
+        if(xmlSecEncCtxDecryptAllCheckType(node) != 0) {
+            if(items != NULL) {
+                items[pos].node = node;
+            }
+            ++pos;
+        }
+        return(pos);
+    }
+
+    for(cur = xmlSecGetNextElementNode(node->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        pos = xmlSecEncCtxDecryptAllFind(cur, items, pos);
+    }
+    return(pos);
+}
+
+static int
+xmlSecEncCtxDecryptAllPrepare(xmlSecEncCtxPtr encCtx, xmlSecEncCtxDecryptAllItemPtr item,
+                              xmlSecPtrListPtr encryptedKeys) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->node != NULL, -1);
+    xmlSecAssert2(item->encCtx == NULL, -1);
+    xmlSecAssert2(encryptedKeys != NULL, -1);
+
+    item->encCtx = xmlSecEncCtxCreate(encCtx->keyInfoReadCtx.keysMngr);
+    if(item->encCtx == NULL) {
+        xmlSecInternalError("xmlSecEncCtxCreate", NULL);
+        return(-1);
+    }
+    ret = xmlSecEncCtxCopyUserPref(item->encCtx, encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxCopyUserPref", NULL);
+        return(-1);
+    }
+    item->encCtx->keyInfoReadCtx.encryptedKeys = encryptedKeys;
+
+    if(encCtx->encKey != NULL) {
+        item->encCtx->encKey = xmlSecKeyDuplicate(encCtx->encKey);
+        if(item->encCtx->encKey == NULL) {
+            xmlSecInternalError("xmlSecKeyDuplicate", NULL);
+            return(-1);
+        }
+    }
+
+    item->encCtx->operation = xmlSecTransformOperationDecrypt;
+    ret = xmlSecEncCtxArenaPrepare(item->encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxArenaPrepare", NULL);
+        return(-1);
+    }
+
+    ret = xmlSecEncCtxEncDataNodeRead(item->encCtx, item->node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        return(-1);
+    }
+
+    if(item->encCtx->cipherValueNode != NULL) {
+        item->data = xmlNodeGetContent(item->encCtx->cipherValueNode);
+        if(item->data == NULL) {
+            xmlSecInvalidNodeContentError(item->encCtx->cipherValueNode, NULL, "empty");
+            return(-1);
+        }
+    } else {
+        ret = xmlSecTransformCtxExecute(&(item->encCtx->transformCtx), item->node->doc);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            return(-1);
+        }
+        item->status = 1;
+    }
+    return(0);
+}
+
+static void
+xmlSecEncCtxDecryptAllWorker(void* data) {
+    xmlSecEncCtxDecryptAllJobPtr job = (xmlSecEncCtxDecryptAllJobPtr)data;
+    xmlSecEncCtxDecryptAllItemPtr item;
+    xmlSecSize pos;
+    int next, ret;
+
+    xmlSecAssert(job != NULL);
+    xmlSecAssert(job->items != NULL);
+
+    while(1) {
+        /* grab the next item */
+        next = xmlSecAtomicIntIncrement(&(job->next));
+        XMLSEC_SAFE_CAST_INT_TO_SIZE(next, pos, return, NULL);
+        if((pos == 0) || (pos > job->itemsSize)) {
+            break;
+        }
+        item = &(job->items[pos - 1]);
+        if(item->status != 0) {
+            continue;
+        }
+        xmlSecAssert(item->encCtx != NULL);
+        xmlSecAssert(item->data != NULL);
+
+        ret = xmlSecTransformCtxBinaryExecute(&(item->encCtx->transformCtx), item->data, xmlSecStrlen(item->data));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxBinaryExecute", NULL);
+            item->status = -1;
+            continue;
+        }
+        item->status = 1;
+    }
+}
+
+static int
+xmlSecEncCtxDecryptAllRun(xmlSecEncCtxDecryptAllJobPtr job, xmlSecSize maxThreads) {
+    xmlSecThreadPtr* threads = NULL;
+    xmlSecSize ii, pending, threadsNum;
+    int ret;
+    int res = 0;
+
+    xmlSecAssert2(job != NULL, -1);
+    xmlSecAssert2(maxThreads > 0, -1);
+
+    for(ii = pending = 0; ii < job->itemsSize; ++ii) {
+        if(job->items[ii].status == 0) {
+            ++pending;
+        }
+    }
+    if(pending == 0) {
+        return(0);
+    }
+
+    /* the current thread is a worker too */
+    threadsNum = (pending < maxThreads) ? pending : maxThreads;
+    if((threadsNum > 1) && (xmlSecThreadsEnabled() != 0)) {
+        threads = (xmlSecThreadPtr*)xmlMalloc(sizeof(xmlSecThreadPtr) * (threadsNum - 1));
+        if(threads == NULL) {
+            xmlSecMallocError(sizeof(xmlSecThreadPtr) * (threadsNum - 1), NULL);
+            return(-1);
+        }
+        memset(threads, 0, sizeof(xmlSecThreadPtr) * (threadsNum - 1));
+
+        for(ii = 0; ii < threadsNum - 1; ++ii) {
+            /* if we can't start a thread then the remaining workers do the job */
+            threads[ii] = xmlSecThreadCreate(xmlSecEncCtxDecryptAllWorker, job);
+            if(threads[ii] == NULL) {
+                break;
+            }
+        }
+    }
+
+    xmlSecEncCtxDecryptAllWorker(job);
+
+    if(threads != NULL) {
+        for(ii = 0; (ii < threadsNum - 1) && (threads[ii] != NULL); ++ii) {
+            ret = xmlSecThreadJoin(threads[ii]);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecThreadJoin", NULL);
+                res = -1;
+            }
+        }
+        xmlFree(threads);
+    }
+    return(res);
+}
+
+/* parses the decrypted data in the context of the node's parent, the document is not changed */
+static int
+xmlSecEncCtxDecryptAllParse(xmlSecEncCtxDecryptAllItemPtr item) {
+    xmlSecBufferPtr result;
+    const xmlChar *oldenc;
+    int len;
+    xmlParserErrors ret;
+
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->node != NULL, -1);
+    xmlSecAssert2(item->node->parent != NULL, -1);
+    xmlSecAssert2(item->encCtx != NULL, -1);
+    xmlSecAssert2(item->results == NULL, -1);
+
+    result = item->encCtx->transformCtx.result;
+    xmlSecAssert2(result != NULL, -1);
+
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(xmlSecBufferGetSize(result), len, return(-1), NULL);
+    oldenc = item->node->doc->encoding;
+    item->node->doc->encoding = NULL;
+    ret = xmlParseInNodeContext(item->node->parent, (const char*)xmlSecBufferGetData(result), len,
+            xmlSecParserGetDefaultOptions(), &(item->results));
+    item->node->doc->encoding = oldenc;
+    if(ret != XML_ERR_OK) {
+        xmlSecXmlError("xmlParseInNodeContext", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/* replaces the node with the parsed data, returns the unlinked node */
+static xmlNodePtr
+xmlSecEncCtxDecryptAllSplice(xmlSecEncCtxDecryptAllItemPtr item) {
+    xmlNodePtr next;
+
+    xmlSecAssert2(item != NULL, NULL);
+    xmlSecAssert2(item->node != NULL, NULL);
+
+    while(item->results != NULL) {
+        next = item->results->next;
+        xmlAddPrevSibling(item->node, item->results);
+        item->results = next;
+    }
+    xmlUnlinkNode(item->node);
+    return(item->node);
+}
+
+/* returns the number of bytes fed to the encryption methods */
+static xmlSecSize
+xmlSecEncCtxDecryptAllGetTraceSize(xmlSecEncCtxDecryptAllJobPtr job, xmlSecTraceSpanPtr span) {
+    xmlSecSize ii, size = 0;
+
+    xmlSecAssert2(job != NULL, 0);
+    xmlSecAssert2(span != NULL, 0);
+
+    for(ii = 0; (job->items != NULL) && (ii < job->itemsSize); ++ii) {
+        if(job->items[ii].encCtx != NULL) {
+            size += xmlSecEncCtxGetTraceSize(job->items[ii].encCtx, span);
+        }
+    }
+    return(size);
+}
+
+/**
+ * xmlSecEncCtxDecryptAll:
+ * @encCtx:             the pointer to encryption processing context.
+ * @node:               the pointer to the root of the subtree to decrypt.
+ * @maxThreads:         the max number of threads used to decrypt the data
+ *                      (0 to use #XMLSEC_ENC_DECRYPT_DEFAULT_THREADS).
+ *
+ * Decrypts all the &lt;enc:EncryptedData/&gt; elements with the Element or
+ * Content type under @node (including @node itself) and replaces them
+ * with the decrypted data. The &lt;enc:EncryptedKey/&gt; elements referenced
+ * by several &lt;enc:EncryptedData/&gt; elements are decrypted only once
+ * and the encrypted data are decrypted in parallel using up to @maxThreads
+ * threads (the current thread included). The decrypted data are parsed
+ * before the first element is replaced, thus the document is not changed
+ * if any of the elements can't be decrypted or parsed. The
+ * &lt;enc:EncryptedData/&gt; elements with other types are not touched.
+ *
+ * If the #XMLSEC_ENC_RETURN_REPLACED_NODE flag is set then the list of
+ * the replaced nodes (in the document order) is returned in the
+ * replacedNodeList member of @encCtx.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxDecryptAll(xmlSecEncCtxPtr encCtx, xmlNodePtr node, xmlSecSize maxThreads) {
+    xmlSecEncCtxDecryptAllJob job;
+    xmlSecEncCtxDecryptAllItemPtr item;
+    xmlSecPtrList encryptedKeys;
+    xmlNodePtr replaced, last = NULL;
+    xmlSecSize ii, size;
+    xmlSecTraceSpan span;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(encCtx->mode == xmlEncCtxModeEncryptedData, -1);
+    xmlSecAssert2(encCtx->replacedNodeList == NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    memset(&job, 0, sizeof(job));
+    ret = xmlSecPtrListInitialize(&encryptedKeys, xmlSecKeyInfoEncryptedKeyCacheId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        return(-1);
+    }
+
+    /* the per-element contexts copy the stats flag from encCtx */
+    XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeEncDecrypt, encCtx, NULL, &(encCtx->transformCtx));
+
+    /* initialize context and add ID atributes to the list of known ids */
+    encCtx->operation = xmlSecTransformOperationDecrypt;
+    xmlSecAddIDs(node->doc, node, xmlSecEncIds);
+
+    /* find the elements */
+    size = xmlSecEncCtxDecryptAllFind(node, NULL, 0);
+    if(size == 0) {
+        res = 0;
+        goto done;
+    }
+    job.items = (xmlSecEncCtxDecryptAllItemPtr)xmlMalloc(sizeof(xmlSecEncCtxDecryptAllItem) * size);
+    if(job.items == NULL) {
+        xmlSecMallocError(sizeof(xmlSecEncCtxDecryptAllItem) * size, NULL);
+        goto done;
+    }
+    memset(job.items, 0, sizeof(xmlSecEncCtxDecryptAllItem) * size);
+    job.itemsSize = size;
+    xmlSecEncCtxDecryptAllFind(node, job.items, 0);
+
+    /* resolve the keys (use the application cache if any) */
+    for(ii = 0; ii < size; ++ii) {
+        item = &(job.items[ii]);
+        ret = xmlSecEncCtxDecryptAllPrepare(encCtx, item,
+            (encCtx->keyInfoReadCtx.encryptedKeys != NULL) ? encCtx->keyInfoReadCtx.encryptedKeys : &encryptedKeys);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecEncCtxDecryptAllPrepare", NULL,
+                "node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(item->node)));
+            if(item->encCtx != NULL) {
+                encCtx->failureReason = item->encCtx->failureReason;
+            }
+            goto done;
+        }
+    }
+
+    /* decrypt the data */
+    ret = xmlSecEncCtxDecryptAllRun(&job, (maxThreads > 0) ? maxThreads : XMLSEC_ENC_DECRYPT_DEFAULT_THREADS);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxDecryptAllRun", NULL);
+        goto done;
+    }
+    for(ii = 0; ii < size; ++ii) {
+        item = &(job.items[ii]);
+        if((item->status != 1) || (item->encCtx->transformCtx.result == NULL)) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "failed to decrypt node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(item->node)));
+            encCtx->failureReason = item->encCtx->failureReason;
+            goto done;
+        }
+    }
+
+    /* parse all the results first so a bad result leaves the document intact */
+    for(ii = 0; ii < size; ++ii) {
+        item = &(job.items[ii]);
+        ret = xmlSecEncCtxDecryptAllParse(item);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecEncCtxDecryptAllParse", xmlSecNodeGetName(item->node));
+            goto done;
+        }
+    }
+
+    /* and replace the nodes, this can't fail */
+    for(ii = 0; ii < size; ++ii) {
+        item = &(job.items[ii]);
+        replaced = xmlSecEncCtxDecryptAllSplice(item);
+        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
+            /* chain the replaced nodes */
+            if(last != NULL) {
+                last->next = replaced;
+                replaced->prev = last;
+            } else {
+                encCtx->replacedNodeList = replaced;
+            }
+            last = replaced;
+        } else {
+            xmlFreeNode(replaced);
+        }
+        item->node = NULL;
+        encCtx->resultReplaced = 1;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    XMLSEC_TRACE_SPAN_END(&span, xmlSecEncCtxDecryptAllGetTraceSize(&job, &span), res);
+    if(job.items != NULL) {
+        for(ii = 0; ii < job.itemsSize; ++ii) {
+            item = &(job.items[ii]);
+            if(item->encCtx != NULL) {
+                xmlSecEncCtxDestroy(item->encCtx);
+            }
+            if(item->data != NULL) {
+                xmlFree(item->data);
+            }
+            if(item->results != NULL) {
+                xmlFreeNodeList(item->results);
+            }
+        }
+        xmlFree(job.items);
+    }
+    xmlSecPtrListFinalize(&encryptedKeys);
+    return(res);
+}
+
+/* returns the number of bytes fed to the encryption method */
+static xmlSecSize
+xmlSecEncCtxGetTraceSize(xmlSecEncCtxPtr encCtx, xmlSecTraceSpanPtr span) {
+    xmlSecAssert2(encCtx != NULL, 0);
+    xmlSecAssert2(span != NULL, 0);
+
+    if(encCtx->encMethod == NULL) {
+        return(0);
+    }
+    span->href = encCtx->encMethod->id->href;
+    return(xmlSecTransformGetStats(encCtx->encMethod)->bytesIn);
+}
+
+static int
+xmlSecEncCtxEncDataNodeRead(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    xmlNodePtr cur;
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
@@ -782,8 +1843,12 @@ xmlSecEncCtxEncDataNodeRead(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
     /* TODO: KeyInfo node != NULL and encKey != NULL */
     if((encCtx->encKey == NULL) && (encCtx->keyInfoReadCtx.keysMngr != NULL)
                         && (encCtx->keyInfoReadCtx.keysMngr->getKey != NULL)) {
+        xmlSecTraceSpan span;
+
+        XMLSEC_TRACE_SPAN_START(&span, xmlSecTraceSpanTypeKeyLookup, &(encCtx->keyInfoReadCtx), NULL, NULL);
         encCtx->encKey = (encCtx->keyInfoReadCtx.keysMngr->getKey)(encCtx->keyInfoNode,
                                                              &(encCtx->keyInfoReadCtx));
+        XMLSEC_TRACE_SPAN_END_KEY_LOOKUP(&span, encCtx->encKey);
     }
 
     /* check that we have exactly what we want */
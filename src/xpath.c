@@ -30,6 +30,7 @@
 #include <xmlsec/errors.h>
 
 #include "cast_helpers.h"
+#include "nodeset_helpers.h"
 
 /**************************************************************************
  *
@@ -62,15 +63,30 @@ typedef struct _xmlSecXPathData                 xmlSecXPathData,
 typedef enum {
     xmlSecXPathDataTypeXPath,
     xmlSecXPathDataTypeXPath2,
-    xmlSecXPathDataTypeXPointer
+    xmlSecXPathDataTypeXPointer,
+    xmlSecXPathDataTypeXPathFilter
 } xmlSecXPathDataType;
 
+/* the XPath filter expressions we evaluate without XPath engine */
+typedef enum {
+    xmlSecXPathFilterTypeGeneric = 0,       /* anything else: evaluate the expression per node */
+    xmlSecXPathFilterTypeAncestorOrSelf,    /* ancestor-or-self::ns:name */
+    xmlSecXPathFilterTypeNotAncestorOrSelf, /* not(ancestor-or-self::ns:name) */
+    xmlSecXPathFilterTypeNotHereAncestor    /* count(ancestor-or-self::ns:name | here()/ancestor::ns:name[1]) >
+                                               count(ancestor-or-self::ns:name) */
+} xmlSecXPathFilterType;
+
 struct _xmlSecXPathData {
     xmlSecXPathDataType                 type;
     xmlXPathContextPtr                  ctx;
     xmlChar*                            expr;
     xmlSecNodeSetOp                     nodeSetOp;
     xmlSecNodeSetType                   nodeSetType;
+
+    /* XPath filter only */
+    xmlSecXPathFilterType               filterType;
+    xmlChar*                            filterName;
+    xmlChar*                            filterNs;
 };
 
 static xmlSecXPathDataPtr       xmlSecXPathDataCreate           (xmlSecXPathDataType type);
@@ -81,9 +97,21 @@ static int                      xmlSecXPathDataRegisterNamespaces(xmlSecXPathDat
                                                                  xmlNodePtr node);
 static int                      xmlSecXPathDataNodeRead         (xmlSecXPathDataPtr data,
                                                                  xmlNodePtr node);
-static xmlSecNodeSetPtr         xmlSecXPathDataExecute          (xmlSecXPathDataPtr data,
+static void                     xmlSecXPathDataSetDoc           (xmlSecXPathDataPtr data,
+                                                                 xmlDocPtr doc,
+                                                                 xmlNodePtr hereNode);
+static xmlXPathObjectPtr        xmlSecXPathDataEval             (xmlSecXPathDataPtr data,
                                                                  xmlDocPtr doc,
                                                                  xmlNodePtr hereNode);
+static xmlSecNodeSetPtr         xmlSecXPathDataExecute          (xmlSecXPathDataPtr data,
+                                                                 xmlDocPtr doc,
+                                                                 xmlNodePtr hereNode,
+                                                                 xmlSecNodeSetPtr inNodes);
+static int                      xmlSecXPathDataFilterParse      (xmlSecXPathDataPtr data);
+static xmlSecNodeSetPtr         xmlSecXPathDataFilterExecute    (xmlSecXPathDataPtr data,
+                                                                 xmlDocPtr doc,
+                                                                 xmlNodePtr hereNode,
+                                                                 xmlSecNodeSetPtr inNodes);
 
 static xmlSecXPathDataPtr
 xmlSecXPathDataCreate(xmlSecXPathDataType type) {
@@ -103,6 +131,7 @@ xmlSecXPathDataCreate(xmlSecXPathDataType type) {
     switch(data->type) {
     case xmlSecXPathDataTypeXPath:
     case xmlSecXPathDataTypeXPath2:
+    case xmlSecXPathDataTypeXPathFilter:
         data->ctx = xmlXPathNewContext(NULL); /* we'll set doc in the context later */
         if(data->ctx == NULL) {
             xmlSecXmlError("xmlXPathNewContext", NULL);
@@ -130,6 +159,12 @@ xmlSecXPathDataDestroy(xmlSecXPathDataPtr data) {
     if(data->expr != NULL) {
         xmlFree(data->expr);
     }
+    if(data->filterName != NULL) {
+        xmlFree(data->filterName);
+    }
+    if(data->filterNs != NULL) {
+        xmlFree(data->filterNs);
+    }
     if(data->ctx != NULL) {
         xmlXPathFreeContext(data->ctx);
     }
@@ -206,16 +241,12 @@ xmlSecXPathDataNodeRead(xmlSecXPathDataPtr data, xmlNodePtr node) {
     return(0);
 }
 
-static xmlSecNodeSetPtr
-xmlSecXPathDataExecute(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNode) {
-    xmlXPathObjectPtr xpathObj = NULL;
-    xmlSecNodeSetPtr nodes;
-
-    xmlSecAssert2(data != NULL, NULL);
-    xmlSecAssert2(data->expr != NULL, NULL);
-    xmlSecAssert2(data->ctx != NULL, NULL);
-    xmlSecAssert2(doc != NULL, NULL);
-    xmlSecAssert2(hereNode != NULL, NULL);
+static void
+xmlSecXPathDataSetDoc(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNode) {
+    xmlSecAssert(data != NULL);
+    xmlSecAssert(data->ctx != NULL);
+    xmlSecAssert(doc != NULL);
+    xmlSecAssert(hereNode != NULL);
 
     /* do not forget to set the doc */
     data->ctx->doc = doc;
@@ -226,6 +257,19 @@ xmlSecXPathDataExecute(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNo
         data->ctx->here = hereNode;
         data->ctx->xptr = 1;
     }
+}
+
+static xmlXPathObjectPtr
+xmlSecXPathDataEval(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNode) {
+    xmlXPathObjectPtr xpathObj = NULL;
+
+    xmlSecAssert2(data != NULL, NULL);
+    xmlSecAssert2(data->expr != NULL, NULL);
+    xmlSecAssert2(data->ctx != NULL, NULL);
+    xmlSecAssert2(doc != NULL, NULL);
+    xmlSecAssert2(hereNode != NULL, NULL);
+
+    xmlSecXPathDataSetDoc(data, doc, hereNode);
 
     /* execute xpath or xpointer expression */
     switch(data->type) {
@@ -263,6 +307,28 @@ xmlSecXPathDataExecute(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNo
             return(NULL);
         }
     }
+    return(xpathObj);
+}
+
+static xmlSecNodeSetPtr
+xmlSecXPathDataExecute(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNode,
+                       xmlSecNodeSetPtr inNodes) {
+    xmlXPathObjectPtr xpathObj;
+    xmlSecNodeSetPtr nodes;
+
+    xmlSecAssert2(data != NULL, NULL);
+    xmlSecAssert2(doc != NULL, NULL);
+    xmlSecAssert2(hereNode != NULL, NULL);
+
+    if(data->type == xmlSecXPathDataTypeXPathFilter) {
+        return(xmlSecXPathDataFilterExecute(data, doc, hereNode, inNodes));
+    }
+
+    xpathObj = xmlSecXPathDataEval(data, doc, hereNode);
+    if(xpathObj == NULL) {
+        xmlSecInternalError("xmlSecXPathDataEval", NULL);
+        return(NULL);
+    }
 
     nodes = xmlSecNodeSetCreate(doc, xpathObj->nodesetval, data->nodeSetType);
     if(nodes == NULL) {
@@ -278,6 +344,467 @@ xmlSecXPathDataExecute(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNo
 }
 
 
+/**************************************************************************
+ *
+ * XPath filter (http://www.w3.org/TR/xmldsig-core/#sec-XPath)
+ *
+ * The filter expression is evaluated for each node in the input nodes set
+ * with the node as the context node and context position/size set to 1.
+ * Instead of building "(//. | //@* | //namespace::*)[boolean(expr)]" (that
+ * copies every namespace node of every element in the document) we walk
+ * the document once and evaluate the compiled expression per node. The
+ * result is a bitmap over the nodes index (see nodeset_helpers.h).
+ *
+ * The most common filters ("not(ancestor-or-self::dsig:Signature)" and
+ * the here() based enveloped signature form) do not need XPath at all:
+ * the result is the subtree (or everything except the subtree) of the
+ * matching elements, i.e. the xmlSecNodeSetTree or xmlSecNodeSetTreeInvert
+ * nodes set.
+ *
+ *****************************************************************************/
+#define XMLSEC_XPATH_FILTER_ANCESTOR_OR_SELF    "ancestor-or-self::"
+#define XMLSEC_XPATH_FILTER_NOT_ANCESTOR        "not(ancestor-or-self::"
+#define XMLSEC_XPATH_FILTER_COUNT_ANCESTOR      "count(ancestor-or-self::"
+#define XMLSEC_XPATH_FILTER_HERE_ANCESTOR       "|here()/ancestor::"
+#define XMLSEC_XPATH_FILTER_HERE_ANCESTOR_END   "[1])>count(ancestor-or-self::"
+
+static int
+xmlSecXPathFilterIsBlank(xmlChar ch) {
+    return((ch == ' ') || (ch == '\t') || (ch == '\n') || (ch == '\r'));
+}
+
+static int
+xmlSecXPathFilterIsDelimiter(xmlChar ch) {
+    return((ch == '(') || (ch == ')') || (ch == '[') || (ch == ']') ||
+           (ch == '|') || (ch == '/') || (ch == '>'));
+}
+
+/* removes the blanks next to the delimiters (but not "a - b" => "a-b") */
+static xmlChar*
+xmlSecXPathFilterNormalize(const xmlChar* expr) {
+    const xmlChar* p;
+    const xmlChar* next;
+    xmlChar* res;
+    xmlChar* q;
+
+    xmlSecAssert2(expr != NULL, NULL);
+
+    res = xmlStrdup(expr);
+    if(res == NULL) {
+        xmlSecStrdupError(expr, NULL);
+        return(NULL);
+    }
+    for(p = expr, q = res; (*p) != '\0'; ) {
+        if(!xmlSecXPathFilterIsBlank(*p)) {
+            *(q++) = *(p++);
+            continue;
+        }
+        for(next = p; xmlSecXPathFilterIsBlank(*next); ++next);
+        if((q != res) && ((*next) != '\0') &&
+           !xmlSecXPathFilterIsDelimiter(*(q - 1)) &&
+           !xmlSecXPathFilterIsDelimiter(*next))
+        {
+            *(q++) = ' ';
+        }
+        p = next;
+    }
+    (*q) = '\0';
+    return(res);
+}
+
+/* returns pointer after @str if @p starts with @str or NULL */
+static const xmlChar*
+xmlSecXPathFilterSkip(const xmlChar* p, const char* str) {
+    int len;
+
+    if(p == NULL) {
+        return(NULL);
+    }
+    len = xmlStrlen(BAD_CAST str);
+    if(xmlStrncmp(p, BAD_CAST str, len) != 0) {
+        return(NULL);
+    }
+    return(p + len);
+}
+
+/* returns pointer after @qname if @p starts with @qname or NULL */
+static const xmlChar*
+xmlSecXPathFilterSkipQName(const xmlChar* p, const xmlChar* qname) {
+    int len;
+
+    if(p == NULL) {
+        return(NULL);
+    }
+    len = xmlStrlen(qname);
+    if((xmlStrncmp(p, qname, len) != 0) || (p[len] == '\0') || !xmlSecXPathFilterIsDelimiter(p[len])) {
+        return(NULL);
+    }
+    return(p + len);
+}
+
+static int
+xmlSecXPathDataFilterSetName(xmlSecXPathDataPtr data, const xmlChar* qname) {
+    const xmlChar* href = NULL;
+    xmlChar* prefix = NULL;
+    xmlChar* name;
+
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(data->ctx != NULL, -1);
+    xmlSecAssert2(data->filterName == NULL, -1);
+    xmlSecAssert2(data->filterNs == NULL, -1);
+    xmlSecAssert2(qname != NULL, -1);
+
+    /* anything unusual (e.g. "*" or "node()") goes to the XPath engine */
+    if(xmlValidateQName(qname, 0) != 0) {
+        return(0);
+    }
+
+    name = xmlSplitQName2(qname, &prefix);
+    if(name == NULL) {
+        name = xmlStrdup(qname);
+        if(name == NULL) {
+            xmlSecStrdupError(qname, NULL);
+            return(-1);
+        }
+    }
+    if(prefix != NULL) {
+        /* unknown prefix is reported by XPath engine */
+        href = xmlXPathNsLookup(data->ctx, prefix);
+        xmlFree(prefix);
+        if(href == NULL) {
+            xmlFree(name);
+            return(0);
+        }
+        data->filterNs = xmlStrdup(href);
+        if(data->filterNs == NULL) {
+            xmlSecStrdupError(href, NULL);
+            xmlFree(name);
+            return(-1);
+        }
+    }
+    data->filterName = name;
+    return(1);
+}
+
+static int
+xmlSecXPathDataFilterParse(xmlSecXPathDataPtr data) {
+    xmlSecXPathFilterType filterType = xmlSecXPathFilterTypeGeneric;
+    xmlChar* expr;
+    xmlChar* qname = NULL;
+    const xmlChar* p;
+    const xmlChar* end;
+    int qnameLen;
+    int ret;
+
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(data->expr != NULL, -1);
+    xmlSecAssert2(data->filterType == xmlSecXPathFilterTypeGeneric, -1);
+
+    expr = xmlSecXPathFilterNormalize(data->expr);
+    if(expr == NULL) {
+        xmlSecInternalError("xmlSecXPathFilterNormalize", NULL);
+        return(-1);
+    }
+
+    /* find the element qname and the filter type */
+    if((p = xmlSecXPathFilterSkip(expr, XMLSEC_XPATH_FILTER_NOT_ANCESTOR)) != NULL) {
+        filterType = xmlSecXPathFilterTypeNotAncestorOrSelf;
+    } else if((p = xmlSecXPathFilterSkip(expr, XMLSEC_XPATH_FILTER_COUNT_ANCESTOR)) != NULL) {
+        filterType = xmlSecXPathFilterTypeNotHereAncestor;
+    } else if((p = xmlSecXPathFilterSkip(expr, XMLSEC_XPATH_FILTER_ANCESTOR_OR_SELF)) != NULL) {
+        filterType = xmlSecXPathFilterTypeAncestorOrSelf;
+    } else {
+        xmlFree(expr);
+        return(0);
+    }
+    for(end = p; ((*end) != '\0') && !xmlSecXPathFilterIsDelimiter(*end); ++end);
+    XMLSEC_SAFE_CAST_PTRDIFF_TO_INT((end - p), qnameLen, xmlFree(expr); return(-1), NULL);
+    if(qnameLen <= 0) {
+        xmlFree(expr);
+        return(0);
+    }
+    qname = xmlStrndup(p, qnameLen);
+    if(qname == NULL) {
+        xmlSecStrdupError(p, NULL);
+        xmlFree(expr);
+        return(-1);
+    }
+
+    /* check the rest of the expression */
+    switch(filterType) {
+    case xmlSecXPathFilterTypeAncestorOrSelf:
+        break;
+    case xmlSecXPathFilterTypeNotAncestorOrSelf:
+        end = xmlSecXPathFilterSkip(end, ")");
+        break;
+    case xmlSecXPathFilterTypeNotHereAncestor:
+        end = xmlSecXPathFilterSkip(end, XMLSEC_XPATH_FILTER_HERE_ANCESTOR);
+        end = xmlSecXPathFilterSkipQName(end, qname);
+        end = xmlSecXPathFilterSkip(end, XMLSEC_XPATH_FILTER_HERE_ANCESTOR_END);
+        end = xmlSecXPathFilterSkip(end, (const char*)qname);
+        end = xmlSecXPathFilterSkip(end, ")");
+        break;
+    default:
+        xmlSecUnsupportedEnumValueError("filterType", filterType, NULL);
+        xmlFree(qname);
+        xmlFree(expr);
+        return(-1);
+    }
+    if((end == NULL) || ((*end) != '\0')) {
+        xmlFree(qname);
+        xmlFree(expr);
+        return(0);
+    }
+
+    ret = xmlSecXPathDataFilterSetName(data, qname);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecXPathDataFilterSetName", NULL);
+        xmlFree(qname);
+        xmlFree(expr);
+        return(-1);
+    }
+    if(ret > 0) {
+        data->filterType = filterType;
+    }
+
+    xmlFree(qname);
+    xmlFree(expr);
+    return(0);
+}
+
+static int
+xmlSecXPathDataFilterIsMatch(xmlSecXPathDataPtr data, xmlNodePtr cur) {
+    xmlSecAssert2(data != NULL, 0);
+    xmlSecAssert2(data->filterName != NULL, 0);
+    xmlSecAssert2(cur != NULL, 0);
+
+    return((cur->type == XML_ELEMENT_NODE) &&
+           xmlSecCheckNodeName(cur, data->filterName, data->filterNs));
+}
+
+/* adds the top most elements that match the filter name */
+static int
+xmlSecXPathDataFilterCollect(xmlSecXPathDataPtr data, xmlNodePtr cur, xmlNodeSetPtr res) {
+    int ret;
+
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(res != NULL, -1);
+
+    for(; cur != NULL; cur = cur->next) {
+        if(cur->type != XML_ELEMENT_NODE) {
+            continue;
+        }
+        if(xmlSecXPathDataFilterIsMatch(data, cur)) {
+            ret = xmlXPathNodeSetAdd(res, cur);
+            if(ret < 0) {
+                xmlSecXmlError("xmlXPathNodeSetAdd", NULL);
+                return(-1);
+            }
+            continue;
+        }
+        ret = xmlSecXPathDataFilterCollect(data, cur->children, res);
+        if(ret < 0) {
+            return(ret);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecXPathDataFilterEval(xmlSecXPathDataPtr data, xmlXPathCompExprPtr comp,
+                          xmlSecNodeSetPtr inNodes, xmlNodePtr node,
+                          xmlNodePtr parent, xmlNodePtr ctxNode) {
+    int ret;
+
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(data->ctx != NULL, -1);
+    xmlSecAssert2(comp != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(ctxNode != NULL, -1);
+
+    /* nodes that are not in the input are removed by intersection anyway */
+    if(inNodes != NULL) {
+        ret = xmlSecNodeSetContains(inNodes, node, parent);
+        if(ret <= 0) {
+            return(ret);
+        }
+    }
+
+    data->ctx->node = ctxNode;
+    data->ctx->proximityPosition = 1;
+    data->ctx->contextSize = 1;
+    ret = xmlXPathCompiledEvalToBoolean(comp, data->ctx);
+    data->ctx->node = NULL;
+    if(ret < 0) {
+        xmlSecXmlError2("xmlXPathCompiledEvalToBoolean", NULL,
+                        "expr=%s", xmlSecErrorsSafeString(data->expr));
+        return(-1);
+    }
+    return(ret);
+}
+
+/* evaluates the expression for each node in the nodes index, each node is visited once */
+static int
+xmlSecXPathDataFilterEvalAll(xmlSecXPathDataPtr data, xmlXPathCompExprPtr comp,
+                             xmlSecNodeSetPtr inNodes, xmlSecNodeSetPtr res) {
+    xmlSecNodeSetIndexPtr index;
+    xmlSecSize pos, size;
+    xmlNodePtr node, parent;
+    xmlNs nsNode;
+    int ret;
+
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(comp != NULL, -1);
+    xmlSecAssert2(res != NULL, -1);
+
+    index = xmlSecNodeSetBitmapGetIndex(res);
+    xmlSecAssert2(index != NULL, -1);
+
+    size = xmlSecNodeSetIndexGetSize(index);
+    for(pos = 0; pos < size; ++pos) {
+        node = xmlSecNodeSetIndexGetNode(index, pos, &parent);
+        if(node == NULL) {
+            xmlSecInternalError("xmlSecNodeSetIndexGetNode", NULL);
+            return(-1);
+        }
+
+        /* C14N never checks the document node */
+        if(node->type == XML_DOCUMENT_NODE) {
+            continue;
+        }
+        if(node->type != XML_NAMESPACE_DECL) {
+            ret = xmlSecXPathDataFilterEval(data, comp, inNodes, node, parent, node);
+        } else {
+            /* XPath namespace node is a copy of xmlNs with the parent element in next (see xpath.c) */
+            memcpy(&nsNode, node, sizeof(nsNode));
+            nsNode.next = (xmlNsPtr)parent;
+            ret = xmlSecXPathDataFilterEval(data, comp, inNodes, node, parent, (xmlNodePtr)&nsNode);
+        }
+        if(ret < 0) {
+            return(-1);
+        }
+        if(ret > 0) {
+            xmlSecNodeSetBitmapSet(res, pos);
+        }
+    }
+    return(0);
+}
+
+static xmlSecNodeSetPtr
+xmlSecXPathDataFilterExecute(xmlSecXPathDataPtr data, xmlDocPtr doc, xmlNodePtr hereNode,
+                             xmlSecNodeSetPtr inNodes) {
+    xmlSecXPathFilterType filterType;
+    xmlSecNodeSetIndexPtr index;
+    xmlXPathCompExprPtr comp;
+    xmlNodeSetPtr res;
+    xmlSecNodeSetPtr nodes;
+    xmlSecNodeSetType nodeSetType;
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(data != NULL, NULL);
+    xmlSecAssert2(data->type == xmlSecXPathDataTypeXPathFilter, NULL);
+    xmlSecAssert2(data->expr != NULL, NULL);
+    xmlSecAssert2(data->ctx != NULL, NULL);
+    xmlSecAssert2(doc != NULL, NULL);
+    xmlSecAssert2(hereNode != NULL, NULL);
+
+    xmlSecXPathDataSetDoc(data, doc, hereNode);
+
+    /* here() is available only for the same doc, let XPath engine report it */
+    filterType = data->filterType;
+    if((filterType == xmlSecXPathFilterTypeNotHereAncestor) && (hereNode->doc != doc)) {
+        filterType = xmlSecXPathFilterTypeGeneric;
+    }
+
+    /* evaluate the expression for each node */
+    if(filterType == xmlSecXPathFilterTypeGeneric) {
+        comp = xmlXPathCtxtCompile(data->ctx, data->expr);
+        if(comp == NULL) {
+            xmlSecXmlError2("xmlXPathCtxtCompile", NULL,
+                            "expr=%s", xmlSecErrorsSafeString(data->expr));
+            return(NULL);
+        }
+
+        index = xmlSecNodeSetIndexCreate(doc);
+        if(index == NULL) {
+            xmlSecInternalError("xmlSecNodeSetIndexCreate", NULL);
+            xmlXPathFreeCompExpr(comp);
+            return(NULL);
+        }
+        nodes = xmlSecNodeSetBitmapCreate(index);
+        if(nodes == NULL) {
+            xmlSecInternalError("xmlSecNodeSetBitmapCreate", NULL);
+            xmlSecNodeSetIndexDestroy(index);
+            xmlXPathFreeCompExpr(comp);
+            return(NULL);
+        }
+
+        ret = xmlSecXPathDataFilterEvalAll(data, comp, inNodes, nodes);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecXPathDataFilterEvalAll", NULL);
+            xmlSecNodeSetDestroy(nodes);
+            xmlXPathFreeCompExpr(comp);
+            return(NULL);
+        }
+        xmlXPathFreeCompExpr(comp);
+        return(nodes);
+    }
+
+    /* the subtrees of the matching elements */
+    res = xmlXPathNodeSetCreate(NULL);
+    if(res == NULL) {
+        xmlSecXmlError("xmlXPathNodeSetCreate", NULL);
+        return(NULL);
+    }
+
+    switch(filterType) {
+    case xmlSecXPathFilterTypeAncestorOrSelf:
+        ret = xmlSecXPathDataFilterCollect(data, doc->children, res);
+        nodeSetType = xmlSecNodeSetTree;
+        break;
+    case xmlSecXPathFilterTypeNotAncestorOrSelf:
+        ret = xmlSecXPathDataFilterCollect(data, doc->children, res);
+        nodeSetType = xmlSecNodeSetTreeInvert;
+        break;
+    case xmlSecXPathFilterTypeNotHereAncestor:
+        /* everything except here()/ancestor::ns:name[1] subtree (or nothing if there is no such ancestor) */
+        for(cur = hereNode->parent; cur != NULL; cur = cur->parent) {
+            if(xmlSecXPathDataFilterIsMatch(data, cur)) {
+                break;
+            }
+        }
+        ret = 0;
+        nodeSetType = xmlSecNodeSetNormal;
+        if(cur != NULL) {
+            ret = xmlXPathNodeSetAdd(res, cur);
+            if(ret < 0) {
+                xmlSecXmlError("xmlXPathNodeSetAdd", NULL);
+            }
+            nodeSetType = xmlSecNodeSetTreeInvert;
+        }
+        break;
+    default:
+        xmlSecUnsupportedEnumValueError("filterType", filterType, NULL);
+        xmlXPathFreeNodeSet(res);
+        return(NULL);
+    }
+    if(ret < 0) {
+        xmlSecInternalError("XPath filter evaluation", NULL);
+        xmlXPathFreeNodeSet(res);
+        return(NULL);
+    }
+
+    nodes = xmlSecNodeSetCreate(doc, res, nodeSetType);
+    if(nodes == NULL) {
+        xmlSecInternalError2("xmlSecNodeSetCreate", NULL,
+            "type=" XMLSEC_ENUM_FMT, XMLSEC_ENUM_CAST(nodeSetType));
+        xmlXPathFreeNodeSet(res);
+        return(NULL);
+    }
+    return(nodes);
+}
+
 /**************************************************************************
  *
  * XPath data list
@@ -304,6 +831,92 @@ xmlSecXPathDataListGetKlass(void) {
     return(&xmlSecXPathDataListKlass);
 }
 
+/*
+ * XPath2 filters: the input nodes set and each filter (the subtrees of the
+ * selected nodes) are combined as bitmaps over the nodes index, i.e. O(nodes)
+ * per filter instead of a chain of nodes sets that has to be checked for
+ * every node later.
+ */
+static xmlSecNodeSetPtr
+xmlSecXPathDataListExecuteBitmap(xmlSecPtrListPtr dataList, xmlDocPtr doc,
+                                 xmlNodePtr hereNode, xmlSecNodeSetPtr nodes) {
+    xmlSecXPathDataPtr data;
+    xmlSecNodeSetIndexPtr index;
+    xmlSecNodeSetPtr res;
+    xmlXPathObjectPtr xpathObj;
+    xmlNodePtr node, parent;
+    xmlSecSize pos, size;
+    int ret;
+
+    xmlSecAssert2(xmlSecPtrListCheckId(dataList, xmlSecXPathDataListId), NULL);
+    xmlSecAssert2(doc != NULL, NULL);
+    xmlSecAssert2(hereNode != NULL, NULL);
+
+    index = xmlSecNodeSetIndexCreate(doc);
+    if(index == NULL) {
+        xmlSecInternalError("xmlSecNodeSetIndexCreate", NULL);
+        return(NULL);
+    }
+    res = xmlSecNodeSetBitmapCreate(index);
+    if(res == NULL) {
+        xmlSecInternalError("xmlSecNodeSetBitmapCreate", NULL);
+        xmlSecNodeSetIndexDestroy(index);
+        return(NULL);
+    }
+
+    /* start with the input nodes set (all nodes if there is no input) */
+    size = xmlSecNodeSetIndexGetSize(index);
+    for(pos = 0; pos < size; ++pos) {
+        node = xmlSecNodeSetIndexGetNode(index, pos, &parent);
+        if(node == NULL) {
+            xmlSecInternalError("xmlSecNodeSetIndexGetNode", NULL);
+            xmlSecNodeSetDestroy(res);
+            return(NULL);
+        }
+        ret = xmlSecNodeSetContains(nodes, node, parent);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeSetContains", NULL);
+            xmlSecNodeSetDestroy(res);
+            return(NULL);
+        }
+        if(ret > 0) {
+            xmlSecNodeSetBitmapSet(res, pos);
+        }
+    }
+
+    for(pos = 0; pos < xmlSecPtrListGetSize(dataList); ++pos) {
+        data = (xmlSecXPathDataPtr)xmlSecPtrListGetItem(dataList, pos);
+        if(data == NULL) {
+            xmlSecInternalError2("xmlSecPtrListGetItem", NULL, "pos=" XMLSEC_SIZE_FMT, pos);
+            xmlSecNodeSetDestroy(res);
+            return(NULL);
+        }
+        if(data->nodeSetType != xmlSecNodeSetTree) {
+            xmlSecUnsupportedEnumValueError("nodeSetType", data->nodeSetType, NULL);
+            xmlSecNodeSetDestroy(res);
+            return(NULL);
+        }
+
+        xpathObj = xmlSecXPathDataEval(data, doc, hereNode);
+        if(xpathObj == NULL) {
+            xmlSecInternalError("xmlSecXPathDataEval", NULL);
+            xmlSecNodeSetDestroy(res);
+            return(NULL);
+        }
+
+        ret = xmlSecNodeSetBitmapApply(res, xpathObj->nodesetval, data->nodeSetOp);
+        xmlXPathFreeObject(xpathObj);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecNodeSetBitmapApply", NULL,
+                "nodeSetOp=" XMLSEC_ENUM_FMT, XMLSEC_ENUM_CAST(data->nodeSetOp));
+            xmlSecNodeSetDestroy(res);
+            return(NULL);
+        }
+    }
+
+    return(res);
+}
+
 static xmlSecNodeSetPtr
 xmlSecXPathDataListExecute(xmlSecPtrListPtr dataList, xmlDocPtr doc,
                            xmlNodePtr hereNode, xmlSecNodeSetPtr nodes) {
@@ -316,6 +929,11 @@ xmlSecXPathDataListExecute(xmlSecPtrListPtr dataList, xmlDocPtr doc,
     xmlSecAssert2(doc != NULL, NULL);
     xmlSecAssert2(hereNode != NULL, NULL);
 
+    data = (xmlSecXPathDataPtr)xmlSecPtrListGetItem(dataList, 0);
+    if((data != NULL) && (data->type == xmlSecXPathDataTypeXPath2)) {
+        return(xmlSecXPathDataListExecuteBitmap(dataList, doc, hereNode, nodes));
+    }
+
     res = nodes;
     for(pos = 0; pos < xmlSecPtrListGetSize(dataList); ++pos) {
         data = (xmlSecXPathDataPtr)xmlSecPtrListGetItem(dataList, pos);
@@ -327,7 +945,7 @@ xmlSecXPathDataListExecute(xmlSecPtrListPtr dataList, xmlDocPtr doc,
             return(NULL);
         }
 
-        tmp = xmlSecXPathDataExecute(data, doc, hereNode);
+        tmp = xmlSecXPathDataExecute(data, doc, hereNode, res);
         if(tmp == NULL) {
             xmlSecInternalError("xmlSecXPathDataExecute", NULL);
             if((res != NULL) && (res != nodes)) {
@@ -465,7 +1083,7 @@ static xmlSecTransformKlass xmlSecTransformXPathKlass = {
     xmlSecTransformDefaultPopXml,               /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecTransformXPathExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -483,16 +1101,11 @@ xmlSecTransformXPathGetKlass(void) {
     return(&xmlSecTransformXPathKlass);
 }
 
-#define XMLSEC_TRANSFORM_XPATH_TMPL "(//. | //@* | //namespace::*)[boolean(%s)]"
-
 static int
 xmlSecTransformXPathNodeRead(xmlSecTransformPtr transform, xmlNodePtr node, xmlSecTransformCtxPtr transformCtx) {
     xmlSecPtrListPtr dataList;
     xmlSecXPathDataPtr data;
     xmlNodePtr cur;
-    xmlChar* tmp;
-    xmlSecSize tmpSize;
-    int tmpLen;
     int ret;
 
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformXPathId), -1);
@@ -512,7 +1125,7 @@ xmlSecTransformXPathNodeRead(xmlSecTransformPtr transform, xmlNodePtr node, xmlS
     }
 
     /* read information from the node */
-    data = xmlSecXPathDataCreate(xmlSecXPathDataTypeXPath);
+    data = xmlSecXPathDataCreate(xmlSecXPathDataTypeXPathFilter);
     if(data == NULL) {
         xmlSecInternalError("xmlSecXPathDataCreate",
                             xmlSecTransformGetName(transform));
@@ -536,25 +1149,13 @@ xmlSecTransformXPathNodeRead(xmlSecTransformPtr transform, xmlNodePtr node, xmlS
         return(-1);
     }
 
-    /* create full XPath expression */
-    xmlSecAssert2(data->expr != NULL, -1);
-    tmpLen = xmlStrlen(data->expr) + xmlStrlen(BAD_CAST XMLSEC_TRANSFORM_XPATH_TMPL) + 1;
-    XMLSEC_SAFE_CAST_INT_TO_SIZE(tmpLen, tmpSize, return(-1), NULL);
-
-    tmp = (xmlChar*) xmlMalloc(sizeof(xmlChar) * tmpSize);
-    if(tmp == NULL) {
-        xmlSecMallocError(sizeof(xmlChar) * tmpSize,
-                          xmlSecTransformGetName(transform));
-        return(-1);
-    }
-    ret = xmlStrPrintf(tmp, tmpLen, XMLSEC_TRANSFORM_XPATH_TMPL, (char*)data->expr);
+    /* check for the filters that can be evaluated without XPath engine */
+    ret = xmlSecXPathDataFilterParse(data);
     if(ret < 0) {
-       xmlSecXmlError("xmlStrPrintf", xmlSecTransformGetName(transform));
-       xmlFree(tmp);
-       return(-1);
+        xmlSecInternalError("xmlSecXPathDataFilterParse",
+                            xmlSecTransformGetName(transform));
+        return(-1);
     }
-    xmlFree(data->expr);
-    data->expr = tmp;
 
     /* set correct node set type and operation */
     data->nodeSetOp     = xmlSecNodeSetIntersection;
@@ -600,7 +1201,7 @@ static xmlSecTransformKlass xmlSecTransformXPath2Klass = {
     xmlSecTransformDefaultPopXml,               /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecTransformXPathExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -726,7 +1327,7 @@ static xmlSecTransformKlass xmlSecTransformXPointerKlass = {
     xmlSecTransformDefaultPopXml,               /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecTransformXPathExecute,                /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -915,7 +1516,7 @@ static xmlSecTransformKlass xmlSecTransformVisa3DHackKlass = {
     xmlSecTransformDefaultPopXml,               /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecTransformVisa3DHackExecute,           /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include <libxml/tree.h>
+#include <libxml/threads.h>
 #include <libxslt/xslt.h>
 #include <libxslt/xsltInternals.h>
 #include <libxslt/transform.h>
@@ -43,9 +44,12 @@
  * Internal xslt ctx
  *
  *****************************************************************************/
+typedef struct _xmlSecXsltCacheItem             xmlSecXsltCacheItem, *xmlSecXsltCacheItemPtr;
+
 typedef struct _xmlSecXsltCtx                   xmlSecXsltCtx, *xmlSecXsltCtxPtr;
 struct _xmlSecXsltCtx {
     xsltStylesheetPtr   xslt;
+    xmlSecXsltCacheItemPtr cacheItem;   /* if not NULL then xslt is owned by the cache item */
     xmlParserCtxtPtr    parserCtx;
 };
 
@@ -101,7 +105,7 @@ static xmlSecTransformKlass xmlSecXsltKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecXsltExecute,                          /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* xmlSecTransformExecuteOnceMethod executeOnce; */
     NULL,                                       /* void* reserved1; */
 };
 
@@ -111,8 +115,269 @@ static xmlSecTransformKlass xmlSecXsltKlass = {
 
 static xsltSecurityPrefsPtr g_xslt_default_security_prefs = NULL;
 
+/**************************************************************************
+ *
+ * Compiled stylesheets cache: the same stylesheets are usually used
+ * again and again so we keep the compiled xsltStylesheetPtr keyed by the
+ * serialized stylesheet (hash is used only to speed up the lookup). The
+ * items are refcounted: the transforms keep using the stylesheet even
+ * if the item was evicted from the cache in the meantime.
+ *
+ *************************************************************************/
+#define XMLSEC_XSLT_CACHE_MAX_SIZE              64
+#define XMLSEC_XSLT_CACHE_DEFAULT_SIZE          16
+
+struct _xmlSecXsltCacheItem {
+    xmlSecByte*         data;
+    xmlSecSize          dataSize;
+    uint32_t            hash;
+    xsltStylesheetPtr   xslt;
+    int                 refCount;       /* the cache itself holds one ref */
+    xmlSecSize          lastUsed;
+};
+
+static xmlMutexPtr              g_xslt_cache_mutex = NULL;
+static xmlSecXsltCacheItemPtr   g_xslt_cache[XMLSEC_XSLT_CACHE_MAX_SIZE];
+static xmlSecSize               g_xslt_cache_size = XMLSEC_XSLT_CACHE_DEFAULT_SIZE;
+static xmlSecSize               g_xslt_cache_used = 0;
+static xmlSecSize               g_xslt_cache_tick = 0;
+
+/* 32-bit FNV-1a */
+static uint32_t
+xmlSecXsltCacheHash(const xmlSecByte* data, xmlSecSize dataSize) {
+    uint32_t res = 2166136261U;
+    xmlSecSize ii;
+
+    xmlSecAssert2(data != NULL, 0);
+
+    for(ii = 0; ii < dataSize; ++ii) {
+        res ^= data[ii];
+        res *= 16777619U;
+    }
+    return(res);
+}
+
+static void
+xmlSecXsltCacheItemDestroy(xmlSecXsltCacheItemPtr item) {
+    xmlSecAssert(item != NULL);
+
+    if(item->xslt != NULL) {
+        xsltFreeStylesheet(item->xslt);
+    }
+    if(item->data != NULL) {
+        xmlFree(item->data);
+    }
+    memset(item, 0, sizeof(xmlSecXsltCacheItem));
+    xmlFree(item);
+}
+
+static xmlSecXsltCacheItemPtr
+xmlSecXsltCacheItemCreate(const xmlSecByte* data, xmlSecSize dataSize, uint32_t hash) {
+    xmlSecXsltCacheItemPtr item;
+
+    xmlSecAssert2(data != NULL, NULL);
+    xmlSecAssert2(dataSize > 0, NULL);
+
+    item = (xmlSecXsltCacheItemPtr)xmlMalloc(sizeof(xmlSecXsltCacheItem));
+    if(item == NULL) {
+        xmlSecMallocError(sizeof(xmlSecXsltCacheItem), NULL);
+        return(NULL);
+    }
+    memset(item, 0, sizeof(xmlSecXsltCacheItem));
+
+    item->data = (xmlSecByte*)xmlMalloc(dataSize);
+    if(item->data == NULL) {
+        xmlSecMallocError(dataSize, NULL);
+        xmlSecXsltCacheItemDestroy(item);
+        return(NULL);
+    }
+    memcpy(item->data, data, dataSize);
+    item->dataSize = dataSize;
+    item->hash = hash;
+    return(item);
+}
+
+static void
+xmlSecXsltCacheItemRelease(xmlSecXsltCacheItemPtr item) {
+    int refCount;
+
+    xmlSecAssert(item != NULL);
+    xmlSecAssert(g_xslt_cache_mutex != NULL);
+
+    xmlMutexLock(g_xslt_cache_mutex);
+    refCount = --item->refCount;
+    xmlMutexUnlock(g_xslt_cache_mutex);
+
+    if(refCount <= 0) {
+        xmlSecXsltCacheItemDestroy(item);
+    }
+}
+
+/* must be called under g_xslt_cache_mutex, returns the item to destroy or NULL */
+static xmlSecXsltCacheItemPtr
+xmlSecXsltCacheRemoveUnlocked(xmlSecSize pos) {
+    xmlSecXsltCacheItemPtr item;
+
+    xmlSecAssert2(pos < g_xslt_cache_used, NULL);
+
+    item = g_xslt_cache[pos];
+    g_xslt_cache[pos] = g_xslt_cache[g_xslt_cache_used - 1];
+    g_xslt_cache[g_xslt_cache_used - 1] = NULL;
+    --g_xslt_cache_used;
+
+    xmlSecAssert2(item != NULL, NULL);
+    --item->refCount;
+    return((item->refCount <= 0) ? item : NULL);
+}
+
+/* must be called under g_xslt_cache_mutex */
+static xmlSecXsltCacheItemPtr
+xmlSecXsltCacheFindUnlocked(const xmlSecByte* data, xmlSecSize dataSize, uint32_t hash) {
+    xmlSecXsltCacheItemPtr item;
+    xmlSecSize ii;
+
+    for(ii = 0; ii < g_xslt_cache_used; ++ii) {
+        item = g_xslt_cache[ii];
+        if((item->hash == hash) && (item->dataSize == dataSize) &&
+           (memcmp(item->data, data, dataSize) == 0)
+        ) {
+            ++item->refCount;
+            item->lastUsed = ++g_xslt_cache_tick;
+            return(item);
+        }
+    }
+    return(NULL);
+}
+
+static void
+xmlSecXsltCacheFlush(void) {
+    xmlSecXsltCacheItemPtr items[XMLSEC_XSLT_CACHE_MAX_SIZE];
+    xmlSecSize itemsSize = 0;
+    xmlSecXsltCacheItemPtr item;
+    xmlSecSize ii;
+
+    if(g_xslt_cache_mutex == NULL) {
+        return;
+    }
+
+    xmlMutexLock(g_xslt_cache_mutex);
+    while(g_xslt_cache_used > 0) {
+        item = xmlSecXsltCacheRemoveUnlocked(g_xslt_cache_used - 1);
+        if(item != NULL) {
+            items[itemsSize++] = item;
+        }
+    }
+    xmlMutexUnlock(g_xslt_cache_mutex);
+
+    for(ii = 0; ii < itemsSize; ++ii) {
+        xmlSecXsltCacheItemDestroy(items[ii]);
+    }
+}
+
+/* compiles the stylesheet from the serialized @data, doesn't touch the cache */
+static xsltStylesheetPtr
+xmlSecXsltCompile(const xmlSecByte* data, xmlSecSize dataSize) {
+    xsltStylesheetPtr res;
+    xmlDocPtr doc;
+
+    xmlSecAssert2(data != NULL, NULL);
+
+    doc = xmlSecParseMemory(data, dataSize, 1);
+    if(doc == NULL) {
+        xmlSecInternalError("xmlSecParseMemory", NULL);
+        return(NULL);
+    }
+
+    /* pre-process stylesheet */
+    res = xsltParseStylesheetDoc(doc);
+    if(res == NULL) {
+        xmlSecXsltError("xsltParseStylesheetDoc", NULL, NULL);
+        xmlFreeDoc(doc);
+        return(NULL);
+    }
+    /* doc is owned by res and will be freed by xsltFreeStylesheet() */
+    return(res);
+}
+
+static int
+xmlSecXsltCacheGet(const xmlSecByte* data, xmlSecSize dataSize, xmlSecXsltCtxPtr ctx) {
+    xmlSecXsltCacheItemPtr item = NULL;
+    xmlSecXsltCacheItemPtr evicted = NULL;
+    xmlSecXsltCacheItemPtr found;
+    uint32_t hash;
+    xmlSecSize ii, pos;
+
+    xmlSecAssert2(data != NULL, -1);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->xslt == NULL, -1);
+    xmlSecAssert2(ctx->cacheItem == NULL, -1);
+    xmlSecAssert2(g_xslt_cache_mutex != NULL, -1);
+
+    hash = xmlSecXsltCacheHash(data, dataSize);
+
+    xmlMutexLock(g_xslt_cache_mutex);
+    found = xmlSecXsltCacheFindUnlocked(data, dataSize, hash);
+    xmlMutexUnlock(g_xslt_cache_mutex);
+    if(found != NULL) {
+        ctx->xslt = found->xslt;
+        ctx->cacheItem = found;
+        return(0);
+    }
+
+    /* not found: compile the stylesheet outside of the lock */
+    item = xmlSecXsltCacheItemCreate(data, dataSize, hash);
+    if(item == NULL) {
+        xmlSecInternalError("xmlSecXsltCacheItemCreate", NULL);
+        return(-1);
+    }
+    item->xslt = xmlSecXsltCompile(data, dataSize);
+    if(item->xslt == NULL) {
+        xmlSecInternalError("xmlSecXsltCompile", NULL);
+        xmlSecXsltCacheItemDestroy(item);
+        return(-1);
+    }
+    item->refCount = 1; /* ctx */
+
+    xmlMutexLock(g_xslt_cache_mutex);
+    /* someone might have compiled the same stylesheet in the meantime */
+    found = xmlSecXsltCacheFindUnlocked(data, dataSize, hash);
+    if(found == NULL) {
+        /* evict the least recently used item if needed */
+        if((g_xslt_cache_used >= g_xslt_cache_size) && (g_xslt_cache_used > 0)) {
+            for(ii = 1, pos = 0; ii < g_xslt_cache_used; ++ii) {
+                if(g_xslt_cache[ii]->lastUsed < g_xslt_cache[pos]->lastUsed) {
+                    pos = ii;
+                }
+            }
+            evicted = xmlSecXsltCacheRemoveUnlocked(pos);
+        }
+        if(g_xslt_cache_used < g_xslt_cache_size) {
+            ++item->refCount; /* cache */
+            item->lastUsed = ++g_xslt_cache_tick;
+            g_xslt_cache[g_xslt_cache_used++] = item;
+        }
+    }
+    xmlMutexUnlock(g_xslt_cache_mutex);
+
+    if(evicted != NULL) {
+        xmlSecXsltCacheItemDestroy(evicted);
+    }
+    if(found != NULL) {
+        xmlSecXsltCacheItemDestroy(item);
+        item = found;
+    }
+
+    ctx->xslt = item->xslt;
+    ctx->cacheItem = item;
+    return(0);
+}
+
 void xmlSecTransformXsltInitialize(void) {
     xmlSecAssert(g_xslt_default_security_prefs == NULL);
+    xmlSecAssert(g_xslt_cache_mutex == NULL);
+
+    g_xslt_cache_mutex = xmlNewMutex();
+    xmlSecAssert(g_xslt_cache_mutex != NULL);
 
     g_xslt_default_security_prefs = xsltNewSecurityPrefs();
     xmlSecAssert(g_xslt_default_security_prefs != NULL);
@@ -124,6 +389,11 @@ void xmlSecTransformXsltInitialize(void) {
 }
 
 void xmlSecTransformXsltShutdown(void) {
+    xmlSecXsltCacheFlush();
+    if(g_xslt_cache_mutex != NULL) {
+        xmlFreeMutex(g_xslt_cache_mutex);
+        g_xslt_cache_mutex = NULL;
+    }
     if(g_xslt_default_security_prefs != NULL) {
         xsltFreeSecurityPrefs(g_xslt_default_security_prefs);
         g_xslt_default_security_prefs = NULL;
@@ -135,13 +405,16 @@ void xmlSecTransformXsltShutdown(void) {
  * @sec: the new security preferences
  *
  * Sets the new default security preferences. The xmlsec default security policy is
- * to disable everything.
+ * to disable everything. The compiled stylesheets cache is flushed.
  */
 void
 xmlSecTransformXsltSetDefaultSecurityPrefs(xsltSecurityPrefsPtr sec) {
     xmlSecAssert(sec != NULL);
     xmlSecAssert(g_xslt_default_security_prefs != NULL);
 
+    /* do not reuse the stylesheets compiled under the old policy */
+    xmlSecXsltCacheFlush();
+
     /* copy prefs */
     XMLSEC_XSLT_COPY_SEC_PREF(sec, g_xslt_default_security_prefs, XSLT_SECPREF_READ_FILE);
     XMLSEC_XSLT_COPY_SEC_PREF(sec, g_xslt_default_security_prefs, XSLT_SECPREF_WRITE_FILE);
@@ -150,6 +423,27 @@ xmlSecTransformXsltSetDefaultSecurityPrefs(xsltSecurityPrefsPtr sec) {
     XMLSEC_XSLT_COPY_SEC_PREF(sec, g_xslt_default_security_prefs, XSLT_SECPREF_WRITE_NETWORK);
 }
 
+/**
+ * xmlSecTransformXsltSetCacheSize:
+ * @size: the max number of compiled stylesheets to keep (0 disables the cache).
+ *
+ * Sets the max number of compiled stylesheets kept in the global cache (the
+ * value is capped at 64, the default is 16). The XSLT transform looks up the
+ * compiled stylesheet in the cache by the serialized stylesheet content and
+ * skips the stylesheet parsing and compilation if it is found. The cache
+ * is flushed.
+ */
+void
+xmlSecTransformXsltSetCacheSize(xmlSecSize size) {
+    xmlSecAssert(g_xslt_cache_mutex != NULL);
+
+    xmlSecXsltCacheFlush();
+
+    xmlMutexLock(g_xslt_cache_mutex);
+    g_xslt_cache_size = (size < XMLSEC_XSLT_CACHE_MAX_SIZE) ? size : XMLSEC_XSLT_CACHE_MAX_SIZE;
+    xmlMutexUnlock(g_xslt_cache_mutex);
+}
+
 /**
  * xmlSecTransformXsltGetKlass:
  *
@@ -214,7 +508,9 @@ xmlSecXsltFinalize(xmlSecTransformPtr transform) {
     ctx = xmlSecXsltGetCtx(transform);
     xmlSecAssert(ctx != NULL);
 
-    if(ctx->xslt != NULL) {
+    if(ctx->cacheItem != NULL) {
+        xmlSecXsltCacheItemRelease(ctx->cacheItem);
+    } else if(ctx->xslt != NULL) {
         xsltFreeStylesheet(ctx->xslt);
     }
     if(ctx->parserCtx != NULL) {
@@ -231,11 +527,12 @@ static int
 xmlSecXsltReadNode(xmlSecTransformPtr transform, xmlNodePtr node, xmlSecTransformCtxPtr transformCtx) {
     xmlSecXsltCtxPtr ctx;
     xmlBufferPtr buffer = NULL;
-    xmlDocPtr doc = NULL;
     xmlNodePtr cur;
     const xmlChar* buf;
     xmlSecSize bufSize;
+    xmlSecSize cacheSize;
     int bufLen;
+    int ret;
     int res = -1;
 
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformXsltId), -1);
@@ -259,33 +556,33 @@ xmlSecXsltReadNode(xmlSecTransformPtr transform, xmlNodePtr node, xmlSecTransfor
         cur = cur->next;
     }
 
-    /* parse the buffer */
     buf = xmlBufferContent(buffer);
     bufLen = xmlBufferLength(buffer);
     XMLSEC_SAFE_CAST_INT_TO_SIZE(bufLen, bufSize, goto done, xmlSecTransformGetName(transform));
-    doc = xmlSecParseMemory(buf, bufSize, 1);
-    if(doc == NULL) {
-        xmlSecInternalError("xmlSecParseMemory",
-                            xmlSecTransformGetName(transform));
-        goto done;
-    }
 
-    /* pre-process stylesheet */
-    ctx->xslt = xsltParseStylesheetDoc(doc);
-    if(ctx->xslt == NULL) {
-        xmlSecXsltError("xsltParseStylesheetDoc", NULL, xmlSecTransformGetName(transform));
+    xmlMutexLock(g_xslt_cache_mutex);
+    cacheSize = g_xslt_cache_size;
+    xmlMutexUnlock(g_xslt_cache_mutex);
 
-        goto done;
+    if((cacheSize > 0) && (bufSize > 0)) {
+        /* get the compiled stylesheet from the cache */
+        ret = xmlSecXsltCacheGet(buf, bufSize, ctx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecXsltCacheGet", xmlSecTransformGetName(transform));
+            goto done;
+        }
+    } else {
+        ctx->xslt = xmlSecXsltCompile(buf, bufSize);
+        if(ctx->xslt == NULL) {
+            xmlSecInternalError("xmlSecXsltCompile", xmlSecTransformGetName(transform));
+            goto done;
+        }
     }
-    doc = NULL; /* owned by ctx->xslt and will be freed by xsltFreeStylesheet() */
 
     /* success */
     res = 0;
 
 done:
-    if(doc != NULL) {
-        xmlFreeDoc(doc);
-    }
     if(buffer != NULL) {
         xmlBufferFree(buffer);
     }
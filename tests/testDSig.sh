@@ -738,6 +738,99 @@ execDSigTest $res_success \
     "$priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
     "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
 
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-rsa-sha256" \
+    "sha256 rsa-sha256" \
+    "rsa x509" \
+    "--transform-stats --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509" \
+    "--transform-stats $priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
+    "--transform-stats --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-rsa-sha256" \
+    "sha256 rsa-sha256" \
+    "rsa x509" \
+    "--trace --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509" \
+    "--trace $priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
+    "--trace --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-rsa-sha256" \
+    "sha256 rsa-sha256" \
+    "rsa x509" \
+    "--arena --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509" \
+    "--arena $priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
+    "--arena --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-multiple-sha2-hmac-sha256" \
+    "sha224 sha256 sha384 sha512 hmac-sha256" \
+    "hmac" \
+    "--batch-digests --lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--batch-digests --hmackey:mykey $topfolder/keys/hmackey.bin"
+
+# the multi-buffer digests are checked against the OpenSSL ones: the
+# document is signed without and verified with the batched digests
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha2-digest-vectors-hmac-sha256" \
+    "sha224 sha256 sha384 sha512 hmac-sha256" \
+    "hmac" \
+    "--batch-digests --lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--batch-digests --hmackey:mykey $topfolder/keys/hmackey.bin"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-stream-id-sha256-rsa-sha256" \
+    "enveloped-signature c14n11 exc-c14n sha256 rsa-sha256" \
+    "" \
+    "--pipeline-c14n --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--pipeline-c14n --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--pipeline-c14n --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
+# the "--repeat" option is set by testrun.sh for the memory and perf tests
+if [ -z "$REPEAT" -a -z "$PERF_TEST" ] ; then
+    batchfile="$tmpfile.batch"
+    for ii in 1 2 3 4 5 6 7 8 ; do
+        echo "$topfolder/aleksey-xmldsig-01/enveloping-sha256-rsa-sha256.xml" >> $batchfile
+    done
+    execDSigTest $res_success \
+        "" \
+        "aleksey-xmldsig-01/enveloping-sha256-rsa-sha256" \
+        "sha256 rsa-sha256" \
+        "rsa x509" \
+        "--batch $batchfile --batch-threads 4 --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509" \
+        "--batch-threads 4 $priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
+        "--batch-threads 4 --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
+    rm -f $batchfile
+
+    execDSigTest $res_success \
+        "" \
+        "aleksey-xmldsig-01/enveloping-sha256-rsa-sha256" \
+        "sha256 rsa-sha256" \
+        "rsa x509" \
+        "--repeat 5 --repeat-warmup 2 --repeat-format json --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509" \
+        "--repeat 5 --repeat-warmup 2 --repeat-format csv --repeat-stats-file $tmpfile.stats $priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
+        "--repeat 5 --repeat-warmup 2 --trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
+    rm -f $tmpfile.stats
+
+    # the same XSLT stylesheet is applied again from the compiled stylesheets cache
+    execDSigTest $res_success \
+        "xmldsig2ed-tests" \
+        "defCan-2" \
+        "c14n11 xslt xpath sha1 hmac-sha1" \
+        "hmac" \
+        "--repeat 3 --lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+        "--repeat 3 --hmackey:mykey $topfolder/keys/hmackey.bin" \
+        "--repeat 3 --hmackey:mykey $topfolder/keys/hmackey.bin"
+fi
+
 execDSigTest $res_success \
     "aleksey-xmldsig-01" \
     "enveloping-sha256-rsa-sha256-relationship" \
@@ -979,6 +1072,48 @@ execDSigTest $res_success \
     "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
     "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
 
+extra_message="Streaming signature"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-stream-sha256-rsa-sha256" \
+    "enveloped-signature exc-c14n sha256 rsa-sha256" \
+    "" \
+    "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--stream-data $topfolder/aleksey-xmldsig-01/enveloped-stream-sha256-rsa-sha256.data $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
+extra_message="Streaming verification"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-stream-id-sha256-rsa-sha256" \
+    "enveloped-signature c14n11 exc-c14n sha256 rsa-sha256" \
+    "" \
+    "--stream-verify $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--stream-verify $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
+# the inputs that fit in one binary chunk are digested and signed in one call (executeOnce),
+# the same signature must be produced when the inputs are processed chunk by chunk
+extra_message="One-shot digest and signature"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-stream-id-sha256-rsa-sha256" \
+    "enveloped-signature c14n11 exc-c14n sha256 rsa-sha256" \
+    "" \
+    "--transform-binary-chunk-size 1048576 --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--transform-binary-chunk-size 1048576 --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--transform-binary-chunk-size 16 --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
+extra_message="Chunked digest and signature"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-stream-id-sha256-rsa-sha256" \
+    "enveloped-signature c14n11 exc-c14n sha256 rsa-sha256" \
+    "" \
+    "--transform-binary-chunk-size 16 --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--transform-binary-chunk-size 16 --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "--transform-binary-chunk-size 1048576 --id-attr:Id Header $priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
 execDSigTest $res_success \
     "" \
     "aleksey-xmldsig-01/enveloped-sha224-ecdsa-sha224" \
@@ -1462,6 +1597,15 @@ execDSigTest $res_success \
     "--lax-key-search $priv_key_option:mykey $topfolder/keys/dsakey.$priv_key_format --pwd secret123 $url_map_xml_stylesheet_2005 $url_map_xml_stylesheet_b64_2005" \
     "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --untrusted-$cert_format $topfolder/keys/ca2cert.$cert_format $url_map_xml_stylesheet_2005 $url_map_xml_stylesheet_b64_2005"
 
+execDSigTest $res_success \
+    "" \
+    "merlin-xmldsig-twenty-three/signature" \
+    "base64 xpath xslt enveloped-signature c14n-with-comments sha1 dsa-sha1" \
+    "dsa x509" \
+    "--prefetch-uris --trusted-$cert_format $topfolder/merlin-xmldsig-twenty-three/certs/merlin.$cert_format --verification-gmt-time 2005-01-01+10:00:00 $url_map_xml_stylesheet_2005 $url_map_xml_stylesheet_b64_2005" \
+    "--prefetch-uris --lax-key-search $priv_key_option:mykey $topfolder/keys/dsakey.$priv_key_format --pwd secret123 $url_map_xml_stylesheet_2005 $url_map_xml_stylesheet_b64_2005" \
+    "--prefetch-uris --trusted-$cert_format $topfolder/keys/cacert.$cert_format --untrusted-$cert_format $topfolder/keys/ca2cert.$cert_format $url_map_xml_stylesheet_2005 $url_map_xml_stylesheet_b64_2005"
+
 
 ##########################################################################
 #
@@ -1582,6 +1726,13 @@ execDSigTest $res_success \
     "rsa x509" \
     "--lax-key-search --pubkey-cert-$cert_format certs/rsa-cert.$cert_format $url_map_rfc3161"
 
+execDSigTest $res_success \
+    "phaos-xmldsig-three" \
+    "signature-big" \
+    "base64 xslt xpath sha1 rsa-sha1" \
+    "rsa x509" \
+    "--mmap-threshold 1 --lax-key-search --pubkey-cert-$cert_format certs/rsa-cert.$cert_format $url_map_rfc3161"
+
 execDSigTest $res_success \
     "phaos-xmldsig-three" \
     "signature-dsa-detached" \
@@ -1777,6 +1928,48 @@ execDSigTest $res_fail \
     "rsa x509" \
     "--trusted-$cert_format certs/rsa-ca-cert.$cert_format"
 
+##########################################################################
+#
+# test SignedInfo canonicalization: the first signature SignedInfo is
+# canonicalized directly, the second signature references it through
+# the generic transforms chain, the results must be the same
+#
+##########################################################################
+if [ -z "$XMLSEC_TEST_NAME" -o "$XMLSEC_TEST_NAME" = "enveloping-signedinfo-c14n-hmac-sha256" ]; then
+c14n_file="$topfolder/aleksey-xmldsig-01/enveloping-signedinfo-c14n-hmac-sha256"
+c14n_params="--lax-key-search --hmackey $topfolder/keys/hmackey.bin --id-attr:Id Data --id-attr:Id http://www.w3.org/2000/09/xmldsig#:SignedInfo --id-attr:Id http://www.w3.org/2000/09/xmldsig#:Signature"
+echo "Test: aleksey-xmldsig-01/enveloping-signedinfo-c14n-hmac-sha256"
+printf "    Checking required transforms                         "
+$xmlsec_app check-transforms $xmlsec_params c14n-with-comments base64 sha256 hmac-sha256 >> $logfile 2>> $logfile
+printCheckStatus $?
+if [ $? -eq 0 ]; then
+    printf "    Canonicalize SignedInfo directly                     "
+    echo "$VALGRIND $xmlsec_app sign $xmlsec_params $c14n_params --node-id signature1 --store-signatures --output $tmpfile.1 $c14n_file.tmpl" >> $logfile
+    $VALGRIND $xmlsec_app sign $xmlsec_params $c14n_params --node-id signature1 --store-signatures --output $tmpfile.1 $c14n_file.tmpl > $tmpfile.2 2>> $logfile
+    printRes $res_success $?
+    printf "    Canonicalize SignedInfo with transforms              "
+    echo "$VALGRIND $xmlsec_app sign $xmlsec_params $c14n_params --node-id signature2 --store-references --output $tmpfile.3 $tmpfile.1" >> $logfile
+    $VALGRIND $xmlsec_app sign $xmlsec_params $c14n_params --node-id signature2 --store-references --output $tmpfile.3 $tmpfile.1 > $tmpfile.4 2>> $logfile
+    printRes $res_success $?
+    printf "    Compare canonicalized SignedInfo                     "
+    sed -n '/== PreSigned data - start buffer:/,/== PreSigned data - end buffer/p' $tmpfile.2 | sed '1d;$d' > $tmpfile.5
+    sed -n '/== PreDigest data - start buffer:/,/== PreDigest data - end buffer/p' $tmpfile.4 | sed '1d;$d' > $tmpfile.6
+    test -s $tmpfile.5 && diff $tmpfile.5 $tmpfile.6 >> $logfile 2>> $logfile
+    printRes $res_success $?
+    printf "    Verify new signatures                                "
+    $VALGRIND $xmlsec_app verify $xmlsec_params $c14n_params --node-id signature1 $tmpfile.3 >> $logfile 2>> $logfile && \
+        $VALGRIND $xmlsec_app verify $xmlsec_params $c14n_params --node-id signature2 $tmpfile.3 >> $logfile 2>> $logfile
+    printRes $res_success $?
+
+    # libxml2 rejects the relative namespace URIs in the ancestors too
+    printf "    Negative test: relative namespace URI                "
+    sed 's|<Envelope |<Envelope xmlns:rel="relative/uri" |' $c14n_file.tmpl > $tmpfile.1
+    $VALGRIND $xmlsec_app sign $xmlsec_params $c14n_params --node-id signature1 --output $tmpfile.3 $tmpfile.1 >> $logfile 2>> $logfile
+    printRes $res_fail $?
+    rm -f $tmpfile.1 $tmpfile.2 $tmpfile.3 $tmpfile.4 $tmpfile.5 $tmpfile.6
+fi
+fi
+
 ##########################################################################
 #
 # test dynamic signature
@@ -48,6 +48,16 @@ execEncTest $res_success \
     "--aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key --binary-data $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.data" \
     "--aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key"
 
+# the same with the key and the data files memory mapped (read-only)
+execEncTest $res_success \
+    "" \
+    "xmlenc11-interop-2012/xenc11-example-AES128-GCM" \
+    "aes128-gcm" \
+    "" \
+    "--mmap-threshold 1 --lax-key-search --aeskey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key" \
+    "--mmap-threshold 1 --aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key --binary-data $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.data" \
+    "--mmap-threshold 1 --aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key"
+
 
 # Advanced RSA OAEP modes:
 # - MSCrypto only supports SHA1 for digest and mgf1
@@ -62,6 +72,24 @@ if [ "z$crypto" != "zmscrypto" -a "z$crypto" != "zmscng" -a "z$crypto" != "zgcry
         "$priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd --session-key aes-128 --xml-data $topfolder/xmlenc11-interop-2012/cipherText__RSA-2048__aes128-gcm__rsa-oaep-mgf1p.data"  \
         "$priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd"
 
+    execEncTest $res_success \
+        "" \
+        "xmlenc11-interop-2012/cipherText__RSA-2048__aes128-gcm__rsa-oaep-mgf1p" \
+        "aes128-gcm rsa-oaep-mgf1p sha256 sha1" \
+        "" \
+        "--trace $priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd" \
+        "--trace $priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd --session-key aes-128 --xml-data $topfolder/xmlenc11-interop-2012/cipherText__RSA-2048__aes128-gcm__rsa-oaep-mgf1p.data"  \
+        "--trace $priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd"
+
+    execEncTest $res_success \
+        "" \
+        "xmlenc11-interop-2012/cipherText__RSA-2048__aes128-gcm__rsa-oaep-mgf1p" \
+        "aes128-gcm rsa-oaep-mgf1p sha256 sha1" \
+        "" \
+        "--arena $priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd" \
+        "--arena $priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd --session-key aes-128 --xml-data $topfolder/xmlenc11-interop-2012/cipherText__RSA-2048__aes128-gcm__rsa-oaep-mgf1p.data"  \
+        "--arena $priv_key_option:TestRsa2048Key $topfolder/xmlenc11-interop-2012/RSA-2048_SHA256WithRSA.$priv_key_format --pwd passwd"
+
     execEncTest $res_success \
         "" \
         "xmlenc11-interop-2012/cipherText__RSA-3072__aes192-gcm__rsa-oaep-mgf1p__Sha256" \
@@ -185,6 +213,16 @@ execEncTest $res_success \
     "--enabled-key-data agreement-method,enc-key,key-name,key-value,ec --session-key aes-256 $priv_key_option:originator-key-name $topfolder/keys/ecdsa-secp256r1-key.$priv_key_format --pwd secret123 $pub_key_option:recipient-key-name $topfolder/keys/ecdsa-secp256r1-second-key.$pub_key_format --xml-data $topfolder/aleksey-xmlenc-01/enc_ecdh_p256_concatkdf_sha1_kw_aes256_aes128gcm.data" \
     "--enabled-key-data agreement-method,enc-key,key-name,key-value,ec $priv_key_option:recipient-key-name $topfolder/keys/ecdsa-secp256r1-second-key.$priv_key_format --pwd secret123"
 
+# ECDH + ConcatKDF + SHA1 with several recipients
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc_ecdh_p256_concatkdf_sha1_kw_aes256_aes128gcm_recipients" \
+    "aes256-gcm kw-aes256 ecdh-es concatkdf sha1" \
+    "agreement-method enc-key ec" \
+    "--enabled-key-data agreement-method,enc-key,key-name,key-value,ec $priv_key_option:second-recipient $topfolder/keys/ec-prime256v1-second-key.$priv_key_format --pwd secret123" \
+    "--enabled-key-data agreement-method,enc-key,key-name,key-value,ec --session-key aes-256 $priv_key_option:originator-key-name $topfolder/keys/ecdsa-secp256r1-key.$priv_key_format --pwd secret123 $pub_key_option:first-recipient $topfolder/keys/ecdsa-secp256r1-second-key.$pub_key_format $pub_key_option:second-recipient $topfolder/keys/ec-prime256v1-second-key.$pub_key_format --enc-recipient first-recipient --enc-recipient second-recipient --xml-data $topfolder/aleksey-xmlenc-01/enc_ecdh_p256_concatkdf_sha1_kw_aes256_aes128gcm_recipients.data" \
+    "--enabled-key-data agreement-method,enc-key,key-name,key-value,ec $priv_key_option:first-recipient $topfolder/keys/ecdsa-secp256r1-second-key.$priv_key_format --pwd secret123"
+
 # ECDH + ConcatKDF + SHA2
 execEncTest $res_success \
     "" \
@@ -526,6 +564,15 @@ execEncTest $res_success \
     "--keys-file $keysfile --binary-data $topfolder/aleksey-xmlenc-01/enc-aes256cbc-keyname.data" \
     "--keys-file $keysfile"
 
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes256cbc-keyname" \
+    "aes256-cbc" \
+    "" \
+    "--keys-file $topfolder/keys/keys.xml" \
+    "--keys-file $keysfile --stream-output --binary-data $topfolder/aleksey-xmlenc-01/enc-aes256cbc-keyname.data" \
+    "--keys-file $keysfile"
+
 execEncTest $res_success \
     "" \
     "aleksey-xmlenc-01/enc-des3cbc-keyname-content" \
@@ -562,6 +609,15 @@ execEncTest $res_success \
     "--keys-file $keysfile  --session-key des-192  --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-aes192-keyname.data" \
     "--keys-file $keysfile"
 
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-des3cbc-aes192-keyname" \
+    "tripledes-cbc kw-aes192" \
+    "enc-key aes des" \
+    "--keys-file $topfolder/keys/keys.xml" \
+    "--keys-file $keysfile  --session-key des-192 --stream-output --binary-data $topfolder/aleksey-xmlenc-01/enc-des3cbc-aes192-keyname.data" \
+    "--keys-file $keysfile"
+
 execEncTest $res_success \
     "" \
     "aleksey-xmlenc-01/enc-aes256-kt-rsa_oaep_sha1-params" \
@@ -571,6 +627,23 @@ execEncTest $res_success \
     "$priv_key_option:my-rsa-key $topfolder/keys/largersakey.$priv_key_format --pwd secret123 --session-key aes-256 --enabled-key-data key-name,enc-key --xml-data $topfolder/aleksey-xmlenc-01/enc-aes256-kt-rsa_oaep_sha1-params.data --node-name http://example.org/paymentv2:CreditCard"  \
     "$priv_key_option:my-rsa-key $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
 
+# several elements share the same encrypted key
+extra_message="Decrypt all"
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-all-aes256-kt-rsa_oaep_sha1-retrieval" \
+    "aes256-cbc rsa-oaep-mgf1p sha1" \
+    "" \
+    "--decrypt-all $priv_key_option:my-rsa-key $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
+extra_message="Negative test: decrypt all with missing key"
+execEncTest $res_fail \
+    "" \
+    "aleksey-xmlenc-01/enc-all-aes256-kt-rsa_oaep_sha1-retrieval" \
+    "aes256-cbc rsa-oaep-mgf1p sha1" \
+    "" \
+    "--decrypt-all"
+
 execEncTest $res_success \
     "" \
     "aleksey-xmlenc-01/enc-aes256-kt-rsa_oaep_sha1" \